@@ -39,6 +39,8 @@
 #import "PLCrashReporter.h"
 #import "PLCrashReport.h"
 #import "PLCrashReportTextFormatter.h"
+#import "PLCrashProfiler.h"
+#import "PLCrashHangWatchdog.h"
 
 /**
  * @defgroup functions Crash Reporter Functions Reference
@@ -103,6 +105,8 @@ typedef enum {
 #import "PLCrashReporter.h"
 #import "PLCrashReport.h"
 #import "PLCrashReportTextFormatter.h"
+#import "PLCrashProfiler.h"
+#import "PLCrashHangWatchdog.h"
 
 /**
  * @mainpage Plausible Crash Reporter
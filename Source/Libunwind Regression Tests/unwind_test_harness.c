@@ -22,11 +22,13 @@
 #include "unwind_test_harness.h"
 #include <stddef.h>
 #include <stdlib.h>
+#include <string.h>
 #include <stdio.h>
 #include <stdbool.h>
 #include <inttypes.h>
 
 #include <mach-o/dyld.h>
+#include <mach/mach_time.h>
 
 #include "PLCrashFrameWalker.h"
 
@@ -189,6 +191,30 @@ static struct unwind_test_case unwind_test_cases[] = {
 };
 
 
+/* Reader sets measured by the benchmark harness */
+enum unwind_bench_reader_set {
+    UNWIND_BENCH_FRAME = 0,
+    UNWIND_BENCH_COMPACT,
+    UNWIND_BENCH_DWARF,
+    UNWIND_BENCH_DEFAULT,
+    UNWIND_BENCH_READER_SET_COUNT
+};
+
+/* Accumulated benchmark results for a single reader set */
+struct unwind_bench_result {
+    /* Frames successfully unwound */
+    uint64_t frames;
+
+    /* Total time spent unwinding, in mach_absolute_time() units */
+    uint64_t elapsed;
+
+    /* Total target memory accesses performed while unwinding */
+    plcrash_async_read_stats_t reads;
+};
+
+/* Number of nested calls used to generate the deep stack benchmark. */
+#define UNWIND_BENCH_STACK_DEPTH 128
+
 /*
  * We abuse global state to pass configuration down to the test result handling
  * without having to modify all of Apple's test cases. This means the tests
@@ -197,6 +223,15 @@ static struct unwind_test_case unwind_test_cases[] = {
 struct  {
     /** The current test case */
     struct unwind_test_case *test_case;
+
+    /** Number of timed iterations to perform per unwind, or 0 if not benchmarking. */
+    uint32_t bench_iterations;
+
+    /** Accumulated per-reader results for the fixture unwinds. */
+    struct unwind_bench_result bench_fixture[UNWIND_BENCH_READER_SET_COUNT];
+
+    /** Accumulated per-reader results for the deep stack unwinds. */
+    struct unwind_bench_result bench_deep[UNWIND_BENCH_READER_SET_COUNT];
 } global_harness_state;
 
 /*
@@ -231,6 +266,90 @@ bool unwind_test_harness (void) {
     } \
 } while (0)
 
+/* Return the benchmark reader set identifier for @a readers */
+static enum unwind_bench_reader_set unwind_bench_reader_set (plframe_cursor_frame_reader_t **readers) {
+    if (readers == frame_readers_frame)
+        return UNWIND_BENCH_FRAME;
+    else if (readers == frame_readers_compact)
+        return UNWIND_BENCH_COMPACT;
+    else if (readers == frame_readers_dwarf)
+        return UNWIND_BENCH_DWARF;
+
+    return UNWIND_BENCH_DEFAULT;
+}
+
+/* Return the frame readers for the given benchmark reader set, or NULL for the default set */
+static plframe_cursor_frame_reader_t **unwind_bench_readers (enum unwind_bench_reader_set set) {
+    switch (set) {
+        case UNWIND_BENCH_FRAME:
+            return frame_readers_frame;
+        case UNWIND_BENCH_COMPACT:
+            return frame_readers_compact;
+        case UNWIND_BENCH_DWARF:
+            return frame_readers_dwarf;
+        default:
+            return NULL;
+    }
+}
+
+/* Step @a cursor using @a readers, or the default reader set if @a readers is NULL */
+static plframe_error_t unwind_bench_step (plframe_cursor_t *cursor, plframe_cursor_frame_reader_t **readers, size_t reader_count) {
+    if (readers != NULL)
+        return plframe_cursor_next_with_readers(cursor, readers, reader_count);
+
+    return plframe_cursor_next(cursor);
+}
+
+/* Add the time and memory accesses since @a start_time and @a start_stats to @a result. */
+static void unwind_bench_accumulate (struct unwind_bench_result *result, uint64_t start_time, const plcrash_async_read_stats_t *start_stats, uint64_t frames) {
+    uint64_t end_time = mach_absolute_time();
+    plcrash_async_read_stats_t stats;
+
+    plcrash_async_read_stats_get(&stats);
+
+    result->frames += frames;
+    result->elapsed += end_time - start_time;
+    result->reads.read_count += stats.read_count - start_stats->read_count;
+    result->reads.read_bytes += stats.read_bytes - start_stats->read_bytes;
+    result->reads.map_count += stats.map_count - start_stats->map_count;
+    result->reads.map_bytes += stats.map_bytes - start_stats->map_bytes;
+}
+
+/*
+ * Repeatedly unwind the current fixture's test function using @a readers, timing only the step through the
+ * test function itself.
+ */
+static void unwind_bench_fixture (plcrash_async_thread_state_t *state, plcrash_async_image_list_t *image_list, plframe_cursor_frame_reader_t **readers, size_t reader_count) {
+    struct unwind_bench_result *result = &global_harness_state.bench_fixture[unwind_bench_reader_set(readers)];
+
+    for (uint32_t iter = 0; iter < global_harness_state.bench_iterations; iter++) {
+        plframe_cursor_t cursor;
+        plcrash_async_read_stats_t stats;
+        uint64_t start_time;
+        plframe_error_t err;
+
+        plframe_cursor_init(&cursor, mach_task_self(), state, image_list);
+        for (uint32_t i = 0; i < global_harness_state.test_case->intermediate_frames; i++) {
+            if ((err = plframe_cursor_next(&cursor)) != PLFRAME_ESUCCESS) {
+                PLCF_DEBUG("Step failed: %d", err);
+                __builtin_trap();
+            }
+        }
+
+        plcrash_async_read_stats_get(&stats);
+        start_time = mach_absolute_time();
+        err = unwind_bench_step(&cursor, readers, reader_count);
+        unwind_bench_accumulate(result, start_time, &stats, 1);
+
+        if (err != PLFRAME_ESUCCESS) {
+            PLCF_DEBUG("Step within test function failed: %d (%s)", err, plframe_strerror(err));
+            __builtin_trap();
+        }
+
+        plframe_cursor_free(&cursor);
+    }
+}
+
 static plcrash_error_t unwind_current_state (plcrash_async_thread_state_t *state, void *context) {
     plframe_cursor_t cursor;
     plcrash_async_image_list_t image_list;
@@ -250,6 +369,10 @@ static plcrash_error_t unwind_current_state (plcrash_async_thread_state_t *state
     for (uint32_t i = 0; i < _dyld_image_count(); i++)
         plcrash_nasync_image_list_append(&image_list, _dyld_get_image_header(i), _dyld_get_image_name(i));
 
+    /* If benchmarking, perform our timed unwinds prior to validation */
+    if (global_harness_state.bench_iterations > 0)
+        unwind_bench_fixture(state, &image_list, readers, reader_count);
+
     /* Initialie our cursor */
     plframe_cursor_init(&cursor, mach_task_self(), state, &image_list);
 
@@ -364,3 +487,119 @@ void uwind_to_main (void) {
 #endif
 }
 
+/*
+ * Walk the full stack of the current thread with each reader set, stopping at the first frame that can not
+ * be unwound.
+ */
+static plcrash_error_t unwind_bench_deep_walk (plcrash_async_thread_state_t *state, void *context) {
+    plcrash_async_image_list_t *image_list = context;
+
+    for (int set = 0; set < UNWIND_BENCH_READER_SET_COUNT; set++) {
+        plframe_cursor_frame_reader_t **readers = unwind_bench_readers(set);
+        size_t reader_count = 0;
+
+        if (readers != NULL) {
+            for (reader_count = 0; readers[reader_count] != NULL; reader_count++) {
+
+            }
+        }
+
+        for (uint32_t iter = 0; iter < global_harness_state.bench_iterations; iter++) {
+            plframe_cursor_t cursor;
+            plcrash_async_read_stats_t stats;
+            uint64_t start_time;
+            uint64_t frames = 0;
+
+            plframe_cursor_init(&cursor, mach_task_self(), state, image_list);
+
+            plcrash_async_read_stats_get(&stats);
+            start_time = mach_absolute_time();
+            while (unwind_bench_step(&cursor, readers, reader_count) == PLFRAME_ESUCCESS)
+                frames++;
+            unwind_bench_accumulate(&global_harness_state.bench_deep[set], start_time, &stats, frames);
+
+            plframe_cursor_free(&cursor);
+        }
+    }
+
+    return PLCRASH_ESUCCESS;
+}
+
+/* Recurse @a depth times before walking the current thread's stack. */
+static __attribute__((noinline)) plcrash_error_t unwind_bench_recurse (uint32_t depth, plcrash_async_image_list_t *image_list) {
+    plcrash_error_t err;
+
+    if (depth == 0)
+        return plcrash_async_thread_state_current(unwind_bench_deep_walk, image_list);
+
+    err = unwind_bench_recurse(depth - 1, image_list);
+
+    /* Prevent tail call optimization from collapsing our frames */
+    __asm__ __volatile__ ("" ::: "memory");
+    return err;
+}
+
+/* Print the per-frame results for @a results */
+static void unwind_bench_print (const char *title, struct unwind_bench_result *results) {
+    static const char *names[UNWIND_BENCH_READER_SET_COUNT] = { "frame", "compact", "dwarf", "default" };
+    mach_timebase_info_data_t timebase;
+
+    mach_timebase_info(&timebase);
+
+    fprintf(stderr, "%s\n", title);
+    fprintf(stderr, "  %-8s %10s %12s %12s %12s %12s\n", "readers", "frames", "ns/frame", "reads/frame", "bytes/frame", "maps/frame");
+    for (int set = 0; set < UNWIND_BENCH_READER_SET_COUNT; set++) {
+        struct unwind_bench_result *r = &results[set];
+        if (r->frames == 0) {
+            fprintf(stderr, "  %-8s %10s\n", names[set], "-");
+            continue;
+        }
+
+        double frames = (double) r->frames;
+        double ns = ((double) r->elapsed * timebase.numer) / timebase.denom;
+        fprintf(stderr, "  %-8s %10" PRIu64 " %12.1f %12.2f %12.1f %12.2f\n", names[set], r->frames,
+                ns / frames,
+                r->reads.read_count / frames,
+                r->reads.read_bytes / frames,
+                r->reads.map_count / frames);
+    }
+}
+
+/*
+ * Run the regression fixtures and a generated deep stack through each reader set @a iterations times, reporting
+ * the time and target memory accesses per unwound frame to stderr. Memory access counts will be zero if
+ * PLCRASH_FEATURE_READ_STATISTICS is disabled.
+ *
+ * The fixtures are also validated exactly as in unwind_test_harness().
+ */
+bool unwind_benchmark_harness (uint32_t iterations) {
+    plcrash_async_image_list_t image_list;
+    bool result;
+
+    if (iterations == 0)
+        return false;
+
+    memset(global_harness_state.bench_fixture, 0, sizeof(global_harness_state.bench_fixture));
+    memset(global_harness_state.bench_deep, 0, sizeof(global_harness_state.bench_deep));
+    global_harness_state.bench_iterations = iterations;
+
+    /* Fixture unwinds */
+    result = unwind_test_harness();
+
+    /* Deep stack unwinds */
+    plcrash_nasync_image_list_init(&image_list, mach_task_self());
+    for (uint32_t i = 0; i < _dyld_image_count(); i++)
+        plcrash_nasync_image_list_append(&image_list, _dyld_get_image_header(i), _dyld_get_image_name(i));
+
+    if (unwind_bench_recurse(UNWIND_BENCH_STACK_DEPTH, &image_list) != PLCRASH_ESUCCESS)
+        result = false;
+
+    plcrash_nasync_image_list_free(&image_list);
+    global_harness_state.bench_iterations = 0;
+
+    fprintf(stderr, "Unwind benchmark: %" PRIu32 " iterations\n", iterations);
+    unwind_bench_print("Fixture unwind (single step through test function)", global_harness_state.bench_fixture);
+    unwind_bench_print("Deep stack unwind (full thread walk)", global_harness_state.bench_deep);
+
+    return result;
+}
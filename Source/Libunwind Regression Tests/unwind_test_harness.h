@@ -23,12 +23,14 @@
 #define PLCRASH_UNWIND_TEST_HARNESS_H
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 bool unwind_test_harness (void);
+bool unwind_benchmark_harness (uint32_t iterations);
     
 #ifdef __cplusplus
 }
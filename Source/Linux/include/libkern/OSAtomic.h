@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * OSAtomic and OSSpinLock definitions for non-Apple hosts, implemented with the GCC __atomic builtins.
+ *
+ * Only the subset referenced by the async core is provided. As with the Darwin implementations, the *Barrier
+ * variants are sequentially consistent, and the spin lock is a simple test-and-set lock.
+ */
+
+#ifndef PLCRASH_LINUX_OSATOMIC_H
+#define PLCRASH_LINUX_OSATOMIC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sched.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int32_t OSSpinLock;
+
+#define OS_SPINLOCK_INIT 0
+
+static inline void OSMemoryBarrier (void) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+static inline bool OSAtomicCompareAndSwapPtrBarrier (void *oldValue, void *newValue, void * volatile *theValue) {
+    return __atomic_compare_exchange_n(theValue, &oldValue, newValue, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+static inline bool OSAtomicCompareAndSwap32Barrier (int32_t oldValue, int32_t newValue, volatile int32_t *theValue) {
+    return __atomic_compare_exchange_n(theValue, &oldValue, newValue, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+static inline int32_t OSAtomicAdd32Barrier (int32_t theAmount, volatile int32_t *theValue) {
+    return __atomic_add_fetch(theValue, theAmount, __ATOMIC_SEQ_CST);
+}
+
+static inline int32_t OSAtomicIncrement32Barrier (volatile int32_t *theValue) {
+    return OSAtomicAdd32Barrier(1, theValue);
+}
+
+static inline int32_t OSAtomicDecrement32Barrier (volatile int32_t *theValue) {
+    return OSAtomicAdd32Barrier(-1, theValue);
+}
+
+static inline bool OSSpinLockTry (volatile OSSpinLock *lock) {
+    return !__atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE);
+}
+
+static inline void OSSpinLockLock (volatile OSSpinLock *lock) {
+    while (!OSSpinLockTry(lock))
+        sched_yield();
+}
+
+static inline void OSSpinLockUnlock (volatile OSSpinLock *lock) {
+    __atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLCRASH_LINUX_OSATOMIC_H */
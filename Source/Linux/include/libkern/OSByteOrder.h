@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Byte order definitions for non-Apple hosts.
+ */
+
+#ifndef PLCRASH_LINUX_OSBYTEORDER_H
+#define PLCRASH_LINUX_OSBYTEORDER_H
+
+#include <stdint.h>
+
+/* Apple's compilers predefine these on all targets; GCC does not. */
+#if !defined(__LITTLE_ENDIAN__) && !defined(__BIG_ENDIAN__)
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define __LITTLE_ENDIAN__ 1
+#else
+#define __BIG_ENDIAN__ 1
+#endif
+#endif
+
+#define OSSwapInt16(x) ((uint16_t) __builtin_bswap16((uint16_t) (x)))
+#define OSSwapInt32(x) ((uint32_t) __builtin_bswap32((uint32_t) (x)))
+#define OSSwapInt64(x) ((uint64_t) __builtin_bswap64((uint64_t) (x)))
+
+#ifdef __LITTLE_ENDIAN__
+#define OSSwapBigToHostInt16(x) OSSwapInt16(x)
+#define OSSwapBigToHostInt32(x) OSSwapInt32(x)
+#define OSSwapBigToHostInt64(x) OSSwapInt64(x)
+#define OSSwapLittleToHostInt16(x) ((uint16_t) (x))
+#define OSSwapLittleToHostInt32(x) ((uint32_t) (x))
+#define OSSwapLittleToHostInt64(x) ((uint64_t) (x))
+#else
+#define OSSwapBigToHostInt16(x) ((uint16_t) (x))
+#define OSSwapBigToHostInt32(x) ((uint32_t) (x))
+#define OSSwapBigToHostInt64(x) ((uint64_t) (x))
+#define OSSwapLittleToHostInt16(x) OSSwapInt16(x)
+#define OSSwapLittleToHostInt32(x) OSSwapInt32(x)
+#define OSSwapLittleToHostInt64(x) OSSwapInt64(x)
+#endif
+
+#define OSSwapHostToBigInt32(x) OSSwapBigToHostInt32(x)
+#define OSSwapHostToLittleInt32(x) OSSwapLittleToHostInt32(x)
+
+#endif /* PLCRASH_LINUX_OSBYTEORDER_H */
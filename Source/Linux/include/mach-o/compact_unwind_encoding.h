@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Compact unwind encoding definitions for non-Apple hosts. These values are fixed by the Mach-O ABI.
+ *
+ * The ARM64 constants are provided here as well, as PLCrashCompatConstants.h only defines them for Mac OS X targets.
+ */
+
+#ifndef PLCRASH_LINUX_COMPACT_UNWIND_ENCODING_H
+#define PLCRASH_LINUX_COMPACT_UNWIND_ENCODING_H
+
+#include <stdint.h>
+
+typedef uint32_t compact_unwind_encoding_t;
+
+#define UNWIND_IS_NOT_FUNCTION_START                0x80000000
+#define UNWIND_HAS_LSDA                             0x40000000
+#define UNWIND_PERSONALITY_MASK                     0x30000000
+
+/* x86 */
+#define UNWIND_X86_MODE_MASK                        0x0F000000
+#define UNWIND_X86_MODE_EBP_FRAME                   0x01000000
+#define UNWIND_X86_MODE_STACK_IMMD                  0x02000000
+#define UNWIND_X86_MODE_STACK_IND                   0x03000000
+#define UNWIND_X86_MODE_DWARF                       0x04000000
+
+#define UNWIND_X86_EBP_FRAME_REGISTERS              0x00007FFF
+#define UNWIND_X86_EBP_FRAME_OFFSET                 0x00FF0000
+
+#define UNWIND_X86_FRAMELESS_STACK_SIZE             0x00FF0000
+#define UNWIND_X86_FRAMELESS_STACK_ADJUST           0x0000E000
+#define UNWIND_X86_FRAMELESS_STACK_REG_COUNT        0x00001C00
+#define UNWIND_X86_FRAMELESS_STACK_REG_PERMUTATION  0x000003FF
+
+#define UNWIND_X86_DWARF_SECTION_OFFSET             0x00FFFFFF
+
+#define UNWIND_X86_REG_NONE                         0
+#define UNWIND_X86_REG_EBX                          1
+#define UNWIND_X86_REG_ECX                          2
+#define UNWIND_X86_REG_EDX                          3
+#define UNWIND_X86_REG_EDI                          4
+#define UNWIND_X86_REG_ESI                          5
+#define UNWIND_X86_REG_EBP                          6
+
+/* x86-64 */
+#define UNWIND_X86_64_MODE_MASK                         0x0F000000
+#define UNWIND_X86_64_MODE_RBP_FRAME                    0x01000000
+#define UNWIND_X86_64_MODE_STACK_IMMD                   0x02000000
+#define UNWIND_X86_64_MODE_STACK_IND                    0x03000000
+#define UNWIND_X86_64_MODE_DWARF                        0x04000000
+
+#define UNWIND_X86_64_RBP_FRAME_REGISTERS               0x00007FFF
+#define UNWIND_X86_64_RBP_FRAME_OFFSET                  0x00FF0000
+
+#define UNWIND_X86_64_FRAMELESS_STACK_SIZE              0x00FF0000
+#define UNWIND_X86_64_FRAMELESS_STACK_ADJUST            0x0000E000
+#define UNWIND_X86_64_FRAMELESS_STACK_REG_COUNT         0x00001C00
+#define UNWIND_X86_64_FRAMELESS_STACK_REG_PERMUTATION   0x000003FF
+
+#define UNWIND_X86_64_DWARF_SECTION_OFFSET              0x00FFFFFF
+
+#define UNWIND_X86_64_REG_NONE                          0
+#define UNWIND_X86_64_REG_RBX                           1
+#define UNWIND_X86_64_REG_R12                           2
+#define UNWIND_X86_64_REG_R13                           3
+#define UNWIND_X86_64_REG_R14                           4
+#define UNWIND_X86_64_REG_R15                           5
+#define UNWIND_X86_64_REG_RBP                           6
+
+/* ARM64 */
+#define UNWIND_ARM64_MODE_MASK                          0x0F000000
+#define UNWIND_ARM64_MODE_FRAMELESS                     0x02000000
+#define UNWIND_ARM64_MODE_DWARF                         0x03000000
+#define UNWIND_ARM64_MODE_FRAME                         0x04000000
+
+#define UNWIND_ARM64_FRAME_X19_X20_PAIR                 0x00000001
+#define UNWIND_ARM64_FRAME_X21_X22_PAIR                 0x00000002
+#define UNWIND_ARM64_FRAME_X23_X24_PAIR                 0x00000004
+#define UNWIND_ARM64_FRAME_X25_X26_PAIR                 0x00000008
+#define UNWIND_ARM64_FRAME_X27_X28_PAIR                 0x00000010
+
+#define UNWIND_ARM64_FRAMELESS_STACK_SIZE_MASK          0x00FFF000
+#define UNWIND_ARM64_DWARF_SECTION_OFFSET               0x00FFFFFF
+
+/* __TEXT,__unwind_info section */
+#define UNWIND_SECTION_VERSION 1
+
+struct unwind_info_section_header {
+    uint32_t version;
+    uint32_t commonEncodingsArraySectionOffset;
+    uint32_t commonEncodingsArrayCount;
+    uint32_t personalityArraySectionOffset;
+    uint32_t personalityArrayCount;
+    uint32_t indexSectionOffset;
+    uint32_t indexCount;
+};
+
+struct unwind_info_section_header_index_entry {
+    uint32_t functionOffset;
+    uint32_t secondLevelPagesSectionOffset;
+    uint32_t lsdaIndexArraySectionOffset;
+};
+
+struct unwind_info_section_header_lsda_index_entry {
+    uint32_t functionOffset;
+    uint32_t lsdaOffset;
+};
+
+struct unwind_info_regular_second_level_entry {
+    uint32_t functionOffset;
+    compact_unwind_encoding_t encoding;
+};
+
+#define UNWIND_SECOND_LEVEL_REGULAR 2
+
+struct unwind_info_regular_second_level_page_header {
+    uint32_t kind;
+    uint16_t entryPageOffset;
+    uint16_t entryCount;
+};
+
+#define UNWIND_SECOND_LEVEL_COMPRESSED 3
+
+struct unwind_info_compressed_second_level_page_header {
+    uint32_t kind;
+    uint16_t entryPageOffset;
+    uint16_t entryCount;
+    uint16_t encodingsPageOffset;
+    uint16_t encodingsCount;
+};
+
+#define UNWIND_INFO_COMPRESSED_ENTRY_FUNC_OFFSET(entry)       ((entry) & 0x00FFFFFF)
+#define UNWIND_INFO_COMPRESSED_ENTRY_ENCODING_INDEX(entry)    (((entry) >> 24) & 0xFF)
+
+#endif /* PLCRASH_LINUX_COMPACT_UNWIND_ENCODING_H */
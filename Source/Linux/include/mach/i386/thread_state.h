@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * x86 thread state definitions for non-Apple hosts. The layouts match the Darwin x86 thread, exception and machine
+ * context structures, which are fixed by the ABI; the floating point state is not interpreted by the async core, and is
+ * reserved as opaque storage.
+ */
+
+#ifndef PLCRASH_LINUX_MACH_I386_THREAD_STATE_H
+#define PLCRASH_LINUX_MACH_I386_THREAD_STATE_H
+
+#include <stdint.h>
+#include <signal.h>
+#include <mach/mach.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define x86_THREAD_STATE32      1
+#define x86_FLOAT_STATE32       2
+#define x86_EXCEPTION_STATE32   3
+#define x86_THREAD_STATE64      4
+#define x86_FLOAT_STATE64       5
+#define x86_EXCEPTION_STATE64   6
+#define x86_THREAD_STATE        7
+#define x86_FLOAT_STATE         8
+#define x86_EXCEPTION_STATE     9
+
+typedef struct x86_state_hdr {
+    uint32_t flavor;
+    uint32_t count;
+} x86_state_hdr_t;
+
+typedef struct __darwin_i386_thread_state {
+    unsigned int __eax;
+    unsigned int __ebx;
+    unsigned int __ecx;
+    unsigned int __edx;
+    unsigned int __edi;
+    unsigned int __esi;
+    unsigned int __ebp;
+    unsigned int __esp;
+    unsigned int __ss;
+    unsigned int __eflags;
+    unsigned int __eip;
+    unsigned int __cs;
+    unsigned int __ds;
+    unsigned int __es;
+    unsigned int __fs;
+    unsigned int __gs;
+} x86_thread_state32_t;
+
+typedef struct __darwin_x86_thread_state64 {
+    uint64_t __rax;
+    uint64_t __rbx;
+    uint64_t __rcx;
+    uint64_t __rdx;
+    uint64_t __rdi;
+    uint64_t __rsi;
+    uint64_t __rbp;
+    uint64_t __rsp;
+    uint64_t __r8;
+    uint64_t __r9;
+    uint64_t __r10;
+    uint64_t __r11;
+    uint64_t __r12;
+    uint64_t __r13;
+    uint64_t __r14;
+    uint64_t __r15;
+    uint64_t __rip;
+    uint64_t __rflags;
+    uint64_t __cs;
+    uint64_t __fs;
+    uint64_t __gs;
+} x86_thread_state64_t;
+
+typedef struct __darwin_i386_exception_state {
+    uint16_t __trapno;
+    uint16_t __cpu;
+    uint32_t __err;
+    uint32_t __faultvaddr;
+} x86_exception_state32_t;
+
+typedef struct __darwin_x86_exception_state64 {
+    uint16_t __trapno;
+    uint16_t __cpu;
+    uint32_t __err;
+    uint64_t __faultvaddr;
+} x86_exception_state64_t;
+
+typedef struct x86_thread_state {
+    x86_state_hdr_t tsh;
+    union {
+        x86_thread_state32_t ts32;
+        x86_thread_state64_t ts64;
+    } uts;
+} x86_thread_state_t;
+
+typedef struct x86_exception_state {
+    x86_state_hdr_t esh;
+    union {
+        x86_exception_state32_t es32;
+        x86_exception_state64_t es64;
+    } ues;
+} x86_exception_state_t;
+
+#define x86_THREAD_STATE32_COUNT ((mach_msg_type_number_t) (sizeof(x86_thread_state32_t) / sizeof(int)))
+#define x86_THREAD_STATE64_COUNT ((mach_msg_type_number_t) (sizeof(x86_thread_state64_t) / sizeof(int)))
+#define x86_THREAD_STATE_COUNT ((mach_msg_type_number_t) (sizeof(x86_thread_state_t) / sizeof(int)))
+#define x86_EXCEPTION_STATE32_COUNT ((mach_msg_type_number_t) (sizeof(x86_exception_state32_t) / sizeof(int)))
+#define x86_EXCEPTION_STATE64_COUNT ((mach_msg_type_number_t) (sizeof(x86_exception_state64_t) / sizeof(int)))
+#define x86_EXCEPTION_STATE_COUNT ((mach_msg_type_number_t) (sizeof(x86_exception_state_t) / sizeof(int)))
+
+/* Machine contexts, as vended to signal handlers on Darwin */
+struct __darwin_mcontext32 {
+    x86_exception_state32_t __es;
+    x86_thread_state32_t __ss;
+    uint8_t __fs[512];
+};
+
+struct __darwin_mcontext64 {
+    x86_exception_state64_t __es;
+    x86_thread_state64_t __ss;
+    uint8_t __fs[524];
+};
+
+#ifdef __LP64__
+#define _STRUCT_MCONTEXT struct __darwin_mcontext64
+#else
+#define _STRUCT_MCONTEXT struct __darwin_mcontext32
+#endif
+
+struct __darwin_ucontext {
+    int uc_onstack;
+    uint32_t uc_sigmask;
+    stack_t uc_stack;
+    struct __darwin_ucontext *uc_link;
+    size_t uc_mcsize;
+    _STRUCT_MCONTEXT *uc_mcontext;
+};
+
+#define _STRUCT_UCONTEXT struct __darwin_ucontext
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLCRASH_LINUX_MACH_I386_THREAD_STATE_H */
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Mach type and interface definitions for non-Apple hosts.
+ *
+ * Only the subset referenced by the async core is provided. No live tasks are available on these hosts; memory is
+ * read through registered memory sources (see PLCrashAsyncMemorySource.h), and the task interfaces declared here
+ * fail for any task other than the current task. See mach_shim.c.
+ */
+
+#ifndef PLCRASH_LINUX_MACH_H
+#define PLCRASH_LINUX_MACH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <mach/machine.h>
+#include <libkern/OSByteOrder.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int kern_return_t;
+typedef unsigned int natural_t;
+typedef int integer_t;
+typedef int boolean_t;
+
+typedef natural_t mach_port_name_t;
+typedef mach_port_name_t mach_port_t;
+typedef mach_port_t task_t;
+typedef mach_port_t thread_t;
+typedef mach_port_t thread_act_t;
+typedef mach_port_t vm_map_t;
+typedef mach_port_t mem_entry_name_port_t;
+typedef natural_t mach_port_right_t;
+typedef integer_t mach_port_delta_t;
+typedef natural_t mach_msg_type_number_t;
+typedef natural_t *thread_state_t;
+typedef int thread_state_flavor_t;
+
+typedef uintptr_t vm_offset_t;
+typedef uintptr_t vm_address_t;
+typedef uintptr_t vm_size_t;
+typedef uintptr_t pointer_t;
+typedef int vm_prot_t;
+typedef unsigned int vm_inherit_t;
+typedef uint64_t memory_object_size_t;
+typedef uint64_t memory_object_offset_t;
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#define KERN_SUCCESS 0
+#define KERN_INVALID_ADDRESS 1
+#define KERN_PROTECTION_FAILURE 2
+#define KERN_NO_SPACE 3
+#define KERN_INVALID_ARGUMENT 4
+#define KERN_FAILURE 5
+#define KERN_RESOURCE_SHORTAGE 6
+#define KERN_INVALID_NAME 15
+#define KERN_INVALID_TASK 16
+#define KERN_NOT_SUPPORTED 46
+
+#define MACH_PORT_NULL ((mach_port_name_t) 0)
+#define MACH_PORT_DEAD ((mach_port_name_t) ~0)
+#define MACH_PORT_VALID(name) (((name) != MACH_PORT_NULL) && ((name) != MACH_PORT_DEAD))
+
+#define MACH_PORT_RIGHT_SEND ((mach_port_right_t) 0)
+#define MACH_PORT_RIGHT_RECEIVE ((mach_port_right_t) 1)
+#define MACH_PORT_RIGHT_SEND_ONCE ((mach_port_right_t) 2)
+#define MACH_PORT_RIGHT_PORT_SET ((mach_port_right_t) 3)
+#define MACH_PORT_RIGHT_DEAD_NAME ((mach_port_right_t) 4)
+
+#define VM_PROT_NONE ((vm_prot_t) 0x00)
+#define VM_PROT_READ ((vm_prot_t) 0x01)
+#define VM_PROT_WRITE ((vm_prot_t) 0x02)
+#define VM_PROT_EXECUTE ((vm_prot_t) 0x04)
+
+#define VM_FLAGS_FIXED 0x0000
+#define VM_FLAGS_ANYWHERE 0x0001
+#define VM_FLAGS_OVERWRITE 0x4000
+
+#define VM_INHERIT_SHARE ((vm_inherit_t) 0)
+#define VM_INHERIT_COPY ((vm_inherit_t) 1)
+#define VM_INHERIT_NONE ((vm_inherit_t) 2)
+
+/* Provided by Darwin's <sys/cdefs.h>, which the Mach headers include. */
+#ifndef __offsetof
+#define __offsetof(type, field) offsetof(type, field)
+#endif
+
+extern vm_size_t vm_page_size;
+extern vm_size_t vm_page_mask;
+
+#ifndef PAGE_SIZE
+#define PAGE_SIZE 4096
+#endif
+
+#define trunc_page(x) ((vm_offset_t) (x) & ~((vm_offset_t) vm_page_mask))
+#define round_page(x) trunc_page((vm_offset_t) (x) + vm_page_mask)
+
+mach_port_t mach_task_self (void);
+mach_port_t mach_thread_self (void);
+
+kern_return_t thread_get_state (thread_act_t thread, thread_state_flavor_t flavor, thread_state_t state,
+                                mach_msg_type_number_t *count);
+
+kern_return_t mach_port_allocate (task_t task, mach_port_right_t right, mach_port_name_t *name);
+kern_return_t mach_port_deallocate (task_t task, mach_port_name_t name);
+kern_return_t mach_port_mod_refs (task_t task, mach_port_name_t name, mach_port_right_t right, mach_port_delta_t delta);
+
+kern_return_t vm_allocate (vm_map_t target, vm_address_t *address, vm_size_t size, int flags);
+kern_return_t vm_deallocate (vm_map_t target, vm_address_t address, vm_size_t size);
+kern_return_t vm_read_overwrite (vm_map_t target, vm_address_t address, vm_size_t size, vm_address_t data, vm_size_t *outsize);
+kern_return_t vm_map (vm_map_t target, vm_address_t *address, vm_size_t size, vm_address_t mask, int flags,
+                      mem_entry_name_port_t object, vm_offset_t offset, boolean_t copy, vm_prot_t cur_protection,
+                      vm_prot_t max_protection, vm_inherit_t inheritance);
+
+kern_return_t mach_make_memory_entry_64 (vm_map_t target, memory_object_size_t *size, memory_object_offset_t offset,
+                                         vm_prot_t permission, mach_port_t *object_handle, mem_entry_name_port_t parent);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLCRASH_LINUX_MACH_H */
@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Mach 64-bit VM interface definitions for non-Apple hosts. See mach/mach.h.
+ */
+
+#ifndef PLCRASH_LINUX_MACH_VM_H
+#define PLCRASH_LINUX_MACH_VM_H
+
+#include <mach/mach.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef uint64_t mach_vm_address_t;
+typedef uint64_t mach_vm_size_t;
+typedef uint64_t mach_vm_offset_t;
+
+#define mach_vm_trunc_page(x) ((mach_vm_offset_t) (x) & ~((mach_vm_offset_t) vm_page_mask))
+#define mach_vm_round_page(x) (((mach_vm_offset_t) (x) + vm_page_mask) & ~((mach_vm_offset_t) vm_page_mask))
+
+kern_return_t mach_vm_allocate (vm_map_t target, mach_vm_address_t *address, mach_vm_size_t size, int flags);
+kern_return_t mach_vm_deallocate (vm_map_t target, mach_vm_address_t address, mach_vm_size_t size);
+kern_return_t mach_vm_read_overwrite (vm_map_t target, mach_vm_address_t address, mach_vm_size_t size, mach_vm_address_t data,
+                                      mach_vm_size_t *outsize);
+kern_return_t mach_vm_map (vm_map_t target, mach_vm_address_t *address, mach_vm_size_t size, mach_vm_offset_t mask, int flags,
+                           mem_entry_name_port_t object, memory_object_offset_t offset, boolean_t copy, vm_prot_t cur_protection,
+                           vm_prot_t max_protection, vm_inherit_t inheritance);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLCRASH_LINUX_MACH_VM_H */
@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <mach/mach.h>
+#include <mach/mach_vm.h>
+
+#include <stdatomic.h>
+#include <sys/mman.h>
+
+/*
+ * Mach interfaces for non-Apple hosts.
+ *
+ * There are no Mach tasks here; all target memory is read through registered memory sources, and only the interfaces
+ * needed to run the async core against those sources are implemented:
+ *
+ * - The current task and thread are represented by fixed names.
+ * - Port names are allocated from a counter, and are only used as memory source handles. No rights are tracked, so
+ *   reference count changes always succeed.
+ * - Anonymous memory may be allocated in, and released from, the current task.
+ * - Reads and mappings of task memory fail with KERN_INVALID_ADDRESS or KERN_NOT_SUPPORTED.
+ * - Thread states may not be fetched; callers must supply them directly.
+ */
+
+/** The name of the current task. */
+#define MACH_SHIM_TASK_SELF ((mach_port_t) 0x103)
+
+/** The name of the current thread. */
+#define MACH_SHIM_THREAD_SELF ((mach_port_t) 0x203)
+
+/** The first name vended by mach_port_allocate(). */
+#define MACH_SHIM_FIRST_NAME ((mach_port_name_t) 0x1003)
+
+vm_size_t vm_page_size = PAGE_SIZE;
+vm_size_t vm_page_mask = PAGE_SIZE - 1;
+
+/** The next port name to be vended. Names are spaced as Mach names are, and are never reused. */
+static _Atomic mach_port_name_t next_port_name = MACH_SHIM_FIRST_NAME;
+
+mach_port_t mach_task_self (void) {
+    return MACH_SHIM_TASK_SELF;
+}
+
+mach_port_t mach_thread_self (void) {
+    return MACH_SHIM_THREAD_SELF;
+}
+
+kern_return_t thread_get_state (thread_act_t thread, thread_state_flavor_t flavor, thread_state_t state,
+                                mach_msg_type_number_t *count)
+{
+    return KERN_NOT_SUPPORTED;
+}
+
+kern_return_t mach_port_allocate (task_t task, mach_port_right_t right, mach_port_name_t *name) {
+    if (task != MACH_SHIM_TASK_SELF)
+        return KERN_INVALID_TASK;
+
+    if (right != MACH_PORT_RIGHT_DEAD_NAME)
+        return KERN_NOT_SUPPORTED;
+
+    *name = atomic_fetch_add(&next_port_name, 0x100);
+    return KERN_SUCCESS;
+}
+
+kern_return_t mach_port_deallocate (task_t task, mach_port_name_t name) {
+    return task == MACH_SHIM_TASK_SELF ? KERN_SUCCESS : KERN_INVALID_TASK;
+}
+
+kern_return_t mach_port_mod_refs (task_t task, mach_port_name_t name, mach_port_right_t right, mach_port_delta_t delta) {
+    return task == MACH_SHIM_TASK_SELF ? KERN_SUCCESS : KERN_INVALID_TASK;
+}
+
+kern_return_t mach_vm_allocate (vm_map_t target, mach_vm_address_t *address, mach_vm_size_t size, int flags) {
+    if (target != MACH_SHIM_TASK_SELF)
+        return KERN_INVALID_TASK;
+
+    if (!(flags & VM_FLAGS_ANYWHERE))
+        return KERN_NOT_SUPPORTED;
+
+    void *mem = mmap(NULL, (size_t) size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED)
+        return KERN_NO_SPACE;
+
+    *address = (mach_vm_address_t) (uintptr_t) mem;
+    return KERN_SUCCESS;
+}
+
+kern_return_t mach_vm_deallocate (vm_map_t target, mach_vm_address_t address, mach_vm_size_t size) {
+    if (target != MACH_SHIM_TASK_SELF)
+        return KERN_INVALID_TASK;
+
+    if (size == 0)
+        return KERN_SUCCESS;
+
+    if (munmap((void *) (uintptr_t) address, (size_t) size) != 0)
+        return KERN_INVALID_ADDRESS;
+
+    return KERN_SUCCESS;
+}
+
+kern_return_t mach_vm_read_overwrite (vm_map_t target, mach_vm_address_t address, mach_vm_size_t size, mach_vm_address_t data,
+                                      mach_vm_size_t *outsize)
+{
+    return KERN_INVALID_ADDRESS;
+}
+
+kern_return_t mach_vm_map (vm_map_t target, mach_vm_address_t *address, mach_vm_size_t size, mach_vm_offset_t mask, int flags,
+                           mem_entry_name_port_t object, memory_object_offset_t offset, boolean_t copy, vm_prot_t cur_protection,
+                           vm_prot_t max_protection, vm_inherit_t inheritance)
+{
+    return KERN_NOT_SUPPORTED;
+}
+
+kern_return_t mach_make_memory_entry_64 (vm_map_t target, memory_object_size_t *size, memory_object_offset_t offset,
+                                         vm_prot_t permission, mach_port_t *object_handle, mem_entry_name_port_t parent)
+{
+    return KERN_NOT_SUPPORTED;
+}
+
+kern_return_t vm_allocate (vm_map_t target, vm_address_t *address, vm_size_t size, int flags) {
+    mach_vm_address_t result;
+    kern_return_t kt;
+
+    if ((kt = mach_vm_allocate(target, &result, size, flags)) != KERN_SUCCESS)
+        return kt;
+
+    *address = (vm_address_t) result;
+    return KERN_SUCCESS;
+}
+
+kern_return_t vm_deallocate (vm_map_t target, vm_address_t address, vm_size_t size) {
+    return mach_vm_deallocate(target, address, size);
+}
+
+kern_return_t vm_read_overwrite (vm_map_t target, vm_address_t address, vm_size_t size, vm_address_t data, vm_size_t *outsize) {
+    return KERN_INVALID_ADDRESS;
+}
+
+kern_return_t vm_map (vm_map_t target, vm_address_t *address, vm_size_t size, vm_address_t mask, int flags,
+                      mem_entry_name_port_t object, vm_offset_t offset, boolean_t copy, vm_prot_t cur_protection,
+                      vm_prot_t max_protection, vm_inherit_t inheritance)
+{
+    return KERN_NOT_SUPPORTED;
+}
@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Checks the memory source, memory object and Mach-O reader path against an on-disk fixture image, with no live task.
+ *
+ * Usage: macho_source_check <Resources/Tests directory>
+ */
+
+#include "PLCrashAsyncMemorySource.h"
+#include "PLCrashAsyncMObject.h"
+#include "PLCrashAsyncMachOImage.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+/** The thin x86-64 fixture image, relative to the Resources/Tests directory. */
+#define CHECK_IMAGE "PLCrashAsyncDwarfEncodingTests/regression-bins/tbin.unwind_test_x86_64_frame.s.2"
+
+/** A universal fixture image, relative to the Resources/Tests directory. */
+#define CHECK_FAT_IMAGE "PLCrashAsyncDwarfEncodingTests/test.macosx"
+
+/** The unslid address of the fixture's __TEXT segment. */
+#define CHECK_TEXT_VMADDR 0x100000000ULL
+
+/** The slide applied to the fixture's segments. */
+#define CHECK_SLIDE 0x20000
+
+/** The unslid address of the fixture's test_rbx() function. */
+#define CHECK_TEST_RBX_ADDR 0x100000a6bULL
+
+/** The size of the fixture's __TEXT,__unwind_info section. */
+#define CHECK_UNWIND_INFO_SIZE 0x90
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+#define CHECK_ERR(expr, expected) do { \
+    plcrash_error_t __err = (expr); \
+    if (__err != (expected)) { \
+        fprintf(stderr, "%s:%d: %s returned %s, expected %s\n", __FILE__, __LINE__, #expr, \
+                plcrash_async_strerror(__err), plcrash_async_strerror(expected)); \
+        failures++; \
+    } \
+} while (0)
+
+/* Symbol lookup callback; copies the symbol name to the provided buffer. */
+static void found_symbol (pl_vm_address_t address, const char *name, void *ctx) {
+    snprintf(ctx, 128, "%s", name);
+}
+
+/* Join @a dir and @a path, returning a newly allocated path. */
+static char *fixture_path (const char *dir, const char *path) {
+    size_t len = strlen(dir) + strlen(path) + 2;
+    char *result = malloc(len);
+    snprintf(result, len, "%s/%s", dir, path);
+    return result;
+}
+
+static void check_macho_image (const char *resources) {
+    char *path = fixture_path(resources, CHECK_IMAGE);
+    plcrash_async_memory_file_t file;
+    plcrash_async_memory_region_t regions[8];
+    plcrash_async_memory_source_t source;
+    plcrash_async_macho_t image;
+    size_t count;
+
+    CHECK_ERR(plcrash_nasync_memory_file_open(&file, path), PLCRASH_ESUCCESS);
+    free(path);
+    if (file.data == NULL)
+        return;
+
+    CHECK_ERR(plcrash_nasync_memory_file_macho_regions(&file, CHECK_SLIDE, regions, 8, &count), PLCRASH_ESUCCESS);
+    CHECK_ERR(plcrash_async_memory_source_regions_init(&source, regions, count), PLCRASH_ESUCCESS);
+    CHECK_ERR(plcrash_async_memory_source_register(&source), PLCRASH_ESUCCESS);
+
+    task_t task = plcrash_async_memory_source_task(&source);
+    CHECK(MACH_PORT_VALID(task));
+    CHECK(plcrash_async_memory_source_lookup(task) == &source);
+    CHECK(plcrash_async_memory_source_lookup(mach_task_self()) == NULL);
+
+    /* Reads are served from the file's segments at their slid addresses, and fail outside of them */
+    uint32_t magic;
+    CHECK_ERR(plcrash_async_task_memcpy(task, CHECK_TEXT_VMADDR + CHECK_SLIDE, 0, &magic, sizeof(magic)), PLCRASH_ESUCCESS);
+    CHECK(magic == MH_MAGIC_64);
+    CHECK_ERR(plcrash_async_task_memcpy(task, CHECK_TEXT_VMADDR, 0, &magic, sizeof(magic)), PLCRASH_ENOTFOUND);
+
+    /* Parse the image, and resolve symbols in both directions */
+    CHECK_ERR(plcrash_nasync_macho_init(&image, task, "tbin", CHECK_TEXT_VMADDR + CHECK_SLIDE), PLCRASH_ESUCCESS);
+    CHECK(plcrash_async_macho_cpu_type(&image) == CPU_TYPE_X86_64);
+    CHECK(image.vmaddr_slide == CHECK_SLIDE);
+
+    pl_vm_address_t pc = 0;
+    CHECK_ERR(plcrash_async_macho_find_symbol_by_name(&image, "_test_rbx", &pc), PLCRASH_ESUCCESS);
+    CHECK(pc == CHECK_TEST_RBX_ADDR + CHECK_SLIDE);
+
+    char name[128] = "";
+    CHECK_ERR(plcrash_async_macho_find_symbol_by_pc(&image, CHECK_TEST_RBX_ADDR + CHECK_SLIDE + 4, found_symbol, name), PLCRASH_ESUCCESS);
+    CHECK(strcmp(name, "_test_rbx") == 0);
+
+    /* Section mappings are served in place from the mapped file */
+    plcrash_async_mobject_t mobj;
+    CHECK_ERR(plcrash_async_macho_map_section(&image, "__TEXT", "__unwind_info", &mobj), PLCRASH_ESUCCESS);
+    CHECK(plcrash_async_mobject_length(&mobj) == CHECK_UNWIND_INFO_SIZE);
+
+    uintptr_t local = (uintptr_t) plcrash_async_mobject_remap_address(&mobj, plcrash_async_mobject_base_address(&mobj), 0, CHECK_UNWIND_INFO_SIZE);
+    CHECK(local >= (uintptr_t) file.data && local + CHECK_UNWIND_INFO_SIZE <= (uintptr_t) file.data + file.length);
+    plcrash_async_mobject_free(&mobj);
+
+    plcrash_nasync_macho_free(&image);
+
+    plcrash_async_memory_source_unregister(&source);
+    CHECK(plcrash_async_memory_source_lookup(task) == NULL);
+
+    plcrash_nasync_memory_file_close(&file);
+}
+
+static void check_registration_limit (void) {
+    plcrash_async_memory_region_t region = { .address = 0x1000, .length = 0x1000, .data = NULL };
+    plcrash_async_memory_source_t sources[PLCRASH_ASYNC_MEMORY_SOURCE_MAX + 1];
+
+    for (size_t i = 0; i < PLCRASH_ASYNC_MEMORY_SOURCE_MAX + 1; i++)
+        CHECK_ERR(plcrash_async_memory_source_regions_init(&sources[i], &region, 1), PLCRASH_ESUCCESS);
+
+    /* Every slot may be claimed, and each handle is distinct */
+    for (size_t i = 0; i < PLCRASH_ASYNC_MEMORY_SOURCE_MAX; i++) {
+        CHECK_ERR(plcrash_async_memory_source_register(&sources[i]), PLCRASH_ESUCCESS);
+        for (size_t j = 0; j < i; j++)
+            CHECK(plcrash_async_memory_source_task(&sources[i]) != plcrash_async_memory_source_task(&sources[j]));
+    }
+
+    CHECK_ERR(plcrash_async_memory_source_register(&sources[PLCRASH_ASYNC_MEMORY_SOURCE_MAX]), PLCRASH_ENOMEM);
+    CHECK(plcrash_async_memory_source_task(&sources[PLCRASH_ASYNC_MEMORY_SOURCE_MAX]) == MACH_PORT_NULL);
+
+    for (size_t i = 0; i < PLCRASH_ASYNC_MEMORY_SOURCE_MAX; i++)
+        plcrash_async_memory_source_unregister(&sources[i]);
+}
+
+static void check_universal_image (const char *resources) {
+    char *path = fixture_path(resources, CHECK_FAT_IMAGE);
+    plcrash_async_memory_file_t file;
+    plcrash_async_memory_region_t regions[8];
+    size_t count;
+
+    CHECK_ERR(plcrash_nasync_memory_file_open(&file, path), PLCRASH_ESUCCESS);
+    free(path);
+    if (file.data == NULL)
+        return;
+
+    CHECK_ERR(plcrash_nasync_memory_file_macho_regions(&file, 0, regions, 8, &count), PLCRASH_ENOTSUP);
+    plcrash_nasync_memory_file_close(&file);
+}
+
+int main (int argc, char *argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s <Resources/Tests directory>\n", argv[0]);
+        return 2;
+    }
+
+    check_macho_image(argv[1]);
+    check_registration_limit();
+    check_universal_image(argv[1]);
+
+    if (failures > 0) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+
+    printf("macho_source_check: all checks passed\n");
+    return 0;
+}
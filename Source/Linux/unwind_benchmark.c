@@ -0,0 +1,674 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Benchmarks the frame readers against the x86-64 libunwind regression binaries, with no live task.
+ *
+ * The fixture images are loaded from disk into a single memory source, alongside a synthetic stack on which the
+ * images' test functions are laid out as if each had called the next, exactly as their prologues would have left it.
+ * The stack is walked with each reader that supports the image, and every unwound frame is verified against the
+ * layout; the walk is then repeated, reporting the time and target memory accesses per frame.
+ *
+ * If a baseline is provided, the benchmark fails if a reader performs more target memory accesses per frame than the
+ * baseline records, or takes more than the given percentage longer per frame.
+ *
+ * Usage: unwind_benchmark [--iterations=N] [--baseline=FILE] [--tolerance=PERCENT] [--write-baseline=FILE]
+ *            <Resources/Tests directory>
+ */
+
+#include "PLCrashAsyncMemorySource.h"
+#include "PLCrashAsyncMachOImage.h"
+#include "PLCrashFrameWalker.h"
+
+#include "PLCrashFrameStackUnwind.h"
+#include "PLCrashFrameCompactUnwind.h"
+#include "PLCrashFrameDWARFUnwind.h"
+
+#include "PLCrashFeatureConfig.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+
+/** The number of frames laid out on the synthetic stack. */
+#define UNWIND_BENCH_STACK_DEPTH 64
+
+/** The target address and size of the synthetic stack. */
+#define UNWIND_BENCH_STACK_ADDR 0x7ff000000000ULL
+#define UNWIND_BENCH_STACK_SIZE (64 * 1024)
+
+/** The unslid address of each fixture's Mach-O header. */
+#define UNWIND_BENCH_HEADER_VMADDR 0x100000000ULL
+
+/** The maximum number of regions vended per fixture image. */
+#define UNWIND_BENCH_IMAGE_REGION_MAX 8
+
+/** The default number of timed walks per reader. */
+#define UNWIND_BENCH_DEFAULT_ITERATIONS 2000
+
+/** The callee-preserved registers tracked across the synthetic stack. */
+static const plcrash_regnum_t bench_nv_regs[] = {
+    PLCRASH_X86_64_RBX,
+    PLCRASH_X86_64_RBP,
+    PLCRASH_X86_64_R12,
+    PLCRASH_X86_64_R13,
+    PLCRASH_X86_64_R14,
+    PLCRASH_X86_64_R15
+};
+
+#define UNWIND_BENCH_NV_REG_COUNT (sizeof(bench_nv_regs) / sizeof(bench_nv_regs[0]))
+
+/* A register saved by a test function, and the offset of its slot below the canonical frame address (CFA). */
+struct bench_saved_reg {
+    plcrash_regnum_t reg;
+    uint32_t cfa_offset;
+};
+
+/* The stack layout of a fixture test function at its call to uwind_to_main(). */
+struct bench_function {
+    /* The function's symbol. */
+    const char *symbol;
+
+    /* The offset of the call's return address from the function's start. */
+    uint32_t return_offset;
+
+    /* The number of bytes between the CFA and the stack pointer at the call. */
+    uint32_t frame_size;
+
+    /* If true, the function establishes an RBP frame; RBP is saved at CFA-16, and then points at the saved value. */
+    bool rbp_frame;
+
+    /* The registers saved by the function, terminated by an entry with a cfa_offset of 0. */
+    struct bench_saved_reg saved[7];
+};
+
+/* Test functions of the frame-based fixtures (unwind_test_x86_64_frame.s and its DWARF-only variant). */
+static const struct bench_function bench_frame_functions[] = {
+    { "_test_no_reg",               0x09, 16, true, { { PLCRASH_X86_64_RBP, 16 } } },
+    { "_test_rbx",                  0x15, 32, true, { { PLCRASH_X86_64_RBP, 16 }, { PLCRASH_X86_64_RBX, 24 } } },
+    { "_test_rbx_r12",              0x23, 32, true, { { PLCRASH_X86_64_RBP, 16 }, { PLCRASH_X86_64_RBX, 32 }, { PLCRASH_X86_64_R12, 24 } } },
+    { "_test_rbx_r14",              0x23, 32, true, { { PLCRASH_X86_64_RBP, 16 }, { PLCRASH_X86_64_RBX, 32 }, { PLCRASH_X86_64_R14, 24 } } },
+    { "_test_rbx_r12_r13",          0x2e, 48, true, { { PLCRASH_X86_64_RBP, 16 }, { PLCRASH_X86_64_RBX, 40 }, { PLCRASH_X86_64_R12, 32 },
+                                                      { PLCRASH_X86_64_R13, 24 } } },
+    { "_test_rbx_r12_r13_r14",      0x39, 48, true, { { PLCRASH_X86_64_RBP, 16 }, { PLCRASH_X86_64_RBX, 48 }, { PLCRASH_X86_64_R12, 40 },
+                                                      { PLCRASH_X86_64_R13, 32 }, { PLCRASH_X86_64_R14, 24 } } },
+    { "_test_r14_r13_r12_rbx",      0x39, 48, true, { { PLCRASH_X86_64_RBP, 16 }, { PLCRASH_X86_64_R14, 48 }, { PLCRASH_X86_64_R13, 40 },
+                                                      { PLCRASH_X86_64_R12, 32 }, { PLCRASH_X86_64_RBX, 24 } } },
+    { "_test_rbx_r12_r13_r14_r15",  0x3d, 64, true, { { PLCRASH_X86_64_RBP, 16 }, { PLCRASH_X86_64_RBX, 56 }, { PLCRASH_X86_64_R12, 48 },
+                                                      { PLCRASH_X86_64_R13, 40 }, { PLCRASH_X86_64_R14, 32 }, { PLCRASH_X86_64_R15, 24 } } },
+    { "_test_r13_rbx_r14_r15_r12",  0x44, 64, true, { { PLCRASH_X86_64_RBP, 16 }, { PLCRASH_X86_64_R13, 56 }, { PLCRASH_X86_64_RBX, 48 },
+                                                      { PLCRASH_X86_64_R14, 40 }, { PLCRASH_X86_64_R15, 32 }, { PLCRASH_X86_64_R12, 24 } } },
+    { NULL }
+};
+
+/* Test functions of the frameless fixture (unwind_test_x86_64_frameless.s). */
+static const struct bench_function bench_frameless_functions[] = {
+    { "_test_no_reg",                   0x09, 16, false, { { 0 } } },
+    { "_test_rbx",                      0x0d, 16, false, { { PLCRASH_X86_64_RBX, 16 } } },
+    { "_test_rbx_r12",                  0x21, 32, false, { { PLCRASH_X86_64_RBX, 24 }, { PLCRASH_X86_64_R12, 16 } } },
+    { "_test_rbx_rbp",                  0x21, 32, false, { { PLCRASH_X86_64_RBX, 24 }, { PLCRASH_X86_64_RBP, 16 } } },
+    { "_test_rbx_r12_r13",              0x2d, 32, false, { { PLCRASH_X86_64_RBX, 32 }, { PLCRASH_X86_64_R12, 24 }, { PLCRASH_X86_64_R13, 16 } } },
+    { "_test_rbx_r12_r13_r14",          0x39, 48, false, { { PLCRASH_X86_64_RBX, 40 }, { PLCRASH_X86_64_R12, 32 }, { PLCRASH_X86_64_R13, 24 },
+                                                           { PLCRASH_X86_64_R14, 16 } } },
+    { "_test_rbx_r12_r13_r14_r15",      0x45, 48, false, { { PLCRASH_X86_64_RBX, 48 }, { PLCRASH_X86_64_R12, 40 }, { PLCRASH_X86_64_R13, 32 },
+                                                           { PLCRASH_X86_64_R14, 24 }, { PLCRASH_X86_64_R15, 16 } } },
+    { "_test_rbx_rbp_r12_r13_r14_r15",  0x51, 80, false, { { PLCRASH_X86_64_RBX, 56 }, { PLCRASH_X86_64_RBP, 48 }, { PLCRASH_X86_64_R12, 40 },
+                                                           { PLCRASH_X86_64_R13, 32 }, { PLCRASH_X86_64_R14, 24 }, { PLCRASH_X86_64_R15, 16 } } },
+    { "_test_rbx_rbp_r12",              0x2d, 32, false, { { PLCRASH_X86_64_RBX, 32 }, { PLCRASH_X86_64_RBP, 24 }, { PLCRASH_X86_64_R12, 16 } } },
+    { "_test_rbx_rbp_r12_r13",          0x39, 48, false, { { PLCRASH_X86_64_RBX, 40 }, { PLCRASH_X86_64_RBP, 32 }, { PLCRASH_X86_64_R12, 24 },
+                                                           { PLCRASH_X86_64_R13, 16 } } },
+    { "_test_rbx_rbp_r12_r13_r14",      0x45, 48, false, { { PLCRASH_X86_64_RBX, 48 }, { PLCRASH_X86_64_RBP, 40 }, { PLCRASH_X86_64_R12, 32 },
+                                                           { PLCRASH_X86_64_R13, 24 }, { PLCRASH_X86_64_R14, 16 } } },
+    { NULL }
+};
+
+/* A fixture image. */
+struct bench_image {
+    /* The image's path, relative to the Resources/Tests directory. */
+    const char *path;
+
+    /* The image's test functions. */
+    const struct bench_function *functions;
+
+    /* The slide applied to the image's segments. */
+    pl_vm_off_t slide;
+
+    /* The mapped image file. */
+    plcrash_async_memory_file_t file;
+
+    /* The address of each test function, indexed as per functions. */
+    pl_vm_address_t addresses[16];
+};
+
+static struct bench_image bench_images[] = {
+    { "PLCrashAsyncDwarfEncodingTests/regression-bins/tbin.unwind_test_x86_64_frame.s.2",                   bench_frame_functions,      0x10000000 },
+    { "PLCrashAsyncDwarfEncodingTests/regression-bins/tbin.unwind_test_x86_64_disable_compact_frame.s.1",   bench_frame_functions,      0x20000000 },
+    { "PLCrashAsyncDwarfEncodingTests/regression-bins/tbin.unwind_test_x86_64_frameless.s.6",               bench_frameless_functions,  0x30000000 },
+};
+
+#define UNWIND_BENCH_IMAGE_COUNT (sizeof(bench_images) / sizeof(bench_images[0]))
+
+/* A benchmarked reader, and the fixture against which it is run. As in the libunwind regression harness, the frame
+ * pointer reader is only run against frame-based functions, and the DWARF reader against images that vend FDEs for the
+ * test functions. */
+struct bench_case {
+    /* The fixture image. */
+    struct bench_image *image;
+
+    /* The reader's name, as reported. */
+    const char *reader_name;
+
+    /* The frame reader. */
+    plframe_cursor_frame_reader_t *reader;
+
+    /* If true, the reader restores callee-preserved registers, and these are verified. */
+    bool restores_callee_registers;
+};
+
+static const struct bench_case bench_cases[] = {
+    { &bench_images[0], "frame_ptr",    plframe_cursor_read_frame_ptr,          false },
+#if PLCRASH_FEATURE_UNWIND_COMPACT
+    { &bench_images[0], "compact",      plframe_cursor_read_compact_unwind,     true },
+#endif
+#if PLCRASH_FEATURE_UNWIND_DWARF
+    { &bench_images[1], "dwarf",        plframe_cursor_read_dwarf_unwind,       true },
+#endif
+#if PLCRASH_FEATURE_UNWIND_COMPACT
+    { &bench_images[2], "compact",      plframe_cursor_read_compact_unwind,     true },
+#endif
+#if PLCRASH_FEATURE_UNWIND_DWARF
+    { &bench_images[2], "dwarf",        plframe_cursor_read_dwarf_unwind,       true },
+#endif
+};
+
+#define UNWIND_BENCH_CASE_COUNT (sizeof(bench_cases) / sizeof(bench_cases[0]))
+
+/* The expected state of a single frame on the synthetic stack. */
+struct bench_frame {
+    plcrash_greg_t ip;
+    plcrash_greg_t sp;
+    plcrash_greg_t nv_regs[UNWIND_BENCH_NV_REG_COUNT];
+};
+
+/* A synthetic stack, laid out for the test functions of a single image. */
+struct bench_stack {
+    /* The stack contents, addressed from UNWIND_BENCH_STACK_ADDR. */
+    uint8_t data[UNWIND_BENCH_STACK_SIZE];
+
+    /* The expected frames, outermost first. */
+    struct bench_frame frames[UNWIND_BENCH_STACK_DEPTH];
+};
+
+/* Accumulated results for a single benchmark case. */
+struct bench_result {
+    /* Frames read */
+    uint64_t frames;
+
+    /* Total time spent walking the stack, in nanoseconds */
+    uint64_t elapsed;
+
+    /* Total target memory accesses performed while walking the stack */
+    plcrash_async_read_stats_t reads;
+};
+
+/* Per-frame results, as recorded in a baseline. */
+struct bench_summary {
+    double reads;
+    double bytes;
+    double maps;
+    double ns;
+};
+
+static struct bench_stack bench_stack;
+static plcrash_async_memory_region_t bench_regions[UNWIND_BENCH_IMAGE_COUNT * UNWIND_BENCH_IMAGE_REGION_MAX + 1];
+
+/* Join @a dir and @a path, returning a newly allocated path. */
+static char *fixture_path (const char *dir, const char *path) {
+    size_t len = strlen(dir) + strlen(path) + 2;
+    char *result = malloc(len);
+    snprintf(result, len, "%s/%s", dir, path);
+    return result;
+}
+
+/* Return the current monotonic time, in nanoseconds. */
+static uint64_t bench_now (void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/* Return the index of @a reg in bench_nv_regs. */
+static size_t bench_nv_reg_index (plcrash_regnum_t reg) {
+    for (size_t i = 0; i < UNWIND_BENCH_NV_REG_COUNT; i++) {
+        if (bench_nv_regs[i] == reg)
+            return i;
+    }
+
+    abort();
+}
+
+/* Write @a value to the synthetic stack at @a address. */
+static void bench_stack_write (pl_vm_address_t address, uint64_t value) {
+    PLCF_ASSERT(address >= UNWIND_BENCH_STACK_ADDR && address - UNWIND_BENCH_STACK_ADDR <= UNWIND_BENCH_STACK_SIZE - sizeof(value));
+    memcpy(&bench_stack.data[address - UNWIND_BENCH_STACK_ADDR], &value, sizeof(value));
+}
+
+/*
+ * Resolve the test functions of @a image, and verify that each return offset follows a call instruction.
+ */
+static bool bench_image_resolve (struct bench_image *image, task_t task) {
+    plcrash_async_macho_t macho;
+    plcrash_error_t err;
+    bool result = true;
+
+    if ((err = plcrash_nasync_macho_init(&macho, task, image->path, UNWIND_BENCH_HEADER_VMADDR + image->slide)) != PLCRASH_ESUCCESS) {
+        fprintf(stderr, "%s: could not parse image: %s\n", image->path, plcrash_async_strerror(err));
+        return false;
+    }
+
+    for (size_t i = 0; image->functions[i].symbol != NULL; i++) {
+        const struct bench_function *fn = &image->functions[i];
+        uint8_t opcode;
+
+        if ((err = plcrash_async_macho_find_symbol_by_name(&macho, fn->symbol, &image->addresses[i])) != PLCRASH_ESUCCESS) {
+            fprintf(stderr, "%s: could not find %s: %s\n", image->path, fn->symbol, plcrash_async_strerror(err));
+            result = false;
+            continue;
+        }
+
+        /* call rel32 */
+        err = plcrash_async_task_memcpy(task, image->addresses[i], fn->return_offset - 5, &opcode, sizeof(opcode));
+        if (err != PLCRASH_ESUCCESS || opcode != 0xe8) {
+            fprintf(stderr, "%s: %s+0x%" PRIx32 " does not follow a call\n", image->path, fn->symbol, fn->return_offset);
+            result = false;
+        }
+    }
+
+    plcrash_nasync_macho_free(&macho);
+    return result;
+}
+
+/*
+ * Lay out UNWIND_BENCH_STACK_DEPTH frames of @a image's test functions on the synthetic stack, cycling through the
+ * functions from the outermost frame inwards; each frame's return address points into its caller's call to
+ * uwind_to_main(). The outermost frame returns to a NULL address, with a NULL saved frame pointer.
+ *
+ * Each function replaces the value of every register it saves with a value unique to its frame, other than RBP
+ * in an RBP frame, which holds the frame pointer.
+ */
+static void bench_stack_init (const struct bench_image *image) {
+    plcrash_greg_t regs[UNWIND_BENCH_NV_REG_COUNT];
+    pl_vm_address_t sp = UNWIND_BENCH_STACK_ADDR + UNWIND_BENCH_STACK_SIZE;
+    pl_vm_address_t return_address = 0;
+    size_t function_count = 0;
+
+    while (image->functions[function_count].symbol != NULL)
+        function_count++;
+
+    memset(bench_stack.data, 0, sizeof(bench_stack.data));
+    for (size_t i = 0; i < UNWIND_BENCH_NV_REG_COUNT; i++)
+        regs[i] = (bench_nv_regs[i] == PLCRASH_X86_64_RBP) ? 0 : 0xA5A5000000000000ULL | (i + 1);
+
+    for (size_t depth = 0; depth < UNWIND_BENCH_STACK_DEPTH; depth++) {
+        const struct bench_function *fn = &image->functions[depth % function_count];
+        pl_vm_address_t cfa = sp;
+
+        /* The caller's return address, and the caller's values of the registers saved by this function */
+        bench_stack_write(cfa - 8, return_address);
+        for (const struct bench_saved_reg *saved = fn->saved; saved->cfa_offset != 0; saved++)
+            bench_stack_write(cfa - saved->cfa_offset, regs[bench_nv_reg_index(saved->reg)]);
+
+        for (const struct bench_saved_reg *saved = fn->saved; saved->cfa_offset != 0; saved++) {
+            size_t idx = bench_nv_reg_index(saved->reg);
+            if (saved->reg == PLCRASH_X86_64_RBP && fn->rbp_frame) {
+                regs[idx] = cfa - 16;
+            } else {
+                regs[idx] = 0xA5A5000000000000ULL | ((depth + 1) << 16) | (idx + 1);
+            }
+        }
+
+        sp = cfa - fn->frame_size;
+        return_address = image->addresses[depth % function_count] + fn->return_offset;
+
+        struct bench_frame *frame = &bench_stack.frames[depth];
+        frame->ip = return_address;
+        frame->sp = sp;
+        memcpy(frame->nv_regs, regs, sizeof(frame->nv_regs));
+    }
+}
+
+/* Initialize @a state as the innermost frame of the synthetic stack. */
+static void bench_thread_state_init (plcrash_async_thread_state_t *state) {
+    const struct bench_frame *frame = &bench_stack.frames[UNWIND_BENCH_STACK_DEPTH - 1];
+
+    plcrash_async_thread_state_init(state, CPU_TYPE_X86_64);
+    plcrash_async_thread_state_set_reg(state, PLCRASH_REG_IP, frame->ip);
+    plcrash_async_thread_state_set_reg(state, PLCRASH_REG_SP, frame->sp);
+    for (size_t i = 0; i < UNWIND_BENCH_NV_REG_COUNT; i++)
+        plcrash_async_thread_state_set_reg(state, bench_nv_regs[i], frame->nv_regs[i]);
+}
+
+/* Verify that @a reg is available in the cursor's current frame, and matches @a expected. */
+static bool bench_verify_reg (plframe_cursor_t *cursor, const struct bench_case *bc, size_t depth, plcrash_regnum_t reg, plcrash_greg_t expected) {
+    plcrash_greg_t value;
+
+    if (plframe_cursor_get_reg(cursor, reg, &value) != PLFRAME_ESUCCESS) {
+        fprintf(stderr, "%s (%s): frame %zu: %s is unavailable\n", bc->image->path, bc->reader_name, depth,
+                plframe_cursor_get_regname(cursor, reg));
+        return false;
+    }
+
+    if (value != expected) {
+        fprintf(stderr, "%s (%s): frame %zu: %s is 0x%" PRIx64 ", expected 0x%" PRIx64 "\n", bc->image->path, bc->reader_name,
+                depth, plframe_cursor_get_regname(cursor, reg), (uint64_t) value, (uint64_t) expected);
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * Walk the synthetic stack with @a bc's reader, verifying each frame.
+ */
+static bool bench_verify (const struct bench_case *bc, task_t task, plcrash_async_image_list_t *image_list) {
+    plcrash_async_thread_state_t state;
+    plframe_cursor_t cursor;
+    plframe_error_t err;
+    bool result = true;
+
+    bench_thread_state_init(&state);
+    plframe_cursor_init(&cursor, task, &state, image_list);
+
+    for (size_t i = 0; i < UNWIND_BENCH_STACK_DEPTH && result; i++) {
+        size_t depth = UNWIND_BENCH_STACK_DEPTH - 1 - i;
+        const struct bench_frame *frame = &bench_stack.frames[depth];
+
+        if ((err = plframe_cursor_next_with_readers(&cursor, (plframe_cursor_frame_reader_t **) &bc->reader, 1)) != PLFRAME_ESUCCESS) {
+            fprintf(stderr, "%s (%s): frame %zu: step failed: %s\n", bc->image->path, bc->reader_name, depth, plframe_strerror(err));
+            result = false;
+            break;
+        }
+
+        result = bench_verify_reg(&cursor, bc, depth, PLCRASH_REG_IP, frame->ip);
+        if (!bc->restores_callee_registers) {
+            result = result && bench_verify_reg(&cursor, bc, depth, PLCRASH_REG_FP, frame->nv_regs[bench_nv_reg_index(PLCRASH_REG_FP)]);
+            continue;
+        }
+
+        result = result && bench_verify_reg(&cursor, bc, depth, PLCRASH_REG_SP, frame->sp);
+        for (size_t r = 0; r < UNWIND_BENCH_NV_REG_COUNT && result; r++)
+            result = bench_verify_reg(&cursor, bc, depth, bench_nv_regs[r], frame->nv_regs[r]);
+    }
+
+    /* The outermost frame terminates the stack */
+    if (result && (err = plframe_cursor_next_with_readers(&cursor, (plframe_cursor_frame_reader_t **) &bc->reader, 1)) != PLFRAME_ENOFRAME) {
+        fprintf(stderr, "%s (%s): stack was not terminated: %s\n", bc->image->path, bc->reader_name, plframe_strerror(err));
+        result = false;
+    }
+
+    plframe_cursor_free(&cursor);
+    return result;
+}
+
+/*
+ * Repeatedly walk the synthetic stack with @a bc's reader, accumulating the results in @a result.
+ */
+static bool bench_run (const struct bench_case *bc, task_t task, plcrash_async_image_list_t *image_list, uint32_t iterations, struct bench_result *result) {
+    plcrash_async_thread_state_t state;
+    plcrash_async_read_stats_t start_stats, end_stats;
+    uint64_t start_time, end_time;
+    uint64_t frames = 0;
+
+    bench_thread_state_init(&state);
+
+    plcrash_async_read_stats_get(&start_stats);
+    start_time = bench_now();
+    for (uint32_t iter = 0; iter < iterations; iter++) {
+        plframe_cursor_t cursor;
+
+        plframe_cursor_init(&cursor, task, &state, image_list);
+        while (plframe_cursor_next_with_readers(&cursor, (plframe_cursor_frame_reader_t **) &bc->reader, 1) == PLFRAME_ESUCCESS)
+            frames++;
+        plframe_cursor_free(&cursor);
+    }
+    end_time = bench_now();
+    plcrash_async_read_stats_get(&end_stats);
+
+    result->frames = frames;
+    result->elapsed = end_time - start_time;
+    result->reads.read_count = end_stats.read_count - start_stats.read_count;
+    result->reads.read_bytes = end_stats.read_bytes - start_stats.read_bytes;
+    result->reads.map_count = end_stats.map_count - start_stats.map_count;
+    result->reads.map_bytes = end_stats.map_bytes - start_stats.map_bytes;
+
+    if (frames != (uint64_t) iterations * UNWIND_BENCH_STACK_DEPTH) {
+        fprintf(stderr, "%s (%s): read %" PRIu64 " frames, expected %" PRIu64 "\n", bc->image->path, bc->reader_name, frames,
+                (uint64_t) iterations * UNWIND_BENCH_STACK_DEPTH);
+        return false;
+    }
+
+    return true;
+}
+
+/* Return the name of @a bc, as reported and recorded in a baseline. */
+static void bench_case_name (const struct bench_case *bc, char *buf, size_t len) {
+    const char *image = strrchr(bc->image->path, '/');
+    snprintf(buf, len, "%s:%s", image != NULL ? image + 1 : bc->image->path, bc->reader_name);
+}
+
+/* Look up @a name in the baseline at @a path. Returns true if found. */
+static bool bench_baseline_lookup (const char *path, const char *name, struct bench_summary *summary) {
+    char line[512];
+    char entry[256];
+    bool found = false;
+    FILE *fp;
+
+    if ((fp = fopen(path, "r")) == NULL) {
+        perror(path);
+        return false;
+    }
+
+    while (!found && fgets(line, sizeof(line), fp) != NULL) {
+        if (line[0] == '#')
+            continue;
+
+        if (sscanf(line, "%255s %lf %lf %lf %lf", entry, &summary->reads, &summary->bytes, &summary->maps, &summary->ns) == 5 && strcmp(entry, name) == 0)
+            found = true;
+    }
+
+    fclose(fp);
+    return found;
+}
+
+/*
+ * Compare @a current against the baseline at @a path. Target memory accesses are deterministic, and must not exceed
+ * the baseline; time may exceed the baseline by at most @a tolerance percent.
+ */
+static bool bench_baseline_check (const char *path, const char *name, const struct bench_summary *current, double tolerance) {
+    struct bench_summary baseline;
+    bool result = true;
+
+    if (!bench_baseline_lookup(path, name, &baseline)) {
+        fprintf(stderr, "%s: no baseline for %s\n", path, name);
+        return false;
+    }
+
+/* Counters are recorded to four decimal places */
+#define BENCH_CHECK_COUNTER(field, label) do { \
+    if (current->field > baseline.field + 0.00005) { \
+        fprintf(stderr, "%s: %.4f " label "/frame exceeds the baseline of %.4f\n", name, current->field, baseline.field); \
+        result = false; \
+    } \
+} while (0)
+
+    BENCH_CHECK_COUNTER(reads, "reads");
+    BENCH_CHECK_COUNTER(bytes, "bytes");
+    BENCH_CHECK_COUNTER(maps, "maps");
+
+#undef BENCH_CHECK_COUNTER
+
+    if (current->ns > baseline.ns * (1.0 + tolerance / 100.0)) {
+        fprintf(stderr, "%s: %.1f ns/frame exceeds the baseline of %.1f ns/frame by more than %.0f%%\n", name, current->ns,
+                baseline.ns, tolerance);
+        result = false;
+    }
+
+    return result;
+}
+
+int main (int argc, char *argv[]) {
+    const char *resources = NULL;
+    const char *baseline = NULL;
+    const char *write_baseline = NULL;
+    uint32_t iterations = UNWIND_BENCH_DEFAULT_ITERATIONS;
+    double tolerance = 100;
+    size_t region_count = 0;
+    plcrash_async_memory_source_t source;
+    plcrash_async_image_list_t image_list;
+    plcrash_error_t err;
+    FILE *baseline_out = NULL;
+    int failures = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--iterations=", 13) == 0) {
+            iterations = (uint32_t) strtoul(argv[i] + 13, NULL, 10);
+        } else if (strncmp(argv[i], "--baseline=", 11) == 0) {
+            baseline = argv[i] + 11;
+        } else if (strncmp(argv[i], "--tolerance=", 12) == 0) {
+            tolerance = strtod(argv[i] + 12, NULL);
+        } else if (strncmp(argv[i], "--write-baseline=", 17) == 0) {
+            write_baseline = argv[i] + 17;
+        } else if (resources == NULL && argv[i][0] != '-') {
+            resources = argv[i];
+        } else {
+            resources = NULL;
+            break;
+        }
+    }
+
+    if (resources == NULL || iterations == 0) {
+        fprintf(stderr, "Usage: %s [--iterations=N] [--baseline=FILE] [--tolerance=PERCENT] [--write-baseline=FILE] "
+                "<Resources/Tests directory>\n", argv[0]);
+        return 2;
+    }
+
+    /* Load the fixture images, and the synthetic stack, into a single memory source */
+    for (size_t i = 0; i < UNWIND_BENCH_IMAGE_COUNT; i++) {
+        struct bench_image *image = &bench_images[i];
+        char *path = fixture_path(resources, image->path);
+        size_t count;
+
+        err = plcrash_nasync_memory_file_open(&image->file, path);
+        free(path);
+        if (err != PLCRASH_ESUCCESS) {
+            fprintf(stderr, "%s: could not open image: %s\n", image->path, plcrash_async_strerror(err));
+            return 1;
+        }
+
+        err = plcrash_nasync_memory_file_macho_regions(&image->file, image->slide, &bench_regions[region_count], UNWIND_BENCH_IMAGE_REGION_MAX, &count);
+        if (err != PLCRASH_ESUCCESS) {
+            fprintf(stderr, "%s: could not read image segments: %s\n", image->path, plcrash_async_strerror(err));
+            return 1;
+        }
+
+        region_count += count;
+    }
+
+    bench_regions[region_count].address = UNWIND_BENCH_STACK_ADDR;
+    bench_regions[region_count].length = UNWIND_BENCH_STACK_SIZE;
+    bench_regions[region_count].data = bench_stack.data;
+    region_count++;
+
+    if ((err = plcrash_async_memory_source_regions_init(&source, bench_regions, region_count)) != PLCRASH_ESUCCESS ||
+        (err = plcrash_async_memory_source_register(&source)) != PLCRASH_ESUCCESS)
+    {
+        fprintf(stderr, "Could not register memory source: %s\n", plcrash_async_strerror(err));
+        return 1;
+    }
+
+    task_t task = plcrash_async_memory_source_task(&source);
+    plcrash_nasync_image_list_init(&image_list, task);
+    for (size_t i = 0; i < UNWIND_BENCH_IMAGE_COUNT; i++) {
+        if (!bench_image_resolve(&bench_images[i], task))
+            return 1;
+        plcrash_nasync_image_list_append(&image_list, UNWIND_BENCH_HEADER_VMADDR + bench_images[i].slide, bench_images[i].path);
+    }
+
+    if (write_baseline != NULL) {
+        if ((baseline_out = fopen(write_baseline, "w")) == NULL) {
+            perror(write_baseline);
+            return 1;
+        }
+        fprintf(baseline_out, "# Generated by unwind_benchmark --iterations=%" PRIu32 "\n", iterations);
+        fprintf(baseline_out, "# case reads/frame bytes/frame maps/frame ns/frame\n");
+    }
+
+    for (size_t i = 0; i < UNWIND_BENCH_CASE_COUNT; i++) {
+        const struct bench_case *bc = &bench_cases[i];
+        struct bench_result result;
+        struct bench_summary summary;
+        char name[256];
+
+        bench_case_name(bc, name, sizeof(name));
+        bench_stack_init(bc->image);
+
+        if (!bench_verify(bc, task, &image_list) || !bench_run(bc, task, &image_list, iterations, &result)) {
+            failures++;
+            continue;
+        }
+
+        summary.reads = (double) result.reads.read_count / result.frames;
+        summary.bytes = (double) result.reads.read_bytes / result.frames;
+        summary.maps = (double) result.reads.map_count / result.frames;
+        summary.ns = (double) result.elapsed / result.frames;
+
+        printf("%-56s %8.1f ns/frame %6.2f reads/frame %8.1f bytes/frame %6.2f maps/frame\n", name, summary.ns, summary.reads,
+               summary.bytes, summary.maps);
+
+        if (baseline_out != NULL)
+            fprintf(baseline_out, "%s %.4f %.4f %.4f %.1f\n", name, summary.reads, summary.bytes, summary.maps, summary.ns);
+
+        if (baseline != NULL && !bench_baseline_check(baseline, name, &summary, tolerance))
+            failures++;
+    }
+
+    if (baseline_out != NULL)
+        fclose(baseline_out);
+
+    plcrash_nasync_image_list_free(&image_list);
+    plcrash_async_memory_source_unregister(&source);
+    for (size_t i = 0; i < UNWIND_BENCH_IMAGE_COUNT; i++)
+        plcrash_nasync_memory_file_close(&bench_images[i].file);
+
+    if (failures > 0) {
+        fprintf(stderr, "%d benchmark case(s) failed\n", failures);
+        return 1;
+    }
+
+    return 0;
+}
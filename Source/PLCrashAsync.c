@@ -27,6 +27,9 @@
  */
 
 #include "PLCrashAsync.h"
+#include "PLCrashFeatureConfig.h"
+#include "PLCrashAsyncMemorySource.h"
+#include "PLCrashAsyncPageCache.h"
 
 #include <stdint.h>
 #include <errno.h>
@@ -180,11 +183,95 @@ thread_t pl_mach_thread_self (void) {
     return result;
 }
 
+#if PLCRASH_FEATURE_READ_STATISTICS
+/** Global target memory access counters. */
+static plcrash_async_read_stats_t plcrash_async_read_stats;
+#endif
+
+/**
+ * Fetch the current target memory access counters. If PLCRASH_FEATURE_READ_STATISTICS is disabled, all counters
+ * will be zero.
+ *
+ * @param stats The destination to which the counters will be copied.
+ *
+ * @warning The counters are not maintained atomically; this API is intended for use by single-threaded benchmarks
+ * and tests.
+ */
+void plcrash_async_read_stats_get (plcrash_async_read_stats_t *stats) {
+#if PLCRASH_FEATURE_READ_STATISTICS
+    *stats = plcrash_async_read_stats;
+#else
+    plcrash_async_memset(stats, 0, sizeof(*stats));
+#endif
+}
+
+/**
+ * Reset all target memory access counters to zero.
+ */
+void plcrash_async_read_stats_reset (void) {
+#if PLCRASH_FEATURE_READ_STATISTICS
+    plcrash_async_memset(&plcrash_async_read_stats, 0, sizeof(plcrash_async_read_stats));
+#endif
+}
+
+/**
+ * Record the creation of a memory object mapping of @a length bytes.
+ *
+ * @param length The requested mapping length.
+ */
+void plcrash_async_read_stats_record_map (pl_vm_size_t length) {
+#if PLCRASH_FEATURE_READ_STATISTICS
+    plcrash_async_read_stats.map_count++;
+    plcrash_async_read_stats.map_bytes += length;
+#endif
+}
+
+/**
+ * Record the release of a memory object mapping of @a length bytes.
+ *
+ * @param length The mapped length.
+ */
+void plcrash_async_read_stats_record_unmap (pl_vm_size_t length) {
+#if PLCRASH_FEATURE_READ_STATISTICS
+    plcrash_async_read_stats.unmap_count++;
+    plcrash_async_read_stats.unmap_bytes += length;
+#endif
+}
+
+/**
+ * Acquire a reference to @a task on behalf of a memory reader. Registered memory source handles are not Mach ports,
+ * and are not reference counted; the caller must ensure that the source remains registered for the lifetime of
+ * the reader.
+ *
+ * @param task The task to be retained.
+ */
+void plcrash_async_task_retain (task_t task) {
+    if (plcrash_async_memory_source_lookup(task) != NULL)
+        return;
+
+    mach_port_mod_refs(mach_task_self(), task, MACH_PORT_RIGHT_SEND, 1);
+}
+
+/**
+ * Release a reference to @a task previously acquired via plcrash_async_task_retain().
+ *
+ * @param task The task to be released.
+ */
+void plcrash_async_task_release (task_t task) {
+    if (plcrash_async_memory_source_lookup(task) != NULL)
+        return;
+
+    mach_port_mod_refs(mach_task_self(), task, MACH_PORT_RIGHT_SEND, -1);
+}
+
 /**
  * Copy @a len bytes from @a task, at @a address + @a offset, storing in @a dest. If the page(s) at the
  * given @a address + @a offset are unmapped or unreadable, no copy will be performed and an error will
  * be returned.
  *
+ * If a page cache has been attached to the current thread via plcrash_async_page_cache_attach(), the read will be
+ * served via the page cache.
+ *
  * @param task The task from which data from address @a source will be read.
  * @param address The base address within @a task from which the data will be read.
  * @param offset The offset from @a address at which data will be read.
@@ -196,6 +283,32 @@ thread_t pl_mach_thread_self (void) {
  * the proivded address + offset would overflow pl_vm_address_t, PLCRASH_ENOMEM is returned.
  */
 plcrash_error_t plcrash_async_task_memcpy (mach_port_t task, pl_vm_address_t address, pl_vm_off_t offset, void *dest, pl_vm_size_t len) {
+    plcrash_async_page_cache_t *cache = plcrash_async_page_cache_current();
+    if (cache != NULL)
+        return plcrash_async_page_cache_memcpy(cache, task, address, offset, dest, len);
+
+    return plcrash_async_task_memcpy_uncached(task, address, offset, dest, len);
+}
+
+/**
+ * Copy @a len bytes from @a task, at @a address + @a offset, storing in @a dest. If the page(s) at the
+ * given @a address + @a offset are unmapped or unreadable, no copy will be performed and an error will
+ * be returned.
+ *
+ * Unlike plcrash_async_task_memcpy(), the read is always issued directly to @a task, bypassing any attached page cache.
+ * If @a task is the handle of a registered memory source, the read is served by that source.
+ *
+ * @param task The task from which data from address @a source will be read.
+ * @param address The base address within @a task from which the data will be read.
+ * @param offset The offset from @a address at which data will be read.
+ * @param dest The destination address to which copied data will be written.
+ * @param len The number of bytes to be read.
+ *
+ * @return On success, returns PLCRASH_ESUCCESS. If the pages containing @a source + len are unmapped, PLCRASH_ENOTFOUND
+ * will be returned. If the pages can not be read due to access restrictions, PLCRASH_EACCESS will be returned. If
+ * the proivded address + offset would overflow pl_vm_address_t, PLCRASH_ENOMEM is returned.
+ */
+plcrash_error_t plcrash_async_task_memcpy_uncached (mach_port_t task, pl_vm_address_t address, pl_vm_off_t offset, void *dest, pl_vm_size_t len) {
     pl_vm_address_t target;
     kern_return_t kt;
 
@@ -203,6 +316,16 @@ plcrash_error_t plcrash_async_task_memcpy (mach_port_t task, pl_vm_address_t add
     if (!plcrash_async_address_apply_offset(address, offset, &target))
         return PLCRASH_ENOMEM;
 
+#if PLCRASH_FEATURE_READ_STATISTICS
+    plcrash_async_read_stats.read_count++;
+    plcrash_async_read_stats.read_bytes += len;
+#endif
+
+    /* Serve reads of a registered memory source via the source */
+    plcrash_async_memory_source_t *source = plcrash_async_memory_source_lookup(task);
+    if (source != NULL)
+        return source->ops->read(source, target, dest, len);
+
 #ifdef PL_HAVE_MACH_VM
     pl_vm_size_t read_size = len;
     kt = mach_vm_read_overwrite(task, target, len, (pointer_t) dest, &read_size);
@@ -440,12 +563,118 @@ ssize_t plcrash_async_writen (int fd, const void *data, size_t len) {
  * @param fd Open file descriptor.
  */
 void plcrash_async_file_init (plcrash_async_file_t *file, int fd, off_t output_limit) {
+    file->sink = PLCRASH_ASYNC_FILE_SINK_FD;
     file->fd = fd;
+    file->mem = NULL;
+    file->mem_size = 0;
+    file->mem_len = 0;
     file->buflen = 0;
     file->total_bytes = 0;
     file->limit_bytes = output_limit;
 }
 
+/**
+ * Initialize the plcrash_async_file_t instance to write directly to a fixed-size memory buffer. Writes that would
+ * exceed @a size bytes will be dropped.
+ *
+ * The buffer remains owned by the caller, and must remain valid until the file is closed. The number of bytes
+ * written may be fetched with plcrash_async_file_buffer_length().
+ *
+ * @param file File structure to initialize.
+ * @param buffer The output buffer.
+ * @param size The size of @a buffer, in bytes.
+ */
+void plcrash_async_file_init_buffer (plcrash_async_file_t *file, void *buffer, size_t size) {
+    file->sink = PLCRASH_ASYNC_FILE_SINK_BUFFER;
+    file->fd = -1;
+    file->mem = buffer;
+    file->mem_size = size;
+    file->mem_len = 0;
+    file->buflen = 0;
+    file->total_bytes = 0;
+    file->limit_bytes = 0;
+}
+
+/**
+ * Initialize the plcrash_async_file_t instance to write directly to a memory buffer, which will be grown as
+ * required. The buffer is allocated with vm_allocate(), and may safely be grown while other threads are suspended.
+ *
+ * The written data may be claimed with plcrash_async_file_buffer_detach(); any data that has not been claimed will
+ * be freed by plcrash_async_file_close().
+ *
+ * @param file File structure to initialize.
+ * @param initial_size The initial buffer allocation, in bytes. This will be rounded up to the page size.
+ * @param output_limit Maximum number of bytes that will be written to the buffer. Specify 0 to disable any limits.
+ * Once the limit is reached, all data will be dropped.
+ *
+ * @return Returns PLCRASH_ENOMEM if the initial buffer could not be allocated, or PLCRASH_ESUCCESS on success.
+ */
+plcrash_error_t plcrash_async_file_init_growable (plcrash_async_file_t *file, size_t initial_size, off_t output_limit) {
+    vm_address_t mem;
+    kern_return_t kt;
+
+    file->sink = PLCRASH_ASYNC_FILE_SINK_GROWABLE;
+    file->fd = -1;
+    file->mem = NULL;
+    file->mem_size = 0;
+    file->mem_len = 0;
+    file->buflen = 0;
+    file->total_bytes = 0;
+    file->limit_bytes = output_limit;
+
+    initial_size = round_page(initial_size == 0 ? 1 : initial_size);
+    if ((kt = vm_allocate(mach_task_self(), &mem, initial_size, VM_FLAGS_ANYWHERE)) != KERN_SUCCESS) {
+        PLCF_DEBUG("Could not allocate output buffer: %d", kt);
+        return PLCRASH_ENOMEM;
+    }
+
+    file->mem = (uint8_t *) mem;
+    file->mem_size = initial_size;
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * @internal
+ *
+ * Append @a len bytes to the memory buffer of @a file, growing the buffer if permitted by the sink type.
+ */
+static bool plcrash_async_file_write_mem (plcrash_async_file_t *file, const void *data, size_t len) {
+    if (file->mem == NULL)
+        return false;
+
+    if (len > file->mem_size - file->mem_len) {
+        if (file->sink != PLCRASH_ASYNC_FILE_SINK_GROWABLE) {
+            PLCF_DEBUG("Output buffer of %zu bytes is full", file->mem_size);
+            return false;
+        }
+
+        /* Grow geometrically */
+        size_t new_size = file->mem_size;
+        while (len > new_size - file->mem_len) {
+            if (new_size > SIZE_MAX / 2)
+                return false;
+            new_size *= 2;
+        }
+
+        vm_address_t mem;
+        kern_return_t kt;
+        if ((kt = vm_allocate(mach_task_self(), &mem, new_size, VM_FLAGS_ANYWHERE)) != KERN_SUCCESS) {
+            PLCF_DEBUG("Could not grow output buffer to %zu bytes: %d", new_size, kt);
+            return false;
+        }
+
+        plcrash_async_memcpy((void *) mem, file->mem, file->mem_len);
+        vm_deallocate(mach_task_self(), (vm_address_t) file->mem, file->mem_size);
+
+        file->mem = (uint8_t *) mem;
+        file->mem_size = new_size;
+    }
+
+    plcrash_async_memcpy(file->mem + file->mem_len, data, len);
+    file->mem_len += len;
+    return true;
+}
 
 /**
  * Write all bytes from @a data to the file buffer. Returns true on success,
@@ -459,6 +688,10 @@ bool plcrash_async_file_write (plcrash_async_file_t *file, const void *data, siz
         file->total_bytes += len;
     }
 
+    /* Memory sinks are written directly, without an intermediate buffer */
+    if (file->sink != PLCRASH_ASYNC_FILE_SINK_FD)
+        return plcrash_async_file_write_mem(file, data, len);
+
     /* Check if the buffer will fill */
     if (file->buflen + len > sizeof(file->buffer)) {
         /* Flush the buffer */
@@ -510,9 +743,26 @@ bool plcrash_async_file_flush (plcrash_async_file_t *file) {
 
 
 /**
- * Close the backing file descriptor.
+ * Close the backing file descriptor. For a PLCRASH_ASYNC_FILE_SINK_GROWABLE sink, any buffer that has not been
+ * claimed via plcrash_async_file_buffer_detach() will be freed.
  */
 bool plcrash_async_file_close (plcrash_async_file_t *file) {
+    switch (file->sink) {
+        case PLCRASH_ASYNC_FILE_SINK_BUFFER:
+            return true;
+
+        case PLCRASH_ASYNC_FILE_SINK_GROWABLE:
+            if (file->mem != NULL)
+                vm_deallocate(mach_task_self(), (vm_address_t) file->mem, file->mem_size);
+            file->mem = NULL;
+            file->mem_size = 0;
+            file->mem_len = 0;
+            return true;
+
+        case PLCRASH_ASYNC_FILE_SINK_FD:
+            break;
+    }
+
     /* Flush any pending data */
     if (!plcrash_async_file_flush(file))
         return false;
@@ -526,6 +776,40 @@ bool plcrash_async_file_close (plcrash_async_file_t *file) {
     return true;
 }
 
+/**
+ * Return the number of bytes written to a memory-backed @a file. Returns 0 for file descriptor sinks.
+ */
+size_t plcrash_async_file_buffer_length (plcrash_async_file_t *file) {
+    return file->mem_len;
+}
+
+/**
+ * Claim ownership of the memory buffer of a PLCRASH_ASYNC_FILE_SINK_GROWABLE @a file. No further data may be written
+ * to @a file, which must still be closed with plcrash_async_file_close().
+ *
+ * @param file The file from which the buffer will be detached.
+ * @param length On return, the number of bytes written to the buffer.
+ * @param allocation_size On return, the size of the buffer's allocation. The caller is responsible for releasing
+ * the buffer with vm_deallocate(), using this size.
+ *
+ * @return Returns the buffer, or NULL if @a file is not a growable memory sink, or its buffer has already
+ * been detached.
+ */
+void *plcrash_async_file_buffer_detach (plcrash_async_file_t *file, size_t *length, size_t *allocation_size) {
+    if (file->sink != PLCRASH_ASYNC_FILE_SINK_GROWABLE || file->mem == NULL)
+        return NULL;
+
+    void *mem = file->mem;
+    *length = file->mem_len;
+    *allocation_size = file->mem_size;
+
+    file->mem = NULL;
+    file->mem_size = 0;
+    file->mem_len = 0;
+
+    return mem;
+}
+
 /**
  * @} plcrash_async_bufio
  */
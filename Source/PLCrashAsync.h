@@ -42,6 +42,8 @@ extern "C" {
 #include <TargetConditionals.h>
 #include <mach/mach.h>
 
+#include "PLCrashAsyncError.h"
+
 #if TARGET_OS_IPHONE
 
 /*
@@ -158,44 +160,6 @@ typedef int64_t pl_vm_off_t;
 #endif /* PLCF_RELEASE_BUILD */
 
 
-/**
- * @ingroup plcrash_async
- * Error return codes.
- */
-typedef enum  {
-    /** Success */
-    PLCRASH_ESUCCESS = 0,
-    
-    /** Unknown error (if found, is a bug) */
-    PLCRASH_EUNKNOWN,
-    
-    /** The output file can not be opened or written to */
-    PLCRASH_OUTPUT_ERR,
-    
-    /** No memory available (allocation failed) */
-    PLCRASH_ENOMEM,
-    
-    /** Unsupported operation */
-    PLCRASH_ENOTSUP,
-    
-    /** Invalid argument */
-    PLCRASH_EINVAL,
-    
-    /** Internal error */
-    PLCRASH_EINTERNAL,
-
-    /** Access to the specified resource is denied. */
-    PLCRASH_EACCESS,
-
-    /** The requested resource could not be found. */
-    PLCRASH_ENOTFOUND,
-    
-    /** The input data is in an unknown or invalid format. */
-    PLCRASH_EINVALID_DATA,
-} plcrash_error_t;
-
-const char *plcrash_async_strerror (plcrash_error_t error);
-
 bool plcrash_async_address_apply_offset (pl_vm_address_t base_address, pl_vm_off_t offset, pl_vm_address_t *result);
     
 thread_t pl_mach_thread_self (void);
@@ -237,7 +201,42 @@ extern const plcrash_async_byteorder_t *plcrash_async_byteorder_little_endian (v
 extern const plcrash_async_byteorder_t *plcrash_async_byteorder_big_endian (void);
 
 
+/**
+ * @internal
+ * @ingroup plcrash_async
+ *
+ * Target memory access counters. These are only maintained if PLCRASH_FEATURE_READ_STATISTICS is enabled.
+ */
+typedef struct plcrash_async_read_stats {
+    /** Number of task read calls issued (eg, vm_read_overwrite) */
+    uint64_t read_count;
+
+    /** Total number of bytes requested via task read calls */
+    uint64_t read_bytes;
+
+    /** Number of memory object mappings created */
+    uint64_t map_count;
+
+    /** Total number of bytes requested via memory object mappings */
+    uint64_t map_bytes;
+
+    /** Number of memory object mappings released */
+    uint64_t unmap_count;
+
+    /** Total number of bytes released via memory object unmappings */
+    uint64_t unmap_bytes;
+} plcrash_async_read_stats_t;
+
+void plcrash_async_read_stats_get (plcrash_async_read_stats_t *stats);
+void plcrash_async_read_stats_reset (void);
+void plcrash_async_read_stats_record_map (pl_vm_size_t length);
+void plcrash_async_read_stats_record_unmap (pl_vm_size_t length);
+
+void plcrash_async_task_retain (task_t task);
+void plcrash_async_task_release (task_t task);
+
 plcrash_error_t plcrash_async_task_memcpy (mach_port_t task, pl_vm_address_t address, pl_vm_off_t offset, void *dest, pl_vm_size_t len);
+plcrash_error_t plcrash_async_task_memcpy_uncached (mach_port_t task, pl_vm_address_t address, pl_vm_off_t offset, void *dest, pl_vm_size_t len);
 
 plcrash_error_t plcrash_async_task_read_uint8 (task_t task, pl_vm_address_t address, pl_vm_off_t offset, uint8_t *result);
 
@@ -257,15 +256,37 @@ void *plcrash_async_memset(void *dest, uint8_t value, size_t n);
 
 ssize_t plcrash_async_writen (int fd, const void *data, size_t len);
 
+/**
+ * @internal
+ * @ingroup plcrash_async_bufio
+ *
+ * Output sink types supported by plcrash_async_file_t.
+ */
+typedef enum {
+    /** Buffered output to a file descriptor. */
+    PLCRASH_ASYNC_FILE_SINK_FD = 0,
+
+    /** Unbuffered output to a fixed-size, caller-provided memory buffer. */
+    PLCRASH_ASYNC_FILE_SINK_BUFFER = 1,
+
+    /** Unbuffered output to a vm_allocate()'d memory buffer that grows as required. */
+    PLCRASH_ASYNC_FILE_SINK_GROWABLE = 2,
+} plcrash_async_file_sink_t;
+
 /**
  * @internal
  * @ingroup plcrash_async_bufio
  *
  * Async-safe buffered file output. This implementation is only intended for use
  * within signal handler execution of crash log output.
+ *
+ * Output may be directed to a file descriptor, or to a memory buffer; see plcrash_async_file_sink_t.
  */
 typedef struct plcrash_async_file {
-    /** Output file descriptor */
+    /** Output sink type */
+    plcrash_async_file_sink_t sink;
+
+    /** Output file descriptor (PLCRASH_ASYNC_FILE_SINK_FD), or -1 */
     int fd;
 
     /** Output limit */
@@ -274,6 +295,15 @@ typedef struct plcrash_async_file {
     /** Total bytes written */
     off_t total_bytes;
 
+    /** Output memory buffer (PLCRASH_ASYNC_FILE_SINK_BUFFER, PLCRASH_ASYNC_FILE_SINK_GROWABLE), or NULL */
+    uint8_t *mem;
+
+    /** Allocated size of @a mem */
+    size_t mem_size;
+
+    /** Number of bytes written to @a mem */
+    size_t mem_len;
+
     /** Current length of data in buffer */
     size_t buflen;
 
@@ -283,9 +313,15 @@ typedef struct plcrash_async_file {
 
 
 void plcrash_async_file_init (plcrash_async_file_t *file, int fd, off_t output_limit);
+void plcrash_async_file_init_buffer (plcrash_async_file_t *file, void *buffer, size_t size);
+plcrash_error_t plcrash_async_file_init_growable (plcrash_async_file_t *file, size_t initial_size, off_t output_limit);
+
 bool plcrash_async_file_write (plcrash_async_file_t *file, const void *data, size_t len);
 bool plcrash_async_file_flush (plcrash_async_file_t *file);
 bool plcrash_async_file_close (plcrash_async_file_t *file);
+
+size_t plcrash_async_file_buffer_length (plcrash_async_file_t *file);
+void *plcrash_async_file_buffer_detach (plcrash_async_file_t *file, size_t *length, size_t *allocation_size);
     
 #ifdef __cplusplus
 }
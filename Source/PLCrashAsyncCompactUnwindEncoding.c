@@ -249,7 +249,7 @@ plcrash_error_t plcrash_async_cfe_reader_find_pc (plcrash_async_cfe_reader_t *re
                 return PLCRASH_EINVAL;
             }
             
-            if (!plcrash_async_mobject_verify_local_pointer(reader->mobj, header, entries_offset, entries_count * sizeof(struct unwind_info_regular_second_level_entry))) {
+            if (!plcrash_async_mobject_verify_local_pointer(reader->mobj, (uintptr_t) header, entries_offset, entries_count * sizeof(struct unwind_info_regular_second_level_entry))) {
                 PLCF_DEBUG("CFE entries table lies outside the mapped CFE range");
                 return PLCRASH_EINVAL;
             }
@@ -292,7 +292,7 @@ plcrash_error_t plcrash_async_cfe_reader_find_pc (plcrash_async_cfe_reader_t *re
                 return PLCRASH_EINVAL;
             }
             
-            if (!plcrash_async_mobject_verify_local_pointer(reader->mobj, header, entries_offset, entries_count * sizeof(uint32_t))) {
+            if (!plcrash_async_mobject_verify_local_pointer(reader->mobj, (uintptr_t) header, entries_offset, entries_count * sizeof(uint32_t))) {
                 PLCF_DEBUG("CFE entries table lies outside the mapped CFE range");
                 return PLCRASH_EINVAL;
             }
@@ -334,7 +334,7 @@ plcrash_error_t plcrash_async_cfe_reader_find_pc (plcrash_async_cfe_reader_t *re
                 return PLCRASH_EINVAL;
             }
 
-            if (!plcrash_async_mobject_verify_local_pointer(reader->mobj, header, encodings_offset, encodings_count * sizeof(uint32_t))) {
+            if (!plcrash_async_mobject_verify_local_pointer(reader->mobj, (uintptr_t) header, encodings_offset, encodings_count * sizeof(uint32_t))) {
                 PLCF_DEBUG("CFE compressed encodings table lies outside the mapped CFE range");
                 return PLCRASH_EINVAL;
             }
@@ -373,6 +373,62 @@ void plcrash_async_cfe_reader_free (plcrash_async_cfe_reader_t *reader) {
 #pragma mark CFE Entry
 
 
+/* Assert that the maximum register count matches the permutation tables below. */
+PLCR_ASSERT_STATIC(expected_max_register_count, PLCRASH_ASYNC_CFE_PERMUTATION_REGISTER_MAX == 6);
+
+/**
+ * @internal
+ * The number of distinct register lists representable by the permutation encoding, indexed by register count. Any
+ * encoded value equal to or greater than the limit for its count is invalid.
+ */
+static const uint16_t cfe_permutation_limit[PLCRASH_ASYNC_CFE_PERMUTATION_REGISTER_MAX+1] = {
+    1, 6, 30, 120, 360, 720, 720
+};
+
+/**
+ * @internal
+ * The positional factors used by the permutation encoding, indexed by register count and list position. See
+ * plcrash_async_cfe_register_encode() for a description of the encoding.
+ *
+ * The value of the last element of a 6-register list is always 0 after renumbering, and is not represented in the
+ * encoding; its factor of 1 will always decode to 0 from the remainder.
+ */
+static const uint16_t cfe_permutation_factors[PLCRASH_ASYNC_CFE_PERMUTATION_REGISTER_MAX+1][PLCRASH_ASYNC_CFE_PERMUTATION_REGISTER_MAX] = {
+    { 0 },
+    { 1 },
+    { 5, 1 },
+    { 20, 4, 1 },
+    { 60, 12, 3, 1 },
+    { 120, 24, 6, 2, 1 },
+    { 120, 24, 6, 2, 1, 1 }
+};
+
+/**
+ * @internal
+ * Maps a set of already-decoded registers and a renumbered position-relative value to the corresponding CFE register
+ * value. The table is indexed by a bitmask of the registers already decoded (bit 0 for register 1, bit 5 for register
+ * 6), and then by the renumbered value; each row lists the registers not yet present in the mask in ascending order,
+ * followed by 0 for unused slots.
+ */
+static const uint8_t cfe_permutation_unused_register[1 << PLCRASH_ASYNC_CFE_PERMUTATION_REGISTER_MAX][PLCRASH_ASYNC_CFE_PERMUTATION_REGISTER_MAX] = {
+    { 1, 2, 3, 4, 5, 6 }, { 2, 3, 4, 5, 6, 0 }, { 1, 3, 4, 5, 6, 0 }, { 3, 4, 5, 6, 0, 0 },
+    { 1, 2, 4, 5, 6, 0 }, { 2, 4, 5, 6, 0, 0 }, { 1, 4, 5, 6, 0, 0 }, { 4, 5, 6, 0, 0, 0 },
+    { 1, 2, 3, 5, 6, 0 }, { 2, 3, 5, 6, 0, 0 }, { 1, 3, 5, 6, 0, 0 }, { 3, 5, 6, 0, 0, 0 },
+    { 1, 2, 5, 6, 0, 0 }, { 2, 5, 6, 0, 0, 0 }, { 1, 5, 6, 0, 0, 0 }, { 5, 6, 0, 0, 0, 0 },
+    { 1, 2, 3, 4, 6, 0 }, { 2, 3, 4, 6, 0, 0 }, { 1, 3, 4, 6, 0, 0 }, { 3, 4, 6, 0, 0, 0 },
+    { 1, 2, 4, 6, 0, 0 }, { 2, 4, 6, 0, 0, 0 }, { 1, 4, 6, 0, 0, 0 }, { 4, 6, 0, 0, 0, 0 },
+    { 1, 2, 3, 6, 0, 0 }, { 2, 3, 6, 0, 0, 0 }, { 1, 3, 6, 0, 0, 0 }, { 3, 6, 0, 0, 0, 0 },
+    { 1, 2, 6, 0, 0, 0 }, { 2, 6, 0, 0, 0, 0 }, { 1, 6, 0, 0, 0, 0 }, { 6, 0, 0, 0, 0, 0 },
+    { 1, 2, 3, 4, 5, 0 }, { 2, 3, 4, 5, 0, 0 }, { 1, 3, 4, 5, 0, 0 }, { 3, 4, 5, 0, 0, 0 },
+    { 1, 2, 4, 5, 0, 0 }, { 2, 4, 5, 0, 0, 0 }, { 1, 4, 5, 0, 0, 0 }, { 4, 5, 0, 0, 0, 0 },
+    { 1, 2, 3, 5, 0, 0 }, { 2, 3, 5, 0, 0, 0 }, { 1, 3, 5, 0, 0, 0 }, { 3, 5, 0, 0, 0, 0 },
+    { 1, 2, 5, 0, 0, 0 }, { 2, 5, 0, 0, 0, 0 }, { 1, 5, 0, 0, 0, 0 }, { 5, 0, 0, 0, 0, 0 },
+    { 1, 2, 3, 4, 0, 0 }, { 2, 3, 4, 0, 0, 0 }, { 1, 3, 4, 0, 0, 0 }, { 3, 4, 0, 0, 0, 0 },
+    { 1, 2, 4, 0, 0, 0 }, { 2, 4, 0, 0, 0, 0 }, { 1, 4, 0, 0, 0, 0 }, { 4, 0, 0, 0, 0, 0 },
+    { 1, 2, 3, 0, 0, 0 }, { 2, 3, 0, 0, 0, 0 }, { 1, 3, 0, 0, 0, 0 }, { 3, 0, 0, 0, 0, 0 },
+    { 1, 2, 0, 0, 0, 0 }, { 2, 0, 0, 0, 0, 0 }, { 1, 0, 0, 0, 0, 0 }, { 0, 0, 0, 0, 0, 0 },
+};
+
 /**
  * @internal
  * Encode a ordered register list using the 10 bit register encoding as defined by the CFE format.
@@ -403,20 +459,7 @@ uint32_t plcrash_async_cfe_register_encode (const uint32_t registers[], uint32_t
      *
      *   1 2 3 4 5 6 ->
      *   0 0 0 0 0 0
-     */
-    uint32_t renumbered[PLCRASH_ASYNC_CFE_PERMUTATION_REGISTER_MAX];
-    for (int i = 0; i < count; ++i) {
-        unsigned countless = 0;
-        for (int j = 0; j < i; ++j)
-            if (registers[j] < registers[i])
-                countless++;
-        
-        renumbered[i] = registers[i] - countless - 1;
-    }
-    
-    uint32_t permutation = 0;
-    
-    /*
+     *
      * Using the renumbered list, we map each element of the list (positionally) into a range large enough to represent
      * the range of any valid element, as well as be subdivided to represent the range of later elements.
      *
@@ -439,44 +482,25 @@ uint32_t plcrash_async_cfe_register_encode (const uint32_t registers[], uint32_t
      *   192 - 215: 3
      *   216 - 239: 4
      *
-     * Note that due to the positional renumbering performed prior to this step, we know that each subsequent position
-     * in the list requires fewer elements; eg, position 0 may include 0-5, position 1 0-4, and position 2 0-3. This
-     * allows us to allocate smaller overall ranges to represent all possible elements.
+     * Note that due to the positional renumbering, we know that each subsequent position in the list requires fewer
+     * elements; eg, position 0 may include 0-5, position 1 0-4, and position 2 0-3. This allows us to allocate smaller
+     * overall ranges to represent all possible elements. The per-count factors are defined in cfe_permutation_factors.
      */
-    
-    /* Assert that the maximum register count matches our switch() statement. */
-    PLCR_ASSERT_STATIC(expected_max_register_count, PLCRASH_ASYNC_CFE_PERMUTATION_REGISTER_MAX == 6);
-    switch (count) {
-        case 1:
-            permutation |= renumbered[0];
-            break;
-            
-        case 2:
-            permutation |= (5*renumbered[0] + renumbered[1]);
-            break;
-            
-        case 3:
-            permutation |= (20*renumbered[0] + 4*renumbered[1] + renumbered[2]);
-            break;
-            
-        case 4:
-            permutation |= (60*renumbered[0] + 12*renumbered[1] + 3*renumbered[2] + renumbered[3]);
-            break;
-            
-        case 5:
-            permutation |= (120*renumbered[0] + 24*renumbered[1] + 6*renumbered[2] + 2*renumbered[3] + renumbered[4]);
-            break;
-            
-        case 6:
-            /*
-             * There are 6 elements in the list, 6 possible values for each element, and values may not repeat. The
-             * value of the last element can be derived from the values previously seen (and due to the positional
-             * renumbering performed above, the value of the last element will *always* be 0.
-             */
-            permutation |= (120*renumbered[0] + 24*renumbered[1] + 6*renumbered[2] + 2*renumbered[3] + renumbered[4]);
-            break;
+    const uint16_t *factors = cfe_permutation_factors[count];
+    uint32_t used = 0;
+    uint32_t permutation = 0;
+
+    for (uint32_t i = 0; i < count; ++i) {
+        PLCF_ASSERT(registers[i] >= 1 && registers[i] <= PLCRASH_ASYNC_CFE_PERMUTATION_REGISTER_MAX);
+
+        /* Renumber relative to the registers that have not yet appeared in the list */
+        uint32_t bit = 1U << (registers[i] - 1);
+        uint32_t renumbered = registers[i] - 1 - __builtin_popcount(used & (bit - 1));
+        used |= bit;
+
+        permutation += factors[i] * renumbered;
     }
-    
+
     PLCF_ASSERT((permutation & 0x3FF) == permutation);
     return permutation;
 }
@@ -491,8 +515,9 @@ uint32_t plcrash_async_cfe_register_encode (const uint32_t registers[], uint32_t
  * register values, <em>not</em> the register values as defined in the PLCrashReporter thread state APIs.
  *
  * @return Returns PLCRASH_ESUCCESS on success, or an appropriate error on failure. This function may fail if @a count
- * exceeds the total number of register values supported by the permutation encoding; this should only occur in the
- * case that the register count supplied from the binary is invalid.
+ * exceeds the total number of register values supported by the permutation encoding, or if @a permutation is not a
+ * valid encoding for @a count registers; this should only occur in the case that the register data supplied from the
+ * binary is invalid.
  *
  * @warning This API is unlikely to be useful outside the CFE encoder implementation, and should not generally be used.
  * Callers must be careful to pass only literal register values defined in the CFE format (eg, values 1-6).
@@ -504,78 +529,31 @@ plcrash_error_t plcrash_async_cfe_register_decode (uint32_t permutation, uint32_
         return PLCRASH_EINVAL;
     }
 
+    /* Validate that every position-relative value will fall within the range supported by its position. An empty
+     * register list ignores the permutation value entirely. */
+    if (count > 0 && permutation >= cfe_permutation_limit[count]) {
+        PLCF_DEBUG("Register permutation 0x%" PRIx32 " is not valid for a count of %" PRIu32, permutation, count);
+        return PLCRASH_EINVAL;
+    }
+
     /*
      * Each register is encoded by mapping the values to a 10-bit range, and then further sub-ranges within that range,
      * with a subrange allocated to each position. See the encoding function for full documentation.
+     *
+     * The position-relative value is extracted using the per-count factors, and then mapped back to the actual
+     * register value using the set of registers that have already been decoded.
      */
-    int permunreg[PLCRASH_ASYNC_CFE_PERMUTATION_REGISTER_MAX];
-#define PERMUTE(pos, factor) do { \
-permunreg[pos] = permutation/factor; \
-permutation -= (permunreg[pos]*factor); \
-} while (0)
+    const uint16_t *factors = cfe_permutation_factors[count];
+    uint32_t used = 0;
+
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t renumbered = permutation / factors[i];
+        permutation -= renumbered * factors[i];
+
+        registers[i] = cfe_permutation_unused_register[used][renumbered];
+        used |= 1U << (registers[i] - 1);
+    }
 
-    /* Assert that the maximum register count matches our switch() statement. */
-    PLCR_ASSERT_STATIC(expected_max_register_count, PLCRASH_ASYNC_CFE_PERMUTATION_REGISTER_MAX == 6);
-	switch (count) {
-		case 6:
-            PERMUTE(0, 120);
-            PERMUTE(1, 24);
-            PERMUTE(2, 6);
-            PERMUTE(3, 2);
-            PERMUTE(4, 1);
-            
-            /*
-             * There are 6 elements in the list, 6 possible values for each element, and values may not repeat. The
-             * value of the last element can be derived from the values previously seen (and due to the positional
-             * renumbering performed, the value of the last element will *always* be 0).
-             */
-            permunreg[5] = 0;
-			break;
-		case 5:
-            PERMUTE(0, 120);
-            PERMUTE(1, 24);
-            PERMUTE(2, 6);
-            PERMUTE(3, 2);
-            PERMUTE(4, 1);
-			break;
-		case 4:
-            PERMUTE(0, 60);
-            PERMUTE(1, 12);
-            PERMUTE(2, 3);
-            PERMUTE(3, 1);
-			break;
-		case 3:
-            PERMUTE(0, 20);
-            PERMUTE(1, 4);
-            PERMUTE(2, 1);
-			break;
-		case 2:
-            PERMUTE(0, 5);
-            PERMUTE(1, 1);
-			break;
-		case 1:
-            PERMUTE(0, 1);
-			break;
-	}
-#undef PERMUTE
-    
-	/* Recompute the actual register values based on the position-relative values. */
-	bool position_used[PLCRASH_ASYNC_CFE_SAVED_REGISTER_MAX+1] = { 0 };
-    
-	for (uint32_t i = 0; i < count; ++i) {
-		int renumbered = 0;
-		for (int u = 1; u < 7; u++) {
-			if (!position_used[u]) {
-				if (renumbered == permunreg[i]) {
-					registers[i] = u;
-					position_used[u] = true;
-					break;
-				}
-				renumbered++;
-			}
-		}
-	}
-    
     return PLCRASH_ESUCCESS;
 }
 
@@ -1022,6 +1000,8 @@ void plcrash_async_cfe_entry_register_list (plcrash_async_cfe_entry_t *entry, pl
  * with the result.
  *
  * @param task The task containing any data referenced by @a thread_state.
+ * @param stack_window A read-ahead window over the target thread's stack, or NULL. If non-NULL, stack data will be
+ * read via the window.
  * @param function_address The task-relative in-memory address of the function containing @a entry. This may be computed
  * by adding the function_base returned by plcrash_async_cfe_reader_find_pc() to the base address of the loaded image.
  * @param thread_state The current thread state corresponding to @a entry.
@@ -1033,6 +1013,7 @@ void plcrash_async_cfe_entry_register_list (plcrash_async_cfe_entry_t *entry, pl
  * @todo This implementation assumes downwards stack growth.
  */
 plcrash_error_t plcrash_async_cfe_entry_apply (task_t task,
+                                               plcrash_async_stack_window_t *stack_window,
                                                pl_vm_address_t function_address,
                                                const plcrash_async_thread_state_t *thread_state,
                                                plcrash_async_cfe_entry_t *entry,
@@ -1088,7 +1069,7 @@ plcrash_error_t plcrash_async_cfe_entry_apply (task_t task,
             plcrash_async_thread_state_set_reg(new_thread_state, PLCRASH_REG_SP, new_sp);
 
             /* Read the saved fp and retaddr */
-            err = plcrash_async_task_memcpy(task, (pl_vm_address_t) fp, 0, dest, greg_size * 2);
+            err = plcrash_async_stack_window_memcpy(stack_window, task, (pl_vm_address_t) fp, 0, dest, greg_size * 2);
             if (err != PLCRASH_ESUCCESS) {
                 PLCF_DEBUG("Failed to read frame data at address 0x%" PRIx64 ": %d", (uint64_t) fp, err);
                 return err;
@@ -1148,7 +1129,7 @@ plcrash_error_t plcrash_async_cfe_entry_apply (task_t task,
                 plcrash_async_thread_state_set_reg(new_thread_state, PLCRASH_REG_SP, retaddr + greg_size);
 
                 /* Read the saved return address */
-                err = plcrash_async_task_memcpy(task, (pl_vm_address_t) retaddr, 0, dest, greg_size);
+                err = plcrash_async_stack_window_memcpy(stack_window, task, (pl_vm_address_t) retaddr, 0, dest, greg_size);
                 if (err != PLCRASH_ESUCCESS) {
                     PLCF_DEBUG("Failed to read return address from 0x%" PRIx64 ": %d", (uint64_t) retaddr, err);
                     return err;
@@ -1195,7 +1176,7 @@ plcrash_error_t plcrash_async_cfe_entry_apply (task_t task,
 
         /* Fetch and save register data */
         plcrash_error_t err;
-        err = plcrash_async_task_memcpy(task, (pl_vm_address_t) saved_reg_addr, i*greg_size, dest, greg_size);
+        err = plcrash_async_stack_window_memcpy(stack_window, task, (pl_vm_address_t) saved_reg_addr, i*greg_size, dest, greg_size);
         if (err != PLCRASH_ESUCCESS) {
             PLCF_DEBUG("Failed to read register data for index %s: %d", plcrash_async_thread_state_get_reg_name(thread_state, register_list[i]), err);
             return err;
@@ -29,6 +29,7 @@
 
 #include "PLCrashAsync.h"
 #include "PLCrashAsyncImageList.h"
+#include "PLCrashAsyncStackWindow.h"
 #include "PLCrashAsyncThread.h"
 
 #include "PLCrashFeatureConfig.h"
@@ -206,6 +207,7 @@ uint32_t plcrash_async_cfe_entry_register_count (plcrash_async_cfe_entry_t *entr
 void plcrash_async_cfe_entry_register_list (plcrash_async_cfe_entry_t *entry, plcrash_regnum_t register_list[]);
 
 plcrash_error_t plcrash_async_cfe_entry_apply (task_t task,
+                                               plcrash_async_stack_window_t *stack_window,
                                                pl_vm_address_t function_address,
                                                const plcrash_async_thread_state_t *thread_state,
                                                plcrash_async_cfe_entry_t *entry,
@@ -67,6 +67,68 @@
 #define PC_REGULAR (BASE_PC+10)
 #define PC_REGULAR_ENCODING (UNWIND_X86_64_MODE_DWARF | PC_REGULAR)
 
+/**
+ * @internal
+ *
+ * Reference implementation of the CFE register permutation encoding, computed directly via positional renumbering
+ * rather than via the lookup tables used by plcrash_async_cfe_register_encode(). Used to exhaustively verify the
+ * table-driven implementation.
+ */
+static uint32_t reference_register_encode (const uint32_t registers[], uint32_t count) {
+    static const uint32_t factors[PLCRASH_ASYNC_CFE_PERMUTATION_REGISTER_MAX+1][PLCRASH_ASYNC_CFE_PERMUTATION_REGISTER_MAX] = {
+        { 0 }, { 1 }, { 5, 1 }, { 20, 4, 1 }, { 60, 12, 3, 1 }, { 120, 24, 6, 2, 1 }, { 120, 24, 6, 2, 1, 0 }
+    };
+
+    uint32_t permutation = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t countless = 0;
+        for (uint32_t j = 0; j < i; j++) {
+            if (registers[j] < registers[i])
+                countless++;
+        }
+
+        permutation += factors[count][i] * (registers[i] - countless - 1);
+    }
+
+    return permutation;
+}
+
+/**
+ * @internal
+ *
+ * Reference implementation of the CFE register permutation decoding; see reference_register_encode().
+ */
+static void reference_register_decode (uint32_t permutation, uint32_t count, uint32_t registers[]) {
+    static const uint32_t factors[PLCRASH_ASYNC_CFE_PERMUTATION_REGISTER_MAX+1][PLCRASH_ASYNC_CFE_PERMUTATION_REGISTER_MAX] = {
+        { 0 }, { 1 }, { 5, 1 }, { 20, 4, 1 }, { 60, 12, 3, 1 }, { 120, 24, 6, 2, 1 }, { 120, 24, 6, 2, 1, 0 }
+    };
+
+    uint32_t permunreg[PLCRASH_ASYNC_CFE_PERMUTATION_REGISTER_MAX] = { 0 };
+    for (uint32_t i = 0; i < count; i++) {
+        if (factors[count][i] == 0)
+            continue;
+
+        permunreg[i] = permutation / factors[count][i];
+        permutation -= permunreg[i] * factors[count][i];
+    }
+
+    bool position_used[PLCRASH_ASYNC_CFE_PERMUTATION_REGISTER_MAX+1] = { 0 };
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t renumbered = 0;
+        for (uint32_t u = 1; u <= PLCRASH_ASYNC_CFE_PERMUTATION_REGISTER_MAX; u++) {
+            if (position_used[u])
+                continue;
+
+            if (renumbered == permunreg[i]) {
+                registers[i] = u;
+                position_used[u] = true;
+                break;
+            }
+            renumbered++;
+        }
+    }
+}
+
 /**
  * @internal
  *
@@ -759,6 +821,85 @@
 #undef PL_EXBIT
 }
 
+/**
+ * Exhaustively verify plcrash_async_cfe_register_encode() and plcrash_async_cfe_register_decode() against the
+ * reference implementation for every ordered list of distinct registers, of every supported length.
+ */
+- (void) testPermutedRegisterEncodingExhaustive {
+    for (uint32_t count = 0; count <= PLCRASH_ASYNC_CFE_PERMUTATION_REGISTER_MAX; count++) {
+        /* Walk all count-length tuples of registers 1-6, skipping those that contain duplicates */
+        uint32_t total = 1;
+        for (uint32_t i = 0; i < count; i++)
+            total *= PLCRASH_ASYNC_CFE_PERMUTATION_REGISTER_MAX;
+
+        uint32_t seen = 0;
+        for (uint32_t n = 0; n < total; n++) {
+            uint32_t registers[PLCRASH_ASYNC_CFE_PERMUTATION_REGISTER_MAX];
+            uint32_t used = 0;
+            bool distinct = true;
+
+            uint32_t v = n;
+            for (uint32_t i = 0; i < count; i++) {
+                registers[i] = (v % PLCRASH_ASYNC_CFE_PERMUTATION_REGISTER_MAX) + 1;
+                v /= PLCRASH_ASYNC_CFE_PERMUTATION_REGISTER_MAX;
+
+                if (used & (1 << registers[i]))
+                    distinct = false;
+                used |= 1 << registers[i];
+            }
+
+            if (!distinct)
+                continue;
+            seen++;
+
+            uint32_t permutation = plcrash_async_cfe_register_encode(registers, count);
+            STAssertEquals(reference_register_encode(registers, count), permutation, @"Encoding does not match the reference implementation for count %" PRIu32, count);
+
+            uint32_t decoded[PLCRASH_ASYNC_CFE_PERMUTATION_REGISTER_MAX];
+            STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_cfe_register_decode(permutation, count, decoded), @"Decode returned an error");
+            for (uint32_t i = 0; i < count; i++)
+                STAssertEquals(registers[i], decoded[i], @"Incorrect register value decoded for position %" PRIu32, i);
+        }
+
+        /* Sanity check the number of permutations we walked: 6!/(6-count)! */
+        uint32_t expected = 1;
+        for (uint32_t i = 0; i < count; i++)
+            expected *= PLCRASH_ASYNC_CFE_PERMUTATION_REGISTER_MAX - i;
+        STAssertEquals(expected, seen, @"Unexpected number of permutations for count %" PRIu32, count);
+    }
+}
+
+/**
+ * Exhaustively verify plcrash_async_cfe_register_decode() against the reference implementation for every possible
+ * 10-bit permutation value, of every supported length. Values that fall outside the valid range for a non-zero count
+ * must be rejected.
+ */
+- (void) testPermutedRegisterDecodeExhaustive {
+    for (uint32_t count = 0; count <= PLCRASH_ASYNC_CFE_PERMUTATION_REGISTER_MAX; count++) {
+        /* The number of valid encodings for count registers: 6!/(6-count)!, excluding the implied last register */
+        uint32_t limit = 1;
+        for (uint32_t i = 0; i < count && i < PLCRASH_ASYNC_CFE_PERMUTATION_REGISTER_MAX - 1; i++)
+            limit *= PLCRASH_ASYNC_CFE_PERMUTATION_REGISTER_MAX - i;
+
+        for (uint32_t permutation = 0; permutation <= 0x3FF; permutation++) {
+            uint32_t decoded[PLCRASH_ASYNC_CFE_PERMUTATION_REGISTER_MAX];
+            plcrash_error_t err = plcrash_async_cfe_register_decode(permutation, count, decoded);
+
+            if (count > 0 && permutation >= limit) {
+                STAssertEquals(PLCRASH_EINVAL, err, @"Decoding of out-of-range permutation 0x%" PRIx32 " did not return an error", permutation);
+                continue;
+            }
+
+            STAssertEquals(PLCRASH_ESUCCESS, err, @"Decode returned an error for permutation 0x%" PRIx32, permutation);
+
+            uint32_t expected[PLCRASH_ASYNC_CFE_PERMUTATION_REGISTER_MAX];
+            reference_register_decode(permutation, count, expected);
+            for (uint32_t i = 0; i < count; i++)
+                STAssertEquals(expected[i], decoded[i], @"Incorrect register value decoded for permutation 0x%" PRIx32 " position %" PRIu32, permutation, i);
+        }
+    }
+}
+
 /**
  * Test reading of a PC, compressed, with a common encoding.
  */
@@ -835,7 +976,7 @@
     
     /* Apply! */
     plcrash_async_thread_state_t nts;
-    plcrash_error_t err = plcrash_async_cfe_entry_apply(mach_task_self(), 0x0, &ts, &entry, &nts);
+    plcrash_error_t err = plcrash_async_cfe_entry_apply(mach_task_self(), NULL, 0x0, &ts, &entry, &nts);
     STAssertEquals(err, PLCRASH_ESUCCESS, @"Failed to apply state to thread");
     
     /* Verify! */
@@ -897,7 +1038,7 @@
 
     /* Apply */
     plcrash_async_thread_state_t nts;
-    plcrash_error_t err = plcrash_async_cfe_entry_apply(mach_task_self(), 0x0, &ts, &entry, &nts);
+    plcrash_error_t err = plcrash_async_cfe_entry_apply(mach_task_self(), NULL, 0x0, &ts, &entry, &nts);
     STAssertEquals(err, PLCRASH_ESUCCESS, @"Failed to apply state to thread");
     
     /* Verify */
@@ -963,7 +1104,7 @@
 
     /* Apply! */
     plcrash_async_thread_state_t nts;
-    plcrash_error_t err = plcrash_async_cfe_entry_apply(mach_task_self(), 0x0, &ts, &entry, &nts);
+    plcrash_error_t err = plcrash_async_cfe_entry_apply(mach_task_self(), NULL, 0x0, &ts, &entry, &nts);
     STAssertEquals(err, PLCRASH_ESUCCESS, @"Failed to apply state to thread");
     
     /* Verify! */
@@ -1025,7 +1166,7 @@
     
     /* Apply! */
     plcrash_async_thread_state_t nts;
-    plcrash_error_t err = plcrash_async_cfe_entry_apply(mach_task_self(), 0x0, &ts, &entry, &nts);
+    plcrash_error_t err = plcrash_async_cfe_entry_apply(mach_task_self(), NULL, 0x0, &ts, &entry, &nts);
     STAssertEquals(err, PLCRASH_ESUCCESS, @"Failed to apply state to thread");
     
     /* Verify! */
@@ -1085,7 +1226,7 @@
 
     /* Apply */
     plcrash_async_thread_state_t nts;
-    plcrash_error_t err = plcrash_async_cfe_entry_apply(mach_task_self(), 0x0, &ts, &entry, &nts);
+    plcrash_error_t err = plcrash_async_cfe_entry_apply(mach_task_self(), NULL, 0x0, &ts, &entry, &nts);
     STAssertEquals(err, PLCRASH_ESUCCESS, @"Failed to apply state to thread");
     
     /* Verify */
@@ -1152,7 +1293,7 @@
     
     /* Apply */
     plcrash_async_thread_state_t nts;
-    plcrash_error_t err = plcrash_async_cfe_entry_apply(mach_task_self(), function_address, &ts, &entry, &nts);
+    plcrash_error_t err = plcrash_async_cfe_entry_apply(mach_task_self(), NULL, function_address, &ts, &entry, &nts);
     STAssertEquals(err, PLCRASH_ESUCCESS, @"Failed to apply state to thread");
     
     /* Verify */
@@ -41,8 +41,101 @@ using namespace plcrash::async;
  */
 
 /**
- * Push a state onto the state stack; all existing values will be saved on the stack, and registers
- * will be set to their default state.
+ * Return the row containing the current state. If the current row has not been modified since it was pushed, this
+ * will be the nearest unmodified saved row.
+ */
+template <typename machine_ptr, typename machine_ptr_s>
+const typename dwarf_cfa_state<machine_ptr, machine_ptr_s>::dwarf_cfa_row_t *dwarf_cfa_state<machine_ptr, machine_ptr_s>::current_row (void) const {
+    uint8_t depth = _table_depth;
+    while (_rows[depth].shared) {
+        PLCF_ASSERT(depth > 0);
+        depth--;
+    }
+
+    return &_rows[depth];
+}
+
+/**
+ * Return the current row for modification, copying the entry indices from the saved row if the current
+ * row is still shared.
+ */
+template <typename machine_ptr, typename machine_ptr_s>
+typename dwarf_cfa_state<machine_ptr, machine_ptr_s>::dwarf_cfa_row_t *dwarf_cfa_state<machine_ptr, machine_ptr_s>::writable_row (void) {
+    dwarf_cfa_row_t *row = &_rows[_table_depth];
+    if (!row->shared)
+        return row;
+
+    const dwarf_cfa_row_t *source = current_row();
+    row->cfa_value = source->cfa_value;
+    row->register_count = source->register_count;
+    plcrash_async_memcpy(row->entries, source->entries, source->register_count);
+    row->shared = false;
+
+    return row;
+}
+
+/**
+ * Search @a row for @a regnum.
+ *
+ * @param row The row to search.
+ * @param regnum The DWARF register number.
+ * @param[out] position The position of the entry within @a row if found, or the position at which an entry for
+ * @a regnum should be inserted.
+ *
+ * @return Returns true if an entry for @a regnum was found, false otherwise.
+ */
+template <typename machine_ptr, typename machine_ptr_s>
+bool dwarf_cfa_state<machine_ptr, machine_ptr_s>::find_entry (const dwarf_cfa_row_t *row, dwarf_cfa_state_regnum_t regnum, uint8_t *position) const {
+    uint8_t low = 0;
+    uint8_t high = row->register_count;
+
+    while (low < high) {
+        uint8_t mid = (low + high) / 2;
+        dwarf_cfa_state_regnum_t mid_regnum = _entries[row->entries[mid]].regnum;
+
+        if (mid_regnum == regnum) {
+            *position = mid;
+            return true;
+        } else if (mid_regnum < regnum) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    *position = low;
+    return false;
+}
+
+/**
+ * Allocate an entry from the free list, returning its index, or DWARF_CFA_STATE_INVALID_ENTRY_IDX if no
+ * entries are available.
+ */
+template <typename machine_ptr, typename machine_ptr_s>
+uint8_t dwarf_cfa_state<machine_ptr, machine_ptr_s>::alloc_entry (void) {
+    uint8_t entry_idx = _free_list;
+    if (entry_idx == DWARF_CFA_STATE_INVALID_ENTRY_IDX)
+        return DWARF_CFA_STATE_INVALID_ENTRY_IDX;
+
+    _free_list = _entries[entry_idx].next;
+    _entries[entry_idx].depth = _table_depth;
+    return entry_idx;
+}
+
+/**
+ * Return an entry to the free list.
+ *
+ * @param entry_idx The index of the entry to be freed.
+ */
+template <typename machine_ptr, typename machine_ptr_s>
+void dwarf_cfa_state<machine_ptr, machine_ptr_s>::free_entry (uint8_t entry_idx) {
+    _entries[entry_idx].next = _free_list;
+    _free_list = entry_idx;
+}
+
+/**
+ * Push a state onto the state stack. The new state initially shares all existing values with the saved
+ * state; the saved state will be preserved when the new state is modified.
  *
  * @return Returns true on success, or false if insufficient space is available on the state
  * stack.
@@ -55,10 +148,7 @@ bool dwarf_cfa_state<machine_ptr, machine_ptr_s>::push_state (void) {
         return false;
     
     _table_depth++;
-    _register_count[_table_depth] = 0;
-    _cfa_value[_table_depth].set_undefined_rule();
-
-    plcrash_async_memset(_table_stack[_table_depth], DWARF_CFA_STATE_INVALID_ENTRY_IDX, sizeof(_table_stack[0]));
+    _rows[_table_depth].shared = true;
     
     return true;
 }
@@ -74,6 +164,15 @@ bool dwarf_cfa_state<machine_ptr, machine_ptr_s>::pop_state (void) {
     if (_table_depth == 0)
         return false;
     
+    /* Release any entries allocated by the discarded state */
+    dwarf_cfa_row_t *row = &_rows[_table_depth];
+    if (!row->shared) {
+        for (uint8_t i = 0; i < row->register_count; i++) {
+            if (_entries[row->entries[i]].depth == _table_depth)
+                free_entry(row->entries[i]);
+        }
+    }
+
     _table_depth--;
     return true;
 }
@@ -84,27 +183,28 @@ bool dwarf_cfa_state<machine_ptr, machine_ptr_s>::pop_state (void) {
 template <typename machine_ptr, typename machine_ptr_s>
 dwarf_cfa_state<machine_ptr, machine_ptr_s>::dwarf_cfa_state (void) {
     /* The size must be smaller than the invalid entry index, which is used as a NULL flag */
-    PLCR_ASSERT_STATIC(max_size, DWARF_CFA_STATE_MAX_REGISTERS < DWARF_CFA_STATE_INVALID_ENTRY_IDX);
+    PLCR_ASSERT_STATIC(max_size, DWARF_CFA_STATE_MAX_ENTRIES < DWARF_CFA_STATE_INVALID_ENTRY_IDX);
+
+    /* A full row must be representable using the entry pool */
+    PLCR_ASSERT_STATIC(max_registers, DWARF_CFA_STATE_MAX_REGISTERS <= DWARF_CFA_STATE_MAX_ENTRIES);
     
     /* Initialize the free list */
-    for (uint8_t i = 0; i < DWARF_CFA_STATE_MAX_REGISTERS; i++)
+    for (uint8_t i = 0; i < DWARF_CFA_STATE_MAX_ENTRIES; i++)
         _entries[i].next = i+1;
     
     /* Set the terminator flag on the last entry */
-    _entries[DWARF_CFA_STATE_MAX_REGISTERS-1].next = DWARF_CFA_STATE_INVALID_ENTRY_IDX;
+    _entries[DWARF_CFA_STATE_MAX_ENTRIES-1].next = DWARF_CFA_STATE_INVALID_ENTRY_IDX;
     
     /* First free entry is _entries[0] */
     _free_list = 0;
     
-    /* Initial register count */
-    _register_count[0] = 0;
-    
     /* Set up the table */
     _table_depth = 0;
-    plcrash_async_memset(_table_stack[0], DWARF_CFA_STATE_INVALID_ENTRY_IDX, sizeof(_table_stack[0]));
+    _rows[0].register_count = 0;
+    _rows[0].shared = false;
     
     /* Default CFA */
-    _cfa_value[0].set_undefined_rule();
+    _rows[0].cfa_value.set_undefined_rule();
 }
 
 /**
@@ -116,53 +216,45 @@ dwarf_cfa_state<machine_ptr, machine_ptr_s>::dwarf_cfa_state (void) {
  */
 template <typename machine_ptr, typename machine_ptr_s>
 bool dwarf_cfa_state<machine_ptr, machine_ptr_s>::set_register (dwarf_cfa_state_regnum_t regnum, plcrash_dwarf_cfa_reg_rule_t rule, machine_ptr value) {
-    /* Check for an existing entry, or find the target entry off which we'll chain our entry */
-    unsigned int bucket = regnum % (sizeof(_table_stack[0]) / sizeof(_table_stack[0][0]));
-    
-    dwarf_cfa_reg_entry_t *parent = NULL;
-    for (uint8_t parent_idx = _table_stack[_table_depth][bucket]; parent_idx != DWARF_CFA_STATE_INVALID_ENTRY_IDX; parent_idx = parent->next) {
-        parent = &_entries[parent_idx];
-        
-        /* If an existing entry is found, we can re-use it directly */
-        if (parent->regnum == regnum) {
-            parent->value = value;
-            parent->rule = rule;
+    dwarf_cfa_row_t *row = writable_row();
+    uint8_t position;
+    uint8_t entry_idx;
+
+    if (find_entry(row, regnum, &position)) {
+        dwarf_cfa_reg_entry_t *entry = &_entries[row->entries[position]];
+
+        /* If the existing entry belongs to this state, we can re-use it directly */
+        if (entry->depth == _table_depth) {
+            entry->value = value;
+            entry->rule = rule;
             return true;
         }
-        
-        /* Otherwise, make sure we terminate with parent == last element */
-        if (parent->next == DWARF_CFA_STATE_INVALID_ENTRY_IDX)
-            break;
-    }
-    
-    /* 'parent' now either points to the end of the list, or is NULL (in which case the table
-     * slot was empty */
-    dwarf_cfa_reg_entry *entry = NULL;
-    uint8_t entry_idx;
-    
-    /* Fetch a free entry */
-    if (_free_list == DWARF_CFA_STATE_INVALID_ENTRY_IDX) {
-        /* No free entries */
-        return false;
+
+        /* Otherwise, the entry is shared with a saved state, and must be replaced with a new entry */
+        if ((entry_idx = alloc_entry()) == DWARF_CFA_STATE_INVALID_ENTRY_IDX)
+            return false;
+    } else {
+        /* Check for available row space */
+        if (row->register_count == DWARF_CFA_STATE_MAX_REGISTERS)
+            return false;
+
+        /* Fetch a free entry */
+        if ((entry_idx = alloc_entry()) == DWARF_CFA_STATE_INVALID_ENTRY_IDX)
+            return false;
+
+        /* Insert at the sorted position */
+        for (uint8_t i = row->register_count; i > position; i--)
+            row->entries[i] = row->entries[i-1];
+        row->register_count++;
     }
-    entry_idx = _free_list;
-    entry = &_entries[entry_idx];
-    _free_list = entry->next;
-    
+
     /* Intialize the entry */
+    dwarf_cfa_reg_entry_t *entry = &_entries[entry_idx];
     entry->regnum = regnum;
     entry->rule = rule;
     entry->value = value;
-    entry->next = DWARF_CFA_STATE_INVALID_ENTRY_IDX;
-    
-    /* Either insert in the parent, or insert as the first table element */
-    if (parent == NULL) {
-        _table_stack[_table_depth][bucket] = entry_idx;
-    } else {
-        parent->next = entry - _entries;
-    }
-    
-    _register_count[_table_depth]++;
+
+    row->entries[position] = entry_idx;
     return true;
 }
 
@@ -176,28 +268,16 @@ bool dwarf_cfa_state<machine_ptr, machine_ptr_s>::set_register (dwarf_cfa_state_
  */
 template <typename machine_ptr, typename machine_ptr_s>
 bool dwarf_cfa_state<machine_ptr, machine_ptr_s>::get_register_rule (dwarf_cfa_state_regnum_t regnum, plcrash_dwarf_cfa_reg_rule_t *rule, machine_ptr *value) {
-    /* Search for the entry */
-    unsigned int bucket = regnum % (sizeof(_table_stack[0]) / sizeof(_table_stack[0][0]));
-    
-    dwarf_cfa_reg_entry_t *entry = NULL;
-    for (uint8_t entry_idx = _table_stack[_table_depth][bucket]; entry_idx != DWARF_CFA_STATE_INVALID_ENTRY_IDX; entry_idx = entry->next) {
-        entry = &_entries[entry_idx];
-        
-        if (entry->regnum != regnum) {
-            if (entry->next == DWARF_CFA_STATE_INVALID_ENTRY_IDX)
-                break;
-            
-            continue;
-        }
-        
-        /* Existing entry found, we can re-use it directly */
-        *value = entry->value;
-        *rule = (plcrash_dwarf_cfa_reg_rule_t) entry->rule;
-        return true;
-    }
-    
-    /* Not found? */
-    return false;
+    const dwarf_cfa_row_t *row = current_row();
+    uint8_t position;
+
+    if (!find_entry(row, regnum, &position))
+        return false;
+
+    const dwarf_cfa_reg_entry_t *entry = &_entries[row->entries[position]];
+    *value = entry->value;
+    *rule = (plcrash_dwarf_cfa_reg_rule_t) entry->rule;
+    return true;
 }
 
 /**
@@ -207,32 +287,23 @@ bool dwarf_cfa_state<machine_ptr, machine_ptr_s>::get_register_rule (dwarf_cfa_s
  */
 template <typename machine_ptr, typename machine_ptr_s>
 void dwarf_cfa_state<machine_ptr, machine_ptr_s>::remove_register (dwarf_cfa_state_regnum_t regnum) {
-    /* Search for the entry */
-    unsigned int bucket = regnum % (sizeof(_table_stack[0]) / sizeof(_table_stack[0][0]));
-    
-    dwarf_cfa_reg_entry *prev = NULL;
-    dwarf_cfa_reg_entry_t *entry = NULL;
-    for (uint8_t entry_idx = _table_stack[_table_depth][bucket]; entry_idx != DWARF_CFA_STATE_INVALID_ENTRY_IDX; entry_idx = entry->next) {
-        prev = entry;
-        entry = &_entries[entry_idx];
-        
-        if (entry->regnum != regnum)
-            continue;
-        
-        /* Remove from the bucket chain */
-        if (prev != NULL) {
-            prev->next = entry->next;
-        } else {
-            _table_stack[_table_depth][bucket] = entry->next;
-        }
-        
-        /* Re-insert in the free list */
-        entry->next = _free_list;
-        _free_list = entry_idx;
-        
-        /* Decrement the register count */
-        _register_count[_table_depth]--;
-    }
+    uint8_t position;
+
+    /* Avoid copying a shared row if there's nothing to remove */
+    if (!find_entry(current_row(), regnum, &position))
+        return;
+
+    dwarf_cfa_row_t *row = writable_row();
+    uint8_t entry_idx = row->entries[position];
+
+    /* Entries shared with a saved state must be preserved */
+    if (_entries[entry_idx].depth == _table_depth)
+        free_entry(entry_idx);
+
+    /* Remove from the row */
+    row->register_count--;
+    for (uint8_t i = position; i < row->register_count; i++)
+        row->entries[i] = row->entries[i+1];
 }
 
 /**
@@ -240,7 +311,7 @@ void dwarf_cfa_state<machine_ptr, machine_ptr_s>::remove_register (dwarf_cfa_sta
  */
 template <typename machine_ptr, typename machine_ptr_s>
 uint8_t dwarf_cfa_state<machine_ptr, machine_ptr_s>::get_register_count (void) {
-    return _register_count[_table_depth];
+    return current_row()->register_count;
 }
 
 
@@ -252,7 +323,7 @@ uint8_t dwarf_cfa_state<machine_ptr, machine_ptr_s>::get_register_count (void) {
  */
 template <typename machine_ptr, typename machine_ptr_s>
 void dwarf_cfa_state<machine_ptr, machine_ptr_s>::set_cfa_register (dwarf_cfa_state_regnum_t regnum, machine_ptr offset) {
-    _cfa_value[_table_depth].set_register_rule(regnum, offset);
+    writable_row()->cfa_value.set_register_rule(regnum, offset);
 }
 
 /**
@@ -263,7 +334,7 @@ void dwarf_cfa_state<machine_ptr, machine_ptr_s>::set_cfa_register (dwarf_cfa_st
  */
 template <typename machine_ptr, typename machine_ptr_s>
 void dwarf_cfa_state<machine_ptr, machine_ptr_s>::set_cfa_register_signed (dwarf_cfa_state_regnum_t regnum, machine_ptr_s offset) {
-    _cfa_value[_table_depth].set_register_rule_signed(regnum, offset);
+    writable_row()->cfa_value.set_register_rule_signed(regnum, offset);
 }
 
 /**
@@ -274,7 +345,7 @@ void dwarf_cfa_state<machine_ptr, machine_ptr_s>::set_cfa_register_signed (dwarf
  */
 template <typename machine_ptr, typename machine_ptr_s>
 void dwarf_cfa_state<machine_ptr, machine_ptr_s>::set_cfa_expression (pl_vm_address_t address, pl_vm_size_t length) {
-    _cfa_value[_table_depth].set_expression_rule(address, length);
+    writable_row()->cfa_value.set_expression_rule(address, length);
 }
 
 /**
@@ -282,7 +353,7 @@ void dwarf_cfa_state<machine_ptr, machine_ptr_s>::set_cfa_expression (pl_vm_addr
  */
 template <typename machine_ptr, typename machine_ptr_s>
 dwarf_cfa_rule<machine_ptr, machine_ptr_s> dwarf_cfa_state<machine_ptr, machine_ptr_s>::get_cfa_rule (void) {
-    return _cfa_value[_table_depth];
+    return current_row()->cfa_value;
 }
 
 /**
@@ -294,12 +365,12 @@ dwarf_cfa_rule<machine_ptr, machine_ptr_s> dwarf_cfa_state<machine_ptr, machine_
 template <typename machine_ptr, typename machine_ptr_s>
 dwarf_cfa_state_iterator<machine_ptr, machine_ptr_s>::dwarf_cfa_state_iterator(dwarf_cfa_state<machine_ptr, machine_ptr_s> *stack) {
     _stack = stack;
-    _bucket_idx = 0;
-    _cur_entry_idx = DWARF_CFA_STATE_INVALID_ENTRY_IDX;
+    _position = 0;
 }
 
 /**
- * Enumerate the next register entry. Returns true on success, or false if no additional entries are available.
+ * Enumerate the next register entry, in ascending register number order. Returns true on success, or false if no
+ * additional entries are available.
  *
  * @param[out] regnum On success, the DWARF register number.
  * @param[out] rule On success, the DWARF CFA rule for @a regnum.
@@ -307,34 +378,13 @@ dwarf_cfa_state_iterator<machine_ptr, machine_ptr_s>::dwarf_cfa_state_iterator(d
  */
 template <typename machine_ptr, typename machine_ptr_s>
 bool dwarf_cfa_state_iterator<machine_ptr, machine_ptr_s>::next (dwarf_cfa_state_regnum_t *regnum, plcrash_dwarf_cfa_reg_rule_t *rule, machine_ptr *value) {
-    /* Fetch the next entry in the bucket chain */
-    if (_cur_entry_idx != DWARF_CFA_STATE_INVALID_ENTRY_IDX) {
-        _cur_entry_idx = _stack->_entries[_cur_entry_idx].next;
-        
-        /* Advance to the next bucket if we've reached the end of the current chain */
-        if (_cur_entry_idx == DWARF_CFA_STATE_INVALID_ENTRY_IDX)
-            _bucket_idx++;
-    }
-    
-    /*
-     * On the first iteration, or after the end of a bucket chain has been reached, find the next valid bucket chain.
-     * Otherwise, we have a valid bucket chain and simply need the next entry.
-     */
-    if (_cur_entry_idx == DWARF_CFA_STATE_INVALID_ENTRY_IDX) {
-        for (; _bucket_idx < DWARF_CFA_STATE_BUCKET_COUNT; _bucket_idx++) {
-            if (_stack->_table_stack[_stack->_table_depth][_bucket_idx] != DWARF_CFA_STATE_INVALID_ENTRY_IDX) {
-                _cur_entry_idx = _stack->_table_stack[_stack->_table_depth][_bucket_idx];
-                break;
-            }
-        }
-        
-        /* If we get here without a valid entry, we've hit the end of all bucket chains. */
-        if (_cur_entry_idx == DWARF_CFA_STATE_INVALID_ENTRY_IDX)
-            return false;
-    }
-    
+    const typename dwarf_cfa_state<machine_ptr, machine_ptr_s>::dwarf_cfa_row_t *row = _stack->current_row();
+    if (_position >= row->register_count)
+        return false;
     
-    typename dwarf_cfa_state<machine_ptr, machine_ptr_s>::dwarf_cfa_reg_entry_t *entry = &_stack->_entries[_cur_entry_idx];
+    const typename dwarf_cfa_state<machine_ptr, machine_ptr_s>::dwarf_cfa_reg_entry_t *entry = &_stack->_entries[row->entries[_position]];
+    _position++;
+
     *regnum = entry->regnum;
     *value = entry->value;
     *rule = (plcrash_dwarf_cfa_reg_rule_t) entry->rule;
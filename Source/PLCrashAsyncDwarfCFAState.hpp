@@ -31,9 +31,11 @@
 #include <stdint.h>
 
 #include "PLCrashAsync.h"
+#include "PLCrashAsyncStackWindow.h"
 #include "PLCrashAsyncDwarfFDE.hpp"
 #include "PLCrashAsyncDwarfCIE.hpp"
 #include "PLCrashAsyncDwarfPrimitives.hpp"
+#include "PLCrashAsyncDwarfExpressionProgram.hpp"
 
 #include "PLCrashFeatureConfig.h"
 #include "PLCrashMacros.h"
@@ -52,8 +54,13 @@ namespace async {
 /* Maximum DWARF register number supported by dwarf_cfa_state and dwarf_cfa_state_regnum_t. */
 #define DWARF_CFA_STATE_REGNUM_MAX UINT32_MAX
 
-/* Consumes around 1.65k (on 32-bit and 64-bit systems). */
-#define DWARF_CFA_STATE_MAX_REGISTERS 100
+/*
+ * Maximum number of register rules in a single CFA table row. This is sized to the largest DWARF register set
+ * used by a supported target: arm64 defines 32 general purpose registers (x0-x30, sp), and the ABI additionally
+ * preserves 8 vector registers (d8-d15). x86-64 defines 17 (including the return address pseudo-register), and
+ * 32-bit ARM and x86 fewer still.
+ */
+#define DWARF_CFA_STATE_MAX_REGISTERS 40
 
 template <typename machine_ptr, typename machine_ptr_s> class dwarf_cfa_state_iterator;
 
@@ -245,8 +252,15 @@ public:
  * For example, ARM allocates or has set aside register values up to 8192, with 8192–16383 reserved for additional
  * vendor co-processor allocations.
  *
- * The actual total number of supported, active registers is much smaller. This class is built to decrease the
- * total amount of fixed stack space to be allocated.
+ * The actual total number of supported, active registers is much smaller. Each row is represented as a small
+ * array of entry indices, sorted by register number, referencing a register entry pool that is shared between
+ * all saved states. Instances are placed on the (potentially small) stack of the crashed thread, and this layout
+ * keeps the instance size at roughly 1.3k on 64-bit systems, and 1k on 32-bit systems.
+ *
+ * Saving a state (DW_CFA_remember_state) is copy-on-write: the new row shares the saved row's contents until
+ * it is first modified, at which point the entry indices (but not the entries themselves) are copied. An entry
+ * is only modified in place if it was allocated by the current row; otherwise, a private copy is allocated, leaving
+ * the saved row intact.
  *
  * @todo If we introduce our own async-safe heap allocator, it may be preferrable to use the heap for entries.
  */
@@ -255,7 +269,7 @@ class dwarf_cfa_state {
 private:
     /* Private configuration defines */
 #define DWARF_CFA_STATE_MAX_STATES 6
-#define DWARF_CFA_STATE_BUCKET_COUNT 14
+#define DWARF_CFA_STATE_MAX_ENTRIES (DWARF_CFA_STATE_MAX_REGISTERS + 16)
 #define DWARF_CFA_STATE_INVALID_ENTRY_IDX UINT8_MAX
 
     /** A single register entry */
@@ -264,36 +278,41 @@ private:
          * Associated rule value. Must be cast to a uint64_t value when evalating PLCRASH_DWARF_CFA_REG_RULE_EXPRESSION and
          * PLCRASH_DWARF_CFA_REG_RULE_VAL_EXPRESSION rules.
          */
-        int64_t value;
+        machine_ptr value;
 
         /** The DWARF register number */
         dwarf_cfa_state_regnum_t regnum;
 
-        /** DWARF register rule */
-        plcrash_dwarf_cfa_reg_rule_t rule;
-        
-        /** Next entry in the list, or NULL */
+        /** DWARF register rule (plcrash_dwarf_cfa_reg_rule_t) */
+        uint8_t rule;
+
+        /** The state depth at which this entry was allocated. Entries allocated at a lower depth are shared with a saved state. */
+        uint8_t depth;
+
+        /** Next entry in the free list, or DWARF_CFA_STATE_INVALID_ENTRY_IDX */
         uint8_t next;
     } dwarf_cfa_reg_entry_t;
-    
-    /** Current call frame value configuration. */
-    dwarf_cfa_rule<machine_ptr,machine_ptr_s> _cfa_value[DWARF_CFA_STATE_MAX_STATES];
-    
-    /** Current number of defined register entries */
-    uint8_t _register_count[DWARF_CFA_STATE_MAX_STATES];
 
-    /**
-     * Active entry lookup table. Maps from regnum to a table index. Most architectures
-     * define <20 valid register numbers.
-     *
-     * This provides a maximum of MAX_STATES saved states (DW_CFA_remember_state), with BUCKET_COUNT register
-     * buckets available in each stack entry. Each bucket may hold multiple register entries; the
-     * maximum number of register entries depends on the configured size of _entries.
-     *
-     * The pre-allocated entry set is shared between each saved state, as to decrease total
-     * memory cost of unused states.
-     */
-    uint8_t _table_stack[DWARF_CFA_STATE_MAX_STATES][DWARF_CFA_STATE_BUCKET_COUNT];
+    /** A single CFA table row */
+    typedef struct dwarf_cfa_row {
+        /** Canonical frame address rule. */
+        dwarf_cfa_rule<machine_ptr,machine_ptr_s> cfa_value;
+
+        /** Number of defined register entries. */
+        uint8_t register_count;
+
+        /**
+         * If true, this row has not been modified since it was pushed, and its contents are those of
+         * the row below it on the state stack.
+         */
+        bool shared;
+
+        /** Indices into the entry pool, sorted by register number. */
+        uint8_t entries[DWARF_CFA_STATE_MAX_REGISTERS];
+    } dwarf_cfa_row_t;
+
+    /** The state stack. The current row is at _table_depth; saved states (DW_CFA_remember_state) are below it. */
+    dwarf_cfa_row_t _rows[DWARF_CFA_STATE_MAX_STATES];
 
     /** Current position in the table stack */
     uint8_t _table_depth;
@@ -303,10 +322,16 @@ private:
 
     /**
      * Statically allocated set of entries; these will be inserted into the free
-     * list upon construction, and then moved into the entry table as registers
+     * list upon construction, and then referenced from the state rows as registers
      * are set.
      */
-    dwarf_cfa_reg_entry_t _entries[DWARF_CFA_STATE_MAX_REGISTERS];
+    dwarf_cfa_reg_entry_t _entries[DWARF_CFA_STATE_MAX_ENTRIES];
+
+    const dwarf_cfa_row_t *current_row (void) const;
+    dwarf_cfa_row_t *writable_row (void);
+    bool find_entry (const dwarf_cfa_row_t *row, dwarf_cfa_state_regnum_t regnum, uint8_t *position) const;
+    uint8_t alloc_entry (void);
+    void free_entry (uint8_t entry_idx);
 
 public:
     dwarf_cfa_state (void);
@@ -322,10 +347,12 @@ public:
                                   pl_vm_size_t length);
     
     plcrash_error_t apply_state (task_t task,
+                                 plcrash_async_stack_window_t *stack_window,
                                  plcrash_async_dwarf_cie_info_t *cie_info,
                                  const plcrash_async_thread_state_t *thread_state,
                                  const plcrash_async_byteorder_t *byteorder,
-                                 plcrash_async_thread_state_t *new_thread_state);
+                                 plcrash_async_thread_state_t *new_thread_state,
+                                 dwarf_expression_cache<machine_ptr, machine_ptr_s> *expr_cache = NULL);
     
     bool set_register (dwarf_cfa_state_regnum_t regnum, plcrash_dwarf_cfa_reg_rule_t rule, machine_ptr value);
     bool get_register_rule (dwarf_cfa_state_regnum_t regnum, plcrash_dwarf_cfa_reg_rule_t *rule, machine_ptr *value);
@@ -353,11 +380,8 @@ public:
 template <typename machine_ptr, typename machine_ptr_s>
 class dwarf_cfa_state_iterator {
 private:
-    /** Current bucket index */
-    uint8_t _bucket_idx;
-    
-    /** Current entry index, or DWARF_CFA_STATE_INVALID_ENTRY_IDX if iteration has not started */
-    uint8_t _cur_entry_idx;
+    /** Position of the next entry within the current row */
+    uint8_t _position;
     
     /** Borrowed reference to the backing DWARF CFA state */
     dwarf_cfa_state<machine_ptr, machine_ptr_s> *_stack;
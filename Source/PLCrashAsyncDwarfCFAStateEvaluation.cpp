@@ -46,9 +46,11 @@ using namespace plcrash::async;
 
 template <typename machine_ptr, typename machine_ptr_s>
 static plcrash_error_t plcrash_async_dwarf_cfa_state_apply_register (task_t task,
+                                                                     plcrash_async_stack_window_t *stack_window,
                                                                      const plcrash_async_thread_state_t *thread_state,
                                                                      const plcrash_async_byteorder_t *byteorder,
                                                                      plcrash_async_thread_state_t *new_thread_state,
+                                                                     dwarf_expression_cache<machine_ptr, machine_ptr_s> *expr_cache,
                                                                      machine_ptr cfa_val,
                                                                      plcrash_regnum_t pl_regnum,
                                                                      plcrash_dwarf_cfa_reg_rule_t dw_rule,
@@ -226,13 +228,18 @@ plcrash_error_t dwarf_cfa_state<machine_ptr, machine_ptr_s>::eval_program (plcra
                 location += dw_expr_read_int(uint32_t) * cie_info->code_alignment_factor;
                 break;
                 
-            case DW_CFA_def_cfa:
-                set_cfa_register(dw_expr_read_uleb128_regnum(), dw_expr_read_uleb128());
+            case DW_CFA_def_cfa: {
+                /* Multi-operand reads are sequenced via locals; function argument evaluation order is unspecified. */
+                dwarf_cfa_state_regnum_t regnum = dw_expr_read_uleb128_regnum();
+                set_cfa_register(regnum, dw_expr_read_uleb128());
                 break;
+            }
                 
-            case DW_CFA_def_cfa_sf:
-                set_cfa_register_signed(dw_expr_read_uleb128_regnum(), dw_expr_read_sleb128() * cie_info->data_alignment_factor);
+            case DW_CFA_def_cfa_sf: {
+                dwarf_cfa_state_regnum_t regnum = dw_expr_read_uleb128_regnum();
+                set_cfa_register_signed(regnum, dw_expr_read_sleb128() * cie_info->data_alignment_factor);
                 break;
+            }
                 
             case DW_CFA_def_cfa_register: {
                 dwarf_cfa_rule<machine_ptr, machine_ptr_s> rule = get_cfa_rule();
@@ -343,25 +350,35 @@ plcrash_error_t dwarf_cfa_state<machine_ptr, machine_ptr_s>::eval_program (plcra
                 dw_expr_set_register(const_operand, PLCRASH_DWARF_CFA_REG_RULE_OFFSET, dw_expr_read_uleb128() * cie_info->data_alignment_factor);
                 break;
                 
-            case DW_CFA_offset_extended:
-                dw_expr_set_register(dw_expr_read_uleb128_regnum(), PLCRASH_DWARF_CFA_REG_RULE_OFFSET, dw_expr_read_uleb128() * cie_info->data_alignment_factor);
+            case DW_CFA_offset_extended: {
+                dwarf_cfa_state_regnum_t regnum = dw_expr_read_uleb128_regnum();
+                dw_expr_set_register(regnum, PLCRASH_DWARF_CFA_REG_RULE_OFFSET, dw_expr_read_uleb128() * cie_info->data_alignment_factor);
                 break;
+            }
                 
-            case DW_CFA_offset_extended_sf:
-                dw_expr_set_register(dw_expr_read_uleb128_regnum(), PLCRASH_DWARF_CFA_REG_RULE_OFFSET, dw_expr_read_sleb128() * cie_info->data_alignment_factor);
+            case DW_CFA_offset_extended_sf: {
+                dwarf_cfa_state_regnum_t regnum = dw_expr_read_uleb128_regnum();
+                dw_expr_set_register(regnum, PLCRASH_DWARF_CFA_REG_RULE_OFFSET, dw_expr_read_sleb128() * cie_info->data_alignment_factor);
                 break;
+            }
                 
-            case DW_CFA_val_offset:
-                dw_expr_set_register(dw_expr_read_uleb128_regnum(), PLCRASH_DWARF_CFA_REG_RULE_VAL_OFFSET, dw_expr_read_uleb128() * cie_info->data_alignment_factor);
+            case DW_CFA_val_offset: {
+                dwarf_cfa_state_regnum_t regnum = dw_expr_read_uleb128_regnum();
+                dw_expr_set_register(regnum, PLCRASH_DWARF_CFA_REG_RULE_VAL_OFFSET, dw_expr_read_uleb128() * cie_info->data_alignment_factor);
                 break;
+            }
                 
-            case DW_CFA_val_offset_sf:
-                dw_expr_set_register(dw_expr_read_uleb128_regnum(), PLCRASH_DWARF_CFA_REG_RULE_VAL_OFFSET, dw_expr_read_sleb128() * cie_info->data_alignment_factor);
+            case DW_CFA_val_offset_sf: {
+                dwarf_cfa_state_regnum_t regnum = dw_expr_read_uleb128_regnum();
+                dw_expr_set_register(regnum, PLCRASH_DWARF_CFA_REG_RULE_VAL_OFFSET, dw_expr_read_sleb128() * cie_info->data_alignment_factor);
                 break;
+            }
                 
-            case DW_CFA_register:
-                dw_expr_set_register(dw_expr_read_uleb128_regnum(), PLCRASH_DWARF_CFA_REG_RULE_REGISTER, dw_expr_read_uleb128());
+            case DW_CFA_register: {
+                dwarf_cfa_state_regnum_t regnum = dw_expr_read_uleb128_regnum();
+                dw_expr_set_register(regnum, PLCRASH_DWARF_CFA_REG_RULE_REGISTER, dw_expr_read_uleb128());
                 break;
+            }
             
             case DW_CFA_expression:
             case DW_CFA_val_expression: {
@@ -462,19 +479,24 @@ plcrash_error_t dwarf_cfa_state<machine_ptr, machine_ptr_s>::eval_program (plcra
  * populate @a new_thread_state with the result.
  *
  * @param task The task containing any data referenced by @a thread_state.
+ * @param stack_window A read-ahead window over the target thread's stack, or NULL.
  * @param cie_info The CIE from which @a cfa_state was derived.
  * @param thread_state The current thread state corresponding to @a entry.
  * @param byteorder The target's byte order.
  * @param new_thread_state The new thread state to be initialized.
+ * @param expr_cache A cache of compiled DWARF expressions to be used when evaluating CFA and register expression rules, or NULL
+ * to evaluate all expressions via plcrash_async_dwarf_expression_eval().
  *
  * @return Returns PLCRASH_ESUCCESS on success, or a standard pclrash_error_t code if an error occurs.
  */
 template <typename machine_ptr, typename machine_ptr_s>
 plcrash_error_t dwarf_cfa_state<machine_ptr, machine_ptr_s>::apply_state (task_t task,
+                                                                          plcrash_async_stack_window_t *stack_window,
                                                                           plcrash_async_dwarf_cie_info_t *cie_info,
                                                                           const plcrash_async_thread_state_t *thread_state,
                                                                           const plcrash_async_byteorder_t *byteorder,
-                                                                          plcrash_async_thread_state_t *new_thread_state)
+                                                                          plcrash_async_thread_state_t *new_thread_state,
+                                                                          dwarf_expression_cache<machine_ptr, machine_ptr_s> *expr_cache)
 {
     plcrash_error_t err;
 
@@ -520,6 +542,14 @@ plcrash_error_t dwarf_cfa_state<machine_ptr, machine_ptr_s>::apply_state (task_t
         }
 
         case DWARF_CFA_STATE_CFA_TYPE_EXPRESSION: {
+            if (expr_cache != NULL) {
+                if ((err = expr_cache->eval(task, thread_state, byteorder, cfa_rule.expression_address(), cfa_rule.expression_length(), NULL, 0, &cfa_val)) != PLCRASH_ESUCCESS) {
+                    PLCF_DEBUG("CFA eval failed");
+                    return err;
+                }
+                break;
+            }
+
             plcrash_async_mobject_t mobj;
             if ((err = plcrash_async_mobject_init(&mobj, task, cfa_rule.expression_address(), cfa_rule.expression_length(), true)) != PLCRASH_ESUCCESS) {
                 PLCF_DEBUG("Could not map CFA expression range");
@@ -562,7 +592,7 @@ plcrash_error_t dwarf_cfa_state<machine_ptr, machine_ptr_s>::apply_state (task_t
         }
         
         /* Apply the register rule */
-        if ((err = plcrash_async_dwarf_cfa_state_apply_register<machine_ptr, machine_ptr_s>(task, thread_state, byteorder, new_thread_state, cfa_val, pl_regnum, dw_rule, dw_value)) != PLCRASH_ESUCCESS)
+        if ((err = plcrash_async_dwarf_cfa_state_apply_register<machine_ptr, machine_ptr_s>(task, stack_window, thread_state, byteorder, new_thread_state, expr_cache, cfa_val, pl_regnum, dw_rule, dw_value)) != PLCRASH_ESUCCESS)
             return err;
         
         /* If the target register is defined as the return address (and is not already the IP), copy the value to the IP.  */
@@ -601,9 +631,11 @@ plcrash_error_t dwarf_cfa_state<machine_ptr, machine_ptr_s>::apply_state (task_t
  * Apply a single register rule to @a new_thread_state.
  *
  * @param task The task containing any data referenced by @a thread_state.
+ * @param stack_window A read-ahead window over the target thread's stack, or NULL.
  * @param thread_state The current thread state corresponding to @a entry.
  * @param byteorder The target's byte order.
  * @param new_thread_state The new thread state to be initialized.
+ * @param expr_cache A cache of compiled DWARF expressions, or NULL.
  * @param cfa_val The base canonical frame address to be used when applying @a dw_rule
  * @param pl_regnum The register to which @a dw_rule and @a dw_value will be applied.
  * @param dw_rule The DWARF register rule to be used to derive the value for @a pl_regnum.
@@ -613,9 +645,11 @@ plcrash_error_t dwarf_cfa_state<machine_ptr, machine_ptr_s>::apply_state (task_t
  */
 template <typename machine_ptr, typename machine_ptr_s>
 static plcrash_error_t plcrash_async_dwarf_cfa_state_apply_register (task_t task,
+                                                                     plcrash_async_stack_window_t *stack_window,
                                                                      const plcrash_async_thread_state_t *thread_state,
                                                                      const plcrash_async_byteorder_t *byteorder,
                                                                      plcrash_async_thread_state_t *new_thread_state,
+                                                                     dwarf_expression_cache<machine_ptr, machine_ptr_s> *expr_cache,
                                                                      machine_ptr cfa_val,
                                                                      plcrash_regnum_t pl_regnum,
                                                                      plcrash_dwarf_cfa_reg_rule_t dw_rule,
@@ -634,7 +668,7 @@ static plcrash_error_t plcrash_async_dwarf_cfa_state_apply_register (task_t task
     /* Apply the rule */
     switch (dw_rule) {
         case PLCRASH_DWARF_CFA_REG_RULE_OFFSET: {
-            if ((err = plcrash_async_task_memcpy(task, cfa_val, (machine_ptr_s)dw_value, vptr, greg_size)) != PLCRASH_ESUCCESS) {
+            if ((err = plcrash_async_stack_window_memcpy(stack_window, task, cfa_val, (machine_ptr_s)dw_value, vptr, greg_size)) != PLCRASH_ESUCCESS) {
                 PLCF_DEBUG("Failed to read offset(N) register value: %d", err);
                 return err;
             }
@@ -686,38 +720,49 @@ static plcrash_error_t plcrash_async_dwarf_cfa_state_apply_register (task_t task
                 return PLCRASH_EINVAL;
             }
             
-            /* Map the expression data  */
-            plcrash_async_mobject_t mobj;
-            if ((err = plcrash_async_mobject_init(&mobj, task, expr_addr, expr_len, true)) != PLCRASH_ESUCCESS) {
-                PLCF_DEBUG("Could not map CFA expression range");
-                return err;
-            }
-            
-            /* Perform the evaluation */
+            /* Perform the evaluation, using the compiled expression cache if available and matching the target word size */
             plcrash_greg_t regval;
-            if (m64) {
-                uint64_t initial_state[] = { cfa_val };
-                if ((err = plcrash_async_dwarf_expression_eval<uint64_t, int64_t>(&mobj, task, thread_state, byteorder, expr_addr, 0, expr_len, initial_state, 1, &rvalue.v64)) != PLCRASH_ESUCCESS) {
-                    plcrash_async_mobject_free(&mobj);
-                    PLCF_DEBUG("CFA eval_64 failed");
+            if (expr_cache != NULL && sizeof(machine_ptr) == greg_size) {
+                machine_ptr initial_state[] = { cfa_val };
+                machine_ptr result;
+                if ((err = expr_cache->eval(task, thread_state, byteorder, expr_addr, expr_len, initial_state, 1, &result)) != PLCRASH_ESUCCESS) {
+                    PLCF_DEBUG("CFA eval failed");
                     return err;
                 }
-                
-                regval = rvalue.v64;
+
+                regval = result;
             } else {
-                uint32_t initial_state[] = { static_cast<uint32_t>(cfa_val) };
-                if ((err = plcrash_async_dwarf_expression_eval<uint32_t, int32_t>(&mobj, task, thread_state, byteorder, expr_addr, 0, expr_len, initial_state, 1, &rvalue.v32)) != PLCRASH_ESUCCESS) {
-                    plcrash_async_mobject_free(&mobj);
-                    PLCF_DEBUG("CFA eval_32 failed");
+                /* Map the expression data  */
+                plcrash_async_mobject_t mobj;
+                if ((err = plcrash_async_mobject_init(&mobj, task, expr_addr, expr_len, true)) != PLCRASH_ESUCCESS) {
+                    PLCF_DEBUG("Could not map CFA expression range");
                     return err;
                 }
-                
-                regval = rvalue.v32;
+
+                if (m64) {
+                    uint64_t initial_state[] = { cfa_val };
+                    if ((err = plcrash_async_dwarf_expression_eval<uint64_t, int64_t>(&mobj, task, thread_state, byteorder, expr_addr, 0, expr_len, initial_state, 1, &rvalue.v64)) != PLCRASH_ESUCCESS) {
+                        plcrash_async_mobject_free(&mobj);
+                        PLCF_DEBUG("CFA eval_64 failed");
+                        return err;
+                    }
+
+                    regval = rvalue.v64;
+                } else {
+                    uint32_t initial_state[] = { static_cast<uint32_t>(cfa_val) };
+                    if ((err = plcrash_async_dwarf_expression_eval<uint32_t, int32_t>(&mobj, task, thread_state, byteorder, expr_addr, 0, expr_len, initial_state, 1, &rvalue.v32)) != PLCRASH_ESUCCESS) {
+                        plcrash_async_mobject_free(&mobj);
+                        PLCF_DEBUG("CFA eval_32 failed");
+                        return err;
+                    }
+
+                    regval = rvalue.v32;
+                }
+
+                /* Clean up the memory mapping */
+                plcrash_async_mobject_free(&mobj);
             }
             
-            /* Clean up the memory mapping */
-            plcrash_async_mobject_free(&mobj);
-            
             /* Dereference the target address, if using the non-value EXPRESSION rule */
             if (dw_rule == PLCRASH_DWARF_CFA_REG_RULE_EXPRESSION) {
                 if ((err = plcrash_async_task_memcpy(task, regval, 0, vptr, greg_size)) != PLCRASH_ESUCCESS) {
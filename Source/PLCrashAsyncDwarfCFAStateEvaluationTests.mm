@@ -382,6 +382,23 @@ using namespace plcrash::async;
     TEST_REGISTER_RESULT(0x4, PLCRASH_DWARF_CFA_REG_RULE_EXPRESSION, (uint64_t)0x20);
 }
 
+/** Test that rules remain in effect following DW_CFA_remember_state */
+- (void) testRememberStatePreservesRules {
+    _stack.set_register(0x4, PLCRASH_DWARF_CFA_REG_RULE_EXPRESSION, 0x20);
+    _stack.set_register(0x5, PLCRASH_DWARF_CFA_REG_RULE_OFFSET, 0x10);
+
+    uint8_t opcodes[] = { DW_CFA_remember_state, DW_CFA_undefined, 0x5 };
+    PERFORM_EVAL_TEST(opcodes, 0x0, PLCRASH_ESUCCESS);
+
+    /* The remembered rule for 0x4 must still apply to the current row */
+    TEST_REGISTER_RESULT(0x4, PLCRASH_DWARF_CFA_REG_RULE_EXPRESSION, (uint64_t)0x20);
+    STAssertEquals((uint8_t)1, _stack.get_register_count(), @"Incorrect number of registers");
+
+    /* Restoring the remembered state restores the rule for 0x5 */
+    STAssertTrue(_stack.pop_state(), @"No new state was pushed");
+    TEST_REGISTER_RESULT(0x5, PLCRASH_DWARF_CFA_REG_RULE_OFFSET, (uint64_t)0x10);
+}
+
 /** Test evaluation of DW_CFA_restore_state */
 - (void) testRestoreState {
     /* Set up an initial state that the opcodes can pop */
@@ -481,7 +498,7 @@ using namespace plcrash::async;
     _cie.return_address_register = dw_regnum;
 
     /* Try to apply the state change */
-    err = cfa_state.apply_state(mach_task_self(), &_cie, &prev_ts, &plcrash_async_byteorder_direct, &new_ts);
+    err = cfa_state.apply_state(mach_task_self(), NULL, &_cie, &prev_ts, &plcrash_async_byteorder_direct, &new_ts);
     STAssertEquals(err, PLCRASH_ESUCCESS, @"Failed to apply CFA state");
     
     /* Verify the result */
@@ -530,7 +547,7 @@ using namespace plcrash::async;
     _cie.return_address_register = dw_invalid_regnum;
     
     /* Try to apply the state change */
-    err = cfa_state.apply_state(mach_task_self(), &_cie, &prev_ts, &plcrash_async_byteorder_direct, &new_ts);
+    err = cfa_state.apply_state(mach_task_self(), NULL, &_cie, &prev_ts, &plcrash_async_byteorder_direct, &new_ts);
     STAssertEquals(err, PLCRASH_ESUCCESS, @"Failed to apply CFA state");
     
     /* Verify the result */
@@ -568,7 +585,7 @@ using namespace plcrash::async;
     _cie.return_address_register = dw_ret_regnum;
     
     /* Try to apply the state change */
-    err = cfa_state.apply_state(mach_task_self(), &_cie, &prev_ts, &plcrash_async_byteorder_direct, &new_ts);
+    err = cfa_state.apply_state(mach_task_self(), NULL, &_cie, &prev_ts, &plcrash_async_byteorder_direct, &new_ts);
     STAssertEquals(err, PLCRASH_ESUCCESS, @"Failed to apply CFA state");
     
     /* Verify the result */    
@@ -605,7 +622,7 @@ using namespace plcrash::async;
     _cie.return_address_register = dw_ret_regnum;
     
     /* Try to apply the state change */
-    err = cfa_state.apply_state(mach_task_self(), &_cie, &prev_ts, &plcrash_async_byteorder_direct, &new_ts);
+    err = cfa_state.apply_state(mach_task_self(), NULL, &_cie, &prev_ts, &plcrash_async_byteorder_direct, &new_ts);
     STAssertEquals(err, PLCRASH_EINVAL, @"Attempt to apply an CFA state with a missing return_address_register did not return EINVAL");
 }
 
@@ -619,7 +636,7 @@ using namespace plcrash::async;
     plcrash_error_t err;
     
     plcrash_async_thread_state_mach_thread_init(&prev_ts, pl_mach_thread_self());
-    err = cfa_state.apply_state(mach_task_self(), &_cie, &prev_ts, &plcrash_async_byteorder_direct, &new_ts);
+    err = cfa_state.apply_state(mach_task_self(), NULL, &_cie, &prev_ts, &plcrash_async_byteorder_direct, &new_ts);
     STAssertEquals(err, PLCRASH_EINVAL, @"Attempt to apply an incomplete CFA state did not return EINVAL");
 }
 
@@ -641,7 +658,7 @@ using namespace plcrash::async;
     cfa_state.set_cfa_register([self findTestDwarfRegister: &prev_ts skip: 0], 10);
 
     /* Try to apply the state change */
-    err = cfa_state.apply_state(mach_task_self(), &_cie, &prev_ts, &plcrash_async_byteorder_direct, &new_ts);
+    err = cfa_state.apply_state(mach_task_self(), NULL, &_cie, &prev_ts, &plcrash_async_byteorder_direct, &new_ts);
     STAssertEquals(err, PLCRASH_ESUCCESS, @"Failed to apply CFA state");
 
     /* Verify the result */
@@ -669,7 +686,7 @@ using namespace plcrash::async;
     cfa_state.set_cfa_register_signed([self findTestDwarfRegister: &prev_ts skip: 0], -10);
     
     /* Try to apply the state change */
-    err = cfa_state.apply_state(mach_task_self(), &_cie, &prev_ts, &plcrash_async_byteorder_direct, &new_ts);
+    err = cfa_state.apply_state(mach_task_self(), NULL, &_cie, &prev_ts, &plcrash_async_byteorder_direct, &new_ts);
     STAssertEquals(err, PLCRASH_ESUCCESS, @"Failed to apply CFA state");
     
     /* Verify the result */
@@ -695,7 +712,7 @@ using namespace plcrash::async;
     cfa_state.set_cfa_expression((pl_vm_address_t)&opcodes, sizeof(opcodes));
     
     /* Try to apply the state change */
-    err = cfa_state.apply_state(mach_task_self(), &_cie, &prev_ts, &plcrash_async_byteorder_direct, &new_ts);
+    err = cfa_state.apply_state(mach_task_self(), NULL, &_cie, &prev_ts, &plcrash_async_byteorder_direct, &new_ts);
     STAssertEquals(err, PLCRASH_ESUCCESS, @"Failed to apply CFA state");
     
     /* Verify the result */
@@ -704,6 +721,37 @@ using namespace plcrash::async;
     STAssertEquals((plcrash_greg_t)15, result, @"Incorrect stack pointer");
 }
 
+/**
+ * Test deriviation of the CFA value from a DWARF expression via a compiled expression cache.
+ */
+- (void) testApplyCFAExpressionCached {
+    plcrash_async_thread_state_t prev_ts;
+    plcrash_async_thread_state_t new_ts;
+    dwarf_cfa_state<uint64_t, int64_t> cfa_state;
+    dwarf_expression_cache<uint64_t, int64_t> expr_cache;
+    plcrash_error_t err;
+    uint8_t opcodes[] = { DW_OP_lit15, DW_OP_plus_uconst, 0x5 };
+
+    /* Populate initial state */
+    plcrash_async_thread_state_mach_thread_init(&prev_ts, pl_mach_thread_self());
+
+    /* Target our sample opcodes */
+    cfa_state.set_cfa_expression((pl_vm_address_t)&opcodes, sizeof(opcodes));
+
+    /* Apply the state change twice; the second application must be served from the cache */
+    for (int i = 0; i < 2; i++) {
+        err = cfa_state.apply_state(mach_task_self(), NULL, &_cie, &prev_ts, &plcrash_async_byteorder_direct, &new_ts, &expr_cache);
+        STAssertEquals(err, PLCRASH_ESUCCESS, @"Failed to apply CFA state");
+
+        STAssertTrue(plcrash_async_thread_state_has_reg(&new_ts, PLCRASH_REG_SP), @"No stack pointer was set");
+        plcrash_greg_t result = plcrash_async_thread_state_get_reg(&new_ts, PLCRASH_REG_SP);
+        STAssertEquals((plcrash_greg_t)20, result, @"Incorrect stack pointer");
+    }
+
+    STAssertEquals(expr_cache.misses(), (uint32_t) 1, @"Expression should have been compiled once");
+    STAssertEquals(expr_cache.hits(), (uint32_t) 1, @"Expression should have been served from the cache");
+}
+
 
 /**
  * Test deriviation of a PLCRASH_DWARF_CFA_REG_RULE_OFFSET register value.
@@ -733,7 +781,7 @@ using namespace plcrash::async;
 
     /* Set the register rule and apply the state change  */
     cfa_state.set_register(dw_regnum, PLCRASH_DWARF_CFA_REG_RULE_OFFSET, -20);
-    err = cfa_state.apply_state(mach_task_self(), &_cie, &prev_ts, &plcrash_async_byteorder_direct, &new_ts);
+    err = cfa_state.apply_state(mach_task_self(), NULL, &_cie, &prev_ts, &plcrash_async_byteorder_direct, &new_ts);
     STAssertEquals(err, PLCRASH_ESUCCESS, @"Failed to apply CFA state");
     
     /* Verify the result */
@@ -766,7 +814,7 @@ using namespace plcrash::async;
     
     /* Set the register rule and apply the state change  */
     cfa_state.set_register(dw_regnum, PLCRASH_DWARF_CFA_REG_RULE_VAL_OFFSET, -20);
-    err = cfa_state.apply_state(mach_task_self(), &_cie, &prev_ts, &plcrash_async_byteorder_direct, &new_ts);
+    err = cfa_state.apply_state(mach_task_self(), NULL, &_cie, &prev_ts, &plcrash_async_byteorder_direct, &new_ts);
     STAssertEquals(err, PLCRASH_ESUCCESS, @"Failed to apply CFA state");
     
     /* Verify the result */
@@ -807,7 +855,7 @@ using namespace plcrash::async;
 
     /* Set the register rule and apply the state change  */
     cfa_state.set_register(dw_regnum, PLCRASH_DWARF_CFA_REG_RULE_REGISTER, dw_regnum_src);
-    err = cfa_state.apply_state(mach_task_self(), &_cie, &prev_ts, &plcrash_async_byteorder_direct, &new_ts);
+    err = cfa_state.apply_state(mach_task_self(), NULL, &_cie, &prev_ts, &plcrash_async_byteorder_direct, &new_ts);
     STAssertEquals(err, PLCRASH_ESUCCESS, @"Failed to apply CFA state");
     
     /* Verify the result */
@@ -857,7 +905,7 @@ using namespace plcrash::async;
 
     /* Set the register rule and apply the state change  */
     cfa_state.set_register(dw_regnum, PLCRASH_DWARF_CFA_REG_RULE_EXPRESSION, (int64_t) opcodes);
-    err = cfa_state.apply_state(mach_task_self(), &_cie, &prev_ts, &plcrash_async_byteorder_direct, &new_ts);
+    err = cfa_state.apply_state(mach_task_self(), NULL, &_cie, &prev_ts, &plcrash_async_byteorder_direct, &new_ts);
     STAssertEquals(err, PLCRASH_ESUCCESS, @"Failed to apply CFA state");
     
     /* Verify the result */
@@ -901,7 +949,7 @@ using namespace plcrash::async;
     
     /* Set the register rule and apply the state change  */
     cfa_state.set_register(dw_regnum, PLCRASH_DWARF_CFA_REG_RULE_VAL_EXPRESSION, (int64_t) opcodes);
-    err = cfa_state.apply_state(mach_task_self(), &_cie, &prev_ts, &plcrash_async_byteorder_direct, &new_ts);
+    err = cfa_state.apply_state(mach_task_self(), NULL, &_cie, &prev_ts, &plcrash_async_byteorder_direct, &new_ts);
     STAssertEquals(err, PLCRASH_ESUCCESS, @"Failed to apply CFA state");
     
     /* Verify the result */
@@ -930,7 +978,7 @@ using namespace plcrash::async;
     
     /* Set the register rule and apply the state change  */
     cfa_state.set_register(dw_regnum, PLCRASH_DWARF_CFA_REG_RULE_SAME_VALUE, 0);
-    err = cfa_state.apply_state(mach_task_self(), &_cie, &prev_ts, &plcrash_async_byteorder_direct, &new_ts);
+    err = cfa_state.apply_state(mach_task_self(), NULL, &_cie, &prev_ts, &plcrash_async_byteorder_direct, &new_ts);
     STAssertEquals(err, PLCRASH_ESUCCESS, @"Failed to apply CFA state");
     
     /* Verify the result */
@@ -169,7 +169,7 @@ using namespace plcrash::async;
         }
     }
 
-    STAssertEquals(stack.get_register_count(), (uint8_t)(100-remove_count), @"Register count was not correctly updated");
+    STAssertEquals(stack.get_register_count(), (uint8_t)(DWARF_CFA_STATE_MAX_REGISTERS-remove_count), @"Register count was not correctly updated");
     
     /* Verify the full set of registers (including verifying that the removed registers were, in fact, removed) */
     for (uint32_t i = 0; i < DWARF_CFA_STATE_MAX_REGISTERS; i++) {
@@ -191,7 +191,7 @@ using namespace plcrash::async;
             STAssertTrue(stack.set_register(i, PLCRASH_DWARF_CFA_REG_RULE_OFFSET, i), @"Failed to add register");
     }
     
-    STAssertEquals(stack.get_register_count(), (uint8_t)100, @"Register count was not correctly updated");
+    STAssertEquals(stack.get_register_count(), (uint8_t)DWARF_CFA_STATE_MAX_REGISTERS, @"Register count was not correctly updated");
     
     /* Ensure that additional requests fail */
     STAssertFalse(stack.set_register(DWARF_CFA_STATE_MAX_REGISTERS+1, PLCRASH_DWARF_CFA_REG_RULE_OFFSET, DWARF_CFA_STATE_MAX_REGISTERS+1), @"A register was somehow allocated from an empty free list");
@@ -227,16 +227,17 @@ using namespace plcrash::async;
 
     stack.set_cfa_register(10, 20);
     
-    /* Try pushing and initializing new state */
+    /* Try pushing and modifying new state; the new state must start as a copy of the saved state */
     STAssertTrue(stack.push_state(), @"Failed to push a new state");
-    STAssertEquals((uint8_t)0, stack.get_register_count(), @"New state should have a register count of 0");
+    STAssertEquals((uint8_t)(DWARF_CFA_STATE_MAX_REGISTERS/4), stack.get_register_count(), @"New state should inherit the saved register count");
+    STAssertEquals(DWARF_CFA_STATE_CFA_TYPE_REGISTER, stack.get_cfa_rule().type(), @"New state should inherit the saved CFA value");
 
     for (int i = 0; i < (DWARF_CFA_STATE_MAX_REGISTERS/4); i++) {
         STAssertTrue(stack.set_register(i, PLCRASH_DWARF_CFA_REG_RULE_OFFSET, i), @"Failed to add register");
-        STAssertEquals((uint8_t)(i+1), stack.get_register_count(), @"Incorrect number of registers");
+        STAssertEquals((uint8_t)(DWARF_CFA_STATE_MAX_REGISTERS/4), stack.get_register_count(), @"Incorrect number of registers");
     }
 
-    STAssertEquals(DWARF_CFA_STATE_CFA_TYPE_UNDEFINED, stack.get_cfa_rule().type(), @"Unexpected initial CFA value");
+    stack.set_cfa_register(11, 30);
     
     /* Pop the state, verify that our original state was saved */
     STAssertTrue(stack.pop_state(), @"Failed to pop current state");
@@ -261,6 +262,80 @@ using namespace plcrash::async;
     STAssertFalse(stack.push_state(), @"Pushing succeeded on a full state stack");
 }
 
+
+/**
+ * Test copy-on-write handling of saved states, including nested and unmodified saved states.
+ */
+- (void) testPushStateCopyOnWrite {
+    dwarf_cfa_state<uint64_t, int64_t> stack;
+    plcrash_dwarf_cfa_reg_rule_t rule;
+    uint64_t value;
+
+    STAssertTrue(stack.set_register(1, PLCRASH_DWARF_CFA_REG_RULE_OFFSET, 10), @"Failed to add register");
+    STAssertTrue(stack.set_register(2, PLCRASH_DWARF_CFA_REG_RULE_OFFSET, 20), @"Failed to add register");
+    stack.set_cfa_register(7, 8);
+
+    /* Push two states without modification; both share the base state */
+    STAssertTrue(stack.push_state(), @"Failed to push a new state");
+    STAssertTrue(stack.push_state(), @"Failed to push a new state");
+    STAssertTrue(stack.get_register_rule(1, &rule, &value), @"Saved register rule was not inherited");
+    STAssertEquals((uint64_t)10, value, @"Incorrect value");
+
+    /* Modify, remove and add registers in the top-most state */
+    STAssertTrue(stack.set_register(1, PLCRASH_DWARF_CFA_REG_RULE_SAME_VALUE, 0), @"Failed to modify register");
+    stack.remove_register(2);
+    STAssertTrue(stack.set_register(3, PLCRASH_DWARF_CFA_REG_RULE_OFFSET, 30), @"Failed to add register");
+    stack.set_cfa_register(7, 16);
+
+    STAssertTrue(stack.get_register_rule(1, &rule, &value), @"Failed to fetch register rule");
+    STAssertEquals(PLCRASH_DWARF_CFA_REG_RULE_SAME_VALUE, rule, @"Incorrect rule");
+    STAssertFalse(stack.get_register_rule(2, &rule, &value), @"Removed register was returned");
+    STAssertEquals((uint8_t)2, stack.get_register_count(), @"Incorrect number of registers");
+
+    /* The unmodified intermediate state must match the base state */
+    STAssertTrue(stack.pop_state(), @"Failed to pop current state");
+    STAssertEquals((uint8_t)2, stack.get_register_count(), @"Incorrect number of registers");
+    STAssertTrue(stack.get_register_rule(1, &rule, &value), @"Failed to fetch register rule");
+    STAssertEquals(PLCRASH_DWARF_CFA_REG_RULE_OFFSET, rule, @"Saved rule was modified");
+    STAssertEquals((uint64_t)10, value, @"Saved value was modified");
+    STAssertTrue(stack.get_register_rule(2, &rule, &value), @"Saved register was removed");
+    STAssertEquals((uint64_t)20, value, @"Saved value was modified");
+    STAssertFalse(stack.get_register_rule(3, &rule, &value), @"Register added to a later state was returned");
+    STAssertEquals((uint64_t)8, stack.get_cfa_rule().register_offset(), @"Saved CFA was modified");
+
+    STAssertTrue(stack.pop_state(), @"Failed to pop current state");
+    STAssertEquals((uint8_t)2, stack.get_register_count(), @"Incorrect number of registers");
+
+    /* Entries allocated by discarded states must be returned to the free list */
+    for (int i = 0; i < DWARF_CFA_STATE_MAX_ENTRIES; i++) {
+        STAssertTrue(stack.push_state(), @"Failed to push a new state");
+        STAssertTrue(stack.set_register(1, PLCRASH_DWARF_CFA_REG_RULE_OFFSET, i), @"Entry was not released by a previous pop");
+        STAssertTrue(stack.set_register(4, PLCRASH_DWARF_CFA_REG_RULE_OFFSET, i), @"Entry was not released by a previous pop");
+        STAssertTrue(stack.pop_state(), @"Failed to pop current state");
+    }
+
+    /* Registers must be enumerated from the current state, in register order */
+    STAssertTrue(stack.push_state(), @"Failed to push a new state");
+    STAssertTrue(stack.set_register(0, PLCRASH_DWARF_CFA_REG_RULE_OFFSET, 0), @"Failed to add register");
+
+    dwarf_cfa_state_iterator<uint64_t, int64_t> iter = dwarf_cfa_state_iterator<uint64_t, int64_t>(&stack);
+    dwarf_cfa_state_regnum_t regnum;
+    for (dwarf_cfa_state_regnum_t expected = 0; expected <= 2; expected++) {
+        STAssertTrue(iter.next(&regnum, &rule, &value), @"Iteration failed while additional registers remain");
+        STAssertEquals(expected, regnum, @"Registers were not enumerated in order");
+    }
+    STAssertFalse(iter.next(&regnum, &rule, &value), @"Iteration returned a register that was not defined");
+}
+
+/**
+ * Verify that the state is small enough to be placed on a signal stack. Each frame unwound via DWARF places up to
+ * two instances on the stack of the crashed thread.
+ */
+- (void) testStateSize {
+    STAssertTrue(sizeof(dwarf_cfa_state<uint64_t, int64_t>) <= 1536, @"dwarf_cfa_state<uint64_t> is %zu bytes", sizeof(dwarf_cfa_state<uint64_t, int64_t>));
+    STAssertTrue(sizeof(dwarf_cfa_state<uint32_t, int32_t>) <= 1536, @"dwarf_cfa_state<uint32_t> is %zu bytes", sizeof(dwarf_cfa_state<uint32_t, int32_t>));
+}
+
 @end
 
 #endif /* PLCRASH_FEATURE_UNWIND_DWARF */
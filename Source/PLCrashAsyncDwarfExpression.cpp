@@ -87,7 +87,7 @@ plcrash_error_t plcrash_async_dwarf_expression_eval (plcrash_async_mobject_t *mo
 {
     // TODO: Review the use of an up-to-800 byte stack allocation; we may want to replace this with
     // use of the new async-safe allocator.
-    dwarf_stack<machine_ptr, 100> stack;
+    dwarf_stack<machine_ptr, DWARF_EXPRESSION_STACK_SIZE> stack;
     dwarf_opstream opstream;
     plcrash_error_t err;
 
@@ -281,9 +281,12 @@ plcrash_error_t plcrash_async_dwarf_expression_eval (plcrash_async_mobject_t *mo
                 dw_expr_push(dw_thread_regval(opcode - DW_OP_breg0) + dw_expr_read_sleb128());
                 break;
                 
-            case DW_OP_bregx:
-                dw_expr_push(dw_thread_regval(dw_expr_read_uleb128()) + dw_expr_read_sleb128());
+            case DW_OP_bregx: {
+                /* Sequence the operand reads; function argument evaluation order is unspecified. */
+                machine_ptr regval = dw_thread_regval(dw_expr_read_uleb128());
+                dw_expr_push(regval + dw_expr_read_sleb128());
                 break;
+            }
                 
             case DW_OP_dup:
                 if (!stack.dup()) {
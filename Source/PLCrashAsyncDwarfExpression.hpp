@@ -561,6 +561,11 @@ typedef enum DW_OP {
     DW_OP_hi_user = 0xff,
 } DW_OP_t;
 
+/**
+ * The maximum depth of the DWARF expression evaluation stack.
+ */
+#define DWARF_EXPRESSION_STACK_SIZE 100
+
 template <typename machine_ptr, typename machine_ptr_s>
 plcrash_error_t plcrash_async_dwarf_expression_eval (plcrash_async_mobject_t *mobj,
                                                      task_t task,
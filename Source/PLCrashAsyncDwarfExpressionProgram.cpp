@@ -0,0 +1,775 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <inttypes.h>
+
+#include "dwarf_stack.hpp"
+#include "dwarf_opstream.hpp"
+
+#include "PLCrashAsyncDwarfExpression.hpp"
+#include "PLCrashAsyncDwarfExpressionProgram.hpp"
+
+#include "PLCrashFeatureConfig.h"
+
+#if PLCRASH_FEATURE_UNWIND_DWARF
+
+using namespace plcrash::async;
+
+/**
+ * @internal
+ * @ingroup plcrash_async_dwarf
+ * @{
+ */
+
+/**
+ * Decode and validate the DWARF expression opcodes at @a address + @a offset, replacing any existing
+ * program.
+ *
+ * Decoding proceeds linearly over the full opcode stream. Opcodes that would fail at evaluation time
+ * without consuming further input (unsupported opcodes, DW_OP_deref_size sizes larger than the machine
+ * word, unmappable DW_OP_bregx register numbers) are compiled to a DWARF_EXPR_INSN_TRAP instruction, preserving
+ * the reference interpreter's behavior of only failing if the opcode is actually reached.
+ *
+ * @param mobj The memory object from which the expression opcodes will be read.
+ * @param byteorder The byte order of the data referenced by @a mobj.
+ * @param address The task-relative address within @a mobj at which the opcodes will be fetched.
+ * @param offset An offset to be applied to @a address.
+ * @param length The total length of the opcodes readable at @a address + @a offset.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success. If an operand extends past the end of the opcode stream,
+ * PLCRASH_EINVAL will be returned. If the expression exceeds DWARF_EXPRESSION_PROGRAM_MAX_INSNS, or branches
+ * to an offset that does not fall on an opcode boundary, PLCRASH_ENOTSUP will be returned. On failure, the
+ * expression must be evaluated via plcrash_async_dwarf_expression_eval().
+ */
+template <typename machine_ptr, typename machine_ptr_s>
+plcrash_error_t dwarf_expression_program<machine_ptr, machine_ptr_s>::compile (plcrash_async_mobject_t *mobj,
+                                                                               const plcrash_async_byteorder_t *byteorder,
+                                                                               pl_vm_address_t address,
+                                                                               pl_vm_off_t offset,
+                                                                               pl_vm_size_t length)
+{
+    /* Opcode stream position of each decoded instruction; used to resolve branch targets. */
+    pl_vm_size_t positions[DWARF_EXPRESSION_PROGRAM_MAX_INSNS];
+    dwarf_opstream opstream;
+    uint32_t count = 0;
+    plcrash_error_t err;
+
+    _count = 0;
+
+    /* Branch targets are recorded as 32-bit stream positions */
+    if (length >= DWARF_EXPR_INSN_TARGET_INVALID) {
+        PLCF_DEBUG("Expression length of %" PRIu64 " exceeds the maximum compiled program size", (uint64_t) length);
+        return PLCRASH_ENOTSUP;
+    }
+
+    /* Configure the opstream */
+    if ((err = opstream.init(mobj, byteorder, address, offset, length)) != PLCRASH_ESUCCESS)
+        return err;
+
+    /* Position-advancing operand read macros; a truncated operand can not be compiled. */
+#define dw_compile_read_int(_type) ({ \
+    _type v; \
+    if (!opstream.read_intU<_type>(&v)) { \
+        PLCF_DEBUG("Read of size %zu exceeds mapped range", sizeof(v)); \
+        return PLCRASH_EINVAL; \
+    } \
+    v; \
+})
+
+#define dw_compile_read_uleb128() ({ \
+    uint64_t v; \
+    if (!opstream.read_uleb128(&v)) { \
+        PLCF_DEBUG("Read of ULEB128 value failed"); \
+        return PLCRASH_EINVAL; \
+    } \
+    (machine_ptr) v; \
+})
+
+#define dw_compile_read_sleb128() ({ \
+    int64_t v; \
+    if (!opstream.read_sleb128(&v)) { \
+        PLCF_DEBUG("Read of SLEB128 value failed"); \
+        return PLCRASH_EINVAL; \
+    } \
+    (machine_ptr_s) v; \
+})
+
+    /* Resolve a DW_OP_skip/DW_OP_bra offset to a stream position; positions outside the stream are marked invalid. */
+#define dw_compile_branch_target(_skip_offset) ({ \
+    pl_vm_off_t target = (pl_vm_off_t) opstream.get_position() + (_skip_offset); \
+    (target < 0 || (pl_vm_size_t) target > length) ? DWARF_EXPR_INSN_TARGET_INVALID : (uint32_t) target; \
+})
+
+    /* Append an instruction, reserving space for the terminating DWARF_EXPR_INSN_END */
+#define dw_compile_emit(_op, _operand, _arg) do { \
+    if (count == DWARF_EXPRESSION_PROGRAM_MAX_INSNS - 1) { \
+        PLCF_DEBUG("Expression exceeds the maximum compiled program size"); \
+        return PLCRASH_ENOTSUP; \
+    } \
+    _insns[count].op = (_op); \
+    _insns[count].operand = (machine_ptr) (_operand); \
+    _insns[count].arg = (_arg); \
+    positions[count] = pos; \
+    count++; \
+} while (0)
+
+    /* The simple stack and arithmetic opcodes map directly to a single operand-free instruction */
+#define dw_compile_simple(_dw_op, _insn_op) case _dw_op: dw_compile_emit(_insn_op, 0, 0); break;
+
+    pl_vm_size_t pos = opstream.get_position();
+    uint8_t opcode;
+    while (opstream.read_intU(&opcode)) {
+        switch (opcode) {
+            case DW_OP_lit0:  case DW_OP_lit1:  case DW_OP_lit2:  case DW_OP_lit3:
+            case DW_OP_lit4:  case DW_OP_lit5:  case DW_OP_lit6:  case DW_OP_lit7:
+            case DW_OP_lit8:  case DW_OP_lit9:  case DW_OP_lit10: case DW_OP_lit11:
+            case DW_OP_lit12: case DW_OP_lit13: case DW_OP_lit14: case DW_OP_lit15:
+            case DW_OP_lit16: case DW_OP_lit17: case DW_OP_lit18: case DW_OP_lit19:
+            case DW_OP_lit20: case DW_OP_lit21: case DW_OP_lit22: case DW_OP_lit23:
+            case DW_OP_lit24: case DW_OP_lit25: case DW_OP_lit26: case DW_OP_lit27:
+            case DW_OP_lit28: case DW_OP_lit29: case DW_OP_lit30: case DW_OP_lit31:
+                dw_compile_emit(DWARF_EXPR_INSN_PUSH, opcode - DW_OP_lit0, 0);
+                break;
+
+            case DW_OP_const1u:
+                dw_compile_emit(DWARF_EXPR_INSN_PUSH, dw_compile_read_int(uint8_t), 0);
+                break;
+
+            case DW_OP_const1s:
+                dw_compile_emit(DWARF_EXPR_INSN_PUSH, dw_compile_read_int(int8_t), 0);
+                break;
+
+            case DW_OP_const2u:
+                dw_compile_emit(DWARF_EXPR_INSN_PUSH, dw_compile_read_int(uint16_t), 0);
+                break;
+
+            case DW_OP_const2s:
+                dw_compile_emit(DWARF_EXPR_INSN_PUSH, (int16_t) dw_compile_read_int(int16_t), 0);
+                break;
+
+            case DW_OP_const4u:
+                dw_compile_emit(DWARF_EXPR_INSN_PUSH, dw_compile_read_int(uint32_t), 0);
+                break;
+
+            case DW_OP_const4s:
+                dw_compile_emit(DWARF_EXPR_INSN_PUSH, (int32_t) dw_compile_read_int(int32_t), 0);
+                break;
+
+            case DW_OP_const8u:
+                dw_compile_emit(DWARF_EXPR_INSN_PUSH, dw_compile_read_int(uint64_t), 0);
+                break;
+
+            case DW_OP_const8s:
+                dw_compile_emit(DWARF_EXPR_INSN_PUSH, (int64_t) dw_compile_read_int(int64_t), 0);
+                break;
+
+            case DW_OP_constu:
+                dw_compile_emit(DWARF_EXPR_INSN_PUSH, dw_compile_read_uleb128(), 0);
+                break;
+
+            case DW_OP_consts:
+                dw_compile_emit(DWARF_EXPR_INSN_PUSH, dw_compile_read_sleb128(), 0);
+                break;
+
+            case DW_OP_breg0:  case DW_OP_breg1:  case DW_OP_breg2:  case DW_OP_breg3:
+            case DW_OP_breg4:  case DW_OP_breg5:  case DW_OP_breg6:  case DW_OP_breg7:
+            case DW_OP_breg8:  case DW_OP_breg9:  case DW_OP_breg10: case DW_OP_breg11:
+            case DW_OP_breg12: case DW_OP_breg13: case DW_OP_breg14: case DW_OP_breg15:
+            case DW_OP_breg16: case DW_OP_breg17: case DW_OP_breg18: case DW_OP_breg19:
+            case DW_OP_breg20: case DW_OP_breg21: case DW_OP_breg22: case DW_OP_breg23:
+            case DW_OP_breg24: case DW_OP_breg25: case DW_OP_breg26: case DW_OP_breg27:
+            case DW_OP_breg28: case DW_OP_breg29: case DW_OP_breg30: case DW_OP_breg31:
+                dw_compile_emit(DWARF_EXPR_INSN_BREG, dw_compile_read_sleb128(), opcode - DW_OP_breg0);
+                break;
+
+            case DW_OP_bregx: {
+                uint64_t regnum = dw_compile_read_uleb128();
+                machine_ptr_s regoff = dw_compile_read_sleb128();
+
+                /* No register number of this size can be mapped; evaluation fails before the offset is applied. */
+                if (regnum > UINT32_MAX) {
+                    dw_compile_emit(DWARF_EXPR_INSN_TRAP, 0, PLCRASH_ENOTSUP);
+                } else {
+                    dw_compile_emit(DWARF_EXPR_INSN_BREG, regoff, (uint32_t) regnum);
+                }
+                break;
+            }
+
+            dw_compile_simple(DW_OP_dup, DWARF_EXPR_INSN_DUP);
+            dw_compile_simple(DW_OP_drop, DWARF_EXPR_INSN_DROP);
+            dw_compile_simple(DW_OP_swap, DWARF_EXPR_INSN_SWAP);
+            dw_compile_simple(DW_OP_rot, DWARF_EXPR_INSN_ROT);
+
+            case DW_OP_pick:
+                dw_compile_emit(DWARF_EXPR_INSN_PICK, 0, dw_compile_read_int(uint8_t));
+                break;
+
+            case DW_OP_over:
+                dw_compile_emit(DWARF_EXPR_INSN_PICK, 0, 1);
+                break;
+
+            dw_compile_simple(DW_OP_xderef, DWARF_EXPR_INSN_XDEREF);
+            dw_compile_simple(DW_OP_deref, DWARF_EXPR_INSN_DEREF);
+
+            case DW_OP_xderef_size:
+            case DW_OP_deref_size: {
+                uint8_t size = dw_compile_read_int(uint8_t);
+
+                /* The reference implementation rejects oversized reads before touching the stack (for DW_OP_xderef_size,
+                 * after a swap that can only fail with the same error). */
+                if (size > sizeof(machine_ptr)) {
+                    dw_compile_emit(DWARF_EXPR_INSN_TRAP, 0, PLCRASH_EINVAL);
+                } else {
+                    dw_compile_emit(opcode == DW_OP_deref_size ? DWARF_EXPR_INSN_DEREF_SIZE : DWARF_EXPR_INSN_XDEREF_SIZE, 0, size);
+                }
+                break;
+            }
+
+            dw_compile_simple(DW_OP_abs, DWARF_EXPR_INSN_ABS);
+            dw_compile_simple(DW_OP_and, DWARF_EXPR_INSN_AND);
+            dw_compile_simple(DW_OP_div, DWARF_EXPR_INSN_DIV);
+            dw_compile_simple(DW_OP_minus, DWARF_EXPR_INSN_MINUS);
+            dw_compile_simple(DW_OP_mod, DWARF_EXPR_INSN_MOD);
+            dw_compile_simple(DW_OP_mul, DWARF_EXPR_INSN_MUL);
+            dw_compile_simple(DW_OP_neg, DWARF_EXPR_INSN_NEG);
+            dw_compile_simple(DW_OP_not, DWARF_EXPR_INSN_NOT);
+            dw_compile_simple(DW_OP_or, DWARF_EXPR_INSN_OR);
+            dw_compile_simple(DW_OP_plus, DWARF_EXPR_INSN_PLUS);
+
+            case DW_OP_plus_uconst:
+                dw_compile_emit(DWARF_EXPR_INSN_PLUS_UCONST, dw_compile_read_uleb128(), 0);
+                break;
+
+            dw_compile_simple(DW_OP_shl, DWARF_EXPR_INSN_SHL);
+            dw_compile_simple(DW_OP_shr, DWARF_EXPR_INSN_SHR);
+            dw_compile_simple(DW_OP_shra, DWARF_EXPR_INSN_SHRA);
+            dw_compile_simple(DW_OP_xor, DWARF_EXPR_INSN_XOR);
+            dw_compile_simple(DW_OP_le, DWARF_EXPR_INSN_LE);
+            dw_compile_simple(DW_OP_ge, DWARF_EXPR_INSN_GE);
+            dw_compile_simple(DW_OP_eq, DWARF_EXPR_INSN_EQ);
+            dw_compile_simple(DW_OP_lt, DWARF_EXPR_INSN_LT);
+            dw_compile_simple(DW_OP_gt, DWARF_EXPR_INSN_GT);
+            dw_compile_simple(DW_OP_ne, DWARF_EXPR_INSN_NE);
+
+            case DW_OP_skip:
+            case DW_OP_bra: {
+                int16_t skipOffset = dw_compile_read_int(int16_t);
+
+                /* The target stream position is resolved to an instruction index once decoding completes */
+                dw_compile_emit(opcode == DW_OP_skip ? DWARF_EXPR_INSN_SKIP : DWARF_EXPR_INSN_BRA, 0, dw_compile_branch_target(skipOffset));
+                break;
+            }
+
+            dw_compile_simple(DW_OP_nop, DWARF_EXPR_INSN_NOP);
+
+            default:
+                /*
+                 * Unsupported opcodes fail evaluation without consuming operands. Decoding continues at the next byte;
+                 * as decoding is a pure function of the starting position, any branch that targets a position found by
+                 * this linear decode will observe the same instruction sequence as the reference implementation.
+                 */
+                dw_compile_emit(DWARF_EXPR_INSN_TRAP, 0, PLCRASH_ENOTSUP);
+                break;
+        }
+
+        pos = opstream.get_position();
+    }
+
+    /* Terminate the program */
+    PLCF_ASSERT(pos == length);
+    _insns[count].op = DWARF_EXPR_INSN_END;
+    _insns[count].operand = 0;
+    _insns[count].arg = 0;
+    positions[count] = pos;
+    count++;
+
+    /* Resolve branch target positions to instruction indices */
+    for (uint32_t i = 0; i < count; i++) {
+        if (_insns[i].op != DWARF_EXPR_INSN_SKIP && _insns[i].op != DWARF_EXPR_INSN_BRA)
+            continue;
+
+        if (_insns[i].arg == DWARF_EXPR_INSN_TARGET_INVALID)
+            continue;
+
+        /* Positions are monotonically increasing; perform a binary search for the target. */
+        uint32_t lo = 0;
+        uint32_t hi = count;
+        while (lo < hi) {
+            uint32_t mid = lo + (hi - lo) / 2;
+            if (positions[mid] < _insns[i].arg)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+
+        if (lo == count || positions[lo] != _insns[i].arg) {
+            PLCF_DEBUG("Branch target 0x%" PRIx32 " does not fall on an opcode boundary", _insns[i].arg);
+            return PLCRASH_ENOTSUP;
+        }
+
+        _insns[i].arg = lo;
+    }
+
+#undef dw_compile_read_int
+#undef dw_compile_read_uleb128
+#undef dw_compile_read_sleb128
+#undef dw_compile_branch_target
+#undef dw_compile_emit
+#undef dw_compile_simple
+
+    _count = count;
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Evaluate the compiled expression. The result, and any error codes, are identical to those that would be
+ * returned by plcrash_async_dwarf_expression_eval() for the source expression.
+ *
+ * @param task The task from which any DWARF expression memory loads will be performed.
+ * @param thread_state The thread state against which the expression will be evaluated.
+ * @param initial_state Initial set of values to be pushed onto the evaluation stack; see plcrash_async_dwarf_expression_eval().
+ * @param initial_count Number of values in the @a initial_state array.
+ * @param[out] result On success, the evaluation result.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, or an appropriate plcrash_error_t values on failure.
+ */
+template <typename machine_ptr, typename machine_ptr_s>
+plcrash_error_t dwarf_expression_program<machine_ptr, machine_ptr_s>::eval (task_t task,
+                                                                            const plcrash_async_thread_state_t *thread_state,
+                                                                            machine_ptr initial_state[],
+                                                                            size_t initial_count,
+                                                                            machine_ptr *result) const
+{
+    dwarf_stack<machine_ptr, DWARF_EXPRESSION_STACK_SIZE> stack;
+    plcrash_error_t err;
+
+    if (_count == 0) {
+        PLCF_DEBUG("Evaluation of an uncompiled expression program");
+        return PLCRASH_EINVAL;
+    }
+
+    /*
+     * Direct-threaded dispatch table, indexed by dwarf_expr_insn_op_t. This relies on the GCC/clang labels-as-values
+     * extension; each handler jumps directly to the next instruction's handler.
+     */
+    static const void *dispatch[] = {
+        &&insn_push, &&insn_breg, &&insn_dup, &&insn_drop, &&insn_pick, &&insn_swap, &&insn_rot,
+        &&insn_xderef, &&insn_deref, &&insn_xderef_size, &&insn_deref_size,
+        &&insn_abs, &&insn_and, &&insn_div, &&insn_minus, &&insn_mod, &&insn_mul, &&insn_neg, &&insn_not,
+        &&insn_or, &&insn_plus, &&insn_plus_uconst, &&insn_shl, &&insn_shr, &&insn_shra, &&insn_xor,
+        &&insn_le, &&insn_ge, &&insn_eq, &&insn_lt, &&insn_gt, &&insn_ne,
+        &&insn_skip, &&insn_bra, &&insn_nop, &&insn_trap, &&insn_end
+    };
+    PLCR_ASSERT_STATIC(DISPATCH_TABLE_SIZE, sizeof(dispatch) / sizeof(dispatch[0]) == DWARF_EXPR_INSN_COUNT);
+
+    /* Push/pop macros that handle reporting of stack overflow/underflow errors */
+#define dw_expr_push(v) if (!stack.push(v)) { \
+    PLCF_DEBUG("Hit stack limit; cannot push further values"); \
+    return PLCRASH_EINTERNAL; \
+}
+
+#define dw_expr_pop(v) if (!stack.pop(v)) { \
+    PLCF_DEBUG("Pop on an empty stack"); \
+    return PLCRASH_EINTERNAL; \
+}
+
+    /* Binary operator handler; v2 is the second stack entry, v1 the top */
+#define dw_expr_binop(_label, _expr) _label: { \
+    machine_ptr v1, v2; \
+    dw_expr_pop(&v1); \
+    dw_expr_pop(&v2); \
+    dw_expr_push(_expr); \
+    dw_expr_next(); \
+}
+
+    /* Advance to and dispatch the next instruction */
+#define dw_expr_next() do { ip++; goto *dispatch[ip->op]; } while (0)
+
+    /* Dispatch to the instruction at index @a _index */
+#define dw_expr_jump(_index) do { ip = &_insns[_index]; goto *dispatch[ip->op]; } while (0)
+
+    /* Populate the initial state */
+    for (size_t i = 0; i < initial_count; i++)
+        dw_expr_push(initial_state[i]);
+
+    const insn_t *ip = &_insns[0];
+    goto *dispatch[ip->op];
+
+insn_push:
+    dw_expr_push(ip->operand);
+    dw_expr_next();
+
+insn_breg: {
+    plcrash_regnum_t rn;
+    if (!plcrash_async_thread_state_map_dwarf_to_reg(thread_state, ip->arg, &rn)) {
+        PLCF_DEBUG("Unsupported DWARF register value of 0x%" PRIx32, ip->arg);
+        return PLCRASH_ENOTSUP;
+    }
+
+    if (!plcrash_async_thread_state_has_reg(thread_state, rn)) {
+        PLCF_DEBUG("Register value of %s unavailable in the current frame.", plcrash_async_thread_state_get_reg_name(thread_state, rn));
+        return PLCRASH_ENOTFOUND;
+    }
+
+    dw_expr_push((machine_ptr) plcrash_async_thread_state_get_reg(thread_state, rn) + ip->operand);
+    dw_expr_next();
+}
+
+insn_dup:
+    if (!stack.dup()) {
+        PLCF_DEBUG("DW_OP_dup on an empty stack");
+        return PLCRASH_EINVAL;
+    }
+    dw_expr_next();
+
+insn_drop:
+    if (!stack.drop()) {
+        PLCF_DEBUG("DW_OP_drop on an empty stack");
+        return PLCRASH_EINVAL;
+    }
+    dw_expr_next();
+
+insn_pick:
+    if (!stack.pick(ip->arg)) {
+        PLCF_DEBUG("DW_OP_pick on invalid index");
+        return PLCRASH_EINVAL;
+    }
+    dw_expr_next();
+
+insn_swap:
+    if (!stack.swap()) {
+        PLCF_DEBUG("DW_OP_swap on stack with < 2 elements");
+        return PLCRASH_EINVAL;
+    }
+    dw_expr_next();
+
+insn_rot:
+    if (!stack.rotate()) {
+        PLCF_DEBUG("DW_OP_rot on stack with < 3 elements");
+        return PLCRASH_EINVAL;
+    }
+    dw_expr_next();
+
+insn_xderef:
+    /* Excise the address space value; see plcrash_async_dwarf_expression_eval() */
+    if (!stack.swap()) {
+        PLCF_DEBUG("DW_OP_xderef on stack with < 2 elements");
+        return PLCRASH_EINVAL;
+    }
+    stack.drop();
+
+    /* Fall through to DW_OP_deref */
+
+insn_deref: {
+    machine_ptr addr;
+    machine_ptr value;
+
+    dw_expr_pop(&addr);
+    if ((err = plcrash_async_task_memcpy(task, addr, 0, &value, sizeof(value))) != PLCRASH_ESUCCESS) {
+        PLCF_DEBUG("DW_OP_deref referenced an invalid target address 0x%" PRIx64, (uint64_t) addr);
+        return err;
+    }
+
+    dw_expr_push(value);
+    dw_expr_next();
+}
+
+insn_xderef_size:
+    /* Excise the address space value; see plcrash_async_dwarf_expression_eval() */
+    if (!stack.swap()) {
+        PLCF_DEBUG("DW_OP_xderef_size on stack with < 2 elements");
+        return PLCRASH_EINVAL;
+    }
+    stack.drop();
+
+    /* Fall through to DW_OP_deref_size */
+
+insn_deref_size: {
+    machine_ptr addr;
+    machine_ptr value = 0;
+
+    dw_expr_pop(&addr);
+
+    #define readval(_type) case sizeof(_type): { \
+        _type r; \
+        if ((err = plcrash_async_task_memcpy(task, (pl_vm_address_t)addr, 0, &r, sizeof(_type))) != PLCRASH_ESUCCESS) { \
+            PLCF_DEBUG("DW_OP_deref_size referenced an invalid target address 0x%" PRIx64, (uint64_t) addr); \
+            return err; \
+        } \
+        value = r; \
+        break; \
+    }
+    switch (ip->arg) {
+        readval(uint8_t);
+        readval(uint16_t);
+        readval(uint32_t);
+        readval(uint64_t);
+
+        default:
+            PLCF_DEBUG("DW_OP_deref_size specified an unsupported size of %" PRIu32, ip->arg);
+            return PLCRASH_EINVAL;
+    }
+    #undef readval
+
+    dw_expr_push(value);
+    dw_expr_next();
+}
+
+insn_abs: {
+    machine_ptr_s v;
+    dw_expr_pop((machine_ptr *)&v);
+    if (v < 0) {
+        dw_expr_push(-v);
+    } else {
+        dw_expr_push(v);
+    }
+    dw_expr_next();
+}
+
+dw_expr_binop(insn_and, v1 & v2);
+
+insn_div: {
+    machine_ptr_s divisor;
+    machine_ptr dividend;
+
+    dw_expr_pop((machine_ptr *) &divisor);
+    dw_expr_pop(&dividend);
+
+    if (divisor == 0) {
+        PLCF_DEBUG("DW_OP_div attempted divide by zero");
+        return PLCRASH_EINVAL;
+    }
+
+    machine_ptr quotient = dividend / divisor;
+    dw_expr_push(quotient);
+    dw_expr_next();
+}
+
+dw_expr_binop(insn_minus, v2 - v1);
+
+insn_mod: {
+    machine_ptr divisor;
+    machine_ptr dividend;
+
+    dw_expr_pop(&divisor);
+    dw_expr_pop(&dividend);
+
+    if (divisor == 0) {
+        PLCF_DEBUG("DW_OP_mod attempted divide by zero");
+        return PLCRASH_EINVAL;
+    }
+
+    machine_ptr remainder = dividend % divisor;
+    dw_expr_push(remainder);
+    dw_expr_next();
+}
+
+dw_expr_binop(insn_mul, v1 * v2);
+
+insn_neg: {
+    machine_ptr_s svalue;
+    dw_expr_pop((machine_ptr *) &svalue);
+    dw_expr_push(0 - svalue);
+    dw_expr_next();
+}
+
+insn_not: {
+    machine_ptr v;
+    dw_expr_pop(&v);
+    dw_expr_push(~v);
+    dw_expr_next();
+}
+
+dw_expr_binop(insn_or, v1 | v2);
+dw_expr_binop(insn_plus, v1 + v2);
+
+insn_plus_uconst: {
+    machine_ptr v;
+    dw_expr_pop(&v);
+    dw_expr_push(ip->operand + v);
+    dw_expr_next();
+}
+
+dw_expr_binop(insn_shl, v2 << v1);
+dw_expr_binop(insn_shr, v2 >> v1);
+
+insn_shra: {
+    machine_ptr shift;
+    machine_ptr_s value;
+
+    dw_expr_pop(&shift);
+    dw_expr_pop((machine_ptr *)&value);
+
+    dw_expr_push(value >> shift);
+    dw_expr_next();
+}
+
+dw_expr_binop(insn_xor, v1 ^ v2);
+dw_expr_binop(insn_le, (v2 <= v1));
+dw_expr_binop(insn_ge, (v2 >= v1));
+dw_expr_binop(insn_eq, (v2 == v1));
+dw_expr_binop(insn_lt, (v2 < v1));
+dw_expr_binop(insn_gt, (v2 > v1));
+dw_expr_binop(insn_ne, (v2 != v1));
+
+insn_skip:
+    if (ip->arg == DWARF_EXPR_INSN_TARGET_INVALID) {
+        PLCF_DEBUG("DW_OP_skip offset falls outside of opcode range");
+        return PLCRASH_EINVAL;
+    }
+    dw_expr_jump(ip->arg);
+
+insn_bra: {
+    machine_ptr cond;
+
+    dw_expr_pop(&cond);
+    if (cond != 0) {
+        if (ip->arg == DWARF_EXPR_INSN_TARGET_INVALID) {
+            PLCF_DEBUG("DW_OP_bra offset falls outside of opcode range");
+            return PLCRASH_EINVAL;
+        }
+        dw_expr_jump(ip->arg);
+    }
+    dw_expr_next();
+}
+
+insn_nop:
+    dw_expr_next();
+
+insn_trap:
+    PLCF_DEBUG("Evaluation reached an invalid or unsupported opcode");
+    return (plcrash_error_t) ip->arg;
+
+insn_end:
+    /* Provide the result */
+    if (!stack.pop(result)) {
+        PLCF_DEBUG("Expression did not provide a result value.");
+        return PLCRASH_EINVAL;
+    }
+
+#undef dw_expr_push
+#undef dw_expr_pop
+#undef dw_expr_binop
+#undef dw_expr_next
+#undef dw_expr_jump
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Construct a new, empty expression cache.
+ */
+template <typename machine_ptr, typename machine_ptr_s>
+dwarf_expression_cache<machine_ptr, machine_ptr_s>::dwarf_expression_cache (void) : _next(0), _hits(0), _misses(0) {
+    for (size_t i = 0; i < DWARF_EXPRESSION_CACHE_SIZE; i++)
+        _entries[i].valid = false;
+}
+
+/**
+ * Evaluate the DWARF expression at @a address, compiling and caching the expression on first use. This may be
+ * used as a drop-in replacement for mapping the expression and evaluating it with plcrash_async_dwarf_expression_eval().
+ *
+ * @param task The task from which the expression opcodes and any DWARF expression memory loads will be read.
+ * @param thread_state The thread state against which the expression will be evaluated.
+ * @param byteorder The byte order of the expression data.
+ * @param address The task-relative address of the expression opcodes.
+ * @param length The total length of the opcodes readable at @a address.
+ * @param initial_state Initial set of values to be pushed onto the evaluation stack; see plcrash_async_dwarf_expression_eval().
+ * @param initial_count Number of values in the @a initial_state array.
+ * @param[out] result On success, the evaluation result.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, or an appropriate plcrash_error_t values on failure.
+ */
+template <typename machine_ptr, typename machine_ptr_s>
+plcrash_error_t dwarf_expression_cache<machine_ptr, machine_ptr_s>::eval (task_t task,
+                                                                          const plcrash_async_thread_state_t *thread_state,
+                                                                          const plcrash_async_byteorder_t *byteorder,
+                                                                          pl_vm_address_t address,
+                                                                          pl_vm_size_t length,
+                                                                          machine_ptr initial_state[],
+                                                                          size_t initial_count,
+                                                                          machine_ptr *result)
+{
+    plcrash_async_mobject_t mobj;
+    plcrash_error_t err;
+    entry_t *entry = NULL;
+
+    /* Look for an existing entry */
+    for (size_t i = 0; i < DWARF_EXPRESSION_CACHE_SIZE; i++) {
+        if (_entries[i].valid && _entries[i].address == address && _entries[i].length == length) {
+            entry = &_entries[i];
+            break;
+        }
+    }
+
+    if (entry != NULL) {
+        _hits++;
+        if (entry->compiled)
+            return entry->program.eval(task, thread_state, initial_state, initial_count, result);
+    }
+
+    /* Map the expression data */
+    if ((err = plcrash_async_mobject_init(&mobj, task, address, length, true)) != PLCRASH_ESUCCESS) {
+        PLCF_DEBUG("Could not map DWARF expression range");
+        return err;
+    }
+
+    /* Compile into the next available entry */
+    if (entry == NULL) {
+        _misses++;
+
+        entry = &_entries[_next];
+        _next = (_next + 1) % DWARF_EXPRESSION_CACHE_SIZE;
+
+        entry->valid = true;
+        entry->address = address;
+        entry->length = length;
+        entry->compiled = (entry->program.compile(&mobj, byteorder, address, 0, length) == PLCRASH_ESUCCESS);
+    }
+
+    /* Evaluate, falling back on the reference implementation if the expression could not be compiled */
+    if (entry->compiled) {
+        err = entry->program.eval(task, thread_state, initial_state, initial_count, result);
+    } else {
+        err = plcrash_async_dwarf_expression_eval<machine_ptr, machine_ptr_s>(&mobj, task, thread_state, byteorder, address, 0, length, initial_state, initial_count, result);
+    }
+
+    plcrash_async_mobject_free(&mobj);
+    return err;
+}
+
+/* Provide explicit 32/64-bit instantiations */
+template class plcrash::async::dwarf_expression_program<uint32_t, int32_t>;
+template class plcrash::async::dwarf_expression_program<uint64_t, int64_t>;
+
+template class plcrash::async::dwarf_expression_cache<uint32_t, int32_t>;
+template class plcrash::async::dwarf_expression_cache<uint64_t, int64_t>;
+
+/**
+ * @}
+ */
+
+#endif /* PLCRASH_FEATURE_UNWIND_DWARF */
@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PLCRASH_ASYNC_DWARF_EXPRESSION_PROGRAM_H
+#define PLCRASH_ASYNC_DWARF_EXPRESSION_PROGRAM_H 1
+
+#include "PLCrashAsync.h"
+#include "PLCrashAsyncMObject.h"
+#include "PLCrashAsyncThread.h"
+
+#include "PLCrashFeatureConfig.h"
+#include "PLCrashMacros.h"
+
+#if PLCRASH_FEATURE_UNWIND_DWARF
+
+PLCR_CPP_BEGIN_NS
+namespace async {
+
+/**
+ * @internal
+ * @ingroup plcrash_async_dwarf
+ * @{
+ */
+
+/**
+ * The maximum number of instructions (including the implicit terminating instruction) that may be
+ * held by a compiled dwarf_expression_program. Expressions that exceed this limit are rejected by
+ * dwarf_expression_program::compile(), and must be evaluated via plcrash_async_dwarf_expression_eval().
+ *
+ * CFI expressions are generally only a handful of opcodes in length.
+ */
+#define DWARF_EXPRESSION_PROGRAM_MAX_INSNS 64
+
+/**
+ * The number of compiled expressions retained by a dwarf_expression_cache.
+ */
+#define DWARF_EXPRESSION_CACHE_SIZE 8
+
+/**
+ * Internal fixed-width instruction opcodes. Each DW_OP opcode (or family of opcodes, such as DW_OP_litN)
+ * maps to a single instruction, with all operands decoded at compile time.
+ */
+typedef enum {
+    /** Push the immediate operand. Used for DW_OP_litN and DW_OP_const*. */
+    DWARF_EXPR_INSN_PUSH = 0,
+
+    /** Push the value of DWARF register arg plus the immediate operand. Used for DW_OP_bregN and DW_OP_bregx. */
+    DWARF_EXPR_INSN_BREG,
+
+    /** DW_OP_dup */
+    DWARF_EXPR_INSN_DUP,
+
+    /** DW_OP_drop */
+    DWARF_EXPR_INSN_DROP,
+
+    /** Copy the stack entry at index arg to the top of the stack. Used for DW_OP_pick and DW_OP_over. */
+    DWARF_EXPR_INSN_PICK,
+
+    /** DW_OP_swap */
+    DWARF_EXPR_INSN_SWAP,
+
+    /** DW_OP_rot */
+    DWARF_EXPR_INSN_ROT,
+
+    /** DW_OP_xderef */
+    DWARF_EXPR_INSN_XDEREF,
+
+    /** DW_OP_deref */
+    DWARF_EXPR_INSN_DEREF,
+
+    /** DW_OP_xderef_size; arg is the read size. */
+    DWARF_EXPR_INSN_XDEREF_SIZE,
+
+    /** DW_OP_deref_size; arg is the read size. */
+    DWARF_EXPR_INSN_DEREF_SIZE,
+
+    /** DW_OP_abs */
+    DWARF_EXPR_INSN_ABS,
+
+    /** DW_OP_and */
+    DWARF_EXPR_INSN_AND,
+
+    /** DW_OP_div */
+    DWARF_EXPR_INSN_DIV,
+
+    /** DW_OP_minus */
+    DWARF_EXPR_INSN_MINUS,
+
+    /** DW_OP_mod */
+    DWARF_EXPR_INSN_MOD,
+
+    /** DW_OP_mul */
+    DWARF_EXPR_INSN_MUL,
+
+    /** DW_OP_neg */
+    DWARF_EXPR_INSN_NEG,
+
+    /** DW_OP_not */
+    DWARF_EXPR_INSN_NOT,
+
+    /** DW_OP_or */
+    DWARF_EXPR_INSN_OR,
+
+    /** DW_OP_plus */
+    DWARF_EXPR_INSN_PLUS,
+
+    /** DW_OP_plus_uconst; the immediate operand is the addend. */
+    DWARF_EXPR_INSN_PLUS_UCONST,
+
+    /** DW_OP_shl */
+    DWARF_EXPR_INSN_SHL,
+
+    /** DW_OP_shr */
+    DWARF_EXPR_INSN_SHR,
+
+    /** DW_OP_shra */
+    DWARF_EXPR_INSN_SHRA,
+
+    /** DW_OP_xor */
+    DWARF_EXPR_INSN_XOR,
+
+    /** DW_OP_le */
+    DWARF_EXPR_INSN_LE,
+
+    /** DW_OP_ge */
+    DWARF_EXPR_INSN_GE,
+
+    /** DW_OP_eq */
+    DWARF_EXPR_INSN_EQ,
+
+    /** DW_OP_lt */
+    DWARF_EXPR_INSN_LT,
+
+    /** DW_OP_gt */
+    DWARF_EXPR_INSN_GT,
+
+    /** DW_OP_ne */
+    DWARF_EXPR_INSN_NE,
+
+    /** DW_OP_skip; arg is the target instruction index. */
+    DWARF_EXPR_INSN_SKIP,
+
+    /** DW_OP_bra; arg is the target instruction index. */
+    DWARF_EXPR_INSN_BRA,
+
+    /** DW_OP_nop */
+    DWARF_EXPR_INSN_NOP,
+
+    /** Terminate evaluation, returning the plcrash_error_t in arg. Used for unsupported opcodes and invalid operands. */
+    DWARF_EXPR_INSN_TRAP,
+
+    /** End of the expression; pop and return the result. */
+    DWARF_EXPR_INSN_END,
+
+    /** The total number of instruction opcodes. */
+    DWARF_EXPR_INSN_COUNT
+} dwarf_expr_insn_op_t;
+
+/** Branch target value used for DW_OP_skip/DW_OP_bra offsets that fall outside of the opcode stream. */
+#define DWARF_EXPR_INSN_TARGET_INVALID UINT32_MAX
+
+/**
+ * A pre-decoded DWARF expression.
+ *
+ * The compiled program is validated once at compile time: all operands are decoded and bounds checked,
+ * and branch offsets are resolved to instruction indices. Evaluation of the compiled program returns
+ * the same result and error codes as plcrash_async_dwarf_expression_eval(), which remains the reference
+ * implementation; expressions that can not be represented exactly (eg, those that branch into the middle
+ * of an instruction) are rejected by compile().
+ */
+template <typename machine_ptr, typename machine_ptr_s> class dwarf_expression_program {
+public:
+    /** A single pre-decoded instruction. */
+    typedef struct insn {
+        /** Decoded immediate operand, if any. */
+        machine_ptr operand;
+
+        /** Instruction-specific argument; a register number, pick index, read size, branch target, or error code. */
+        uint32_t arg;
+
+        /** The instruction opcode (dwarf_expr_insn_op_t). */
+        uint8_t op;
+    } insn_t;
+
+private:
+    /** Compiled instructions. The final instruction is always DWARF_EXPR_INSN_END. */
+    insn_t _insns[DWARF_EXPRESSION_PROGRAM_MAX_INSNS];
+
+    /** Number of valid entries in _insns, including the terminating DWARF_EXPR_INSN_END instruction. */
+    uint32_t _count;
+
+public:
+    dwarf_expression_program (void) : _count(0) {}
+
+    plcrash_error_t compile (plcrash_async_mobject_t *mobj,
+                             const plcrash_async_byteorder_t *byteorder,
+                             pl_vm_address_t address,
+                             pl_vm_off_t offset,
+                             pl_vm_size_t length);
+
+    plcrash_error_t eval (task_t task,
+                          const plcrash_async_thread_state_t *thread_state,
+                          machine_ptr initial_state[],
+                          size_t initial_count,
+                          machine_ptr *result) const;
+
+    /** Return the number of compiled instructions, including the terminating instruction, or 0 if not compiled. */
+    uint32_t insn_count (void) const { return _count; }
+};
+
+/**
+ * A small fixed-size cache of compiled expressions, keyed by the task-relative address of the expression opcodes.
+ *
+ * A cache instance may be shared across unwinding of all frames within a single task, and assumes that all cached
+ * expressions share a common byte order. Expressions that can not be compiled are recorded as such, and
+ * will be evaluated via plcrash_async_dwarf_expression_eval() without further compilation attempts.
+ */
+template <typename machine_ptr, typename machine_ptr_s> class dwarf_expression_cache {
+    /** A single cache entry. */
+    typedef struct entry {
+        /** Task-relative address of the expression opcodes. */
+        pl_vm_address_t address;
+
+        /** Length of the expression opcodes. */
+        pl_vm_size_t length;
+
+        /** True if this entry is populated. */
+        bool valid;
+
+        /** True if @a program was successfully compiled. */
+        bool compiled;
+
+        /** The compiled program, if @a compiled is true. */
+        dwarf_expression_program<machine_ptr, machine_ptr_s> program;
+    } entry_t;
+
+    /** Cache entries */
+    entry_t _entries[DWARF_EXPRESSION_CACHE_SIZE];
+
+    /** Next entry to be replaced on a cache miss. */
+    uint32_t _next;
+
+    /** Number of lookups that found an existing entry. */
+    uint32_t _hits;
+
+    /** Number of lookups that required a compilation attempt. */
+    uint32_t _misses;
+
+public:
+    dwarf_expression_cache (void);
+
+    plcrash_error_t eval (task_t task,
+                          const plcrash_async_thread_state_t *thread_state,
+                          const plcrash_async_byteorder_t *byteorder,
+                          pl_vm_address_t address,
+                          pl_vm_size_t length,
+                          machine_ptr initial_state[],
+                          size_t initial_count,
+                          machine_ptr *result);
+
+    /** Return the number of evaluations that found an existing cache entry. */
+    uint32_t hits (void) const { return _hits; }
+
+    /** Return the number of evaluations that required a compilation attempt. */
+    uint32_t misses (void) const { return _misses; }
+};
+
+/**
+ * @}
+ */
+
+}
+PLCR_CPP_END_NS
+
+#endif /* PLCRASH_FEATURE_UNWIND_DWARF */
+#endif /* PLCRASH_ASYNC_DWARF_EXPRESSION_PROGRAM_H */
@@ -29,6 +29,7 @@
 #import "PLCrashTestCase.h"
 
 #include "PLCrashAsyncDwarfExpression.hpp"
+#include "PLCrashAsyncDwarfExpressionProgram.hpp"
 
 #include "PLCrashFeatureConfig.h"
 
@@ -144,7 +145,8 @@ using namespace plcrash::async;
 
 /* Perform evaluation of the given opcodes, expecting a result of type @a type,
  * with an expected value of @a expected. The data is interpreted as big endian,
- * as to simplify formulating multi-byte test values in the opcode stream */
+ * as to simplify formulating multi-byte test values in the opcode stream. The opcodes
+ * are evaluated by both the reference interpreter and the compiled expression program. */
 #define PERFORM_EVAL_TEST(opcodes, type, expected) do { \
     plcrash_async_mobject_t mobj; \
     plcrash_error_t err; \
@@ -155,11 +157,25 @@ using namespace plcrash::async;
         err = plcrash_async_dwarf_expression_eval<uint64_t, int64_t>(&mobj, mach_task_self(), &_ts, plcrash_async_byteorder_big_endian(), (pl_vm_address_t) &opcodes, 0, sizeof(opcodes), NULL, 0, &result); \
         STAssertEquals(err, PLCRASH_ESUCCESS, @"64-bit evaluation failed"); \
         STAssertEquals((type)result, (type)expected, @"Incorrect 64-bit result"); \
+\
+        dwarf_expression_program<uint64_t, int64_t> program; \
+        err = program.compile(&mobj, plcrash_async_byteorder_big_endian(), (pl_vm_address_t) &opcodes, 0, sizeof(opcodes)); \
+        STAssertEquals(err, PLCRASH_ESUCCESS, @"64-bit compilation failed"); \
+        err = program.eval(mach_task_self(), &_ts, NULL, 0, &result); \
+        STAssertEquals(err, PLCRASH_ESUCCESS, @"64-bit compiled evaluation failed"); \
+        STAssertEquals((type)result, (type)expected, @"Incorrect 64-bit compiled result"); \
     } else { \
         uint32_t result; \
         err = plcrash_async_dwarf_expression_eval<uint32_t, int32_t>(&mobj, mach_task_self(), &_ts, plcrash_async_byteorder_big_endian(), (pl_vm_address_t) &opcodes, 0, sizeof(opcodes), NULL, 0, &result); \
         STAssertEquals(err, PLCRASH_ESUCCESS, @"32-bit evaluation failed"); \
         STAssertEquals((type)result, (type)expected, @"Incorrect 32-bit result"); \
+\
+        dwarf_expression_program<uint32_t, int32_t> program; \
+        err = program.compile(&mobj, plcrash_async_byteorder_big_endian(), (pl_vm_address_t) &opcodes, 0, sizeof(opcodes)); \
+        STAssertEquals(err, PLCRASH_ESUCCESS, @"32-bit compilation failed"); \
+        err = program.eval(mach_task_self(), &_ts, NULL, 0, &result); \
+        STAssertEquals(err, PLCRASH_ESUCCESS, @"32-bit compiled evaluation failed"); \
+        STAssertEquals((type)result, (type)expected, @"Incorrect 32-bit compiled result"); \
     } \
 \
     plcrash_async_mobject_free(&mobj); \
@@ -176,10 +192,22 @@ using namespace plcrash::async;
         uint64_t result; \
         err = plcrash_async_dwarf_expression_eval<uint64_t, int64_t>(&mobj, mach_task_self(), &_ts, plcrash_async_byteorder_big_endian(), (pl_vm_address_t) &opcodes, 0, sizeof(opcodes), NULL, 0, &result); \
         STAssertEquals(err, errval, @"64-bit evaluation did not return expected error code"); \
+\
+        dwarf_expression_program<uint64_t, int64_t> program; \
+        err = program.compile(&mobj, plcrash_async_byteorder_big_endian(), (pl_vm_address_t) &opcodes, 0, sizeof(opcodes)); \
+        STAssertEquals(err, PLCRASH_ESUCCESS, @"64-bit compilation failed"); \
+        err = program.eval(mach_task_self(), &_ts, NULL, 0, &result); \
+        STAssertEquals(err, errval, @"64-bit compiled evaluation did not return expected error code"); \
     } else { \
         uint32_t result; \
         err = plcrash_async_dwarf_expression_eval<uint32_t, int32_t>(&mobj, mach_task_self(), &_ts, plcrash_async_byteorder_big_endian(), (pl_vm_address_t) &opcodes, 0, sizeof(opcodes), NULL, 0, &result); \
         STAssertEquals(err, errval, @"32-bit evaluation did not return expected error code"); \
+\
+        dwarf_expression_program<uint32_t, int32_t> program; \
+        err = program.compile(&mobj, plcrash_async_byteorder_big_endian(), (pl_vm_address_t) &opcodes, 0, sizeof(opcodes)); \
+        STAssertEquals(err, PLCRASH_ESUCCESS, @"32-bit compilation failed"); \
+        err = program.eval(mach_task_self(), &_ts, NULL, 0, &result); \
+        STAssertEquals(err, errval, @"32-bit compiled evaluation did not return expected error code"); \
     } \
     \
     plcrash_async_mobject_free(&mobj); \
@@ -820,6 +848,209 @@ using namespace plcrash::async;
 }
 
 
+/* Differential test helpers; a fixed-seed xorshift generator keeps failures reproducible. */
+static uint32_t diff_random (uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return (uint32_t) *state;
+}
+
+static void diff_append (uint8_t *opcodes, size_t *len, uint64_t value, size_t size) {
+    for (size_t i = size; i > 0; i--)
+        opcodes[(*len)++] = (value >> (8 * (i - 1))) & 0xFF;
+}
+
+/**
+ * Generate a random, terminating opcode stream of at most 160 bytes. Branches only move forward; malformed
+ * operands, invalid opcodes, and branches into the middle of an instruction are all generated.
+ */
+static size_t diff_generate (uint64_t *state, uint8_t *opcodes, uint8_t test_reg, uint8_t bad_reg, uint64_t *deref_target, size_t ptr_size) {
+    static const uint8_t simple_ops[] = {
+        DW_OP_dup, DW_OP_drop, DW_OP_over, DW_OP_swap, DW_OP_rot, DW_OP_nop,
+        DW_OP_abs, DW_OP_and, DW_OP_div, DW_OP_minus, DW_OP_mod, DW_OP_mul, DW_OP_neg, DW_OP_not, DW_OP_or, DW_OP_plus,
+        DW_OP_shl, DW_OP_shr, DW_OP_shra, DW_OP_xor, DW_OP_le, DW_OP_ge, DW_OP_eq, DW_OP_lt, DW_OP_gt, DW_OP_ne
+    };
+    static const uint8_t const_ops[] = {
+        DW_OP_const1u, DW_OP_const1s, DW_OP_const2u, DW_OP_const2s, DW_OP_const4u, DW_OP_const4s, DW_OP_const8u, DW_OP_const8s
+    };
+    size_t len = 0;
+    uint32_t count = 1 + diff_random(state) % 12;
+
+    for (uint32_t i = 0; i < count; i++) {
+        switch (diff_random(state) % 10) {
+            case 0:
+                opcodes[len++] = DW_OP_lit0 + diff_random(state) % 32;
+                break;
+
+            case 1: {
+                uint32_t idx = diff_random(state) % 8;
+                opcodes[len++] = const_ops[idx];
+                diff_append(opcodes, &len, ((uint64_t) diff_random(state) << 32) | diff_random(state), 1 << (idx / 2));
+                break;
+            }
+
+            case 2:
+                opcodes[len++] = (diff_random(state) % 2) ? DW_OP_constu : DW_OP_consts;
+                opcodes[len++] = 0x80 | diff_random(state);
+                opcodes[len++] = diff_random(state) & 0x7F;
+                break;
+
+            case 3: {
+                uint8_t reg = (diff_random(state) % 2) ? test_reg : bad_reg;
+                if (diff_random(state) % 2) {
+                    opcodes[len++] = DW_OP_breg0 + reg;
+                } else {
+                    opcodes[len++] = DW_OP_bregx;
+                    opcodes[len++] = reg;
+                }
+                opcodes[len++] = diff_random(state) & 0x7F;
+                break;
+            }
+
+            case 4:
+            case 5:
+                opcodes[len++] = simple_ops[diff_random(state) % (sizeof(simple_ops) / sizeof(simple_ops[0]))];
+                break;
+
+            case 6:
+                opcodes[len++] = (diff_random(state) % 2) ? DW_OP_pick : DW_OP_plus_uconst;
+                opcodes[len++] = diff_random(state) % 4;
+                break;
+
+            case 7:
+                /* Only dereference a known-valid address */
+                opcodes[len++] = (ptr_size == 8) ? DW_OP_const8u : DW_OP_const4u;
+                diff_append(opcodes, &len, (uintptr_t) deref_target, ptr_size);
+                if (diff_random(state) % 2) {
+                    opcodes[len++] = DW_OP_deref;
+                } else {
+                    opcodes[len++] = DW_OP_deref_size;
+                    opcodes[len++] = diff_random(state) % 10;
+                }
+                break;
+
+            case 8:
+                opcodes[len++] = (diff_random(state) % 2) ? DW_OP_skip : DW_OP_bra;
+                diff_append(opcodes, &len, diff_random(state) % 14, 2);
+                break;
+
+            case 9:
+                /* Arbitrary byte; may be an invalid opcode */
+                opcodes[len++] = diff_random(state);
+                break;
+        }
+    }
+
+    /* Occasionally truncate the final operand */
+    if (diff_random(state) % 10 == 0 && len > 1)
+        len--;
+
+    return len;
+}
+
+/**
+ * Verify that compiled expression programs produce results and error codes identical to the reference
+ * interpreter for a large set of generated expressions.
+ */
+- (void) testCompiledDifferential {
+    uint64_t state = 88172645463325252ULL;
+    uint64_t deref_target = 0x1122334455667788ULL;
+    size_t compiled = 0;
+
+    /* Set up the thread state */
+    plcrash_regnum_t regnum;
+    STAssertTrue(plcrash_async_thread_state_map_dwarf_to_reg(&_ts, [self dwarfTestRegister], &regnum), @"Failed to map DWARF register");
+    plcrash_async_thread_state_set_reg(&_ts, regnum, 0xFFFFFFF0);
+
+    for (size_t i = 0; i < 20000; i++) {
+        uint8_t opcodes[160];
+        size_t len = diff_generate(&state, opcodes, [self dwarfTestRegister], [self dwarfBadRegister], &deref_target, [self is32] ? 4 : 8);
+
+        plcrash_async_mobject_t mobj;
+        STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_mobject_init(&mobj, mach_task_self(), (pl_vm_address_t) opcodes, len, true), @"Failed to initialize mobj");
+
+        if (![self is32]) {
+            uint64_t initial_state[] = { diff_random(&state) };
+            uint64_t expected = 0, result = 0;
+            plcrash_error_t expected_err = plcrash_async_dwarf_expression_eval<uint64_t, int64_t>(&mobj, mach_task_self(), &_ts, plcrash_async_byteorder_big_endian(), (pl_vm_address_t) opcodes, 0, len, initial_state, 1, &expected);
+
+            dwarf_expression_program<uint64_t, int64_t> program;
+            if (program.compile(&mobj, plcrash_async_byteorder_big_endian(), (pl_vm_address_t) opcodes, 0, len) == PLCRASH_ESUCCESS) {
+                compiled++;
+                STAssertEquals(program.eval(mach_task_self(), &_ts, initial_state, 1, &result), expected_err, @"Compiled error code differs for expression %zu", i);
+                if (expected_err == PLCRASH_ESUCCESS)
+                    STAssertEquals(result, expected, @"Compiled result differs for expression %zu", i);
+            }
+        } else {
+            uint32_t initial_state[] = { diff_random(&state) };
+            uint32_t expected = 0, result = 0;
+            plcrash_error_t expected_err = plcrash_async_dwarf_expression_eval<uint32_t, int32_t>(&mobj, mach_task_self(), &_ts, plcrash_async_byteorder_big_endian(), (pl_vm_address_t) opcodes, 0, len, initial_state, 1, &expected);
+
+            dwarf_expression_program<uint32_t, int32_t> program;
+            if (program.compile(&mobj, plcrash_async_byteorder_big_endian(), (pl_vm_address_t) opcodes, 0, len) == PLCRASH_ESUCCESS) {
+                compiled++;
+                STAssertEquals(program.eval(mach_task_self(), &_ts, initial_state, 1, &result), expected_err, @"Compiled error code differs for expression %zu", i);
+                if (expected_err == PLCRASH_ESUCCESS)
+                    STAssertEquals(result, expected, @"Compiled result differs for expression %zu", i);
+            }
+        }
+
+        plcrash_async_mobject_free(&mobj);
+    }
+
+    /* Most generated expressions are representable; verify that the comparison was not vacuous. */
+    STAssertTrue(compiled > 10000, @"Only %zu expressions were compiled", compiled);
+}
+
+/**
+ * Verify that expressions that can not be represented exactly are rejected by the compiler.
+ */
+- (void) testCompileRejected {
+    plcrash_async_mobject_t mobj;
+    dwarf_expression_program<uint64_t, int64_t> program;
+
+    /* Branch into the middle of the DW_OP_const2u operand */
+    uint8_t mid_insn[] = { DW_OP_skip, 0x0, 0x1, DW_OP_const2u, DW_OP_lit1, DW_OP_lit2 };
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_mobject_init(&mobj, mach_task_self(), (pl_vm_address_t) mid_insn, sizeof(mid_insn), true), @"Failed to initialize mobj");
+    STAssertEquals(program.compile(&mobj, plcrash_async_byteorder_big_endian(), (pl_vm_address_t) mid_insn, 0, sizeof(mid_insn)), PLCRASH_ENOTSUP, @"Mid-instruction branch was compiled");
+    plcrash_async_mobject_free(&mobj);
+
+    /* Truncated operand */
+    uint8_t truncated[] = { DW_OP_lit1, DW_OP_const4u, 0x0, 0x0 };
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_mobject_init(&mobj, mach_task_self(), (pl_vm_address_t) truncated, sizeof(truncated), true), @"Failed to initialize mobj");
+    STAssertEquals(program.compile(&mobj, plcrash_async_byteorder_big_endian(), (pl_vm_address_t) truncated, 0, sizeof(truncated)), PLCRASH_EINVAL, @"Truncated operand was compiled");
+    plcrash_async_mobject_free(&mobj);
+
+    /* A rejected program must not be evaluated */
+    uint64_t result;
+    STAssertEquals(program.eval(mach_task_self(), &_ts, NULL, 0, &result), PLCRASH_EINVAL, @"Rejected program was evaluated");
+}
+
+/**
+ * Verify compiled expression caching, including fallback to the reference interpreter.
+ */
+- (void) testExpressionCache {
+    dwarf_expression_cache<uint64_t, int64_t> cache;
+    uint64_t result;
+
+    uint8_t opcodes[] = { DW_OP_lit5, DW_OP_lit1, DW_OP_minus, DW_OP_dup, DW_OP_bra, 0xFF, 0xFA /* -6; jump to decrement */ };
+    for (int i = 0; i < 3; i++) {
+        STAssertEquals(cache.eval(mach_task_self(), &_ts, plcrash_async_byteorder_big_endian(), (pl_vm_address_t) opcodes, sizeof(opcodes), NULL, 0, &result), PLCRASH_ESUCCESS, @"Evaluation failed");
+        STAssertEquals(result, (uint64_t) 0, @"Incorrect result");
+    }
+    STAssertEquals(cache.misses(), (uint32_t) 1, @"Expression should have been compiled once");
+    STAssertEquals(cache.hits(), (uint32_t) 2, @"Expression should have been served from the cache");
+
+    /* Not representable as a compiled program; must be evaluated by the interpreter */
+    uint8_t mid_insn[] = { DW_OP_skip, 0x0, 0x1, DW_OP_const2u, DW_OP_lit1, DW_OP_lit2 };
+    for (int i = 0; i < 2; i++) {
+        STAssertEquals(cache.eval(mach_task_self(), &_ts, plcrash_async_byteorder_big_endian(), (pl_vm_address_t) mid_insn, sizeof(mid_insn), NULL, 0, &result), PLCRASH_ESUCCESS, @"Evaluation failed");
+        STAssertEquals(result, (uint64_t) 2, @"Incorrect result");
+    }
+    STAssertEquals(cache.misses(), (uint32_t) 2, @"Uncompilable expression should only be compiled once");
+}
+
 @end
 
 #endif /* PLCRASH_FEATURE_UNWIND_DWARF */
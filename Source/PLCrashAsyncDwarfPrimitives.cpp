@@ -435,6 +435,27 @@ plcrash_error_t plcrash::async::plcrash_async_dwarf_read_task_uleb128 (task_t ta
     return err;
 }
 
+/**
+ * Map @a location + @a offset within @a mobj, returning the local address and the number of bytes readable
+ * from that address to the end of @a mobj. This allows the LEB128 decoders to perform a single bounds check
+ * for the entire value, rather than remapping every byte.
+ *
+ * @param mobj The memory object to be mapped.
+ * @param location A task-relative location within @a mobj.
+ * @param offset Offset to be applied to @a location.
+ * @param avail On success, the number of bytes readable at the returned address.
+ *
+ * @return Returns the local address, or NULL if the target address does not fall within @a mobj.
+ */
+static const uint8_t *leb128_local_range (plcrash_async_mobject_t *mobj, pl_vm_address_t location, pl_vm_off_t offset, size_t *avail) {
+    const uint8_t *p = (const uint8_t *) plcrash_async_mobject_remap_address(mobj, location, offset, 1);
+    if (p == NULL)
+        return NULL;
+
+    *avail = (size_t) ((mobj->address + mobj->length) - (uintptr_t) p);
+    return p;
+}
+
 /**
  * Read a ULEB128 value from @a location within @a mobj.
  *
@@ -445,38 +466,20 @@ plcrash_error_t plcrash::async::plcrash_async_dwarf_read_task_uleb128 (task_t ta
  * @param size On success, will be set to the total size of the decoded LEB128 value at @a location, in bytes.
  */
 plcrash_error_t plcrash::async::plcrash_async_dwarf_read_uleb128 (plcrash_async_mobject_t *mobj, pl_vm_address_t location, pl_vm_off_t offset, uint64_t *result, pl_vm_size_t *size) {
-    unsigned int shift = 0;
-    pl_vm_off_t position = 0;
-    *result = 0;
-    
-    uint8_t *p;
-    while ((p = (uint8_t *) plcrash_async_mobject_remap_address(mobj, location, position + offset, 1)) != NULL) {
-        /* LEB128 uses 7 bits for the number, the final bit to signal completion */
-        uint8_t byte = *p;
-        *result |= ((uint64_t) (byte & 0x7f)) << shift;
-        shift += 7;
-        
-        /* This is used to track length, so we must set it before
-         * potentially terminating the loop below */
-        position++;
-        
-        /* Check for terminating bit */
-        if ((byte & 0x80) == 0)
-            break;
-        
-        /* Check for a ULEB128 larger than 64-bits */
-        if (shift >= 64) {
-            PLCF_DEBUG("ULEB128 is larger than the maximum supported size of 64 bits");
-            return PLCRASH_ENOTSUP;
-        }
-    }
-    
-    if (p == NULL) {
+    const uint8_t *p;
+    size_t avail;
+    size_t lebsize;
+    plcrash_error_t err;
+
+    if ((p = leb128_local_range(mobj, location, offset, &avail)) == NULL) {
         PLCF_DEBUG("ULEB128 value did not terminate within mapped memory range");
         return PLCRASH_EINVAL;
     }
-    
-    *size = position;
+
+    if ((err = plcrash_async_dwarf_decode_uleb128(p, avail, result, &lebsize)) != PLCRASH_ESUCCESS)
+        return err;
+
+    *size = lebsize;
     return PLCRASH_ESUCCESS;
 }
 
@@ -490,42 +493,20 @@ plcrash_error_t plcrash::async::plcrash_async_dwarf_read_uleb128 (plcrash_async_
  * @param size On success, will be set to the total size of the decoded LEB128 value, in bytes.
  */
 plcrash_error_t plcrash::async::plcrash_async_dwarf_read_sleb128 (plcrash_async_mobject_t *mobj, pl_vm_address_t location, pl_vm_off_t offset, int64_t *result, pl_vm_size_t *size) {
-    unsigned int shift = 0;
-    pl_vm_off_t position = 0;
-    *result = 0;
-    
-    uint8_t *p;
-    while ((p = (uint8_t *) plcrash_async_mobject_remap_address(mobj, location, position + offset, 1)) != NULL) {
-        /* LEB128 uses 7 bits for the number, the final bit to signal completion */
-        uint8_t byte = *p;
-        *result |= ((uint64_t) (byte & 0x7f)) << shift;
-        shift += 7;
-        
-        /* This is used to track length, so we must set it before
-         * potentially terminating the loop below */
-        position++;
-        
-        /* Check for terminating bit */
-        if ((byte & 0x80) == 0)
-            break;
-        
-        /* Check for a ULEB128 larger than 64-bits */
-        if (shift >= 64) {
-            PLCF_DEBUG("ULEB128 is larger than the maximum supported size of 64 bits");
-            return PLCRASH_ENOTSUP;
-        }
-    }
-    
-    if (p == NULL) {
-        PLCF_DEBUG("ULEB128 value did not terminate within mapped memory range");
+    const uint8_t *p;
+    size_t avail;
+    size_t lebsize;
+    plcrash_error_t err;
+
+    if ((p = leb128_local_range(mobj, location, offset, &avail)) == NULL) {
+        PLCF_DEBUG("SLEB128 value did not terminate within mapped memory range");
         return PLCRASH_EINVAL;
     }
-    
-    /* Sign bit is 2nd high order bit */
-    if (shift < 64 && (*p & 0x40))
-        *result |= -(1ULL << shift);
-    
-    *size = position;
+
+    if ((err = plcrash_async_dwarf_decode_sleb128(p, avail, result, &lebsize)) != PLCRASH_ESUCCESS)
+        return err;
+
+    *size = lebsize;
     return PLCRASH_ESUCCESS;
 }
 
@@ -339,6 +339,148 @@ private:
     base_addr_t _func_base;
 };
 
+/**
+ * @internal
+ *
+ * Decode the scalar (one byte per iteration) tail of a LEB128 value. This is the fallback path of
+ * plcrash_async_dwarf_decode_leb128(), and is used for values that are not terminated within the first
+ * eight bytes, or that are located fewer than eight bytes from the end of the readable range.
+ *
+ * @param p The local address of the LEB128 data.
+ * @param avail The number of bytes readable at @a p.
+ * @param result On success, the raw (not sign extended) decoded value.
+ * @param size On success, the total size of the decoded value, in bytes.
+ * @param shift On success, the total number of value bits decoded; used for SLEB128 sign extension.
+ */
+static inline plcrash_error_t plcrash_async_dwarf_decode_leb128_scalar (const uint8_t *p, size_t avail, uint64_t *result, size_t *size, unsigned int *shift) {
+    uint64_t value = 0;
+    unsigned int bits = 0;
+
+    for (size_t position = 0; position < avail; position++) {
+        /* LEB128 uses 7 bits for the number, the final bit to signal completion */
+        uint8_t byte = p[position];
+        value |= ((uint64_t) (byte & 0x7f)) << bits;
+        bits += 7;
+
+        /* Check for terminating bit */
+        if ((byte & 0x80) == 0) {
+            *result = value;
+            *size = position + 1;
+            *shift = bits;
+            return PLCRASH_ESUCCESS;
+        }
+
+        /* Check for a LEB128 larger than 64-bits */
+        if (bits >= 64) {
+            PLCF_DEBUG("LEB128 is larger than the maximum supported size of 64 bits");
+            return PLCRASH_ENOTSUP;
+        }
+    }
+
+    PLCF_DEBUG("LEB128 value did not terminate within mapped memory range");
+    return PLCRASH_EINVAL;
+}
+
+/**
+ * @internal
+ *
+ * Decode a LEB128 value from locally mapped memory, performing a single bounds check for the entire value.
+ *
+ * Single byte values are returned directly. On little-endian hosts, values that terminate within the first eight
+ * bytes (which includes every LEB128 value of 56 bits or fewer) are decoded without a per-byte loop: the eight bytes are loaded as a single word, the
+ * terminating byte is located from the clear continuation bits, and the 7-bit groups are packed together with
+ * three shift-and-mask steps. All other values fall back to plcrash_async_dwarf_decode_leb128_scalar().
+ *
+ * @param p The local address of the LEB128 data.
+ * @param avail The number of bytes readable at @a p. No bytes beyond this range will be read.
+ * @param result On success, the raw (not sign extended) decoded value.
+ * @param size On success, the total size of the decoded value, in bytes.
+ * @param shift On success, the total number of value bits decoded; used for SLEB128 sign extension.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, PLCRASH_ENOTSUP if the value exceeds 64 bits, or PLCRASH_EINVAL if
+ * the value does not terminate within @a avail bytes.
+ */
+static inline plcrash_error_t plcrash_async_dwarf_decode_leb128 (const uint8_t *p, size_t avail, uint64_t *result, size_t *size, unsigned int *shift) {
+    /* Single byte values are by far the most common encoding found in CFA programs */
+    if (avail > 0 && (p[0] & 0x80) == 0) {
+        *result = p[0];
+        *size = 1;
+        *shift = 7;
+        return PLCRASH_ESUCCESS;
+    }
+
+#if defined(__LITTLE_ENDIAN__)
+    if (avail >= sizeof(uint64_t)) {
+        uint64_t word;
+        __builtin_memcpy(&word, p, sizeof(word));
+
+        /* The terminating byte is the first byte with a clear continuation bit */
+        uint64_t stops = ~word & 0x8080808080808080ULL;
+        if (stops != 0) {
+            unsigned int nbytes = (__builtin_ctzll(stops) >> 3) + 1;
+
+            /* Discard any bytes following the terminator, and the continuation bits */
+            if (nbytes < sizeof(uint64_t))
+                word &= (1ULL << (nbytes * 8)) - 1;
+            word &= 0x7f7f7f7f7f7f7f7fULL;
+
+            /* Pack 8x7-bit groups -> 4x14-bit -> 2x28-bit -> 1x56-bit */
+            word = ((word & 0x7f007f007f007f00ULL) >> 1) | (word & 0x007f007f007f007fULL);
+            word = ((word & 0x3fff00003fff0000ULL) >> 2) | (word & 0x00003fff00003fffULL);
+            word = ((word & 0x0fffffff00000000ULL) >> 4) | (word & 0x000000000fffffffULL);
+
+            *result = word;
+            *size = nbytes;
+            *shift = nbytes * 7;
+            return PLCRASH_ESUCCESS;
+        }
+    }
+#endif
+
+    return plcrash_async_dwarf_decode_leb128_scalar(p, avail, result, size, shift);
+}
+
+/**
+ * @internal
+ *
+ * Decode a ULEB128 value from locally mapped memory.
+ *
+ * @param p The local address of the LEB128 data.
+ * @param avail The number of bytes readable at @a p. No bytes beyond this range will be read.
+ * @param result On success, the ULEB128 value.
+ * @param size On success, the total size of the decoded value, in bytes.
+ */
+static inline plcrash_error_t plcrash_async_dwarf_decode_uleb128 (const uint8_t *p, size_t avail, uint64_t *result, size_t *size) {
+    unsigned int shift;
+    return plcrash_async_dwarf_decode_leb128(p, avail, result, size, &shift);
+}
+
+/**
+ * @internal
+ *
+ * Decode a SLEB128 value from locally mapped memory.
+ *
+ * @param p The local address of the LEB128 data.
+ * @param avail The number of bytes readable at @a p. No bytes beyond this range will be read.
+ * @param result On success, the SLEB128 value.
+ * @param size On success, the total size of the decoded value, in bytes.
+ */
+static inline plcrash_error_t plcrash_async_dwarf_decode_sleb128 (const uint8_t *p, size_t avail, int64_t *result, size_t *size) {
+    plcrash_error_t err;
+    unsigned int shift;
+    uint64_t value;
+
+    if ((err = plcrash_async_dwarf_decode_leb128(p, avail, &value, size, &shift)) != PLCRASH_ESUCCESS)
+        return err;
+
+    /* Sign bit is 2nd high order bit of the final byte; it is the highest decoded value bit */
+    if (shift < 64 && (value & (1ULL << (shift - 1))))
+        value |= -(1ULL << shift);
+
+    *result = (int64_t) value;
+    return PLCRASH_ESUCCESS;
+}
+
 plcrash_error_t plcrash_async_dwarf_read_uleb128 (plcrash_async_mobject_t *mobj, pl_vm_address_t location, pl_vm_off_t offset, uint64_t *result, pl_vm_size_t *size);
 plcrash_error_t plcrash_async_dwarf_read_sleb128 (plcrash_async_mobject_t *mobj, pl_vm_address_t location, pl_vm_off_t offset, int64_t *result, pl_vm_size_t *size);
 
@@ -31,15 +31,211 @@
 #include "PLCrashAsyncDwarfEncoding.hpp"
 #include "PLCrashAsyncDwarfPrimitives.hpp"
 #include "PLCrashAsyncDwarfFDE.hpp"
+#include "PLCrashAsyncMachOImage.h"
+#include "dwarf_opstream.hpp"
 
 #include "PLCrashFeatureConfig.h"
 
 #include <inttypes.h>
+#include <mach/mach_time.h>
+#include <mach-o/dyld.h>
 
 #if PLCRASH_FEATURE_UNWIND_DWARF
 
 using namespace plcrash::async;
 
+/**
+ * Reference byte-at-a-time LEB128 reader, equivalent to the decoder used prior to the introduction of
+ * plcrash_async_dwarf_decode_leb128(); each byte is remapped and bounds checked individually.
+ */
+static plcrash_error_t reference_read_leb128 (plcrash_async_mobject_t *mobj, pl_vm_address_t location, bool is_signed, uint64_t *result, pl_vm_size_t *size) {
+    unsigned int shift = 0;
+    pl_vm_off_t position = 0;
+    uint64_t value = 0;
+
+    uint8_t *p;
+    while ((p = (uint8_t *) plcrash_async_mobject_remap_address(mobj, location, position, 1)) != NULL) {
+        uint8_t byte = *p;
+        value |= ((uint64_t) (byte & 0x7f)) << shift;
+        shift += 7;
+        position++;
+
+        if ((byte & 0x80) == 0) {
+            if (is_signed && shift < 64 && (byte & 0x40))
+                value |= -(1ULL << shift);
+
+            *result = value;
+            *size = position;
+            return PLCRASH_ESUCCESS;
+        }
+
+        if (shift >= 64)
+            return PLCRASH_ENOTSUP;
+    }
+
+    return PLCRASH_EINVAL;
+}
+
+/**
+ * Encode @a value as a LEB128 value of exactly @a width bytes, padding with continuation bytes as necessary.
+ */
+static void encode_padded_leb128 (uint64_t value, bool is_signed, size_t width, uint8_t *buffer) {
+    for (size_t i = 0; i < width; i++) {
+        unsigned int shift = (unsigned int) (7 * i);
+        uint64_t group = is_signed ? (uint64_t) (((int64_t) value) >> shift) : value >> shift;
+
+        buffer[i] = (group & 0x7f) | (i + 1 < width ? 0x80 : 0);
+    }
+}
+
+/** xorshift64 generator used to produce reproducible LEB128 test data. */
+static uint64_t leb128_random (uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+/** Maximum number of images scanned by testLEB128Benchmark */
+#define LEB128_BENCH_MAX_IMAGES 32
+
+/** Maximum number of FDE instruction streams collected by testLEB128Benchmark */
+#define LEB128_BENCH_MAX_STREAMS (1 << 16)
+
+/** An FDE instruction stream located within a mapped __eh_frame section. */
+typedef struct leb128_bench_stream {
+    /** The memory object containing the stream. */
+    plcrash_async_mobject_t *mobj;
+
+    /** The task-relative address of the stream. */
+    pl_vm_address_t address;
+
+    /** The length of the stream, in bytes. */
+    pl_vm_size_t length;
+} leb128_bench_stream_t;
+
+/**
+ * Return the operand layout of CFA @a opcode, or NULL if the operands can not be decoded without CIE context
+ * (DW_CFA_set_loc) or the opcode is unknown. Layout characters: U = ULEB128, S = SLEB128, B = ULEB128 length
+ * followed by a block of that length, digits = fixed size operand.
+ */
+static const char *leb128_bench_layout (uint8_t opcode) {
+    switch (opcode & 0xC0) {
+        case DW_CFA_advance_loc:
+        case DW_CFA_restore:
+            return "";
+        case DW_CFA_offset:
+            return "U";
+        default:
+            break;
+    }
+
+    switch (opcode) {
+        case DW_CFA_nop:
+        case DW_CFA_remember_state:
+        case DW_CFA_restore_state:
+            return "";
+
+        case DW_CFA_advance_loc1:
+            return "1";
+        case DW_CFA_advance_loc2:
+            return "2";
+        case DW_CFA_advance_loc4:
+            return "4";
+
+        case DW_CFA_restore_extended:
+        case DW_CFA_undefined:
+        case DW_CFA_same_value:
+        case DW_CFA_def_cfa_register:
+        case DW_CFA_def_cfa_offset:
+        case 0x2e: /* DW_CFA_GNU_args_size */
+            return "U";
+
+        case DW_CFA_offset_extended:
+        case DW_CFA_register:
+        case DW_CFA_def_cfa:
+        case DW_CFA_val_offset:
+        case 0x2f: /* DW_CFA_GNU_negative_offset_extended */
+            return "UU";
+
+        case DW_CFA_def_cfa_offset_sf:
+            return "S";
+
+        case DW_CFA_offset_extended_sf:
+        case DW_CFA_def_cfa_sf:
+        case DW_CFA_val_offset_sf:
+            return "US";
+
+        case DW_CFA_def_cfa_expression:
+            return "B";
+
+        case DW_CFA_expression:
+        case DW_CFA_val_expression:
+            return "UB";
+
+        default:
+            return NULL;
+    }
+}
+
+/**
+ * Walk the CFA instruction stream @a stream using dwarf_opstream, decoding every LEB128 operand, and
+ * terminating at the first opcode for which leb128_bench_layout() returns NULL.
+ *
+ * @param stream The stream to walk.
+ * @param reference If true, operands are decoded with reference_read_leb128(), as dwarf_opstream did prior
+ * to the introduction of plcrash_async_dwarf_decode_leb128(). Otherwise, the dwarf_opstream LEB128 readers are used.
+ * @param checksum The sum of all decoded operand values will be added to this value.
+ *
+ * @return Returns the number of LEB128 operands decoded.
+ */
+static size_t leb128_bench_walk (leb128_bench_stream_t *stream, bool reference, uint64_t *checksum) {
+    dwarf_opstream opstream;
+    size_t count = 0;
+    uint8_t opcode;
+
+    if (opstream.init(stream->mobj, &plcrash_async_byteorder_direct, stream->address, 0, stream->length) != PLCRASH_ESUCCESS)
+        return 0;
+
+    while (opstream.read_intU(&opcode)) {
+        const char *layout = leb128_bench_layout(opcode);
+        if (layout == NULL)
+            return count;
+
+        for (const char *op = layout; *op != '\0'; op++) {
+            uint64_t value;
+
+            if (*op >= '1' && *op <= '9') {
+                if (!opstream.skip(*op - '0'))
+                    return count;
+                continue;
+            }
+
+            if (reference) {
+                pl_vm_size_t size;
+                if (reference_read_leb128(stream->mobj, stream->address + opstream.get_position(), *op == 'S', &value, &size) != PLCRASH_ESUCCESS || !opstream.skip(size))
+                    return count;
+            } else if (*op == 'S') {
+                int64_t svalue;
+                if (!opstream.read_sleb128(&svalue))
+                    return count;
+                value = (uint64_t) svalue;
+            } else if (!opstream.read_uleb128(&value)) {
+                return count;
+            }
+
+            *checksum += value;
+            count++;
+
+            /* Skip expression blocks */
+            if (*op == 'B' && !opstream.skip(value))
+                return count;
+        }
+    }
+
+    return count;
+}
+
 @interface PLCrashAsyncDwarfPrimativesTests : PLCrashTestCase {
 }
 @end
@@ -593,6 +789,213 @@ using namespace plcrash::async;
 }
 
 
+
+/**
+ * Test decoding of LEB128 values of every supported encoded width, both with enough trailing data to use the
+ * word-at-a-time path, and with the value ending exactly at the end of the readable range.
+ */
+- (void) testDecodeLEB128Widths {
+    uint8_t buffer[32];
+
+    for (size_t width = 1; width <= 10; width++) {
+        unsigned int bits = (unsigned int) (7 * width);
+
+        /* Unsigned values that fit within width */
+        uint64_t umax = bits >= 64 ? UINT64_MAX : (1ULL << bits) - 1;
+        uint64_t uvalues[] = { 0, 1, umax, umax / 3, umax >> 1 };
+
+        /* Signed values that fit within width */
+        int64_t smax = bits >= 64 ? INT64_MAX : (int64_t) ((1ULL << (bits - 1)) - 1);
+        int64_t smin = bits >= 64 ? INT64_MIN : -smax - 1;
+        int64_t svalues[] = { 0, -1, 1, smax, smin, smin / 3 };
+
+        for (size_t trailing = 0; trailing <= 16; trailing += 16) {
+            for (size_t i = 0; i < sizeof(uvalues) / sizeof(uvalues[0]); i++) {
+                uint64_t result;
+                size_t size;
+
+                /* Trailing bytes are continuation bytes; they must not be consumed */
+                memset(buffer, 0x80, sizeof(buffer));
+                encode_padded_leb128(uvalues[i], false, width, buffer);
+
+                STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_dwarf_decode_uleb128(buffer, width + trailing, &result, &size), @"Failed to decode %zu-byte ULEB128", width);
+                STAssertEquals(uvalues[i], result, @"Incorrect %zu-byte ULEB128 value", width);
+                STAssertEquals(width, size, @"Incorrect %zu-byte ULEB128 size", width);
+            }
+
+            for (size_t i = 0; i < sizeof(svalues) / sizeof(svalues[0]); i++) {
+                int64_t result;
+                size_t size;
+
+                memset(buffer, 0x80, sizeof(buffer));
+                encode_padded_leb128((uint64_t) svalues[i], true, width, buffer);
+
+                STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_dwarf_decode_sleb128(buffer, width + trailing, &result, &size), @"Failed to decode %zu-byte SLEB128", width);
+                STAssertEquals(svalues[i], result, @"Incorrect %zu-byte SLEB128 value", width);
+                STAssertEquals(width, size, @"Incorrect %zu-byte SLEB128 size", width);
+            }
+        }
+
+        /* A value that extends one byte past the readable range must be rejected */
+        uint64_t result;
+        size_t size;
+        memset(buffer, 0x80, sizeof(buffer));
+        encode_padded_leb128(1, false, width, buffer);
+        STAssertEquals(PLCRASH_EINVAL, plcrash_async_dwarf_decode_uleb128(buffer, width - 1, &result, &size), @"Truncated %zu-byte ULEB128 should not be decodable", width);
+    }
+
+    /* Values larger than 64 bits must be rejected, regardless of whether they terminate within the readable range */
+    uint64_t result;
+    size_t size;
+    memset(buffer, 0x80, sizeof(buffer));
+    buffer[10] = 0x01;
+    STAssertEquals(PLCRASH_ENOTSUP, plcrash_async_dwarf_decode_uleb128(buffer, sizeof(buffer), &result, &size), @"11-byte ULEB128 should not be decodable");
+}
+
+/**
+ * Verify that the LEB128 readers produce results identical to the reference byte-at-a-time reader for every
+ * offset within randomly generated buffers, including offsets near the end of the mapped range.
+ */
+- (void) testReadLEB128Differential {
+    uint64_t state = 88172645463325252ULL;
+    uint8_t buffer[4096];
+
+    for (size_t round = 0; round < 8; round++) {
+        /* Vary the density of continuation bits, so that both short and overlong values are generated */
+        uint64_t continuation_odds = 2 + round;
+        for (size_t i = 0; i < sizeof(buffer); i++) {
+            uint64_t r = leb128_random(&state);
+            buffer[i] = (r & 0x7f) | ((r >> 8) % continuation_odds != 0 ? 0x80 : 0);
+        }
+
+        plcrash_async_mobject_t mobj;
+        STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_mobject_init(&mobj, mach_task_self(), (pl_vm_address_t) buffer, sizeof(buffer), true), @"Failed to initialize mobj mapping");
+
+        for (size_t offset = 0; offset < sizeof(buffer); offset++) {
+            pl_vm_address_t location = (pl_vm_address_t) buffer + offset;
+            uint64_t expected, uresult;
+            int64_t sresult;
+            pl_vm_size_t expected_size, size;
+            plcrash_error_t expected_err;
+
+            expected_err = reference_read_leb128(&mobj, location, false, &expected, &expected_size);
+            STAssertEquals(expected_err, plcrash_async_dwarf_read_uleb128(&mobj, location, 0, &uresult, &size), @"ULEB128 error differs at offset %zu", offset);
+            if (expected_err == PLCRASH_ESUCCESS) {
+                STAssertEquals(expected, uresult, @"ULEB128 value differs at offset %zu", offset);
+                STAssertEquals(expected_size, size, @"ULEB128 size differs at offset %zu", offset);
+            }
+
+            expected_err = reference_read_leb128(&mobj, location, true, &expected, &expected_size);
+            STAssertEquals(expected_err, plcrash_async_dwarf_read_sleb128(&mobj, location, 0, &sresult, &size), @"SLEB128 error differs at offset %zu", offset);
+            if (expected_err == PLCRASH_ESUCCESS) {
+                STAssertEquals((int64_t) expected, sresult, @"SLEB128 value differs at offset %zu", offset);
+                STAssertEquals(expected_size, size, @"SLEB128 size differs at offset %zu", offset);
+            }
+        }
+
+        plcrash_async_mobject_free(&mobj);
+    }
+}
+
+/**
+ * Benchmark LEB128 decoding over the FDE instruction streams found in the __eh_frame sections of the images
+ * loaded into the test process, comparing the byte-at-a-time reference reader against the dwarf_opstream readers.
+ */
+- (void) testLEB128Benchmark {
+    static leb128_bench_stream_t streams[LEB128_BENCH_MAX_STREAMS];
+    plcrash_async_macho_t images[LEB128_BENCH_MAX_IMAGES];
+    plcrash_async_mobject_t sections[LEB128_BENCH_MAX_IMAGES];
+    size_t image_count = 0;
+    size_t stream_count = 0;
+
+    /* Collect every FDE instruction stream */
+    for (uint32_t i = 0; i < _dyld_image_count() && image_count < LEB128_BENCH_MAX_IMAGES; i++) {
+        plcrash_async_macho_t *image = &images[image_count];
+        plcrash_async_mobject_t *sect = &sections[image_count];
+
+        if (plcrash_nasync_macho_init(image, mach_task_self(), _dyld_get_image_name(i), (pl_vm_address_t) _dyld_get_image_header(i)) != PLCRASH_ESUCCESS)
+            continue;
+
+        if (plcrash_async_macho_map_section(image, SEG_TEXT, "__eh_frame", sect) != PLCRASH_ESUCCESS) {
+            plcrash_nasync_macho_free(image);
+            continue;
+        }
+        image_count++;
+
+        const plcrash_async_byteorder_t *byteorder = plcrash_async_macho_byteorder(image);
+        pl_vm_address_t base = plcrash_async_mobject_base_address(sect);
+        pl_vm_size_t sect_length = plcrash_async_mobject_length(sect);
+        pl_vm_size_t offset = 0;
+
+        while (offset + 8 <= sect_length && stream_count < LEB128_BENCH_MAX_STREAMS) {
+            uint32_t length, cie_id;
+            if (plcrash_async_mobject_read_uint32(sect, byteorder, base, offset, &length) != PLCRASH_ESUCCESS || length == 0 || length == UINT32_MAX)
+                break;
+            if (plcrash_async_mobject_read_uint32(sect, byteorder, base, offset + 4, &cie_id) != PLCRASH_ESUCCESS)
+                break;
+
+            /* A non-zero CIE pointer identifies an FDE */
+            if (cie_id != 0) {
+                plcrash_async_dwarf_fde_info_t fde;
+                plcrash_error_t err;
+
+                if (image->m64)
+                    err = plcrash_async_dwarf_fde_info_init<uint64_t>(&fde, sect, byteorder, base + offset, false);
+                else
+                    err = plcrash_async_dwarf_fde_info_init<uint32_t>(&fde, sect, byteorder, base + offset, false);
+
+                if (err == PLCRASH_ESUCCESS) {
+                    streams[stream_count].mobj = sect;
+                    streams[stream_count].address = base + plcrash_async_dwarf_fde_info_instructions_offset(&fde);
+                    streams[stream_count].length = plcrash_async_dwarf_fde_info_instructions_length(&fde);
+                    stream_count++;
+                    plcrash_async_dwarf_fde_info_free(&fde);
+                }
+            }
+
+            offset += 4 + length;
+        }
+    }
+
+    STAssertTrue(stream_count > 0, @"No FDEs found in the loaded images");
+
+    /* Verify and time both readers */
+    const size_t iterations = 20;
+    uint64_t reference_time = 0, reference_checksum = 0;
+    uint64_t reader_time = 0, reader_checksum = 0;
+    size_t reference_count = 0, reader_count = 0;
+
+    for (size_t iter = 0; iter < iterations; iter++) {
+        uint64_t start = mach_absolute_time();
+        for (size_t i = 0; i < stream_count; i++)
+            reference_count += leb128_bench_walk(&streams[i], true, &reference_checksum);
+        reference_time += mach_absolute_time() - start;
+
+        start = mach_absolute_time();
+        for (size_t i = 0; i < stream_count; i++)
+            reader_count += leb128_bench_walk(&streams[i], false, &reader_checksum);
+        reader_time += mach_absolute_time() - start;
+    }
+
+    STAssertEquals(reference_count, reader_count, @"LEB128 readers decoded a different number of operands than the reference reader");
+    STAssertEquals(reference_checksum, reader_checksum, @"LEB128 readers disagree with the reference reader");
+
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+    double reference_ns = ((double) reference_time * timebase.numer) / timebase.denom;
+    double reader_ns = ((double) reader_time * timebase.numer) / timebase.denom;
+
+    fprintf(stderr, "LEB128 decode: %zu operands in %zu FDEs from %zu images\n", reference_count / iterations, stream_count, image_count);
+    fprintf(stderr, "  %-12s %12s %12s\n", "reader", "ns/FDE", "ns/operand");
+    fprintf(stderr, "  %-12s %12.2f %12.2f\n", "byte-wise", reference_ns / (iterations * stream_count), reference_ns / reference_count);
+    fprintf(stderr, "  %-12s %12.2f %12.2f\n", "word-wise", reader_ns / (iterations * stream_count), reader_ns / reader_count);
+
+    for (size_t i = 0; i < image_count; i++) {
+        plcrash_async_mobject_free(&sections[i]);
+        plcrash_nasync_macho_free(&images[i]);
+    }
+}
+
 @end
 
 #endif /* PLCRASH_FEATURE_UNWIND_DWARF */
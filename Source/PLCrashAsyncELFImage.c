@@ -0,0 +1,1026 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PLCrashAsyncELFImage.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+/**
+ * @internal
+ * @ingroup plcrash_async_image
+ *
+ * Implements async-safe ELF binary parsing. This is used to locate the DWARF unwind data (.eh_frame,
+ * .eh_frame_hdr, and .debug_frame) within ELF objects, allowing the DWARF CFA engine to be driven from
+ * ELF images.
+ *
+ * The ELF structures are defined locally, as <elf.h> is not available on Apple's platforms.
+ * @{
+ */
+
+/* e_ident indices and values */
+#define PL_ELF_EI_NIDENT    16
+#define PL_ELF_EI_CLASS     4
+#define PL_ELF_EI_DATA      5
+#define PL_ELF_CLASS32      1
+#define PL_ELF_CLASS64      2
+#define PL_ELF_DATA2LSB     1
+#define PL_ELF_DATA2MSB     2
+
+/* Program header types */
+#define PL_ELF_PT_LOAD          1
+#define PL_ELF_PT_GNU_EH_FRAME  0x6474e550
+
+/* Section header types and flags */
+#define PL_ELF_SHT_SYMTAB   2
+#define PL_ELF_SHT_DYNSYM   11
+#define PL_ELF_SHF_ALLOC    0x2
+
+/* Undefined section index */
+#define PL_ELF_SHN_UNDEF    0
+
+/* The subset of the DW_EH_PE pointer encodings used by .eh_frame_hdr */
+#define PL_ELF_DW_EH_PE_absptr  0x00
+#define PL_ELF_DW_EH_PE_udata2  0x02
+#define PL_ELF_DW_EH_PE_udata4  0x03
+#define PL_ELF_DW_EH_PE_udata8  0x04
+#define PL_ELF_DW_EH_PE_sdata2  0x0A
+#define PL_ELF_DW_EH_PE_sdata4  0x0B
+#define PL_ELF_DW_EH_PE_sdata8  0x0C
+#define PL_ELF_DW_EH_PE_pcrel   0x10
+#define PL_ELF_DW_EH_PE_datarel 0x30
+#define PL_ELF_DW_EH_PE_omit    0xFF
+
+/** ELF header (32-bit) */
+struct pl_elf32_ehdr {
+    uint8_t e_ident[PL_ELF_EI_NIDENT];
+    uint16_t e_type;
+    uint16_t e_machine;
+    uint32_t e_version;
+    uint32_t e_entry;
+    uint32_t e_phoff;
+    uint32_t e_shoff;
+    uint32_t e_flags;
+    uint16_t e_ehsize;
+    uint16_t e_phentsize;
+    uint16_t e_phnum;
+    uint16_t e_shentsize;
+    uint16_t e_shnum;
+    uint16_t e_shstrndx;
+};
+
+/** ELF header (64-bit) */
+struct pl_elf64_ehdr {
+    uint8_t e_ident[PL_ELF_EI_NIDENT];
+    uint16_t e_type;
+    uint16_t e_machine;
+    uint32_t e_version;
+    uint64_t e_entry;
+    uint64_t e_phoff;
+    uint64_t e_shoff;
+    uint32_t e_flags;
+    uint16_t e_ehsize;
+    uint16_t e_phentsize;
+    uint16_t e_phnum;
+    uint16_t e_shentsize;
+    uint16_t e_shnum;
+    uint16_t e_shstrndx;
+};
+
+/** Program header (32-bit) */
+struct pl_elf32_phdr {
+    uint32_t p_type;
+    uint32_t p_offset;
+    uint32_t p_vaddr;
+    uint32_t p_paddr;
+    uint32_t p_filesz;
+    uint32_t p_memsz;
+    uint32_t p_flags;
+    uint32_t p_align;
+};
+
+/** Program header (64-bit) */
+struct pl_elf64_phdr {
+    uint32_t p_type;
+    uint32_t p_flags;
+    uint64_t p_offset;
+    uint64_t p_vaddr;
+    uint64_t p_paddr;
+    uint64_t p_filesz;
+    uint64_t p_memsz;
+    uint64_t p_align;
+};
+
+/** Section header (32-bit) */
+struct pl_elf32_shdr {
+    uint32_t sh_name;
+    uint32_t sh_type;
+    uint32_t sh_flags;
+    uint32_t sh_addr;
+    uint32_t sh_offset;
+    uint32_t sh_size;
+    uint32_t sh_link;
+    uint32_t sh_info;
+    uint32_t sh_addralign;
+    uint32_t sh_entsize;
+};
+
+/** Section header (64-bit) */
+struct pl_elf64_shdr {
+    uint32_t sh_name;
+    uint32_t sh_type;
+    uint64_t sh_flags;
+    uint64_t sh_addr;
+    uint64_t sh_offset;
+    uint64_t sh_size;
+    uint32_t sh_link;
+    uint32_t sh_info;
+    uint64_t sh_addralign;
+    uint64_t sh_entsize;
+};
+
+/** Symbol table entry (32-bit) */
+struct pl_elf32_sym {
+    uint32_t st_name;
+    uint32_t st_value;
+    uint32_t st_size;
+    uint8_t st_info;
+    uint8_t st_other;
+    uint16_t st_shndx;
+};
+
+/** Symbol table entry (64-bit) */
+struct pl_elf64_sym {
+    uint32_t st_name;
+    uint8_t st_info;
+    uint8_t st_other;
+    uint16_t st_shndx;
+    uint64_t st_value;
+    uint64_t st_size;
+};
+
+/**
+ * @internal
+ * A 32-bit/64-bit neutral program header. The values will be returned in host byte order.
+ */
+typedef struct pl_async_elf_segment {
+    uint32_t type;
+    uint64_t offset;
+    uint64_t vaddr;
+    uint64_t filesz;
+    uint64_t memsz;
+} pl_async_elf_segment_t;
+
+/**
+ * @internal
+ * A 32-bit/64-bit neutral section header. The values will be returned in host byte order.
+ */
+typedef struct pl_async_elf_section {
+    uint32_t name;
+    uint32_t type;
+    uint64_t flags;
+    uint64_t addr;
+    uint64_t offset;
+    uint64_t size;
+    uint32_t link;
+    uint64_t entsize;
+} pl_async_elf_section_t;
+
+/**
+ * @internal
+ * Compute the address of the file @a offset within @a image, assuming that the image's file contents are mapped
+ * at the ELF header address.
+ *
+ * @return Returns false if the address would overflow.
+ */
+static bool plcrash_async_elf_file_address (plcrash_async_elf_t *image, uint64_t offset, pl_vm_address_t *result) {
+    if (offset > PL_VM_ADDRESS_MAX - image->header_addr)
+        return false;
+
+    *result = image->header_addr + offset;
+    return true;
+}
+
+/**
+ * @internal
+ * Read the program header at @a index.
+ *
+ * @param image The ELF image.
+ * @param index The program header table index. This must be less than image->phnum.
+ * @param seg On success, will be initialized with the program header's values.
+ */
+static plcrash_error_t plcrash_async_elf_read_segment (plcrash_async_elf_t *image, uint16_t index, pl_async_elf_segment_t *seg) {
+    pl_vm_address_t addr;
+    plcrash_error_t err;
+
+    PLCF_ASSERT(index < image->phnum);
+
+    if (!plcrash_async_elf_file_address(image, image->phoff + (uint64_t) index * image->phentsize, &addr)) {
+        PLCF_DEBUG("Program header %" PRIu16 " address overflows in: %s", index, image->name);
+        return PLCRASH_EINVAL;
+    }
+
+    if (image->m64) {
+        struct pl_elf64_phdr phdr;
+        if ((err = plcrash_async_task_memcpy(image->task, addr, 0, &phdr, sizeof(phdr))) != PLCRASH_ESUCCESS) {
+            PLCF_DEBUG("Failed to read program header %" PRIu16 " in: %s", index, image->name);
+            return err;
+        }
+
+        seg->type = image->byteorder->swap32(phdr.p_type);
+        seg->offset = image->byteorder->swap64(phdr.p_offset);
+        seg->vaddr = image->byteorder->swap64(phdr.p_vaddr);
+        seg->filesz = image->byteorder->swap64(phdr.p_filesz);
+        seg->memsz = image->byteorder->swap64(phdr.p_memsz);
+    } else {
+        struct pl_elf32_phdr phdr;
+        if ((err = plcrash_async_task_memcpy(image->task, addr, 0, &phdr, sizeof(phdr))) != PLCRASH_ESUCCESS) {
+            PLCF_DEBUG("Failed to read program header %" PRIu16 " in: %s", index, image->name);
+            return err;
+        }
+
+        seg->type = image->byteorder->swap32(phdr.p_type);
+        seg->offset = image->byteorder->swap32(phdr.p_offset);
+        seg->vaddr = image->byteorder->swap32(phdr.p_vaddr);
+        seg->filesz = image->byteorder->swap32(phdr.p_filesz);
+        seg->memsz = image->byteorder->swap32(phdr.p_memsz);
+    }
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * @internal
+ * Read the section header at @a index. The section header table is only available if the image's file contents
+ * are mapped at the ELF header address.
+ *
+ * @param image The ELF image.
+ * @param index The section header table index. This must be less than image->shnum.
+ * @param sect On success, will be initialized with the section header's values.
+ */
+static plcrash_error_t plcrash_async_elf_read_section (plcrash_async_elf_t *image, uint16_t index, pl_async_elf_section_t *sect) {
+    pl_vm_address_t addr;
+    plcrash_error_t err;
+
+    PLCF_ASSERT(index < image->shnum);
+
+    if (!plcrash_async_elf_file_address(image, image->shoff + (uint64_t) index * image->shentsize, &addr)) {
+        PLCF_DEBUG("Section header %" PRIu16 " address overflows in: %s", index, image->name);
+        return PLCRASH_EINVAL;
+    }
+
+    if (image->m64) {
+        struct pl_elf64_shdr shdr;
+        if ((err = plcrash_async_task_memcpy(image->task, addr, 0, &shdr, sizeof(shdr))) != PLCRASH_ESUCCESS) {
+            PLCF_DEBUG("Failed to read section header %" PRIu16 " in: %s", index, image->name);
+            return err;
+        }
+
+        sect->name = image->byteorder->swap32(shdr.sh_name);
+        sect->type = image->byteorder->swap32(shdr.sh_type);
+        sect->flags = image->byteorder->swap64(shdr.sh_flags);
+        sect->addr = image->byteorder->swap64(shdr.sh_addr);
+        sect->offset = image->byteorder->swap64(shdr.sh_offset);
+        sect->size = image->byteorder->swap64(shdr.sh_size);
+        sect->link = image->byteorder->swap32(shdr.sh_link);
+        sect->entsize = image->byteorder->swap64(shdr.sh_entsize);
+    } else {
+        struct pl_elf32_shdr shdr;
+        if ((err = plcrash_async_task_memcpy(image->task, addr, 0, &shdr, sizeof(shdr))) != PLCRASH_ESUCCESS) {
+            PLCF_DEBUG("Failed to read section header %" PRIu16 " in: %s", index, image->name);
+            return err;
+        }
+
+        sect->name = image->byteorder->swap32(shdr.sh_name);
+        sect->type = image->byteorder->swap32(shdr.sh_type);
+        sect->flags = image->byteorder->swap32(shdr.sh_flags);
+        sect->addr = image->byteorder->swap32(shdr.sh_addr);
+        sect->offset = image->byteorder->swap32(shdr.sh_offset);
+        sect->size = image->byteorder->swap32(shdr.sh_size);
+        sect->link = image->byteorder->swap32(shdr.sh_link);
+        sect->entsize = image->byteorder->swap32(shdr.sh_entsize);
+    }
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * @internal
+ * Return the task address of @a sect's data. Allocated sections are resolved via their slid virtual address;
+ * all other sections are resolved via their file offset.
+ *
+ * @return Returns false if the address would overflow.
+ */
+static bool plcrash_async_elf_section_address (plcrash_async_elf_t *image, pl_async_elf_section_t *sect, pl_vm_address_t *result) {
+    if (sect->flags & PL_ELF_SHF_ALLOC) {
+        *result = (pl_vm_address_t) (sect->addr + image->vmaddr_slide);
+        return true;
+    }
+
+    return plcrash_async_elf_file_address(image, sect->offset, result);
+}
+
+/**
+ * Initialize a new ELF binary image parser.
+ *
+ * @param image The image structure to be initialized.
+ * @param task The task in which the image is mapped.
+ * @param name The file name or path for the ELF image.
+ * @param header The task-local address of the image's ELF header.
+ *
+ * @return PLCRASH_ESUCCESS on success. PLCRASH_EINVAL will be returned if the ELF file can not be parsed,
+ * or PLCRASH_EINTERNAL if an error occurs reading from the target task.
+ *
+ * @warning This method is not async safe.
+ */
+plcrash_error_t plcrash_nasync_elf_init (plcrash_async_elf_t *image, mach_port_t task, const char *name, pl_vm_address_t header) {
+    uint8_t ident[PL_ELF_EI_NIDENT];
+    plcrash_error_t ret;
+
+    /* Basic initialization */
+    image->task = task;
+    image->header_addr = header;
+    image->name = strdup(name);
+
+    plcrash_async_task_retain(image->task);
+
+    /* Read and validate the identification bytes */
+    if ((ret = plcrash_async_task_memcpy(image->task, image->header_addr, 0, ident, sizeof(ident))) != PLCRASH_ESUCCESS) {
+        PLCF_DEBUG("Failed to read ELF header from 0x%" PRIx64 " for image %s, ret=%d", (uint64_t) image->header_addr, name, ret);
+        ret = PLCRASH_EINTERNAL;
+        goto error;
+    }
+
+    if (ident[0] != 0x7F || ident[1] != 'E' || ident[2] != 'L' || ident[3] != 'F') {
+        PLCF_DEBUG("Unknown ELF magic in: %s", image->name);
+        ret = PLCRASH_EINVAL;
+        goto error;
+    }
+
+    switch (ident[PL_ELF_EI_DATA]) {
+        case PL_ELF_DATA2LSB:
+            image->byteorder = plcrash_async_byteorder_little_endian();
+            break;
+
+        case PL_ELF_DATA2MSB:
+            image->byteorder = plcrash_async_byteorder_big_endian();
+            break;
+
+        default:
+            PLCF_DEBUG("Unknown ELF data encoding 0x%" PRIx8 " in: %s", ident[PL_ELF_EI_DATA], image->name);
+            ret = PLCRASH_EINVAL;
+            goto error;
+    }
+
+    /* Read in the remainder of the header */
+    switch (ident[PL_ELF_EI_CLASS]) {
+        case PL_ELF_CLASS32: {
+            struct pl_elf32_ehdr ehdr;
+            if ((ret = plcrash_async_task_memcpy(image->task, image->header_addr, 0, &ehdr, sizeof(ehdr))) != PLCRASH_ESUCCESS) {
+                PLCF_DEBUG("Failed to read ELF header for image %s, ret=%d", name, ret);
+                ret = PLCRASH_EINTERNAL;
+                goto error;
+            }
+
+            image->m64 = false;
+            image->machine = image->byteorder->swap16(ehdr.e_machine);
+            image->phoff = image->byteorder->swap32(ehdr.e_phoff);
+            image->phentsize = image->byteorder->swap16(ehdr.e_phentsize);
+            image->phnum = image->byteorder->swap16(ehdr.e_phnum);
+            image->shoff = image->byteorder->swap32(ehdr.e_shoff);
+            image->shentsize = image->byteorder->swap16(ehdr.e_shentsize);
+            image->shnum = image->byteorder->swap16(ehdr.e_shnum);
+            image->shstrndx = image->byteorder->swap16(ehdr.e_shstrndx);
+            break;
+        }
+
+        case PL_ELF_CLASS64: {
+            struct pl_elf64_ehdr ehdr;
+            if ((ret = plcrash_async_task_memcpy(image->task, image->header_addr, 0, &ehdr, sizeof(ehdr))) != PLCRASH_ESUCCESS) {
+                PLCF_DEBUG("Failed to read ELF header for image %s, ret=%d", name, ret);
+                ret = PLCRASH_EINTERNAL;
+                goto error;
+            }
+
+            image->m64 = true;
+            image->machine = image->byteorder->swap16(ehdr.e_machine);
+            image->phoff = image->byteorder->swap64(ehdr.e_phoff);
+            image->phentsize = image->byteorder->swap16(ehdr.e_phentsize);
+            image->phnum = image->byteorder->swap16(ehdr.e_phnum);
+            image->shoff = image->byteorder->swap64(ehdr.e_shoff);
+            image->shentsize = image->byteorder->swap16(ehdr.e_shentsize);
+            image->shnum = image->byteorder->swap16(ehdr.e_shnum);
+            image->shstrndx = image->byteorder->swap16(ehdr.e_shstrndx);
+            break;
+        }
+
+        default:
+            PLCF_DEBUG("Unknown ELF class 0x%" PRIx8 " in: %s", ident[PL_ELF_EI_CLASS], image->name);
+            ret = PLCRASH_EINVAL;
+            goto error;
+    }
+
+    /* Validate the table entry sizes; these may be larger than our structures, but never smaller */
+    if (image->phnum > 0 && image->phentsize < (image->m64 ? sizeof(struct pl_elf64_phdr) : sizeof(struct pl_elf32_phdr))) {
+        PLCF_DEBUG("Invalid program header entry size %" PRIu16 " in: %s", image->phentsize, image->name);
+        ret = PLCRASH_EINVAL;
+        goto error;
+    }
+
+    if (image->shnum > 0 && image->shentsize < (image->m64 ? sizeof(struct pl_elf64_shdr) : sizeof(struct pl_elf32_shdr))) {
+        PLCF_DEBUG("Invalid section header entry size %" PRIu16 " in: %s", image->shentsize, image->name);
+        ret = PLCRASH_EINVAL;
+        goto error;
+    }
+
+    /* Compute the vmaddr slide from the PT_LOAD segment that maps the ELF header */
+    {
+        bool found_load_seg = false;
+        for (uint16_t i = 0; i < image->phnum; i++) {
+            pl_async_elf_segment_t seg;
+            if ((ret = plcrash_async_elf_read_segment(image, i, &seg)) != PLCRASH_ESUCCESS)
+                goto error;
+
+            if (seg.type != PL_ELF_PT_LOAD || seg.offset != 0)
+                continue;
+
+            image->vmaddr_slide = (pl_vm_off_t) (image->header_addr - seg.vaddr);
+            found_load_seg = true;
+            break;
+        }
+
+        if (!found_load_seg) {
+            PLCF_DEBUG("Could not find a PT_LOAD segment containing the ELF header in: %s", image->name);
+            ret = PLCRASH_EINVAL;
+            goto error;
+        }
+    }
+
+    return PLCRASH_ESUCCESS;
+
+error:
+    if (image->name != NULL)
+        free(image->name);
+
+    plcrash_async_task_release(image->task);
+
+    return ret;
+}
+
+/**
+ * Return a borrowed reference to the byte order functions to use when parsing data from
+ * @a image.
+ *
+ * @param image The image from which the byte order functions should be returned.
+ */
+const plcrash_async_byteorder_t *plcrash_async_elf_byteorder (plcrash_async_elf_t *image) {
+    return image->byteorder;
+}
+
+/**
+ * @internal
+ * Find the section named @a sectname.
+ *
+ * @param image The ELF image to search.
+ * @param sectname The section name (eg, ".eh_frame").
+ * @param sect On success, will be initialized with the section header's values.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, PLCRASH_ENOTFOUND if the section is not found or the image has no
+ * section header table, or another plcrash_error_t if the section header table can not be read.
+ */
+static plcrash_error_t plcrash_async_elf_find_section (plcrash_async_elf_t *image, const char *sectname, pl_async_elf_section_t *sect) {
+    pl_async_elf_section_t strtab;
+    pl_vm_address_t strtab_addr;
+    plcrash_error_t err;
+
+    if (image->shoff == 0 || image->shstrndx == PL_ELF_SHN_UNDEF || image->shstrndx >= image->shnum)
+        return PLCRASH_ENOTFOUND;
+
+    /* Fetch the section name table */
+    if ((err = plcrash_async_elf_read_section(image, image->shstrndx, &strtab)) != PLCRASH_ESUCCESS)
+        return err;
+
+    if (!plcrash_async_elf_section_address(image, &strtab, &strtab_addr)) {
+        PLCF_DEBUG("Section name table address overflows in: %s", image->name);
+        return PLCRASH_EINVAL;
+    }
+
+    /* Determine the length of the name we're searching for, including the trailing NUL */
+    size_t namelen = 0;
+    while (sectname[namelen] != '\0')
+        namelen++;
+    namelen++;
+
+    for (uint16_t i = 0; i < image->shnum; i++) {
+        char name[32];
+
+        if ((err = plcrash_async_elf_read_section(image, i, sect)) != PLCRASH_ESUCCESS)
+            return err;
+
+        /* Skip names that can not possibly match */
+        if (namelen > sizeof(name) || sect->name >= strtab.size || strtab.size - sect->name < namelen)
+            continue;
+
+        if (plcrash_async_task_memcpy(image->task, strtab_addr, sect->name, name, namelen) != PLCRASH_ESUCCESS) {
+            PLCF_DEBUG("Failed to read section name for section %" PRIu16 " in: %s", i, image->name);
+            return PLCRASH_EINVAL;
+        }
+
+        if (plcrash_async_strncmp(sectname, name, namelen) == 0)
+            return PLCRASH_ESUCCESS;
+    }
+
+    return PLCRASH_ENOTFOUND;
+}
+
+/**
+ * Map the section named @a sectname into a memory object.
+ *
+ * The section header table is not loaded by the runtime loader; this function may only be used if the image's
+ * complete file contents are mapped at the ELF header address. Use plcrash_async_elf_map_eh_frame_hdr() and
+ * plcrash_async_elf_map_eh_frame() to locate the unwind data within loaded images.
+ *
+ * @param image The image to search for @a sectname.
+ * @param sectname The section name (eg, ".debug_frame").
+ * @param mobj The mobject to be initialized with a mapping of the section's data. It is the caller's responsibility to dealloc
+ * @a mobj after a successful initialization.
+ *
+ * @return On success, returns PLCRASH_ESUCCESS. On failure, one of the plcrash_error_t error values will be returned, and no
+ * mapping will be performed. PLCRASH_ENOTFOUND will be returned if the section is not found.
+ */
+plcrash_error_t plcrash_async_elf_map_section (plcrash_async_elf_t *image, const char *sectname, plcrash_async_mobject_t *mobj) {
+    pl_async_elf_section_t sect;
+    pl_vm_address_t sectaddr;
+    plcrash_error_t err;
+
+    if ((err = plcrash_async_elf_find_section(image, sectname, &sect)) != PLCRASH_ESUCCESS)
+        return err;
+
+    if (!plcrash_async_elf_section_address(image, &sect, &sectaddr)) {
+        PLCF_DEBUG("Section %s address overflows in: %s", sectname, image->name);
+        return PLCRASH_EINVAL;
+    }
+
+    return plcrash_async_mobject_init(mobj, image->task, sectaddr, sect.size, true);
+}
+
+/**
+ * Map the .eh_frame_hdr section, as referenced by the image's PT_GNU_EH_FRAME program header.
+ *
+ * @param image The image to search.
+ * @param mobj The mobject to be initialized with a mapping of the section's data. It is the caller's responsibility to dealloc
+ * @a mobj after a successful initialization.
+ *
+ * @return On success, returns PLCRASH_ESUCCESS. On failure, one of the plcrash_error_t error values will be returned, and no
+ * mapping will be performed. PLCRASH_ENOTFOUND will be returned if the image has no PT_GNU_EH_FRAME program header.
+ */
+plcrash_error_t plcrash_async_elf_map_eh_frame_hdr (plcrash_async_elf_t *image, plcrash_async_mobject_t *mobj) {
+    plcrash_error_t err;
+
+    for (uint16_t i = 0; i < image->phnum; i++) {
+        pl_async_elf_segment_t seg;
+        if ((err = plcrash_async_elf_read_segment(image, i, &seg)) != PLCRASH_ESUCCESS)
+            return err;
+
+        if (seg.type != PL_ELF_PT_GNU_EH_FRAME)
+            continue;
+
+        return plcrash_async_mobject_init(mobj, image->task, (pl_vm_address_t) (seg.vaddr + image->vmaddr_slide), seg.memsz, true);
+    }
+
+    return PLCRASH_ENOTFOUND;
+}
+
+/**
+ * @internal
+ * Read a DW_EH_PE encoded pointer from @a mobj, as used within .eh_frame_hdr. Only the absolute, pc-relative, and
+ * data-relative encodings are supported.
+ *
+ * @param image The image from which @a mobj was mapped.
+ * @param mobj The memory object from which the pointer will be read.
+ * @param address The target-relative address of the encoded pointer.
+ * @param encoding The DW_EH_PE pointer encoding.
+ * @param data_base The base address to be used for DW_EH_PE_datarel pointers.
+ * @param result On success, the decoded pointer value.
+ * @param size On success, the number of bytes consumed.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, PLCRASH_ENOTFOUND if the value is DW_EH_PE_omit, PLCRASH_ENOTSUP
+ * if the encoding is unsupported, or PLCRASH_EINVAL if the value can not be read.
+ */
+static plcrash_error_t plcrash_async_elf_read_eh_ptr (plcrash_async_elf_t *image,
+                                                      plcrash_async_mobject_t *mobj,
+                                                      pl_vm_address_t address,
+                                                      uint8_t encoding,
+                                                      pl_vm_address_t data_base,
+                                                      pl_vm_address_t *result,
+                                                      pl_vm_size_t *size)
+{
+    const plcrash_async_byteorder_t *byteorder = image->byteorder;
+    uint64_t value;
+
+    if (encoding == PL_ELF_DW_EH_PE_omit)
+        return PLCRASH_ENOTFOUND;
+
+    /* Read the value */
+    switch (encoding & 0x0F) {
+        case PL_ELF_DW_EH_PE_absptr:
+            if (image->m64) {
+                if (plcrash_async_mobject_read_uint64(mobj, byteorder, address, 0, &value) != PLCRASH_ESUCCESS)
+                    return PLCRASH_EINVAL;
+                *size = 8;
+            } else {
+                uint32_t v32;
+                if (plcrash_async_mobject_read_uint32(mobj, byteorder, address, 0, &v32) != PLCRASH_ESUCCESS)
+                    return PLCRASH_EINVAL;
+                value = v32;
+                *size = 4;
+            }
+            break;
+
+        case PL_ELF_DW_EH_PE_udata2:
+        case PL_ELF_DW_EH_PE_sdata2: {
+            uint16_t v16;
+            if (plcrash_async_mobject_read_uint16(mobj, byteorder, address, 0, &v16) != PLCRASH_ESUCCESS)
+                return PLCRASH_EINVAL;
+            value = ((encoding & 0x0F) == PL_ELF_DW_EH_PE_sdata2) ? (uint64_t) (int64_t) (int16_t) v16 : v16;
+            *size = 2;
+            break;
+        }
+
+        case PL_ELF_DW_EH_PE_udata4:
+        case PL_ELF_DW_EH_PE_sdata4: {
+            uint32_t v32;
+            if (plcrash_async_mobject_read_uint32(mobj, byteorder, address, 0, &v32) != PLCRASH_ESUCCESS)
+                return PLCRASH_EINVAL;
+            value = ((encoding & 0x0F) == PL_ELF_DW_EH_PE_sdata4) ? (uint64_t) (int64_t) (int32_t) v32 : v32;
+            *size = 4;
+            break;
+        }
+
+        case PL_ELF_DW_EH_PE_udata8:
+        case PL_ELF_DW_EH_PE_sdata8:
+            if (plcrash_async_mobject_read_uint64(mobj, byteorder, address, 0, &value) != PLCRASH_ESUCCESS)
+                return PLCRASH_EINVAL;
+            *size = 8;
+            break;
+
+        default:
+            PLCF_DEBUG("Unsupported .eh_frame_hdr pointer format 0x%" PRIx8, encoding);
+            return PLCRASH_ENOTSUP;
+    }
+
+    /* Apply the relative base, if any */
+    switch (encoding & 0x70) {
+        case PL_ELF_DW_EH_PE_absptr:
+            break;
+
+        case PL_ELF_DW_EH_PE_pcrel:
+            value += address;
+            break;
+
+        case PL_ELF_DW_EH_PE_datarel:
+            value += data_base;
+            break;
+
+        default:
+            PLCF_DEBUG("Unsupported .eh_frame_hdr pointer application 0x%" PRIx8, encoding);
+            return PLCRASH_ENOTSUP;
+    }
+
+    /* Indirect pointers are not used by .eh_frame_hdr */
+    if (encoding & 0x80) {
+        PLCF_DEBUG("Unsupported indirect .eh_frame_hdr pointer 0x%" PRIx8, encoding);
+        return PLCRASH_ENOTSUP;
+    }
+
+    *result = (pl_vm_address_t) value;
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Map the .eh_frame section. If the image provides a PT_GNU_EH_FRAME program header, the section is located via
+ * the .eh_frame_hdr eh_frame_ptr, and the mapping extends to the end of the containing PT_LOAD segment; the DWARF
+ * frame reader will stop at the section's zero terminator. Otherwise, the section is located via the section
+ * header table.
+ *
+ * @param image The image to search.
+ * @param mobj The mobject to be initialized with a mapping of the section's data. It is the caller's responsibility to dealloc
+ * @a mobj after a successful initialization.
+ *
+ * @return On success, returns PLCRASH_ESUCCESS. On failure, one of the plcrash_error_t error values will be returned, and no
+ * mapping will be performed. PLCRASH_ENOTFOUND will be returned if the section can not be found.
+ */
+plcrash_error_t plcrash_async_elf_map_eh_frame (plcrash_async_elf_t *image, plcrash_async_mobject_t *mobj) {
+    plcrash_async_mobject_t hdr;
+    pl_vm_address_t hdr_addr;
+    pl_vm_address_t eh_frame_addr;
+    pl_vm_size_t ptr_size;
+    uint8_t version;
+    uint8_t eh_frame_ptr_enc;
+    plcrash_error_t err;
+
+    /* Fall back on the section header table if there's no PT_GNU_EH_FRAME header */
+    if ((err = plcrash_async_elf_map_eh_frame_hdr(image, &hdr)) != PLCRASH_ESUCCESS)
+        return plcrash_async_elf_map_section(image, ".eh_frame", mobj);
+
+    hdr_addr = plcrash_async_mobject_base_address(&hdr);
+
+    /* Fetch the eh_frame_ptr */
+    if ((err = plcrash_async_mobject_read_uint8(&hdr, hdr_addr, 0, &version)) != PLCRASH_ESUCCESS ||
+        (err = plcrash_async_mobject_read_uint8(&hdr, hdr_addr, 1, &eh_frame_ptr_enc)) != PLCRASH_ESUCCESS)
+    {
+        PLCF_DEBUG("Failed to read .eh_frame_hdr header in: %s", image->name);
+        plcrash_async_mobject_free(&hdr);
+        return PLCRASH_EINVAL;
+    }
+
+    if (version != 1) {
+        PLCF_DEBUG("Unsupported .eh_frame_hdr version %" PRIu8 " in: %s", version, image->name);
+        plcrash_async_mobject_free(&hdr);
+        return PLCRASH_ENOTSUP;
+    }
+
+    err = plcrash_async_elf_read_eh_ptr(image, &hdr, hdr_addr + 4, eh_frame_ptr_enc, hdr_addr, &eh_frame_addr, &ptr_size);
+    plcrash_async_mobject_free(&hdr);
+    if (err != PLCRASH_ESUCCESS) {
+        PLCF_DEBUG("Failed to read .eh_frame_hdr eh_frame_ptr in: %s", image->name);
+        return err;
+    }
+
+    /* Map through the end of the containing segment */
+    for (uint16_t i = 0; i < image->phnum; i++) {
+        pl_async_elf_segment_t seg;
+        if ((err = plcrash_async_elf_read_segment(image, i, &seg)) != PLCRASH_ESUCCESS)
+            return err;
+
+        if (seg.type != PL_ELF_PT_LOAD)
+            continue;
+
+        pl_vm_address_t seg_start = (pl_vm_address_t) (seg.vaddr + image->vmaddr_slide);
+        if (eh_frame_addr < seg_start || eh_frame_addr - seg_start >= seg.filesz)
+            continue;
+
+        return plcrash_async_mobject_init(mobj, image->task, eh_frame_addr, seg.filesz - (eh_frame_addr - seg_start), true);
+    }
+
+    PLCF_DEBUG("The .eh_frame_hdr eh_frame_ptr 0x%" PRIx64 " does not fall within a PT_LOAD segment in: %s", (uint64_t) eh_frame_addr, image->name);
+    return PLCRASH_EINVAL;
+}
+
+/**
+ * Use the .eh_frame_hdr binary search table to find the .eh_frame FDE that may contain @a pc. The returned
+ * offset may be supplied to plcrash::async::dwarf_frame_reader::find_fde() as its offset hint, replacing
+ * a linear scan of the .eh_frame section.
+ *
+ * The table only records each FDE's starting address; the caller must verify that the FDE's range includes @a pc.
+ *
+ * @param image The image from which @a eh_frame_hdr was mapped.
+ * @param eh_frame_hdr The mapped .eh_frame_hdr section.
+ * @param eh_frame_addr The task address of the .eh_frame section.
+ * @param pc The PC value to search for.
+ * @param fde_offset On success, the .eh_frame relative offset of the candidate FDE.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, PLCRASH_ENOTFOUND if no table entry precedes @a pc or the table is
+ * absent, PLCRASH_ENOTSUP if the table uses an encoding other than DW_EH_PE_datarel|DW_EH_PE_sdata4, or
+ * PLCRASH_EINVAL if the section can not be parsed.
+ */
+plcrash_error_t plcrash_async_elf_eh_frame_hdr_search (plcrash_async_elf_t *image,
+                                                      plcrash_async_mobject_t *eh_frame_hdr,
+                                                      pl_vm_address_t eh_frame_addr,
+                                                      pl_vm_address_t pc,
+                                                      pl_vm_off_t *fde_offset)
+{
+    const pl_vm_address_t hdr_addr = plcrash_async_mobject_base_address(eh_frame_hdr);
+    pl_vm_address_t cursor = hdr_addr;
+    pl_vm_address_t value;
+    pl_vm_size_t size;
+    uint8_t header[4];
+    plcrash_error_t err;
+
+    /* Read the version and encodings */
+    for (size_t i = 0; i < sizeof(header); i++) {
+        if (plcrash_async_mobject_read_uint8(eh_frame_hdr, hdr_addr, i, &header[i]) != PLCRASH_ESUCCESS) {
+            PLCF_DEBUG("Failed to read .eh_frame_hdr header in: %s", image->name);
+            return PLCRASH_EINVAL;
+        }
+    }
+    cursor += sizeof(header);
+
+    const uint8_t version = header[0];
+    const uint8_t eh_frame_ptr_enc = header[1];
+    const uint8_t fde_count_enc = header[2];
+    const uint8_t table_enc = header[3];
+
+    if (version != 1) {
+        PLCF_DEBUG("Unsupported .eh_frame_hdr version %" PRIu8 " in: %s", version, image->name);
+        return PLCRASH_ENOTSUP;
+    }
+
+    /* Skip the eh_frame_ptr */
+    if ((err = plcrash_async_elf_read_eh_ptr(image, eh_frame_hdr, cursor, eh_frame_ptr_enc, hdr_addr, &value, &size)) != PLCRASH_ESUCCESS)
+        return err;
+    cursor += size;
+
+    /* Fetch the table entry count */
+    pl_vm_address_t fde_count;
+    if ((err = plcrash_async_elf_read_eh_ptr(image, eh_frame_hdr, cursor, fde_count_enc, hdr_addr, &fde_count, &size)) != PLCRASH_ESUCCESS)
+        return err;
+    cursor += size;
+
+    /* Only fixed-size table entries are searchable. In practice, this is the only encoding emitted by the toolchains. */
+    if (table_enc != (PL_ELF_DW_EH_PE_datarel | PL_ELF_DW_EH_PE_sdata4)) {
+        PLCF_DEBUG("Unsupported .eh_frame_hdr table encoding 0x%" PRIx8 " in: %s", table_enc, image->name);
+        return PLCRASH_ENOTSUP;
+    }
+
+    /* Each entry is an (initial_location, fde_address) pair */
+    const pl_vm_size_t entry_size = 8;
+    if (fde_count == 0)
+        return PLCRASH_ENOTFOUND;
+
+    if (fde_count > (plcrash_async_mobject_length(eh_frame_hdr) - (cursor - hdr_addr)) / entry_size) {
+        PLCF_DEBUG("The .eh_frame_hdr table extends beyond the section in: %s", image->name);
+        return PLCRASH_EINVAL;
+    }
+
+    /* Find the last entry with an initial location <= pc */
+    pl_vm_address_t low = 0;
+    pl_vm_address_t high = fde_count;
+    while (low < high) {
+        pl_vm_address_t mid = low + (high - low) / 2;
+        pl_vm_address_t initial_loc;
+
+        if ((err = plcrash_async_elf_read_eh_ptr(image, eh_frame_hdr, cursor + (mid * entry_size), table_enc, hdr_addr, &initial_loc, &size)) != PLCRASH_ESUCCESS)
+            return err;
+
+        if (initial_loc <= pc) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    if (low == 0)
+        return PLCRASH_ENOTFOUND;
+
+    /* Fetch the FDE address */
+    pl_vm_address_t fde_addr;
+    if ((err = plcrash_async_elf_read_eh_ptr(image, eh_frame_hdr, cursor + ((low - 1) * entry_size) + 4, table_enc, hdr_addr, &fde_addr, &size)) != PLCRASH_ESUCCESS)
+        return err;
+
+    if (fde_addr < eh_frame_addr) {
+        PLCF_DEBUG("The .eh_frame_hdr FDE address 0x%" PRIx64 " precedes the .eh_frame section in: %s", (uint64_t) fde_addr, image->name);
+        return PLCRASH_EINVAL;
+    }
+
+    *fde_offset = (pl_vm_off_t) (fde_addr - eh_frame_addr);
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Attempt to locate a symbol address for @a symbol name within @a image. The .dynsym and .symtab tables are
+ * searched via the section header table; as such, this function may only be used if the image's complete
+ * file contents are mapped at the ELF header address.
+ *
+ * @param image The ELF image to search for @a symbol
+ * @param symbol The symbol name to search for.
+ * @param pc On success, will be set to the slid address of the symbol.
+ *
+ * @return Returns PLCRASH_ESUCCESS if the symbol is found, or PLCRASH_ENOTFOUND if not found. If the symbol is not
+ * found, the contents of @a pc are undefined.
+ */
+plcrash_error_t plcrash_async_elf_find_symbol_by_name (plcrash_async_elf_t *image, const char *symbol, pl_vm_address_t *pc) {
+    const size_t sym_size = image->m64 ? sizeof(struct pl_elf64_sym) : sizeof(struct pl_elf32_sym);
+    plcrash_error_t err;
+
+    if (image->shoff == 0)
+        return PLCRASH_ENOTFOUND;
+
+    /* Determine the length of the symbol name, including the trailing NUL */
+    size_t namelen = 0;
+    while (symbol[namelen] != '\0')
+        namelen++;
+    namelen++;
+
+    for (uint16_t i = 0; i < image->shnum; i++) {
+        pl_async_elf_section_t symtab;
+        pl_async_elf_section_t strtab;
+        pl_vm_address_t symtab_addr;
+        pl_vm_address_t strtab_addr;
+
+        if ((err = plcrash_async_elf_read_section(image, i, &symtab)) != PLCRASH_ESUCCESS)
+            return err;
+
+        if (symtab.type != PL_ELF_SHT_SYMTAB && symtab.type != PL_ELF_SHT_DYNSYM)
+            continue;
+
+        /* Fetch the associated string table */
+        if (symtab.link >= image->shnum || (err = plcrash_async_elf_read_section(image, symtab.link, &strtab)) != PLCRASH_ESUCCESS) {
+            PLCF_DEBUG("Invalid symbol table string table index %" PRIu32 " in: %s", symtab.link, image->name);
+            continue;
+        }
+
+        if (!plcrash_async_elf_section_address(image, &symtab, &symtab_addr) || !plcrash_async_elf_section_address(image, &strtab, &strtab_addr))
+            continue;
+
+        uint64_t entsize = symtab.entsize >= sym_size ? symtab.entsize : sym_size;
+
+        /* Map the tables */
+        plcrash_async_mobject_t symtab_mobj;
+        plcrash_async_mobject_t strtab_mobj;
+
+        if (plcrash_async_mobject_init(&symtab_mobj, image->task, symtab_addr, symtab.size, true) != PLCRASH_ESUCCESS)
+            continue;
+
+        if (plcrash_async_mobject_init(&strtab_mobj, image->task, strtab_addr, strtab.size, true) != PLCRASH_ESUCCESS) {
+            plcrash_async_mobject_free(&symtab_mobj);
+            continue;
+        }
+
+        /* Search the table */
+        err = PLCRASH_ENOTFOUND;
+        for (uint64_t n = 0; n < symtab.size / entsize; n++) {
+            void *entry = plcrash_async_mobject_remap_address(&symtab_mobj, symtab_addr, n * entsize, sym_size);
+            uint32_t st_name;
+            uint16_t st_shndx;
+            uint64_t st_value;
+
+            if (entry == NULL)
+                break;
+
+            if (image->m64) {
+                struct pl_elf64_sym *sym = entry;
+                st_name = image->byteorder->swap32(sym->st_name);
+                st_shndx = image->byteorder->swap16(sym->st_shndx);
+                st_value = image->byteorder->swap64(sym->st_value);
+            } else {
+                struct pl_elf32_sym *sym = entry;
+                st_name = image->byteorder->swap32(sym->st_name);
+                st_shndx = image->byteorder->swap16(sym->st_shndx);
+                st_value = image->byteorder->swap32(sym->st_value);
+            }
+
+            /* Skip undefined symbols */
+            if (st_shndx == PL_ELF_SHN_UNDEF)
+                continue;
+
+            const char *name = plcrash_async_mobject_remap_address(&strtab_mobj, strtab_addr, st_name, namelen);
+            if (name == NULL)
+                continue;
+
+            if (plcrash_async_strncmp(symbol, name, namelen) == 0) {
+                *pc = (pl_vm_address_t) (st_value + image->vmaddr_slide);
+                err = PLCRASH_ESUCCESS;
+                break;
+            }
+        }
+
+        plcrash_async_mobject_free(&symtab_mobj);
+        plcrash_async_mobject_free(&strtab_mobj);
+
+        if (err == PLCRASH_ESUCCESS)
+            return err;
+    }
+
+    return PLCRASH_ENOTFOUND;
+}
+
+/**
+ * Free all ELF image resources.
+ *
+ * @warning This method is not async safe.
+ */
+void plcrash_nasync_elf_free (plcrash_async_elf_t *image) {
+    if (image->name != NULL)
+        free(image->name);
+
+    plcrash_async_task_release(image->task);
+}
+
+/**
+ * @}
+ */
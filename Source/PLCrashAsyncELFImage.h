@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PLCRASH_ASYNC_ELF_IMAGE_H
+#define PLCRASH_ASYNC_ELF_IMAGE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "PLCrashAsyncMObject.h"
+
+/**
+ * @internal
+ * @ingroup plcrash_async_image
+ * @{
+ */
+
+/**
+ * @internal
+ *
+ * An ELF image instance.
+ *
+ * ELF images are resolved relative to the address of their ELF header. Allocated (SHF_ALLOC) sections and
+ * program segments are located via their link-time virtual addresses and the computed vmaddr slide, as they would be
+ * in a loaded image. The section header table and non-allocated sections (eg, .debug_frame) are not mapped by the
+ * runtime loader, and are located via their file offsets; these are only available if the image's complete file
+ * contents are mapped at the header address.
+ */
+typedef struct plcrash_async_elf {
+    /** The Mach task in which the ELF image can be found */
+    mach_port_t task;
+
+    /** The binary image's header address. */
+    pl_vm_address_t header_addr;
+
+    /** The vmaddr slide, computed from the address of the PT_LOAD segment containing the ELF header. */
+    pl_vm_off_t vmaddr_slide;
+
+    /** The binary image's name/path. */
+    char *name;
+
+    /** If true, the image is an ELFCLASS64 image. If false, it is an ELFCLASS32 image. */
+    bool m64;
+
+    /** The byte order functions to use for this image */
+    const plcrash_async_byteorder_t *byteorder;
+
+    /** The ELF machine type (e_machine), in host byte order. */
+    uint16_t machine;
+
+    /** Offset of the program header table from the ELF header. */
+    uint64_t phoff;
+
+    /** Size of a single program header table entry. */
+    uint16_t phentsize;
+
+    /** Number of program header table entries. */
+    uint16_t phnum;
+
+    /** Offset of the section header table from the ELF header, or 0 if the image has no section header table. */
+    uint64_t shoff;
+
+    /** Size of a single section header table entry. */
+    uint16_t shentsize;
+
+    /** Number of section header table entries. */
+    uint16_t shnum;
+
+    /** Section header table index of the section name string table. */
+    uint16_t shstrndx;
+} plcrash_async_elf_t;
+
+plcrash_error_t plcrash_nasync_elf_init (plcrash_async_elf_t *image, mach_port_t task, const char *name, pl_vm_address_t header);
+
+const plcrash_async_byteorder_t *plcrash_async_elf_byteorder (plcrash_async_elf_t *image);
+
+plcrash_error_t plcrash_async_elf_map_section (plcrash_async_elf_t *image, const char *sectname, plcrash_async_mobject_t *mobj);
+plcrash_error_t plcrash_async_elf_map_eh_frame_hdr (plcrash_async_elf_t *image, plcrash_async_mobject_t *mobj);
+plcrash_error_t plcrash_async_elf_map_eh_frame (plcrash_async_elf_t *image, plcrash_async_mobject_t *mobj);
+
+plcrash_error_t plcrash_async_elf_eh_frame_hdr_search (plcrash_async_elf_t *image,
+                                                      plcrash_async_mobject_t *eh_frame_hdr,
+                                                      pl_vm_address_t eh_frame_addr,
+                                                      pl_vm_address_t pc,
+                                                      pl_vm_off_t *fde_offset);
+
+plcrash_error_t plcrash_async_elf_find_symbol_by_name (plcrash_async_elf_t *image, const char *symbol, pl_vm_address_t *pc);
+
+void plcrash_nasync_elf_free (plcrash_async_elf_t *image);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLCRASH_ASYNC_ELF_IMAGE_H */
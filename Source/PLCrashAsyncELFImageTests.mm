@@ -0,0 +1,338 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "PLCrashTestCase.h"
+
+#include "PLCrashAsyncELFImage.h"
+
+#include "PLCrashAsyncDwarfEncoding.hpp"
+#include "PLCrashAsyncDwarfCIE.hpp"
+#include "PLCrashAsyncDwarfCFAState.hpp"
+
+#include "PLCrashFeatureConfig.h"
+
+using namespace plcrash::async;
+
+/* ELF e_machine values */
+#define EM_386      3
+#define EM_X86_64   62
+
+/* DWARF register numbers used by the test fixtures */
+#define DW_X86_64_RBX   3
+#define DW_X86_64_RBP   6
+#define DW_X86_64_RSP   7
+#define DW_X86_64_R12   12
+#define DW_X86_64_R13   13
+
+#define DW_X86_EBX      3
+#define DW_X86_ESP      4
+#define DW_X86_EBP      5
+#define DW_X86_ESI      6
+#define DW_X86_EDI      7
+
+/**
+ * An expected CFA register rule (CFA = register + offset) and two saved register rules
+ * (register saved at CFA + offset), as emitted by the .cfi directives in test.S.
+ */
+struct elf_cfi_expected {
+    /** Function symbol name */
+    const char *function;
+
+    /** Symbol name of the label at which the rules are evaluated */
+    const char *body;
+
+    dwarf_cfa_state_regnum_t cfa_reg;
+    uint64_t cfa_offset;
+
+    dwarf_cfa_state_regnum_t saved_reg1;
+    int64_t saved_offset1;
+
+    dwarf_cfa_state_regnum_t saved_reg2;
+    int64_t saved_offset2;
+};
+
+@interface PLCrashAsyncELFImageTests : PLCrashTestCase {
+    /** The mapped x86-64 test image */
+    NSData *_data;
+
+    /** The parsed x86-64 test image */
+    plcrash_async_elf_t _image;
+}
+@end
+
+@implementation PLCrashAsyncELFImageTests
+
+- (void) setUp {
+    _data = [self dataForTestResource: @"test.x86_64"];
+    STAssertNotNil(_data, @"Failed to load test image");
+
+    plcrash_error_t err = plcrash_nasync_elf_init(&_image, mach_task_self(), "test.x86_64", (pl_vm_address_t) [_data bytes]);
+    STAssertEquals(err, PLCRASH_ESUCCESS, @"Failed to initialize ELF parser");
+}
+
+- (void) tearDown {
+    plcrash_nasync_elf_free(&_image);
+    _data = nil;
+}
+
+/**
+ * Verify header parsing.
+ */
+- (void) testParseHeader {
+    STAssertTrue(_image.m64, @"Image should be ELFCLASS64");
+    STAssertEquals(_image.machine, (uint16_t) EM_X86_64, @"Incorrect machine type");
+    STAssertEquals(plcrash_async_elf_byteorder(&_image), plcrash_async_byteorder_little_endian(), @"Incorrect byte order");
+
+    /* The fixture is a shared object linked at 0x0 */
+    STAssertEquals(_image.vmaddr_slide, (pl_vm_off_t) [_data bytes], @"Incorrect vmaddr slide");
+}
+
+/**
+ * Verify that non-ELF data is rejected.
+ */
+- (void) testRejectInvalidImage {
+    plcrash_async_elf_t image;
+    const uint8_t bad_header[64] = { 0x7F, 'E', 'L', 'X' };
+
+    STAssertEquals(plcrash_nasync_elf_init(&image, mach_task_self(), "invalid", (pl_vm_address_t) bad_header), PLCRASH_EINVAL, @"Invalid image was accepted");
+}
+
+/**
+ * Verify mapping of the DWARF sections.
+ */
+- (void) testMapSections {
+    plcrash_async_mobject_t eh_frame;
+    plcrash_async_mobject_t eh_frame_sect;
+    plcrash_async_mobject_t mobj;
+
+    /* The program header-derived .eh_frame must match the section header table */
+    STAssertEquals(plcrash_async_elf_map_eh_frame(&_image, &eh_frame), PLCRASH_ESUCCESS, @"Failed to map .eh_frame");
+    STAssertEquals(plcrash_async_elf_map_section(&_image, ".eh_frame", &eh_frame_sect), PLCRASH_ESUCCESS, @"Failed to map .eh_frame section");
+    STAssertEquals(plcrash_async_mobject_base_address(&eh_frame), plcrash_async_mobject_base_address(&eh_frame_sect), @"Incorrect .eh_frame address");
+    STAssertTrue(plcrash_async_mobject_length(&eh_frame) >= plcrash_async_mobject_length(&eh_frame_sect), @"Short .eh_frame mapping");
+    plcrash_async_mobject_free(&eh_frame);
+    plcrash_async_mobject_free(&eh_frame_sect);
+
+    STAssertEquals(plcrash_async_elf_map_eh_frame_hdr(&_image, &mobj), PLCRASH_ESUCCESS, @"Failed to map .eh_frame_hdr");
+    plcrash_async_mobject_free(&mobj);
+
+    STAssertEquals(plcrash_async_elf_map_section(&_image, ".debug_frame", &mobj), PLCRASH_ESUCCESS, @"Failed to map .debug_frame");
+    plcrash_async_mobject_free(&mobj);
+
+    STAssertEquals(plcrash_async_elf_map_section(&_image, ".pl_missing", &mobj), PLCRASH_ENOTFOUND, @"Missing section was found");
+}
+
+/**
+ * Verify symbol lookup.
+ */
+- (void) testFindSymbol {
+    pl_vm_address_t pc;
+
+    STAssertEquals(plcrash_async_elf_find_symbol_by_name(&_image, "pl_elf_test_frame", &pc), PLCRASH_ESUCCESS, @"Failed to find symbol");
+    STAssertEquals(pc, (pl_vm_address_t) [_data bytes] + 0x1000, @"Incorrect symbol address");
+
+    STAssertEquals(plcrash_async_elf_find_symbol_by_name(&_image, "pl_elf_test", &pc), PLCRASH_ENOTFOUND, @"Symbol prefix should not match");
+    STAssertEquals(plcrash_async_elf_find_symbol_by_name(&_image, "pl_elf_test_missing", &pc), PLCRASH_ENOTFOUND, @"Missing symbol was found");
+}
+
+/**
+ * Verify that the .eh_frame_hdr search table returns the FDE for each function.
+ */
+- (void) testEHFrameHdrSearch {
+    plcrash_async_mobject_t hdr;
+    plcrash_async_mobject_t eh_frame;
+    pl_vm_address_t fn;
+    pl_vm_off_t offset;
+
+    STAssertEquals(plcrash_async_elf_map_eh_frame_hdr(&_image, &hdr), PLCRASH_ESUCCESS, @"Failed to map .eh_frame_hdr");
+    STAssertEquals(plcrash_async_elf_map_eh_frame(&_image, &eh_frame), PLCRASH_ESUCCESS, @"Failed to map .eh_frame");
+    pl_vm_address_t eh_frame_addr = plcrash_async_mobject_base_address(&eh_frame);
+
+    dwarf_frame_reader reader;
+    STAssertEquals(reader.init(&eh_frame, _image.byteorder, _image.m64, false), PLCRASH_ESUCCESS, @"Failed to initialize reader");
+
+    const char *functions[] = { "pl_elf_test_frame", "pl_elf_test_frameless" };
+    for (size_t i = 0; i < sizeof(functions) / sizeof(functions[0]); i++) {
+        plcrash_async_dwarf_fde_info_t fde_info;
+
+        STAssertEquals(plcrash_async_elf_find_symbol_by_name(&_image, functions[i], &fn), PLCRASH_ESUCCESS, @"Failed to find %s", functions[i]);
+        STAssertEquals(plcrash_async_elf_eh_frame_hdr_search(&_image, &hdr, eh_frame_addr, fn + 1, &offset), PLCRASH_ESUCCESS, @"Search failed for %s", functions[i]);
+
+        /* The search result must be the FDE found by a linear scan */
+        STAssertEquals(reader.find_fde(0x0, fn + 1, &fde_info), PLCRASH_ESUCCESS, @"FDE scan failed for %s", functions[i]);
+        STAssertEquals(fde_info.fde_offset, (pl_vm_address_t) offset + 4 /* 32-bit length field */, @"Incorrect FDE offset for %s", functions[i]);
+        plcrash_async_dwarf_fde_info_free(&fde_info);
+    }
+
+    /* Verify that a PC preceding all entries is not found */
+    STAssertEquals(plcrash_async_elf_find_symbol_by_name(&_image, "pl_elf_test_frame", &fn), PLCRASH_ESUCCESS, @"Failed to find symbol");
+    STAssertEquals(plcrash_async_elf_eh_frame_hdr_search(&_image, &hdr, eh_frame_addr, fn - 1, &offset), PLCRASH_ENOTFOUND, @"Search should have failed");
+
+    plcrash_async_mobject_free(&hdr);
+    plcrash_async_mobject_free(&eh_frame);
+}
+
+/**
+ * Evaluate the CFA program for @a expected->body within @a section, and verify that the resulting rules match
+ * the assembler-generated CFI.
+ *
+ * @param image The ELF image.
+ * @param section The mapped .eh_frame or .debug_frame section.
+ * @param debug_frame True if @a section is a .debug_frame section.
+ * @param expected The expected rules.
+ */
+template <typename machine_ptr, typename machine_ptr_s>
+static void verify_cfi_rules (PLCrashAsyncELFImageTests *self,
+                              plcrash_async_elf_t *image,
+                              plcrash_async_mobject_t *section,
+                              bool debug_frame,
+                              const struct elf_cfi_expected *expected)
+{
+    dwarf_frame_reader reader;
+    plcrash_async_dwarf_fde_info_t fde_info;
+    plcrash_async_dwarf_cie_info_t cie_info;
+    gnu_ehptr_reader<machine_ptr> ptr_state(image->byteorder);
+    dwarf_cfa_state<machine_ptr, machine_ptr_s> cfa_state;
+    pl_vm_address_t fn;
+    pl_vm_address_t pc;
+    plcrash_error_t err;
+
+    STAssertEquals(plcrash_async_elf_find_symbol_by_name(image, expected->function, &fn), PLCRASH_ESUCCESS, @"Failed to find %s", expected->function);
+    STAssertEquals(plcrash_async_elf_find_symbol_by_name(image, expected->body, &pc), PLCRASH_ESUCCESS, @"Failed to find %s", expected->body);
+
+    /* .debug_frame addresses are not relocated */
+    if (debug_frame) {
+        fn -= image->vmaddr_slide;
+        pc -= image->vmaddr_slide;
+    }
+
+    /* Find the FDE and CIE */
+    STAssertEquals(reader.init(section, image->byteorder, image->m64, debug_frame), PLCRASH_ESUCCESS, @"Failed to initialize reader");
+    err = reader.find_fde(0x0, pc, &fde_info);
+    STAssertEquals(err, PLCRASH_ESUCCESS, @"Failed to find FDE for %s", expected->body);
+    if (err != PLCRASH_ESUCCESS)
+        return;
+
+    STAssertEquals(fde_info.pc_start, (uint64_t) fn, @"Incorrect FDE start address for %s", expected->function);
+
+    err = plcrash_async_dwarf_cie_info_init(&cie_info, section, image->byteorder, &ptr_state, plcrash_async_mobject_base_address(section) + fde_info.cie_offset);
+    STAssertEquals(err, PLCRASH_ESUCCESS, @"Failed to parse CIE for %s", expected->function);
+    if (err != PLCRASH_ESUCCESS) {
+        plcrash_async_dwarf_fde_info_free(&fde_info);
+        return;
+    }
+
+    /* Evaluate the initial and FDE instructions */
+    err = cfa_state.eval_program(section, pc, fde_info.pc_start, &cie_info, &ptr_state, image->byteorder, plcrash_async_mobject_base_address(section), cie_info.initial_instructions_offset, cie_info.initial_instructions_length);
+    STAssertEquals(err, PLCRASH_ESUCCESS, @"Failed to evaluate CIE instructions");
+
+    err = cfa_state.eval_program(section, pc, fde_info.pc_start, &cie_info, &ptr_state, image->byteorder, plcrash_async_mobject_base_address(section), fde_info.instructions_offset, fde_info.instructions_length);
+    STAssertEquals(err, PLCRASH_ESUCCESS, @"Failed to evaluate FDE instructions");
+
+    /* Verify the CFA rule */
+    dwarf_cfa_rule<machine_ptr, machine_ptr_s> cfa_rule = cfa_state.get_cfa_rule();
+    STAssertEquals(cfa_rule.type(), DWARF_CFA_STATE_CFA_TYPE_REGISTER, @"Unexpected CFA rule type for %s", expected->body);
+    if (cfa_rule.type() == DWARF_CFA_STATE_CFA_TYPE_REGISTER) {
+        STAssertEquals(cfa_rule.register_number(), expected->cfa_reg, @"Incorrect CFA register for %s", expected->body);
+        STAssertEquals((uint64_t) cfa_rule.register_offset(), expected->cfa_offset, @"Incorrect CFA offset for %s", expected->body);
+    }
+
+    /* Verify the saved register rules */
+    plcrash_dwarf_cfa_reg_rule_t rule;
+    machine_ptr value;
+
+    STAssertTrue(cfa_state.get_register_rule(expected->saved_reg1, &rule, &value), @"Missing rule for register %u", expected->saved_reg1);
+    STAssertEquals(rule, PLCRASH_DWARF_CFA_REG_RULE_OFFSET, @"Incorrect rule type");
+    STAssertEquals((int64_t) (machine_ptr_s) value, expected->saved_offset1, @"Incorrect offset for register %u", expected->saved_reg1);
+
+    STAssertTrue(cfa_state.get_register_rule(expected->saved_reg2, &rule, &value), @"Missing rule for register %u", expected->saved_reg2);
+    STAssertEquals(rule, PLCRASH_DWARF_CFA_REG_RULE_OFFSET, @"Incorrect rule type");
+    STAssertEquals((int64_t) (machine_ptr_s) value, expected->saved_offset2, @"Incorrect offset for register %u", expected->saved_reg2);
+
+    plcrash_async_dwarf_cie_info_free(&cie_info);
+    plcrash_async_dwarf_fde_info_free(&fde_info);
+}
+
+/* Rules emitted by the x86-64 .cfi directives in test.S */
+static const struct elf_cfi_expected x86_64_expected[] = {
+    { "pl_elf_test_frame",      "pl_elf_test_frame_body",       DW_X86_64_RBP, 16, DW_X86_64_RBP, -16, DW_X86_64_RBX, -24 },
+    { "pl_elf_test_frameless",  "pl_elf_test_frameless_body",   DW_X86_64_RSP, 48, DW_X86_64_R12, -16, DW_X86_64_R13, -24 },
+};
+
+/* Rules emitted by the i386 .cfi directives in test.S */
+static const struct elf_cfi_expected x86_expected[] = {
+    { "pl_elf_test_frame",      "pl_elf_test_frame_body",       DW_X86_EBP, 8,  DW_X86_EBP, -8, DW_X86_EBX, -12 },
+    { "pl_elf_test_frameless",  "pl_elf_test_frameless_body",   DW_X86_ESP, 24, DW_X86_ESI, -8, DW_X86_EDI, -12 },
+};
+
+/**
+ * Verify that the CFA engine derives the assembler-generated rules from .eh_frame.
+ */
+- (void) testEHFrameRules {
+    plcrash_async_mobject_t eh_frame;
+
+    STAssertEquals(plcrash_async_elf_map_eh_frame(&_image, &eh_frame), PLCRASH_ESUCCESS, @"Failed to map .eh_frame");
+    for (size_t i = 0; i < sizeof(x86_64_expected) / sizeof(x86_64_expected[0]); i++)
+        verify_cfi_rules<uint64_t, int64_t>(self, &_image, &eh_frame, false, &x86_64_expected[i]);
+
+    plcrash_async_mobject_free(&eh_frame);
+}
+
+/**
+ * Verify that the CFA engine derives the assembler-generated rules from .debug_frame.
+ */
+- (void) testDebugFrameRules {
+    plcrash_async_mobject_t debug_frame;
+
+    STAssertEquals(plcrash_async_elf_map_section(&_image, ".debug_frame", &debug_frame), PLCRASH_ESUCCESS, @"Failed to map .debug_frame");
+    for (size_t i = 0; i < sizeof(x86_64_expected) / sizeof(x86_64_expected[0]); i++)
+        verify_cfi_rules<uint64_t, int64_t>(self, &_image, &debug_frame, true, &x86_64_expected[i]);
+
+    plcrash_async_mobject_free(&debug_frame);
+}
+
+/**
+ * Verify ELFCLASS32 parsing. Only .debug_frame is evaluated, as the pc-relative .eh_frame addresses of an image
+ * mapped above 4GB can not be represented by 32-bit pointers.
+ */
+- (void) testELF32DebugFrameRules {
+    NSData *data = [self dataForTestResource: @"test.i386"];
+    plcrash_async_elf_t image;
+    plcrash_async_mobject_t debug_frame;
+
+    STAssertEquals(plcrash_nasync_elf_init(&image, mach_task_self(), "test.i386", (pl_vm_address_t) [data bytes]), PLCRASH_ESUCCESS, @"Failed to initialize ELF parser");
+    STAssertFalse(image.m64, @"Image should be ELFCLASS32");
+    STAssertEquals(image.machine, (uint16_t) EM_386, @"Incorrect machine type");
+
+    STAssertEquals(plcrash_async_elf_map_section(&image, ".debug_frame", &debug_frame), PLCRASH_ESUCCESS, @"Failed to map .debug_frame");
+    for (size_t i = 0; i < sizeof(x86_expected) / sizeof(x86_expected[0]); i++)
+        verify_cfi_rules<uint32_t, int32_t>(self, &image, &debug_frame, true, &x86_expected[i]);
+
+    plcrash_async_mobject_free(&debug_frame);
+    plcrash_nasync_elf_free(&image);
+}
+
+@end
@@ -64,7 +64,7 @@ void plcrash_nasync_image_list_init (plcrash_async_image_list_t *list, mach_port
 
     list->_list = new async_list<plcrash_async_image_t *>();
     list->task = task;
-    mach_port_mod_refs(mach_task_self(), list->task, MACH_PORT_RIGHT_SEND, 1);
+    plcrash_async_task_retain(list->task);
 }
 
 /**
@@ -90,7 +90,7 @@ void plcrash_nasync_image_list_free (plcrash_async_image_list_t *list) {
     /* Free the backing list */
     delete list->_list;
     
-    mach_port_mod_refs(mach_task_self(), list->task, MACH_PORT_RIGHT_SEND, -1);
+    plcrash_async_task_release(list->task);
 }
 
 /**
@@ -139,7 +139,7 @@ void plcrash_nasync_image_list_remove (plcrash_async_image_list_t *list, pl_vm_a
 
         /* If not found, nothing to do */
         if (found == NULL) {
-            PLCF_DEBUG("Can't find header addr=%llu in Mach-O image list.", (uint64_t)header);
+            PLCF_DEBUG("Can't find header addr=%llu in Mach-O image list.", (unsigned long long) header);
             list->_list->set_reading(false);
             return;
         }
@@ -32,6 +32,7 @@
 #include "PLCrashAsync.h"
 #include "PLCrashMacros.h"
 #include <libkern/OSAtomic.h>
+#include <stdlib.h>
 
 PLCR_CPP_BEGIN_NS
 namespace async {
@@ -27,6 +27,7 @@
  */
 
 #include "PLCrashAsyncMObject.h"
+#include "PLCrashAsyncMemorySource.h"
 
 #include <stdint.h>
 #include <inttypes.h>
@@ -238,6 +239,69 @@ static plcrash_error_t plcrash_async_mobject_remap_pages_workaround (mach_port_t
     return PLCRASH_ESUCCESS;
 }
 
+/**
+ * @internal
+ *
+ * Map pages starting at @a task_addr from @a task into the current process, recording the mapping in the target
+ * memory access counters and the counters of any mapping pool attached to the current thread. @a task must be a
+ * Mach task; mappings of registered memory sources are provided by plcrash_async_mobject_init() directly. Most
+ * callers should use plcrash_async_mobject_init() instead.
+ *
+ * @param task The task from which the memory will be mapped.
+ * @param task_addr The task-relative address of the memory to be mapped. This is not required to fall on a page boundry.
+ * @param length The total size of the mapping to create.
+ * @param require_full If false, a short mapping will be permitted if the full page range is not mappable.
+ * @param[out] result The page-aligned in-process address at which the pages were mapped.
+ * @param[out] result_length The total size, in bytes, of the mapped pages.
+ *
+ * @return On success, returns PLCRASH_ESUCCESS. On failure, one of the plcrash_error_t error values will be returned, and no
+ * mapping will be performed.
+ */
+plcrash_error_t plcrash_async_mobject_map_pages (mach_port_t task, pl_vm_address_t task_addr, pl_vm_size_t length, bool require_full,
+                                                 pl_vm_address_t *result, pl_vm_size_t *result_length)
+{
+    plcrash_error_t err;
+
+    plcrash_async_read_stats_record_map(length);
+    err = plcrash_async_mobject_remap_pages_workaround(task, task_addr, length, require_full, result, result_length);
+    if (err != PLCRASH_ESUCCESS)
+        return err;
+
+    plcrash_async_mobject_pool_t *pool = plcrash_async_mobject_pool_current();
+    if (pool != NULL)
+        pool->stats.map_count++;
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * @internal
+ *
+ * Release a mapping created by plcrash_async_mobject_map_pages().
+ *
+ * @param task The task from which the pages were mapped.
+ * @param address The page-aligned in-process address of the mapping.
+ * @param length The total size, in bytes, of the mapped pages.
+ */
+void plcrash_async_mobject_unmap_pages (mach_port_t task, pl_vm_address_t address, pl_vm_size_t length) {
+    kern_return_t kt;
+
+#ifdef PL_HAVE_MACH_VM
+    kt = mach_vm_deallocate(mach_task_self(), address, length);
+#else
+    kt = vm_deallocate(mach_task_self(), address, length);
+#endif
+
+    if (kt != KERN_SUCCESS)
+        PLCF_DEBUG("vm_deallocate() failure: %d", kt);
+
+    plcrash_async_read_stats_record_unmap(length);
+
+    plcrash_async_mobject_pool_t *pool = plcrash_async_mobject_pool_current();
+    if (pool != NULL)
+        pool->stats.unmap_count++;
+}
+
 
 /**
  * Initialize a new memory object reference, mapping @a task_addr from @a task into the current process. The mapping
@@ -254,17 +318,38 @@ static plcrash_error_t plcrash_async_mobject_remap_pages_workaround (mach_port_t
  *
  * @return On success, returns PLCRASH_ESUCCESS. On failure, one of the plcrash_error_t error values will be returned, and no
  * mapping will be performed.
+ *
+ * If a mapping pool has been attached to the current thread via plcrash_async_mobject_pool_attach(), the mapping
+ * will be shared with any other memory object that references the same pages, and will be retained by the pool
+ * after @a mobj is freed.
  */
 plcrash_error_t plcrash_async_mobject_init (plcrash_async_mobject_t *mobj, mach_port_t task, pl_vm_address_t task_addr, pl_vm_size_t length, bool require_full) {
     plcrash_error_t err;
 
-    /* Perform the page mapping */
-    err = plcrash_async_mobject_remap_pages_workaround(task, task_addr, length, require_full, &mobj->vm_address, &mobj->vm_length);
+    /* Perform the page mapping, preferring a pooled mapping if a pool is available. Memory sources map the requested
+     * address directly, rather than the page containing it; these mappings are not pooled. */
+    plcrash_async_memory_source_t *source = plcrash_async_memory_source_lookup(task);
+    plcrash_async_mobject_pool_t *pool = plcrash_async_mobject_pool_current();
+    pl_vm_size_t page_offset = task_addr - mach_vm_trunc_page(task_addr);
+    bool pooled = false;
+
+    if (source != NULL) {
+        plcrash_async_read_stats_record_map(length);
+        err = source->ops->map(source, task_addr, length, require_full, &mobj->vm_address, &mobj->vm_length);
+        page_offset = 0;
+    } else if (pool != NULL) {
+        err = plcrash_async_mobject_pool_map(pool, task, task_addr, length, require_full, &mobj->vm_address, &mobj->vm_length, &pooled);
+    } else {
+        err = plcrash_async_mobject_map_pages(task, task_addr, length, require_full, &mobj->vm_address, &mobj->vm_length);
+    }
+
     if (err != PLCRASH_ESUCCESS)
         return err;
 
+    mobj->pool = pooled ? pool : NULL;
+
     /* Determine the offset and length of the actual data */
-    mobj->address = mobj->vm_address + (task_addr - mach_vm_trunc_page(task_addr));
+    mobj->address = mobj->vm_address + page_offset;
     mobj->length = mobj->vm_length - (mobj->address - mobj->vm_address);
 
     /* Ensure that the length is capped to the user's requested length, rather than the total length once rounded up
@@ -281,7 +366,7 @@ plcrash_error_t plcrash_async_mobject_init (plcrash_async_mobject_t *mobj, mach_
     
     /* Save the task reference */
     mobj->task = task;
-    mach_port_mod_refs(mach_task_self(), mobj->task, MACH_PORT_RIGHT_SEND, 1);
+    plcrash_async_task_retain(mobj->task);
 
     return PLCRASH_ESUCCESS;
 }
@@ -464,24 +549,25 @@ plcrash_error_t plcrash_async_mobject_read_uint64 (plcrash_async_mobject_t *mobj
 }
 
 /**
- * Free the memory mapping.
+ * Free the memory mapping. If the mapping is owned by a mapping pool, the pool's reference is released instead.
  *
  * @note Unlike most free() functions in this API, this function is async-safe.
  */
 void plcrash_async_mobject_free (plcrash_async_mobject_t *mobj) {
-    kern_return_t kt;
-    
-#ifdef PL_HAVE_MACH_VM
-    kt = mach_vm_deallocate(mach_task_self(), mobj->vm_address, mobj->vm_length);
-#else
-    kt = vm_deallocate(mach_task_self(), mobj->vm_address, mobj->vm_length);
-#endif
-    
-    if (kt != KERN_SUCCESS)
-        PLCF_DEBUG("vm_deallocate() failure: %d", kt);
+    plcrash_async_memory_source_t *source = plcrash_async_memory_source_lookup(mobj->task);
+
+    if (source != NULL) {
+        if (source->ops->unmap != NULL)
+            source->ops->unmap(source, mobj->vm_address, mobj->vm_length);
+        plcrash_async_read_stats_record_unmap(mobj->vm_length);
+    } else if (mobj->pool != NULL) {
+        plcrash_async_mobject_pool_unmap(mobj->pool, mobj->vm_address);
+    } else {
+        plcrash_async_mobject_unmap_pages(mobj->task, mobj->vm_address, mobj->vm_length);
+    }
 
     /* Decrement our task refcount */
-    mach_port_mod_refs(mach_task_self(), mobj->task, MACH_PORT_RIGHT_SEND, -1);
+    plcrash_async_task_release(mobj->task);
 }
 
 /**
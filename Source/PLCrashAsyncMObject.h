@@ -35,6 +35,7 @@ extern "C" {
 
 #include <stdint.h>
 #include "PLCrashAsync.h"
+#include "PLCrashAsyncMObjectPool.h"
 
 /**
  * @ingroup plcrash_async
@@ -62,13 +63,20 @@ typedef struct plcrash_async_mobject {
     int64_t vm_slide;
 
     /** The actual mapping start address. This may differ from the address pointer, as it must be
-     * page-aligned. */
+     * page-aligned. Mappings provided by a memory source begin at the address pointer. */
     pl_vm_address_t vm_address;
     
     /** The actual mapping size. This may differ from the user-requested size, as the base address has been page-aligned */
     pl_vm_size_t vm_length;
+
+    /** The pool that owns the mapping, or NULL if the mapping is owned by this memory object. */
+    plcrash_async_mobject_pool_t *pool;
 } plcrash_async_mobject_t;
 
+plcrash_error_t plcrash_async_mobject_map_pages (mach_port_t task, pl_vm_address_t task_addr, pl_vm_size_t length, bool require_full,
+                                                 pl_vm_address_t *result, pl_vm_size_t *result_length);
+void plcrash_async_mobject_unmap_pages (mach_port_t task, pl_vm_address_t address, pl_vm_size_t length);
+
 plcrash_error_t plcrash_async_mobject_init (plcrash_async_mobject_t *mobj, mach_port_t task, pl_vm_address_t task_addr, pl_vm_size_t length, bool require_full);
 
 pl_vm_address_t plcrash_async_mobject_base_address (plcrash_async_mobject_t *mobj);
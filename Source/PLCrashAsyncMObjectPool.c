@@ -0,0 +1,332 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PLCrashAsyncMObjectPool.h"
+#include "PLCrashAsyncMObject.h"
+
+#include <inttypes.h>
+#include <stdatomic.h>
+
+/**
+ * @internal
+ * @ingroup plcrash_async
+ *
+ * Implements an async-safe pool of memory object mappings.
+ *
+ * @{
+ */
+
+/** The currently attached mapping pool, if any. */
+static plcrash_async_mobject_pool_t *_Atomic attached_mobject_pool = NULL;
+
+/**
+ * Initialize a new mapping pool, preallocating storage for @a capacity entries.
+ *
+ * @param pool The pool to initialize.
+ * @param capacity The maximum number of mappings to be retained.
+ * @param max_size The maximum total size, in bytes, of all retained mappings.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, or PLCRASH_ENOMEM if the pool storage could not be allocated.
+ *
+ * @warning This function is not async-safe, and must be called prior to report generation.
+ */
+plcrash_error_t plcrash_async_mobject_pool_init (plcrash_async_mobject_pool_t *pool, size_t capacity, pl_vm_size_t max_size) {
+    plcrash_async_memset(pool, 0, sizeof(*pool));
+
+    if (capacity == 0)
+        capacity = 1;
+
+    pl_vm_size_t alloc_size = mach_vm_round_page(capacity * sizeof(plcrash_async_mobject_pool_entry_t));
+
+    vm_address_t region;
+    kern_return_t kt = vm_allocate(mach_task_self(), &region, alloc_size, VM_FLAGS_ANYWHERE);
+    if (kt != KERN_SUCCESS) {
+        PLCF_DEBUG("Failed to allocate mapping pool storage: %d", kt);
+        return PLCRASH_ENOMEM;
+    }
+
+    pool->capacity = capacity;
+    pool->max_size = max_size;
+    pool->entries = (plcrash_async_mobject_pool_entry_t *) region;
+    pool->allocation_size = alloc_size;
+
+    for (size_t i = 0; i < capacity; i++)
+        pool->entries[i].task_address = PL_VM_ADDRESS_INVALID;
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * @internal
+ *
+ * Release the mapping held by @a entry, and mark the entry as unused.
+ */
+static void plcrash_async_mobject_pool_release_entry (plcrash_async_mobject_pool_t *pool, plcrash_async_mobject_pool_entry_t *entry) {
+    plcrash_async_mobject_unmap_pages(entry->task, entry->vm_address, entry->vm_length);
+
+    pool->stats.mapped_bytes -= entry->vm_length;
+    entry->task_address = PL_VM_ADDRESS_INVALID;
+    entry->refcount = 0;
+    entry->stale = false;
+}
+
+/**
+ * Free all resources associated with @a pool, including any retained mappings. The pool must not be attached, and
+ * all memory objects referencing the pool's mappings must have been freed.
+ *
+ * @param pool The pool to free.
+ */
+void plcrash_async_mobject_pool_free (plcrash_async_mobject_pool_t *pool) {
+    PLCF_ASSERT(atomic_load(&attached_mobject_pool) != pool);
+
+    if (pool->entries == NULL)
+        return;
+
+    for (size_t i = 0; i < pool->capacity; i++) {
+        if (pool->entries[i].task_address != PL_VM_ADDRESS_INVALID)
+            plcrash_async_mobject_pool_release_entry(pool, &pool->entries[i]);
+    }
+
+    vm_deallocate(mach_task_self(), (vm_address_t) pool->entries, pool->allocation_size);
+
+    pool->entries = NULL;
+    pool->capacity = 0;
+}
+
+/**
+ * Attach @a pool to the current thread. Until the pool is detached via plcrash_async_mobject_pool_detach(), memory
+ * objects initialized by the current thread via plcrash_async_mobject_init() will share the pool's mappings. Memory
+ * objects initialized by any other thread are unaffected.
+ *
+ * The pool counters are reset.
+ *
+ * @param pool The pool to attach.
+ *
+ * @return Returns true if the pool was attached, or false if another pool is already attached. Only one pool may be
+ * attached at a time.
+ */
+bool plcrash_async_mobject_pool_attach (plcrash_async_mobject_pool_t *pool) {
+    /* Only one pool may be attached at a time. The pool's state must not be modified until it has been claimed; if
+     * the swap fails, the pool may be in use by its current owner. */
+    plcrash_async_mobject_pool_t *expected = NULL;
+    if (!atomic_compare_exchange_strong(&attached_mobject_pool, &expected, pool))
+        return false;
+
+    /* Claim ownership before resetting the pool, so that no other thread will be served from it. */
+    pool->owner = pthread_self();
+    atomic_thread_fence(memory_order_seq_cst);
+
+    pl_vm_size_t mapped_bytes = pool->stats.mapped_bytes;
+    plcrash_async_memset(&pool->stats, 0, sizeof(pool->stats));
+    pool->stats.mapped_bytes = mapped_bytes;
+    pool->stats.peak_mapped_bytes = mapped_bytes;
+
+    pool->use_counter = 0;
+
+    return true;
+}
+
+/**
+ * Detach @a pool from the current thread, releasing all unreferenced mappings. Mappings that are still referenced
+ * by a memory object are released when that memory object is freed. The pool's counters remain available until the
+ * pool is next attached.
+ *
+ * @param pool A pool previously attached via plcrash_async_mobject_pool_attach().
+ */
+void plcrash_async_mobject_pool_detach (plcrash_async_mobject_pool_t *pool) {
+    PLCF_ASSERT(atomic_load(&attached_mobject_pool) == pool);
+
+    /* Tear down all mappings while still attached, so that the releases are reflected in the pool's counters. The
+     * target memory may change once the session ends; any mappings that remain referenced may not be vended again. */
+    for (size_t i = 0; i < pool->capacity; i++) {
+        plcrash_async_mobject_pool_entry_t *entry = &pool->entries[i];
+        if (entry->task_address == PL_VM_ADDRESS_INVALID)
+            continue;
+
+        if (entry->refcount == 0) {
+            plcrash_async_mobject_pool_release_entry(pool, entry);
+        } else {
+            PLCF_DEBUG("Pooled mapping at 0x%" PRIx64 " is still referenced at detach", (uint64_t) entry->task_address);
+            entry->stale = true;
+        }
+    }
+
+    atomic_compare_exchange_strong(&attached_mobject_pool, &pool, NULL);
+}
+
+/**
+ * Return the mapping pool attached to the current thread, or NULL if none.
+ */
+plcrash_async_mobject_pool_t *plcrash_async_mobject_pool_current (void) {
+    plcrash_async_mobject_pool_t *pool = atomic_load(&attached_mobject_pool);
+    if (pool == NULL || !pthread_equal(pool->owner, pthread_self()))
+        return NULL;
+
+    return pool;
+}
+
+/**
+ * Map pages starting at @a task_addr from @a task via @a pool. If an existing pooled mapping covers the requested
+ * range, a new reference to that mapping is returned. Otherwise, a new mapping is created and, if room is available,
+ * retained by the pool.
+ *
+ * @param pool The mapping pool to be used.
+ * @param task The task from which the memory will be mapped.
+ * @param task_addr The task-relative address of the memory to be mapped. This is not required to fall on a page boundry.
+ * @param length The total size of the mapping to create.
+ * @param require_full If false, a short mapping will be permitted if the full page range is not mappable.
+ * @param[out] result The in-process address of the page containing @a task_addr.
+ * @param[out] result_length The total number of mapped bytes available at @a result.
+ * @param[out] pooled On success, set to true if the mapping is owned by @a pool, and must be released via
+ * plcrash_async_mobject_pool_unmap(). If false, the mapping is owned by the caller, and must be released via
+ * plcrash_async_mobject_unmap_pages().
+ *
+ * @return Returns the same error values as plcrash_async_mobject_map_pages().
+ */
+plcrash_error_t plcrash_async_mobject_pool_map (plcrash_async_mobject_pool_t *pool, task_t task, pl_vm_address_t task_addr, pl_vm_size_t length, bool require_full,
+                                                pl_vm_address_t *result, pl_vm_size_t *result_length, bool *pooled)
+{
+    pl_vm_address_t base_addr = mach_vm_trunc_page(task_addr);
+    pl_vm_size_t total_size = mach_vm_round_page(length + (task_addr - base_addr));
+    plcrash_error_t err;
+
+    pool->use_counter++;
+
+    /* Look for an existing mapping that covers the requested pages */
+    for (size_t i = 0; i < pool->capacity; i++) {
+        plcrash_async_mobject_pool_entry_t *entry = &pool->entries[i];
+        if (entry->task_address == PL_VM_ADDRESS_INVALID || entry->stale || entry->task != task || entry->task_address > base_addr)
+            continue;
+
+        pl_vm_size_t skip = base_addr - entry->task_address;
+        if (skip >= entry->vm_length)
+            continue;
+
+        /* A short mapping also satisfies any short request within the probed range, as no further pages would be
+         * mappable. */
+        pl_vm_size_t available = require_full ? entry->vm_length : entry->probed_length;
+        if (total_size > available - skip)
+            continue;
+
+        entry->refcount++;
+        entry->last_use = pool->use_counter;
+        pool->stats.hit_count++;
+
+        *result = entry->vm_address + skip;
+        *result_length = entry->vm_length - skip;
+        *pooled = true;
+        return PLCRASH_ESUCCESS;
+    }
+
+    /* Find an unused entry, evicting unreferenced mappings until the new mapping fits within the pool's bounds. */
+    plcrash_async_mobject_pool_entry_t *target = NULL;
+    for (size_t i = 0; i < pool->capacity && target == NULL; i++) {
+        if (pool->entries[i].task_address == PL_VM_ADDRESS_INVALID)
+            target = &pool->entries[i];
+    }
+
+    while (total_size <= pool->max_size && (target == NULL || pool->max_size - pool->stats.mapped_bytes < total_size)) {
+        plcrash_async_mobject_pool_entry_t *victim = NULL;
+        for (size_t i = 0; i < pool->capacity; i++) {
+            plcrash_async_mobject_pool_entry_t *entry = &pool->entries[i];
+            if (entry->task_address == PL_VM_ADDRESS_INVALID || entry->refcount != 0)
+                continue;
+
+            if (victim == NULL || entry->last_use < victim->last_use)
+                victim = entry;
+        }
+
+        if (victim == NULL)
+            break;
+
+        plcrash_async_mobject_pool_release_entry(pool, victim);
+        pool->stats.eviction_count++;
+
+        if (target == NULL)
+            target = victim;
+    }
+
+    /* If no room could be made, hand ownership of the mapping to the caller */
+    if (target == NULL || total_size > pool->max_size || pool->max_size - pool->stats.mapped_bytes < total_size) {
+        pool->stats.bypass_count++;
+        *pooled = false;
+        return plcrash_async_mobject_map_pages(task, task_addr, length, require_full, result, result_length);
+    }
+
+    pl_vm_address_t vm_address;
+    pl_vm_size_t vm_length;
+    if ((err = plcrash_async_mobject_map_pages(task, task_addr, length, require_full, &vm_address, &vm_length)) != PLCRASH_ESUCCESS)
+        return err;
+
+    target->task = task;
+    target->task_address = base_addr;
+    target->vm_address = vm_address;
+    target->vm_length = vm_length;
+    target->probed_length = require_full ? vm_length : total_size;
+    target->refcount = 1;
+    target->stale = false;
+    target->last_use = pool->use_counter;
+
+    pool->stats.mapped_bytes += vm_length;
+    if (pool->stats.mapped_bytes > pool->stats.peak_mapped_bytes)
+        pool->stats.peak_mapped_bytes = pool->stats.mapped_bytes;
+
+    *result = vm_address;
+    *result_length = vm_length;
+    *pooled = true;
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Release a reference to the pooled mapping containing @a vm_address. Unreferenced mappings are retained until the
+ * pool is detached, or until they are evicted to make room for a new mapping; if the pool has since been detached,
+ * the mapping is released immediately.
+ *
+ * @param pool The pool from which the mapping was acquired.
+ * @param vm_address An in-process address returned by plcrash_async_mobject_pool_map().
+ */
+void plcrash_async_mobject_pool_unmap (plcrash_async_mobject_pool_t *pool, pl_vm_address_t vm_address) {
+    for (size_t i = 0; i < pool->capacity; i++) {
+        plcrash_async_mobject_pool_entry_t *entry = &pool->entries[i];
+        if (entry->task_address == PL_VM_ADDRESS_INVALID || entry->refcount == 0)
+            continue;
+
+        if (vm_address < entry->vm_address || vm_address - entry->vm_address >= entry->vm_length)
+            continue;
+
+        entry->refcount--;
+        if (entry->refcount == 0 && entry->stale)
+            plcrash_async_mobject_pool_release_entry(pool, entry);
+
+        return;
+    }
+
+    PLCF_DEBUG("No pooled mapping found for address 0x%" PRIx64, (uint64_t) vm_address);
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PLCRASH_ASYNC_MOBJECT_POOL_H
+#define PLCRASH_ASYNC_MOBJECT_POOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "PLCrashAsync.h"
+
+/**
+ * @ingroup plcrash_async
+ *
+ * The default number of mappings retained by a report-generation mapping pool.
+ */
+#define PLCRASH_ASYNC_MOBJECT_POOL_DEFAULT_CAPACITY 32
+
+/**
+ * @ingroup plcrash_async
+ *
+ * The default upper bound, in bytes, on the local address space occupied by a report-generation mapping pool.
+ */
+#define PLCRASH_ASYNC_MOBJECT_POOL_DEFAULT_MAX_SIZE (32 * 1024 * 1024)
+
+/**
+ * @internal
+ * @ingroup plcrash_async
+ *
+ * A single pooled mapping.
+ */
+typedef struct plcrash_async_mobject_pool_entry {
+    /** The task from which the pages were mapped. */
+    task_t task;
+
+    /** The page-aligned task-relative address of the mapping, or PL_VM_ADDRESS_INVALID if the entry is unused. */
+    pl_vm_address_t task_address;
+
+    /** The page-aligned local address of the mapping. */
+    pl_vm_address_t vm_address;
+
+    /** The size of the local mapping. */
+    pl_vm_size_t vm_length;
+
+    /** The page-rounded size of the range that was requested when the mapping was created. This may exceed
+     * @a vm_length if a short mapping was permitted, in which case no pages are mappable beyond @a vm_length. */
+    pl_vm_size_t probed_length;
+
+    /** The number of memory objects currently referencing this mapping. */
+    uint32_t refcount;
+
+    /** If true, the mapping was created during a previous session, and may not be vended again. The mapping is
+     * released once its last reference is dropped. */
+    bool stale;
+
+    /** The value of the pool's use counter at the time of the entry's most recent use. */
+    uint64_t last_use;
+} plcrash_async_mobject_pool_entry_t;
+
+/**
+ * @internal
+ * @ingroup plcrash_async
+ *
+ * Mapping pool counters.
+ */
+typedef struct plcrash_async_mobject_pool_stats {
+    /** Number of local mappings created by the attached thread, including mappings that were not pooled. */
+    uint64_t map_count;
+
+    /** Number of local mappings released by the attached thread, including mappings that were not pooled. */
+    uint64_t unmap_count;
+
+    /** Number of memory object initializations served from an existing pooled mapping. */
+    uint64_t hit_count;
+
+    /** Number of unreferenced pooled mappings released to make room for a new mapping. */
+    uint64_t eviction_count;
+
+    /** Number of mappings that could not be pooled, and are owned by their memory object. */
+    uint64_t bypass_count;
+
+    /** The total size of all pooled mappings. */
+    pl_vm_size_t mapped_bytes;
+
+    /** The largest value of @a mapped_bytes observed while attached. */
+    pl_vm_size_t peak_mapped_bytes;
+} plcrash_async_mobject_pool_stats_t;
+
+/**
+ * @internal
+ * @ingroup plcrash_async
+ *
+ * An async-safe pool of reference counted memory object mappings.
+ *
+ * Symbol lookup and unwinding repeatedly map the same target ranges (eg, __LINKEDIT, __unwind_info, __eh_frame, and
+ * the Objective-C sections), each time paying for a memory entry, a vm_map(), and a vm_deallocate(). While a pool
+ * is attached to the current thread via plcrash_async_mobject_pool_attach(), memory objects initialized by that
+ * thread via plcrash_async_mobject_init() share pooled mappings of any covering range; releasing a memory object
+ * only drops its reference, and all unreferenced mappings are released together by
+ * plcrash_async_mobject_pool_detach().
+ *
+ * The pool retains at most @a capacity mappings, totalling at most @a max_size bytes of local address space.
+ * Unreferenced mappings are evicted in least recently used order to make room for new mappings; if no room can be
+ * made, the new mapping is owned by its memory object, exactly as if no pool were attached.
+ *
+ * All storage is allocated by plcrash_async_mobject_pool_init(). Pooled mappings do not observe changes to target
+ * memory, and a pool should only be attached while the target task's threads are suspended.
+ */
+typedef struct plcrash_async_mobject_pool {
+    /** The maximum number of pooled mappings. */
+    size_t capacity;
+
+    /** The maximum total size of all pooled mappings. */
+    pl_vm_size_t max_size;
+
+    /** Pool entries. */
+    plcrash_async_mobject_pool_entry_t *entries;
+
+    /** The total size of the allocation backing @a entries. */
+    pl_vm_size_t allocation_size;
+
+    /** The thread to which the pool is attached. Only valid while the pool is attached. */
+    pthread_t owner;
+
+    /** Monotonically increasing use counter, used to select the least recently used entry for eviction. */
+    uint64_t use_counter;
+
+    /** Pool counters. These are reset when the pool is attached. */
+    plcrash_async_mobject_pool_stats_t stats;
+} plcrash_async_mobject_pool_t;
+
+plcrash_error_t plcrash_async_mobject_pool_init (plcrash_async_mobject_pool_t *pool, size_t capacity, pl_vm_size_t max_size);
+void plcrash_async_mobject_pool_free (plcrash_async_mobject_pool_t *pool);
+
+bool plcrash_async_mobject_pool_attach (plcrash_async_mobject_pool_t *pool);
+void plcrash_async_mobject_pool_detach (plcrash_async_mobject_pool_t *pool);
+plcrash_async_mobject_pool_t *plcrash_async_mobject_pool_current (void);
+
+plcrash_error_t plcrash_async_mobject_pool_map (plcrash_async_mobject_pool_t *pool, task_t task, pl_vm_address_t task_addr, pl_vm_size_t length, bool require_full,
+                                                pl_vm_address_t *result, pl_vm_size_t *result_length, bool *pooled);
+void plcrash_async_mobject_pool_unmap (plcrash_async_mobject_pool_t *pool, pl_vm_address_t vm_address);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLCRASH_ASYNC_MOBJECT_POOL_H */
@@ -0,0 +1,259 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "SenTestCompat.h"
+
+#import "PLCrashAsyncMObject.h"
+#import "PLCrashAsyncMObjectPool.h"
+
+@interface PLCrashAsyncMObjectPoolTests : SenTestCase {
+@private
+    /** Page-aligned test allocation. */
+    vm_address_t _region;
+
+    /** Size of the readable test allocation. A guard page follows the readable range. */
+    vm_size_t _region_size;
+
+    /** The pool under test. */
+    plcrash_async_mobject_pool_t _pool;
+}
+@end
+
+@implementation PLCrashAsyncMObjectPoolTests
+
+- (void) setUp {
+    _region_size = vm_page_size * 4;
+    STAssertEquals(KERN_SUCCESS, vm_allocate(mach_task_self(), &_region, _region_size + vm_page_size, VM_FLAGS_ANYWHERE), @"Failed to allocate test pages");
+    STAssertEquals(KERN_SUCCESS, vm_protect(mach_task_self(), _region + _region_size, vm_page_size, false, VM_PROT_NONE), @"Failed to protect guard page");
+
+    uint32_t *words = (uint32_t *) _region;
+    for (uint32_t i = 0; i < _region_size / sizeof(uint32_t); i++)
+        words[i] = i;
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_mobject_pool_init(&_pool, PLCRASH_ASYNC_MOBJECT_POOL_DEFAULT_CAPACITY, PLCRASH_ASYNC_MOBJECT_POOL_DEFAULT_MAX_SIZE), @"Failed to initialize pool");
+}
+
+- (void) tearDown {
+    if (plcrash_async_mobject_pool_current() == &_pool)
+        plcrash_async_mobject_pool_detach(&_pool);
+
+    plcrash_async_mobject_pool_free(&_pool);
+    vm_deallocate(mach_task_self(), _region, _region_size + vm_page_size);
+}
+
+/**
+ * Verify that the word at @a offset within the test region is readable via @a mobj.
+ */
+- (void) assertWordAtOffset: (pl_vm_off_t) offset mobj: (plcrash_async_mobject_t *) mobj {
+    uint32_t val;
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_mobject_read_uint32(mobj, &plcrash_async_byteorder_direct, _region, offset, &val), @"Failed to read");
+    STAssertEquals((uint32_t) (offset / sizeof(uint32_t)), val, @"Incorrect value read");
+}
+
+/**
+ * Verify that memory objects are only pooled while a pool is attached to the current thread.
+ */
+- (void) testAttach {
+    plcrash_async_mobject_t mobj;
+
+    STAssertTrue(plcrash_async_mobject_pool_current() == NULL, @"Pool should not be attached");
+
+    STAssertTrue(plcrash_async_mobject_pool_attach(&_pool), @"Failed to attach pool");
+    STAssertTrue(plcrash_async_mobject_pool_current() == &_pool, @"Pool should be attached");
+
+    /* Only one pool may be attached at a time */
+    plcrash_async_mobject_pool_t other;
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_mobject_pool_init(&other, 1, vm_page_size), @"Failed to initialize pool");
+    STAssertFalse(plcrash_async_mobject_pool_attach(&other), @"Attached a second pool");
+    plcrash_async_mobject_pool_free(&other);
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_mobject_init(&mobj, mach_task_self(), _region, _region_size, true), @"Failed to map");
+    STAssertTrue(mobj.pool == &_pool, @"Mapping was not pooled");
+    [self assertWordAtOffset: sizeof(uint32_t) * 4 mobj: &mobj];
+    plcrash_async_mobject_free(&mobj);
+
+    STAssertEquals((uint64_t) 1, _pool.stats.map_count, @"Incorrect map count");
+    STAssertEquals((uint64_t) 0, _pool.stats.unmap_count, @"Pooled mapping was released early");
+
+    plcrash_async_mobject_pool_detach(&_pool);
+    STAssertTrue(plcrash_async_mobject_pool_current() == NULL, @"Pool should not be attached");
+    STAssertEquals((uint64_t) 1, _pool.stats.unmap_count, @"Pooled mapping was not released on detach");
+    STAssertEquals((pl_vm_size_t) 0, _pool.stats.mapped_bytes, @"Pooled mappings remain after detach");
+
+    /* Once detached, mappings are owned by their memory object */
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_mobject_init(&mobj, mach_task_self(), _region, _region_size, true), @"Failed to map");
+    STAssertTrue(mobj.pool == NULL, @"Mapping was pooled by a detached pool");
+    plcrash_async_mobject_free(&mobj);
+
+    STAssertEquals((uint64_t) 1, _pool.stats.map_count, @"Mapping was counted by a detached pool");
+}
+
+/**
+ * Verify that a mapping is shared by all memory objects that reference a covered range.
+ */
+- (void) testSharedMapping {
+    plcrash_async_mobject_t outer;
+    plcrash_async_mobject_t inner;
+
+    STAssertTrue(plcrash_async_mobject_pool_attach(&_pool), @"Failed to attach pool");
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_mobject_init(&outer, mach_task_self(), _region, _region_size, true), @"Failed to map");
+
+    pl_vm_off_t offset = vm_page_size + sizeof(uint32_t) * 2;
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_mobject_init(&inner, mach_task_self(), _region + offset, sizeof(uint32_t) * 4, true), @"Failed to map");
+
+    STAssertEquals((uint64_t) 1, _pool.stats.map_count, @"Covered range was mapped again");
+    STAssertEquals((uint64_t) 1, _pool.stats.hit_count, @"Incorrect hit count");
+
+    /* The inner object must be restricted to its requested range */
+    STAssertEquals(_region + offset, plcrash_async_mobject_base_address(&inner), @"Incorrect base address");
+    STAssertEquals((pl_vm_address_t) sizeof(uint32_t) * 4, plcrash_async_mobject_length(&inner), @"Incorrect length");
+    STAssertTrue(plcrash_async_mobject_remap_address(&inner, _region, offset + sizeof(uint32_t) * 4, sizeof(uint32_t)) == NULL, @"Read outside of the requested range");
+
+    [self assertWordAtOffset: offset mobj: &inner];
+    [self assertWordAtOffset: offset mobj: &outer];
+    STAssertEquals(plcrash_async_mobject_remap_address(&outer, _region, offset, 1), plcrash_async_mobject_remap_address(&inner, _region, offset, 1), @"Mapping was not shared");
+
+    /* Releasing the memory objects must retain the mapping until detach */
+    plcrash_async_mobject_free(&inner);
+    plcrash_async_mobject_free(&outer);
+    STAssertEquals((uint64_t) 0, _pool.stats.unmap_count, @"Pooled mapping was released early");
+    STAssertEquals((pl_vm_size_t) _region_size, _pool.stats.mapped_bytes, @"Incorrect mapped size");
+
+    /* A later request is served from the retained mapping */
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_mobject_init(&inner, mach_task_self(), _region + offset, sizeof(uint32_t), true), @"Failed to map");
+    STAssertEquals((uint64_t) 2, _pool.stats.hit_count, @"Retained mapping was not reused");
+    plcrash_async_mobject_free(&inner);
+
+    plcrash_async_mobject_pool_detach(&_pool);
+    STAssertEquals((uint64_t) 1, _pool.stats.map_count, @"Incorrect map count");
+    STAssertEquals((uint64_t) 1, _pool.stats.unmap_count, @"Incorrect unmap count");
+}
+
+/**
+ * Verify that a short mapping satisfies later short requests of the same range, but not full requests.
+ */
+- (void) testShortMapping {
+    plcrash_async_mobject_t first;
+    plcrash_async_mobject_t second;
+    plcrash_async_mobject_t full;
+
+    STAssertTrue(plcrash_async_mobject_pool_attach(&_pool), @"Failed to attach pool");
+
+    /* The guard page terminates the mapping */
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_mobject_init(&first, mach_task_self(), _region, _region_size * 2, false), @"Failed to map");
+    STAssertEquals((pl_vm_address_t) _region_size, plcrash_async_mobject_length(&first), @"Incorrect short mapping length");
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_mobject_init(&second, mach_task_self(), _region + vm_page_size, _region_size, false), @"Failed to map");
+    STAssertEquals((pl_vm_address_t) _region_size - vm_page_size, plcrash_async_mobject_length(&second), @"Incorrect short mapping length");
+    STAssertEquals((uint64_t) 1, _pool.stats.hit_count, @"Short mapping was not reused");
+
+    STAssertNotEquals(PLCRASH_ESUCCESS, plcrash_async_mobject_init(&full, mach_task_self(), _region, _region_size * 2, true), @"Full mapping of the guard page succeeded");
+    STAssertEquals((uint64_t) 1, _pool.stats.hit_count, @"Short mapping was used to satisfy a full request");
+
+    plcrash_async_mobject_free(&second);
+    plcrash_async_mobject_free(&first);
+}
+
+/**
+ * Verify that unreferenced mappings are evicted to remain within the pool's bounds, and that mappings are handed to
+ * their memory object once no room can be made.
+ */
+- (void) testAddressSpaceBound {
+    plcrash_async_mobject_pool_t pool;
+    plcrash_async_mobject_t mobj[3];
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_mobject_pool_init(&pool, PLCRASH_ASYNC_MOBJECT_POOL_DEFAULT_CAPACITY, vm_page_size * 2), @"Failed to initialize pool");
+    STAssertTrue(plcrash_async_mobject_pool_attach(&pool), @"Failed to attach pool");
+
+    /* Fill the pool, then touch the first page so that the second becomes the least recently used */
+    for (int i = 0; i < 2; i++) {
+        STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_mobject_init(&mobj[i], mach_task_self(), _region + (i * vm_page_size), sizeof(uint32_t), true), @"Failed to map");
+        plcrash_async_mobject_free(&mobj[i]);
+    }
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_mobject_init(&mobj[0], mach_task_self(), _region, sizeof(uint32_t), true), @"Failed to map");
+    plcrash_async_mobject_free(&mobj[0]);
+
+    /* Mapping a new page must evict the second page, leaving the first page pooled */
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_mobject_init(&mobj[2], mach_task_self(), _region + (2 * vm_page_size), sizeof(uint32_t), true), @"Failed to map");
+    STAssertEquals((uint64_t) 1, pool.stats.eviction_count, @"Incorrect eviction count");
+    STAssertEquals((uint64_t) 1, pool.stats.unmap_count, @"Evicted mapping was not released");
+    STAssertEquals((pl_vm_size_t) vm_page_size * 2, pool.stats.peak_mapped_bytes, @"Pool exceeded its bounds");
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_mobject_init(&mobj[0], mach_task_self(), _region, sizeof(uint32_t), true), @"Failed to map");
+    STAssertEquals((uint64_t) 2, pool.stats.hit_count, @"Most recently used mapping was evicted");
+
+    /* With all pooled mappings referenced, a new mapping must be owned by its memory object */
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_mobject_init(&mobj[1], mach_task_self(), _region + (3 * vm_page_size), sizeof(uint32_t), true), @"Failed to map");
+    STAssertTrue(mobj[1].pool == NULL, @"Mapping was pooled beyond the pool's bounds");
+    STAssertEquals((uint64_t) 1, pool.stats.bypass_count, @"Incorrect bypass count");
+    [self assertWordAtOffset: 3 * vm_page_size mobj: &mobj[1]];
+
+    plcrash_async_mobject_free(&mobj[1]);
+    STAssertEquals((uint64_t) 2, pool.stats.unmap_count, @"Unpooled mapping was not released");
+
+    /* Requests larger than the pool must always be unpooled */
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_mobject_init(&mobj[1], mach_task_self(), _region, _region_size, true), @"Failed to map");
+    STAssertTrue(mobj[1].pool == NULL, @"Mapping was pooled beyond the pool's bounds");
+    STAssertEquals((uint64_t) 1, pool.stats.eviction_count, @"Oversized mapping evicted pooled mappings");
+    plcrash_async_mobject_free(&mobj[1]);
+
+    plcrash_async_mobject_free(&mobj[0]);
+    plcrash_async_mobject_free(&mobj[2]);
+
+    plcrash_async_mobject_pool_detach(&pool);
+    STAssertEquals(pool.stats.map_count, pool.stats.unmap_count, @"Mappings were leaked");
+    plcrash_async_mobject_pool_free(&pool);
+}
+
+/**
+ * Verify that mappings still referenced at detach remain valid, are not reused by a later session, and are released
+ * along with their last reference.
+ */
+- (void) testReferencedAcrossDetach {
+    plcrash_async_mobject_t held;
+    plcrash_async_mobject_t mobj;
+
+    STAssertTrue(plcrash_async_mobject_pool_attach(&_pool), @"Failed to attach pool");
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_mobject_init(&held, mach_task_self(), _region, vm_page_size, true), @"Failed to map");
+    plcrash_async_mobject_pool_detach(&_pool);
+
+    STAssertEquals((uint64_t) 0, _pool.stats.unmap_count, @"Referenced mapping was released");
+    [self assertWordAtOffset: sizeof(uint32_t) mobj: &held];
+
+    STAssertTrue(plcrash_async_mobject_pool_attach(&_pool), @"Failed to attach pool");
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_mobject_init(&mobj, mach_task_self(), _region, vm_page_size, true), @"Failed to map");
+    STAssertEquals((uint64_t) 0, _pool.stats.hit_count, @"Mapping from a previous session was reused");
+
+    plcrash_async_mobject_free(&held);
+    STAssertEquals((uint64_t) 1, _pool.stats.unmap_count, @"Stale mapping was not released with its last reference");
+
+    plcrash_async_mobject_free(&mobj);
+    plcrash_async_mobject_pool_detach(&_pool);
+    STAssertEquals((pl_vm_size_t) 0, _pool.stats.mapped_bytes, @"Pooled mappings remain after detach");
+}
+
+@end
@@ -70,7 +70,7 @@ plcrash_error_t plcrash_nasync_macho_init (plcrash_async_macho_t *image, mach_po
     image->header_addr = header;
     image->name = strdup(name);
 
-    mach_port_mod_refs(mach_task_self(), image->task, MACH_PORT_RIGHT_SEND, 1);
+    plcrash_async_task_retain(image->task);
     task_initialized = true;
 
     /* Read in the Mach-O header */
@@ -199,7 +199,7 @@ error:
         free(image->name);
     
     if (task_initialized)
-        mach_port_mod_refs(mach_task_self(), image->task, MACH_PORT_RIGHT_SEND, -1);
+        plcrash_async_task_release(image->task);
 
     return ret;
 }
@@ -947,7 +947,7 @@ void plcrash_nasync_macho_free (plcrash_async_macho_t *image) {
     
     plcrash_async_mobject_free(&image->load_cmds);
 
-    mach_port_mod_refs(mach_task_self(), image->task, MACH_PORT_RIGHT_SEND, -1);
+    plcrash_async_task_release(image->task);
 }
 
 
@@ -0,0 +1,579 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PLCrashAsyncMemorySource.h"
+#include "PLCrashAsyncMObject.h"
+
+#include <inttypes.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <mach-o/loader.h>
+#include <mach-o/fat.h>
+
+#include <stdatomic.h>
+
+/**
+ * @internal
+ * @ingroup plcrash_async
+ *
+ * Implements pluggable sources of target memory.
+ *
+ * @{
+ */
+
+/** Registered memory sources, indexed by slot. */
+static plcrash_async_memory_source_t *_Atomic registered_sources[PLCRASH_ASYNC_MEMORY_SOURCE_MAX];
+
+/**
+ * Task handles assigned to registered memory sources, indexed by slot, or MACH_PORT_NULL if the slot is unassigned.
+ *
+ * Each handle is a dead name allocated in the current task's IPC space. The name is reserved for the lifetime of the
+ * registration, and can not collide with a live task port; any Mach call that is mistakenly issued against the
+ * handle will fail, rather than operating on an unrelated port. On non-Apple hosts, names are vended by the Mach shim
+ * (Source/Linux/mach_shim.c), and no live tasks exist.
+ */
+static _Atomic task_t registered_tasks[PLCRASH_ASYNC_MEMORY_SOURCE_MAX];
+
+/*
+ * Live task source
+ */
+
+static plcrash_error_t task_source_read (plcrash_async_memory_source_t *source, pl_vm_address_t address, void *dest, pl_vm_size_t len) {
+    return plcrash_async_task_memcpy_uncached(source->context.task, address, 0, dest, len);
+}
+
+static plcrash_error_t task_source_map (plcrash_async_memory_source_t *source, pl_vm_address_t address, pl_vm_size_t length, bool require_full,
+                                        pl_vm_address_t *result, pl_vm_size_t *result_length)
+{
+    plcrash_error_t err;
+
+    /* Map the containing pages, and report the mapping relative to the requested address */
+    pl_vm_size_t page_offset = address - mach_vm_trunc_page(address);
+    if ((err = plcrash_async_mobject_map_pages(source->context.task, address, length, require_full, result, result_length)) != PLCRASH_ESUCCESS)
+        return err;
+
+    *result += page_offset;
+    *result_length -= page_offset;
+
+    return PLCRASH_ESUCCESS;
+}
+
+static void task_source_unmap (plcrash_async_memory_source_t *source, pl_vm_address_t address, pl_vm_size_t length) {
+    pl_vm_size_t page_offset = address - mach_vm_trunc_page(address);
+    plcrash_async_mobject_unmap_pages(source->context.task, address - page_offset, length + page_offset);
+}
+
+/** Live task source operations. */
+static const plcrash_async_memory_source_ops_t task_source_ops = {
+    .read = task_source_read,
+    .map = task_source_map,
+    .unmap = task_source_unmap
+};
+
+/**
+ * Initialize a memory source that reads from a live Mach task. This is primarily useful for wrapping a task
+ * alongside other memory sources; readers may also be passed @a task directly.
+ *
+ * @param source The source to initialize.
+ * @param task The task from which memory will be read. The caller is responsible for ensuring that @a task remains
+ * valid for the lifetime of @a source.
+ */
+void plcrash_async_memory_source_task_init (plcrash_async_memory_source_t *source, task_t task) {
+    source->ops = &task_source_ops;
+    source->task = MACH_PORT_NULL;
+    source->context.task = task;
+}
+
+/*
+ * Region source
+ */
+
+/**
+ * @internal
+ *
+ * Return the region of @a source containing @a address, or NULL if none.
+ */
+static const plcrash_async_memory_region_t *region_source_find (plcrash_async_memory_source_t *source, pl_vm_address_t address) {
+    const plcrash_async_memory_region_t *regions = source->context.regions.regions;
+    size_t low = 0;
+    size_t high = source->context.regions.count;
+
+    /* Find the last region starting at or below the address */
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (regions[mid].address <= address)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    if (low == 0)
+        return NULL;
+
+    const plcrash_async_memory_region_t *region = &regions[low - 1];
+    if (address - region->address >= region->length)
+        return NULL;
+
+    return region;
+}
+
+/**
+ * @internal
+ *
+ * Walk the contiguous regions covering @a len bytes at @a address, copying their contents to @a dest if non-NULL.
+ *
+ * @return Returns PLCRASH_ESUCCESS if the entire range is available, or PLCRASH_ENOTFOUND otherwise.
+ */
+static plcrash_error_t region_source_copy (plcrash_async_memory_source_t *source, pl_vm_address_t address, uint8_t *dest, pl_vm_size_t len) {
+    while (len > 0) {
+        const plcrash_async_memory_region_t *region = region_source_find(source, address);
+        if (region == NULL)
+            return PLCRASH_ENOTFOUND;
+
+        pl_vm_size_t offset = address - region->address;
+        pl_vm_size_t avail = region->length - offset;
+        if (avail > len)
+            avail = len;
+
+        if (dest != NULL) {
+            plcrash_async_memcpy(dest, (const uint8_t *) region->data + offset, avail);
+            dest += avail;
+        }
+
+        address += avail;
+        len -= avail;
+    }
+
+    return PLCRASH_ESUCCESS;
+}
+
+static plcrash_error_t region_source_read (plcrash_async_memory_source_t *source, pl_vm_address_t address, void *dest, pl_vm_size_t len) {
+    plcrash_error_t err;
+
+    if (PL_VM_ADDRESS_MAX - address < len)
+        return PLCRASH_ENOMEM;
+
+    /* Verify the full range prior to copying, so that no data is copied on failure */
+    if ((err = region_source_copy(source, address, NULL, len)) != PLCRASH_ESUCCESS)
+        return err;
+
+    return region_source_copy(source, address, dest, len);
+}
+
+static plcrash_error_t region_source_map (plcrash_async_memory_source_t *source, pl_vm_address_t address, pl_vm_size_t length, bool require_full,
+                                          pl_vm_address_t *result, pl_vm_size_t *result_length)
+{
+    /* Mappings are served directly from the region buffer, and may not span regions */
+    const plcrash_async_memory_region_t *region = region_source_find(source, address);
+    if (region == NULL) {
+        PLCF_DEBUG("No region found at 0x%" PRIx64, (uint64_t) address);
+        return PLCRASH_ENOMEM;
+    }
+
+    pl_vm_size_t offset = address - region->address;
+    pl_vm_size_t avail = region->length - offset;
+    if (require_full && avail < length)
+        return PLCRASH_ENOMEM;
+
+    *result = (pl_vm_address_t) (uintptr_t) ((const uint8_t *) region->data + offset);
+    *result_length = avail;
+
+    return PLCRASH_ESUCCESS;
+}
+
+/** Region source operations. */
+static const plcrash_async_memory_source_ops_t region_source_ops = {
+    .read = region_source_read,
+    .map = region_source_map,
+    .unmap = NULL
+};
+
+/**
+ * Initialize a memory source that serves reads from a set of local buffers, such as a captured memory snapshot or
+ * the regions of a mapped file.
+ *
+ * @param source The source to initialize.
+ * @param regions The source regions. The array is sorted in place by address, and is a borrowed reference that must
+ * remain valid for the lifetime of @a source, as must the region buffers.
+ * @param count The number of elements in @a regions.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, or PLCRASH_EINVAL if a region is empty, overflows the address space,
+ * or overlaps another region.
+ */
+plcrash_error_t plcrash_async_memory_source_regions_init (plcrash_async_memory_source_t *source, plcrash_async_memory_region_t *regions, size_t count) {
+    /* Insertion sort by address; region tables are small, and this requires no allocation. */
+    for (size_t i = 1; i < count; i++) {
+        plcrash_async_memory_region_t region = regions[i];
+        size_t j = i;
+        while (j > 0 && regions[j - 1].address > region.address) {
+            regions[j] = regions[j - 1];
+            j--;
+        }
+        regions[j] = region;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (regions[i].length == 0 || PL_VM_ADDRESS_MAX - regions[i].address < regions[i].length - 1) {
+            PLCF_DEBUG("Invalid region at 0x%" PRIx64, (uint64_t) regions[i].address);
+            return PLCRASH_EINVAL;
+        }
+
+        if (i > 0 && regions[i].address - regions[i - 1].address < regions[i - 1].length) {
+            PLCF_DEBUG("Region at 0x%" PRIx64 " overlaps its predecessor", (uint64_t) regions[i].address);
+            return PLCRASH_EINVAL;
+        }
+    }
+
+    source->ops = &region_source_ops;
+    source->task = MACH_PORT_NULL;
+    source->context.regions.regions = regions;
+    source->context.regions.count = count;
+
+    return PLCRASH_ESUCCESS;
+}
+
+/*
+ * Registration
+ */
+
+/**
+ * Register @a source, assigning it a task handle. The handle may be fetched via plcrash_async_memory_source_task(),
+ * and passed to any memory reader in place of a Mach task.
+ *
+ * @param source An initialized memory source.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, PLCRASH_ENOMEM if PLCRASH_ASYNC_MEMORY_SOURCE_MAX sources are
+ * already registered, or PLCRASH_EINTERNAL if a handle could not be allocated.
+ */
+plcrash_error_t plcrash_async_memory_source_register (plcrash_async_memory_source_t *source) {
+    mach_port_name_t name;
+    kern_return_t kt;
+
+    /* Reserve a name for the handle */
+    if ((kt = mach_port_allocate(mach_task_self(), MACH_PORT_RIGHT_DEAD_NAME, &name)) != KERN_SUCCESS) {
+        PLCF_DEBUG("mach_port_allocate() failed: %d", kt);
+        source->task = MACH_PORT_NULL;
+        return PLCRASH_EINTERNAL;
+    }
+
+    for (size_t slot = 0; slot < PLCRASH_ASYNC_MEMORY_SOURCE_MAX; slot++) {
+        plcrash_async_memory_source_t *expected = NULL;
+        if (!atomic_compare_exchange_strong(&registered_sources[slot], &expected, source))
+            continue;
+
+        /* Publish the handle once the slot has been claimed */
+        source->task = name;
+        atomic_store(&registered_tasks[slot], name);
+
+        return PLCRASH_ESUCCESS;
+    }
+
+    mach_port_mod_refs(mach_task_self(), name, MACH_PORT_RIGHT_DEAD_NAME, -1);
+    source->task = MACH_PORT_NULL;
+    return PLCRASH_ENOMEM;
+}
+
+/**
+ * Unregister @a source, releasing its task handle. All readers referencing the handle must have been freed.
+ *
+ * @param source A source previously registered via plcrash_async_memory_source_register().
+ */
+void plcrash_async_memory_source_unregister (plcrash_async_memory_source_t *source) {
+    PLCF_ASSERT(plcrash_async_memory_source_lookup(source->task) == source);
+
+    for (size_t slot = 0; slot < PLCRASH_ASYNC_MEMORY_SOURCE_MAX; slot++) {
+        if (atomic_load(&registered_sources[slot]) != source)
+            continue;
+
+        /* Withdraw the handle prior to releasing the slot */
+        atomic_store(&registered_tasks[slot], MACH_PORT_NULL);
+        atomic_store(&registered_sources[slot], NULL);
+        break;
+    }
+
+    mach_port_mod_refs(mach_task_self(), source->task, MACH_PORT_RIGHT_DEAD_NAME, -1);
+    source->task = MACH_PORT_NULL;
+}
+
+/**
+ * Return the task handle assigned to @a source, or MACH_PORT_NULL if the source is not registered.
+ *
+ * @param source A memory source.
+ */
+task_t plcrash_async_memory_source_task (plcrash_async_memory_source_t *source) {
+    return source->task;
+}
+
+/**
+ * Return the registered memory source assigned to @a task, or NULL if @a task is not a memory source handle.
+ *
+ * @param task A task handle.
+ */
+plcrash_async_memory_source_t *plcrash_async_memory_source_lookup (task_t task) {
+    if (!MACH_PORT_VALID(task))
+        return NULL;
+
+    for (size_t slot = 0; slot < PLCRASH_ASYNC_MEMORY_SOURCE_MAX; slot++) {
+        if (atomic_load_explicit(&registered_tasks[slot], memory_order_acquire) == task)
+            return atomic_load_explicit(&registered_sources[slot], memory_order_relaxed);
+    }
+
+    return NULL;
+}
+
+/*
+ * Mapped files
+ */
+
+/**
+ * Map the file at @a path into the current process. A file containing a raw memory dump may be served via a single
+ * region referencing the file's contents; Mach-O images and core files may be served via the regions returned by
+ * plcrash_nasync_memory_file_macho_regions().
+ *
+ * @param file The file to initialize.
+ * @param path The path of the file to be mapped.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, PLCRASH_ENOTFOUND if the file does not exist, PLCRASH_EACCESS if the
+ * file could not be opened, PLCRASH_EINVALID_DATA if the file is empty, or PLCRASH_EINTERNAL if the file could not
+ * be mapped.
+ *
+ * @warning This function is not async-safe.
+ */
+plcrash_error_t plcrash_nasync_memory_file_open (plcrash_async_memory_file_t *file, const char *path) {
+    plcrash_error_t err = PLCRASH_ESUCCESS;
+    struct stat sb;
+
+    file->data = NULL;
+    file->length = 0;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        PLCF_DEBUG("Could not open %s: %d", path, errno);
+        return errno == ENOENT ? PLCRASH_ENOTFOUND : PLCRASH_EACCESS;
+    }
+
+    if (fstat(fd, &sb) != 0) {
+        PLCF_DEBUG("Could not stat %s: %d", path, errno);
+        err = PLCRASH_EINTERNAL;
+        goto cleanup;
+    }
+
+    if (sb.st_size <= 0) {
+        err = PLCRASH_EINVALID_DATA;
+        goto cleanup;
+    }
+
+    void *data = mmap(NULL, (size_t) sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        PLCF_DEBUG("Could not map %s: %d", path, errno);
+        err = PLCRASH_EINTERNAL;
+        goto cleanup;
+    }
+
+    file->data = data;
+    file->length = (pl_vm_size_t) sb.st_size;
+
+cleanup:
+    close(fd);
+    return err;
+}
+
+/**
+ * Populate @a regions with the file-backed segments of the Mach-O image or core file mapped by @a file. Each
+ * LC_SEGMENT or LC_SEGMENT_64 command with file contents produces a region at the segment's VM address plus @a slide.
+ * Zero-filled segment contents are not included.
+ *
+ * dSYM companion files carry no __TEXT contents; for these, an additional region serving the Mach-O header and load
+ * commands is produced at the __TEXT address, allowing the file to be parsed with plcrash_nasync_macho_init().
+ *
+ * @param file A mapped Mach-O file.
+ * @param slide The slide to be applied to each segment address. Core files should use a slide of 0.
+ * @param regions The array to which regions will be appended, starting at index 0.
+ * @param capacity The number of elements available in @a regions.
+ * @param[out] count On success, the number of regions written to @a regions.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, PLCRASH_ENOTSUP if @a file is a universal binary, PLCRASH_EINVALID_DATA
+ * if the file could not be parsed, or PLCRASH_ENOMEM if @a capacity is insufficient.
+ *
+ * @warning This function is not async-safe.
+ */
+plcrash_error_t plcrash_nasync_memory_file_macho_regions (plcrash_async_memory_file_t *file, pl_vm_off_t slide, plcrash_async_memory_region_t *regions, size_t capacity, size_t *count) {
+    const plcrash_async_byteorder_t *byteorder = &plcrash_async_byteorder_direct;
+    struct mach_header header;
+    pl_vm_size_t header_size;
+    bool m64;
+
+    *count = 0;
+
+    if (file->length < sizeof(header))
+        return PLCRASH_EINVALID_DATA;
+    plcrash_async_memcpy(&header, file->data, sizeof(header));
+
+    switch (header.magic) {
+        case MH_CIGAM:
+            byteorder = &plcrash_async_byteorder_swapped;
+            // Fall-through
+
+        case MH_MAGIC:
+            m64 = false;
+            header_size = sizeof(struct mach_header);
+            break;
+
+        case MH_CIGAM_64:
+            byteorder = &plcrash_async_byteorder_swapped;
+            // Fall-through
+
+        case MH_MAGIC_64:
+            m64 = true;
+            header_size = sizeof(struct mach_header_64);
+            break;
+
+        case FAT_CIGAM:
+        case FAT_MAGIC:
+            PLCF_DEBUG("Universal Mach-O files are not supported");
+            return PLCRASH_ENOTSUP;
+
+        default:
+            PLCF_DEBUG("Unknown Mach-O magic: 0x%" PRIx32, header.magic);
+            return PLCRASH_EINVALID_DATA;
+    }
+
+    pl_vm_size_t cmds_size = byteorder->swap32(header.sizeofcmds);
+    uint32_t ncmds = byteorder->swap32(header.ncmds);
+    if (file->length < header_size || file->length - header_size < cmds_size)
+        return PLCRASH_EINVALID_DATA;
+
+    pl_vm_size_t offset = 0;
+    bool header_mapped = false;
+    bool have_text = false;
+    uint64_t text_vmaddr = 0;
+    for (uint32_t i = 0; i < ncmds; i++) {
+        struct load_command cmd;
+        if (cmds_size - offset < sizeof(cmd))
+            return PLCRASH_EINVALID_DATA;
+
+        const uint8_t *cmd_data = file->data + header_size + offset;
+        plcrash_async_memcpy(&cmd, cmd_data, sizeof(cmd));
+
+        uint32_t cmdsize = byteorder->swap32(cmd.cmdsize);
+        if (cmdsize < sizeof(cmd) || cmds_size - offset < cmdsize)
+            return PLCRASH_EINVALID_DATA;
+        offset += cmdsize;
+
+        uint64_t vmaddr, vmsize, fileoff, filesize;
+        char segname[16];
+        uint32_t type = byteorder->swap32(cmd.cmd);
+        if (type == LC_SEGMENT_64 && m64) {
+            struct segment_command_64 seg;
+            if (cmdsize < sizeof(seg))
+                return PLCRASH_EINVALID_DATA;
+
+            plcrash_async_memcpy(&seg, cmd_data, sizeof(seg));
+            vmaddr = byteorder->swap64(seg.vmaddr);
+            vmsize = byteorder->swap64(seg.vmsize);
+            fileoff = byteorder->swap64(seg.fileoff);
+            filesize = byteorder->swap64(seg.filesize);
+            plcrash_async_memcpy(segname, seg.segname, sizeof(segname));
+        } else if (type == LC_SEGMENT && !m64) {
+            struct segment_command seg;
+            if (cmdsize < sizeof(seg))
+                return PLCRASH_EINVALID_DATA;
+
+            plcrash_async_memcpy(&seg, cmd_data, sizeof(seg));
+            vmaddr = byteorder->swap32(seg.vmaddr);
+            vmsize = byteorder->swap32(seg.vmsize);
+            fileoff = byteorder->swap32(seg.fileoff);
+            filesize = byteorder->swap32(seg.filesize);
+            plcrash_async_memcpy(segname, seg.segname, sizeof(segname));
+        } else {
+            continue;
+        }
+
+        if (plcrash_async_strncmp(segname, SEG_TEXT, sizeof(segname)) == 0) {
+            have_text = true;
+            text_vmaddr = vmaddr;
+        }
+
+        /* Only the file-backed portion of the segment is available */
+        if (filesize > vmsize)
+            filesize = vmsize;
+        if (filesize == 0)
+            continue;
+
+        if (fileoff == 0 && filesize >= header_size + cmds_size)
+            header_mapped = true;
+
+        if (fileoff > file->length || file->length - fileoff < filesize) {
+            PLCF_DEBUG("Segment contents at 0x%" PRIx64 " exceed the file length", fileoff);
+            return PLCRASH_EINVALID_DATA;
+        }
+
+        if (*count == capacity)
+            return PLCRASH_ENOMEM;
+
+        regions[*count].address = (pl_vm_address_t) (vmaddr + slide);
+        regions[*count].length = (pl_vm_size_t) filesize;
+        regions[*count].data = file->data + fileoff;
+        (*count)++;
+    }
+
+    /* Serve the header of a dSYM companion file at its (empty) __TEXT segment */
+    if (have_text && !header_mapped) {
+        if (*count == capacity)
+            return PLCRASH_ENOMEM;
+
+        regions[*count].address = (pl_vm_address_t) (text_vmaddr + slide);
+        regions[*count].length = header_size + cmds_size;
+        regions[*count].data = file->data;
+        (*count)++;
+    }
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Unmap a file previously mapped via plcrash_nasync_memory_file_open(). Any memory sources referencing the file's
+ * contents must no longer be in use.
+ *
+ * @param file The file to unmap.
+ *
+ * @warning This function is not async-safe.
+ */
+void plcrash_nasync_memory_file_close (plcrash_async_memory_file_t *file) {
+    if (file->data != NULL)
+        munmap((void *) file->data, (size_t) file->length);
+
+    file->data = NULL;
+    file->length = 0;
+}
+
+/**
+ * @}
+ */
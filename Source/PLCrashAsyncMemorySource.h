@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PLCRASH_ASYNC_MEMORY_SOURCE_H
+#define PLCRASH_ASYNC_MEMORY_SOURCE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "PLCrashAsync.h"
+
+/**
+ * @ingroup plcrash_async
+ *
+ * The maximum number of memory sources that may be registered at any one time.
+ */
+#define PLCRASH_ASYNC_MEMORY_SOURCE_MAX 16
+
+typedef struct plcrash_async_memory_source plcrash_async_memory_source_t;
+
+/**
+ * @internal
+ * @ingroup plcrash_async
+ *
+ * Memory source operations. All operations must be async-safe.
+ */
+typedef struct plcrash_async_memory_source_ops {
+    /**
+     * Copy @a len bytes at @a address to @a dest. If any of the requested bytes are unavailable, no data may be copied.
+     *
+     * @return Returns the same error values as plcrash_async_task_memcpy().
+     */
+    plcrash_error_t (*read) (plcrash_async_memory_source_t *source, pl_vm_address_t address, void *dest, pl_vm_size_t len);
+
+    /**
+     * Make @a length bytes at @a address available in the current process.
+     *
+     * @param source The memory source.
+     * @param address The source-relative address of the memory to be mapped.
+     * @param length The total size of the mapping to create.
+     * @param require_full If false, a short mapping may be returned if fewer than @a length bytes are available.
+     * @param[out] result The in-process address corresponding to @a address.
+     * @param[out] result_length The number of bytes available at @a result.
+     *
+     * @return Returns the same error values as plcrash_async_mobject_map_pages().
+     */
+    plcrash_error_t (*map) (plcrash_async_memory_source_t *source, pl_vm_address_t address, pl_vm_size_t length, bool require_full,
+                            pl_vm_address_t *result, pl_vm_size_t *result_length);
+
+    /**
+     * Release a mapping returned by @a map, given the @a result and @a result_length values returned by @a map.
+     * May be NULL if mappings do not need to be released.
+     */
+    void (*unmap) (plcrash_async_memory_source_t *source, pl_vm_address_t address, pl_vm_size_t length);
+} plcrash_async_memory_source_ops_t;
+
+/**
+ * @internal
+ * @ingroup plcrash_async
+ *
+ * A contiguous range of source memory, backed by a local buffer.
+ */
+typedef struct plcrash_async_memory_region {
+    /** The source-relative address of the region. */
+    pl_vm_address_t address;
+
+    /** The size of the region, in bytes. */
+    pl_vm_size_t length;
+
+    /** The local buffer containing the region's contents. This is a borrowed reference. */
+    const void *data;
+} plcrash_async_memory_region_t;
+
+/**
+ * @internal
+ * @ingroup plcrash_async
+ *
+ * A source of target memory.
+ *
+ * The memory readers (plcrash_async_task_memcpy(), plcrash_async_mobject_t, and everything built on them, including
+ * plcrash_async_macho_t and the frame readers) address target memory via a task_t. Once registered via
+ * plcrash_async_memory_source_register(), a memory source is assigned a task handle that may be passed to any of
+ * those readers in place of a Mach task; all reads and mappings of that handle are then served by the source. This
+ * allows the unwinder and symbolicator to operate on captured memory snapshots, core files, and on-disk Mach-O images,
+ * with no live task available.
+ */
+struct plcrash_async_memory_source {
+    /** The source operations. */
+    const plcrash_async_memory_source_ops_t *ops;
+
+    /** The task handle assigned to this source, or MACH_PORT_NULL if the source is not registered. */
+    task_t task;
+
+    /** Implementation state. */
+    union {
+        /** The backing task of a live task source. */
+        task_t task;
+
+        /** The regions of a region source. */
+        struct {
+            /** Regions, sorted by address. */
+            plcrash_async_memory_region_t *regions;
+
+            /** The number of regions. */
+            size_t count;
+        } regions;
+    } context;
+};
+
+/**
+ * @internal
+ * @ingroup plcrash_async
+ *
+ * A read-only file mapped into the current process.
+ */
+typedef struct plcrash_async_memory_file {
+    /** The mapped file contents, or NULL if not mapped. */
+    const uint8_t *data;
+
+    /** The size of the mapped file. */
+    pl_vm_size_t length;
+} plcrash_async_memory_file_t;
+
+void plcrash_async_memory_source_task_init (plcrash_async_memory_source_t *source, task_t task);
+plcrash_error_t plcrash_async_memory_source_regions_init (plcrash_async_memory_source_t *source, plcrash_async_memory_region_t *regions, size_t count);
+
+plcrash_error_t plcrash_async_memory_source_register (plcrash_async_memory_source_t *source);
+void plcrash_async_memory_source_unregister (plcrash_async_memory_source_t *source);
+task_t plcrash_async_memory_source_task (plcrash_async_memory_source_t *source);
+plcrash_async_memory_source_t *plcrash_async_memory_source_lookup (task_t task);
+
+plcrash_error_t plcrash_nasync_memory_file_open (plcrash_async_memory_file_t *file, const char *path);
+plcrash_error_t plcrash_nasync_memory_file_macho_regions (plcrash_async_memory_file_t *file, pl_vm_off_t slide, plcrash_async_memory_region_t *regions, size_t capacity, size_t *count);
+void plcrash_nasync_memory_file_close (plcrash_async_memory_file_t *file);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLCRASH_ASYNC_MEMORY_SOURCE_H */
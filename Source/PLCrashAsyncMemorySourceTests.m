@@ -0,0 +1,327 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "SenTestCompat.h"
+
+#import "PLCrashAsyncMemorySource.h"
+#import "PLCrashAsyncMObject.h"
+#import "PLCrashAsyncMachOImage.h"
+
+@interface PLCrashAsyncMemorySourceTests : SenTestCase {
+@private
+    /** Region backing data. */
+    uint32_t _words[3][256];
+
+    /** Test regions. The first two regions are contiguous; the third follows a gap. */
+    plcrash_async_memory_region_t _regions[3];
+}
+@end
+
+/** Source-relative address of the first test region. */
+#define TEST_REGION_BASE ((pl_vm_address_t) 0x10000)
+
+@implementation PLCrashAsyncMemorySourceTests
+
+- (void) setUp {
+    for (uint32_t r = 0; r < 3; r++) {
+        for (uint32_t i = 0; i < 256; i++)
+            _words[r][i] = (r << 16) | i;
+    }
+
+    /* Supply the regions out of order; they're sorted by plcrash_async_memory_source_regions_init() */
+    _regions[0] = (plcrash_async_memory_region_t) { TEST_REGION_BASE + (sizeof(_words[0]) * 3), sizeof(_words[2]), _words[2] };
+    _regions[1] = (plcrash_async_memory_region_t) { TEST_REGION_BASE, sizeof(_words[0]), _words[0] };
+    _regions[2] = (plcrash_async_memory_region_t) { TEST_REGION_BASE + sizeof(_words[0]), sizeof(_words[1]), _words[1] };
+}
+
+/**
+ * Test reads via a registered region source's task handle.
+ */
+- (void) testRegionRead {
+    plcrash_async_memory_source_t source;
+    uint32_t vals[2];
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_memory_source_regions_init(&source, _regions, 3), @"Failed to initialize source");
+    STAssertEquals(TEST_REGION_BASE, _regions[0].address, @"Regions were not sorted");
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_memory_source_register(&source), @"Failed to register source");
+    task_t task = plcrash_async_memory_source_task(&source);
+    STAssertTrue(plcrash_async_memory_source_lookup(task) == &source, @"Source was not registered");
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_task_memcpy(task, TEST_REGION_BASE, sizeof(uint32_t) * 4, vals, sizeof(uint32_t)), @"Failed to read");
+    STAssertEquals((uint32_t) 4, vals[0], @"Incorrect value read");
+
+    /* Reads may span contiguous regions */
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_task_memcpy(task, TEST_REGION_BASE, sizeof(_words[0]) - sizeof(uint32_t), vals, sizeof(vals)), @"Failed to read across regions");
+    STAssertEquals((uint32_t) 255, vals[0], @"Incorrect value read");
+    STAssertEquals((uint32_t) (1 << 16), vals[1], @"Incorrect value read");
+
+    /* Reads spanning a gap must fail without copying any data */
+    vals[0] = UINT32_MAX;
+    STAssertEquals(PLCRASH_ENOTFOUND, plcrash_async_task_memcpy(task, TEST_REGION_BASE, (sizeof(_words[0]) * 2) - sizeof(uint32_t), vals, sizeof(vals)), @"Read across a gap succeeded");
+    STAssertEquals(UINT32_MAX, vals[0], @"Data was copied from a failed read");
+
+    STAssertEquals(PLCRASH_ENOTFOUND, plcrash_async_task_memcpy(task, 0, 0, vals, sizeof(uint32_t)), @"Read below all regions succeeded");
+
+    plcrash_async_memory_source_unregister(&source);
+    STAssertTrue(plcrash_async_memory_source_lookup(task) == NULL, @"Source was not unregistered");
+}
+
+/**
+ * Test memory objects mapped via a registered region source.
+ */
+- (void) testRegionMap {
+    plcrash_async_memory_source_t source;
+    plcrash_async_mobject_t mobj;
+    uint32_t val;
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_memory_source_regions_init(&source, _regions, 3), @"Failed to initialize source");
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_memory_source_register(&source), @"Failed to register source");
+    task_t task = plcrash_async_memory_source_task(&source);
+
+    pl_vm_address_t addr = TEST_REGION_BASE + sizeof(_words[0]) + sizeof(uint32_t) * 8;
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_mobject_init(&mobj, task, addr, sizeof(uint32_t) * 4, true), @"Failed to map");
+    STAssertEquals((pl_vm_address_t) sizeof(uint32_t) * 4, plcrash_async_mobject_length(&mobj), @"Incorrect length");
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_mobject_read_uint32(&mobj, &plcrash_async_byteorder_direct, addr, sizeof(uint32_t), &val), @"Failed to read");
+    STAssertEquals((uint32_t) ((1 << 16) | 9), val, @"Incorrect value read");
+    STAssertTrue(plcrash_async_mobject_remap_address(&mobj, addr, 0, 1) == &_words[1][8], @"Mapping was not served from the region buffer");
+    plcrash_async_mobject_free(&mobj);
+
+    /* Mappings of a region that does not begin on a page boundary must not extend below the region buffer */
+    addr = TEST_REGION_BASE + sizeof(_words[0]);
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_mobject_init(&mobj, task, addr, sizeof(uint32_t), true), @"Failed to map");
+    STAssertEquals((pl_vm_address_t) (uintptr_t) _words[1], mobj.vm_address, @"Mapping extended below the region buffer");
+    STAssertEquals((pl_vm_size_t) sizeof(_words[1]), mobj.vm_length, @"Incorrect mapping length");
+    plcrash_async_mobject_free(&mobj);
+    addr = TEST_REGION_BASE + sizeof(_words[0]) + sizeof(uint32_t) * 8;
+
+    /* Full mappings may not extend past the end of a region; short mappings are truncated */
+    STAssertNotEquals(PLCRASH_ESUCCESS, plcrash_async_mobject_init(&mobj, task, addr, sizeof(_words[1]), true), @"Mapped past the end of a region");
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_mobject_init(&mobj, task, addr, sizeof(_words[1]), false), @"Failed to map");
+    STAssertEquals((pl_vm_address_t) sizeof(_words[1]) - sizeof(uint32_t) * 8, plcrash_async_mobject_length(&mobj), @"Incorrect short mapping length");
+    plcrash_async_mobject_free(&mobj);
+
+    plcrash_async_memory_source_unregister(&source);
+}
+
+/**
+ * Test that invalid region tables are rejected.
+ */
+- (void) testRegionValidation {
+    plcrash_async_memory_source_t source;
+
+    _regions[0].address = TEST_REGION_BASE + sizeof(uint32_t);
+    STAssertEquals(PLCRASH_EINVAL, plcrash_async_memory_source_regions_init(&source, _regions, 3), @"Accepted overlapping regions");
+
+    [self setUp];
+    _regions[0].length = 0;
+    STAssertEquals(PLCRASH_EINVAL, plcrash_async_memory_source_regions_init(&source, _regions, 3), @"Accepted an empty region");
+}
+
+/**
+ * Test a live task source, which must behave identically to reading the task directly.
+ */
+- (void) testTaskSource {
+    plcrash_async_memory_source_t source;
+    plcrash_async_mobject_t mobj;
+    uint32_t val;
+
+    plcrash_async_memory_source_task_init(&source, mach_task_self());
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_memory_source_register(&source), @"Failed to register source");
+    task_t task = plcrash_async_memory_source_task(&source);
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_task_memcpy(task, (pl_vm_address_t) _words[1], sizeof(uint32_t) * 3, &val, sizeof(val)), @"Failed to read");
+    STAssertEquals((uint32_t) ((1 << 16) | 3), val, @"Incorrect value read");
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_mobject_init(&mobj, task, (pl_vm_address_t) _words[2], sizeof(_words[2]), true), @"Failed to map");
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_mobject_read_uint32(&mobj, &plcrash_async_byteorder_direct, (pl_vm_address_t) _words[2], sizeof(uint32_t) * 5, &val), @"Failed to read");
+    STAssertEquals((uint32_t) ((2 << 16) | 5), val, @"Incorrect value read");
+    plcrash_async_mobject_free(&mobj);
+
+    plcrash_async_memory_source_unregister(&source);
+}
+
+/**
+ * Test that registration is bounded, and that live task ports are never treated as source handles.
+ */
+- (void) testRegistration {
+    plcrash_async_memory_source_t sources[PLCRASH_ASYNC_MEMORY_SOURCE_MAX + 1];
+
+    for (size_t i = 0; i < PLCRASH_ASYNC_MEMORY_SOURCE_MAX; i++) {
+        plcrash_async_memory_source_task_init(&sources[i], mach_task_self());
+        STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_memory_source_register(&sources[i]), @"Failed to register source");
+    }
+
+    plcrash_async_memory_source_task_init(&sources[PLCRASH_ASYNC_MEMORY_SOURCE_MAX], mach_task_self());
+    STAssertEquals(PLCRASH_ENOMEM, plcrash_async_memory_source_register(&sources[PLCRASH_ASYNC_MEMORY_SOURCE_MAX]), @"Registered too many sources");
+    STAssertEquals((task_t) MACH_PORT_NULL, plcrash_async_memory_source_task(&sources[PLCRASH_ASYNC_MEMORY_SOURCE_MAX]), @"Unregistered source was assigned a handle");
+
+    STAssertTrue(plcrash_async_memory_source_lookup(mach_task_self()) == NULL, @"Task port was treated as a source handle");
+
+    /* Handles are reserved dead names, and never alias a live port */
+    mach_port_type_t type;
+    STAssertEquals(KERN_SUCCESS, mach_port_type(mach_task_self(), plcrash_async_memory_source_task(&sources[0]), &type), @"Handle name was not reserved");
+    STAssertEquals((mach_port_type_t) MACH_PORT_TYPE_DEAD_NAME, type, @"Handle was not a dead name");
+
+    for (size_t i = 0; i < PLCRASH_ASYNC_MEMORY_SOURCE_MAX; i++)
+        plcrash_async_memory_source_unregister(&sources[i]);
+}
+
+/**
+ * Test reading a Mach-O image from disk, via the regions of its file-backed segments.
+ */
+- (void) testMachOFile {
+    const pl_vm_address_t vmaddr = 0x100000000ULL;
+    const pl_vm_off_t slide = 0x4000;
+    uint8_t image[0x2000];
+
+    /* Build a minimal image, with a zero-fill segment following __TEXT */
+    memset(image, 0, sizeof(image));
+
+    struct mach_header_64 *header = (struct mach_header_64 *) image;
+    struct segment_command_64 *segs = (struct segment_command_64 *) (header + 1);
+    header->magic = MH_MAGIC_64;
+    header->filetype = MH_EXECUTE;
+    header->ncmds = 2;
+    header->sizeofcmds = sizeof(segs[0]) * 2;
+
+    segs[0].cmd = LC_SEGMENT_64;
+    segs[0].cmdsize = sizeof(segs[0]);
+    strlcpy(segs[0].segname, SEG_TEXT, sizeof(segs[0].segname));
+    segs[0].vmaddr = vmaddr;
+    segs[0].vmsize = sizeof(image);
+    segs[0].fileoff = 0;
+    segs[0].filesize = sizeof(image);
+
+    segs[1].cmd = LC_SEGMENT_64;
+    segs[1].cmdsize = sizeof(segs[1]);
+    strlcpy(segs[1].segname, SEG_DATA, sizeof(segs[1].segname));
+    segs[1].vmaddr = vmaddr + sizeof(image);
+    segs[1].vmsize = 0x1000;
+
+    uint32_t marker = 0xCAFEF00D;
+    memcpy(image + 0x1000, &marker, sizeof(marker));
+
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent: [[NSProcessInfo processInfo] globallyUniqueString]];
+    STAssertTrue([[NSData dataWithBytes: image length: sizeof(image)] writeToFile: path atomically: NO], @"Failed to write image");
+
+    /* Map the file */
+    plcrash_async_memory_file_t file;
+    plcrash_async_memory_region_t regions[4];
+    size_t count;
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_nasync_memory_file_open(&file, [path fileSystemRepresentation]), @"Failed to open file");
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_nasync_memory_file_macho_regions(&file, slide, regions, 4, &count), @"Failed to parse file");
+    STAssertEquals((size_t) 1, count, @"Zero-fill segment should not produce a region");
+    STAssertEquals(vmaddr + slide, regions[0].address, @"Incorrect region address");
+    STAssertEquals((pl_vm_size_t) sizeof(image), regions[0].length, @"Incorrect region length");
+
+    STAssertEquals(PLCRASH_ENOMEM, plcrash_nasync_memory_file_macho_regions(&file, slide, regions, 0, &count), @"Capacity was not checked");
+
+    /* Read the image via its task handle */
+    plcrash_async_memory_source_t source;
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_memory_source_regions_init(&source, regions, 1), @"Failed to initialize source");
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_memory_source_register(&source), @"Failed to register source");
+    task_t task = plcrash_async_memory_source_task(&source);
+
+    uint32_t val;
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_task_memcpy(task, vmaddr + slide, 0x1000, &val, sizeof(val)), @"Failed to read");
+    STAssertEquals(marker, val, @"Incorrect value read");
+
+    plcrash_async_macho_t macho;
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_nasync_macho_init(&macho, task, "test", vmaddr + slide), @"Failed to parse image");
+    STAssertEquals(slide, macho.vmaddr_slide, @"Incorrect slide");
+    STAssertEquals((pl_vm_size_t) sizeof(image), macho.text_size, @"Incorrect __TEXT size");
+    plcrash_nasync_macho_free(&macho);
+
+    plcrash_async_memory_source_unregister(&source);
+    plcrash_nasync_memory_file_close(&file);
+    [[NSFileManager defaultManager] removeItemAtPath: path error: NULL];
+}
+
+/**
+ * Test that the header of a dSYM companion file, which has no __TEXT contents, is served at its __TEXT address.
+ */
+- (void) testMachODSYMFile {
+    const pl_vm_address_t vmaddr = 0x100000000ULL;
+    uint8_t image[0x1000];
+
+    /* Build a minimal dSYM, with an empty __TEXT segment and a file-backed __LINKEDIT segment */
+    memset(image, 0, sizeof(image));
+
+    struct mach_header_64 *header = (struct mach_header_64 *) image;
+    struct segment_command_64 *segs = (struct segment_command_64 *) (header + 1);
+    header->magic = MH_MAGIC_64;
+    header->filetype = MH_DSYM;
+    header->ncmds = 2;
+    header->sizeofcmds = sizeof(segs[0]) * 2;
+
+    segs[0].cmd = LC_SEGMENT_64;
+    segs[0].cmdsize = sizeof(segs[0]);
+    strlcpy(segs[0].segname, SEG_TEXT, sizeof(segs[0].segname));
+    segs[0].vmaddr = vmaddr;
+    segs[0].vmsize = 0x4000;
+
+    segs[1].cmd = LC_SEGMENT_64;
+    segs[1].cmdsize = sizeof(segs[1]);
+    strlcpy(segs[1].segname, SEG_LINKEDIT, sizeof(segs[1].segname));
+    segs[1].vmaddr = vmaddr + 0x4000;
+    segs[1].vmsize = 0x800;
+    segs[1].fileoff = 0x800;
+    segs[1].filesize = 0x800;
+
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent: [[NSProcessInfo processInfo] globallyUniqueString]];
+    STAssertTrue([[NSData dataWithBytes: image length: sizeof(image)] writeToFile: path atomically: NO], @"Failed to write image");
+
+    plcrash_async_memory_file_t file;
+    plcrash_async_memory_region_t regions[4];
+    size_t count;
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_nasync_memory_file_open(&file, [path fileSystemRepresentation]), @"Failed to open file");
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_nasync_memory_file_macho_regions(&file, 0, regions, 4, &count), @"Failed to parse file");
+    STAssertEquals((size_t) 2, count, @"Header region was not produced");
+    STAssertEquals(vmaddr, regions[1].address, @"Incorrect header region address");
+    STAssertEquals((pl_vm_size_t) (sizeof(*header) + header->sizeofcmds), regions[1].length, @"Incorrect header region length");
+
+    STAssertEquals(PLCRASH_ENOMEM, plcrash_nasync_memory_file_macho_regions(&file, 0, regions, 1, &count), @"Capacity was not checked");
+
+    /* Parse the header via its task handle */
+    plcrash_async_memory_source_t source;
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_memory_source_regions_init(&source, regions, 2), @"Failed to initialize source");
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_memory_source_register(&source), @"Failed to register source");
+
+    plcrash_async_macho_t macho;
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_nasync_macho_init(&macho, plcrash_async_memory_source_task(&source), "test", vmaddr), @"Failed to parse dSYM");
+    STAssertEquals((pl_vm_off_t) 0, macho.vmaddr_slide, @"Incorrect slide");
+    plcrash_nasync_macho_free(&macho);
+
+    plcrash_async_memory_source_unregister(&source);
+    plcrash_nasync_memory_file_close(&file);
+    [[NSFileManager defaultManager] removeItemAtPath: path error: NULL];
+}
+
+@end
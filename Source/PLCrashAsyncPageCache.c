@@ -0,0 +1,285 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PLCrashAsyncPageCache.h"
+
+#include <stdatomic.h>
+
+/**
+ * @internal
+ * @ingroup plcrash_async
+ *
+ * Implements an async-safe cache of target task pages.
+ *
+ * @{
+ */
+
+/** The currently attached page cache, if any. */
+static plcrash_async_page_cache_t *_Atomic attached_page_cache = NULL;
+
+/**
+ * Initialize a new page cache, preallocating storage for @a capacity pages.
+ *
+ * @param cache The cache to initialize.
+ * @param capacity The number of pages to be cached. This will be rounded up to a multiple of
+ * PLCRASH_ASYNC_PAGE_CACHE_WAYS.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, or PLCRASH_ENOMEM if the cache storage could not be allocated.
+ *
+ * @warning This function is not async-safe, and must be called prior to report generation.
+ */
+plcrash_error_t plcrash_async_page_cache_init (plcrash_async_page_cache_t *cache, size_t capacity) {
+    plcrash_async_memset(cache, 0, sizeof(*cache));
+
+    /* Round up to a whole number of sets */
+    if (capacity == 0)
+        capacity = PLCRASH_ASYNC_PAGE_CACHE_WAYS;
+    capacity = ((capacity + PLCRASH_ASYNC_PAGE_CACHE_WAYS - 1) / PLCRASH_ASYNC_PAGE_CACHE_WAYS) * PLCRASH_ASYNC_PAGE_CACHE_WAYS;
+
+    /* Allocate the page data and entries as a single region; the page data is placed first to maintain its alignment. */
+    pl_vm_size_t data_size = capacity * PLCRASH_ASYNC_PAGE_CACHE_PAGE_SIZE;
+    pl_vm_size_t alloc_size = data_size + (capacity * sizeof(plcrash_async_page_cache_entry_t));
+
+    vm_address_t region;
+    kern_return_t kt = vm_allocate(mach_task_self(), &region, alloc_size, VM_FLAGS_ANYWHERE);
+    if (kt != KERN_SUCCESS) {
+        PLCF_DEBUG("Failed to allocate page cache storage: %d", kt);
+        return PLCRASH_ENOMEM;
+    }
+
+    cache->capacity = capacity;
+    cache->data = (uint8_t *) region;
+    cache->entries = (plcrash_async_page_cache_entry_t *) (region + data_size);
+    cache->allocation_size = alloc_size;
+
+    for (size_t i = 0; i < capacity; i++)
+        cache->entries[i].address = PL_VM_ADDRESS_INVALID;
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Free all resources associated with @a cache. The cache must not be attached.
+ *
+ * @param cache The cache to free.
+ */
+void plcrash_async_page_cache_free (plcrash_async_page_cache_t *cache) {
+    PLCF_ASSERT(atomic_load(&attached_page_cache) != cache);
+
+    if (cache->data != NULL)
+        vm_deallocate(mach_task_self(), (vm_address_t) cache->data, cache->allocation_size);
+
+    cache->data = NULL;
+    cache->entries = NULL;
+    cache->capacity = 0;
+}
+
+/**
+ * Attach @a cache to the current thread. Until the cache is detached via plcrash_async_page_cache_detach(), reads
+ * issued by the current thread via plcrash_async_task_memcpy() will be served via @a cache. Reads issued by any other
+ * thread are unaffected.
+ *
+ * All previously cached pages are discarded, and the cache counters are reset.
+ *
+ * @param cache The cache to attach.
+ *
+ * @return Returns true if the cache was attached, or false if another cache is already attached. Only one cache may be
+ * attached at a time.
+ */
+bool plcrash_async_page_cache_attach (plcrash_async_page_cache_t *cache) {
+    /* Only one cache may be attached at a time. The cache's state must not be modified until it has been claimed; if
+     * the swap fails, the cache may be in use by its current owner. */
+    plcrash_async_page_cache_t *expected = NULL;
+    if (!atomic_compare_exchange_strong(&attached_page_cache, &expected, cache))
+        return false;
+
+    /* Claim ownership before resetting the cache, so that no other thread will be served from it. */
+    cache->owner = pthread_self();
+    atomic_thread_fence(memory_order_seq_cst);
+
+    /* Discard any pages cached by a previous session; the target memory may have changed since. */
+    for (size_t i = 0; i < cache->capacity; i++)
+        cache->entries[i].address = PL_VM_ADDRESS_INVALID;
+
+    plcrash_async_memset(&cache->stats, 0, sizeof(cache->stats));
+    cache->use_counter = 0;
+
+    return true;
+}
+
+/**
+ * Detach @a cache from the current thread. Reads will no longer be served from @a cache. The cache's counters remain
+ * available until the cache is next attached.
+ *
+ * @param cache A cache previously attached via plcrash_async_page_cache_attach().
+ */
+void plcrash_async_page_cache_detach (plcrash_async_page_cache_t *cache) {
+    PLCF_ASSERT(atomic_load(&attached_page_cache) == cache);
+    atomic_compare_exchange_strong(&attached_page_cache, &cache, NULL);
+}
+
+/**
+ * Return the page cache attached to the current thread, or NULL if none.
+ */
+plcrash_async_page_cache_t *plcrash_async_page_cache_current (void) {
+    plcrash_async_page_cache_t *cache = atomic_load(&attached_page_cache);
+    if (cache == NULL || !pthread_equal(cache->owner, pthread_self()))
+        return NULL;
+
+    return cache;
+}
+
+/**
+ * @internal
+ *
+ * Return the cache entry for the page at @a page in @a task, reading the page into the cache if necessary. If the
+ * page can not be read, the returned entry's status will contain the read error.
+ *
+ * @param cache The target cache.
+ * @param task The task containing the page.
+ * @param page The page-aligned address of the page.
+ * @param[out] err On failure, the error returned by the task read. This is only set if NULL is returned.
+ *
+ * @return Returns the page's entry, or NULL if the page could not be read and the error can not be cached.
+ */
+static plcrash_async_page_cache_entry_t *plcrash_async_page_cache_lookup (plcrash_async_page_cache_t *cache, task_t task, pl_vm_address_t page, plcrash_error_t *err) {
+    size_t set_count = cache->capacity / PLCRASH_ASYNC_PAGE_CACHE_WAYS;
+    size_t set = (size_t) ((page / PLCRASH_ASYNC_PAGE_CACHE_PAGE_SIZE) % set_count);
+    plcrash_async_page_cache_entry_t *ways = &cache->entries[set * PLCRASH_ASYNC_PAGE_CACHE_WAYS];
+    plcrash_async_page_cache_entry_t *victim = &ways[0];
+
+    cache->use_counter++;
+
+    for (size_t i = 0; i < PLCRASH_ASYNC_PAGE_CACHE_WAYS; i++) {
+        plcrash_async_page_cache_entry_t *entry = &ways[i];
+
+        if (entry->address == page && entry->task == task) {
+            if (entry->status == PLCRASH_ESUCCESS)
+                cache->stats.hit_count++;
+            else
+                cache->stats.negative_hit_count++;
+
+            entry->last_use = cache->use_counter;
+            return entry;
+        }
+
+        /* Prefer an unused entry; otherwise, evict the least recently used entry */
+        if (victim->address == PL_VM_ADDRESS_INVALID)
+            continue;
+
+        if (entry->address == PL_VM_ADDRESS_INVALID || entry->last_use < victim->last_use)
+            victim = entry;
+    }
+
+    /* Fetch the page */
+    cache->stats.miss_count++;
+    if (victim->address != PL_VM_ADDRESS_INVALID)
+        cache->stats.eviction_count++;
+
+    uint8_t *data = cache->data + ((victim - cache->entries) * PLCRASH_ASYNC_PAGE_CACHE_PAGE_SIZE);
+    plcrash_error_t status = plcrash_async_task_memcpy_uncached(task, page, 0, data, PLCRASH_ASYNC_PAGE_CACHE_PAGE_SIZE);
+
+    /* Only cache successful reads, and failures that are a property of the page itself */
+    if (status != PLCRASH_ESUCCESS && status != PLCRASH_ENOTFOUND && status != PLCRASH_EACCESS) {
+        victim->address = PL_VM_ADDRESS_INVALID;
+        *err = status;
+        return NULL;
+    }
+
+    victim->task = task;
+    victim->address = page;
+    victim->status = status;
+    victim->last_use = cache->use_counter;
+
+    return victim;
+}
+
+/**
+ * Copy @a len bytes from @a task, at @a address + @a offset, storing in @a dest. Reads of up to
+ * PLCRASH_ASYNC_PAGE_CACHE_PAGE_SIZE bytes are served from (and if necessary, fetched into) @a cache; larger reads
+ * are performed directly via plcrash_async_task_memcpy_uncached().
+ *
+ * @param cache The page cache to be used.
+ * @param task The task from which data from address @a source will be read.
+ * @param address The base address within @a task from which the data will be read.
+ * @param offset The offset from @a address at which data will be read.
+ * @param dest The destination address to which copied data will be written.
+ * @param len The number of bytes to be read.
+ *
+ * @return Returns the same error values as plcrash_async_task_memcpy().
+ */
+plcrash_error_t plcrash_async_page_cache_memcpy (plcrash_async_page_cache_t *cache, task_t task, pl_vm_address_t address, pl_vm_off_t offset, void *dest, pl_vm_size_t len) {
+    pl_vm_address_t target;
+    plcrash_error_t err;
+
+    /* Compute the target address and check for overflow */
+    if (!plcrash_async_address_apply_offset(address, offset, &target))
+        return PLCRASH_ENOMEM;
+
+    /* Pass through any reads that can not be served from at most two cached pages */
+    if (len == 0 || len > PLCRASH_ASYNC_PAGE_CACHE_PAGE_SIZE || PL_VM_ADDRESS_MAX - target < len) {
+        cache->stats.bypass_count++;
+        return plcrash_async_task_memcpy_uncached(task, target, 0, dest, len);
+    }
+
+    /* Look up both pages prior to copying; as with a direct read, no data is copied if any page is unreadable. */
+    pl_vm_address_t first_page = target & ~((pl_vm_address_t) PLCRASH_ASYNC_PAGE_CACHE_PAGE_SIZE - 1);
+    pl_vm_address_t last_page = (target + len - 1) & ~((pl_vm_address_t) PLCRASH_ASYNC_PAGE_CACHE_PAGE_SIZE - 1);
+
+    plcrash_async_page_cache_entry_t *first = plcrash_async_page_cache_lookup(cache, task, first_page, &err);
+    if (first == NULL)
+        return err;
+    if (first->status != PLCRASH_ESUCCESS)
+        return first->status;
+
+    plcrash_async_page_cache_entry_t *last = first;
+    if (last_page != first_page) {
+        last = plcrash_async_page_cache_lookup(cache, task, last_page, &err);
+        if (last == NULL)
+            return err;
+        if (last->status != PLCRASH_ESUCCESS)
+            return last->status;
+    }
+
+    /* Copy out the data */
+    pl_vm_size_t first_len = len;
+    if (last != first)
+        first_len = last_page - target;
+
+    uint8_t *first_data = cache->data + ((first - cache->entries) * PLCRASH_ASYNC_PAGE_CACHE_PAGE_SIZE);
+    plcrash_async_memcpy(dest, first_data + (target - first_page), first_len);
+
+    if (last != first) {
+        uint8_t *last_data = cache->data + ((last - cache->entries) * PLCRASH_ASYNC_PAGE_CACHE_PAGE_SIZE);
+        plcrash_async_memcpy((uint8_t *) dest + first_len, last_data, len - first_len);
+    }
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PLCRASH_ASYNC_PAGE_CACHE_H
+#define PLCRASH_ASYNC_PAGE_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "PLCrashAsync.h"
+
+/**
+ * @ingroup plcrash_async
+ *
+ * Size of a single cached page, in bytes. This is the smallest page size supported by any target; reads are aligned
+ * to this size, and so never cross a hardware page boundary.
+ */
+#define PLCRASH_ASYNC_PAGE_CACHE_PAGE_SIZE 4096
+
+/**
+ * @ingroup plcrash_async
+ *
+ * Number of entries in each set of the cache. Each page address maps to a single set, and is cached in the least
+ * recently used entry within that set.
+ */
+#define PLCRASH_ASYNC_PAGE_CACHE_WAYS 4
+
+/**
+ * @ingroup plcrash_async
+ *
+ * The default number of pages cached by a report-generation page cache.
+ */
+#define PLCRASH_ASYNC_PAGE_CACHE_DEFAULT_CAPACITY 64
+
+/**
+ * @internal
+ * @ingroup plcrash_async
+ *
+ * A single page cache entry.
+ */
+typedef struct plcrash_async_page_cache_entry {
+    /** The task from which the page was read. */
+    task_t task;
+
+    /** The task-relative page address, or PL_VM_ADDRESS_INVALID if the entry is unused. */
+    pl_vm_address_t address;
+
+    /** PLCRASH_ESUCCESS if the page data is available, or the error returned when the page was read. */
+    plcrash_error_t status;
+
+    /** The value of the cache's use counter at the time of the entry's most recent use. */
+    uint64_t last_use;
+} plcrash_async_page_cache_entry_t;
+
+/**
+ * @internal
+ * @ingroup plcrash_async
+ *
+ * Page cache counters.
+ */
+typedef struct plcrash_async_page_cache_stats {
+    /** Number of page lookups served from cached page data. */
+    uint64_t hit_count;
+
+    /** Number of page lookups served from a cached read failure, without issuing a task read. */
+    uint64_t negative_hit_count;
+
+    /** Number of page lookups that required a task read. */
+    uint64_t miss_count;
+
+    /** Number of cached pages evicted to make room for a newly read page. */
+    uint64_t eviction_count;
+
+    /** Number of reads that were too large to be cached, and were passed through to the task. */
+    uint64_t bypass_count;
+} plcrash_async_page_cache_stats_t;
+
+/**
+ * @internal
+ * @ingroup plcrash_async
+ *
+ * An async-safe, fixed-capacity cache of target task pages.
+ *
+ * Report generation issues a large number of small reads (frame records, register-referenced memory, Objective-C
+ * metadata) that are clustered on a small number of pages. While a cache is attached to the current thread via
+ * plcrash_async_page_cache_attach(), reads of up to PLCRASH_ASYNC_PAGE_CACHE_PAGE_SIZE bytes issued via
+ * plcrash_async_task_memcpy() are served from whole cached pages; pages that could not be read are also cached, so
+ * that invalid addresses are only probed once.
+ *
+ * All storage is allocated by plcrash_async_page_cache_init(); no allocation is performed once the cache has been
+ * initialized. The cache does not observe changes to target memory, and should only be attached while the target
+ * task's threads are suspended.
+ */
+typedef struct plcrash_async_page_cache {
+    /** The number of cached pages. This is a multiple of PLCRASH_ASYNC_PAGE_CACHE_WAYS. */
+    size_t capacity;
+
+    /** Cache entries, grouped into sets of PLCRASH_ASYNC_PAGE_CACHE_WAYS entries. */
+    plcrash_async_page_cache_entry_t *entries;
+
+    /** Page data; the data for entries[i] is found at data + (i * PLCRASH_ASYNC_PAGE_CACHE_PAGE_SIZE). */
+    uint8_t *data;
+
+    /** The total size of the allocation backing @a entries and @a data. */
+    pl_vm_size_t allocation_size;
+
+    /** The thread to which the cache is attached. Only valid while the cache is attached. */
+    pthread_t owner;
+
+    /** Monotonically increasing use counter, used to select the least recently used entry for eviction. */
+    uint64_t use_counter;
+
+    /** Cache counters. These are reset when the cache is attached. */
+    plcrash_async_page_cache_stats_t stats;
+} plcrash_async_page_cache_t;
+
+plcrash_error_t plcrash_async_page_cache_init (plcrash_async_page_cache_t *cache, size_t capacity);
+void plcrash_async_page_cache_free (plcrash_async_page_cache_t *cache);
+
+bool plcrash_async_page_cache_attach (plcrash_async_page_cache_t *cache);
+void plcrash_async_page_cache_detach (plcrash_async_page_cache_t *cache);
+plcrash_async_page_cache_t *plcrash_async_page_cache_current (void);
+
+plcrash_error_t plcrash_async_page_cache_memcpy (plcrash_async_page_cache_t *cache, task_t task, pl_vm_address_t address, pl_vm_off_t offset, void *dest, pl_vm_size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLCRASH_ASYNC_PAGE_CACHE_H */
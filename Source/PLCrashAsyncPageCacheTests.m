@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "SenTestCompat.h"
+
+#import "PLCrashAsyncPageCache.h"
+#import "PLCrashFeatureConfig.h"
+
+@interface PLCrashAsyncPageCacheTests : SenTestCase {
+@private
+    /** Page-aligned test allocation. */
+    vm_address_t _region;
+
+    /** Size of the readable test allocation; this spans more cache pages than a single cache set. A guard page
+     * follows the readable range. */
+    vm_size_t _region_size;
+
+    /** The cache under test. */
+    plcrash_async_page_cache_t _cache;
+}
+@end
+
+@implementation PLCrashAsyncPageCacheTests
+
+- (void) setUp {
+    _region_size = ((PLCRASH_ASYNC_PAGE_CACHE_WAYS + 1) * PLCRASH_ASYNC_PAGE_CACHE_PAGE_SIZE + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+    STAssertEquals(KERN_SUCCESS, vm_allocate(mach_task_self(), &_region, _region_size + PAGE_SIZE, VM_FLAGS_ANYWHERE), @"Failed to allocate test pages");
+    STAssertEquals(KERN_SUCCESS, vm_protect(mach_task_self(), _region + _region_size, PAGE_SIZE, false, VM_PROT_NONE), @"Failed to protect guard page");
+
+    uint32_t *words = (uint32_t *) _region;
+    for (uint32_t i = 0; i < _region_size / sizeof(uint32_t); i++)
+        words[i] = i;
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_page_cache_init(&_cache, PLCRASH_ASYNC_PAGE_CACHE_DEFAULT_CAPACITY), @"Failed to initialize cache");
+}
+
+- (void) tearDown {
+    if (plcrash_async_page_cache_current() == &_cache)
+        plcrash_async_page_cache_detach(&_cache);
+
+    plcrash_async_page_cache_free(&_cache);
+    vm_deallocate(mach_task_self(), _region, _region_size + PAGE_SIZE);
+}
+
+/**
+ * Verify that plcrash_async_task_memcpy() is only served from an attached cache.
+ */
+- (void) testAttach {
+    STAssertTrue(plcrash_async_page_cache_current() == NULL, @"Cache should not be attached");
+
+    STAssertTrue(plcrash_async_page_cache_attach(&_cache), @"Failed to attach cache");
+    STAssertTrue(plcrash_async_page_cache_current() == &_cache, @"Cache should be attached");
+
+    /* Only one cache may be attached at a time */
+    plcrash_async_page_cache_t other;
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_page_cache_init(&other, PLCRASH_ASYNC_PAGE_CACHE_WAYS), @"Failed to initialize cache");
+    STAssertFalse(plcrash_async_page_cache_attach(&other), @"Attached a second cache");
+    plcrash_async_page_cache_free(&other);
+
+    uint32_t val;
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_task_memcpy(mach_task_self(), _region, sizeof(uint32_t) * 4, &val, sizeof(val)), @"Failed to read");
+    STAssertEquals((uint32_t) 4, val, @"Incorrect value read");
+    STAssertEquals((uint64_t) 1, _cache.stats.miss_count, @"Read was not served via the cache");
+
+    /* A failed attach must not reset the state of the attached cache */
+    STAssertFalse(plcrash_async_page_cache_attach(&_cache), @"Attached an already-attached cache");
+    STAssertEquals((uint64_t) 1, _cache.stats.miss_count, @"Failed attach reset the attached cache's counters");
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_task_memcpy(mach_task_self(), _region, sizeof(uint32_t) * 4, &val, sizeof(val)), @"Failed to read");
+    STAssertEquals((uint64_t) 1, _cache.stats.hit_count, @"Failed attach discarded the attached cache's pages");
+
+    plcrash_async_page_cache_detach(&_cache);
+    STAssertTrue(plcrash_async_page_cache_current() == NULL, @"Cache should not be attached");
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_task_memcpy(mach_task_self(), _region, sizeof(uint32_t) * 5, &val, sizeof(val)), @"Failed to read");
+    STAssertEquals((uint32_t) 5, val, @"Incorrect value read");
+    STAssertEquals((uint64_t) 1, _cache.stats.hit_count, @"Read was served from a detached cache");
+}
+
+/**
+ * Verify that repeated reads of a page are served from the cache, and that attaching the cache discards previously
+ * cached pages.
+ */
+- (void) testCachedRead {
+    uint32_t *words = (uint32_t *) _region;
+    uint32_t val;
+
+    STAssertTrue(plcrash_async_page_cache_attach(&_cache), @"Failed to attach cache");
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_page_cache_memcpy(&_cache, mach_task_self(), _region, sizeof(uint32_t) * 8, &val, sizeof(val)), @"Failed to read");
+    STAssertEquals((uint32_t) 8, val, @"Incorrect value read");
+
+    /* Modify the backing memory; the cached copy should be returned. */
+    words[9] = UINT32_MAX;
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_page_cache_memcpy(&_cache, mach_task_self(), _region, sizeof(uint32_t) * 9, &val, sizeof(val)), @"Failed to read");
+    STAssertEquals((uint32_t) 9, val, @"Value was not served from the cache");
+
+    STAssertEquals((uint64_t) 1, _cache.stats.miss_count, @"Incorrect miss count");
+    STAssertEquals((uint64_t) 1, _cache.stats.hit_count, @"Incorrect hit count");
+
+    /* Re-attaching should discard the cached page */
+    plcrash_async_page_cache_detach(&_cache);
+    STAssertTrue(plcrash_async_page_cache_attach(&_cache), @"Failed to attach cache");
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_page_cache_memcpy(&_cache, mach_task_self(), _region, sizeof(uint32_t) * 9, &val, sizeof(val)), @"Failed to read");
+    STAssertEquals(UINT32_MAX, val, @"Stale value was returned after re-attaching");
+}
+
+/**
+ * Verify reads that span two cached pages.
+ */
+- (void) testCrossPageRead {
+    uint32_t vals[4];
+
+    pl_vm_off_t offset = PLCRASH_ASYNC_PAGE_CACHE_PAGE_SIZE - (sizeof(uint32_t) * 2);
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_page_cache_memcpy(&_cache, mach_task_self(), _region, offset, vals, sizeof(vals)), @"Failed to read");
+
+    for (uint32_t i = 0; i < 4; i++)
+        STAssertEquals((uint32_t) (offset / sizeof(uint32_t)) + i, vals[i], @"Incorrect value read at index %" PRIu32, i);
+
+    STAssertEquals((uint64_t) 2, _cache.stats.miss_count, @"Expected both pages to be read");
+}
+
+/**
+ * Verify that unreadable pages are cached, and are not read again.
+ */
+- (void) testNegativeCache {
+    plcrash_async_read_stats_t start_stats, end_stats;
+    uint32_t val;
+
+    plcrash_error_t err = plcrash_async_page_cache_memcpy(&_cache, mach_task_self(), _region, _region_size, &val, sizeof(val));
+    STAssertNotEquals(PLCRASH_ESUCCESS, err, @"Read of guard page succeeded");
+
+    plcrash_async_read_stats_get(&start_stats);
+    STAssertEquals(err, plcrash_async_page_cache_memcpy(&_cache, mach_task_self(), _region, _region_size + sizeof(uint32_t), &val, sizeof(val)), @"Cached read returned a different error");
+    plcrash_async_read_stats_get(&end_stats);
+
+    STAssertEquals((uint64_t) 1, _cache.stats.negative_hit_count, @"Read was not served from the negative cache");
+#if PLCRASH_FEATURE_READ_STATISTICS
+    STAssertEquals(start_stats.read_count, end_stats.read_count, @"Unreadable page was read again");
+#endif
+
+    /* A read spanning a readable and an unreadable page must fail without copying any data */
+    uint32_t vals[2] = { UINT32_MAX, UINT32_MAX };
+    STAssertEquals(err, plcrash_async_page_cache_memcpy(&_cache, mach_task_self(), _region, _region_size - sizeof(uint32_t), vals, sizeof(vals)), @"Spanning read did not fail");
+    STAssertEquals(UINT32_MAX, vals[0], @"Data was copied from a failed read");
+}
+
+/**
+ * Verify that the least recently used page is evicted from a full set.
+ */
+- (void) testEviction {
+    plcrash_async_page_cache_t cache;
+    uint32_t val;
+
+    /* Use a single set, so that all pages compete for the same entries */
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_page_cache_init(&cache, 1), @"Failed to initialize cache");
+    STAssertEquals((size_t) PLCRASH_ASYNC_PAGE_CACHE_WAYS, cache.capacity, @"Capacity was not rounded up to a full set");
+
+    /* Fill the set, then touch the first page so that the second becomes the least recently used */
+    for (uint32_t i = 0; i < PLCRASH_ASYNC_PAGE_CACHE_WAYS; i++)
+        STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_page_cache_memcpy(&cache, mach_task_self(), _region, i * PLCRASH_ASYNC_PAGE_CACHE_PAGE_SIZE, &val, sizeof(val)), @"Failed to read");
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_page_cache_memcpy(&cache, mach_task_self(), _region, 0, &val, sizeof(val)), @"Failed to read");
+
+    STAssertEquals((uint64_t) PLCRASH_ASYNC_PAGE_CACHE_WAYS, cache.stats.miss_count, @"Incorrect miss count");
+    STAssertEquals((uint64_t) 1, cache.stats.hit_count, @"Incorrect hit count");
+    STAssertEquals((uint64_t) 0, cache.stats.eviction_count, @"Unexpected eviction");
+
+    /* Reading a new page must evict the second page, leaving the first page cached */
+    pl_vm_off_t offset = PLCRASH_ASYNC_PAGE_CACHE_WAYS * PLCRASH_ASYNC_PAGE_CACHE_PAGE_SIZE;
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_page_cache_memcpy(&cache, mach_task_self(), _region, offset, &val, sizeof(val)), @"Failed to read");
+    STAssertEquals((uint32_t) (offset / sizeof(uint32_t)), val, @"Incorrect value read");
+    STAssertEquals((uint64_t) 1, cache.stats.eviction_count, @"Incorrect eviction count");
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_page_cache_memcpy(&cache, mach_task_self(), _region, 0, &val, sizeof(val)), @"Failed to read");
+    STAssertEquals((uint64_t) 2, cache.stats.hit_count, @"Most recently used page was evicted");
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_page_cache_memcpy(&cache, mach_task_self(), _region, PLCRASH_ASYNC_PAGE_CACHE_PAGE_SIZE, &val, sizeof(val)), @"Failed to read");
+    STAssertEquals((uint64_t) PLCRASH_ASYNC_PAGE_CACHE_WAYS + 2, cache.stats.miss_count, @"Least recently used page was not evicted");
+
+    plcrash_async_page_cache_free(&cache);
+}
+
+/**
+ * Verify that reads larger than a page bypass the cache.
+ */
+- (void) testBypass {
+    uint8_t buffer[PLCRASH_ASYNC_PAGE_CACHE_PAGE_SIZE + sizeof(uint32_t)];
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_page_cache_memcpy(&_cache, mach_task_self(), _region, 0, buffer, sizeof(buffer)), @"Failed to read");
+    STAssertEquals((uint64_t) 1, _cache.stats.bypass_count, @"Read was not passed through");
+    STAssertEquals((uint64_t) 0, _cache.stats.miss_count, @"Read was cached");
+}
+
+/**
+ * Verify that overflow is safely handled.
+ */
+- (void) testOverflow {
+    uint32_t val;
+    STAssertEquals(PLCRASH_ENOMEM, plcrash_async_page_cache_memcpy(&_cache, mach_task_self(), PL_VM_ADDRESS_MAX, 1, &val, sizeof(val)), @"Bad read was performed");
+}
+
+@end
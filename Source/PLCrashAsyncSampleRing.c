@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PLCrashAsyncSampleRing.h"
+
+#include <libkern/OSAtomic.h>
+
+/**
+ * @internal
+ * @ingroup plcrash_async
+ *
+ * Implements a lock-free ring of stack samples.
+ *
+ * @{
+ */
+
+/**
+ * Initialize a new sample ring, preallocating storage for @a capacity samples.
+ *
+ * @param ring The ring to initialize.
+ * @param capacity The number of samples that may be buffered. This will be rounded up to a power of two.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, or PLCRASH_ENOMEM if the ring storage could not be allocated.
+ *
+ * @warning This function is not async-safe, and must be called prior to sampling.
+ */
+plcrash_error_t plcrash_async_sample_ring_init (plcrash_async_sample_ring_t *ring, uint32_t capacity) {
+    plcrash_async_memset(ring, 0, sizeof(*ring));
+
+    /* Round up to a power of two, allowing slot indices to be derived by masking the free-running counters */
+    uint32_t slots = 1;
+    while (slots < capacity && slots < (UINT32_MAX / 2) + 1)
+        slots <<= 1;
+
+    pl_vm_size_t alloc_size = slots * sizeof(plcrash_async_sample_t);
+
+    vm_address_t region;
+    kern_return_t kt = vm_allocate(mach_task_self(), &region, alloc_size, VM_FLAGS_ANYWHERE);
+    if (kt != KERN_SUCCESS) {
+        PLCF_DEBUG("Failed to allocate sample ring storage: %d", kt);
+        return PLCRASH_ENOMEM;
+    }
+
+    ring->samples = (plcrash_async_sample_t *) region;
+    ring->capacity = slots;
+    ring->allocation_size = alloc_size;
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Free all resources associated with @a ring. Neither the producer nor the consumer may be accessing the ring.
+ *
+ * @param ring The ring to free.
+ */
+void plcrash_async_sample_ring_free (plcrash_async_sample_ring_t *ring) {
+    if (ring->samples != NULL)
+        vm_deallocate(mach_task_self(), (vm_address_t) ring->samples, ring->allocation_size);
+
+    ring->samples = NULL;
+    ring->capacity = 0;
+}
+
+/**
+ * Reserve the next free sample slot. The sample may be recorded in place, and then published via
+ * plcrash_async_sample_ring_commit(). A reserved slot that is never committed is simply reused by the next
+ * reservation.
+ *
+ * This function may only be called by the ring's single producer.
+ *
+ * @param ring The sample ring.
+ *
+ * @return Returns the reserved slot, or NULL if the ring is full. If the ring is full, the dropped sample is counted.
+ */
+plcrash_async_sample_t *plcrash_async_sample_ring_reserve (plcrash_async_sample_ring_t *ring) {
+    uint32_t head = ring->head;
+
+    if (head - ring->tail >= ring->capacity) {
+        ring->dropped++;
+        return NULL;
+    }
+
+    /* Ensure that the consumer's reads of this slot have completed before it is overwritten */
+    OSMemoryBarrier();
+
+    return &ring->samples[head & (ring->capacity - 1)];
+}
+
+/**
+ * Publish the sample previously reserved via plcrash_async_sample_ring_reserve(), making it visible to the consumer.
+ *
+ * This function may only be called by the ring's single producer.
+ *
+ * @param ring The sample ring.
+ */
+void plcrash_async_sample_ring_commit (plcrash_async_sample_ring_t *ring) {
+    PLCF_ASSERT(ring->head - ring->tail < ring->capacity);
+
+    /* Ensure that the sample is visible before it is published */
+    OSMemoryBarrier();
+    ring->head = ring->head + 1;
+}
+
+/**
+ * Return the oldest published sample, or NULL if the ring is empty. The sample remains valid until released via
+ * plcrash_async_sample_ring_consume().
+ *
+ * This function may only be called by the ring's single consumer.
+ *
+ * @param ring The sample ring.
+ */
+const plcrash_async_sample_t *plcrash_async_sample_ring_peek (plcrash_async_sample_ring_t *ring) {
+    uint32_t tail = ring->tail;
+
+    if (ring->head == tail)
+        return NULL;
+
+    /* Ensure that the sample data is not read before its publication */
+    OSMemoryBarrier();
+
+    return &ring->samples[tail & (ring->capacity - 1)];
+}
+
+/**
+ * Release the sample returned by plcrash_async_sample_ring_peek(), making its slot available to the producer.
+ *
+ * This function may only be called by the ring's single consumer.
+ *
+ * @param ring The sample ring.
+ */
+void plcrash_async_sample_ring_consume (plcrash_async_sample_ring_t *ring) {
+    PLCF_ASSERT(ring->head != ring->tail);
+
+    /* Ensure that all reads of the sample have completed before the slot is released */
+    OSMemoryBarrier();
+    ring->tail = ring->tail + 1;
+}
+
+/**
+ * Return the number of samples dropped because the ring was full.
+ *
+ * @param ring The sample ring.
+ */
+uint32_t plcrash_async_sample_ring_dropped (plcrash_async_sample_ring_t *ring) {
+    return ring->dropped;
+}
+
+/**
+ * @}
+ */
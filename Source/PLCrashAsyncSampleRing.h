@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PLCRASH_ASYNC_SAMPLE_RING_H
+#define PLCRASH_ASYNC_SAMPLE_RING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "PLCrashAsync.h"
+
+/**
+ * @ingroup plcrash_async
+ *
+ * The maximum number of frames recorded for a single stack sample. Deeper stacks are truncated, retaining the
+ * innermost frames.
+ */
+#define PLCRASH_ASYNC_SAMPLE_MAX_FRAMES 128
+
+/**
+ * @internal
+ * @ingroup plcrash_async
+ *
+ * A single stack sample.
+ */
+typedef struct plcrash_async_sample {
+    /** The mach_absolute_time() at which the sample was taken. */
+    uint64_t timestamp;
+
+    /** The index of the sampled thread, as assigned by the sampler. */
+    uint32_t thread_index;
+
+    /** The number of valid entries in @a pcs. */
+    uint32_t depth;
+
+    /** Sampled instruction pointers, ordered from the innermost frame outwards. */
+    pl_vm_address_t pcs[PLCRASH_ASYNC_SAMPLE_MAX_FRAMES];
+} plcrash_async_sample_t;
+
+/**
+ * @internal
+ * @ingroup plcrash_async
+ *
+ * A preallocated, lock-free, single-producer/single-consumer ring of stack samples.
+ *
+ * The producer (generally a sampling thread that has suspended its target thread) reserves a slot with
+ * plcrash_async_sample_ring_reserve(), records the sample in place, and publishes it with
+ * plcrash_async_sample_ring_commit(). The consumer reads published samples with plcrash_async_sample_ring_peek(), and
+ * releases them with plcrash_async_sample_ring_consume(). Neither side blocks or allocates; if the ring is full, the
+ * new sample is dropped and counted.
+ *
+ * All storage is allocated by plcrash_async_sample_ring_init().
+ */
+typedef struct plcrash_async_sample_ring {
+    /** Sample slots. */
+    plcrash_async_sample_t *samples;
+
+    /** The number of slots in @a samples. This is always a power of two. */
+    uint32_t capacity;
+
+    /** The total size of the allocation backing @a samples. */
+    pl_vm_size_t allocation_size;
+
+    /** The number of samples published by the producer. Only modified by the producer. */
+    volatile uint32_t head;
+
+    /** The number of samples released by the consumer. Only modified by the consumer. */
+    volatile uint32_t tail;
+
+    /** The number of samples dropped because the ring was full. Only modified by the producer. */
+    volatile uint32_t dropped;
+} plcrash_async_sample_ring_t;
+
+plcrash_error_t plcrash_async_sample_ring_init (plcrash_async_sample_ring_t *ring, uint32_t capacity);
+void plcrash_async_sample_ring_free (plcrash_async_sample_ring_t *ring);
+
+plcrash_async_sample_t *plcrash_async_sample_ring_reserve (plcrash_async_sample_ring_t *ring);
+void plcrash_async_sample_ring_commit (plcrash_async_sample_ring_t *ring);
+
+const plcrash_async_sample_t *plcrash_async_sample_ring_peek (plcrash_async_sample_ring_t *ring);
+void plcrash_async_sample_ring_consume (plcrash_async_sample_ring_t *ring);
+
+uint32_t plcrash_async_sample_ring_dropped (plcrash_async_sample_ring_t *ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLCRASH_ASYNC_SAMPLE_RING_H */
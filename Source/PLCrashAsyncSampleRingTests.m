@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "SenTestCompat.h"
+
+#import "PLCrashAsyncSampleRing.h"
+
+#import <pthread.h>
+
+@interface PLCrashAsyncSampleRingTests : SenTestCase {
+@private
+    /** The ring under test. */
+    plcrash_async_sample_ring_t _ring;
+}
+@end
+
+@implementation PLCrashAsyncSampleRingTests
+
+- (void) setUp {
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_sample_ring_init(&_ring, 3), @"Failed to initialize ring");
+}
+
+- (void) tearDown {
+    plcrash_async_sample_ring_free(&_ring);
+}
+
+/**
+ * Verify that the capacity is rounded up to a power of two.
+ */
+- (void) testCapacity {
+    STAssertEquals(_ring.capacity, (uint32_t) 4, @"Capacity was not rounded up");
+}
+
+/**
+ * Verify that samples are returned in order, and that samples are dropped and counted when the ring is full.
+ */
+- (void) testOrderingAndOverflow {
+    STAssertNULL(plcrash_async_sample_ring_peek(&_ring), @"Ring should be empty");
+
+    for (uint32_t i = 0; i < _ring.capacity; i++) {
+        plcrash_async_sample_t *sample = plcrash_async_sample_ring_reserve(&_ring);
+        STAssertNotNULL(sample, @"Failed to reserve sample %u", i);
+        sample->thread_index = i;
+        sample->depth = 1;
+        sample->pcs[0] = 0x1000 + i;
+        plcrash_async_sample_ring_commit(&_ring);
+    }
+
+    STAssertNULL(plcrash_async_sample_ring_reserve(&_ring), @"Reserved a slot in a full ring");
+    STAssertEquals(plcrash_async_sample_ring_dropped(&_ring), (uint32_t) 1, @"Dropped sample was not counted");
+
+    /* Drain half, and verify that the freed slots may be reused */
+    for (uint32_t i = 0; i < 2; i++) {
+        const plcrash_async_sample_t *sample = plcrash_async_sample_ring_peek(&_ring);
+        STAssertNotNULL(sample, @"Missing sample %u", i);
+        STAssertEquals(sample->thread_index, i, @"Samples returned out of order");
+        STAssertEquals(sample->pcs[0], (pl_vm_address_t) (0x1000 + i), @"Incorrect sample data");
+        plcrash_async_sample_ring_consume(&_ring);
+    }
+
+    plcrash_async_sample_t *sample = plcrash_async_sample_ring_reserve(&_ring);
+    STAssertNotNULL(sample, @"Failed to reserve a released slot");
+    sample->thread_index = 100;
+    plcrash_async_sample_ring_commit(&_ring);
+
+    uint32_t expected[] = { 2, 3, 100 };
+    for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++) {
+        const plcrash_async_sample_t *next = plcrash_async_sample_ring_peek(&_ring);
+        STAssertNotNULL(next, @"Missing sample %zu", i);
+        STAssertEquals(next->thread_index, expected[i], @"Samples returned out of order");
+        plcrash_async_sample_ring_consume(&_ring);
+    }
+
+    STAssertNULL(plcrash_async_sample_ring_peek(&_ring), @"Ring should be empty");
+}
+
+/**
+ * Verify that an uncommitted reservation is not visible to the consumer.
+ */
+- (void) testUncommittedReservation {
+    STAssertNotNULL(plcrash_async_sample_ring_reserve(&_ring), @"Failed to reserve a slot");
+    STAssertNULL(plcrash_async_sample_ring_peek(&_ring), @"Uncommitted sample was visible");
+}
+
+struct producer_ctx {
+    plcrash_async_sample_ring_t *ring;
+    uint32_t count;
+};
+
+static void *producer_thread (void *arg) {
+    struct producer_ctx *ctx = arg;
+
+    for (uint32_t i = 0; i < ctx->count; ) {
+        plcrash_async_sample_t *sample = plcrash_async_sample_ring_reserve(ctx->ring);
+        if (sample == NULL) {
+            sched_yield();
+            continue;
+        }
+
+        sample->thread_index = i;
+        sample->depth = 2;
+        sample->pcs[0] = i;
+        sample->pcs[1] = ~(pl_vm_address_t) i;
+        plcrash_async_sample_ring_commit(ctx->ring);
+        i++;
+    }
+
+    return NULL;
+}
+
+/**
+ * Verify that samples published by a concurrent producer are observed intact and in order.
+ */
+- (void) testConcurrentProducer {
+    struct producer_ctx ctx = { &_ring, 100000 };
+    pthread_t thr;
+    STAssertEquals(0, pthread_create(&thr, NULL, producer_thread, &ctx), @"Failed to start producer");
+
+    uint32_t next = 0;
+    while (next < ctx.count) {
+        const plcrash_async_sample_t *sample = plcrash_async_sample_ring_peek(&_ring);
+        if (sample == NULL) {
+            sched_yield();
+            continue;
+        }
+
+        if (sample->thread_index != next || sample->pcs[0] != next || sample->pcs[1] != ~(pl_vm_address_t) next) {
+            STFail(@"Sample %u was corrupt or out of order", next);
+            break;
+        }
+
+        plcrash_async_sample_ring_consume(&_ring);
+        next++;
+    }
+
+    pthread_join(thr, NULL);
+}
+
+@end
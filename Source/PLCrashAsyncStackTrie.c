@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PLCrashAsyncStackTrie.h"
+
+/**
+ * @internal
+ * @ingroup plcrash_async
+ *
+ * Implements a hash trie of sampled stacks.
+ *
+ * @{
+ */
+
+/**
+ * Return the bucket for the (@a parent, @a pc) node key.
+ */
+static inline uint32_t plcrash_async_stack_trie_bucket (plcrash_async_stack_trie_t *trie, uint32_t parent, pl_vm_address_t pc) {
+    uint64_t key = ((uint64_t) pc) ^ (((uint64_t) parent) << 32) ^ (((uint64_t) parent) >> 7);
+    return (uint32_t) ((key * 0x9E3779B97F4A7C15ULL) >> 32) & trie->bucket_mask;
+}
+
+/**
+ * Find the child of @a parent with the given @a pc, inserting a new node if none exists.
+ *
+ * @return Returns the node index, or PLCRASH_ASYNC_STACK_TRIE_ROOT if the trie is full.
+ */
+static uint32_t plcrash_async_stack_trie_child (plcrash_async_stack_trie_t *trie, uint32_t parent, pl_vm_address_t pc) {
+    uint32_t bucket = plcrash_async_stack_trie_bucket(trie, parent, pc);
+
+    for (uint32_t i = trie->buckets[bucket]; i != PLCRASH_ASYNC_STACK_TRIE_ROOT; i = trie->nodes[i].next) {
+        if (trie->nodes[i].pc == pc && trie->nodes[i].parent == parent)
+            return i;
+    }
+
+    if (trie->count == trie->capacity)
+        return PLCRASH_ASYNC_STACK_TRIE_ROOT;
+
+    uint32_t idx = trie->count++;
+    plcrash_async_stack_trie_node_t *node = &trie->nodes[idx];
+    node->pc = pc;
+    node->parent = parent;
+    node->self_count = 0;
+    node->total_count = 0;
+    node->next = trie->buckets[bucket];
+    trie->buckets[bucket] = idx;
+
+    return idx;
+}
+
+/**
+ * Initialize a new stack trie, preallocating storage for @a capacity nodes.
+ *
+ * @param trie The trie to initialize.
+ * @param capacity The maximum number of nodes, including the root node.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, PLCRASH_EINVAL if @a capacity is too small to hold the root node, or
+ * PLCRASH_ENOMEM if the trie storage could not be allocated.
+ *
+ * @warning This function is not async-safe.
+ */
+plcrash_error_t plcrash_async_stack_trie_init (plcrash_async_stack_trie_t *trie, uint32_t capacity) {
+    plcrash_async_memset(trie, 0, sizeof(*trie));
+
+    if (capacity < 2 || capacity > (UINT32_MAX / 2) + 1)
+        return PLCRASH_EINVAL;
+
+    /* Size the hash table to at least one bucket per node */
+    uint32_t buckets = 1;
+    while (buckets < capacity)
+        buckets <<= 1;
+
+    /* Allocate the nodes and buckets as a single region; the nodes are placed first to maintain their alignment. */
+    pl_vm_size_t nodes_size = capacity * sizeof(plcrash_async_stack_trie_node_t);
+    pl_vm_size_t alloc_size = nodes_size + (buckets * sizeof(uint32_t));
+
+    vm_address_t region;
+    kern_return_t kt = vm_allocate(mach_task_self(), &region, alloc_size, VM_FLAGS_ANYWHERE);
+    if (kt != KERN_SUCCESS) {
+        PLCF_DEBUG("Failed to allocate stack trie storage: %d", kt);
+        return PLCRASH_ENOMEM;
+    }
+
+    trie->nodes = (plcrash_async_stack_trie_node_t *) region;
+    trie->buckets = (uint32_t *) (region + nodes_size);
+    trie->capacity = capacity;
+    trie->bucket_mask = buckets - 1;
+    trie->allocation_size = alloc_size;
+
+    plcrash_async_stack_trie_reset(trie);
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Free all resources associated with @a trie.
+ *
+ * @param trie The trie to free.
+ */
+void plcrash_async_stack_trie_free (plcrash_async_stack_trie_t *trie) {
+    if (trie->nodes != NULL)
+        vm_deallocate(mach_task_self(), (vm_address_t) trie->nodes, trie->allocation_size);
+
+    trie->nodes = NULL;
+    trie->buckets = NULL;
+    trie->capacity = 0;
+    trie->count = 0;
+}
+
+/**
+ * Discard all recorded stacks, leaving only the root node.
+ *
+ * @param trie The trie to reset.
+ */
+void plcrash_async_stack_trie_reset (plcrash_async_stack_trie_t *trie) {
+    plcrash_async_memset(trie->buckets, 0, (trie->bucket_mask + 1) * sizeof(uint32_t));
+    plcrash_async_memset(&trie->nodes[PLCRASH_ASYNC_STACK_TRIE_ROOT], 0, sizeof(trie->nodes[0]));
+
+    trie->count = 1;
+    trie->sample_count = 0;
+    trie->dropped_count = 0;
+}
+
+/**
+ * Record a sampled stack.
+ *
+ * The stack is recorded beneath a thread node identified by @a thread_index, and the self and total counts of the
+ * stack's nodes are incremented. If the trie is full, the stack is not counted; any nodes that were inserted
+ * before the trie filled remain, with a zero count.
+ *
+ * @param trie The trie in which the stack will be recorded.
+ * @param thread_index The index of the sampled thread.
+ * @param pcs The sampled instruction pointers, ordered from the innermost frame outwards.
+ * @param depth The number of entries in @a pcs.
+ * @param leaf On success, will be set to the index of the node representing the innermost frame. May be NULL.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, or PLCRASH_ENOMEM if the trie is full.
+ */
+plcrash_error_t plcrash_async_stack_trie_insert (plcrash_async_stack_trie_t *trie,
+                                                 uint32_t thread_index,
+                                                 const pl_vm_address_t *pcs,
+                                                 uint32_t depth,
+                                                 uint32_t *leaf)
+{
+    /* Find or insert the thread node, and then each frame from the outermost inwards */
+    uint32_t node = plcrash_async_stack_trie_child(trie, PLCRASH_ASYNC_STACK_TRIE_ROOT, thread_index);
+    for (uint32_t i = depth; i > 0 && node != PLCRASH_ASYNC_STACK_TRIE_ROOT; i--)
+        node = plcrash_async_stack_trie_child(trie, node, pcs[i - 1]);
+
+    if (node == PLCRASH_ASYNC_STACK_TRIE_ROOT) {
+        trie->dropped_count++;
+        return PLCRASH_ENOMEM;
+    }
+
+    /* Update the counts along the path */
+    trie->nodes[node].self_count++;
+    for (uint32_t i = node; i != PLCRASH_ASYNC_STACK_TRIE_ROOT; i = trie->nodes[i].parent)
+        trie->nodes[i].total_count++;
+
+    trie->nodes[PLCRASH_ASYNC_STACK_TRIE_ROOT].total_count++;
+    trie->sample_count++;
+
+    if (leaf != NULL)
+        *leaf = node;
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * @}
+ */
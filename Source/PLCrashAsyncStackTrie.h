@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PLCRASH_ASYNC_STACK_TRIE_H
+#define PLCRASH_ASYNC_STACK_TRIE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "PLCrashAsync.h"
+
+/**
+ * @ingroup plcrash_async
+ *
+ * Index of the stack trie's root node. The root node has no address, and is never a member of a hash chain.
+ */
+#define PLCRASH_ASYNC_STACK_TRIE_ROOT 0
+
+/**
+ * @internal
+ * @ingroup plcrash_async
+ *
+ * A single stack trie node, representing a unique call path.
+ */
+typedef struct plcrash_async_stack_trie_node {
+    /** The frame's instruction pointer. For the thread nodes that are direct children of the root, this is instead the
+     * thread index supplied to plcrash_async_stack_trie_insert(). */
+    pl_vm_address_t pc;
+
+    /** Index of the parent node. */
+    uint32_t parent;
+
+    /** Index of the next node in the same hash bucket, or PLCRASH_ASYNC_STACK_TRIE_ROOT if this is the last. */
+    uint32_t next;
+
+    /** The number of samples whose innermost frame is this node. */
+    uint32_t self_count;
+
+    /** The number of samples that include this node. */
+    uint32_t total_count;
+} plcrash_async_stack_trie_node_t;
+
+/**
+ * @internal
+ * @ingroup plcrash_async
+ *
+ * A preallocated hash trie of sampled stacks.
+ *
+ * Each node is identified by its (parent, pc) pair, and nodes are found via a single open hash table keyed on that
+ * pair; inserting a stack of depth N requires N hash lookups, and stacks that share a common prefix share the nodes
+ * for that prefix. Nodes are allocated sequentially, and a node's parent always has a lower index than the node
+ * itself.
+ *
+ * All storage is allocated by plcrash_async_stack_trie_init(); no allocation is performed once the trie has been
+ * initialized.
+ */
+typedef struct plcrash_async_stack_trie {
+    /** Trie nodes; nodes[PLCRASH_ASYNC_STACK_TRIE_ROOT] is the root. */
+    plcrash_async_stack_trie_node_t *nodes;
+
+    /** The maximum number of nodes, including the root. */
+    uint32_t capacity;
+
+    /** The number of nodes in use, including the root. */
+    uint32_t count;
+
+    /** Hash buckets, each holding the index of the first node in its chain. */
+    uint32_t *buckets;
+
+    /** The number of buckets, minus one. The bucket count is always a power of two. */
+    uint32_t bucket_mask;
+
+    /** The total size of the allocation backing @a nodes and @a buckets. */
+    pl_vm_size_t allocation_size;
+
+    /** The number of stacks recorded in the trie. */
+    uint32_t sample_count;
+
+    /** The number of stacks that could not be recorded because the trie was full. */
+    uint32_t dropped_count;
+} plcrash_async_stack_trie_t;
+
+plcrash_error_t plcrash_async_stack_trie_init (plcrash_async_stack_trie_t *trie, uint32_t capacity);
+void plcrash_async_stack_trie_free (plcrash_async_stack_trie_t *trie);
+void plcrash_async_stack_trie_reset (plcrash_async_stack_trie_t *trie);
+
+plcrash_error_t plcrash_async_stack_trie_insert (plcrash_async_stack_trie_t *trie,
+                                                 uint32_t thread_index,
+                                                 const pl_vm_address_t *pcs,
+                                                 uint32_t depth,
+                                                 uint32_t *leaf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLCRASH_ASYNC_STACK_TRIE_H */
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "SenTestCompat.h"
+
+#import "PLCrashAsyncStackTrie.h"
+
+@interface PLCrashAsyncStackTrieTests : SenTestCase {
+@private
+    /** The trie under test. */
+    plcrash_async_stack_trie_t _trie;
+}
+@end
+
+@implementation PLCrashAsyncStackTrieTests
+
+- (void) setUp {
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_stack_trie_init(&_trie, 16), @"Failed to initialize trie");
+}
+
+- (void) tearDown {
+    plcrash_async_stack_trie_free(&_trie);
+}
+
+/**
+ * Verify that identical stacks share a single path, and that stacks with a common prefix share the prefix nodes.
+ */
+- (void) testDeduplication {
+    /* Stacks are ordered from the innermost frame outwards */
+    pl_vm_address_t stack_a[] = { 0x30, 0x20, 0x10 };
+    pl_vm_address_t stack_b[] = { 0x40, 0x20, 0x10 };
+    uint32_t leaf_a1, leaf_a2, leaf_b;
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_stack_trie_insert(&_trie, 0, stack_a, 3, &leaf_a1), @"Insert failed");
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_stack_trie_insert(&_trie, 0, stack_a, 3, &leaf_a2), @"Insert failed");
+    STAssertEquals(leaf_a1, leaf_a2, @"Identical stacks were not deduplicated");
+
+    /* root + thread + 0x10 + 0x20 + 0x30 */
+    STAssertEquals(_trie.count, (uint32_t) 5, @"Unexpected node count");
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_stack_trie_insert(&_trie, 0, stack_b, 3, &leaf_b), @"Insert failed");
+    STAssertEquals(_trie.count, (uint32_t) 6, @"Common prefix was not shared");
+
+    /* Verify the leaf paths */
+    STAssertEquals(_trie.nodes[leaf_a1].pc, (pl_vm_address_t) 0x30, @"Incorrect leaf");
+    STAssertEquals(_trie.nodes[leaf_b].pc, (pl_vm_address_t) 0x40, @"Incorrect leaf");
+    STAssertEquals(_trie.nodes[leaf_a1].parent, _trie.nodes[leaf_b].parent, @"Leaves should share a parent");
+
+    uint32_t caller = _trie.nodes[leaf_a1].parent;
+    STAssertEquals(_trie.nodes[caller].pc, (pl_vm_address_t) 0x20, @"Incorrect caller");
+    STAssertTrue(caller < leaf_a1 && caller < leaf_b, @"Parent should precede its children");
+
+    /* Verify the counts */
+    STAssertEquals(_trie.nodes[leaf_a1].self_count, (uint32_t) 2, @"Incorrect self count");
+    STAssertEquals(_trie.nodes[leaf_b].self_count, (uint32_t) 1, @"Incorrect self count");
+    STAssertEquals(_trie.nodes[caller].self_count, (uint32_t) 0, @"Incorrect self count");
+    STAssertEquals(_trie.nodes[caller].total_count, (uint32_t) 3, @"Incorrect total count");
+    STAssertEquals(_trie.nodes[PLCRASH_ASYNC_STACK_TRIE_ROOT].total_count, (uint32_t) 3, @"Incorrect root count");
+    STAssertEquals(_trie.sample_count, (uint32_t) 3, @"Incorrect sample count");
+}
+
+/**
+ * Verify that identical stacks from different threads are recorded separately.
+ */
+- (void) testThreads {
+    pl_vm_address_t stack[] = { 0x20, 0x10 };
+    uint32_t leaf_0, leaf_1;
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_stack_trie_insert(&_trie, 0, stack, 2, &leaf_0), @"Insert failed");
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_stack_trie_insert(&_trie, 1, stack, 2, &leaf_1), @"Insert failed");
+    STAssertNotEquals(leaf_0, leaf_1, @"Stacks from different threads were merged");
+
+    uint32_t thread_node = _trie.nodes[_trie.nodes[leaf_1].parent].parent;
+    STAssertEquals(_trie.nodes[thread_node].parent, (uint32_t) PLCRASH_ASYNC_STACK_TRIE_ROOT, @"Expected a thread node");
+    STAssertEquals(_trie.nodes[thread_node].pc, (pl_vm_address_t) 1, @"Incorrect thread index");
+}
+
+/**
+ * Verify that stacks are dropped and counted once the trie is full, and that reset discards all stacks.
+ */
+- (void) testFullAndReset {
+    pl_vm_address_t stack[20];
+    for (size_t i = 0; i < 20; i++)
+        stack[i] = 0x1000 + i;
+
+    /* 16 nodes can't hold root + thread + 20 frames */
+    STAssertEquals(PLCRASH_ENOMEM, plcrash_async_stack_trie_insert(&_trie, 0, stack, 20, NULL), @"Expected the trie to be full");
+    STAssertEquals(_trie.dropped_count, (uint32_t) 1, @"Dropped stack was not counted");
+    STAssertEquals(_trie.sample_count, (uint32_t) 0, @"Dropped stack was counted as a sample");
+    STAssertEquals(_trie.nodes[PLCRASH_ASYNC_STACK_TRIE_ROOT].total_count, (uint32_t) 0, @"Dropped stack was counted");
+
+    /* A stack that shares the existing prefix still fits */
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_stack_trie_insert(&_trie, 0, &stack[10], 10, NULL), @"Insert failed");
+
+    plcrash_async_stack_trie_reset(&_trie);
+    STAssertEquals(_trie.count, (uint32_t) 1, @"Reset did not discard nodes");
+    STAssertEquals(_trie.sample_count, (uint32_t) 0, @"Reset did not discard samples");
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_stack_trie_insert(&_trie, 0, stack, 14, NULL), @"Insert after reset failed");
+}
+
+/**
+ * Verify that a trie too small to hold any stack is rejected.
+ */
+- (void) testInvalidCapacity {
+    plcrash_async_stack_trie_t trie;
+    STAssertEquals(PLCRASH_EINVAL, plcrash_async_stack_trie_init(&trie, 1), @"Accepted an unusable capacity");
+}
+
+@end
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PLCrashAsyncStackWindow.h"
+
+#include <inttypes.h>
+
+/**
+ * @internal
+ * @ingroup plcrash_async
+ *
+ * Implements an async-safe read-ahead window over a thread's stack.
+ *
+ * @{
+ */
+
+/**
+ * Initialize a new stack window.
+ *
+ * @param window The window to initialize.
+ * @param task The task containing the target stack.
+ * @param sp The thread's stack pointer. Reads at addresses below @a sp will not be cached. If PL_VM_ADDRESS_INVALID,
+ * the window will be disabled, and all reads will be passed through to @a task.
+ */
+void plcrash_async_stack_window_init (plcrash_async_stack_window_t *window, task_t task, pl_vm_address_t sp) {
+    window->task = task;
+    window->floor = sp;
+    window->base = 0x0;
+    window->length = 0;
+}
+
+/**
+ * @internal
+ *
+ * Refill @a window with stack data beginning at @a start; the range of @a len bytes at @a target must
+ * fall within the refilled window.
+ *
+ * A full window read may extend beyond the top of the stack's mapped pages; in that case, the read is retried
+ * with the window truncated to the end of the page(s) containing the requested range.
+ */
+static plcrash_error_t plcrash_async_stack_window_fill (plcrash_async_stack_window_t *window, pl_vm_address_t start, pl_vm_address_t target, pl_vm_size_t len) {
+    plcrash_error_t err;
+    pl_vm_size_t fill_len = sizeof(window->data);
+
+    /* Drop any existing (possibly stale) data */
+    window->length = 0;
+
+    /* Clamp to the addressable range */
+    if (PL_VM_ADDRESS_MAX - start < fill_len)
+        fill_len = PL_VM_ADDRESS_MAX - start;
+
+    PLCF_ASSERT(fill_len >= (target - start) + len);
+
+    err = plcrash_async_task_memcpy(window->task, start, 0, window->data, fill_len);
+    if (err != PLCRASH_ESUCCESS) {
+        /* Retry, limiting the read to the pages containing the requested range. */
+        pl_vm_address_t page_end = ((target + len - 1) & ~((pl_vm_address_t) PAGE_SIZE - 1)) + PAGE_SIZE;
+        if (page_end > target && page_end - start < fill_len) {
+            fill_len = page_end - start;
+            err = plcrash_async_task_memcpy(window->task, start, 0, window->data, fill_len);
+        }
+
+        if (err != PLCRASH_ESUCCESS)
+            return err;
+    }
+
+    window->base = start;
+    window->length = fill_len;
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Copy @a len bytes from @a task, at @a address + @a offset, storing in @a dest. If the target range falls within
+ * the stack covered by @a window, the data will be served from (and if necessary, fetched into) the window; otherwise,
+ * the read is performed directly via plcrash_async_task_memcpy().
+ *
+ * @param window The stack window to be used, or NULL to read directly from @a task.
+ * @param task The task from which data from address @a source will be read.
+ * @param address The base address within @a task from which the data will be read.
+ * @param offset The offset from @a address at which data will be read.
+ * @param dest The destination address to which copied data will be written.
+ * @param len The number of bytes to be read.
+ *
+ * @return Returns the same error values as plcrash_async_task_memcpy().
+ */
+plcrash_error_t plcrash_async_stack_window_memcpy (plcrash_async_stack_window_t *window, task_t task, pl_vm_address_t address, pl_vm_off_t offset, void *dest, pl_vm_size_t len) {
+    pl_vm_address_t target;
+
+    /* Pass through any reads that can not be served from the window */
+    if (window == NULL || window->task != task || window->floor == PL_VM_ADDRESS_INVALID || len > sizeof(window->data) - PLCRASH_ASYNC_STACK_WINDOW_LOOKBEHIND)
+        return plcrash_async_task_memcpy(task, address, offset, dest, len);
+
+    /* Compute the target address and check for overflow */
+    if (!plcrash_async_address_apply_offset(address, offset, &target))
+        return PLCRASH_ENOMEM;
+
+    /* Only stack addresses at or above the initial stack pointer are cached */
+    if (target < window->floor || PL_VM_ADDRESS_MAX - target < len)
+        return plcrash_async_task_memcpy(task, target, 0, dest, len);
+
+    /* Slide the window if the requested range is not already available. The window is started slightly below the
+     * target address, as saved registers are commonly read at negative offsets from the frame pointer or CFA. */
+    if (window->length == 0 || target < window->base || target + len > window->base + window->length) {
+        pl_vm_address_t start = target - window->floor > PLCRASH_ASYNC_STACK_WINDOW_LOOKBEHIND ? target - PLCRASH_ASYNC_STACK_WINDOW_LOOKBEHIND : window->floor;
+        if (plcrash_async_stack_window_fill(window, start, target, len) != PLCRASH_ESUCCESS) {
+            /* The surrounding stack range may be partially unmapped (eg, if the stack pointer is corrupt); fall back
+             * on reading only the requested bytes. */
+            return plcrash_async_task_memcpy(task, target, 0, dest, len);
+        }
+    }
+
+    plcrash_async_memcpy(dest, window->data + (target - window->base), len);
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * @}
+ */
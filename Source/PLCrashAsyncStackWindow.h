@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PLCRASH_ASYNC_STACK_WINDOW_H
+#define PLCRASH_ASYNC_STACK_WINDOW_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "PLCrashAsync.h"
+
+/**
+ * @ingroup plcrash_async
+ *
+ * Size of the window buffer, in bytes. The window is generally allocated on the crashed thread's stack (which may
+ * be a small sigaltstack), and is sized to cover the saved frame records of a typical run of frames with a single read.
+ */
+#define PLCRASH_ASYNC_STACK_WINDOW_SIZE 2048
+
+/**
+ * @ingroup plcrash_async
+ *
+ * Number of bytes below a missed address that will be included when the window is refilled.
+ */
+#define PLCRASH_ASYNC_STACK_WINDOW_LOOKBEHIND 256
+
+/**
+ * @internal
+ * @ingroup plcrash_async
+ *
+ * An async-safe prefetch window over a target thread's stack.
+ *
+ * Stack loads performed while unwinding (saved frame pointers, return addresses, and callee-saved registers) are
+ * small, and are clustered at monotonically increasing addresses above the thread's initial stack pointer. Rather
+ * than issuing a vm_read for every 4 or 8 byte value, the window fetches a contiguous block of the stack with a
+ * single read, and serves subsequent loads from the local copy; the window slides forward as the unwinder walks
+ * towards the top of the stack.
+ *
+ * Only addresses at or above the initial stack pointer are served from the window; all other reads are passed
+ * through to plcrash_async_task_memcpy().
+ */
+typedef struct plcrash_async_stack_window {
+    /** The task from which stack data will be read. */
+    task_t task;
+
+    /** The lowest task address that may be served from the window; this is the thread's initial stack pointer. If
+     * PL_VM_ADDRESS_INVALID, the window is disabled and all reads are passed through to the task. */
+    pl_vm_address_t floor;
+
+    /** The task-relative address of the first byte in @a data. */
+    pl_vm_address_t base;
+
+    /** The number of valid bytes in @a data, or 0 if the window is empty. */
+    pl_vm_size_t length;
+
+    /** Cached stack data. */
+    uint8_t data[PLCRASH_ASYNC_STACK_WINDOW_SIZE];
+} plcrash_async_stack_window_t;
+
+void plcrash_async_stack_window_init (plcrash_async_stack_window_t *window, task_t task, pl_vm_address_t sp);
+
+plcrash_error_t plcrash_async_stack_window_memcpy (plcrash_async_stack_window_t *window, task_t task, pl_vm_address_t address, pl_vm_off_t offset, void *dest, pl_vm_size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLCRASH_ASYNC_STACK_WINDOW_H */
@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "SenTestCompat.h"
+
+#import "PLCrashAsyncStackWindow.h"
+
+@interface PLCrashAsyncStackWindowTests : SenTestCase {
+@private
+    /** Page-aligned test allocation, standing in for a thread stack. */
+    vm_address_t _stack;
+
+    /** Size of the readable test allocation. A guard page follows the readable range. */
+    vm_size_t _stack_size;
+}
+@end
+
+@implementation PLCrashAsyncStackWindowTests
+
+- (void) setUp {
+    _stack_size = PAGE_SIZE * 2;
+    STAssertEquals(KERN_SUCCESS, vm_allocate(mach_task_self(), &_stack, _stack_size + PAGE_SIZE, VM_FLAGS_ANYWHERE), @"Failed to allocate test pages");
+    STAssertEquals(KERN_SUCCESS, vm_protect(mach_task_self(), _stack + _stack_size, PAGE_SIZE, false, VM_PROT_NONE), @"Failed to protect guard page");
+
+    uint32_t *words = (uint32_t *) _stack;
+    for (uint32_t i = 0; i < _stack_size / sizeof(uint32_t); i++)
+        words[i] = i;
+}
+
+- (void) tearDown {
+    vm_deallocate(mach_task_self(), _stack, _stack_size + PAGE_SIZE);
+}
+
+/**
+ * Verify that reads are passed through to the task when no window is provided.
+ */
+- (void) testNULLWindow {
+    uint32_t val;
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_stack_window_memcpy(NULL, mach_task_self(), _stack, sizeof(uint32_t) * 4, &val, sizeof(val)), @"Failed to read");
+    STAssertEquals((uint32_t) 4, val, @"Incorrect value read");
+}
+
+/**
+ * Verify that data within the window is served from the local copy.
+ */
+- (void) testCachedRead {
+    plcrash_async_stack_window_t window;
+    uint32_t *words = (uint32_t *) _stack;
+    uint32_t val;
+
+    plcrash_async_stack_window_init(&window, mach_task_self(), _stack);
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_stack_window_memcpy(&window, mach_task_self(), _stack, sizeof(uint32_t) * 8, &val, sizeof(val)), @"Failed to read");
+    STAssertEquals((uint32_t) 8, val, @"Incorrect value read");
+    STAssertEquals((pl_vm_address_t) _stack, window.base, @"Window should begin at the floor");
+
+    /* Modify the backing memory; the prefetched copy should be returned. */
+    words[9] = UINT32_MAX;
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_stack_window_memcpy(&window, mach_task_self(), _stack, sizeof(uint32_t) * 9, &val, sizeof(val)), @"Failed to read");
+    STAssertEquals((uint32_t) 9, val, @"Value was not served from the window");
+}
+
+/**
+ * Verify that the window slides forward when reading past its end.
+ */
+- (void) testSlidingRead {
+    plcrash_async_stack_window_t window;
+    uint32_t val;
+
+    plcrash_async_stack_window_init(&window, mach_task_self(), _stack);
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_stack_window_memcpy(&window, mach_task_self(), _stack, 0, &val, sizeof(val)), @"Failed to read");
+
+    pl_vm_off_t offset = PLCRASH_ASYNC_STACK_WINDOW_SIZE + 64;
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_stack_window_memcpy(&window, mach_task_self(), _stack, offset, &val, sizeof(val)), @"Failed to read");
+    STAssertEquals((uint32_t) (offset / sizeof(uint32_t)), val, @"Incorrect value read");
+    STAssertEquals((pl_vm_address_t) (_stack + offset - PLCRASH_ASYNC_STACK_WINDOW_LOOKBEHIND), window.base, @"Window did not slide");
+}
+
+/**
+ * Verify that a read near the end of the mapped stack succeeds, even though a full window can not be fetched.
+ */
+- (void) testReadAtStackTop {
+    plcrash_async_stack_window_t window;
+    uint32_t val;
+
+    plcrash_async_stack_window_init(&window, mach_task_self(), _stack);
+
+    pl_vm_off_t offset = _stack_size - sizeof(uint32_t);
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_stack_window_memcpy(&window, mach_task_self(), _stack, offset, &val, sizeof(val)), @"Failed to read");
+    STAssertEquals((uint32_t) (offset / sizeof(uint32_t)), val, @"Incorrect value read");
+    STAssertTrue(window.base + window.length <= _stack + _stack_size, @"Window extends past the mapped range");
+}
+
+/**
+ * Verify that reads below the initial stack pointer are never cached.
+ */
+- (void) testReadBelowFloor {
+    plcrash_async_stack_window_t window;
+    uint32_t *words = (uint32_t *) _stack;
+    uint32_t val;
+
+    plcrash_async_stack_window_init(&window, mach_task_self(), _stack + PAGE_SIZE);
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_stack_window_memcpy(&window, mach_task_self(), _stack, sizeof(uint32_t) * 2, &val, sizeof(val)), @"Failed to read");
+    STAssertEquals((uint32_t) 2, val, @"Incorrect value read");
+    STAssertEquals((pl_vm_size_t) 0, window.length, @"Read below floor should not populate the window");
+
+    words[2] = UINT32_MAX;
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_stack_window_memcpy(&window, mach_task_self(), _stack, sizeof(uint32_t) * 2, &val, sizeof(val)), @"Failed to read");
+    STAssertEquals(UINT32_MAX, val, @"Read below floor returned stale data");
+}
+
+/**
+ * Verify that unmapped reads return an error.
+ */
+- (void) testUnmappedRead {
+    plcrash_async_stack_window_t window;
+    uint32_t val;
+
+    plcrash_async_stack_window_init(&window, mach_task_self(), 0x0);
+    STAssertNotEquals(PLCRASH_ESUCCESS, plcrash_async_stack_window_memcpy(&window, mach_task_self(), 0x0, 0, &val, sizeof(val)), @"Bad read was performed");
+
+    /* Verify that overflow is safely handled */
+    STAssertEquals(PLCRASH_ENOMEM, plcrash_async_stack_window_memcpy(&window, mach_task_self(), PL_VM_ADDRESS_MAX, 1, &val, sizeof(val)), @"Bad read was performed");
+}
+
+@end
@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PLCrashAsyncStringTable.h"
+
+/**
+ * @internal
+ * @ingroup plcrash_async
+ *
+ * Implements an async-safe string interning table.
+ *
+ * @{
+ */
+
+/**
+ * Initialize a new string table, preallocating storage for up to @a capacity strings and @a storage_size bytes of
+ * string data.
+ *
+ * @param table The table to initialize.
+ * @param capacity The maximum number of strings to be held by the table.
+ * @param storage_size The number of bytes reserved for string data, including each string's NUL terminator.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, or PLCRASH_ENOMEM if the table storage could not be allocated.
+ *
+ * @warning This function is not async-safe, and must be called prior to report generation.
+ */
+plcrash_error_t plcrash_async_string_table_init (plcrash_async_string_table_t *table, uint32_t capacity, size_t storage_size) {
+    plcrash_async_memset(table, 0, sizeof(*table));
+
+    if (capacity == 0)
+        capacity = 1;
+
+    /* Keep the load factor at or below one half */
+    uint32_t slot_count = 2;
+    while (slot_count < capacity * 2)
+        slot_count <<= 1;
+
+    /* Allocate the slots, hashes, offsets and string storage as a single region */
+    pl_vm_size_t slots_size = slot_count * sizeof(uint32_t);
+    pl_vm_size_t entries_size = capacity * sizeof(uint32_t);
+    pl_vm_size_t alloc_size = slots_size + (entries_size * 2) + storage_size;
+
+    vm_address_t region;
+    kern_return_t kt = vm_allocate(mach_task_self(), &region, alloc_size, VM_FLAGS_ANYWHERE);
+    if (kt != KERN_SUCCESS) {
+        PLCF_DEBUG("Failed to allocate string table storage: %d", kt);
+        return PLCRASH_ENOMEM;
+    }
+
+    table->capacity = capacity;
+    table->slot_count = slot_count;
+    table->slots = (uint32_t *) region;
+    table->hashes = (uint32_t *) (region + slots_size);
+    table->offsets = (uint32_t *) (region + slots_size + entries_size);
+    table->storage = (char *) (region + slots_size + (entries_size * 2));
+    table->storage_size = storage_size;
+    table->allocation_size = alloc_size;
+
+    /* vm_allocate() returns zero-filled pages; all slots are unused. */
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Free all resources associated with @a table.
+ *
+ * @param table The table to free.
+ */
+void plcrash_async_string_table_free (plcrash_async_string_table_t *table) {
+    if (table->slots != NULL)
+        vm_deallocate(mach_task_self(), (vm_address_t) table->slots, table->allocation_size);
+
+    table->slots = NULL;
+    table->hashes = NULL;
+    table->offsets = NULL;
+    table->storage = NULL;
+    table->capacity = 0;
+    table->count = 0;
+}
+
+/**
+ * Remove all strings from @a table.
+ *
+ * @param table The table to reset.
+ */
+void plcrash_async_string_table_reset (plcrash_async_string_table_t *table) {
+    if (table->count == 0)
+        return;
+
+    plcrash_async_memset(table->slots, 0, table->slot_count * sizeof(uint32_t));
+    table->count = 0;
+    table->storage_used = 0;
+}
+
+/**
+ * Add @a string to @a table, if not already present, and return its index.
+ *
+ * @param table The table to which @a string will be added.
+ * @param string The NUL-terminated string to add. The string is copied into the table.
+ * @param[out] index On success, the index assigned to @a string. Indices are assigned sequentially from 0, in the
+ * order that distinct strings are added.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, or PLCRASH_ENOMEM if @a string is not present and the table's
+ * capacity or storage has been exhausted.
+ */
+plcrash_error_t plcrash_async_string_table_intern (plcrash_async_string_table_t *table, const char *string, uint32_t *index) {
+    /* Compute the FNV-1a hash and the string length */
+    uint32_t hash = 2166136261U;
+    size_t length = 0;
+    for (const char *p = string; *p != '\0'; p++) {
+        hash ^= (uint8_t) *p;
+        hash *= 16777619U;
+        length++;
+    }
+
+    /* Probe for an existing entry */
+    uint32_t mask = table->slot_count - 1;
+    uint32_t slot = hash & mask;
+    while (table->slots[slot] != 0) {
+        uint32_t entry = table->slots[slot] - 1;
+        if (table->hashes[entry] == hash && plcrash_async_strcmp(table->storage + table->offsets[entry], string) == 0) {
+            *index = entry;
+            return PLCRASH_ESUCCESS;
+        }
+
+        slot = (slot + 1) & mask;
+    }
+
+    /* Add a new entry */
+    if (table->count == table->capacity || length + 1 > table->storage_size - table->storage_used)
+        return PLCRASH_ENOMEM;
+
+    uint32_t entry = table->count;
+    plcrash_async_memcpy(table->storage + table->storage_used, string, length + 1);
+    table->offsets[entry] = (uint32_t) table->storage_used;
+    table->hashes[entry] = hash;
+    table->storage_used += length + 1;
+
+    table->slots[slot] = entry + 1;
+    table->count++;
+
+    *index = entry;
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Return the number of strings held by @a table.
+ *
+ * @param table The string table.
+ */
+uint32_t plcrash_async_string_table_count (plcrash_async_string_table_t *table) {
+    return table->count;
+}
+
+/**
+ * Return the string at @a index, or NULL if @a index is out of range.
+ *
+ * @param table The string table.
+ * @param index The string index, as returned by plcrash_async_string_table_intern().
+ */
+const char *plcrash_async_string_table_string (plcrash_async_string_table_t *table, uint32_t index) {
+    if (index >= table->count)
+        return NULL;
+
+    return table->storage + table->offsets[index];
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PLCRASH_ASYNC_STRING_TABLE_H
+#define PLCRASH_ASYNC_STRING_TABLE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "PLCrashAsync.h"
+
+/**
+ * @ingroup plcrash_async
+ *
+ * The default maximum number of strings held by a report-generation string table.
+ */
+#define PLCRASH_ASYNC_STRING_TABLE_DEFAULT_CAPACITY 4096
+
+/**
+ * @ingroup plcrash_async
+ *
+ * The default number of bytes of string storage reserved for a report-generation string table.
+ */
+#define PLCRASH_ASYNC_STRING_TABLE_DEFAULT_STORAGE_SIZE (256 * 1024)
+
+/**
+ * @internal
+ * @ingroup plcrash_async
+ *
+ * An async-safe, fixed-capacity string interning table.
+ *
+ * Each distinct string added via plcrash_async_string_table_intern() is copied into the table's storage, and assigned
+ * the next sequential index; adding an equal string returns the existing index. This is used to write each symbol name
+ * and image path to a crash report only once.
+ *
+ * All storage is allocated by plcrash_async_string_table_init(); no allocation is performed once the table has been
+ * initialized. The table is not thread-safe.
+ */
+typedef struct plcrash_async_string_table {
+    /** The maximum number of strings that may be held by the table. */
+    uint32_t capacity;
+
+    /** The number of strings held by the table. */
+    uint32_t count;
+
+    /** The number of hash slots. This is a power of two, and at least twice @a capacity. */
+    uint32_t slot_count;
+
+    /** Hash slots. Each slot contains the index of a string plus one, or 0 if the slot is unused. */
+    uint32_t *slots;
+
+    /** String hashes, indexed by string index. */
+    uint32_t *hashes;
+
+    /** String offsets within @a storage, indexed by string index. */
+    uint32_t *offsets;
+
+    /** NUL-terminated string storage. */
+    char *storage;
+
+    /** The size of @a storage, in bytes. */
+    size_t storage_size;
+
+    /** The number of bytes of @a storage in use. */
+    size_t storage_used;
+
+    /** The total size of the allocation backing the slots, hashes, offsets and storage. */
+    pl_vm_size_t allocation_size;
+} plcrash_async_string_table_t;
+
+plcrash_error_t plcrash_async_string_table_init (plcrash_async_string_table_t *table, uint32_t capacity, size_t storage_size);
+void plcrash_async_string_table_free (plcrash_async_string_table_t *table);
+
+void plcrash_async_string_table_reset (plcrash_async_string_table_t *table);
+plcrash_error_t plcrash_async_string_table_intern (plcrash_async_string_table_t *table, const char *string, uint32_t *index);
+
+uint32_t plcrash_async_string_table_count (plcrash_async_string_table_t *table);
+const char *plcrash_async_string_table_string (plcrash_async_string_table_t *table, uint32_t index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLCRASH_ASYNC_STRING_TABLE_H */
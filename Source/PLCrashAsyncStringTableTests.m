@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "SenTestCompat.h"
+
+#import "PLCrashAsyncStringTable.h"
+
+@interface PLCrashAsyncStringTableTests : SenTestCase {
+@private
+    /** The table under test. */
+    plcrash_async_string_table_t _table;
+}
+@end
+
+@implementation PLCrashAsyncStringTableTests
+
+- (void) setUp {
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_string_table_init(&_table, 64, 1024), @"Failed to initialize table");
+}
+
+- (void) tearDown {
+    plcrash_async_string_table_free(&_table);
+}
+
+/**
+ * Verify that equal strings are assigned the same index, and distinct strings sequential indices.
+ */
+- (void) testIntern {
+    uint32_t first, second, again;
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_string_table_intern(&_table, "-[NSObject description]", &first), @"Failed to add string");
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_string_table_intern(&_table, "/usr/lib/libobjc.A.dylib", &second), @"Failed to add string");
+
+    /* Use a distinct buffer to ensure that the string contents are compared */
+    char copy[] = "-[NSObject description]";
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_string_table_intern(&_table, copy, &again), @"Failed to look up string");
+
+    STAssertEquals((uint32_t) 0, first, @"Incorrect index");
+    STAssertEquals((uint32_t) 1, second, @"Incorrect index");
+    STAssertEquals(first, again, @"Equal string assigned a new index");
+    STAssertEquals((uint32_t) 2, plcrash_async_string_table_count(&_table), @"Incorrect count");
+
+    /* The table must hold its own copy */
+    copy[0] = '+';
+    STAssertTrue(strcmp("-[NSObject description]", plcrash_async_string_table_string(&_table, first)) == 0, @"Incorrect string");
+    STAssertTrue(strcmp("/usr/lib/libobjc.A.dylib", plcrash_async_string_table_string(&_table, second)) == 0, @"Incorrect string");
+    STAssertNULL(plcrash_async_string_table_string(&_table, 2), @"Returned a string for an unused index");
+
+    /* The empty string is a valid entry */
+    uint32_t empty;
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_string_table_intern(&_table, "", &empty), @"Failed to add empty string");
+    STAssertTrue(strcmp("", plcrash_async_string_table_string(&_table, empty)) == 0, @"Incorrect string");
+}
+
+/**
+ * Verify that all entries remain reachable once the table is filled to capacity, and that no further strings are
+ * added once it is full.
+ */
+- (void) testCapacity {
+    char name[32];
+    uint32_t index;
+
+    for (uint32_t i = 0; i < _table.capacity; i++) {
+        snprintf(name, sizeof(name), "sym%u", i);
+        STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_string_table_intern(&_table, name, &index), @"Failed to add string %s", name);
+        STAssertEquals(i, index, @"Incorrect index");
+    }
+
+    STAssertEquals(PLCRASH_ENOMEM, plcrash_async_string_table_intern(&_table, "overflow", &index), @"Added a string beyond capacity");
+
+    /* Existing strings may still be looked up */
+    for (uint32_t i = 0; i < _table.capacity; i++) {
+        snprintf(name, sizeof(name), "sym%u", i);
+        STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_string_table_intern(&_table, name, &index), @"Failed to look up string %s", name);
+        STAssertEquals(i, index, @"Incorrect index");
+        STAssertTrue(strcmp(name, plcrash_async_string_table_string(&_table, i)) == 0, @"Incorrect string");
+    }
+}
+
+/**
+ * Verify that strings are rejected once the table's string storage is exhausted.
+ */
+- (void) testStorageExhausted {
+    char name[256];
+    uint32_t index;
+
+    memset(name, 'a', sizeof(name) - 1);
+    name[sizeof(name) - 1] = '\0';
+
+    /* 4 x 256 bytes fills the 1024 byte storage exactly */
+    for (int i = 0; i < 4; i++) {
+        name[0] = (char) ('a' + i);
+        STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_string_table_intern(&_table, name, &index), @"Failed to add string");
+    }
+
+    STAssertEquals(PLCRASH_ENOMEM, plcrash_async_string_table_intern(&_table, "x", &index), @"Added a string beyond the storage size");
+    STAssertEquals((uint32_t) 4, plcrash_async_string_table_count(&_table), @"Incorrect count");
+}
+
+/**
+ * Verify that resetting the table discards all strings.
+ */
+- (void) testReset {
+    uint32_t index;
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_string_table_intern(&_table, "first", &index), @"Failed to add string");
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_string_table_intern(&_table, "second", &index), @"Failed to add string");
+
+    plcrash_async_string_table_reset(&_table);
+    STAssertEquals((uint32_t) 0, plcrash_async_string_table_count(&_table), @"Table not reset");
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_string_table_intern(&_table, "second", &index), @"Failed to add string");
+    STAssertEquals((uint32_t) 0, index, @"Indices not reset");
+}
+
+@end
@@ -28,6 +28,7 @@
 
 #import "SenTestCompat.h"
 #import "PLCrashAsync.h"
+#import "PLCrashFeatureConfig.h"
 
 #import <fcntl.h>
 #import <sys/stat.h>
@@ -108,6 +109,38 @@
     STAssertEquals(PLCRASH_ENOMEM, plcrash_async_task_memcpy(mach_task_self(), PL_VM_ADDRESS_MAX, 1, dest, sizeof(bytes)), @"Bad read was performed");
 }
 
+- (void) testReadStatistics {
+    const char bytes[] = "Hello";
+    char dest[sizeof(bytes)];
+    plcrash_async_read_stats_t stats;
+
+    plcrash_async_read_stats_reset();
+    plcrash_async_read_stats_get(&stats);
+    STAssertEquals(stats.read_count, (uint64_t) 0, @"Counters were not reset");
+    STAssertEquals(stats.read_bytes, (uint64_t) 0, @"Counters were not reset");
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_task_memcpy(mach_task_self(), (pl_vm_address_t) bytes, 0, dest, sizeof(dest)), @"Read failed");
+    plcrash_async_task_memcpy(mach_task_self(), (pl_vm_address_t) bytes, 0, dest, 2);
+    plcrash_async_read_stats_record_map(PAGE_SIZE);
+    plcrash_async_read_stats_record_unmap(PAGE_SIZE);
+
+    plcrash_async_read_stats_get(&stats);
+#if PLCRASH_FEATURE_READ_STATISTICS
+    STAssertEquals(stats.read_count, (uint64_t) 2, @"Incorrect read count");
+    STAssertEquals(stats.read_bytes, (uint64_t) sizeof(dest) + 2, @"Incorrect read byte count");
+    STAssertEquals(stats.map_count, (uint64_t) 1, @"Incorrect map count");
+    STAssertEquals(stats.map_bytes, (uint64_t) PAGE_SIZE, @"Incorrect map byte count");
+    STAssertEquals(stats.unmap_count, (uint64_t) 1, @"Incorrect unmap count");
+    STAssertEquals(stats.unmap_bytes, (uint64_t) PAGE_SIZE, @"Incorrect unmap byte count");
+#else
+    STAssertEquals(stats.read_count, (uint64_t) 0, @"Counters should be disabled");
+    STAssertEquals(stats.map_count, (uint64_t) 0, @"Counters should be disabled");
+    STAssertEquals(stats.unmap_count, (uint64_t) 0, @"Counters should be disabled");
+#endif
+
+    plcrash_async_read_stats_reset();
+}
+
 - (void) testTaskReadInt {
     const plcrash_async_byteorder_t *byteorder = &plcrash_async_byteorder_swapped;
     union test_data {
@@ -274,4 +307,72 @@
     [input close];
 }
 
+
+- (void) testBufferSink {
+    plcrash_async_file_t file;
+    uint8_t buffer[8];
+    uint32_t data = 0xAABBCCDD;
+
+    plcrash_async_file_init_buffer(&file, buffer, sizeof(buffer));
+
+    /* Write to the buffer size; further writes must be dropped */
+    STAssertTrue(plcrash_async_file_write(&file, &data, sizeof(data)), @"Write failed");
+    STAssertTrue(plcrash_async_file_write(&file, &data, sizeof(data)), @"Write failed");
+    STAssertFalse(plcrash_async_file_write(&file, &data, sizeof(data)), @"Buffer size not enforced");
+
+    STAssertTrue(plcrash_async_file_flush(&file), @"Flush failed");
+    STAssertEquals((size_t) 8, plcrash_async_file_buffer_length(&file), @"Incorrect buffer length");
+    STAssertTrue(memcmp(buffer, &data, sizeof(data)) == 0, @"Incorrect data written");
+    STAssertTrue(memcmp(buffer + sizeof(data), &data, sizeof(data)) == 0, @"Incorrect data written");
+
+    /* A caller-owned buffer can't be detached */
+    size_t length, allocation_size;
+    STAssertNULL(plcrash_async_file_buffer_detach(&file, &length, &allocation_size), @"Detached a caller-owned buffer");
+    STAssertTrue(plcrash_async_file_close(&file), @"Close failed");
+}
+
+- (void) testGrowableSink {
+    plcrash_async_file_t file;
+    uint8_t data[1000];
+    int write_iterations = 64;
+
+    for (size_t i = 0; i < sizeof(data); i++)
+        data[i] = (uint8_t) i;
+
+    /* Start with a buffer that must be grown several times */
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_file_init_growable(&file, 1, 0), @"Failed to initialize growable sink");
+    for (int i = 0; i < write_iterations; i++)
+        STAssertTrue(plcrash_async_file_write(&file, data, sizeof(data)), @"Write failed");
+
+    STAssertEquals(sizeof(data) * write_iterations, plcrash_async_file_buffer_length(&file), @"Incorrect buffer length");
+
+    /* Detach and verify the data */
+    size_t length, allocation_size;
+    uint8_t *buffer = plcrash_async_file_buffer_detach(&file, &length, &allocation_size);
+    STAssertNotNULL(buffer, @"Failed to detach buffer");
+    STAssertEquals(sizeof(data) * write_iterations, length, @"Incorrect detached length");
+    STAssertTrue(allocation_size >= length, @"Allocation size smaller than length");
+    STAssertNULL(plcrash_async_file_buffer_detach(&file, &length, &allocation_size), @"Detached a buffer twice");
+    STAssertTrue(plcrash_async_file_close(&file), @"Close failed");
+
+    for (int i = 0; i < write_iterations; i++)
+        STAssertTrue(memcmp(buffer + (i * sizeof(data)), data, sizeof(data)) == 0, @"Data does not compare at iteration %d", i);
+
+    vm_deallocate(mach_task_self(), (vm_address_t) buffer, allocation_size);
+}
+
+- (void) testGrowableSinkLimit {
+    plcrash_async_file_t file;
+    uint32_t data = 1;
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_file_init_growable(&file, 0, 8), @"Failed to initialize growable sink");
+    STAssertTrue(plcrash_async_file_write(&file, &data, sizeof(data)), @"Write failed");
+    STAssertTrue(plcrash_async_file_write(&file, &data, sizeof(data)), @"Write failed");
+    STAssertFalse(plcrash_async_file_write(&file, &data, sizeof(data)), @"Limit not enforced");
+    STAssertEquals((size_t) 8, plcrash_async_file_buffer_length(&file), @"Incorrect buffer length");
+
+    /* Closing without detaching releases the buffer */
+    STAssertTrue(plcrash_async_file_close(&file), @"Close failed");
+}
+
 @end
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "SenTestCompat.h"
+
+#import "PLCrashReporter.h"
+
+/* Defined in plcrashutil/PLCrashConvertCommand.m */
+extern int plcrash_convert_command (int argc, char *argv[]);
+
+@interface PLCrashConvertCommandTests : SenTestCase {
+@private
+    /** Temporary directory containing the test inputs and outputs. */
+    NSString *_root;
+}
+@end
+
+/**
+ * Tests for the plcrashutil convert command.
+ */
+@implementation PLCrashConvertCommandTests
+
+- (void) setUp {
+    _root = [[NSTemporaryDirectory() stringByAppendingPathComponent: [[NSProcessInfo processInfo] globallyUniqueString]] retain];
+}
+
+- (void) tearDown {
+    [[NSFileManager defaultManager] removeItemAtPath: _root error: NULL];
+    [_root release];
+}
+
+/**
+ * Write a live report to @a path, creating any intermediate directories.
+ */
+- (void) writeReportToPath: (NSString *) path {
+    NSError *error;
+
+    STAssertTrue([[NSFileManager defaultManager] createDirectoryAtPath: [path stringByDeletingLastPathComponent] withIntermediateDirectories: YES attributes: nil error: &error], @"Could not create directory: %@", error);
+
+    PLCrashReporter *reporter = [[[PLCrashReporter alloc] initWithConfiguration: [PLCrashReporterConfig defaultConfiguration]] autorelease];
+    NSData *data = [reporter generateLiveReportAndReturnError: &error];
+    STAssertNotNil(data, @"Failed to generate live report: %@", error);
+    STAssertTrue([data writeToFile: path options: NSDataWritingAtomic error: &error], @"Could not write report: %@", error);
+}
+
+/**
+ * Verify that a batch conversion is performed when the output directory is the first option on the command line,
+ * as passed by plcrashutil's main().
+ */
+- (void) testBatchConvertWithLeadingOutputDirectory {
+    NSString *input = [_root stringByAppendingPathComponent: @"input"];
+    NSString *output = [_root stringByAppendingPathComponent: @"output"];
+
+    [self writeReportToPath: [input stringByAppendingPathComponent: @"a.plcrash"]];
+    [self writeReportToPath: [input stringByAppendingPathComponent: @"nested/b.plcrash"]];
+
+    char *argv[] = {
+        "convert",
+        "--output-dir",
+        (char *) [output fileSystemRepresentation],
+        "--jobs=2",
+        (char *) [input fileSystemRepresentation],
+        NULL
+    };
+    STAssertEquals(0, plcrash_convert_command(5, argv), @"Batch conversion failed");
+
+    for (NSString *name in [NSArray arrayWithObjects: @"a.crash", @"nested/b.crash", nil]) {
+        NSString *text = [NSString stringWithContentsOfFile: [output stringByAppendingPathComponent: name] encoding: NSUTF8StringEncoding error: NULL];
+        STAssertNotNil(text, @"Missing converted report %@", name);
+        STAssertTrue([text hasPrefix: @"Incident Identifier: "], @"Unexpected converted report contents for %@", name);
+    }
+
+    /* The command must be repeatable within a single process */
+    NSString *again = [_root stringByAppendingPathComponent: @"again"];
+    argv[2] = (char *) [again fileSystemRepresentation];
+    STAssertEquals(0, plcrash_convert_command(5, argv), @"Repeated batch conversion failed");
+    STAssertTrue([[NSFileManager defaultManager] fileExistsAtPath: [again stringByAppendingPathComponent: @"a.crash"]], @"Missing converted report");
+}
+
+@end
@@ -101,6 +101,28 @@
 #    define PLCRASH_FEATURE_UNWIND_COMPACT 1
 #endif
 
+#ifndef PLCRASH_FEATURE_UNWIND_STACK_SCAN
+/**
+ * If true, fall back to heuristic stack scanning when compact unwinding, DWARF unwinding and frame pointers all fail
+ * to produce a frame. Scanned frames may be spurious, and are marked as scanned in the crash report. Disabled by
+ * default.
+ */
+#    define PLCRASH_FEATURE_UNWIND_STACK_SCAN 0
+#endif
+
+#ifndef PLCRASH_FEATURE_READ_STATISTICS
+/**
+ * If true, count the target memory reads and mappings performed by the async-safe memory APIs. The counters are
+ * not thread-safe, and are intended only for use by benchmarks and tests; they are disabled by default in
+ * release builds.
+ */
+#  ifdef PLCF_RELEASE_BUILD
+#    define PLCRASH_FEATURE_READ_STATISTICS 0
+#  else
+#    define PLCRASH_FEATURE_READ_STATISTICS 1
+#  endif
+#endif
+
 /**
  * @}
  */
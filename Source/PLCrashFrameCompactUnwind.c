@@ -37,17 +37,19 @@
  * Attempt to fetch next frame using compact frame unwinding data from @a image_list.
  *
  * @param task The task containing the target frame stack.
+ * @param stack_window The read-ahead window over the target stack, or NULL.
  * @param image_list The list of images loaded in the target @a task.
  * @param current_frame The current stack frame.
- * @param previous_frame The previous stack frame, or NULL if this is the first frame.
+ * @param previous_frame A summary of the previous stack frame, or NULL if this is the first frame.
  * @param next_frame The new frame to be initialized.
  *
  * @return Returns PLFRAME_ESUCCESS on success, PLFRAME_ENOFRAME is no additional frames are available, or a standard plframe_error_t code if an error occurs.
  */
 plframe_error_t plframe_cursor_read_compact_unwind (task_t task,
+                                                    plcrash_async_stack_window_t *stack_window,
                                                     plcrash_async_image_list_t *image_list,
                                                     const plframe_stackframe_t *current_frame,
-                                                    const plframe_stackframe_t *previous_frame,
+                                                    const plframe_stackframe_summary_t *previous_frame,
                                                     plframe_stackframe_t *next_frame)
 {
     plframe_error_t result;
@@ -130,7 +132,7 @@ plframe_error_t plframe_cursor_read_compact_unwind (task_t task,
     }
 
     /* Apply the frame delta -- this may fail. */
-    if ((err = plcrash_async_cfe_entry_apply(task, function_address, &current_frame->thread_state, &entry, &next_frame->thread_state)) == PLCRASH_ESUCCESS) {
+    if ((err = plcrash_async_cfe_entry_apply(task, stack_window, function_address, &current_frame->thread_state, &entry, &next_frame->thread_state)) == PLCRASH_ESUCCESS) {
         result = PLFRAME_ESUCCESS;
     } else {
         PLCF_DEBUG("Failed to apply CFE encoding 0x%" PRIx32 " for PC 0x%" PRIx64 ": %d", encoding, (uint64_t) pc, err);
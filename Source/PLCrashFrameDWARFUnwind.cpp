@@ -48,10 +48,11 @@ using namespace plcrash::async;
  * Attempt to fetch next frame using compact frame unwinding data from @a image.
  *
  * @param task The task containing the target frame stack.
+ * @param stack_window The read-ahead window over the target stack, or NULL.
  * @param pc The current frame's PC value.
  * @param image The Mach-O image for the current stack frame.
  * @param current_frame The current stack frame.
- * @param previous_frame The previous stack frame, or NULL if this is the first frame.
+ * @param previous_frame A summary of the previous stack frame, or NULL if this is the first frame.
  * @param next_frame The new frame to be initialized.
  *
  * @tparam machine_ptr The native machine pointer type for the target data.
@@ -61,10 +62,11 @@ using namespace plcrash::async;
  */
 template<typename machine_ptr, typename machine_ptr_s>
 static plframe_error_t plframe_cursor_read_dwarf_unwind_int (task_t task,
+                                                             plcrash_async_stack_window_t *stack_window,
                                                              machine_ptr pc,
                                                              plcrash_async_macho_t *image,
                                                              const plframe_stackframe_t *current_frame,
-                                                             const plframe_stackframe_t *previous_frame,
+                                                             const plframe_stackframe_summary_t *previous_frame,
                                                              plframe_stackframe_t *next_frame)
 {
     gnu_ehptr_reader<machine_ptr> ptr_state(image->byteorder);
@@ -177,7 +179,7 @@ static plframe_error_t plframe_cursor_read_dwarf_unwind_int (task_t task,
     }
     
     /* Apply the frame delta -- this may fail. */
-    if ((err = cfa_state.apply_state(task, &cie_info, &current_frame->thread_state, image->byteorder, &next_frame->thread_state)) == PLCRASH_ESUCCESS) {
+    if ((err = cfa_state.apply_state(task, stack_window, &cie_info, &current_frame->thread_state, image->byteorder, &next_frame->thread_state)) == PLCRASH_ESUCCESS) {
         result = PLFRAME_ESUCCESS;
     } else {
         PLCF_DEBUG("Failed to apply CFA state for PC 0x%" PRIx64 ": %d", (uint64_t) pc, err);
@@ -203,17 +205,19 @@ cleanup:
  * Attempt to fetch next frame using compact frame unwinding data from @a image_list.
  *
  * @param task The task containing the target frame stack.
+ * @param stack_window The read-ahead window over the target stack, or NULL.
  * @param image_list The list of images loaded in the target @a task.
  * @param current_frame The current stack frame.
- * @param previous_frame The previous stack frame, or NULL if this is the first frame.
+ * @param previous_frame A summary of the previous stack frame, or NULL if this is the first frame.
  * @param next_frame The new frame to be initialized.
  *
  * @return Returns PLFRAME_ESUCCESS on success, PLFRAME_ENOFRAME is no additional frames are available, or a standard plframe_error_t code if an error occurs.
  */
 plframe_error_t plframe_cursor_read_dwarf_unwind (task_t task,
+                                                  plcrash_async_stack_window_t *stack_window,
                                                   plcrash_async_image_list_t *image_list,
                                                   const plframe_stackframe_t *current_frame,
-                                                  const plframe_stackframe_t *previous_frame,
+                                                  const plframe_stackframe_summary_t *previous_frame,
                                                   plframe_stackframe_t *next_frame)
 {
     plframe_error_t ferr;
@@ -244,12 +248,12 @@ plframe_error_t plframe_cursor_read_dwarf_unwind (task_t task,
         /* Could only happen due to programmer error; eg, an image that doesn't actually match our thread state */
         PLCF_ASSERT(pc <= UINT64_MAX);
 
-        ferr = plframe_cursor_read_dwarf_unwind_int<uint64_t, int64_t>(task, pc, &image->macho_image, current_frame, previous_frame, next_frame);
+        ferr = plframe_cursor_read_dwarf_unwind_int<uint64_t, int64_t>(task, stack_window, pc, &image->macho_image, current_frame, previous_frame, next_frame);
     } else {
         /* Could only happen due to programmer error; eg, an image that doesn't actually match our thread state */
         PLCF_ASSERT(pc <= UINT32_MAX);
 
-        ferr = plframe_cursor_read_dwarf_unwind_int<uint32_t, int32_t>(task, pc, &image->macho_image, current_frame, previous_frame, next_frame);
+        ferr = plframe_cursor_read_dwarf_unwind_int<uint32_t, int32_t>(task, stack_window, pc, &image->macho_image, current_frame, previous_frame, next_frame);
     }
     
     plcrash_async_image_list_set_reading(image_list, false);
@@ -0,0 +1,280 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PLCrashFrameStackScan.h"
+#include "PLCrashAsync.h"
+
+#include <mach-o/loader.h>
+
+/**
+ * @internal
+ * @ingroup plcrash_backtrace_private
+ * @{
+ */
+
+/**
+ * @internal
+ *
+ * Return true if the instruction preceding @a pc is a call instruction for @a cpu_type. Common call encodings are
+ * recognized; if the preceding instruction can not be read, false is returned. Targets for which no call encodings
+ * are known (eg, 32-bit ARM, with its mix of ARM and Thumb instructions) always return true.
+ */
+static bool plframe_stack_scan_is_call_site (task_t task, cpu_type_t cpu_type, pl_vm_address_t pc) {
+    switch (cpu_type) {
+        case CPU_TYPE_X86:
+        case CPU_TYPE_X86_64: {
+            /* insn[i] is the byte at pc - 7 + i */
+            uint8_t insn[7];
+            if (plcrash_async_task_memcpy(task, pc, -(pl_vm_off_t) sizeof(insn), insn, sizeof(insn)) != PLCRASH_ESUCCESS)
+                return false;
+
+            /* call rel32 */
+            if (insn[2] == 0xE8)
+                return true;
+
+            /* call r/m (FF /2) with a register, disp8, disp32, or SIB+disp32 operand */
+            if (insn[5] == 0xFF && (insn[6] & 0xF8) == 0xD0)
+                return true;
+            if (insn[4] == 0xFF && ((insn[5] >> 3) & 0x7) == 2)
+                return true;
+            if (insn[1] == 0xFF && ((insn[2] >> 3) & 0x7) == 2)
+                return true;
+            if (insn[0] == 0xFF && ((insn[1] >> 3) & 0x7) == 2)
+                return true;
+
+            return false;
+        }
+
+        case CPU_TYPE_ARM64: {
+            uint32_t insn;
+            if (plcrash_async_task_memcpy(task, pc, -(pl_vm_off_t) sizeof(insn), &insn, sizeof(insn)) != PLCRASH_ESUCCESS)
+                return false;
+
+            /* BL */
+            if ((insn & 0xFC000000) == 0x94000000)
+                return true;
+
+            /* BLR */
+            if ((insn & 0xFFFFFC1F) == 0xD63F0000)
+                return true;
+
+            /* BLRAA, BLRAAZ, BLRAB, BLRABZ */
+            if ((insn & 0xFEFFF800) == 0xD63F0800)
+                return true;
+
+            return false;
+        }
+
+        default:
+            return true;
+    }
+}
+
+/**
+ * @internal
+ *
+ * Find the lowest and highest addresses covered by the __TEXT segments of @a image_list. The image list must be
+ * marked as reading.
+ *
+ * @return Returns false if no images are available.
+ */
+static bool plframe_stack_scan_text_bounds (plcrash_async_image_list_t *image_list, pl_vm_address_t *low, pl_vm_address_t *high) {
+    plcrash_async_image_t *image = NULL;
+    bool found = false;
+
+    *low = PL_VM_ADDRESS_MAX;
+    *high = 0;
+
+    while ((image = plcrash_async_image_list_next(image_list, image)) != NULL) {
+        pl_vm_address_t start = image->macho_image.header_addr;
+        pl_vm_address_t end = start + image->macho_image.text_size;
+
+        if (start < *low)
+            *low = start;
+        if (end > *high)
+            *high = end;
+
+        found = true;
+    }
+
+    return found;
+}
+
+/**
+ * Fetch the next frame by scanning the stack above @a current_frame's stack pointer for a value that looks like a
+ * return address: a value within the __TEXT segment of a loaded image, immediately following a call instruction.
+ *
+ * This is a heuristic of last resort, and may produce spurious frames from stale stack contents; it is intended to be
+ * used only after all other frame readers have failed. At most #PLFRAME_STACK_SCAN_MAX_WORDS stack words are
+ * examined. The stack is read #PLFRAME_STACK_SCAN_CHUNK_WORDS words at a time, and each chunk is first filtered
+ * against the combined text range of all images using a branch-free loop that the compiler vectorizes; only values
+ * that pass the range filter are looked up in @a image_list and checked for a preceding call instruction.
+ *
+ * The new frame's stack pointer is set to the address following the return address slot, allowing subsequent scans
+ * to resume above it. A current frame pointer above that slot is carried forward, as it will generally still
+ * reference the caller's frame when the current function does not maintain a frame pointer.
+ *
+ * @param task The task containing the target frame stack.
+ * @param stack_window The read-ahead window over the target stack, or NULL.
+ * @param image_list The list of images loaded in the target @a task.
+ * @param current_frame The current stack frame.
+ * @param previous_frame A summary of the previous stack frame, or NULL if this is the first frame.
+ * @param next_frame The new frame to be initialized.
+ *
+ * @return Returns PLFRAME_ESUCCESS on success, PLFRAME_ENOFRAME if no candidate return address is found within the
+ * scan window, or a standard plframe_error_t code if an error occurs.
+ */
+plframe_error_t plframe_cursor_read_stack_scan (task_t task,
+                                                plcrash_async_stack_window_t *stack_window,
+                                                plcrash_async_image_list_t *image_list,
+                                                const plframe_stackframe_t *current_frame,
+                                                const plframe_stackframe_summary_t *previous_frame,
+                                                plframe_stackframe_t *next_frame)
+{
+    const plcrash_async_thread_state_t *state = &current_frame->thread_state;
+    size_t greg_size = plcrash_async_thread_state_get_greg_size(state);
+
+    if (!plcrash_async_thread_state_has_reg(state, PLCRASH_REG_SP)) {
+        PLCF_DEBUG("The stack pointer is unavailable, can't scan the stack.");
+        return PLFRAME_EBADFRAME;
+    }
+
+    if (plcrash_async_thread_state_get_stack_direction(state) != PLCRASH_ASYNC_THREAD_STACK_DIRECTION_DOWN)
+        return PLFRAME_ENOTSUP;
+
+    pl_vm_address_t sp = (pl_vm_address_t) plcrash_async_thread_state_get_reg(state, PLCRASH_REG_SP);
+    plcrash_greg_t ip = 0;
+    if (plcrash_async_thread_state_has_reg(state, PLCRASH_REG_IP))
+        ip = plcrash_async_thread_state_get_reg(state, PLCRASH_REG_IP);
+
+    plcrash_async_image_list_set_reading(image_list, true);
+
+    pl_vm_address_t text_low;
+    pl_vm_address_t text_high;
+    if (!plframe_stack_scan_text_bounds(image_list, &text_low, &text_high)) {
+        plcrash_async_image_list_set_reading(image_list, false);
+        return PLFRAME_ENOFRAME;
+    }
+
+    /* Saved return addresses may carry pointer authentication codes; strip any bits above the highest text address */
+    uint64_t ptr_mask = UINT64_MAX;
+#if defined(__arm64__)
+    if (greg_size == sizeof(uint64_t)) {
+        ptr_mask = 1;
+        while (ptr_mask < text_high)
+            ptr_mask = (ptr_mask << 1) | 1;
+    }
+#endif
+
+    const uint64_t text_span = text_high - text_low;
+    plframe_error_t result = PLFRAME_ENOFRAME;
+
+    for (size_t base = 0; base < PLFRAME_STACK_SCAN_MAX_WORDS; base += PLFRAME_STACK_SCAN_CHUNK_WORDS) {
+        union {
+            uint64_t greg64[PLFRAME_STACK_SCAN_CHUNK_WORDS];
+            uint32_t greg32[PLFRAME_STACK_SCAN_CHUNK_WORDS];
+        } chunk;
+        uint64_t words[PLFRAME_STACK_SCAN_CHUNK_WORDS];
+        uint8_t hits[PLFRAME_STACK_SCAN_CHUNK_WORDS];
+        size_t count = PLFRAME_STACK_SCAN_CHUNK_WORDS;
+
+        /* Read the chunk; if it extends past the end of the stack, fall back to reading the words that are available */
+        pl_vm_off_t offset = (pl_vm_off_t) (base * greg_size);
+        if (plcrash_async_stack_window_memcpy(stack_window, task, sp, offset, &chunk, count * greg_size) != PLCRASH_ESUCCESS) {
+            for (count = 0; count < PLFRAME_STACK_SCAN_CHUNK_WORDS; count++) {
+                void *dest = (greg_size == sizeof(uint64_t)) ? (void *) &chunk.greg64[count] : (void *) &chunk.greg32[count];
+                if (plcrash_async_stack_window_memcpy(stack_window, task, sp, offset + (pl_vm_off_t) (count * greg_size), dest, greg_size) != PLCRASH_ESUCCESS)
+                    break;
+            }
+
+            if (count == 0)
+                break;
+        }
+
+        if (greg_size == sizeof(uint64_t)) {
+            for (size_t i = 0; i < count; i++)
+                words[i] = chunk.greg64[i] & ptr_mask;
+        } else {
+            for (size_t i = 0; i < count; i++)
+                words[i] = chunk.greg32[i];
+        }
+
+        /* Filter the chunk against the combined text range. This loop is branch-free, and is vectorized by the
+         * compiler; the vast majority of stack words are rejected here. */
+        uint8_t any = 0;
+        for (size_t i = 0; i < count; i++) {
+            hits[i] = (uint8_t) ((words[i] - text_low) < text_span);
+            any |= hits[i];
+        }
+
+        if (!any) {
+            if (count < PLFRAME_STACK_SCAN_CHUNK_WORDS)
+                break;
+            continue;
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            if (!hits[i] || words[i] == ip)
+                continue;
+
+            plcrash_async_image_t *image = plcrash_async_image_containing_address(image_list, (pl_vm_address_t) words[i]);
+            if (image == NULL)
+                continue;
+
+            if (!plframe_stack_scan_is_call_site(task, plcrash_async_macho_cpu_type(&image->macho_image), (pl_vm_address_t) words[i]))
+                continue;
+
+            /* Found a candidate return address */
+            *next_frame = *current_frame;
+            plcrash_async_thread_state_clear_all_regs(&next_frame->thread_state);
+            plcrash_async_thread_state_set_reg(&next_frame->thread_state, PLCRASH_REG_IP, words[i]);
+            pl_vm_address_t new_sp = sp + (base + i + 1) * greg_size;
+            plcrash_async_thread_state_set_reg(&next_frame->thread_state, PLCRASH_REG_SP, new_sp);
+
+            /* A frame pointer below the return address slot can not reference a caller's frame */
+            if (plcrash_async_thread_state_has_reg(state, PLCRASH_REG_FP)) {
+                plcrash_greg_t fp = plcrash_async_thread_state_get_reg(state, PLCRASH_REG_FP);
+                if (fp >= new_sp)
+                    plcrash_async_thread_state_set_reg(&next_frame->thread_state, PLCRASH_REG_FP, fp);
+            }
+
+            result = PLFRAME_ESUCCESS;
+            goto cleanup;
+        }
+
+        /* End of the readable stack */
+        if (count < PLFRAME_STACK_SCAN_CHUNK_WORDS)
+            break;
+    }
+
+cleanup:
+    plcrash_async_image_list_set_reading(image_list, false);
+    return result;
+}
+
+/**
+ * @}
+ */
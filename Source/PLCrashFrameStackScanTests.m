@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "SenTestCompat.h"
+#import "PLCrashFrameStackScan.h"
+
+#import <dlfcn.h>
+
+#if __has_feature(ptrauth_calls)
+#import <ptrauth.h>
+#endif
+
+/**
+ * Return the address to which this function returns; this is a genuine return address, following a call instruction
+ * within the test image.
+ */
+static __attribute__((noinline)) uintptr_t scan_test_return_address (void) {
+    void *addr = __builtin_extract_return_addr(__builtin_return_address(0));
+#if __has_feature(ptrauth_calls)
+    addr = ptrauth_strip(addr, ptrauth_key_return_address);
+#endif
+    return (uintptr_t) addr;
+}
+
+@interface PLCrashFrameStackScanTests : SenTestCase {
+@private
+    plcrash_async_image_list_t _image_list;
+
+    /** A zero-filled stack of PLFRAME_STACK_SCAN_MAX_WORDS + 1 words. The test stack is allocated on the heap, so
+     * that the scan can not stray into the test thread's real stack. */
+    uintptr_t *_stack;
+
+    /** A return address within the test image. */
+    uintptr_t _retaddr;
+}
+@end
+
+@implementation PLCrashFrameStackScanTests
+
+- (void) setUp {
+    Dl_info info;
+    _retaddr = scan_test_return_address();
+    STAssertTrue(dladdr((void *) _retaddr, &info) != 0, @"Could not find the test image");
+
+    plcrash_nasync_image_list_init(&_image_list, mach_task_self());
+    plcrash_nasync_image_list_append(&_image_list, (pl_vm_address_t) info.dli_fbase, info.dli_fname);
+
+    _stack = calloc(PLFRAME_STACK_SCAN_MAX_WORDS + 1, sizeof(uintptr_t));
+}
+
+- (void) tearDown {
+    free(_stack);
+    plcrash_nasync_image_list_free(&_image_list);
+}
+
+/**
+ * Initialize @a frame with the given stack and frame pointers.
+ */
+- (void) initFrame: (plframe_stackframe_t *) frame sp: (uintptr_t) sp fp: (uintptr_t) fp {
+    plcrash_async_thread_state_mach_thread_init(&frame->thread_state, pl_mach_thread_self());
+    plcrash_async_thread_state_clear_all_regs(&frame->thread_state);
+    plcrash_async_thread_state_set_reg(&frame->thread_state, PLCRASH_REG_IP, 0x1);
+    plcrash_async_thread_state_set_reg(&frame->thread_state, PLCRASH_REG_SP, sp);
+    plcrash_async_thread_state_set_reg(&frame->thread_state, PLCRASH_REG_FP, fp);
+}
+
+/**
+ * Verify that the scan skips values outside of any image, and recovers a return address.
+ */
+- (void) testScanFindsReturnAddress {
+    plframe_stackframe_t frame;
+    plframe_stackframe_t next;
+
+    _stack[2] = 0x10;
+    _stack[3] = UINTPTR_MAX;
+    _stack[PLFRAME_STACK_SCAN_CHUNK_WORDS + 5] = _retaddr;
+
+    uintptr_t fp = (uintptr_t) &_stack[PLFRAME_STACK_SCAN_CHUNK_WORDS + 10];
+    [self initFrame: &frame sp: (uintptr_t) _stack fp: fp];
+
+    STAssertEquals(plframe_cursor_read_stack_scan(mach_task_self(), NULL, &_image_list, &frame, NULL, &next), PLFRAME_ESUCCESS, @"Failed to scan stack");
+    STAssertEquals((uintptr_t) plcrash_async_thread_state_get_reg(&next.thread_state, PLCRASH_REG_IP), _retaddr, @"Incorrect IP");
+    STAssertEquals((uintptr_t) plcrash_async_thread_state_get_reg(&next.thread_state, PLCRASH_REG_SP), (uintptr_t) &_stack[PLFRAME_STACK_SCAN_CHUNK_WORDS + 6], @"Incorrect SP");
+    STAssertEquals((uintptr_t) plcrash_async_thread_state_get_reg(&next.thread_state, PLCRASH_REG_FP), fp, @"Frame pointer was not carried forward");
+
+    /* Resuming from the recovered frame finds nothing further */
+    STAssertEquals(plframe_cursor_read_stack_scan(mach_task_self(), NULL, &_image_list, &next, NULL, &frame), PLFRAME_ENOFRAME, @"Expected end of scan");
+}
+
+/**
+ * Verify that a frame pointer below the recovered return address slot is not carried forward.
+ */
+- (void) testScanDropsStaleFramePointer {
+    plframe_stackframe_t frame;
+    plframe_stackframe_t next;
+
+    _stack[4] = _retaddr;
+    [self initFrame: &frame sp: (uintptr_t) &_stack[1] fp: (uintptr_t) &_stack[0]];
+
+    STAssertEquals(plframe_cursor_read_stack_scan(mach_task_self(), NULL, &_image_list, &frame, NULL, &next), PLFRAME_ESUCCESS, @"Failed to scan stack");
+    STAssertFalse(plcrash_async_thread_state_has_reg(&next.thread_state, PLCRASH_REG_FP), @"Stale frame pointer was carried forward");
+}
+
+/**
+ * Verify that the scan is bounded to PLFRAME_STACK_SCAN_MAX_WORDS words.
+ */
+- (void) testScanBound {
+    plframe_stackframe_t frame;
+    plframe_stackframe_t next;
+
+    _stack[PLFRAME_STACK_SCAN_MAX_WORDS] = _retaddr;
+    [self initFrame: &frame sp: (uintptr_t) _stack fp: 0];
+
+    STAssertEquals(plframe_cursor_read_stack_scan(mach_task_self(), NULL, &_image_list, &frame, NULL, &next), PLFRAME_ENOFRAME, @"Scan exceeded its bound");
+
+    _stack[PLFRAME_STACK_SCAN_MAX_WORDS - 1] = _retaddr;
+    STAssertEquals(plframe_cursor_read_stack_scan(mach_task_self(), NULL, &_image_list, &frame, NULL, &next), PLFRAME_ESUCCESS, @"Failed to scan the final word");
+}
+
+/**
+ * Verify that the scan requires a stack pointer.
+ */
+- (void) testScanRequiresStackPointer {
+    plframe_stackframe_t frame;
+    plframe_stackframe_t next;
+
+    [self initFrame: &frame sp: (uintptr_t) _stack fp: 0];
+    plcrash_async_thread_state_clear_reg(&frame.thread_state, PLCRASH_REG_SP);
+
+    STAssertEquals(plframe_cursor_read_stack_scan(mach_task_self(), NULL, &_image_list, &frame, NULL, &next), PLFRAME_EBADFRAME, @"Expected a bad frame");
+}
+
+/**
+ * Verify that the cursor marks frames recovered by the stack scanner.
+ */
+- (void) testCursorMarksScannedFrames {
+    plframe_stackframe_t frame;
+    plframe_cursor_t cursor;
+    plframe_cursor_frame_reader_t *readers[] = { plframe_cursor_read_stack_scan };
+
+    _stack[8] = _retaddr;
+    [self initFrame: &frame sp: (uintptr_t) _stack fp: 0];
+
+    plframe_cursor_init(&cursor, mach_task_self(), &frame.thread_state, &_image_list);
+
+    STAssertEquals(plframe_cursor_next_with_readers(&cursor, readers, 1), PLFRAME_ESUCCESS, @"Failed to read initial frame");
+    STAssertFalse(plframe_cursor_is_scanned(&cursor), @"Initial frame should not be marked as scanned");
+
+    STAssertEquals(plframe_cursor_next_with_readers(&cursor, readers, 1), PLFRAME_ESUCCESS, @"Failed to scan frame");
+    STAssertTrue(plframe_cursor_is_scanned(&cursor), @"Scanned frame was not marked");
+
+    plcrash_greg_t pc;
+    STAssertEquals(plframe_cursor_get_reg(&cursor, PLCRASH_REG_IP, &pc), PLFRAME_ESUCCESS, @"Failed to fetch IP");
+    STAssertEquals((uintptr_t) pc, _retaddr, @"Incorrect IP");
+
+    plframe_cursor_free(&cursor);
+}
+
+@end
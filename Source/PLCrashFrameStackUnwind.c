@@ -33,16 +33,19 @@
  * Fetch the next frame, assuming a valid frame pointer in @a cursor's current frame.
  *
  * @param task The task containing the target frame stack.
+ * @param stack_window The read-ahead window over the target stack, or NULL.
+ * @param image_list The list of images loaded in the target @a task.
  * @param current_frame The current stack frame.
- * @param previous_frame The previous stack frame, or NULL if this is the first frame.
+ * @param previous_frame A summary of the previous stack frame, or NULL if this is the first frame.
  * @param next_frame The new frame to be initialized.
  *
  * @return Returns PLFRAME_ESUCCESS on success, PLFRAME_ENOFRAME is no additional frames are available, or a standard plframe_error_t code if an error occurs.
  */
 plframe_error_t plframe_cursor_read_frame_ptr (task_t task,
+                                               plcrash_async_stack_window_t *stack_window,
                                                plcrash_async_image_list_t *image_list,
                                                const plframe_stackframe_t *current_frame,
-                                               const plframe_stackframe_t *previous_frame,
+                                               const plframe_stackframe_summary_t *previous_frame,
                                                plframe_stackframe_t *next_frame)
 {
     /* Determine the appropriate type width for the target thread */
@@ -76,8 +79,8 @@ plframe_error_t plframe_cursor_read_frame_ptr (task_t task,
         return PLFRAME_ENOFRAME;
     
     /* Verify that the stack is growing in the right direction. */
-    if (previous_frame != NULL && plcrash_async_thread_state_has_reg(&previous_frame->thread_state, PLCRASH_REG_FP)) {
-        plcrash_greg_t prev_fp = plcrash_async_thread_state_get_reg(&previous_frame->thread_state, PLCRASH_REG_FP);
+    if (previous_frame != NULL && plframe_stackframe_summary_has_reg(previous_frame, PLCRASH_REG_FP)) {
+        plcrash_greg_t prev_fp = plframe_stackframe_summary_get_reg(previous_frame, PLCRASH_REG_FP);
 
         plcrash_async_thread_stack_direction_t stack_direction = plcrash_async_thread_state_get_stack_direction(&current_frame->thread_state);
         if ((stack_direction == PLCRASH_ASYNC_THREAD_STACK_DIRECTION_DOWN && fp < prev_fp) ||
@@ -93,7 +96,7 @@ plframe_error_t plframe_cursor_read_frame_ptr (task_t task,
     plcrash_greg_t new_pc;
     plcrash_error_t err;
     
-    err = plcrash_async_task_memcpy(task, (pl_vm_address_t) fp, 0, dest, len);
+    err = plcrash_async_stack_window_memcpy(stack_window, task, (pl_vm_address_t) fp, 0, dest, len);
     if (err != PLCRASH_ESUCCESS) {
         PLCF_DEBUG("Failed to read frame: %d", err);
         return PLFRAME_EBADFRAME;
@@ -36,9 +36,10 @@ extern "C" {
 #include "PLCrashFrameWalker.h"
 
 plframe_error_t plframe_cursor_read_frame_ptr (task_t task,
+                                               plcrash_async_stack_window_t *stack_window,
                                                plcrash_async_image_list_t *image_list,
                                                const plframe_stackframe_t *current_frame,
-                                               const plframe_stackframe_t *previous_frame,
+                                               const plframe_stackframe_summary_t *previous_frame,
                                                plframe_stackframe_t *next_frame);
     
 #ifdef __cplusplus
@@ -82,17 +82,17 @@ struct stack_frame {
     
     /* Try walking the stack */
     plframe_stackframe_t new_frame;
-    plframe_stackframe_t prev_frame;
-    plframe_stackframe_t frame = cursor.frame;
+    plframe_stackframe_summary_t prev_frame;
+    plframe_stackframe_t frame = *cursor.frame;
     for (int i = 0; i < frame_count; i++) {
         if (i > 0) {
-            plframe_stackframe_t *has_prev_frame = NULL;
+            plframe_stackframe_summary_t *has_prev_frame = NULL;
             if (i >= 2) // the 1st frame doesn't have a previous frame
                 has_prev_frame = &prev_frame;
 
             /* Fetch the next frame */
-            STAssertEquals(plframe_cursor_read_frame_ptr(cursor.task, &_image_list, &frame, has_prev_frame, &new_frame), PLFRAME_ESUCCESS, @"Failed to read next frame");
-            prev_frame = frame;
+            STAssertEquals(plframe_cursor_read_frame_ptr(cursor.task, NULL, &_image_list, &frame, has_prev_frame, &new_frame), PLFRAME_ESUCCESS, @"Failed to read next frame");
+            plframe_stackframe_summary_init(&prev_frame, &frame);
             frame = new_frame;
         }
 
@@ -103,7 +103,7 @@ struct stack_frame {
     }
 
     /* Ensure that the final frame's NULL fp triggers an ENOFRAME */
-    STAssertEquals(plframe_cursor_read_frame_ptr(cursor.task, &_image_list, &frame, &prev_frame, &new_frame), PLFRAME_ENOFRAME, @"Expected to hit end of frames");
+    STAssertEquals(plframe_cursor_read_frame_ptr(cursor.task, NULL, &_image_list, &frame, &prev_frame, &new_frame), PLFRAME_ENOFRAME, @"Expected to hit end of frames");
 }
 
 /**
@@ -130,18 +130,18 @@ struct stack_frame {
     
     /* Try walking the stack */
     plframe_stackframe_t new_frame;
-    plframe_stackframe_t prev_frame;
-    plframe_stackframe_t frame = cursor.frame;
+    plframe_stackframe_summary_t prev_frame;
+    plframe_stackframe_t frame = *cursor.frame;
     
     for (size_t i = 0; i < frame_count; i++) {
         if (i > 0) {
-            plframe_stackframe_t *has_prev_frame = NULL;
+            plframe_stackframe_summary_t *has_prev_frame = NULL;
             if (i >= 2) // the 1st frame doesn't have a previous frame
                 has_prev_frame = &prev_frame;
             
             /* Fetch the next frame */
-            STAssertEquals(plframe_cursor_read_frame_ptr(cursor.task, &_image_list, &frame, has_prev_frame, &new_frame), PLFRAME_ESUCCESS, @"Failed to read next frame");
-            prev_frame = frame;
+            STAssertEquals(plframe_cursor_read_frame_ptr(cursor.task, NULL, &_image_list, &frame, has_prev_frame, &new_frame), PLFRAME_ESUCCESS, @"Failed to read next frame");
+            plframe_stackframe_summary_init(&prev_frame, &frame);
             frame = new_frame;
         }
 
@@ -152,7 +152,7 @@ struct stack_frame {
     }
 
     /* Ensure that the final frame's bad fp triggers an EBADFRAME */
-    STAssertEquals(plframe_cursor_read_frame_ptr(cursor.task, &_image_list, &frame, &prev_frame, &new_frame), PLFRAME_EBADFRAME, @"Expected to hit end of frames");
+    STAssertEquals(plframe_cursor_read_frame_ptr(cursor.task, NULL, &_image_list, &frame, &prev_frame, &new_frame), PLFRAME_EBADFRAME, @"Expected to hit end of frames");
 }
 
 @end
@@ -33,6 +33,7 @@
 #include "PLCrashFrameStackUnwind.h"
 #include "PLCrashFrameCompactUnwind.h"
 #include "PLCrashFrameDWARFUnwind.h"
+#include "PLCrashFrameStackScan.h"
 
 #include "PLCrashFeatureConfig.h"
 
@@ -65,6 +66,53 @@ const char *plframe_strerror (plframe_error_t error) {
     return "Unhandled error code";
 }
 
+#pragma mark Frame Summaries
+
+/**
+ * Initialize @a summary with the generic registers of @a frame.
+ *
+ * @param summary The summary to be initialized.
+ * @param frame The frame to be summarized.
+ */
+void plframe_stackframe_summary_init (plframe_stackframe_summary_t *summary, const plframe_stackframe_t *frame) {
+    summary->valid_regs = 0;
+
+    for (plcrash_regnum_t regnum = PLCRASH_REG_IP; regnum <= PLCRASH_REG_SP; regnum++) {
+        if (!plcrash_async_thread_state_has_reg(&frame->thread_state, regnum)) {
+            summary->regs[regnum] = 0;
+            continue;
+        }
+
+        summary->valid_regs |= (1U << regnum);
+        summary->regs[regnum] = plcrash_async_thread_state_get_reg(&frame->thread_state, regnum);
+    }
+}
+
+/**
+ * Return true if @a regnum is available in @a summary. Only the generic IP, FP, and SP registers are retained by a
+ * frame summary; false will be returned for all other registers.
+ *
+ * @param summary The frame summary to query.
+ * @param regnum The register to check for availability.
+ */
+bool plframe_stackframe_summary_has_reg (const plframe_stackframe_summary_t *summary, plcrash_regnum_t regnum) {
+    if (regnum > PLCRASH_REG_SP)
+        return false;
+
+    return (summary->valid_regs & (1U << regnum)) != 0;
+}
+
+/**
+ * Fetch a register value from @a summary. The register must be available; see plframe_stackframe_summary_has_reg().
+ *
+ * @param summary The frame summary from which the register value will be fetched.
+ * @param regnum The register to fetch.
+ */
+plcrash_greg_t plframe_stackframe_summary_get_reg (const plframe_stackframe_summary_t *summary, plcrash_regnum_t regnum) {
+    PLCF_ASSERT(plframe_stackframe_summary_has_reg(summary, regnum));
+    return summary->regs[regnum];
+}
+
 #pragma mark Frame Walking
 
 /**
@@ -78,8 +126,25 @@ const char *plframe_strerror (plframe_error_t error) {
 static void plframe_cursor_internal_init (plframe_cursor_t *cursor, task_t task, plcrash_async_image_list_t *image_list) {
     cursor->depth = 0;
     cursor->task = task;
+    cursor->frame = &cursor->frames[0];
     cursor->image_list = image_list;
-    mach_port_mod_refs(mach_task_self(), cursor->task, MACH_PORT_RIGHT_SEND, 1);    
+    cursor->scanned = false;
+    plcrash_async_task_retain(cursor->task);
+}
+
+/**
+ * @internal
+ * Configure the cursor's stack window using the stack pointer of the initial frame. If the stack pointer is
+ * unavailable, the window will be disabled.
+ *
+ * @param cursor Cursor record for which the initial frame has been populated.
+ */
+static void plframe_cursor_internal_init_stack_window (plframe_cursor_t *cursor) {
+    pl_vm_address_t sp = PL_VM_ADDRESS_INVALID;
+    if (plcrash_async_thread_state_has_reg(&cursor->frame->thread_state, PLCRASH_REG_SP))
+        sp = plcrash_async_thread_state_get_reg(&cursor->frame->thread_state, PLCRASH_REG_SP);
+
+    plcrash_async_stack_window_init(&cursor->stack_window, cursor->task, sp);
 }
 
 /**
@@ -98,7 +163,8 @@ static void plframe_cursor_internal_init (plframe_cursor_t *cursor, task_t task,
 plframe_error_t plframe_cursor_init (plframe_cursor_t *cursor, task_t task, plcrash_async_thread_state_t *thread_state, plcrash_async_image_list_t *image_list) {
     plframe_cursor_internal_init(cursor, task, image_list);
 
-    plcrash_async_memcpy(&cursor->frame.thread_state, thread_state, sizeof(cursor->frame.thread_state));
+    plcrash_async_memcpy(&cursor->frame->thread_state, thread_state, sizeof(cursor->frame->thread_state));
+    plframe_cursor_internal_init_stack_window(cursor);
 
     return PLFRAME_ESUCCESS;
 }
@@ -121,7 +187,11 @@ plframe_error_t plframe_cursor_thread_init (plframe_cursor_t *cursor, task_t tas
     /* Standard initialization */
     plframe_cursor_internal_init(cursor, task, image_list);
     
-    return plcrash_async_thread_state_mach_thread_init(&cursor->frame.thread_state, thread);
+    plcrash_error_t err = plcrash_async_thread_state_mach_thread_init(&cursor->frame->thread_state, thread);
+    if (err == PLCRASH_ESUCCESS)
+        plframe_cursor_internal_init_stack_window(cursor);
+
+    return err;
 }
 
 /**
@@ -140,18 +210,22 @@ plframe_error_t plframe_cursor_next_with_readers (plframe_cursor_t *cursor, plfr
     }
     
     /* A previous frame is only available if we're on the second frame */
-    plframe_stackframe_t *prev_frame = NULL;
+    plframe_stackframe_summary_t *prev_frame = NULL;
     if (cursor->depth >= 2)
         prev_frame = &cursor->prev_frame;
     
-    /* Read in the next frame using the first successful frame reader. */
-    plframe_stackframe_t frame;
+    /* Read in the next frame using the first successful frame reader; the frame is read directly into the cursor's
+     * unused frame slot. */
+    plframe_stackframe_t *frame = (cursor->frame == &cursor->frames[0]) ? &cursor->frames[1] : &cursor->frames[0];
     plframe_error_t ferr = PLFRAME_EINVAL; // default return value if reader_count is 0.
+    bool scanned = false;
     
     for (size_t i = 0; i < reader_count; i++) {
-        ferr = readers[i](cursor->task, cursor->image_list, &cursor->frame, prev_frame, &frame);
-        if (ferr == PLFRAME_ESUCCESS)
+        ferr = readers[i](cursor->task, &cursor->stack_window, cursor->image_list, cursor->frame, prev_frame, frame);
+        if (ferr == PLFRAME_ESUCCESS) {
+            scanned = (readers[i] == plframe_cursor_read_stack_scan);
             break;
+        }
     }
     
     if (ferr != PLFRAME_ESUCCESS) {
@@ -159,19 +233,20 @@ plframe_error_t plframe_cursor_next_with_readers (plframe_cursor_t *cursor, plfr
     }
 
     /* Check for completion */
-    if (!plcrash_async_thread_state_has_reg(&frame.thread_state, PLCRASH_REG_IP)) {
+    if (!plcrash_async_thread_state_has_reg(&frame->thread_state, PLCRASH_REG_IP)) {
         PLCF_DEBUG("Missing expected IP value in successfully read frame");
         return PLFRAME_ENOFRAME;
     }
     
     /* A pc within the NULL page is a terminating frame */
-    plcrash_greg_t ip = plcrash_async_thread_state_get_reg(&frame.thread_state, PLCRASH_REG_IP);
+    plcrash_greg_t ip = plcrash_async_thread_state_get_reg(&frame->thread_state, PLCRASH_REG_IP);
     if (ip <= PAGE_SIZE)
         return PLFRAME_ENOFRAME;
     
-    /* Save the newly fetched frame */
-    cursor->prev_frame = cursor->frame;
+    /* Save the newly fetched frame, retaining only a summary of the current frame */
+    plframe_stackframe_summary_init(&cursor->prev_frame, cursor->frame);
     cursor->frame = frame;
+    cursor->scanned = scanned;
     cursor->depth++;
     
     return PLFRAME_ESUCCESS;
@@ -194,7 +269,11 @@ plframe_error_t plframe_cursor_next (plframe_cursor_t *cursor) {
         plframe_cursor_read_dwarf_unwind,
 #endif
 
-        plframe_cursor_read_frame_ptr
+        plframe_cursor_read_frame_ptr,
+
+#if PLCRASH_FEATURE_UNWIND_STACK_SCAN
+        plframe_cursor_read_stack_scan
+#endif
     };
 
     return plframe_cursor_next_with_readers(cursor, readers, sizeof(readers)/sizeof(readers[0]));
@@ -210,14 +289,25 @@ plframe_error_t plframe_cursor_next (plframe_cursor_t *cursor) {
  */
 plframe_error_t plframe_cursor_get_reg (plframe_cursor_t *cursor, plcrash_regnum_t regnum, plcrash_greg_t *reg) {
     /* Verify that the register is available */
-    if (!plcrash_async_thread_state_has_reg(&cursor->frame.thread_state, regnum))
+    if (!plcrash_async_thread_state_has_reg(&cursor->frame->thread_state, regnum))
         return PLFRAME_ENOTSUP;
 
     /* Fetch from thread state */
-    *reg = plcrash_async_thread_state_get_reg(&cursor->frame.thread_state, regnum);
+    *reg = plcrash_async_thread_state_get_reg(&cursor->frame->thread_state, regnum);
     return PLFRAME_ESUCCESS;
 }
 
+/**
+ * Return true if the current frame was recovered by heuristic stack scanning, rather than by a frame reader that
+ * follows the stack's unwind information or frame pointers. Such frames may be spurious, and should be marked as
+ * such when reported.
+ *
+ * @param cursor A cursor instance representing a valid frame, as initialized by plframe_cursor_next().
+ */
+bool plframe_cursor_is_scanned (plframe_cursor_t *cursor) {
+    return cursor->scanned;
+}
+
 /**
  * Get a register's name.
  *
@@ -225,7 +315,7 @@ plframe_error_t plframe_cursor_get_reg (plframe_cursor_t *cursor, plcrash_regnum
  * @param regnum The register number for which a name should be returned.
  */
 char const *plframe_cursor_get_regname (plframe_cursor_t *cursor, plcrash_regnum_t regnum) {
-    return plcrash_async_thread_state_get_reg_name(&cursor->frame.thread_state, regnum);
+    return plcrash_async_thread_state_get_reg_name(&cursor->frame->thread_state, regnum);
 }
 
 /**
@@ -234,7 +324,7 @@ char const *plframe_cursor_get_regname (plframe_cursor_t *cursor, plcrash_regnum
  * @param cursor The target cursor.
  */
 size_t plframe_cursor_get_regcount (plframe_cursor_t *cursor) {
-    return plcrash_async_thread_state_get_reg_count(&cursor->frame.thread_state);
+    return plcrash_async_thread_state_get_reg_count(&cursor->frame->thread_state);
 }
 
 /**
@@ -244,5 +334,5 @@ size_t plframe_cursor_get_regcount (plframe_cursor_t *cursor) {
  */
 void plframe_cursor_free(plframe_cursor_t *cursor) {
     if (cursor->task != MACH_PORT_NULL)
-        mach_port_mod_refs(mach_task_self(), cursor->task, MACH_PORT_RIGHT_SEND, -1);
+        plcrash_async_task_release(cursor->task);
 }
@@ -40,6 +40,7 @@
 
 #include "PLCrashAsyncThread.h"
 #include "PLCrashAsyncImageList.h"
+#include "PLCrashAsyncStackWindow.h"
 
 /* Configure supported targets based on the host build architecture. There's currently
  * no deployed architecture on which simultaneous support for different processor families
@@ -121,6 +122,22 @@ typedef struct plframe_stackframe {
     plcrash_async_thread_state_t thread_state;
 } plframe_stackframe_t;
 
+/**
+ * @internal
+ *
+ * A compact record of a previously walked stack frame.
+ *
+ * Frame readers consult the previous frame only to validate the progress of the stack walk; rather than retaining
+ * a complete thread state for the previous frame, the cursor retains only its generic IP, FP, and SP registers.
+ */
+typedef struct plframe_stackframe_summary {
+    /** The set of available registers in @a regs, as a bitmask of (1 << plcrash_gen_regnum_t) values. */
+    uint32_t valid_regs;
+
+    /** The frame's generic register values, indexed by plcrash_gen_regnum_t. */
+    plcrash_greg_t regs[PLCRASH_REG_SP+1];
+} plframe_stackframe_summary_t;
+
 /**
  * @internal
  * Frame cursor context.
@@ -136,38 +153,56 @@ typedef struct plframe_cursor {
      * structure should be considered uninitialized. */
     uint32_t depth;
     
-    /** The previous frame. This value is unitialized if no previous frame exists (eg, a depth of <= 1) */
-    plframe_stackframe_t prev_frame;
+    /** A summary of the previous frame. This value is unitialized if no previous frame exists (eg, a depth of <= 1) */
+    plframe_stackframe_summary_t prev_frame;
+
+    /** The current stack frame data. This points into @a frames, and the cursor must not be copied by value. */
+    plframe_stackframe_t *frame;
+
+    /** Frame storage. The slot not referenced by @a frame is used by the frame readers to populate the next frame,
+     * allowing the cursor to advance by swapping slots rather than copying the full thread state. */
+    plframe_stackframe_t frames[2];
 
-    /** The current stack frame data */
-    plframe_stackframe_t frame;
+    /** Read-ahead window over the target thread's stack, used to serve the frame readers' stack loads. */
+    plcrash_async_stack_window_t stack_window;
+
+    /** True if the current frame was recovered by heuristic stack scanning; see plframe_cursor_read_stack_scan(). */
+    bool scanned;
 } plframe_cursor_t;
 
 /**
  * Fetch the caller's stack frame, based on the current state in @a current_frame and @a previous_frame.
  *
  * @param task The task containing the target frame stack.
+ * @param stack_window A read-ahead window over the target thread's stack, or NULL. If non-NULL, stack loads should be
+ * performed via plcrash_async_stack_window_memcpy().
  * @param image_list The list of images loaded in the target @a task.
  * @param current_frame The current stack frame.
- * @param previous_frame The previous stack frame, or NULL if this is the first frame.
+ * @param previous_frame A summary of the previous stack frame, or NULL if this is the first frame.
  * @param next_frame The new frame to be initialized.
  *
  * @return Returns PLFRAME_ESUCCESS on success, PLFRAME_ENOFRAME is no additional frames are available, or a standard plframe_error_t code if an error occurs.
  */
 typedef plframe_error_t plframe_cursor_frame_reader_t (task_t task,
+                                                       plcrash_async_stack_window_t *stack_window,
                                                        plcrash_async_image_list_t *image_list,
                                                        const plframe_stackframe_t *current_frame,
-                                                       const plframe_stackframe_t *previous_frame,
+                                                       const plframe_stackframe_summary_t *previous_frame,
                                                        plframe_stackframe_t *next_frame);
 
 const char *plframe_strerror (plframe_error_t error);
 
+void plframe_stackframe_summary_init (plframe_stackframe_summary_t *summary, const plframe_stackframe_t *frame);
+bool plframe_stackframe_summary_has_reg (const plframe_stackframe_summary_t *summary, plcrash_regnum_t regnum);
+plcrash_greg_t plframe_stackframe_summary_get_reg (const plframe_stackframe_summary_t *summary, plcrash_regnum_t regnum);
+
 plframe_error_t plframe_cursor_init (plframe_cursor_t *cursor, task_t task, plcrash_async_thread_state_t *thread_state, plcrash_async_image_list_t *image_list);
 plframe_error_t plframe_cursor_thread_init (plframe_cursor_t *cursor, task_t task, thread_t thread, plcrash_async_image_list_t *image_list);
 
 char const *plframe_cursor_get_regname (plframe_cursor_t *cursor, plcrash_regnum_t regnum);
 size_t plframe_cursor_get_regcount (plframe_cursor_t *cursor);
 plframe_error_t plframe_cursor_get_reg (plframe_cursor_t *cursor, plcrash_regnum_t regnum, plcrash_greg_t *reg);
+bool plframe_cursor_is_scanned (plframe_cursor_t *cursor);
 
 plframe_error_t plframe_cursor_next (plframe_cursor_t *cursor);
 plframe_error_t plframe_cursor_next_with_readers (plframe_cursor_t *cursor, plframe_cursor_frame_reader_t *readers[], size_t reader_count);
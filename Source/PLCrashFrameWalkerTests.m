@@ -87,9 +87,10 @@
 
 /* Test-only frame readers */
 static plframe_error_t null_ip_reader (task_t task,
+                                       plcrash_async_stack_window_t *stack_window,
                                        plcrash_async_image_list_t *image_list,
                                        const plframe_stackframe_t *current_frame,
-                                       const plframe_stackframe_t *previous_frame,
+                                       const plframe_stackframe_summary_t *previous_frame,
                                        plframe_stackframe_t *next_frame)
 {
     plcrash_async_thread_state_copy(&next_frame->thread_state, &current_frame->thread_state);
@@ -98,9 +99,10 @@ static plframe_error_t null_ip_reader (task_t task,
 }
 
 static plframe_error_t esuccess_reader (task_t task,
+                                        plcrash_async_stack_window_t *stack_window,
                                         plcrash_async_image_list_t *image_list,
                                         const plframe_stackframe_t *current_frame,
-                                        const plframe_stackframe_t *previous_frame,
+                                        const plframe_stackframe_summary_t *previous_frame,
                                         plframe_stackframe_t *next_frame)
 {
     plcrash_async_thread_state_copy(&next_frame->thread_state, &current_frame->thread_state);
@@ -135,4 +137,12 @@ static plframe_error_t esuccess_reader (task_t task,
     STAssertTrue(unwind_test_harness(), @"Regression tests failed");
 }
 
+/*
+ * Run the stack walking regression tests as a benchmark, reporting the per-frame unwind cost of each reader
+ * set.
+ */
+- (void) testStackWalkerBenchmark {
+    STAssertTrue(unwind_benchmark_harness(100), @"Benchmark failed");
+}
+
 @end
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+#import <mach/mach.h>
+
+@class PLCrashReporter;
+@class PLCrashHangWatchdog;
+
+/**
+ * @ingroup constants
+ * The default main thread stall duration, in seconds, after which a watchdog report is generated.
+ */
+#define PLCRASH_HANG_WATCHDOG_DEFAULT_STALL_THRESHOLD 2.0
+
+/**
+ * @ingroup constants
+ * The default minimum interval, in seconds, between successive watchdog reports.
+ */
+#define PLCRASH_HANG_WATCHDOG_DEFAULT_MINIMUM_REPORT_INTERVAL 60.0
+
+/**
+ * The PLCrashHangWatchdogDelegate protocol is used to deliver watchdog reports generated by a PLCrashHangWatchdog.
+ */
+@protocol PLCrashHangWatchdogDelegate <NSObject>
+
+/**
+ * Called when a main thread stall has been detected and a watchdog report has been generated.
+ *
+ * @param watchdog The watchdog that detected the stall.
+ * @param reportData The encoded PLCrashReport data. The report will be of type PLCrashReportTypeWatchdog, and the
+ * stalled thread will be marked as the crashed thread.
+ *
+ * @warning This method is called on the watchdog's monitoring thread, not the main thread; the main thread may still
+ * be stalled when this method is called. No further stalls will be detected until this method returns.
+ */
+- (void) hangWatchdog: (PLCrashHangWatchdog *) watchdog didGenerateReport: (NSData *) reportData;
+
+@end
+
+/**
+ * @internal
+ * Private monitor state (shared between the run loop observer and the monitoring thread).
+ */
+typedef struct _PLCrashHangWatchdogState _PLCrashHangWatchdogState;
+
+@interface PLCrashHangWatchdog : NSObject {
+@private
+    /** Private monitor state */
+    _PLCrashHangWatchdogState *_state;
+
+    /** The reporter used to generate watchdog reports. */
+    PLCrashReporter *_crashReporter;
+
+    /** Report delegate (not retained) */
+    id<PLCrashHangWatchdogDelegate> _delegate;
+
+    /** The stall duration after which a report is generated. */
+    NSTimeInterval _stallThreshold;
+
+    /** The minimum interval between successive reports. */
+    NSTimeInterval _minimumReportInterval;
+}
+
+- (instancetype) initWithCrashReporter: (PLCrashReporter *) crashReporter delegate: (id<PLCrashHangWatchdogDelegate>) delegate;
+
+- (instancetype) initWithCrashReporter: (PLCrashReporter *) crashReporter
+                              delegate: (id<PLCrashHangWatchdogDelegate>) delegate
+                        stallThreshold: (NSTimeInterval) stallThreshold
+                 minimumReportInterval: (NSTimeInterval) minimumReportInterval;
+
+- (BOOL) startAndReturnError: (NSError **) outError;
+- (void) stop;
+
+/** The duration, in seconds, for which the main thread must be stalled before a watchdog report is generated. */
+@property(nonatomic, readonly) NSTimeInterval stallThreshold;
+
+/** The minimum interval, in seconds, between successive watchdog reports. */
+@property(nonatomic, readonly) NSTimeInterval minimumReportInterval;
+
+/** YES if the watchdog is currently monitoring the main thread. */
+@property(nonatomic, readonly, getter=isRunning) BOOL running;
+
+/** The number of watchdog reports that have been generated. */
+@property(nonatomic, readonly) NSUInteger reportCount;
+
+@end
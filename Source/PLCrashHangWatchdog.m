@@ -0,0 +1,377 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "PLCrashHangWatchdog.h"
+#import "CrashReporter.h"
+
+#import "PLCrashReporterNSError.h"
+
+#import <pthread.h>
+#import <libkern/OSAtomic.h>
+#import <mach/mach_time.h>
+
+/** @internal
+ * The minimum interval between polls of the monitored run loop, in seconds. */
+#define MIN_POLL_INTERVAL 0.01
+
+/**
+ * @internal
+ *
+ * Monitor state. @a activity is written only by the run loop observer, on the monitored thread, and read by the
+ * monitoring thread; all other fields are owned by the monitoring thread while it is running.
+ *
+ * The low bit of @a activity is set while the run loop is busy handling an event, and the remaining bits are
+ * a counter that is advanced each time the run loop begins handling a new event. This allows the observer to
+ * publish its state with a single aligned 32-bit store, and without reading the clock; the monitoring thread
+ * measures a stall from the first poll at which it observes a given busy activity value.
+ */
+struct _PLCrashHangWatchdogState {
+    /** The owning watchdog (not retained). */
+    PLCrashHangWatchdog *watchdog;
+
+    /** Current run loop activity state. */
+    volatile uint32_t activity;
+
+    /** The run loop being monitored. */
+    CFRunLoopRef run_loop;
+
+    /** The thread servicing @a run_loop. A send right is held for the thread. */
+    thread_t thread;
+
+    /** The run loop observer, or NULL if not running. */
+    CFRunLoopObserverRef observer;
+
+    /** The stall threshold, in mach_absolute_time() units. */
+    uint64_t threshold_abs;
+
+    /** The interval between polls, in mach_absolute_time() units. */
+    uint64_t poll_abs;
+
+    /** The minimum interval between reports, in mach_absolute_time() units. */
+    uint64_t min_report_interval_abs;
+
+    /** The mach_absolute_time() at which the most recent report was generated, or 0 if no report has been generated. */
+    uint64_t last_report_abs;
+
+    /** The number of reports generated. */
+    volatile uint32_t report_count;
+
+    /** The monitoring thread. Only valid while @a running is true. */
+    pthread_t monitor;
+
+    /** Set to request that the monitoring thread exit. */
+    volatile uint32_t should_stop;
+
+    /** True if the monitoring thread is running. */
+    bool running;
+};
+
+@interface PLCrashHangWatchdog (PrivateMethods)
+
+- (instancetype) initWithCrashReporter: (PLCrashReporter *) crashReporter
+                              delegate: (id<PLCrashHangWatchdogDelegate>) delegate
+                        stallThreshold: (NSTimeInterval) stallThreshold
+                 minimumReportInterval: (NSTimeInterval) minimumReportInterval
+                               runLoop: (CFRunLoopRef) runLoop
+                                thread: (thread_t) thread;
+
+- (void) reportStall;
+
+@end
+
+/**
+ * @internal
+ *
+ * Run loop observer callback. Marks the run loop as idle while it is waiting for events (or has exited), and
+ * as busy otherwise.
+ */
+static void plcrash_hang_watchdog_observer (CFRunLoopObserverRef observer, CFRunLoopActivity activity, void *info) {
+    _PLCrashHangWatchdogState *state = info;
+    uint32_t value = state->activity;
+
+    if (activity == kCFRunLoopBeforeWaiting || activity == kCFRunLoopExit) {
+        state->activity = value & ~1U;
+    } else {
+        /* The run loop is moving on to a new stage; advance the counter and mark the run loop as busy */
+        state->activity = (value + 2) | 1;
+    }
+}
+
+/**
+ * @internal
+ *
+ * Monitoring thread entry point.
+ */
+static void *plcrash_hang_watchdog_thread (void *arg) {
+    _PLCrashHangWatchdogState *state = arg;
+
+    uint32_t observed = state->activity;
+    uint64_t observed_since = mach_absolute_time();
+    bool reported = false;
+
+    while (!state->should_stop) {
+        mach_wait_until(mach_absolute_time() + state->poll_abs);
+
+        uint32_t activity = state->activity;
+        uint64_t now = mach_absolute_time();
+
+        /* Restart the stall timer whenever the run loop goes idle or begins handling a new event */
+        if ((activity & 1) == 0 || activity != observed) {
+            observed = activity;
+            observed_since = now;
+            reported = false;
+            continue;
+        }
+
+        /* Generate at most one report per stall */
+        if (reported || now - observed_since < state->threshold_abs)
+            continue;
+
+        /* Rate limit repeated reports; a stall that outlasts the limit is reported once it expires */
+        if (state->last_report_abs != 0 && now - state->last_report_abs < state->min_report_interval_abs)
+            continue;
+
+        reported = true;
+        state->last_report_abs = now;
+        [state->watchdog reportStall];
+    }
+
+    return NULL;
+}
+
+/**
+ * Monitors the main thread's run loop, and generates a watchdog report of all threads when the main thread
+ * stalls -- that is, when a single run loop callout runs for longer than the stall threshold.
+ *
+ * Reports are generated by the provided PLCrashReporter instance, and are tagged as PLCrashReportTypeWatchdog
+ * reports, with the main thread marked as the crashed thread. The process is not terminated. At most one report
+ * is generated per stall, and no more than one report is generated per PLCrashHangWatchdog::minimumReportInterval.
+ *
+ * Monitoring adds a run loop observer to the main run loop; the observer records the run loop's state with a
+ * single memory store per callout, and the stall detection itself is performed on a separate low-frequency
+ * monitoring thread.
+ */
+@implementation PLCrashHangWatchdog
+
+@synthesize stallThreshold = _stallThreshold;
+@synthesize minimumReportInterval = _minimumReportInterval;
+
+/**
+ * Initialize a new watchdog instance with the default stall threshold and report interval.
+ *
+ * @param crashReporter The reporter to be used to generate watchdog reports.
+ * @param delegate The delegate to which generated reports will be delivered. The delegate is not retained.
+ */
+- (instancetype) initWithCrashReporter: (PLCrashReporter *) crashReporter delegate: (id<PLCrashHangWatchdogDelegate>) delegate {
+    return [self initWithCrashReporter: crashReporter
+                              delegate: delegate
+                        stallThreshold: PLCRASH_HANG_WATCHDOG_DEFAULT_STALL_THRESHOLD
+                 minimumReportInterval: PLCRASH_HANG_WATCHDOG_DEFAULT_MINIMUM_REPORT_INTERVAL];
+}
+
+/**
+ * Initialize a new watchdog instance.
+ *
+ * @param crashReporter The reporter to be used to generate watchdog reports.
+ * @param delegate The delegate to which generated reports will be delivered. The delegate is not retained.
+ * @param stallThreshold The duration, in seconds, for which the main thread must be stalled before a report is
+ * generated. Stalls are detected by polling at a quarter of this interval, and may be reported up to one polling
+ * interval after the threshold has elapsed.
+ * @param minimumReportInterval The minimum interval, in seconds, between successive reports.
+ */
+- (instancetype) initWithCrashReporter: (PLCrashReporter *) crashReporter
+                              delegate: (id<PLCrashHangWatchdogDelegate>) delegate
+                        stallThreshold: (NSTimeInterval) stallThreshold
+                 minimumReportInterval: (NSTimeInterval) minimumReportInterval
+{
+    return [self initWithCrashReporter: crashReporter
+                              delegate: delegate
+                        stallThreshold: stallThreshold
+                 minimumReportInterval: minimumReportInterval
+                               runLoop: CFRunLoopGetMain()
+                                thread: pthread_mach_thread_np(pthread_main_thread_np())];
+}
+
+- (void) dealloc {
+    if (_state != NULL) {
+        [self stop];
+
+        mach_port_deallocate(mach_task_self(), _state->thread);
+        CFRelease(_state->run_loop);
+
+        free(_state);
+    }
+
+    [_crashReporter release];
+    [super dealloc];
+}
+
+/**
+ * Start monitoring the main thread.
+ *
+ * @param outError A pointer to an NSError object variable. If an error occurs, this pointer will contain an error
+ * object indicating why monitoring could not be started. If no error occurs, this parameter will be left unmodified.
+ * You may specify nil for this parameter, and no error information will be provided.
+ *
+ * @return Returns YES on success, or NO if the watchdog is already running or the monitoring thread could not be
+ * started.
+ */
+- (BOOL) startAndReturnError: (NSError **) outError {
+    if (_state->running) {
+        plcrash_populate_error(outError, PLCrashReporterErrorResourceBusy, @"The watchdog is already running", nil);
+        return NO;
+    }
+
+    CFRunLoopObserverContext context = { .version = 0, .info = _state };
+    _state->observer = CFRunLoopObserverCreate(NULL, kCFRunLoopAllActivities, true, 0, plcrash_hang_watchdog_observer, &context);
+    if (_state->observer == NULL) {
+        plcrash_populate_error(outError, PLCrashReporterErrorUnknown, @"Could not create the watchdog run loop observer", nil);
+        return NO;
+    }
+
+    /* Begin in the idle state; the observer will mark the run loop busy once it begins handling events */
+    _state->activity = 0;
+    _state->should_stop = 0;
+    OSMemoryBarrier();
+
+    int err = pthread_create(&_state->monitor, NULL, plcrash_hang_watchdog_thread, _state);
+    if (err != 0) {
+        plcrash_populate_posix_error(outError, err, @"Could not start the watchdog monitoring thread");
+        CFRelease(_state->observer);
+        _state->observer = NULL;
+        return NO;
+    }
+
+    CFRunLoopAddObserver(_state->run_loop, _state->observer, kCFRunLoopCommonModes);
+
+    _state->running = true;
+    return YES;
+}
+
+/**
+ * Stop monitoring, waiting for the monitoring thread to exit. If a report is currently being generated, this method
+ * will block until the report has been delivered. If the watchdog is not running, this method has no effect.
+ */
+- (void) stop {
+    if (!_state->running)
+        return;
+
+    CFRunLoopObserverInvalidate(_state->observer);
+    CFRelease(_state->observer);
+    _state->observer = NULL;
+
+    OSAtomicCompareAndSwap32Barrier(0, 1, (int32_t *) &_state->should_stop);
+    pthread_join(_state->monitor, NULL);
+
+    _state->running = false;
+}
+
+- (BOOL) isRunning {
+    return _state->running;
+}
+
+- (NSUInteger) reportCount {
+    return _state->report_count;
+}
+
+@end
+
+/**
+ * @internal
+ *
+ * Private Methods
+ */
+@implementation PLCrashHangWatchdog (PrivateMethods)
+
+/**
+ * Initialize a new watchdog instance that monitors @a runLoop, serviced by @a thread.
+ *
+ * @param crashReporter The reporter to be used to generate watchdog reports.
+ * @param delegate The delegate to which generated reports will be delivered. The delegate is not retained.
+ * @param stallThreshold The stall threshold, in seconds.
+ * @param minimumReportInterval The minimum interval, in seconds, between successive reports.
+ * @param runLoop The run loop to be monitored.
+ * @param thread The thread servicing @a runLoop. This thread will be marked as the crashed thread in generated
+ * reports. The watchdog acquires its own reference to the thread port.
+ */
+- (instancetype) initWithCrashReporter: (PLCrashReporter *) crashReporter
+                              delegate: (id<PLCrashHangWatchdogDelegate>) delegate
+                        stallThreshold: (NSTimeInterval) stallThreshold
+                 minimumReportInterval: (NSTimeInterval) minimumReportInterval
+                               runLoop: (CFRunLoopRef) runLoop
+                                thread: (thread_t) thread
+{
+    if ((self = [super init]) == nil)
+        return nil;
+
+    _crashReporter = [crashReporter retain];
+    _delegate = delegate;
+    _stallThreshold = stallThreshold;
+    _minimumReportInterval = minimumReportInterval;
+
+    _state = calloc(1, sizeof(_PLCrashHangWatchdogState));
+    if (_state == NULL) {
+        [self release];
+        return nil;
+    }
+
+    _state->watchdog = self;
+    _state->run_loop = (CFRunLoopRef) CFRetain(runLoop);
+    _state->thread = thread;
+    mach_port_mod_refs(mach_task_self(), thread, MACH_PORT_RIGHT_SEND, 1);
+
+    /* Convert the intervals to mach_absolute_time() units */
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+
+    NSTimeInterval pollInterval = MAX(stallThreshold / 4.0, MIN_POLL_INTERVAL);
+    _state->threshold_abs = (uint64_t) ((stallThreshold * NSEC_PER_SEC) * timebase.denom / timebase.numer);
+    _state->poll_abs = (uint64_t) ((pollInterval * NSEC_PER_SEC) * timebase.denom / timebase.numer);
+    _state->min_report_interval_abs = (uint64_t) ((minimumReportInterval * NSEC_PER_SEC) * timebase.denom / timebase.numer);
+
+    return self;
+}
+
+/**
+ * Generate a watchdog report for the monitored thread, and deliver it to the delegate. Called on the monitoring
+ * thread.
+ */
+- (void) reportStall {
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    NSError *error;
+
+    NSData *data = [_crashReporter generateWatchdogReportWithThread: _state->thread error: &error];
+    if (data == nil) {
+        NSLog(@"Could not generate watchdog report: %@", error);
+    } else {
+        OSAtomicIncrement32Barrier((int32_t *) &_state->report_count);
+        [_delegate hangWatchdog: self didGenerateReport: data];
+    }
+
+    [pool drain];
+}
+
+@end
@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "SenTestCompat.h"
+
+#import "PLCrashHangWatchdog.h"
+#import "PLCrashReport.h"
+#import "PLCrashReporter.h"
+#import "PLCrashReporterConfig.h"
+
+#import <mach/mach_time.h>
+
+/* Number of run loop iterations performed by the monitoring overhead benchmark */
+#define BENCHMARK_ITERATIONS 100000
+
+@interface PLCrashHangWatchdog (PrivateMethods)
+- (instancetype) initWithCrashReporter: (PLCrashReporter *) crashReporter
+                              delegate: (id<PLCrashHangWatchdogDelegate>) delegate
+                        stallThreshold: (NSTimeInterval) stallThreshold
+                 minimumReportInterval: (NSTimeInterval) minimumReportInterval
+                               runLoop: (CFRunLoopRef) runLoop
+                                thread: (thread_t) thread;
+@end
+
+@interface PLCrashHangWatchdogTests : SenTestCase <PLCrashHangWatchdogDelegate> {
+@private
+    /** Reporter used to generate watchdog reports */
+    PLCrashReporter *_reporter;
+
+    /** The current thread */
+    thread_t _thread;
+
+    /** Reports delivered to the delegate. Must be accessed while synchronized on the receiver. */
+    NSMutableArray *_reports;
+}
+@end
+
+@implementation PLCrashHangWatchdogTests
+
+- (void) setUp {
+    _reporter = [[PLCrashReporter alloc] initWithConfiguration: [PLCrashReporterConfig defaultConfiguration]];
+    _thread = mach_thread_self();
+    _reports = [[NSMutableArray alloc] init];
+}
+
+- (void) tearDown {
+    [_reporter release];
+    mach_port_deallocate(mach_task_self(), _thread);
+    [_reports release];
+}
+
+- (void) hangWatchdog: (PLCrashHangWatchdog *) watchdog didGenerateReport: (NSData *) reportData {
+    @synchronized (self) {
+        [_reports addObject: reportData];
+    }
+}
+
+/* Returns a watchdog monitoring the current thread's run loop */
+- (PLCrashHangWatchdog *) watchdogWithStallThreshold: (NSTimeInterval) stallThreshold minimumReportInterval: (NSTimeInterval) minimumReportInterval {
+    return [[[PLCrashHangWatchdog alloc] initWithCrashReporter: _reporter
+                                                      delegate: self
+                                                stallThreshold: stallThreshold
+                                         minimumReportInterval: minimumReportInterval
+                                                       runLoop: CFRunLoopGetCurrent()
+                                                        thread: _thread] autorelease];
+}
+
+/* Timer callback; stalls the run loop for the timer's userInfo interval */
+- (void) stall: (NSTimer *) timer {
+    [NSThread sleepForTimeInterval: [[timer userInfo] doubleValue]];
+}
+
+/* Schedule a stall of @a duration on the current run loop after @a delay, and then run the run loop for @a runTime */
+- (void) runWithStall: (NSTimeInterval) duration after: (NSTimeInterval) delay runTime: (NSTimeInterval) runTime {
+    NSTimer *timer = [NSTimer timerWithTimeInterval: delay target: self selector: @selector(stall:) userInfo: [NSNumber numberWithDouble: duration] repeats: NO];
+    [[NSRunLoop currentRunLoop] addTimer: timer forMode: NSDefaultRunLoopMode];
+    [[NSRunLoop currentRunLoop] runUntilDate: [NSDate dateWithTimeIntervalSinceNow: runTime]];
+}
+
+/**
+ * Verify that a stall generates a single watchdog report.
+ */
+- (void) testStallGeneratesReport {
+    NSError *error;
+    PLCrashHangWatchdog *watchdog = [self watchdogWithStallThreshold: 0.1 minimumReportInterval: 0.0];
+    STAssertTrue([watchdog startAndReturnError: &error], @"Failed to start watchdog: %@", error);
+    STAssertTrue([watchdog isRunning], @"Watchdog not marked as running");
+
+    /* Stall for several multiples of the threshold; only one report should be generated */
+    [self runWithStall: 0.5 after: 0.05 runTime: 0.7];
+    [watchdog stop];
+    STAssertFalse([watchdog isRunning], @"Watchdog still marked as running");
+
+    STAssertEquals((NSUInteger) 1, [_reports count], @"Expected exactly one report for a single stall");
+    STAssertEquals((NSUInteger) 1, [watchdog reportCount], @"Incorrect report count");
+    if ([_reports count] == 0)
+        return;
+
+    PLCrashReport *report = [[[PLCrashReport alloc] initWithData: [_reports objectAtIndex: 0] error: &error] autorelease];
+    STAssertNotNil(report, @"Could not parse watchdog report: %@", error);
+    STAssertEquals(PLCrashReportTypeWatchdog, report.reportType, @"Report not marked as a watchdog report");
+}
+
+/**
+ * Verify that an idle run loop does not generate reports.
+ */
+- (void) testIdleDoesNotGenerateReport {
+    NSError *error;
+    PLCrashHangWatchdog *watchdog = [self watchdogWithStallThreshold: 0.1 minimumReportInterval: 0.0];
+    STAssertTrue([watchdog startAndReturnError: &error], @"Failed to start watchdog: %@", error);
+
+    [[NSRunLoop currentRunLoop] runUntilDate: [NSDate dateWithTimeIntervalSinceNow: 0.5]];
+    [watchdog stop];
+
+    STAssertEquals((NSUInteger) 0, [_reports count], @"Report generated for an idle run loop");
+}
+
+/**
+ * Verify that reports for successive stalls are rate limited.
+ */
+- (void) testReportRateLimit {
+    NSError *error;
+    PLCrashHangWatchdog *watchdog = [self watchdogWithStallThreshold: 0.1 minimumReportInterval: 60.0];
+    STAssertTrue([watchdog startAndReturnError: &error], @"Failed to start watchdog: %@", error);
+
+    [self runWithStall: 0.3 after: 0.05 runTime: 0.4];
+    [self runWithStall: 0.3 after: 0.05 runTime: 0.4];
+    [watchdog stop];
+
+    STAssertEquals((NSUInteger) 1, [_reports count], @"Second stall was not rate limited");
+}
+
+/**
+ * Verify that starting a running watchdog fails.
+ */
+- (void) testDoubleStart {
+    NSError *error;
+    PLCrashHangWatchdog *watchdog = [self watchdogWithStallThreshold: 1.0 minimumReportInterval: 0.0];
+    STAssertTrue([watchdog startAndReturnError: &error], @"Failed to start watchdog: %@", error);
+    STAssertFalse([watchdog startAndReturnError: NULL], @"Started an already running watchdog");
+    [watchdog stop];
+}
+
+/* Run the current thread's run loop for @a iterations non-blocking passes, returning the elapsed time in nanoseconds */
+static double run_loop_benchmark (uint32_t iterations) {
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+
+    uint64_t start = mach_absolute_time();
+    for (uint32_t i = 0; i < iterations; i++)
+        CFRunLoopRunInMode(kCFRunLoopDefaultMode, 0, true);
+    uint64_t elapsed = mach_absolute_time() - start;
+
+    return (double) elapsed * timebase.numer / timebase.denom;
+}
+
+/**
+ * Measure the per-iteration run loop overhead of the watchdog's observer.
+ */
+- (void) testMonitoringOverheadBenchmark {
+    NSError *error;
+    PLCrashHangWatchdog *watchdog = [self watchdogWithStallThreshold: 60.0 minimumReportInterval: 0.0];
+
+    /* Warm up, then measure without and with monitoring */
+    run_loop_benchmark(BENCHMARK_ITERATIONS / 10);
+    double baseline = run_loop_benchmark(BENCHMARK_ITERATIONS);
+
+    STAssertTrue([watchdog startAndReturnError: &error], @"Failed to start watchdog: %@", error);
+    double monitored = run_loop_benchmark(BENCHMARK_ITERATIONS);
+    [watchdog stop];
+
+    fprintf(stderr, "Hang watchdog benchmark: %u run loop iterations\n", BENCHMARK_ITERATIONS);
+    fprintf(stderr, "  %-12s %12s\n", "", "ns/iter");
+    fprintf(stderr, "  %-12s %12.1f\n", "baseline", baseline / BENCHMARK_ITERATIONS);
+    fprintf(stderr, "  %-12s %12.1f\n", "monitored", monitored / BENCHMARK_ITERATIONS);
+    fprintf(stderr, "  %-12s %12.1f\n", "overhead", (monitored - baseline) / BENCHMARK_ITERATIONS);
+
+    STAssertEquals((NSUInteger) 0, [_reports count], @"Benchmark unexpectedly generated a report");
+}
+
+@end
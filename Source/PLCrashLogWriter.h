@@ -38,6 +38,9 @@ extern "C" {
 
 #import "PLCrashAsync.h"
 #import "PLCrashAsyncImageList.h"
+#import "PLCrashAsyncMObjectPool.h"
+#import "PLCrashAsyncPageCache.h"
+#import "PLCrashAsyncStringTable.h"
 #import "PLCrashFrameWalker.h"
     
 #import "PLCrashAsyncSymbolication.h"
@@ -55,6 +58,42 @@ extern "C" {
  * @{
  */
 
+/**
+ * @internal
+ *
+ * Report types, as defined by CrashReport.ReportInfo.ReportType.
+ */
+typedef enum {
+    /** The report type will be inferred from the report contents. */
+    PLCRASH_LOG_REPORT_TYPE_UNKNOWN = 0,
+
+    /** A report generated due to a fatal signal or machine exception. */
+    PLCRASH_LOG_REPORT_TYPE_CRASH = 1,
+
+    /** A report generated due to an unhandled language-level exception. */
+    PLCRASH_LOG_REPORT_TYPE_LANGUAGE_EXCEPTION = 2,
+
+    /** A report generated due to a hung or deadlocked thread. */
+    PLCRASH_LOG_REPORT_TYPE_WATCHDOG = 3,
+
+    /** A report generated on request, where no crash occured. */
+    PLCRASH_LOG_REPORT_TYPE_LIVE = 4
+} plcrash_log_report_type_t;
+
+/**
+ * @internal
+ *
+ * Register encodings supported by the crash log writer.
+ */
+typedef enum {
+    /** Registers are written as CrashReport.Thread.RegisterValue messages, each including the register's name. */
+    PLCRASH_LOG_REGISTER_ENCODING_NAMED = 0,
+
+    /** Registers are written as fixed fields of a typed CrashReport.Thread.RegisterState message. Register values
+     * with additional type or content information are also written as RegisterValue messages. */
+    PLCRASH_LOG_REGISTER_ENCODING_TYPED = 1
+} plcrash_log_register_encoding_t;
+
 /**
  * @internal
  *
@@ -64,14 +103,25 @@ typedef struct plcrash_log_writer {
     /** The strategy to use for symbolication */
     plcrash_async_symbol_strategy_t symbol_strategy;
 
+    /** The encoding to use for thread register values */
+    plcrash_log_register_encoding_t register_encoding;
+
     /** Report data */
     struct {
         /** If true, the report should be marked as a 'generated' user-requested report, rather than as a true crash
          * report */
         bool user_requested;
 
+        /** The report type, or PLCRASH_LOG_REPORT_TYPE_UNKNOWN if the type should be inferred when the report is
+         * written. */
+        plcrash_log_report_type_t type;
+
         /** Report UUID */
         uuid_t uuid_bytes;
+
+        /** The number of crashed thread frames included in the report fingerprint, or 0 if no fingerprint should
+         * be written. */
+        uint32_t fingerprint_frame_count;
     } report_info;
 
     /** System data */
@@ -154,6 +204,18 @@ typedef struct plcrash_log_writer {
         /** Call stack frame count, or 0 if the call stack is unavailable */
         size_t callstack_count;
     } uncaught_exception;
+
+    /** The page cache to be attached while writing a report (may be NULL). This is a borrowed reference, and must
+     * remain valid for the lifetime of the writer. */
+    plcrash_async_page_cache_t *page_cache;
+
+    /** The mapping pool to be attached while writing a report (may be NULL). This is a borrowed reference, and must
+     * remain valid for the lifetime of the writer. */
+    plcrash_async_mobject_pool_t *mobject_pool;
+
+    /** The string table used to intern symbol and image names while writing a report (may be NULL). This is a
+     * borrowed reference, and must remain valid for the lifetime of the writer. */
+    plcrash_async_string_table_t *string_table;
 } plcrash_log_writer_t;
 
 /**
@@ -219,6 +281,12 @@ plcrash_error_t plcrash_log_writer_init (plcrash_log_writer_t *writer,
                                          plcrash_async_symbol_strategy_t symbol_strategy,
                                          BOOL user_requested);
 void plcrash_log_writer_set_exception (plcrash_log_writer_t *writer, NSException *exception);
+void plcrash_log_writer_set_report_type (plcrash_log_writer_t *writer, plcrash_log_report_type_t type);
+void plcrash_log_writer_set_register_encoding (plcrash_log_writer_t *writer, plcrash_log_register_encoding_t encoding);
+void plcrash_log_writer_set_fingerprint_frame_count (plcrash_log_writer_t *writer, uint32_t frame_count);
+void plcrash_log_writer_set_page_cache (plcrash_log_writer_t *writer, plcrash_async_page_cache_t *page_cache);
+void plcrash_log_writer_set_mobject_pool (plcrash_log_writer_t *writer, plcrash_async_mobject_pool_t *mobject_pool);
+void plcrash_log_writer_set_string_table (plcrash_log_writer_t *writer, plcrash_async_string_table_t *string_table);
 
 plcrash_error_t plcrash_log_writer_write (plcrash_log_writer_t *writer,
                                           thread_t crashed_thread,
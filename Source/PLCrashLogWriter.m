@@ -105,6 +105,9 @@ enum {
     /** CrashReport.symbol.end_address */
     PLCRASH_PROTO_SYMBOL_END_ADDRESS = 3,
 
+    /** CrashReport.symbol.name_index */
+    PLCRASH_PROTO_SYMBOL_NAME_INDEX = 4,
+
 
     /** CrashReport.threads */
     PLCRASH_PROTO_THREADS_ID = 3,
@@ -126,6 +129,9 @@ enum {
     /** CrashReport.thread.frame.symbol */
     PLCRASH_PROTO_THREAD_FRAME_SYMBOL_ID = 6,
 
+    /** CrashReport.thread.frame.scanned */
+    PLCRASH_PROTO_THREAD_FRAME_SCANNED_ID = 7,
+
 
     /** CrashReport.thread.registers */
     PLCRASH_PROTO_THREAD_REGISTERS_ID = 4,
@@ -142,6 +148,21 @@ enum {
     /** CrashReport.thread.register.content */
     PLCRASH_PROTO_THREAD_REGISTER_CONTENT_ID = 4,
 
+    /** CrashReport.thread.register_state */
+    PLCRASH_PROTO_THREAD_REGISTER_STATE_ID = 5,
+
+    /** CrashReport.thread.register_state.x86_32 */
+    PLCRASH_PROTO_THREAD_REGISTER_STATE_X86_32_ID = 1,
+
+    /** CrashReport.thread.register_state.x86_64 */
+    PLCRASH_PROTO_THREAD_REGISTER_STATE_X86_64_ID = 2,
+
+    /** CrashReport.thread.register_state.arm */
+    PLCRASH_PROTO_THREAD_REGISTER_STATE_ARM_ID = 3,
+
+    /** CrashReport.thread.register_state.arm64 */
+    PLCRASH_PROTO_THREAD_REGISTER_STATE_ARM64_ID = 4,
+
 
     /** CrashReport.images */
     PLCRASH_PROTO_BINARY_IMAGES_ID = 4,
@@ -154,6 +175,9 @@ enum {
 
     /** CrashReport.BinaryImage.name */
     PLCRASH_PROTO_BINARY_IMAGE_NAME_ID = 3,
+
+    /** CrashReport.BinaryImage.name_index */
+    PLCRASH_PROTO_BINARY_IMAGE_NAME_INDEX_ID = 6,
     
     /** CrashReport.BinaryImage.uuid */
     PLCRASH_PROTO_BINARY_IMAGE_UUID_ID = 4,
@@ -257,6 +281,19 @@ enum {
 
     /** CrashReport.report_info.uuid */
     PLCRASH_PROTO_REPORT_INFO_UUID_ID = 2,
+
+    /** CrashReport.report_info.type */
+    PLCRASH_PROTO_REPORT_INFO_TYPE_ID = 3,
+
+    /** CrashReport.report_info.fingerprint */
+    PLCRASH_PROTO_REPORT_INFO_FINGERPRINT_ID = 4,
+
+
+    /** CrashReport.string_table */
+    PLCRASH_PROTO_STRING_TABLE_ID = 10,
+
+    /** CrashReport.string_table.entries */
+    PLCRASH_PROTO_STRING_TABLE_ENTRIES_ID = 1,
 };
 
 /**
@@ -479,6 +516,99 @@ plcrash_error_t plcrash_log_writer_init (plcrash_log_writer_t *writer,
     return PLCRASH_ESUCCESS;
 }
 
+/**
+ * Set the page cache to be used while writing reports. If non-NULL, @a page_cache will be attached to the writing
+ * thread for the duration of plcrash_log_writer_write(), and small target memory reads will be served from the cache.
+ *
+ * @param writer The writer to configure.
+ * @param page_cache A preallocated page cache, or NULL to disable page caching. This is a borrowed reference, and must
+ * remain valid for the lifetime of @a writer.
+ *
+ * @warning This function is not async safe, and must be called outside of a signal handler.
+ */
+void plcrash_log_writer_set_page_cache (plcrash_log_writer_t *writer, plcrash_async_page_cache_t *page_cache) {
+    writer->page_cache = page_cache;
+
+    /* Ensure that any signal handler has a consistent view of the above configuration. */
+    OSMemoryBarrier();
+}
+
+/**
+ * Set the mapping pool to be used while writing reports. If non-NULL, @a mobject_pool will be attached to the writing
+ * thread for the duration of plcrash_log_writer_write(); image segment and section mappings will be retained for the
+ * whole report, and released together once the report has been written.
+ *
+ * @param writer The writer to configure.
+ * @param mobject_pool A preallocated mapping pool, or NULL to disable mapping reuse. This is a borrowed reference, and
+ * must remain valid for the lifetime of @a writer.
+ *
+ * @warning This function is not async safe, and must be called outside of a signal handler.
+ */
+void plcrash_log_writer_set_mobject_pool (plcrash_log_writer_t *writer, plcrash_async_mobject_pool_t *mobject_pool) {
+    writer->mobject_pool = mobject_pool;
+
+    /* Ensure that any signal handler has a consistent view of the above configuration. */
+    OSMemoryBarrier();
+}
+
+/**
+ * Set the string table to be used while writing reports. If non-NULL, symbol names and binary image names will be
+ * written once to the report's string table, and referenced by index from each stack frame and image. Strings that
+ * do not fit within @a string_table are written in full.
+ *
+ * @param writer The writer to configure.
+ * @param string_table A preallocated string table, or NULL to write all strings in full. This is a borrowed reference,
+ * and must remain valid for the lifetime of @a writer.
+ *
+ * @warning This function is not async safe, and must be called outside of a signal handler.
+ */
+void plcrash_log_writer_set_string_table (plcrash_log_writer_t *writer, plcrash_async_string_table_t *string_table) {
+    writer->string_table = string_table;
+
+    /* Ensure that any signal handler has a consistent view of the above configuration. */
+    OSMemoryBarrier();
+}
+
+/**
+ * Set the report type for this writer. If not set, the report type is inferred when the report is written: reports
+ * marked as user requested are written as PLCRASH_LOG_REPORT_TYPE_LIVE reports, reports with an uncaught exception
+ * as PLCRASH_LOG_REPORT_TYPE_LANGUAGE_EXCEPTION reports, and all others as PLCRASH_LOG_REPORT_TYPE_CRASH reports.
+ *
+ * @warning This function is not async safe, and must be called outside of a signal handler.
+ */
+void plcrash_log_writer_set_report_type (plcrash_log_writer_t *writer, plcrash_log_report_type_t type) {
+    writer->report_info.type = type;
+
+    /* Ensure that any signal handler has a consistent view of the above configuration. */
+    OSMemoryBarrier();
+}
+
+/**
+ * Set the encoding used for thread register values. If not set, registers are written using
+ * PLCRASH_LOG_REGISTER_ENCODING_NAMED, which is readable by all v1 report decoders.
+ *
+ * @warning This function is not async safe, and must be called outside of a signal handler.
+ */
+void plcrash_log_writer_set_register_encoding (plcrash_log_writer_t *writer, plcrash_log_register_encoding_t encoding) {
+    writer->register_encoding = encoding;
+
+    /* Ensure that any signal handler has a consistent view of the above configuration. */
+    OSMemoryBarrier();
+}
+
+/**
+ * Set the number of crashed thread frames included in the report fingerprint. If not set, or set to 0, no
+ * fingerprint is written.
+ *
+ * @warning This function is not async safe, and must be called outside of a signal handler.
+ */
+void plcrash_log_writer_set_fingerprint_frame_count (plcrash_log_writer_t *writer, uint32_t frame_count) {
+    writer->report_info.fingerprint_frame_count = frame_count;
+
+    /* Ensure that any signal handler has a consistent view of the above configuration. */
+    OSMemoryBarrier();
+}
+
 /**
  * Set the uncaught exception for this writer. Once set, this exception will be used to
  * provide exception data for the crash log output.
@@ -803,20 +933,265 @@ static size_t plcrash_writer_write_thread_register (plcrash_async_file_t *file,
     return rv;
 }
 
+/**
+ * @internal
+ *
+ * A typed register state layout, mapping a thread state's register numbers to the fields of the corresponding
+ * CrashReport.Thread.RegisterState message.
+ */
+typedef struct plcrash_writer_register_layout {
+    /** The CrashReport.Thread.RegisterState field containing messages of this layout. */
+    uint32_t message_id;
+
+    /** The register field type; either PLPROTOBUF_C_TYPE_UINT32 or PLPROTOBUF_C_TYPE_UINT64. */
+    PLProtobufCType field_type;
+
+    /** Field numbers, indexed by register number. Registers with a field number of 0 are not written. */
+    const uint32_t *field_ids;
+
+    /** The number of entries in @a field_ids. */
+    size_t field_count;
+} plcrash_writer_register_layout_t;
+
+#ifdef PLCRASH_ASYNC_THREAD_X86_SUPPORT
+/** CrashReport.Thread.RegisterState.X86_32 field numbers */
+static const uint32_t x86_32_register_fields[] = {
+    [PLCRASH_X86_EAX] = 1,
+    [PLCRASH_X86_EBX] = 2,
+    [PLCRASH_X86_ECX] = 3,
+    [PLCRASH_X86_EDX] = 4,
+    [PLCRASH_X86_EDI] = 5,
+    [PLCRASH_X86_ESI] = 6,
+    [PLCRASH_X86_EBP] = 7,
+    [PLCRASH_X86_ESP] = 8,
+    [PLCRASH_X86_EFLAGS] = 10,
+    [PLCRASH_X86_EIP] = 11,
+    [PLCRASH_X86_CS] = 12,
+    [PLCRASH_X86_DS] = 13,
+    [PLCRASH_X86_ES] = 14,
+    [PLCRASH_X86_FS] = 15,
+    [PLCRASH_X86_GS] = 16,
+    [PLCRASH_X86_TRAPNO] = 18,
+};
+
+/** CrashReport.Thread.RegisterState.X86_64 field numbers */
+static const uint32_t x86_64_register_fields[] = {
+    [PLCRASH_X86_64_RAX] = 1,
+    [PLCRASH_X86_64_RBX] = 2,
+    [PLCRASH_X86_64_RCX] = 3,
+    [PLCRASH_X86_64_RDX] = 4,
+    [PLCRASH_X86_64_RDI] = 5,
+    [PLCRASH_X86_64_RSI] = 6,
+    [PLCRASH_X86_64_RBP] = 7,
+    [PLCRASH_X86_64_RSP] = 8,
+    [PLCRASH_X86_64_R8] = 9,
+    [PLCRASH_X86_64_R9] = 10,
+    [PLCRASH_X86_64_R10] = 11,
+    [PLCRASH_X86_64_R11] = 12,
+    [PLCRASH_X86_64_R12] = 13,
+    [PLCRASH_X86_64_R13] = 14,
+    [PLCRASH_X86_64_R14] = 15,
+    [PLCRASH_X86_64_R15] = 16,
+    [PLCRASH_X86_64_RIP] = 17,
+    [PLCRASH_X86_64_RFLAGS] = 18,
+    [PLCRASH_X86_64_CS] = 19,
+    [PLCRASH_X86_64_FS] = 20,
+    [PLCRASH_X86_64_GS] = 21,
+};
+
+static const plcrash_writer_register_layout_t x86_32_register_layout = {
+    PLCRASH_PROTO_THREAD_REGISTER_STATE_X86_32_ID, PLPROTOBUF_C_TYPE_UINT32,
+    x86_32_register_fields, sizeof(x86_32_register_fields) / sizeof(x86_32_register_fields[0])
+};
+
+static const plcrash_writer_register_layout_t x86_64_register_layout = {
+    PLCRASH_PROTO_THREAD_REGISTER_STATE_X86_64_ID, PLPROTOBUF_C_TYPE_UINT64,
+    x86_64_register_fields, sizeof(x86_64_register_fields) / sizeof(x86_64_register_fields[0])
+};
+#endif /* PLCRASH_ASYNC_THREAD_X86_SUPPORT */
+
+#ifdef PLCRASH_ASYNC_THREAD_ARM_SUPPORT
+/** CrashReport.Thread.RegisterState.ARM field numbers */
+static const uint32_t arm_register_fields[] = {
+    [PLCRASH_ARM_R0] = 1,
+    [PLCRASH_ARM_R1] = 2,
+    [PLCRASH_ARM_R2] = 3,
+    [PLCRASH_ARM_R3] = 4,
+    [PLCRASH_ARM_R4] = 5,
+    [PLCRASH_ARM_R5] = 6,
+    [PLCRASH_ARM_R6] = 7,
+    [PLCRASH_ARM_R7] = 8,
+    [PLCRASH_ARM_R8] = 9,
+    [PLCRASH_ARM_R9] = 10,
+    [PLCRASH_ARM_R10] = 11,
+    [PLCRASH_ARM_R11] = 12,
+    [PLCRASH_ARM_R12] = 13,
+    [PLCRASH_ARM_SP] = 14,
+    [PLCRASH_ARM_LR] = 15,
+    [PLCRASH_ARM_PC] = 16,
+    [PLCRASH_ARM_CPSR] = 17,
+};
+
+/** CrashReport.Thread.RegisterState.ARM64 field numbers */
+static const uint32_t arm64_register_fields[] = {
+    [PLCRASH_ARM64_X0] = 1,
+    [PLCRASH_ARM64_X1] = 2,
+    [PLCRASH_ARM64_X2] = 3,
+    [PLCRASH_ARM64_X3] = 4,
+    [PLCRASH_ARM64_X4] = 5,
+    [PLCRASH_ARM64_X5] = 6,
+    [PLCRASH_ARM64_X6] = 7,
+    [PLCRASH_ARM64_X7] = 8,
+    [PLCRASH_ARM64_X8] = 9,
+    [PLCRASH_ARM64_X9] = 10,
+    [PLCRASH_ARM64_X10] = 11,
+    [PLCRASH_ARM64_X11] = 12,
+    [PLCRASH_ARM64_X12] = 13,
+    [PLCRASH_ARM64_X13] = 14,
+    [PLCRASH_ARM64_X14] = 15,
+    [PLCRASH_ARM64_X15] = 16,
+    [PLCRASH_ARM64_X16] = 17,
+    [PLCRASH_ARM64_X17] = 18,
+    [PLCRASH_ARM64_X18] = 19,
+    [PLCRASH_ARM64_X19] = 20,
+    [PLCRASH_ARM64_X20] = 21,
+    [PLCRASH_ARM64_X21] = 22,
+    [PLCRASH_ARM64_X22] = 23,
+    [PLCRASH_ARM64_X23] = 24,
+    [PLCRASH_ARM64_X24] = 25,
+    [PLCRASH_ARM64_X25] = 26,
+    [PLCRASH_ARM64_X26] = 27,
+    [PLCRASH_ARM64_X27] = 28,
+    [PLCRASH_ARM64_X28] = 29,
+    [PLCRASH_ARM64_FP] = 30,
+    [PLCRASH_ARM64_SP] = 31,
+    [PLCRASH_ARM64_LR] = 32,
+    [PLCRASH_ARM64_PC] = 33,
+    [PLCRASH_ARM64_CPSR] = 34,
+};
+
+static const plcrash_writer_register_layout_t arm_register_layout = {
+    PLCRASH_PROTO_THREAD_REGISTER_STATE_ARM_ID, PLPROTOBUF_C_TYPE_UINT32,
+    arm_register_fields, sizeof(arm_register_fields) / sizeof(arm_register_fields[0])
+};
+
+static const plcrash_writer_register_layout_t arm64_register_layout = {
+    PLCRASH_PROTO_THREAD_REGISTER_STATE_ARM64_ID, PLPROTOBUF_C_TYPE_UINT64,
+    arm64_register_fields, sizeof(arm64_register_fields) / sizeof(arm64_register_fields[0])
+};
+#endif /* PLCRASH_ASYNC_THREAD_ARM_SUPPORT */
+
+/**
+ * @internal
+ *
+ * Return the typed register state layout for @a thread_state, or NULL if the thread state's architecture has no
+ * typed register state message.
+ *
+ * @param thread_state The thread state to be written.
+ */
+static const plcrash_writer_register_layout_t *plcrash_writer_register_layout (const plcrash_async_thread_state_t *thread_state) {
+#if defined(PLCRASH_ASYNC_THREAD_X86_SUPPORT)
+    if (thread_state->x86_state.thread.tsh.flavor == x86_THREAD_STATE32) {
+        return &x86_32_register_layout;
+    } else {
+        return &x86_64_register_layout;
+    }
+#elif defined(PLCRASH_ASYNC_THREAD_ARM_SUPPORT)
+    if (thread_state->arm_state.thread.ash.flavor == ARM_THREAD_STATE32) {
+        return &arm_register_layout;
+    } else {
+        return &arm64_register_layout;
+    }
+#else
+    return NULL;
+#endif
+}
+
+/**
+ * @internal
+ *
+ * Write the register fields of a typed register state message. Registers that are not available from @a cursor are
+ * omitted.
+ *
+ * @param file Output file
+ * @param layout The register state layout.
+ * @param cursor The cursor from which to acquire frame registers.
+ */
+static size_t plcrash_writer_write_register_state_fields (plcrash_async_file_t *file, const plcrash_writer_register_layout_t *layout, plframe_cursor_t *cursor) {
+    uint32_t regCount = plframe_cursor_get_regcount(cursor);
+    size_t rv = 0;
+
+    for (uint32_t i = 0; i < regCount && i < layout->field_count; i++) {
+        plcrash_greg_t regVal;
+
+        /* Skip unmapped and unavailable registers */
+        if (layout->field_ids[i] == 0)
+            continue;
+
+        if (plframe_cursor_get_reg(cursor, i, &regVal) != PLFRAME_ESUCCESS)
+            continue;
+
+        if (layout->field_type == PLPROTOBUF_C_TYPE_UINT32) {
+            uint32_t uint32val = (uint32_t) regVal;
+            rv += plcrash_writer_pack(file, layout->field_ids[i], PLPROTOBUF_C_TYPE_UINT32, &uint32val);
+        } else {
+            uint64_t uint64val = regVal;
+            rv += plcrash_writer_pack(file, layout->field_ids[i], PLPROTOBUF_C_TYPE_UINT64, &uint64val);
+        }
+    }
+
+    return rv;
+}
+
+/**
+ * @internal
+ *
+ * Write a typed register state message.
+ *
+ * @param file Output file
+ * @param layout The register state layout.
+ * @param cursor The cursor from which to acquire frame registers.
+ */
+static size_t plcrash_writer_write_register_state (plcrash_async_file_t *file, const plcrash_writer_register_layout_t *layout, plframe_cursor_t *cursor) {
+    uint32_t msgsize;
+    size_t rv = 0;
+
+    /* Get the register message size */
+    msgsize = plcrash_writer_write_register_state_fields(NULL, layout, cursor);
+
+    /* Write the header and message */
+    rv += plcrash_writer_pack(file, layout->message_id, PLPROTOBUF_C_TYPE_MESSAGE, &msgsize);
+    rv += plcrash_writer_write_register_state_fields(file, layout, cursor);
+
+    return rv;
+}
+
 /**
  * @internal
  *
  * Write all thread backtrace register messages
  *
  * @param file Output file
+ * @param writer Writer containing the register encoding to be used.
  * @param task The task from which @a uap was derived. All memory accesses will be mapped from this task.
  * @param cursor The cursor from which to acquire frame registers.
  */
-static size_t plcrash_writer_write_thread_registers (plcrash_async_file_t *file, task_t task, plframe_cursor_t *cursor) {
+static size_t plcrash_writer_write_thread_registers (plcrash_async_file_t *file, plcrash_log_writer_t *writer, task_t task, plframe_cursor_t *cursor) {
+    const plcrash_writer_register_layout_t *layout = NULL;
     plframe_error_t frame_err;
     uint32_t regCount = plframe_cursor_get_regcount(cursor);
     size_t rv = 0;
-    
+
+    /* Write out the typed register state, if enabled */
+    if (writer->register_encoding == PLCRASH_LOG_REGISTER_ENCODING_TYPED)
+        layout = plcrash_writer_register_layout(&cursor->frame->thread_state);
+
+    if (layout != NULL) {
+        uint32_t msgsize = plcrash_writer_write_register_state(NULL, layout, cursor);
+        rv += plcrash_writer_pack(file, PLCRASH_PROTO_THREAD_REGISTER_STATE_ID, PLPROTOBUF_C_TYPE_MESSAGE, &msgsize);
+        rv += plcrash_writer_write_register_state(file, layout, cursor);
+    }
+
     /* Write out register messages */
     for (int i = 0; i < regCount; i++) {
         plcrash_greg_t regVal;
@@ -830,6 +1205,11 @@ static size_t plcrash_writer_write_thread_registers (plcrash_async_file_t *file,
             regVal = 0;
         }
 
+        /* If written as part of the typed register state, only registers with additional content information
+         * require a named register message */
+        if (layout != NULL && (size_t) i < layout->field_count && layout->field_ids[i] != 0 && !plregister_is_notable_address(regVal))
+            continue;
+
         /* Fetch the register name */
         regname = plframe_cursor_get_regname(cursor, i);
 
@@ -844,20 +1224,61 @@ static size_t plcrash_writer_write_thread_registers (plcrash_async_file_t *file,
     return rv;
 }
 
+/**
+ * @internal
+ *
+ * Write a string value, either in full as the @a string_id field, or if @a string_table is non-NULL and the string
+ * could be interned, as a string table index in the @a index_id field. The string table lookup is repeated for
+ * the sizing and writing passes, and will return the same result for both.
+ *
+ * @param file Output file
+ * @param string_table The report string table, or NULL.
+ * @param string_id The field ID used to write @a string in full.
+ * @param index_id The field ID used to write the string table index of @a string.
+ * @param string The string value.
+ */
+static size_t plcrash_writer_write_string_ref (plcrash_async_file_t *file, plcrash_async_string_table_t *string_table, uint32_t string_id, uint32_t index_id, const char *string) {
+    uint32_t index;
+
+    if (string_table != NULL && plcrash_async_string_table_intern(string_table, string, &index) == PLCRASH_ESUCCESS)
+        return plcrash_writer_pack(file, index_id, PLPROTOBUF_C_TYPE_UINT32, &index);
+
+    return plcrash_writer_pack(file, string_id, PLPROTOBUF_C_TYPE_STRING, string);
+}
+
+/**
+ * @internal
+ *
+ * Write the string table message
+ *
+ * @param file Output file
+ * @param string_table The report string table.
+ */
+static size_t plcrash_writer_write_string_table (plcrash_async_file_t *file, plcrash_async_string_table_t *string_table) {
+    uint32_t count = plcrash_async_string_table_count(string_table);
+    size_t rv = 0;
+
+    for (uint32_t i = 0; i < count; i++)
+        rv += plcrash_writer_pack(file, PLCRASH_PROTO_STRING_TABLE_ENTRIES_ID, PLPROTOBUF_C_TYPE_STRING, plcrash_async_string_table_string(string_table, i));
+
+    return rv;
+}
+
 /**
  * @internal
  *
  * Write a symbol
  *
  * @param file Output file
+ * @param string_table The report string table, or NULL.
  * @param name The symbol name
  * @param start_address The symbol start address
  */
-static size_t plcrash_writer_write_symbol (plcrash_async_file_t *file, const char *name, uint64_t start_address) {
+static size_t plcrash_writer_write_symbol (plcrash_async_file_t *file, plcrash_async_string_table_t *string_table, const char *name, uint64_t start_address) {
     size_t rv = 0;
     
     /* name */
-    rv += plcrash_writer_pack(file, PLCRASH_PROTO_SYMBOL_NAME, PLPROTOBUF_C_TYPE_STRING, name);
+    rv += plcrash_writer_write_string_ref(file, string_table, PLCRASH_PROTO_SYMBOL_NAME, PLCRASH_PROTO_SYMBOL_NAME_INDEX, name);
     
     /* start_address */
     rv += plcrash_writer_pack(file, PLCRASH_PROTO_SYMBOL_START_ADDRESS, PLPROTOBUF_C_TYPE_UINT64, &start_address);
@@ -873,6 +1294,9 @@ struct pl_symbol_cb_ctx {
     /** File to use for writing out a symbol entry. May be NULL. */
     plcrash_async_file_t *file;
 
+    /** The report string table. May be NULL. */
+    plcrash_async_string_table_t *string_table;
+
     /** Size of the symbol entry, to be written by the callback function upon writing an entry. */
     uint32_t msgsize;
 };
@@ -885,7 +1309,7 @@ struct pl_symbol_cb_ctx {
  */
 static void plcrash_writer_write_thread_frame_symbol_cb (pl_vm_address_t address, const char *name, void *ctx) {
     struct pl_symbol_cb_ctx *cb_ctx = ctx;
-    cb_ctx->msgsize = plcrash_writer_write_symbol(cb_ctx->file, name, address);
+    cb_ctx->msgsize = plcrash_writer_write_symbol(cb_ctx->file, cb_ctx->string_table, name, address);
 }
 
 /**
@@ -895,11 +1319,15 @@ static void plcrash_writer_write_thread_frame_symbol_cb (pl_vm_address_t address
  *
  * @param file Output file
  * @param pcval The frame PC value.
+ * @param scanned If true, mark the frame as having been recovered by stack scanning.
  */
-static size_t plcrash_writer_write_thread_frame (plcrash_async_file_t *file, plcrash_log_writer_t *writer, uint64_t pcval, plcrash_async_image_list_t *image_list, plcrash_async_symbol_cache_t *findContext) {
+static size_t plcrash_writer_write_thread_frame (plcrash_async_file_t *file, plcrash_log_writer_t *writer, uint64_t pcval, bool scanned, plcrash_async_image_list_t *image_list, plcrash_async_symbol_cache_t *findContext) {
     size_t rv = 0;
 
     rv += plcrash_writer_pack(file, PLCRASH_PROTO_THREAD_FRAME_PC_ID, PLPROTOBUF_C_TYPE_UINT64, &pcval);
+
+    if (scanned)
+        rv += plcrash_writer_pack(file, PLCRASH_PROTO_THREAD_FRAME_SCANNED_ID, PLPROTOBUF_C_TYPE_BOOL, &scanned);
     
     plcrash_async_image_list_set_reading(image_list, true);
     plcrash_async_image_t *image = plcrash_async_image_containing_address(image_list, (pl_vm_address_t) pcval);
@@ -911,6 +1339,7 @@ static size_t plcrash_writer_write_thread_frame (plcrash_async_file_t *file, plc
         /* Get the symbol message size. If the symbol can not be found, our callback will not be called. If the symbol is found,
          * our callback is called and PLCRASH_ESUCCESS is returned. */
         ctx.file = NULL;
+        ctx.string_table = writer->string_table;
         ctx.msgsize = 0x0;
         ret = plcrash_async_find_symbol(&image->macho_image, writer->symbol_strategy, findContext, (pl_vm_address_t) pcval, plcrash_writer_write_thread_frame_symbol_cb, &ctx);
         if (ret == PLCRASH_ESUCCESS) {
@@ -1005,7 +1434,7 @@ static size_t plcrash_writer_write_thread (plcrash_async_file_t *file,
             
             /* On the first frame, dump registers for the crashed thread */
             if (frame_count == 0 && crashed) {
-                rv += plcrash_writer_write_thread_registers(file, task, &cursor);
+                rv += plcrash_writer_write_thread_registers(file, writer, task, &cursor);
             }
 
             /* Fetch the PC value */
@@ -1016,10 +1445,11 @@ static size_t plcrash_writer_write_thread (plcrash_async_file_t *file,
             }
 
             /* Determine the size */
-            frame_size = plcrash_writer_write_thread_frame(NULL, writer, pc, image_list, findContext);
+            bool scanned = plframe_cursor_is_scanned(&cursor);
+            frame_size = plcrash_writer_write_thread_frame(NULL, writer, pc, scanned, image_list, findContext);
             
             rv += plcrash_writer_pack(file, PLCRASH_PROTO_THREAD_FRAMES_ID, PLPROTOBUF_C_TYPE_MESSAGE, &frame_size);
-            rv += plcrash_writer_write_thread_frame(file, writer, pc, image_list, findContext);
+            rv += plcrash_writer_write_thread_frame(file, writer, pc, scanned, image_list, findContext);
             frame_count++;
         }
 
@@ -1036,15 +1466,145 @@ static size_t plcrash_writer_write_thread (plcrash_async_file_t *file,
 }
 
 
+/** 64-bit FNV-1a offset basis */
+#define PLCRASH_WRITER_FNV1A_64_BASIS 0xcbf29ce484222325ULL
+
+/** 64-bit FNV-1a prime */
+#define PLCRASH_WRITER_FNV1A_64_PRIME 0x100000001b3ULL
+
+/**
+ * @internal
+ *
+ * Append @a len bytes of @a data to the 64-bit FNV-1a @a hash, returning the updated hash value.
+ */
+static uint64_t plcrash_writer_fnv1a_64 (uint64_t hash, const void *data, size_t len) {
+    const uint8_t *p = data;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= p[i];
+        hash *= PLCRASH_WRITER_FNV1A_64_PRIME;
+    }
+    return hash;
+}
+
+/**
+ * @internal
+ *
+ * Append @a value to the 64-bit FNV-1a @a hash in little-endian byte order, returning the updated hash value.
+ */
+static uint64_t plcrash_writer_fnv1a_64_uint64 (uint64_t hash, uint64_t value) {
+    for (size_t i = 0; i < sizeof(value); i++) {
+        hash ^= (uint8_t) (value >> (i * 8));
+        hash *= PLCRASH_WRITER_FNV1A_64_PRIME;
+    }
+    return hash;
+}
+
+/**
+ * @internal
+ *
+ * Compute the report fingerprint: a 64-bit FNV-1a hash of the image UUID and image-relative PC of the top
+ * @a writer->report_info.fingerprint_frame_count frames of @a thread, followed by the signal number and code.
+ * Frames that fall outside of a known image are hashed using an all-zero UUID and their absolute PC. The walk
+ * stops at the first heuristically recovered frame, as scanned frames may vary between otherwise identical crashes.
+ *
+ * @param writer The writer context.
+ * @param task The task in which @a thread is executing.
+ * @param thread The crashed thread.
+ * @param thread_ctx The thread state to walk, or NULL to fetch the state of @a thread. Must be non-NULL if @a thread
+ * is the current thread.
+ * @param image_list The current list of loaded binary images.
+ * @param siginfo Signal information.
+ * @param fingerprint On success, will be set to the computed fingerprint.
+ *
+ * @return Returns true if a fingerprint was computed, or false if fingerprints are disabled or no frames could
+ * be walked.
+ */
+static bool plcrash_writer_fingerprint (plcrash_log_writer_t *writer,
+                                        task_t task,
+                                        thread_t thread,
+                                        plcrash_async_thread_state_t *thread_ctx,
+                                        plcrash_async_image_list_t *image_list,
+                                        plcrash_log_signal_info_t *siginfo,
+                                        uint64_t *fingerprint)
+{
+    static const uint8_t no_uuid[16] = { 0 };
+    plcrash_async_thread_state_t cursor_thr_state;
+    plframe_cursor_t cursor;
+    plframe_error_t ferr;
+
+    if (writer->report_info.fingerprint_frame_count == 0)
+        return false;
+
+    /* Initialize the cursor */
+    if (thread_ctx != NULL) {
+        cursor_thr_state = *thread_ctx;
+    } else {
+        plcrash_async_thread_state_mach_thread_init(&cursor_thr_state, thread);
+    }
+
+    ferr = plframe_cursor_init(&cursor, task, &cursor_thr_state, image_list);
+    if (ferr != PLFRAME_ESUCCESS) {
+        PLCF_DEBUG("An error occured initializing the fingerprint frame cursor: %s", plframe_strerror(ferr));
+        return false;
+    }
+
+    /* Hash the top frames */
+    uint64_t hash = PLCRASH_WRITER_FNV1A_64_BASIS;
+    uint32_t frame_count = 0;
+    while (frame_count < writer->report_info.fingerprint_frame_count && (ferr = plframe_cursor_next(&cursor)) == PLFRAME_ESUCCESS) {
+        plcrash_greg_t pc = 0;
+
+        if (plframe_cursor_is_scanned(&cursor))
+            break;
+
+        if ((ferr = plframe_cursor_get_reg(&cursor, PLCRASH_REG_IP, &pc)) != PLFRAME_ESUCCESS) {
+            PLCF_DEBUG("Could not retrieve frame PC register: %s", plframe_strerror(ferr));
+            break;
+        }
+
+        const uint8_t *uuid = no_uuid;
+        uint64_t offset = pc;
+
+        plcrash_async_image_list_set_reading(image_list, true);
+        plcrash_async_image_t *image = plcrash_async_image_containing_address(image_list, (pl_vm_address_t) pc);
+        if (image != NULL) {
+            struct uuid_command *uuid_cmd = plcrash_async_macho_find_command(&image->macho_image, LC_UUID);
+            if (uuid_cmd != NULL)
+                uuid = uuid_cmd->uuid;
+
+            offset = pc - image->macho_image.header_addr;
+        }
+
+        hash = plcrash_writer_fnv1a_64(hash, uuid, sizeof(no_uuid));
+        plcrash_async_image_list_set_reading(image_list, false);
+
+        hash = plcrash_writer_fnv1a_64_uint64(hash, offset);
+        frame_count++;
+    }
+
+    plframe_cursor_free(&cursor);
+
+    if (frame_count == 0)
+        return false;
+
+    /* Append the signal number and code */
+    hash = plcrash_writer_fnv1a_64_uint64(hash, (uint64_t) (int64_t) siginfo->bsd_info->signo);
+    hash = plcrash_writer_fnv1a_64_uint64(hash, (uint64_t) (int64_t) siginfo->bsd_info->code);
+
+    *fingerprint = hash;
+    return true;
+}
+
 /**
  * @internal
  *
  * Write a binary image frame
  *
  * @param file Output file
+ * @param string_table The report string table, or NULL.
  * @param image Mach-O image.
  */
-static size_t plcrash_writer_write_binary_image (plcrash_async_file_t *file, plcrash_async_macho_t *image) {
+static size_t plcrash_writer_write_binary_image (plcrash_async_file_t *file, plcrash_async_string_table_t *string_table, plcrash_async_macho_t *image) {
     size_t rv = 0;
 
     /* Fetch the CPU types. Note that the wire format represents these as 64-bit unsigned integers.
@@ -1067,7 +1627,7 @@ static size_t plcrash_writer_write_binary_image (plcrash_async_file_t *file, plc
     }
 
     /* Name */
-    rv += plcrash_writer_pack(file, PLCRASH_PROTO_BINARY_IMAGE_NAME_ID, PLPROTOBUF_C_TYPE_STRING, image->name);
+    rv += plcrash_writer_write_string_ref(file, string_table, PLCRASH_PROTO_BINARY_IMAGE_NAME_ID, PLCRASH_PROTO_BINARY_IMAGE_NAME_INDEX_ID, image->name);
 
     /* UUID */
     struct uuid_command *uuid;
@@ -1114,10 +1674,10 @@ static size_t plcrash_writer_write_exception (plcrash_async_file_t *file, plcras
         uint64_t pc = (uint64_t)(uintptr_t) writer->uncaught_exception.callstack[i];
         
         /* Determine the size */
-        uint32_t frame_size = plcrash_writer_write_thread_frame(NULL, writer, pc, image_list, findContext);
+        uint32_t frame_size = plcrash_writer_write_thread_frame(NULL, writer, pc, false, image_list, findContext);
         
         rv += plcrash_writer_pack(file, PLCRASH_PROTO_EXCEPTION_FRAMES_ID, PLPROTOBUF_C_TYPE_MESSAGE, &frame_size);
-        rv += plcrash_writer_write_thread_frame(file, writer, pc, image_list, findContext);
+        rv += plcrash_writer_write_thread_frame(file, writer, pc, false, image_list, findContext);
         frame_count++;
     }
 
@@ -1211,10 +1771,16 @@ static size_t plcrash_writer_write_signal (plcrash_async_file_t *file, plcrash_l
  *
  * @param file Output file
  * @param writer Writer containing report data
+ * @param fingerprint The report fingerprint, or NULL if no fingerprint should be written.
  */
-static size_t plcrash_writer_write_report_info (plcrash_async_file_t *file, plcrash_log_writer_t *writer) {
+static size_t plcrash_writer_write_report_info (plcrash_async_file_t *file, plcrash_log_writer_t *writer, const uint64_t *fingerprint) {
     size_t rv = 0;
 
+    /* The fingerprint must be written first, at a fixed offset from the start of the report; see
+     * PLCRASH_REPORT_FILE_FINGERPRINT_OFFSET. */
+    if (fingerprint != NULL)
+        rv += plcrash_writer_pack(file, PLCRASH_PROTO_REPORT_INFO_FINGERPRINT_ID, PLPROTOBUF_C_TYPE_FIXED64, fingerprint);
+
     /* Note crashed status */
     rv += plcrash_writer_pack(file, PLCRASH_PROTO_REPORT_INFO_USER_REQUESTED_ID, PLPROTOBUF_C_TYPE_BOOL, &writer->report_info.user_requested);
     
@@ -1225,6 +1791,19 @@ static size_t plcrash_writer_write_report_info (plcrash_async_file_t *file, plcr
     uuid_bin.data = &writer->report_info.uuid_bytes;
     rv += plcrash_writer_pack(file, PLCRASH_PROTO_REPORT_INFO_UUID_ID, PLPROTOBUF_C_TYPE_BYTES, &uuid_bin);
 
+    /* Report type */
+    uint32_t type = writer->report_info.type;
+    if (type == PLCRASH_LOG_REPORT_TYPE_UNKNOWN) {
+        if (writer->report_info.user_requested) {
+            type = PLCRASH_LOG_REPORT_TYPE_LIVE;
+        } else if (writer->uncaught_exception.has_exception) {
+            type = PLCRASH_LOG_REPORT_TYPE_LANGUAGE_EXCEPTION;
+        } else {
+            type = PLCRASH_LOG_REPORT_TYPE_CRASH;
+        }
+    }
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_REPORT_INFO_TYPE_ID, PLPROTOBUF_C_TYPE_ENUM, &type);
+
     return rv;
 }
 
@@ -1275,6 +1854,21 @@ plcrash_error_t plcrash_log_writer_write (plcrash_log_writer_t *writer,
     if (err != PLCRASH_ESUCCESS)
         return err;
 
+    /* Serve target memory reads from the page cache, if any, while the report is written. The other threads have been
+     * suspended, and the cached pages will remain valid for the duration of report generation. */
+    bool page_cache_attached = false;
+    if (writer->page_cache != NULL)
+        page_cache_attached = plcrash_async_page_cache_attach(writer->page_cache);
+
+    /* Likewise, share segment and section mappings for the duration of report generation. */
+    bool mobject_pool_attached = false;
+    if (writer->mobject_pool != NULL)
+        mobject_pool_attached = plcrash_async_mobject_pool_attach(writer->mobject_pool);
+
+    /* Discard any strings interned by a previous report */
+    if (writer->string_table != NULL)
+        plcrash_async_string_table_reset(writer->string_table);
+
     /* Write the file header */
     {
         uint8_t version = PLCRASH_REPORT_FILE_VERSION;
@@ -1287,14 +1881,23 @@ plcrash_error_t plcrash_log_writer_write (plcrash_log_writer_t *writer,
     
     /* Report Info */
     {
+        uint64_t fingerprint;
+        const uint64_t *fingerprint_ptr = NULL;
         uint32_t size;
+
+        /* Compute the fingerprint from the crashed thread */
+        plcrash_async_thread_state_t *crashed_ctx = (crashed_thread == pl_mach_thread_self()) ? current_state : NULL;
+        if (plcrash_writer_fingerprint(writer, mach_task_self(), crashed_thread, crashed_ctx, image_list, siginfo, &fingerprint))
+            fingerprint_ptr = &fingerprint;
         
-        /* Determine size */
-        size = plcrash_writer_write_report_info(NULL, writer);
+        /* Determine size. The message must fit within a single-byte length prefix for the fingerprint to be found at a
+         * fixed offset. */
+        size = plcrash_writer_write_report_info(NULL, writer, fingerprint_ptr);
+        PLCF_ASSERT(size < 128);
         
         /* Write message */
         plcrash_writer_pack(file, PLCRASH_PROTO_REPORT_INFO_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
-        plcrash_writer_write_report_info(file, writer);
+        plcrash_writer_write_report_info(file, writer, fingerprint_ptr);
     }
 
     /* System Info */
@@ -1398,9 +2001,9 @@ plcrash_error_t plcrash_log_writer_write (plcrash_log_writer_t *writer,
         uint32_t size;
 
         /* Calculate the message size */
-        size = plcrash_writer_write_binary_image(NULL, &image->macho_image);
+        size = plcrash_writer_write_binary_image(NULL, writer->string_table, &image->macho_image);
         plcrash_writer_pack(file, PLCRASH_PROTO_BINARY_IMAGES_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
-        plcrash_writer_write_binary_image(file, &image->macho_image);
+        plcrash_writer_write_binary_image(file, writer->string_table, &image->macho_image);
     }
 
     plcrash_async_image_list_set_reading(image_list, false);
@@ -1424,8 +2027,25 @@ plcrash_error_t plcrash_log_writer_write (plcrash_log_writer_t *writer,
         plcrash_writer_pack(file, PLCRASH_PROTO_SIGNAL_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
         plcrash_writer_write_signal(file, siginfo);
     }
+
+    /* String table. This must be written last, once all string references have been written. */
+    if (writer->string_table != NULL && plcrash_async_string_table_count(writer->string_table) > 0) {
+        uint32_t size;
+
+        /* Calculate the message size */
+        size = plcrash_writer_write_string_table(NULL, writer->string_table);
+        plcrash_writer_pack(file, PLCRASH_PROTO_STRING_TABLE_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
+        plcrash_writer_write_string_table(file, writer->string_table);
+    }
     
     plcrash_async_symbol_cache_free(&findContext);
+
+    /* Release all pooled mappings */
+    if (mobject_pool_attached)
+        plcrash_async_mobject_pool_detach(writer->mobject_pool);
+
+    if (page_cache_attached)
+        plcrash_async_page_cache_detach(writer->page_cache);
     
     /* Clean up the thread array */
     for (mach_msg_type_number_t i = 0; i < thread_count; i++) {
@@ -43,12 +43,16 @@
 
 #import <mach-o/loader.h>
 #import <mach-o/dyld.h>
+#import <mach/mach_time.h>
 
 #import "crash_report.pb-c.h"
 #import "PLCrashTestThread.h"
 
 #import "PLCrashSysctl.h"
 
+/* Number of reports written and decoded per register encoding by the register encoding benchmark */
+#define REGISTER_ENCODING_BENCHMARK_ITERATIONS 50
+
 @interface PLCrashLogWriterTests : SenTestCase {
 @private
     /* Path to crash log */
@@ -392,6 +396,8 @@
         return;
 
     STAssertFalse(crashReport->report_info->user_requested, @"Report not correctly marked as non-user-requested");
+    STAssertTrue(crashReport->report_info->has_type, @"Report missing a type value");
+    STAssertEquals(PLCRASH__CRASH_REPORT__REPORT_INFO__REPORT_TYPE__LANGUAGE_EXCEPTION, crashReport->report_info->type, @"Report type not inferred from the uncaught exception");
     STAssertTrue(crashReport->report_info->has_uuid, @"Report missing a UUID value");
     STAssertEquals((size_t)16, crashReport->report_info->uuid.len, @"UUID is not expected 16 bytes");
     {
@@ -426,16 +432,16 @@
     /* Validate the 'crashed' flag is on a thread with the expected PC. */
     uint64_t expectedPC;
 #if __x86_64__
-    expectedPC = cursor.frame.thread_state.x86_state.thread.uts.ts64.__rip;
+    expectedPC = cursor.frame->thread_state.x86_state.thread.uts.ts64.__rip;
 #elif __i386__
-    expectedPC = cursor.frame.thread_state.x86_state.thread.uts.ts32.__eip;
+    expectedPC = cursor.frame->thread_state.x86_state.thread.uts.ts32.__eip;
 #elif __arm__
-    expectedPC = cursor.frame.thread_state.arm_state.thread.ts_32.__pc;
+    expectedPC = cursor.frame->thread_state.arm_state.thread.ts_32.__pc;
 #elif __arm64__
 #if __DARWIN_OPAQUE_ARM_THREAD_STATE64
-    expectedPC = cursor.frame.thread_state.arm_state.thread.ts_64.__opaque_pc;
+    expectedPC = cursor.frame->thread_state.arm_state.thread.ts_64.__opaque_pc;
 #else
-    expectedPC = cursor.frame.thread_state.arm_state.thread.ts_64.__pc;
+    expectedPC = cursor.frame->thread_state.arm_state.thread.ts_64.__pc;
 #endif
 #else
 #error Unsupported Platform
@@ -464,4 +470,343 @@
     protobuf_c_message_free_unpacked((ProtobufCMessage *) crashReport, NULL);
 }
 
+
+/**
+ * Write a crash report for @a thread to memory, using the already captured @a thread_state and the given
+ * register @a encoding. If non-NULL, the time spent writing the report will be returned via @a elapsed, in
+ * mach_absolute_time() units.
+ */
+- (NSData *) writeReportForThread: (thread_t) thread
+                      threadState: (plcrash_async_thread_state_t *) thread_state
+                        imageList: (plcrash_async_image_list_t *) image_list
+                 registerEncoding: (plcrash_log_register_encoding_t) encoding
+                          elapsed: (uint64_t *) elapsed
+{
+    return [self writeReportForThread: thread threadState: thread_state imageList: image_list registerEncoding: encoding
+                symbolicationStrategy: PLCRASH_ASYNC_SYMBOL_STRATEGY_NONE stringTable: NULL fingerprintFrameCount: 0 elapsed: elapsed];
+}
+
+/**
+ * Write a crash report for @a thread to memory, as per writeReportForThread:threadState:imageList:registerEncoding:elapsed:,
+ * using the given symbolication @a strategy. If non-NULL, symbol and image names will be written to @a string_table. If
+ * @a fingerprint_frames is non-zero, a fingerprint of that many frames will be written.
+ */
+- (NSData *) writeReportForThread: (thread_t) thread
+                      threadState: (plcrash_async_thread_state_t *) thread_state
+                        imageList: (plcrash_async_image_list_t *) image_list
+                 registerEncoding: (plcrash_log_register_encoding_t) encoding
+            symbolicationStrategy: (plcrash_async_symbol_strategy_t) strategy
+                      stringTable: (plcrash_async_string_table_t *) string_table
+            fingerprintFrameCount: (uint32_t) fingerprint_frames
+                          elapsed: (uint64_t *) elapsed
+{
+    plcrash_log_writer_t writer;
+    plcrash_async_file_t file;
+
+    /* Initialze faux crash data */
+    plcrash_log_signal_info_t info;
+    plcrash_log_bsd_signal_info_t bsd_info;
+    bsd_info.address = (void *) 0x42;
+    bsd_info.code = SEGV_MAPERR;
+    bsd_info.signo = SIGSEGV;
+    info.bsd_info = &bsd_info;
+    info.mach_info = NULL;
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_file_init_growable(&file, 64 * 1024, 0), @"Failed to initialize the report buffer");
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_log_writer_init(&writer, @"test.id", @"1.0", @"2.0", strategy, false), @"Initialization failed");
+    plcrash_log_writer_set_register_encoding(&writer, encoding);
+    if (string_table != NULL)
+        plcrash_log_writer_set_string_table(&writer, string_table);
+    plcrash_log_writer_set_fingerprint_frame_count(&writer, fingerprint_frames);
+
+    uint64_t start = mach_absolute_time();
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_log_writer_write(&writer, thread, image_list, &file, &info, thread_state), @"Crash log failed");
+    plcrash_async_file_flush(&file);
+    if (elapsed != NULL)
+        *elapsed = mach_absolute_time() - start;
+
+    plcrash_log_writer_close(&writer);
+    plcrash_log_writer_free(&writer);
+
+    size_t length;
+    size_t allocation_size;
+    void *bytes = plcrash_async_file_buffer_detach(&file, &length, &allocation_size);
+    plcrash_async_file_close(&file);
+
+    NSData *data = [NSData dataWithBytes: bytes length: length];
+    vm_deallocate(mach_task_self(), (vm_address_t) bytes, allocation_size);
+
+    return data;
+}
+
+/**
+ * Return the crashed thread of the protobuf-encoded report in @a data, or NULL if not found. The caller is responsible
+ * for freeing @a crashReport.
+ */
+- (Plcrash__CrashReport__Thread *) crashedThreadInReport: (NSData *) data crashReport: (Plcrash__CrashReport **) crashReport {
+    const struct PLCrashReportFileHeader *header = [data bytes];
+    *crashReport = plcrash__crash_report__unpack(NULL, [data length] - sizeof(struct PLCrashReportFileHeader), header->data);
+    STAssertNotNULL(*crashReport, @"Could not decode crash report");
+    if (*crashReport == NULL)
+        return NULL;
+
+    for (size_t i = 0; i < (*crashReport)->n_threads; i++) {
+        if ((*crashReport)->threads[i]->crashed)
+            return (*crashReport)->threads[i];
+    }
+
+    return NULL;
+}
+
+/**
+ * Verify that the typed register encoding is written and decoded to the same register values as the named encoding.
+ */
+- (void) testWriteTypedRegisters {
+    plcrash_async_image_list_t image_list;
+    plcrash_async_thread_state_t thread_state;
+    thread_t thread = pthread_mach_thread_np(_thr_args.thread);
+    NSError *error;
+
+    plcrash_nasync_image_list_init(&image_list, mach_task_self());
+    for (uint32_t i = 0; i < _dyld_image_count(); i++)
+        plcrash_nasync_image_list_append(&image_list, _dyld_get_image_header(i), _dyld_get_image_name(i));
+    plcrash_async_thread_state_mach_thread_init(&thread_state, thread);
+
+    NSData *named = [self writeReportForThread: thread threadState: &thread_state imageList: &image_list registerEncoding: PLCRASH_LOG_REGISTER_ENCODING_NAMED elapsed: NULL];
+    NSData *typed = [self writeReportForThread: thread threadState: &thread_state imageList: &image_list registerEncoding: PLCRASH_LOG_REGISTER_ENCODING_TYPED elapsed: NULL];
+    plcrash_nasync_image_list_free(&image_list);
+
+    STAssertTrue([typed length] < [named length], @"Typed register encoding did not reduce the report size");
+
+    /* Check the wire representation */
+    Plcrash__CrashReport *crashReport;
+    Plcrash__CrashReport__Thread *thr = [self crashedThreadInReport: typed crashReport: &crashReport];
+    STAssertNotNULL(thr, @"No crashed thread");
+    if (thr != NULL) {
+        STAssertNotNULL(thr->register_state, @"Missing typed register state");
+        if (thr->register_state != NULL) {
+            Plcrash__CrashReport__Thread__RegisterState *state = thr->register_state;
+#if __x86_64__
+            STAssertNotNULL(state->x86_64, @"Missing x86-64 register state");
+#elif __i386__
+            STAssertNotNULL(state->x86_32, @"Missing x86-32 register state");
+#elif __arm64__
+            STAssertNotNULL(state->arm64, @"Missing ARM64 register state");
+#elif __arm__
+            STAssertNotNULL(state->arm, @"Missing ARM register state");
+#endif
+        }
+
+        /* Only registers with additional content information should be written by name */
+        for (size_t i = 0; i < thr->n_registers; i++)
+            STAssertNotNULL(thr->registers[i]->type, @"Register %s written by name without type information", thr->registers[i]->name);
+    }
+    if (crashReport != NULL)
+        protobuf_c_message_free_unpacked((ProtobufCMessage *) crashReport, NULL);
+
+    /* Both encodings must decode to the same register values */
+    PLCrashReport *namedReport = [[[PLCrashReport alloc] initWithData: named error: &error] autorelease];
+    STAssertNotNil(namedReport, @"Could not decode report: %@", error);
+    PLCrashReport *typedReport = [[[PLCrashReport alloc] initWithData: typed error: &error] autorelease];
+    STAssertNotNil(typedReport, @"Could not decode report: %@", error);
+
+    NSMutableDictionary *namedRegisters = [NSMutableDictionary dictionary];
+    NSMutableDictionary *typedRegisters = [NSMutableDictionary dictionary];
+    for (PLCrashReportThreadInfo *threadInfo in namedReport.threads) {
+        for (PLCrashReportRegisterInfo *reg in threadInfo.registers)
+            [namedRegisters setObject: [NSNumber numberWithUnsignedLongLong: reg.registerValue] forKey: reg.registerName];
+    }
+    for (PLCrashReportThreadInfo *threadInfo in typedReport.threads) {
+        for (PLCrashReportRegisterInfo *reg in threadInfo.registers)
+            [typedRegisters setObject: [NSNumber numberWithUnsignedLongLong: reg.registerValue] forKey: reg.registerName];
+    }
+
+    STAssertNotEquals((NSUInteger) 0, [namedRegisters count], @"No registers decoded");
+    STAssertEqualObjects(namedRegisters, typedRegisters, @"Typed registers do not match the named registers");
+}
+
+/**
+ * Verify that symbol and image names written to the report string table are resolved to the same values as
+ * names written inline.
+ */
+- (void) testWriteStringTable {
+    plcrash_async_image_list_t image_list;
+    plcrash_async_thread_state_t thread_state;
+    plcrash_async_string_table_t string_table;
+    thread_t thread = pthread_mach_thread_np(_thr_args.thread);
+    NSError *error;
+
+    plcrash_nasync_image_list_init(&image_list, mach_task_self());
+    for (uint32_t i = 0; i < _dyld_image_count(); i++)
+        plcrash_nasync_image_list_append(&image_list, _dyld_get_image_header(i), _dyld_get_image_name(i));
+    plcrash_async_thread_state_mach_thread_init(&thread_state, thread);
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_string_table_init(&string_table, PLCRASH_ASYNC_STRING_TABLE_DEFAULT_CAPACITY, PLCRASH_ASYNC_STRING_TABLE_DEFAULT_STORAGE_SIZE), @"Failed to initialize string table");
+
+    NSData *inlined = [self writeReportForThread: thread threadState: &thread_state imageList: &image_list registerEncoding: PLCRASH_LOG_REGISTER_ENCODING_NAMED
+                           symbolicationStrategy: PLCRASH_ASYNC_SYMBOL_STRATEGY_ALL stringTable: NULL fingerprintFrameCount: 0 elapsed: NULL];
+    NSData *tabled = [self writeReportForThread: thread threadState: &thread_state imageList: &image_list registerEncoding: PLCRASH_LOG_REGISTER_ENCODING_NAMED
+                          symbolicationStrategy: PLCRASH_ASYNC_SYMBOL_STRATEGY_ALL stringTable: &string_table fingerprintFrameCount: 0 elapsed: NULL];
+    plcrash_nasync_image_list_free(&image_list);
+
+    STAssertNotEquals(0U, plcrash_async_string_table_count(&string_table), @"No strings were interned");
+    plcrash_async_string_table_free(&string_table);
+
+    /* Check the wire representation */
+    const struct PLCrashReportFileHeader *header = [tabled bytes];
+    Plcrash__CrashReport *crashReport = plcrash__crash_report__unpack(NULL, [tabled length] - sizeof(struct PLCrashReportFileHeader), header->data);
+    STAssertNotNULL(crashReport, @"Could not decode crash report");
+    if (crashReport != NULL) {
+        STAssertNotNULL(crashReport->string_table, @"Missing string table");
+        for (size_t i = 0; i < crashReport->n_binary_images; i++) {
+            STAssertNULL(crashReport->binary_images[i]->name, @"Image name written inline");
+            STAssertTrue(crashReport->binary_images[i]->has_name_index, @"Missing image name index");
+        }
+        protobuf_c_message_free_unpacked((ProtobufCMessage *) crashReport, NULL);
+    }
+
+    /* Both reports must decode to the same names */
+    PLCrashReport *inlinedReport = [[[PLCrashReport alloc] initWithData: inlined error: &error] autorelease];
+    STAssertNotNil(inlinedReport, @"Could not decode report: %@", error);
+    PLCrashReport *tabledReport = [[[PLCrashReport alloc] initWithData: tabled error: &error] autorelease];
+    STAssertNotNil(tabledReport, @"Could not decode report: %@", error);
+
+    STAssertEquals([inlinedReport.images count], [tabledReport.images count], @"Image count does not match");
+    for (NSUInteger i = 0; i < [inlinedReport.images count] && i < [tabledReport.images count]; i++) {
+        PLCrashReportBinaryImageInfo *expected = [inlinedReport.images objectAtIndex: i];
+        PLCrashReportBinaryImageInfo *actual = [tabledReport.images objectAtIndex: i];
+        STAssertEqualObjects(expected.imageName, actual.imageName, @"Image name does not match");
+    }
+
+    STAssertEquals([inlinedReport.threads count], [tabledReport.threads count], @"Thread count does not match");
+    for (NSUInteger i = 0; i < [inlinedReport.threads count] && i < [tabledReport.threads count]; i++) {
+        NSArray *expectedFrames = [[inlinedReport.threads objectAtIndex: i] stackFrames];
+        NSArray *actualFrames = [[tabledReport.threads objectAtIndex: i] stackFrames];
+        STAssertEquals([expectedFrames count], [actualFrames count], @"Frame count does not match");
+        for (NSUInteger f = 0; f < [expectedFrames count] && f < [actualFrames count]; f++) {
+            PLCrashReportSymbolInfo *expected = [[expectedFrames objectAtIndex: f] symbolInfo];
+            PLCrashReportSymbolInfo *actual = [[actualFrames objectAtIndex: f] symbolInfo];
+            STAssertEqualObjects(expected.symbolName, actual.symbolName, @"Symbol name does not match");
+        }
+    }
+}
+
+/**
+ * Verify that the report fingerprint is stable across reports of the same thread state, and may be read both
+ * from the fixed file offset and from the decoded report.
+ */
+- (void) testWriteFingerprint {
+    plcrash_async_image_list_t image_list;
+    plcrash_async_thread_state_t thread_state;
+    thread_t thread = pthread_mach_thread_np(_thr_args.thread);
+    uint64_t fingerprint;
+    uint64_t other;
+    NSError *error;
+
+    plcrash_nasync_image_list_init(&image_list, mach_task_self());
+    for (uint32_t i = 0; i < _dyld_image_count(); i++)
+        plcrash_nasync_image_list_append(&image_list, _dyld_get_image_header(i), _dyld_get_image_name(i));
+    plcrash_async_thread_state_mach_thread_init(&thread_state, thread);
+
+    NSData *first = [self writeReportForThread: thread threadState: &thread_state imageList: &image_list registerEncoding: PLCRASH_LOG_REGISTER_ENCODING_NAMED
+                         symbolicationStrategy: PLCRASH_ASYNC_SYMBOL_STRATEGY_NONE stringTable: NULL fingerprintFrameCount: 8 elapsed: NULL];
+    NSData *second = [self writeReportForThread: thread threadState: &thread_state imageList: &image_list registerEncoding: PLCRASH_LOG_REGISTER_ENCODING_NAMED
+                          symbolicationStrategy: PLCRASH_ASYNC_SYMBOL_STRATEGY_NONE stringTable: NULL fingerprintFrameCount: 8 elapsed: NULL];
+    NSData *shallow = [self writeReportForThread: thread threadState: &thread_state imageList: &image_list registerEncoding: PLCRASH_LOG_REGISTER_ENCODING_NAMED
+                           symbolicationStrategy: PLCRASH_ASYNC_SYMBOL_STRATEGY_NONE stringTable: NULL fingerprintFrameCount: 1 elapsed: NULL];
+    NSData *disabled = [self writeReportForThread: thread threadState: &thread_state imageList: &image_list registerEncoding: PLCRASH_LOG_REGISTER_ENCODING_NAMED
+                            symbolicationStrategy: PLCRASH_ASYNC_SYMBOL_STRATEGY_NONE stringTable: NULL fingerprintFrameCount: 0 elapsed: NULL];
+    plcrash_nasync_image_list_free(&image_list);
+
+    /* Read the fingerprint without decoding */
+    STAssertTrue([PLCrashReport fingerprintFromData: first fingerprint: &fingerprint], @"Fingerprint not found at the fixed offset");
+    STAssertTrue([PLCrashReport fingerprintFromData: second fingerprint: &other], @"Fingerprint not found at the fixed offset");
+    STAssertEquals(fingerprint, other, @"Fingerprint is not stable across reports");
+
+    STAssertTrue([PLCrashReport fingerprintFromData: shallow fingerprint: &other], @"Fingerprint not found at the fixed offset");
+    STAssertNotEquals(fingerprint, other, @"Fingerprint did not depend on the frame count");
+
+    STAssertFalse([PLCrashReport fingerprintFromData: disabled fingerprint: &other], @"Fingerprint unexpectedly found");
+
+    /* The decoded report must match */
+    PLCrashReport *report = [[[PLCrashReport alloc] initWithData: first error: &error] autorelease];
+    STAssertNotNil(report, @"Could not decode report: %@", error);
+    STAssertTrue(report.hasFingerprint, @"Missing fingerprint");
+    STAssertEquals(fingerprint, report.fingerprint, @"Decoded fingerprint does not match");
+
+    report = [[[PLCrashReport alloc] initWithData: disabled error: &error] autorelease];
+    STAssertNotNil(report, @"Could not decode report: %@", error);
+    STAssertFalse(report.hasFingerprint, @"Fingerprint unexpectedly decoded");
+}
+
+/**
+ * Compare the report size and the write and decode latency of the named and typed register encodings, using
+ * the same captured thread state for both.
+ */
+- (void) testRegisterEncodingBenchmark {
+    plcrash_log_register_encoding_t encodings[] = { PLCRASH_LOG_REGISTER_ENCODING_NAMED, PLCRASH_LOG_REGISTER_ENCODING_TYPED };
+    const char *names[] = { "named (v1)", "typed (v2)" };
+    plcrash_async_image_list_t image_list;
+    plcrash_async_thread_state_t thread_state;
+    thread_t thread = pthread_mach_thread_np(_thr_args.thread);
+    mach_timebase_info_data_t timebase;
+
+    mach_timebase_info(&timebase);
+    plcrash_nasync_image_list_init(&image_list, mach_task_self());
+    for (uint32_t i = 0; i < _dyld_image_count(); i++)
+        plcrash_nasync_image_list_append(&image_list, _dyld_get_image_header(i), _dyld_get_image_name(i));
+    plcrash_async_thread_state_mach_thread_init(&thread_state, thread);
+
+    fprintf(stderr, "Register encoding benchmark: %u reports per encoding\n", REGISTER_ENCODING_BENCHMARK_ITERATIONS);
+    fprintf(stderr, "  %-12s %12s %14s %12s %12s\n", "", "report bytes", "register bytes", "write ns", "decode ns");
+
+    for (size_t e = 0; e < sizeof(encodings) / sizeof(encodings[0]); e++) {
+        uint64_t write_total = 0;
+        uint64_t decode_total = 0;
+        NSData *data = nil;
+
+        for (uint32_t i = 0; i < REGISTER_ENCODING_BENCHMARK_ITERATIONS; i++) {
+            NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+            uint64_t elapsed;
+
+            [data release];
+            data = [[self writeReportForThread: thread threadState: &thread_state imageList: &image_list registerEncoding: encodings[e] elapsed: &elapsed] retain];
+            write_total += elapsed;
+
+            uint64_t start = mach_absolute_time();
+            PLCrashReport *report = [[PLCrashReport alloc] initWithData: data error: NULL];
+            decode_total += mach_absolute_time() - start;
+            STAssertNotNil(report, @"Could not decode report");
+            [report release];
+
+            [pool drain];
+        }
+
+        /* Determine the encoded size of the crashed thread's register values, by re-packing the thread without them */
+        size_t register_bytes = 0;
+        Plcrash__CrashReport *crashReport;
+        Plcrash__CrashReport__Thread *thr = [self crashedThreadInReport: data crashReport: &crashReport];
+        if (thr != NULL) {
+            size_t n_registers = thr->n_registers;
+            Plcrash__CrashReport__Thread__RegisterState *register_state = thr->register_state;
+
+            register_bytes = plcrash__crash_report__thread__get_packed_size(thr);
+            thr->n_registers = 0;
+            thr->register_state = NULL;
+            register_bytes -= plcrash__crash_report__thread__get_packed_size(thr);
+
+            thr->n_registers = n_registers;
+            thr->register_state = register_state;
+        }
+        if (crashReport != NULL)
+            protobuf_c_message_free_unpacked((ProtobufCMessage *) crashReport, NULL);
+
+        fprintf(stderr, "  %-12s %12lu %14lu %12.0f %12.0f\n", names[e], (unsigned long) [data length], (unsigned long) register_bytes,
+                (double) write_total * timebase.numer / timebase.denom / REGISTER_ENCODING_BENCHMARK_ITERATIONS,
+                (double) decode_total * timebase.numer / timebase.denom / REGISTER_ENCODING_BENCHMARK_ITERATIONS);
+        [data release];
+    }
+
+    plcrash_nasync_image_list_free(&image_list);
+}
+
 @end
@@ -106,9 +106,13 @@
 #endif /* PLCR_PRIVATE */
 
 #ifdef PLCR_PRIVATE
-#  if defined(__clang__) && __has_feature(cxx_attributes) && __has_warning("-Wimplicit-fallthrough")
-#    define PLCR_FALLTHROUGH [[clang::fallthrough]]
-#  else
+/* __has_feature() and __has_warning() may only be evaluated on compilers that define them */
+#  if defined(__clang__)
+#    if __has_feature(cxx_attributes) && __has_warning("-Wimplicit-fallthrough")
+#      define PLCR_FALLTHROUGH [[clang::fallthrough]]
+#    endif
+#  endif
+#  ifndef PLCR_FALLTHROUGH
 #    define PLCR_FALLTHROUGH do {} while (0)
 #  endif
 #endif
@@ -77,6 +77,10 @@
 #define PLCrashMachExceptionPortSet         PLNS(PLCrashMachExceptionPortSet)
 #define PLCrashProcessInfo                  PLNS(PLCrashProcessInfo)
 #define PLCrashReporterConfig               PLNS(PLCrashReporterConfig)
+#define PLMutableCrashReporterConfig        PLNS(PLMutableCrashReporterConfig)
+#define PLCrashProfiler                     PLNS(PLCrashProfiler)
+#define PLCrashHangWatchdog                 PLNS(PLCrashHangWatchdog)
+#define PLCrashHangWatchdogDelegate         PLNS(PLCrashHangWatchdogDelegate)
 #define PLCrashUncaughtExceptionHandler     PLNS(PLCrashUncaughtExceptionHandler)
 #define PLCrashReportFormatter              PLNS(PLCrashReportFormatter)
 
@@ -157,9 +161,19 @@
 #define plcrash_async_cfe_reader_init PLNS(plcrash_async_cfe_reader_init)
 #define plcrash_async_cfe_register_decode PLNS(plcrash_async_cfe_register_decode)
 #define plcrash_async_cfe_register_encode PLNS(plcrash_async_cfe_register_encode)
+#define plcrash_async_elf_byteorder PLNS(plcrash_async_elf_byteorder)
+#define plcrash_async_elf_eh_frame_hdr_search PLNS(plcrash_async_elf_eh_frame_hdr_search)
+#define plcrash_async_elf_find_symbol_by_name PLNS(plcrash_async_elf_find_symbol_by_name)
+#define plcrash_async_elf_map_eh_frame PLNS(plcrash_async_elf_map_eh_frame)
+#define plcrash_async_elf_map_eh_frame_hdr PLNS(plcrash_async_elf_map_eh_frame_hdr)
+#define plcrash_async_elf_map_section PLNS(plcrash_async_elf_map_section)
+#define plcrash_async_file_buffer_detach PLNS(plcrash_async_file_buffer_detach)
+#define plcrash_async_file_buffer_length PLNS(plcrash_async_file_buffer_length)
 #define plcrash_async_file_close PLNS(plcrash_async_file_close)
 #define plcrash_async_file_flush PLNS(plcrash_async_file_flush)
 #define plcrash_async_file_init PLNS(plcrash_async_file_init)
+#define plcrash_async_file_init_buffer PLNS(plcrash_async_file_init_buffer)
+#define plcrash_async_file_init_growable PLNS(plcrash_async_file_init_growable)
 #define plcrash_async_file_write PLNS(plcrash_async_file_write)
 #define plcrash_async_find_symbol PLNS(plcrash_async_find_symbol)
 #define plcrash_async_image_containing_address PLNS(plcrash_async_image_containing_address)
@@ -190,35 +204,82 @@
 #define plcrash_async_macho_symtab_reader_read PLNS(plcrash_async_macho_symtab_reader_read)
 #define plcrash_async_macho_symtab_reader_symbol_name PLNS(plcrash_async_macho_symtab_reader_symbol_name)
 #define plcrash_async_memcpy PLNS(plcrash_async_memcpy)
+#define plcrash_async_memory_source_lookup PLNS(plcrash_async_memory_source_lookup)
+#define plcrash_async_memory_source_regions_init PLNS(plcrash_async_memory_source_regions_init)
+#define plcrash_async_memory_source_register PLNS(plcrash_async_memory_source_register)
+#define plcrash_async_memory_source_task PLNS(plcrash_async_memory_source_task)
+#define plcrash_async_memory_source_task_init PLNS(plcrash_async_memory_source_task_init)
+#define plcrash_async_memory_source_unregister PLNS(plcrash_async_memory_source_unregister)
 #define plcrash_async_memset PLNS(plcrash_async_memset)
 #define plcrash_async_mobject_base_address PLNS(plcrash_async_mobject_base_address)
 #define plcrash_async_mobject_free PLNS(plcrash_async_mobject_free)
 #define plcrash_async_mobject_init PLNS(plcrash_async_mobject_init)
 #define plcrash_async_mobject_length PLNS(plcrash_async_mobject_length)
+#define plcrash_async_mobject_map_pages PLNS(plcrash_async_mobject_map_pages)
+#define plcrash_async_mobject_pool_attach PLNS(plcrash_async_mobject_pool_attach)
+#define plcrash_async_mobject_pool_current PLNS(plcrash_async_mobject_pool_current)
+#define plcrash_async_mobject_pool_detach PLNS(plcrash_async_mobject_pool_detach)
+#define plcrash_async_mobject_pool_free PLNS(plcrash_async_mobject_pool_free)
+#define plcrash_async_mobject_pool_init PLNS(plcrash_async_mobject_pool_init)
+#define plcrash_async_mobject_pool_map PLNS(plcrash_async_mobject_pool_map)
+#define plcrash_async_mobject_pool_unmap PLNS(plcrash_async_mobject_pool_unmap)
 #define plcrash_async_mobject_read_uint16 PLNS(plcrash_async_mobject_read_uint16)
 #define plcrash_async_mobject_read_uint32 PLNS(plcrash_async_mobject_read_uint32)
 #define plcrash_async_mobject_read_uint64 PLNS(plcrash_async_mobject_read_uint64)
 #define plcrash_async_mobject_read_uint8 PLNS(plcrash_async_mobject_read_uint8)
 #define plcrash_async_mobject_remap_address PLNS(plcrash_async_mobject_remap_address)
 #define plcrash_async_mobject_task PLNS(plcrash_async_mobject_task)
+#define plcrash_async_mobject_unmap_pages PLNS(plcrash_async_mobject_unmap_pages)
 #define plcrash_async_mobject_verify_local_pointer PLNS(plcrash_async_mobject_verify_local_pointer)
 #define plcrash_async_objc_cache_free PLNS(plcrash_async_objc_cache_free)
 #define plcrash_async_objc_cache_init PLNS(plcrash_async_objc_cache_init)
 #define plcrash_async_objc_find_method PLNS(plcrash_async_objc_find_method)
 #define plcrash_async_objc_supports_nonptr_isa PLNS(plcrash_async_objc_supports_nonptr_isa)
+#define plcrash_async_page_cache_attach PLNS(plcrash_async_page_cache_attach)
+#define plcrash_async_page_cache_current PLNS(plcrash_async_page_cache_current)
+#define plcrash_async_page_cache_detach PLNS(plcrash_async_page_cache_detach)
+#define plcrash_async_page_cache_free PLNS(plcrash_async_page_cache_free)
+#define plcrash_async_page_cache_init PLNS(plcrash_async_page_cache_init)
+#define plcrash_async_page_cache_memcpy PLNS(plcrash_async_page_cache_memcpy)
 #define plcrash_async_read_addr PLNS(plcrash_async_read_addr)
+#define plcrash_async_read_stats_get PLNS(plcrash_async_read_stats_get)
+#define plcrash_async_read_stats_record_map PLNS(plcrash_async_read_stats_record_map)
+#define plcrash_async_read_stats_record_unmap PLNS(plcrash_async_read_stats_record_unmap)
+#define plcrash_async_read_stats_reset PLNS(plcrash_async_read_stats_reset)
+#define plcrash_async_sample_ring_commit PLNS(plcrash_async_sample_ring_commit)
+#define plcrash_async_sample_ring_consume PLNS(plcrash_async_sample_ring_consume)
+#define plcrash_async_sample_ring_dropped PLNS(plcrash_async_sample_ring_dropped)
+#define plcrash_async_sample_ring_free PLNS(plcrash_async_sample_ring_free)
+#define plcrash_async_sample_ring_init PLNS(plcrash_async_sample_ring_init)
+#define plcrash_async_sample_ring_peek PLNS(plcrash_async_sample_ring_peek)
+#define plcrash_async_sample_ring_reserve PLNS(plcrash_async_sample_ring_reserve)
 #define plcrash_async_signal_sigcode PLNS(plcrash_async_signal_sigcode)
 #define plcrash_async_signal_signame PLNS(plcrash_async_signal_signame)
+#define plcrash_async_stack_trie_free PLNS(plcrash_async_stack_trie_free)
+#define plcrash_async_stack_trie_init PLNS(plcrash_async_stack_trie_init)
+#define plcrash_async_stack_trie_insert PLNS(plcrash_async_stack_trie_insert)
+#define plcrash_async_stack_trie_reset PLNS(plcrash_async_stack_trie_reset)
+#define plcrash_async_stack_window_init PLNS(plcrash_async_stack_window_init)
+#define plcrash_async_stack_window_memcpy PLNS(plcrash_async_stack_window_memcpy)
 #define plcrash_async_strcmp PLNS(plcrash_async_strcmp)
 #define plcrash_async_strerror PLNS(plcrash_async_strerror)
+#define plcrash_async_string_table_count PLNS(plcrash_async_string_table_count)
+#define plcrash_async_string_table_free PLNS(plcrash_async_string_table_free)
+#define plcrash_async_string_table_init PLNS(plcrash_async_string_table_init)
+#define plcrash_async_string_table_intern PLNS(plcrash_async_string_table_intern)
+#define plcrash_async_string_table_reset PLNS(plcrash_async_string_table_reset)
+#define plcrash_async_string_table_string PLNS(plcrash_async_string_table_string)
 #define plcrash_async_strncmp PLNS(plcrash_async_strncmp)
 #define plcrash_async_symbol_cache_free PLNS(plcrash_async_symbol_cache_free)
 #define plcrash_async_symbol_cache_init PLNS(plcrash_async_symbol_cache_init)
 #define plcrash_async_task_memcpy PLNS(plcrash_async_task_memcpy)
+#define plcrash_async_task_memcpy_uncached PLNS(plcrash_async_task_memcpy_uncached)
 #define plcrash_async_task_read_uint16 PLNS(plcrash_async_task_read_uint16)
 #define plcrash_async_task_read_uint32 PLNS(plcrash_async_task_read_uint32)
 #define plcrash_async_task_read_uint64 PLNS(plcrash_async_task_read_uint64)
 #define plcrash_async_task_read_uint8 PLNS(plcrash_async_task_read_uint8)
+#define plcrash_async_task_release PLNS(plcrash_async_task_release)
+#define plcrash_async_task_retain PLNS(plcrash_async_task_retain)
 #define plcrash_async_thread_state_clear_all_regs PLNS(plcrash_async_thread_state_clear_all_regs)
 #define plcrash_async_thread_state_clear_reg PLNS(plcrash_async_thread_state_clear_reg)
 #define plcrash_async_thread_state_clear_volatile_regs PLNS(plcrash_async_thread_state_clear_volatile_regs)
@@ -242,32 +303,85 @@
 #define plcrash_log_writer_free PLNS(plcrash_log_writer_free)
 #define plcrash_log_writer_init PLNS(plcrash_log_writer_init)
 #define plcrash_log_writer_set_exception PLNS(plcrash_log_writer_set_exception)
+#define plcrash_log_writer_set_fingerprint_frame_count PLNS(plcrash_log_writer_set_fingerprint_frame_count)
+#define plcrash_log_writer_set_mobject_pool PLNS(plcrash_log_writer_set_mobject_pool)
+#define plcrash_log_writer_set_page_cache PLNS(plcrash_log_writer_set_page_cache)
+#define plcrash_log_writer_set_register_encoding PLNS(plcrash_log_writer_set_register_encoding)
+#define plcrash_log_writer_set_report_type PLNS(plcrash_log_writer_set_report_type)
+#define plcrash_log_writer_set_string_table PLNS(plcrash_log_writer_set_string_table)
 #define plcrash_log_writer_write PLNS(plcrash_log_writer_write)
+#define plcrash_nasync_elf_free PLNS(plcrash_nasync_elf_free)
+#define plcrash_nasync_elf_init PLNS(plcrash_nasync_elf_init)
 #define plcrash_nasync_image_list_append PLNS(plcrash_nasync_image_list_append)
 #define plcrash_nasync_image_list_free PLNS(plcrash_nasync_image_list_free)
 #define plcrash_nasync_image_list_init PLNS(plcrash_nasync_image_list_init)
 #define plcrash_nasync_image_list_remove PLNS(plcrash_nasync_image_list_remove)
 #define plcrash_nasync_macho_free PLNS(plcrash_nasync_macho_free)
 #define plcrash_nasync_macho_init PLNS(plcrash_nasync_macho_init)
+#define plcrash_nasync_memory_file_close PLNS(plcrash_nasync_memory_file_close)
+#define plcrash_nasync_memory_file_macho_regions PLNS(plcrash_nasync_memory_file_macho_regions)
+#define plcrash_nasync_memory_file_open PLNS(plcrash_nasync_memory_file_open)
 #define plcrash_populate_error PLNS(plcrash_populate_error)
 #define plcrash_populate_mach_error PLNS(plcrash_populate_mach_error)
 #define plcrash_populate_posix_error PLNS(plcrash_populate_posix_error)
+#define plcrash_report_frame_iter_next PLNS(plcrash_report_frame_iter_next)
+#define plcrash_report_image_iter_next PLNS(plcrash_report_image_iter_next)
+#define plcrash_report_reader_application_info PLNS(plcrash_report_reader_application_info)
+#define plcrash_report_reader_exception PLNS(plcrash_report_reader_exception)
+#define plcrash_report_reader_exception_frames PLNS(plcrash_report_reader_exception_frames)
+#define plcrash_report_reader_failed PLNS(plcrash_report_reader_failed)
+#define plcrash_report_reader_image_count PLNS(plcrash_report_reader_image_count)
+#define plcrash_report_reader_images PLNS(plcrash_report_reader_images)
+#define plcrash_report_reader_index_strings PLNS(plcrash_report_reader_index_strings)
+#define plcrash_report_reader_machine_info PLNS(plcrash_report_reader_machine_info)
+#define plcrash_report_reader_open PLNS(plcrash_report_reader_open)
+#define plcrash_report_reader_process_info PLNS(plcrash_report_reader_process_info)
+#define plcrash_report_reader_report_info PLNS(plcrash_report_reader_report_info)
+#define plcrash_report_reader_signal PLNS(plcrash_report_reader_signal)
+#define plcrash_report_reader_string PLNS(plcrash_report_reader_string)
+#define plcrash_report_reader_string_count PLNS(plcrash_report_reader_string_count)
+#define plcrash_report_reader_system_info PLNS(plcrash_report_reader_system_info)
+#define plcrash_report_reader_thread_count PLNS(plcrash_report_reader_thread_count)
+#define plcrash_report_reader_thread_frames PLNS(plcrash_report_reader_thread_frames)
+#define plcrash_report_reader_thread_registers PLNS(plcrash_report_reader_thread_registers)
+#define plcrash_report_reader_threads PLNS(plcrash_report_reader_threads)
+#define plcrash_report_register_iter_next PLNS(plcrash_report_register_iter_next)
+#define plcrash_report_thread_iter_next PLNS(plcrash_report_thread_iter_next)
 #define plcrash_sysctl_int PLNS(plcrash_sysctl_int)
 #define plcrash_sysctl_string PLNS(plcrash_sysctl_string)
 #define plcrash_sysctl_valid_utf8_bytes PLNS(plcrash_sysctl_valid_utf8_bytes)
 #define plcrash_sysctl_valid_utf8_bytes_max PLNS(plcrash_sysctl_valid_utf8_bytes_max)
+#define plcrash_text_buffer_append PLNS(plcrash_text_buffer_append)
+#define plcrash_text_buffer_append_hex PLNS(plcrash_text_buffer_append_hex)
+#define plcrash_text_buffer_append_hex_alternate PLNS(plcrash_text_buffer_append_hex_alternate)
+#define plcrash_text_buffer_append_int64 PLNS(plcrash_text_buffer_append_int64)
+#define plcrash_text_buffer_append_padded PLNS(plcrash_text_buffer_append_padded)
+#define plcrash_text_buffer_append_padding PLNS(plcrash_text_buffer_append_padding)
+#define plcrash_text_buffer_append_string PLNS(plcrash_text_buffer_append_string)
+#define plcrash_text_buffer_bytes PLNS(plcrash_text_buffer_bytes)
+#define plcrash_text_buffer_detach PLNS(plcrash_text_buffer_detach)
+#define plcrash_text_buffer_failed PLNS(plcrash_text_buffer_failed)
+#define plcrash_text_buffer_free PLNS(plcrash_text_buffer_free)
+#define plcrash_text_buffer_init PLNS(plcrash_text_buffer_init)
+#define plcrash_text_buffer_length PLNS(plcrash_text_buffer_length)
+#define plcrash_text_buffer_utf16_length PLNS(plcrash_text_buffer_utf16_length)
 #define plcrash_writer_pack PLNS(plcrash_writer_pack)
 #define plframe_cursor_free PLNS(plframe_cursor_free)
 #define plframe_cursor_get_reg PLNS(plframe_cursor_get_reg)
 #define plframe_cursor_get_regcount PLNS(plframe_cursor_get_regcount)
 #define plframe_cursor_get_regname PLNS(plframe_cursor_get_regname)
 #define plframe_cursor_init PLNS(plframe_cursor_init)
+#define plframe_cursor_is_scanned PLNS(plframe_cursor_is_scanned)
 #define plframe_cursor_next PLNS(plframe_cursor_next)
 #define plframe_cursor_next_with_readers PLNS(plframe_cursor_next_with_readers)
 #define plframe_cursor_read_compact_unwind PLNS(plframe_cursor_read_compact_unwind)
 #define plframe_cursor_read_dwarf_unwind PLNS(plframe_cursor_read_dwarf_unwind)
 #define plframe_cursor_read_frame_ptr PLNS(plframe_cursor_read_frame_ptr)
+#define plframe_cursor_read_stack_scan PLNS(plframe_cursor_read_stack_scan)
 #define plframe_cursor_thread_init PLNS(plframe_cursor_thread_init)
+#define plframe_stackframe_summary_get_reg PLNS(plframe_stackframe_summary_get_reg)
+#define plframe_stackframe_summary_has_reg PLNS(plframe_stackframe_summary_has_reg)
+#define plframe_stackframe_summary_init PLNS(plframe_stackframe_summary_init)
 #define plframe_strerror PLNS(plframe_strerror)
 #define plframe_test_thread_spawn PLNS(plframe_test_thread_spawn)
 #define plframe_test_thread_stop PLNS(plframe_test_thread_stop)
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+#import <mach/mach.h>
+
+/**
+ * @ingroup constants
+ * Profile file magic identifier */
+#define PLCRASH_PROFILE_FILE_MAGIC "plprofile"
+
+/**
+ * @ingroup constants
+ * Profile format version byte identifier. Will not change outside of the introduction of an entirely new profile
+ * format. */
+#define PLCRASH_PROFILE_FILE_VERSION 1
+
+/**
+ * @ingroup constants
+ * The default number of samples that may be buffered between aggregation passes.
+ */
+#define PLCRASH_PROFILER_DEFAULT_SAMPLE_CAPACITY 1024
+
+/**
+ * @ingroup constants
+ * The default number of unique call path nodes that may be recorded by a profiler.
+ */
+#define PLCRASH_PROFILER_DEFAULT_NODE_CAPACITY 65536
+
+/**
+ * @internal
+ * Private sampler state (used to hide the async-safe sampling implementation).
+ */
+typedef struct _PLCrashProfilerState _PLCrashProfilerState;
+
+@interface PLCrashProfiler : NSObject {
+@private
+    /** Private sampler state */
+    _PLCrashProfilerState *_state;
+
+    /** The interval between samples */
+    NSTimeInterval _samplingInterval;
+}
+
+- (instancetype) initWithThreads: (const thread_t *) threads count: (NSUInteger) count samplingInterval: (NSTimeInterval) samplingInterval;
+
+- (instancetype) initWithThreads: (const thread_t *) threads
+                           count: (NSUInteger) count
+                samplingInterval: (NSTimeInterval) samplingInterval
+                  sampleCapacity: (NSUInteger) sampleCapacity
+                    nodeCapacity: (NSUInteger) nodeCapacity;
+
+- (BOOL) startAndReturnError: (NSError **) outError;
+- (void) stop;
+
+- (void) reset;
+
+- (NSData *) profileDataAndReturnError: (NSError **) outError;
+
+/** The interval between samples. */
+@property(nonatomic, readonly) NSTimeInterval samplingInterval;
+
+/** YES if the profiler is currently sampling. */
+@property(nonatomic, readonly, getter=isRunning) BOOL running;
+
+/** The number of stack samples aggregated into the profile. */
+@property(nonatomic, readonly) NSUInteger sampleCount;
+
+/** The number of stack samples that were discarded, either because the sample buffer or the profile was full. */
+@property(nonatomic, readonly) NSUInteger droppedSampleCount;
+
+@end
@@ -0,0 +1,856 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "PLCrashProfiler.h"
+#import "CrashReporter.h"
+
+#import "PLCrashAsync.h"
+#import "PLCrashAsyncImageList.h"
+#import "PLCrashAsyncSampleRing.h"
+#import "PLCrashAsyncStackTrie.h"
+#import "PLCrashAsyncSymbolication.h"
+#import "PLCrashFrameWalker.h"
+#import "PLCrashLogWriterEncoding.h"
+
+#import "PLCrashReporterNSError.h"
+
+#import <pthread.h>
+#import <libkern/OSAtomic.h>
+#import <dlfcn.h>
+#import <mach/mach_time.h>
+#import <mach-o/dyld.h>
+
+/** @internal
+ * Maximum number of bytes that will be written to a profile.
+ * Used as a safety measure in case of implementation malfunction. */
+#define MAX_PROFILE_BYTES (16 * 1024 * 1024)
+
+/** @internal
+ * Initial size of the in-memory profile buffer. The buffer is grown as required, up to MAX_PROFILE_BYTES. */
+#define PROFILE_INITIAL_BYTES (64 * 1024)
+
+/** @internal
+ * Protobuf field IDs, as defined in profile.proto */
+enum {
+    /* Profile */
+    PLCRASH_PROTO_PROFILE_INFO_ID = 1,
+    PLCRASH_PROTO_PROFILE_THREADS_ID = 2,
+    PLCRASH_PROTO_PROFILE_IMAGES_ID = 3,
+    PLCRASH_PROTO_PROFILE_SYMBOLS_ID = 4,
+    PLCRASH_PROTO_PROFILE_NODES_ID = 5,
+
+    /* Profile.Info */
+    PLCRASH_PROTO_PROFILE_INFO_SAMPLING_INTERVAL_ID = 1,
+    PLCRASH_PROTO_PROFILE_INFO_DURATION_ID = 2,
+    PLCRASH_PROTO_PROFILE_INFO_SAMPLE_COUNT_ID = 3,
+    PLCRASH_PROTO_PROFILE_INFO_DROPPED_COUNT_ID = 4,
+    PLCRASH_PROTO_PROFILE_INFO_TIMESTAMP_ID = 5,
+
+    /* Profile.Thread */
+    PLCRASH_PROTO_PROFILE_THREAD_INDEX_ID = 1,
+    PLCRASH_PROTO_PROFILE_THREAD_NAME_ID = 2,
+
+    /* Profile.Image */
+    PLCRASH_PROTO_PROFILE_IMAGE_BASE_ADDRESS_ID = 1,
+    PLCRASH_PROTO_PROFILE_IMAGE_SIZE_ID = 2,
+    PLCRASH_PROTO_PROFILE_IMAGE_NAME_ID = 3,
+    PLCRASH_PROTO_PROFILE_IMAGE_UUID_ID = 4,
+
+    /* Profile.Symbol */
+    PLCRASH_PROTO_PROFILE_SYMBOL_NAME_ID = 1,
+    PLCRASH_PROTO_PROFILE_SYMBOL_START_ADDRESS_ID = 2,
+
+    /* Profile.Node */
+    PLCRASH_PROTO_PROFILE_NODE_PARENT_ID = 1,
+    PLCRASH_PROTO_PROFILE_NODE_PC_ID = 2,
+    PLCRASH_PROTO_PROFILE_NODE_THREAD_ID = 3,
+    PLCRASH_PROTO_PROFILE_NODE_IMAGE_ID = 4,
+    PLCRASH_PROTO_PROFILE_NODE_SYMBOL_ID = 5,
+    PLCRASH_PROTO_PROFILE_NODE_SELF_COUNT_ID = 6,
+    PLCRASH_PROTO_PROFILE_NODE_TOTAL_COUNT_ID = 7,
+};
+
+/** @internal
+ * Images loaded in the current process; maintained via dyld callbacks. */
+static plcrash_async_image_list_t profiler_image_list;
+
+/**
+ * @internal
+ *
+ * Sampler state. The sampler thread is the single producer for @a ring; the ring is consumed, and the samples
+ * aggregated into @a trie, only while @a trie_lock is held.
+ */
+struct _PLCrashProfilerState {
+    /** Sampled threads. A send right is held for each thread. */
+    thread_t *threads;
+
+    /** The number of entries in @a threads. */
+    uint32_t thread_count;
+
+    /** The interval between samples, in mach_absolute_time() units. */
+    uint64_t interval_abs;
+
+    /** Buffered samples, written by the sampler thread while the sampled thread is suspended. */
+    plcrash_async_sample_ring_t ring;
+
+    /** Aggregated samples. */
+    plcrash_async_stack_trie_t trie;
+
+    /** Guards @a trie, and the consumer side of @a ring. */
+    pthread_mutex_t trie_lock;
+
+    /** The value of the ring's dropped sample counter at the most recent reset. */
+    uint32_t ring_dropped_base;
+
+    /** The sampler thread. Only valid while @a running is true. */
+    pthread_t sampler;
+
+    /** Set to request that the sampler thread exit. */
+    volatile uint32_t should_stop;
+
+    /** True if the sampler thread is running. */
+    bool running;
+
+    /** The mach_absolute_time() at which the sampler was most recently started. */
+    uint64_t start_abs;
+
+    /** Total sampling time of all previous runs, in mach_absolute_time() units. */
+    uint64_t elapsed_abs;
+
+    /** The time at which sampling was first started, or 0 if never started. */
+    time_t timestamp;
+};
+
+/**
+ * @internal
+ * dyld image add notification callback.
+ */
+static void profiler_image_add_callback (const struct mach_header *mh, intptr_t vmaddr_slide) {
+    Dl_info info;
+
+    /* Look up the image info */
+    if (dladdr(mh, &info) == 0) {
+        NSLog(@"%s: dladdr(%p, ...) failed", __FUNCTION__, mh);
+        return;
+    }
+
+    /* Register the image */
+    plcrash_nasync_image_list_append(&profiler_image_list, (pl_vm_address_t) mh, info.dli_fname);
+}
+
+/**
+ * @internal
+ * dyld image remove notification callback.
+ */
+static void profiler_image_remove_callback (const struct mach_header *mh, intptr_t vmaddr_slide) {
+    plcrash_nasync_image_list_remove(&profiler_image_list, (uintptr_t) mh);
+}
+
+/**
+ * @internal
+ *
+ * Sample the thread at @a index, recording its stack in the sample ring. The thread is suspended only while its
+ * stack is walked; no locks are acquired and no memory is allocated while it is suspended.
+ */
+static void plcrash_profiler_sample_thread (_PLCrashProfilerState *state, uint32_t index) {
+    thread_t thread = state->threads[index];
+
+    /* Reserve a slot before suspending the thread; if the ring is full, the sample is dropped */
+    plcrash_async_sample_t *sample = plcrash_async_sample_ring_reserve(&state->ring);
+    if (sample == NULL)
+        return;
+
+    /* The thread may have terminated */
+    if (thread_suspend(thread) != KERN_SUCCESS)
+        return;
+
+    uint64_t timestamp = mach_absolute_time();
+    uint32_t depth = 0;
+
+    plcrash_async_thread_state_t thread_state;
+    if (plcrash_async_thread_state_mach_thread_init(&thread_state, thread) == PLCRASH_ESUCCESS) {
+        plframe_cursor_t cursor;
+        if (plframe_cursor_init(&cursor, mach_task_self(), &thread_state, &profiler_image_list) == PLFRAME_ESUCCESS) {
+            while (depth < PLCRASH_ASYNC_SAMPLE_MAX_FRAMES && plframe_cursor_next(&cursor) == PLFRAME_ESUCCESS) {
+                plcrash_greg_t pc;
+                if (plframe_cursor_get_reg(&cursor, PLCRASH_REG_IP, &pc) != PLFRAME_ESUCCESS)
+                    break;
+
+                sample->pcs[depth++] = (pl_vm_address_t) pc;
+            }
+
+            plframe_cursor_free(&cursor);
+        }
+    }
+
+    thread_resume(thread);
+
+    if (depth == 0)
+        return;
+
+    sample->timestamp = timestamp;
+    sample->thread_index = index;
+    sample->depth = depth;
+    plcrash_async_sample_ring_commit(&state->ring);
+}
+
+/**
+ * @internal
+ *
+ * Aggregate all buffered samples into the stack trie. The trie lock must be held.
+ */
+static void plcrash_profiler_drain (_PLCrashProfilerState *state) {
+    const plcrash_async_sample_t *sample;
+
+    while ((sample = plcrash_async_sample_ring_peek(&state->ring)) != NULL) {
+        plcrash_async_stack_trie_insert(&state->trie, sample->thread_index, sample->pcs, sample->depth, NULL);
+        plcrash_async_sample_ring_consume(&state->ring);
+    }
+}
+
+/**
+ * @internal
+ *
+ * Sampler thread entry point.
+ */
+static void *plcrash_profiler_sampler_thread (void *arg) {
+    _PLCrashProfilerState *state = arg;
+    uint64_t deadline = mach_absolute_time();
+
+    while (!state->should_stop) {
+        for (uint32_t i = 0; i < state->thread_count; i++)
+            plcrash_profiler_sample_thread(state, i);
+
+        /* Aggregate the buffered samples, unless the profile is currently being exported; in that case, the samples
+         * remain buffered until the next pass. */
+        if (pthread_mutex_trylock(&state->trie_lock) == 0) {
+            plcrash_profiler_drain(state);
+            pthread_mutex_unlock(&state->trie_lock);
+        }
+
+        /* Schedule the next pass; if we've fallen behind, don't attempt to catch up */
+        uint64_t now = mach_absolute_time();
+        deadline += state->interval_abs;
+        if (deadline < now)
+            deadline = now;
+
+        mach_wait_until(deadline);
+    }
+
+    return NULL;
+}
+
+/**
+ * @internal
+ *
+ * Write a Profile.Info message.
+ */
+static size_t plcrash_profile_write_info (plcrash_async_file_t *file, uint64_t interval_ns, uint64_t duration_ns, uint32_t sample_count, uint32_t dropped_count, time_t timestamp) {
+    size_t rv = 0;
+
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROFILE_INFO_SAMPLING_INTERVAL_ID, PLPROTOBUF_C_TYPE_UINT64, &interval_ns);
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROFILE_INFO_DURATION_ID, PLPROTOBUF_C_TYPE_UINT64, &duration_ns);
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROFILE_INFO_SAMPLE_COUNT_ID, PLPROTOBUF_C_TYPE_UINT32, &sample_count);
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROFILE_INFO_DROPPED_COUNT_ID, PLPROTOBUF_C_TYPE_UINT32, &dropped_count);
+
+    if (timestamp != 0) {
+        int64_t tsval = timestamp;
+        rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROFILE_INFO_TIMESTAMP_ID, PLPROTOBUF_C_TYPE_INT64, &tsval);
+    }
+
+    return rv;
+}
+
+/**
+ * @internal
+ *
+ * Write a Profile.Thread message.
+ */
+static size_t plcrash_profile_write_thread (plcrash_async_file_t *file, uint32_t index, const char *name) {
+    size_t rv = 0;
+
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROFILE_THREAD_INDEX_ID, PLPROTOBUF_C_TYPE_UINT32, &index);
+    if (name != NULL && name[0] != '\0')
+        rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROFILE_THREAD_NAME_ID, PLPROTOBUF_C_TYPE_STRING, name);
+
+    return rv;
+}
+
+/**
+ * @internal
+ *
+ * Write a Profile.Image message.
+ */
+static size_t plcrash_profile_write_image (plcrash_async_file_t *file, plcrash_async_macho_t *image) {
+    size_t rv = 0;
+
+    uint64_t base = image->header_addr;
+    uint64_t size = image->text_size;
+
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROFILE_IMAGE_BASE_ADDRESS_ID, PLPROTOBUF_C_TYPE_UINT64, &base);
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROFILE_IMAGE_SIZE_ID, PLPROTOBUF_C_TYPE_UINT64, &size);
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROFILE_IMAGE_NAME_ID, PLPROTOBUF_C_TYPE_STRING, image->name);
+
+    struct uuid_command *uuid = plcrash_async_macho_find_command(image, LC_UUID);
+    if (uuid != NULL) {
+        PLProtobufCBinaryData binary;
+        binary.len = sizeof(uuid->uuid);
+        binary.data = uuid->uuid;
+        rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROFILE_IMAGE_UUID_ID, PLPROTOBUF_C_TYPE_BYTES, &binary);
+    }
+
+    return rv;
+}
+
+/**
+ * @internal
+ *
+ * Write a Profile.Symbol message.
+ */
+static size_t plcrash_profile_write_symbol (plcrash_async_file_t *file, const char *name, uint64_t start_address) {
+    size_t rv = 0;
+
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROFILE_SYMBOL_NAME_ID, PLPROTOBUF_C_TYPE_STRING, name);
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROFILE_SYMBOL_START_ADDRESS_ID, PLPROTOBUF_C_TYPE_UINT64, &start_address);
+
+    return rv;
+}
+
+/**
+ * @internal
+ *
+ * A symbolicated call tree node, as written to a Profile.Node message.
+ */
+struct plcrash_profile_node {
+    /** Index of the node's parent, in output order. */
+    uint32_t parent;
+
+    /** The frame pc, or the thread index for thread nodes. */
+    uint64_t pc;
+
+    /** True if this is a thread node. */
+    bool is_thread;
+
+    /** Index of the containing image, or UINT32_MAX if unknown. */
+    uint32_t image;
+
+    /** Index of the containing symbol, or UINT32_MAX if unknown. */
+    uint32_t symbol;
+
+    /** Sample counts. */
+    uint32_t self_count;
+    uint32_t total_count;
+};
+
+/**
+ * @internal
+ *
+ * Write a Profile.Node message.
+ */
+static size_t plcrash_profile_write_node (plcrash_async_file_t *file, const struct plcrash_profile_node *node) {
+    size_t rv = 0;
+
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROFILE_NODE_PARENT_ID, PLPROTOBUF_C_TYPE_UINT32, &node->parent);
+
+    if (node->is_thread) {
+        uint32_t thread = (uint32_t) node->pc;
+        rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROFILE_NODE_THREAD_ID, PLPROTOBUF_C_TYPE_UINT32, &thread);
+    } else {
+        rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROFILE_NODE_PC_ID, PLPROTOBUF_C_TYPE_UINT64, &node->pc);
+    }
+
+    if (node->image != UINT32_MAX)
+        rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROFILE_NODE_IMAGE_ID, PLPROTOBUF_C_TYPE_UINT32, &node->image);
+
+    if (node->symbol != UINT32_MAX)
+        rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROFILE_NODE_SYMBOL_ID, PLPROTOBUF_C_TYPE_UINT32, &node->symbol);
+
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROFILE_NODE_SELF_COUNT_ID, PLPROTOBUF_C_TYPE_UINT32, &node->self_count);
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROFILE_NODE_TOTAL_COUNT_ID, PLPROTOBUF_C_TYPE_UINT32, &node->total_count);
+
+    return rv;
+}
+
+/**
+ * @internal
+ *
+ * Symbol lookup state used by plcrash_profile_found_symbol_cb().
+ */
+struct plcrash_profile_symbol_ctx {
+    /** The symbol start address, if found. */
+    pl_vm_address_t address;
+
+    /** The symbol name, if found. */
+    NSString *name;
+};
+
+/**
+ * @internal
+ *
+ * plcrash_async_found_symbol_cb callback implementation.
+ */
+static void plcrash_profile_found_symbol_cb (pl_vm_address_t address, const char *name, void *ctx) {
+    struct plcrash_profile_symbol_ctx *sym_ctx = ctx;
+    sym_ctx->address = address;
+    sym_ctx->name = [NSString stringWithUTF8String: name];
+}
+
+/**
+ * @internal
+ *
+ * CFAllocator deallocation callback for profile data; @a info is the buffer's vm_allocate() allocation size.
+ */
+static void plcrash_profile_data_deallocate (void *ptr, void *info) {
+    vm_deallocate(mach_task_self(), (vm_address_t) ptr, (vm_size_t) (uintptr_t) info);
+}
+
+/**
+ * Sampling profiler.
+ *
+ * A PLCrashProfiler periodically samples the stacks of a fixed set of threads, using the same async-safe unwinder
+ * that is used to generate crash reports. Each sample suspends the target thread only for as long as required to
+ * walk its stack; the raw instruction pointers are recorded in a preallocated buffer, and are aggregated into a
+ * deduplicated call tree on the sampler thread once all threads have been resumed.
+ *
+ * Symbolication is deferred until the profile is exported via PLCrashProfiler::profileDataAndReturnError:, which
+ * produces a compact aggregated profile as defined by profile.proto.
+ */
+@implementation PLCrashProfiler
+
+@synthesize samplingInterval = _samplingInterval;
+
++ (void) initialize {
+    if (![[self class] isEqual: [PLCrashProfiler class]])
+        return;
+
+    /* Enable dyld image monitoring */
+    plcrash_nasync_image_list_init(&profiler_image_list, mach_task_self());
+    _dyld_register_func_for_add_image(profiler_image_add_callback);
+    _dyld_register_func_for_remove_image(profiler_image_remove_callback);
+}
+
+/**
+ * Initialize a new profiler instance, using the default sample and node capacities.
+ *
+ * @param threads The threads to be sampled. The profiler acquires its own reference to each thread port.
+ * @param count The number of entries in @a threads.
+ * @param samplingInterval The interval between samples, in seconds.
+ */
+- (instancetype) initWithThreads: (const thread_t *) threads count: (NSUInteger) count samplingInterval: (NSTimeInterval) samplingInterval {
+    return [self initWithThreads: threads
+                           count: count
+                samplingInterval: samplingInterval
+                  sampleCapacity: PLCRASH_PROFILER_DEFAULT_SAMPLE_CAPACITY
+                    nodeCapacity: PLCRASH_PROFILER_DEFAULT_NODE_CAPACITY];
+}
+
+/**
+ * Initialize a new profiler instance.
+ *
+ * All sample storage is preallocated; if more than @a sampleCapacity samples are buffered before they can be
+ * aggregated, or if the profile exceeds @a nodeCapacity unique call path nodes, additional samples are dropped and
+ * counted in PLCrashProfiler::droppedSampleCount.
+ *
+ * @param threads The threads to be sampled. The profiler acquires its own reference to each thread port.
+ * @param count The number of entries in @a threads.
+ * @param samplingInterval The interval between samples, in seconds.
+ * @param sampleCapacity The number of samples that may be buffered between aggregation passes.
+ * @param nodeCapacity The maximum number of unique call path nodes that may be recorded.
+ *
+ * @return Returns nil if the sample storage could not be allocated.
+ */
+- (instancetype) initWithThreads: (const thread_t *) threads
+                           count: (NSUInteger) count
+                samplingInterval: (NSTimeInterval) samplingInterval
+                  sampleCapacity: (NSUInteger) sampleCapacity
+                    nodeCapacity: (NSUInteger) nodeCapacity
+{
+    if ((self = [super init]) == nil)
+        return nil;
+
+    _samplingInterval = samplingInterval;
+
+    _state = calloc(1, sizeof(_PLCrashProfilerState));
+    if (_state == NULL) {
+        [self release];
+        return nil;
+    }
+
+    pthread_mutex_init(&_state->trie_lock, NULL);
+
+    /* Convert the interval to mach_absolute_time() units */
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+    _state->interval_abs = (uint64_t) ((samplingInterval * NSEC_PER_SEC) * timebase.denom / timebase.numer);
+    if (_state->interval_abs == 0)
+        _state->interval_abs = 1;
+
+    /* Acquire a reference to each thread */
+    _state->threads = calloc(count, sizeof(thread_t));
+    _state->thread_count = (uint32_t) count;
+    for (NSUInteger i = 0; i < count; i++) {
+        _state->threads[i] = threads[i];
+        mach_port_mod_refs(mach_task_self(), threads[i], MACH_PORT_RIGHT_SEND, 1);
+    }
+
+    /* Preallocate the sample storage */
+    if (plcrash_async_sample_ring_init(&_state->ring, (uint32_t) MIN(sampleCapacity, UINT32_MAX)) != PLCRASH_ESUCCESS ||
+        plcrash_async_stack_trie_init(&_state->trie, (uint32_t) MIN(nodeCapacity, UINT32_MAX)) != PLCRASH_ESUCCESS)
+    {
+        [self release];
+        return nil;
+    }
+
+    return self;
+}
+
+- (void) dealloc {
+    if (_state != NULL) {
+        [self stop];
+
+        for (uint32_t i = 0; i < _state->thread_count; i++)
+            mach_port_deallocate(mach_task_self(), _state->threads[i]);
+
+        plcrash_async_sample_ring_free(&_state->ring);
+        plcrash_async_stack_trie_free(&_state->trie);
+        pthread_mutex_destroy(&_state->trie_lock);
+
+        free(_state->threads);
+        free(_state);
+    }
+
+    [super dealloc];
+}
+
+/**
+ * Start sampling. Samples are added to any previously recorded samples; use PLCrashProfiler::reset to discard them.
+ *
+ * @param outError A pointer to an NSError object variable. If an error occurs, this pointer will contain an error
+ * object indicating why sampling could not be started. If no error occurs, this parameter will be left unmodified.
+ * You may specify nil for this parameter, and no error information will be provided.
+ *
+ * @return Returns YES on success, or NO if the profiler is already running or the sampler thread could not be
+ * started.
+ */
+- (BOOL) startAndReturnError: (NSError **) outError {
+    if (_state->running) {
+        plcrash_populate_error(outError, PLCrashReporterErrorResourceBusy, @"The profiler is already running", nil);
+        return NO;
+    }
+
+    _state->should_stop = 0;
+    _state->start_abs = mach_absolute_time();
+    if (_state->timestamp == 0)
+        _state->timestamp = time(NULL);
+
+    int err = pthread_create(&_state->sampler, NULL, plcrash_profiler_sampler_thread, _state);
+    if (err != 0) {
+        plcrash_populate_posix_error(outError, err, @"Could not start the profiler sampling thread");
+        return NO;
+    }
+
+    _state->running = true;
+    return YES;
+}
+
+/**
+ * Stop sampling, waiting for the sampler thread to exit. Recorded samples are retained. If the profiler is not
+ * running, this method has no effect.
+ */
+- (void) stop {
+    if (!_state->running)
+        return;
+
+    OSAtomicCompareAndSwap32Barrier(0, 1, (int32_t *) &_state->should_stop);
+    pthread_join(_state->sampler, NULL);
+
+    _state->elapsed_abs += mach_absolute_time() - _state->start_abs;
+    _state->running = false;
+}
+
+/**
+ * Discard all recorded samples.
+ */
+- (void) reset {
+    pthread_mutex_lock(&_state->trie_lock); {
+        plcrash_profiler_drain(_state);
+        plcrash_async_stack_trie_reset(&_state->trie);
+        _state->ring_dropped_base = plcrash_async_sample_ring_dropped(&_state->ring);
+
+        _state->elapsed_abs = 0;
+        _state->start_abs = mach_absolute_time();
+        _state->timestamp = _state->running ? time(NULL) : 0;
+    } pthread_mutex_unlock(&_state->trie_lock);
+}
+
+- (BOOL) isRunning {
+    return _state->running;
+}
+
+- (NSUInteger) sampleCount {
+    NSUInteger count;
+
+    pthread_mutex_lock(&_state->trie_lock); {
+        plcrash_profiler_drain(_state);
+        count = _state->trie.sample_count;
+    } pthread_mutex_unlock(&_state->trie_lock);
+
+    return count;
+}
+
+- (NSUInteger) droppedSampleCount {
+    NSUInteger count;
+
+    pthread_mutex_lock(&_state->trie_lock); {
+        plcrash_profiler_drain(_state);
+        count = _state->trie.dropped_count + (plcrash_async_sample_ring_dropped(&_state->ring) - _state->ring_dropped_base);
+    } pthread_mutex_unlock(&_state->trie_lock);
+
+    return count;
+}
+
+/**
+ * Symbolicate the recorded samples, and return the aggregated profile. Sampling continues while the profile is
+ * exported.
+ *
+ * @param outError A pointer to an NSError object variable. If an error occurs, this pointer will contain an error
+ * object indicating why the profile could not be generated. If no error occurs, this parameter will be left
+ * unmodified. You may specify nil for this parameter, and no error information will be provided.
+ *
+ * @return Returns the profile data, as defined by profile.proto, or nil if an error occurs.
+ */
+- (NSData *) profileDataAndReturnError: (NSError **) outError {
+    /* Snapshot the aggregated samples; symbolication is performed without holding the trie lock, allowing the sampler
+     * to continue aggregating. */
+    NSMutableData *nodeData;
+    uint32_t node_count;
+    uint32_t sample_count;
+    uint32_t dropped_count;
+    uint64_t elapsed_abs;
+    time_t timestamp;
+
+    pthread_mutex_lock(&_state->trie_lock); {
+        plcrash_profiler_drain(_state);
+
+        node_count = _state->trie.count;
+        nodeData = [NSMutableData dataWithBytes: _state->trie.nodes length: node_count * sizeof(plcrash_async_stack_trie_node_t)];
+        sample_count = _state->trie.sample_count;
+        dropped_count = _state->trie.dropped_count + (plcrash_async_sample_ring_dropped(&_state->ring) - _state->ring_dropped_base);
+
+        elapsed_abs = _state->elapsed_abs;
+        if (_state->running)
+            elapsed_abs += mach_absolute_time() - _state->start_abs;
+        timestamp = _state->timestamp;
+    } pthread_mutex_unlock(&_state->trie_lock);
+
+    const plcrash_async_stack_trie_node_t *trie_nodes = [nodeData bytes];
+
+    /* Assign output indices, omitting nodes with no samples (left behind by stacks that could not be recorded). A
+     * node's parent always precedes it, and a parent's total count is never less than that of its children. */
+    uint32_t *output_index = calloc(node_count, sizeof(uint32_t));
+    struct plcrash_profile_node *nodes = calloc(node_count, sizeof(struct plcrash_profile_node));
+    uint32_t output_count = 0;
+
+    NSMutableArray *symbolNames = [NSMutableArray array];
+    NSMutableArray *symbolAddresses = [NSMutableArray array];
+    NSMutableDictionary *symbolIndices = [NSMutableDictionary dictionary];
+    NSMutableArray *images = [NSMutableArray array];
+    NSMutableDictionary *imageIndices = [NSMutableDictionary dictionary];
+
+    plcrash_async_symbol_cache_t symbol_cache;
+    if (plcrash_async_symbol_cache_init(&symbol_cache) != PLCRASH_ESUCCESS) {
+        plcrash_populate_error(outError, PLCrashReporterErrorUnknown, @"Failed to initialize the symbol cache", nil);
+        free(output_index);
+        free(nodes);
+        return nil;
+    }
+
+    plcrash_async_image_list_set_reading(&profiler_image_list, true);
+    for (uint32_t i = 1; i < node_count; i++) {
+        const plcrash_async_stack_trie_node_t *trie_node = &trie_nodes[i];
+        if (trie_node->total_count == 0)
+            continue;
+
+        struct plcrash_profile_node *node = &nodes[output_count];
+        output_index[i] = ++output_count;
+
+        node->parent = output_index[trie_node->parent];
+        node->pc = trie_node->pc;
+        node->is_thread = (trie_node->parent == PLCRASH_ASYNC_STACK_TRIE_ROOT);
+        node->image = UINT32_MAX;
+        node->symbol = UINT32_MAX;
+        node->self_count = trie_node->self_count;
+        node->total_count = trie_node->total_count;
+
+        if (node->is_thread)
+            continue;
+
+        /* Resolve the image and symbol */
+        plcrash_async_image_t *image = plcrash_async_image_containing_address(&profiler_image_list, (pl_vm_address_t) node->pc);
+        if (image == NULL)
+            continue;
+
+        NSNumber *imageKey = [NSNumber numberWithUnsignedLongLong: image->macho_image.header_addr];
+        NSNumber *imageIndex = [imageIndices objectForKey: imageKey];
+        if (imageIndex == nil) {
+            imageIndex = [NSNumber numberWithUnsignedInt: (uint32_t) [images count]];
+            [imageIndices setObject: imageIndex forKey: imageKey];
+            [images addObject: [NSValue valueWithPointer: image]];
+        }
+        node->image = [imageIndex unsignedIntValue];
+
+        struct plcrash_profile_symbol_ctx ctx = { 0, nil };
+        if (plcrash_async_find_symbol(&image->macho_image, PLCRASH_ASYNC_SYMBOL_STRATEGY_ALL, &symbol_cache, (pl_vm_address_t) node->pc, plcrash_profile_found_symbol_cb, &ctx) != PLCRASH_ESUCCESS || ctx.name == nil)
+            continue;
+
+        NSNumber *symbolKey = [NSNumber numberWithUnsignedLongLong: ctx.address];
+        NSNumber *symbolIndex = [symbolIndices objectForKey: symbolKey];
+        if (symbolIndex == nil) {
+            symbolIndex = [NSNumber numberWithUnsignedInt: (uint32_t) [symbolNames count]];
+            [symbolIndices setObject: symbolIndex forKey: symbolKey];
+            [symbolNames addObject: ctx.name];
+            [symbolAddresses addObject: symbolKey];
+        }
+        node->symbol = [symbolIndex unsignedIntValue];
+    }
+
+    /* Initialize the output buffer */
+    plcrash_async_file_t file;
+    NSData *data = nil;
+    size_t expected = 0;
+
+    if (plcrash_async_file_init_growable(&file, PROFILE_INITIAL_BYTES, MAX_PROFILE_BYTES) != PLCRASH_ESUCCESS) {
+        plcrash_populate_error(outError, PLCrashReporterErrorOperatingSystem, @"Failed to allocate the profile buffer", nil);
+        plcrash_async_image_list_set_reading(&profiler_image_list, false);
+        goto cleanup;
+    }
+
+    /* Write the file header */
+    {
+        uint8_t version = PLCRASH_PROFILE_FILE_VERSION;
+
+        plcrash_async_file_write(&file, PLCRASH_PROFILE_FILE_MAGIC, strlen(PLCRASH_PROFILE_FILE_MAGIC));
+        plcrash_async_file_write(&file, &version, sizeof(version));
+        expected += strlen(PLCRASH_PROFILE_FILE_MAGIC) + sizeof(version);
+    }
+
+    /* Info */
+    {
+        mach_timebase_info_data_t timebase;
+        mach_timebase_info(&timebase);
+
+        uint64_t interval_ns = (uint64_t) (_samplingInterval * NSEC_PER_SEC);
+        uint64_t duration_ns = elapsed_abs * timebase.numer / timebase.denom;
+
+        uint32_t size = (uint32_t) plcrash_profile_write_info(NULL, interval_ns, duration_ns, sample_count, dropped_count, timestamp);
+        expected += plcrash_writer_pack(&file, PLCRASH_PROTO_PROFILE_INFO_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
+        expected += plcrash_profile_write_info(&file, interval_ns, duration_ns, sample_count, dropped_count, timestamp);
+    }
+
+    /* Threads. The name is fetched via the thread port, for which we hold a send right; the thread's pthread_t
+     * can not be used, as the thread may have since exited. */
+    for (uint32_t i = 0; i < _state->thread_count; i++) {
+        thread_extended_info_data_t info;
+        mach_msg_type_number_t info_count = THREAD_EXTENDED_INFO_COUNT;
+        const char *name = NULL;
+
+        if (thread_info(_state->threads[i], THREAD_EXTENDED_INFO, (thread_info_t) &info, &info_count) == KERN_SUCCESS) {
+            info.pth_name[sizeof(info.pth_name) - 1] = '\0';
+            name = info.pth_name;
+        }
+
+        uint32_t size = (uint32_t) plcrash_profile_write_thread(NULL, i, name);
+        expected += plcrash_writer_pack(&file, PLCRASH_PROTO_PROFILE_THREADS_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
+        expected += plcrash_profile_write_thread(&file, i, name);
+    }
+
+    /* Images */
+    for (NSValue *value in images) {
+        plcrash_async_image_t *image = [value pointerValue];
+
+        uint32_t size = (uint32_t) plcrash_profile_write_image(NULL, &image->macho_image);
+        expected += plcrash_writer_pack(&file, PLCRASH_PROTO_PROFILE_IMAGES_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
+        expected += plcrash_profile_write_image(&file, &image->macho_image);
+    }
+    plcrash_async_image_list_set_reading(&profiler_image_list, false);
+
+    /* Symbols */
+    for (NSUInteger i = 0; i < [symbolNames count]; i++) {
+        const char *name = [[symbolNames objectAtIndex: i] UTF8String];
+        uint64_t address = [[symbolAddresses objectAtIndex: i] unsignedLongLongValue];
+
+        uint32_t size = (uint32_t) plcrash_profile_write_symbol(NULL, name, address);
+        expected += plcrash_writer_pack(&file, PLCRASH_PROTO_PROFILE_SYMBOLS_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
+        expected += plcrash_profile_write_symbol(&file, name, address);
+    }
+
+    /* Nodes */
+    for (uint32_t i = 0; i < output_count; i++) {
+        uint32_t size = (uint32_t) plcrash_profile_write_node(NULL, &nodes[i]);
+        expected += plcrash_writer_pack(&file, PLCRASH_PROTO_PROFILE_NODES_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
+        expected += plcrash_profile_write_node(&file, &nodes[i]);
+    }
+
+    /* Hand the buffer off to a CFData instance; any dropped write (eg, due to MAX_PROFILE_BYTES) leaves the buffer
+     * short of the expected length. */
+    size_t length;
+    size_t allocationSize;
+    void *bytes = plcrash_async_file_buffer_detach(&file, &length, &allocationSize);
+    plcrash_async_file_close(&file);
+
+    if (bytes == NULL || length != expected) {
+        plcrash_populate_error(outError, PLCrashReporterErrorUnknown, @"Failed to write the profile", nil);
+        if (bytes != NULL)
+            vm_deallocate(mach_task_self(), (vm_address_t) bytes, allocationSize);
+        goto cleanup;
+    }
+
+    CFAllocatorContext allocatorContext = {
+        .version = 0,
+        .info = (void *) (uintptr_t) allocationSize,
+        .deallocate = plcrash_profile_data_deallocate
+    };
+    CFAllocatorRef deallocator = CFAllocatorCreate(kCFAllocatorDefault, &allocatorContext);
+    if (deallocator != NULL)
+        data = [(NSData *) CFDataCreateWithBytesNoCopy(kCFAllocatorDefault, bytes, (CFIndex) length, deallocator) autorelease];
+
+    if (data == nil) {
+        vm_deallocate(mach_task_self(), (vm_address_t) bytes, allocationSize);
+        plcrash_populate_error(outError, PLCrashReporterErrorOperatingSystem, @"Failed to allocate the profile data", nil);
+    }
+
+    if (deallocator != NULL)
+        CFRelease(deallocator);
+
+cleanup:
+    plcrash_async_symbol_cache_free(&symbol_cache);
+    free(output_index);
+    free(nodes);
+
+    return data;
+}
+
+@end
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "SenTestCompat.h"
+
+#import "PLCrashProfiler.h"
+
+#import <pthread.h>
+
+/* Set to request that the spinning test thread exit. */
+static volatile bool spin_should_stop;
+
+/* Busy loop; this is not static, to ensure that it's visible to symbol table symbolication */
+void plcrash_profiler_test_spin (void) __attribute__((noinline));
+void plcrash_profiler_test_spin (void) {
+    while (!spin_should_stop)
+        __asm__ __volatile__ ("");
+}
+
+static void *spin_thread (void *arg) {
+    pthread_setname_np("plcrash.profiler.test");
+    plcrash_profiler_test_spin();
+    return NULL;
+}
+
+@interface PLCrashProfilerTests : SenTestCase {
+@private
+    /** The spinning test thread. */
+    pthread_t _thread;
+
+    /** The profiler under test, sampling _thread. */
+    PLCrashProfiler *_profiler;
+}
+@end
+
+@implementation PLCrashProfilerTests
+
+- (void) setUp {
+    spin_should_stop = false;
+    STAssertEquals(0, pthread_create(&_thread, NULL, spin_thread, NULL), @"Failed to start test thread");
+
+    thread_t thread = pthread_mach_thread_np(_thread);
+    _profiler = [[PLCrashProfiler alloc] initWithThreads: &thread count: 1 samplingInterval: 0.001];
+    STAssertNotNil(_profiler, @"Failed to initialize profiler");
+}
+
+- (void) tearDown {
+    [_profiler release];
+
+    spin_should_stop = true;
+    pthread_join(_thread, NULL);
+}
+
+/**
+ * Wait for at least @a count samples to be recorded.
+ */
+- (void) waitForSamples: (NSUInteger) count {
+    for (int i = 0; i < 500 && [_profiler sampleCount] < count; i++)
+        usleep(10 * 1000);
+}
+
+/**
+ * Verify starting and stopping the profiler.
+ */
+- (void) testStartStop {
+    NSError *error;
+
+    STAssertFalse([_profiler isRunning], @"Profiler should not be running");
+    STAssertTrue([_profiler startAndReturnError: &error], @"Failed to start profiler: %@", error);
+    STAssertTrue([_profiler isRunning], @"Profiler should be running");
+
+    /* A running profiler can not be started again */
+    STAssertFalse([_profiler startAndReturnError: NULL], @"Started a running profiler");
+
+    [self waitForSamples: 10];
+    [_profiler stop];
+    STAssertFalse([_profiler isRunning], @"Profiler should not be running");
+
+    /* No further samples are recorded once stopped */
+    NSUInteger count = [_profiler sampleCount];
+    STAssertTrue(count >= 10, @"Too few samples were recorded: %lu", (unsigned long) count);
+    usleep(20 * 1000);
+    STAssertEquals(count, [_profiler sampleCount], @"Samples were recorded after stopping");
+
+    [_profiler reset];
+    STAssertEquals((NSUInteger) 0, [_profiler sampleCount], @"Reset did not discard samples");
+}
+
+/**
+ * Verify that the exported profile is well-formed, and includes the symbolicated sampled function.
+ */
+- (void) testProfileData {
+    NSError *error;
+
+    STAssertTrue([_profiler startAndReturnError: &error], @"Failed to start profiler: %@", error);
+    [self waitForSamples: 10];
+    [_profiler stop];
+
+    NSData *data = [_profiler profileDataAndReturnError: &error];
+    STAssertNotNil(data, @"Failed to export profile: %@", error);
+
+    /* Verify the file header */
+    size_t magic_len = strlen(PLCRASH_PROFILE_FILE_MAGIC);
+    STAssertTrue([data length] > magic_len + 1, @"Profile is too short");
+    STAssertTrue(memcmp([data bytes], PLCRASH_PROFILE_FILE_MAGIC, magic_len) == 0, @"Incorrect magic");
+    STAssertEquals(((const uint8_t *) [data bytes])[magic_len], (uint8_t) PLCRASH_PROFILE_FILE_VERSION, @"Incorrect version");
+
+    /* Verify that the sampled function and thread name were written */
+    NSData *symbol = [@"plcrash_profiler_test_spin" dataUsingEncoding: NSUTF8StringEncoding];
+    STAssertTrue([data rangeOfData: symbol options: 0 range: NSMakeRange(0, [data length])].location != NSNotFound, @"Sampled function was not symbolicated");
+
+    NSData *name = [@"plcrash.profiler.test" dataUsingEncoding: NSUTF8StringEncoding];
+    STAssertTrue([data rangeOfData: name options: 0 range: NSMakeRange(0, [data length])].location != NSNotFound, @"Thread name was not written");
+}
+
+/**
+ * Verify that samples are dropped and counted when the profile is full.
+ */
+- (void) testDroppedSamples {
+    thread_t thread = pthread_mach_thread_np(_thread);
+    PLCrashProfiler *profiler = [[[PLCrashProfiler alloc] initWithThreads: &thread count: 1 samplingInterval: 0.001 sampleCapacity: 4 nodeCapacity: 2] autorelease];
+    STAssertNotNil(profiler, @"Failed to initialize profiler");
+
+    STAssertTrue([profiler startAndReturnError: NULL], @"Failed to start profiler");
+    for (int i = 0; i < 500 && [profiler droppedSampleCount] == 0; i++)
+        usleep(10 * 1000);
+    [profiler stop];
+
+    STAssertTrue([profiler droppedSampleCount] > 0, @"Dropped samples were not counted");
+    STAssertEquals((NSUInteger) 0, [profiler sampleCount], @"No sample should fit within the profile");
+}
+
+@end
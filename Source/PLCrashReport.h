@@ -73,6 +73,67 @@ struct PLCrashReportFileHeader {
     const uint8_t data[];
 } __attribute__((packed));
 
+/**
+ * @ingroup constants
+ * The byte offset of the report fingerprint within a crash report file.
+ *
+ * If a fingerprint was written, it is encoded as the first field of the report's ReportInfo message, which
+ * immediately follows the file header. The fingerprint may then be read directly from the report file as a
+ * 64-bit little-endian value, without decoding the report; the fingerprint is present if the bytes at
+ * #PLCRASH_REPORT_FILE_REPORT_INFO_TAG_OFFSET and #PLCRASH_REPORT_FILE_FINGERPRINT_TAG_OFFSET match
+ * #PLCRASH_REPORT_FILE_REPORT_INFO_TAG and #PLCRASH_REPORT_FILE_FINGERPRINT_TAG.
+ *
+ * @sa PLCrashReport::fingerprintFromData:fingerprint:
+ */
+#define PLCRASH_REPORT_FILE_FINGERPRINT_OFFSET 11
+
+/**
+ * @ingroup constants
+ * The byte offset of the ReportInfo message key within a crash report file.
+ */
+#define PLCRASH_REPORT_FILE_REPORT_INFO_TAG_OFFSET 8
+
+/**
+ * @ingroup constants
+ * The encoded ReportInfo message key (field 9, length-delimited).
+ */
+#define PLCRASH_REPORT_FILE_REPORT_INFO_TAG 0x4A
+
+/**
+ * @ingroup constants
+ * The byte offset of the fingerprint field key within a crash report file.
+ */
+#define PLCRASH_REPORT_FILE_FINGERPRINT_TAG_OFFSET 10
+
+/**
+ * @ingroup constants
+ * The encoded ReportInfo.fingerprint field key (field 4, 64-bit).
+ */
+#define PLCRASH_REPORT_FILE_FINGERPRINT_TAG 0x21
+
+
+/**
+ * Crash report types.
+ *
+ * @ingroup enums
+ */
+typedef NS_ENUM(NSUInteger, PLCrashReportType) {
+    /** The report type is unknown. */
+    PLCrashReportTypeUnknown = 0,
+
+    /** A report generated due to a fatal signal or Mach exception. */
+    PLCrashReportTypeCrash = 1,
+
+    /** A report generated due to an uncaught language exception. */
+    PLCrashReportTypeLanguageException = 2,
+
+    /** A report generated due to a watchdog event, such as a main thread stall. The responsible thread
+     * is marked as the crashed thread. The process was not necessarily terminated. */
+    PLCrashReportTypeWatchdog = 3,
+
+    /** A live report generated on request, where no crash occurred. */
+    PLCrashReportTypeLive = 4
+};
 
 /**
  * @internal
@@ -114,8 +175,19 @@ typedef struct _PLCrashReportDecoder _PLCrashReportDecoder;
 
     /** Report UUID */
     CFUUIDRef _uuid;
+
+    /** Report type */
+    PLCrashReportType _reportType;
+
+    /** YES if a fingerprint is available */
+    BOOL _hasFingerprint;
+
+    /** Report fingerprint */
+    uint64_t _fingerprint;
 }
 
++ (BOOL) fingerprintFromData: (NSData *) encodedData fingerprint: (uint64_t *) fingerprint;
+
 - (id) initWithData: (NSData *) encodedData error: (NSError **) outError;
 
 - (PLCrashReportBinaryImageInfo *) imageForAddress: (uint64_t) address;
@@ -197,4 +269,22 @@ typedef struct _PLCrashReportDecoder _PLCrashReportDecoder;
  */
 @property(nonatomic, readonly) CFUUIDRef uuidRef;
 
+/**
+ * The report type. Reports written by earlier releases do not record a type; for these reports, the type
+ * is inferred from the user-requested flag and the presence of exception information.
+ */
+@property(nonatomic, readonly) PLCrashReportType reportType;
+
+/**
+ * YES if a report fingerprint is available.
+ */
+@property(nonatomic, readonly) BOOL hasFingerprint;
+
+/**
+ * A stable 64-bit fingerprint of the crash, computed when the report was written from the image UUIDs and
+ * image-relative PCs of the top frames of the crashed thread, and the signal number and code. Reports with the
+ * same fingerprint may be grouped as duplicates without symbolication. Only available if hasFingerprint is YES.
+ */
+@property(nonatomic, readonly) uint64_t fingerprint;
+
 @end
@@ -31,13 +31,52 @@
 
 #import "crash_report.pb-c.h"
 
+#import <stdatomic.h>
+
+/**
+ * @internal
+ *
+ * A single entry in the binary image address index. Entries are sorted by start address and never overlap.
+ */
+typedef struct plcr_image_range {
+    /** The normalized start address (inclusive). */
+    uint64_t start;
+
+    /** The end address (exclusive). */
+    uint64_t end;
+
+    /** The index of the image within the report's image list. */
+    NSUInteger image_index;
+} plcr_image_range_t;
+
+/**
+ * @internal
+ *
+ * The binary image address index.
+ */
+typedef struct plcr_image_index {
+    /** Number of entries in ranges. */
+    NSUInteger count;
+
+    /** Non-overlapping address ranges, sorted by start address. */
+    plcr_image_range_t ranges[];
+} plcr_image_index_t;
+
 struct _PLCrashReportDecoder {
     Plcrash__CrashReport *crashReport;
+
+    /** The report's string table entries, as NSString instances. */
+    NSArray *strings;
+
+    /** The image address index, or NULL if not yet built. Once published, the index is immutable. */
+    _Atomic(plcr_image_index_t *) image_index;
 };
 
 @interface PLCrashReport (PrivateMethods)
 
 - (Plcrash__CrashReport *) decodeCrashData: (NSData *) data error: (NSError **) outError;
+- (NSArray *) extractStringTable: (Plcrash__CrashReport__StringTable *) stringTable;
+- (NSString *) stringWithValue: (const char *) string index: (uint32_t) index hasIndex: (protobuf_c_boolean) hasIndex;
 - (PLCrashReportSystemInfo *) extractSystemInfo: (Plcrash__CrashReport__SystemInfo *) systemInfo
                                   processorInfo: (PLCrashReportProcessorInfo *) processorInfo
                                           error: (NSError **) outError;
@@ -51,12 +90,214 @@ struct _PLCrashReportDecoder {
 - (PLCrashReportExceptionInfo *) extractExceptionInfo: (Plcrash__CrashReport__Exception *) exceptionInfo error: (NSError **) outError;
 - (PLCrashReportSignalInfo *) extractSignalInfo: (Plcrash__CrashReport__Signal *) signalInfo error: (NSError **) outError;
 - (PLCrashReportMachExceptionInfo *) extractMachExceptionInfo: (Plcrash__CrashReport__Signal__MachException *) machExceptionInfo error: (NSError **) outError;
+- (plcr_image_index_t *) buildImageIndex;
 
 @end
 
 
 static void populate_nserror (NSError **error, PLCrashReporterError code, NSString *description);
 
+/**
+ * @internal
+ *
+ * Normalize an image base address, stripping any pointer authentication bits.
+ */
+static inline uint64_t plcr_normalize_image_address (uint64_t address) {
+#if __DARWIN_OPAQUE_ARM_THREAD_STATE64
+    address &= 0x0000000fffffffff;
+#endif
+    return address;
+}
+
+/**
+ * @internal
+ *
+ * qsort() comparator for plcr_image_range_t; sorts by start address, then by image index.
+ */
+static int plcr_image_range_compare (const void *lhs, const void *rhs) {
+    const plcr_image_range_t *a = lhs;
+    const plcr_image_range_t *b = rhs;
+
+    if (a->start != b->start)
+        return a->start < b->start ? -1 : 1;
+
+    if (a->image_index != b->image_index)
+        return a->image_index < b->image_index ? -1 : 1;
+
+    return 0;
+}
+
+/**
+ * @internal
+ *
+ * qsort() comparator for uint64_t addresses.
+ */
+static int plcr_address_compare (const void *lhs, const void *rhs) {
+    uint64_t a = *(const uint64_t *) lhs;
+    uint64_t b = *(const uint64_t *) rhs;
+
+    if (a != b)
+        return a < b ? -1 : 1;
+
+    return 0;
+}
+
+/**
+ * @internal
+ *
+ * Push @a value onto the binary min-heap @a heap of @a count entries, ordered by the image index of the
+ * corresponding entry in @a images.
+ */
+static void plcr_image_heap_push (NSUInteger *heap, NSUInteger *count, const plcr_image_range_t *images, NSUInteger value) {
+    NSUInteger i = (*count)++;
+    while (i > 0) {
+        NSUInteger parent = (i - 1) / 2;
+        if (images[heap[parent]].image_index <= images[value].image_index)
+            break;
+
+        heap[i] = heap[parent];
+        i = parent;
+    }
+    heap[i] = value;
+}
+
+/**
+ * @internal
+ *
+ * Remove the minimum entry from the binary min-heap @a heap of @a count entries.
+ */
+static void plcr_image_heap_pop (NSUInteger *heap, NSUInteger *count, const plcr_image_range_t *images) {
+    NSUInteger value = heap[--(*count)];
+    NSUInteger i = 0;
+    for (;;) {
+        NSUInteger child = i * 2 + 1;
+        if (child >= *count)
+            break;
+
+        if (child + 1 < *count && images[heap[child + 1]].image_index < images[heap[child]].image_index)
+            child++;
+
+        if (images[value].image_index <= images[heap[child]].image_index)
+            break;
+
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = value;
+}
+
+/**
+ * @internal
+ *
+ * Build a non-overlapping image address index from @a count non-empty image ranges. Where image ranges overlap,
+ * each address is assigned to the overlapping image with the lowest image index; adjacent addresses assigned to
+ * the same image are merged into a single entry.
+ *
+ * The address space is split at every image start and end address, and swept in address order, with the images
+ * containing the current address held in a min-heap ordered by image index.
+ *
+ * @param images The image ranges. These will be sorted in place.
+ * @param count The number of entries in @a images.
+ *
+ * @return Returns the new index, which must be freed via free(), or NULL if the index can not be allocated.
+ */
+static plcr_image_index_t *plcr_image_index_create (plcr_image_range_t *images, NSUInteger count) {
+    /* Each image start or end address may begin at most one new entry */
+    NSUInteger capacity = count * 2;
+    plcr_image_index_t *index = malloc(sizeof(plcr_image_index_t) + sizeof(plcr_image_range_t) * capacity);
+    if (index == NULL)
+        return NULL;
+    index->count = 0;
+
+    if (count == 0)
+        return index;
+
+    uint64_t *bounds = malloc(sizeof(uint64_t) * capacity);
+    NSUInteger *heap = malloc(sizeof(NSUInteger) * count);
+    if (bounds == NULL || heap == NULL) {
+        free(bounds);
+        free(heap);
+        free(index);
+        return NULL;
+    }
+
+    /* Sort the images and their (unique) bounding addresses */
+    qsort(images, count, sizeof(plcr_image_range_t), plcr_image_range_compare);
+
+    NSUInteger boundCount = 0;
+    for (NSUInteger i = 0; i < count; i++) {
+        bounds[boundCount++] = images[i].start;
+        bounds[boundCount++] = images[i].end;
+    }
+    qsort(bounds, boundCount, sizeof(uint64_t), plcr_address_compare);
+
+    NSUInteger uniqueCount = 0;
+    for (NSUInteger i = 0; i < boundCount; i++) {
+        if (uniqueCount == 0 || bounds[uniqueCount - 1] != bounds[i])
+            bounds[uniqueCount++] = bounds[i];
+    }
+
+    /* Sweep each interval between adjacent bounds, assigning it to the lowest-indexed image that contains it */
+    NSUInteger heapCount = 0;
+    NSUInteger next = 0;
+    for (NSUInteger i = 0; i + 1 < uniqueCount; i++) {
+        uint64_t start = bounds[i];
+        uint64_t end = bounds[i + 1];
+
+        while (next < count && images[next].start <= start)
+            plcr_image_heap_push(heap, &heapCount, images, next++);
+
+        /* Discard any images that end at or before this interval */
+        while (heapCount > 0 && images[heap[0]].end <= start)
+            plcr_image_heap_pop(heap, &heapCount, images);
+
+        if (heapCount == 0)
+            continue;
+
+        /* Extend the previous entry if it is adjacent and refers to the same image */
+        NSUInteger imageIndex = images[heap[0]].image_index;
+        plcr_image_range_t *last = index->count > 0 ? &index->ranges[index->count - 1] : NULL;
+        if (last != NULL && last->end == start && last->image_index == imageIndex) {
+            last->end = end;
+            continue;
+        }
+
+        index->ranges[index->count].start = start;
+        index->ranges[index->count].end = end;
+        index->ranges[index->count].image_index = imageIndex;
+        index->count++;
+    }
+
+    free(bounds);
+    free(heap);
+
+    return index;
+}
+
+/**
+ * @internal
+ *
+ * Return the index entry containing @a address, or NULL if none.
+ */
+static const plcr_image_range_t *plcr_image_index_lookup (const plcr_image_index_t *index, uint64_t address) {
+    /* Find the number of entries with a start address <= address */
+    NSUInteger low = 0;
+    NSUInteger high = index->count;
+    while (low < high) {
+        NSUInteger mid = low + (high - low) / 2;
+        if (index->ranges[mid].start <= address)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    /* Entries don't overlap; only the last entry starting at or before the address may contain it */
+    if (low == 0 || address >= index->ranges[low - 1].end)
+        return NULL;
+
+    return &index->ranges[low - 1];
+}
+
 /**
  * Provides decoding of crash logs generated by the PLCrashReporter framework.
  *
@@ -64,6 +305,45 @@ static void populate_nserror (NSError **error, PLCrashReporterError code, NSStri
  */
 @implementation PLCrashReport
 
+/**
+ * Read the report fingerprint directly from the provided crash log data, without decoding the report.
+ *
+ * @param encodedData Encoded plcrash crash log.
+ * @param fingerprint On success, will be set to the report's fingerprint.
+ *
+ * @return Returns YES if the report contains a fingerprint, or NO if the data is not a crash log, or the
+ * report was written without a fingerprint.
+ *
+ * @sa PLCRASH_REPORT_FILE_FINGERPRINT_OFFSET
+ */
++ (BOOL) fingerprintFromData: (NSData *) encodedData fingerprint: (uint64_t *) fingerprint {
+    const uint8_t *bytes = [encodedData bytes];
+
+    if ([encodedData length] < PLCRASH_REPORT_FILE_FINGERPRINT_OFFSET + sizeof(uint64_t))
+        return NO;
+
+    /* Verify the header and the field keys preceding the fingerprint */
+    if (memcmp(bytes, PLCRASH_REPORT_FILE_MAGIC, strlen(PLCRASH_REPORT_FILE_MAGIC)) != 0)
+        return NO;
+
+    if (bytes[strlen(PLCRASH_REPORT_FILE_MAGIC)] != PLCRASH_REPORT_FILE_VERSION)
+        return NO;
+
+    if (bytes[PLCRASH_REPORT_FILE_REPORT_INFO_TAG_OFFSET] != PLCRASH_REPORT_FILE_REPORT_INFO_TAG ||
+        bytes[PLCRASH_REPORT_FILE_FINGERPRINT_TAG_OFFSET] != PLCRASH_REPORT_FILE_FINGERPRINT_TAG)
+    {
+        return NO;
+    }
+
+    /* The fingerprint is encoded little-endian */
+    uint64_t value = 0;
+    for (size_t i = 0; i < sizeof(value); i++)
+        value |= ((uint64_t) bytes[PLCRASH_REPORT_FILE_FINGERPRINT_OFFSET + i]) << (i * 8);
+
+    *fingerprint = value;
+    return YES;
+}
+
 /**
  * Initialize with the provided crash log data. On error, nil will be returned, and
  * an NSError instance will be provided via @a error, if non-NULL.
@@ -87,6 +367,8 @@ static void populate_nserror (NSError **error, PLCrashReporterError code, NSStri
 
     /* Allocate the struct and attempt to parse */
     _decoder = malloc(sizeof(_PLCrashReportDecoder));
+    _decoder->strings = nil;
+    atomic_init(&_decoder->image_index, NULL);
     _decoder->crashReport = [self decodeCrashData: encodedData error: outError];
 
     /* Check if decoding failed. If so, outError has already been populated. */
@@ -94,6 +376,9 @@ static void populate_nserror (NSError **error, PLCrashReporterError code, NSStri
         goto error;
     }
 
+    /* String table (optional). This must be extracted before any messages that refer to it. */
+    _decoder->strings = [[self extractStringTable: _decoder->crashReport->string_table] retain];
+
     /* Report info (optional) */
     _uuid = NULL;
     if (_decoder->crashReport->report_info != NULL) {
@@ -166,6 +451,44 @@ static void populate_nserror (NSError **error, PLCrashReporterError code, NSStri
             goto error;
     }
 
+    /* Report type. Older reports do not include an explicit type, and the type must be inferred. */
+    _reportType = PLCrashReportTypeUnknown;
+    if (_decoder->crashReport->report_info != NULL && _decoder->crashReport->report_info->has_type) {
+        switch (_decoder->crashReport->report_info->type) {
+            case PLCRASH__CRASH_REPORT__REPORT_INFO__REPORT_TYPE__CRASH:
+                _reportType = PLCrashReportTypeCrash;
+                break;
+            case PLCRASH__CRASH_REPORT__REPORT_INFO__REPORT_TYPE__LANGUAGE_EXCEPTION:
+                _reportType = PLCrashReportTypeLanguageException;
+                break;
+            case PLCRASH__CRASH_REPORT__REPORT_INFO__REPORT_TYPE__WATCHDOG:
+                _reportType = PLCrashReportTypeWatchdog;
+                break;
+            case PLCRASH__CRASH_REPORT__REPORT_INFO__REPORT_TYPE__LIVE:
+                _reportType = PLCrashReportTypeLive;
+                break;
+            default:
+                _reportType = PLCrashReportTypeUnknown;
+                break;
+        }
+    }
+
+    if (_reportType == PLCrashReportTypeUnknown) {
+        if (_decoder->crashReport->report_info != NULL && _decoder->crashReport->report_info->user_requested) {
+            _reportType = PLCrashReportTypeLive;
+        } else if (_exceptionInfo != nil) {
+            _reportType = PLCrashReportTypeLanguageException;
+        } else {
+            _reportType = PLCrashReportTypeCrash;
+        }
+    }
+
+    /* Report fingerprint */
+    if (_decoder->crashReport->report_info != NULL && _decoder->crashReport->report_info->has_fingerprint) {
+        _hasFingerprint = YES;
+        _fingerprint = _decoder->crashReport->report_info->fingerprint;
+    }
+
     return self;
 
 error:
@@ -190,6 +513,12 @@ error:
 
     /* Free the decoder state */
     if (_decoder != NULL) {
+        [_decoder->strings release];
+
+        plcr_image_index_t *index = atomic_load(&_decoder->image_index);
+        if (index != NULL)
+            free(index);
+
         if (_decoder->crashReport != NULL) {
             protobuf_c_message_free_unpacked((ProtobufCMessage *) _decoder->crashReport, NULL);
         }
@@ -203,22 +532,37 @@ error:
 
 /**
  * Return the binary image containing the given address, or nil if no binary image
- * is found.
+ * is found. If multiple images contain the address, the first matching image in
+ * the report's image list is returned.
+ *
+ * The image address index is built on first use; subsequent lookups are performed
+ * via binary search, without locking.
  *
  * @param address The address to search for.
  */
 - (PLCrashReportBinaryImageInfo *) imageForAddress: (uint64_t) address {
-    for (PLCrashReportBinaryImageInfo *imageInfo in self.images) {
-        uint64_t normalizedBaseAddress = imageInfo.imageBaseAddress;
-#if __DARWIN_OPAQUE_ARM_THREAD_STATE64
-        normalizedBaseAddress &= 0x0000000fffffffff;
-#endif
-        if (normalizedBaseAddress <= address && address < (normalizedBaseAddress + imageInfo.imageSize))
-            return imageInfo;
+    /* Pairs with the release issued when the index is published */
+    plcr_image_index_t *index = atomic_load_explicit(&_decoder->image_index, memory_order_acquire);
+
+    if (index == NULL)
+        index = [self buildImageIndex];
+
+    /* If the index could not be allocated, fall back on a linear search */
+    if (index == NULL) {
+        for (PLCrashReportBinaryImageInfo *imageInfo in self.images) {
+            uint64_t normalizedBaseAddress = plcr_normalize_image_address(imageInfo.imageBaseAddress);
+            if (normalizedBaseAddress <= address && address < (normalizedBaseAddress + imageInfo.imageSize))
+                return imageInfo;
+        }
+
+        return nil;
     }
 
-    /* Not found */
-    return nil;
+    const plcr_image_range_t *range = plcr_image_index_lookup(index, address);
+    if (range == NULL)
+        return nil;
+
+    return [_images objectAtIndex: range->image_index];
 }
 
 // property getter. Returns YES if machine information is available.
@@ -252,6 +596,9 @@ error:
 @synthesize images = _images;
 @synthesize exceptionInfo = _exceptionInfo;
 @synthesize uuidRef = _uuid;
+@synthesize reportType = _reportType;
+@synthesize hasFingerprint = _hasFingerprint;
+@synthesize fingerprint = _fingerprint;
 
 @end
 
@@ -562,6 +909,46 @@ error:
                                                            native: processInfo->native] autorelease];
 }
 
+/**
+ * Extract the report's string table. Returns an array of NSString instances, indexed by string table index; if the
+ * report does not include a string table, an empty array is returned.
+ */
+- (NSArray *) extractStringTable: (Plcrash__CrashReport__StringTable *) stringTable {
+    if (stringTable == NULL)
+        return [NSArray array];
+
+    NSMutableArray *strings = [NSMutableArray arrayWithCapacity: stringTable->n_entries];
+    for (size_t i = 0; i < stringTable->n_entries; i++) {
+        NSString *string = [NSString stringWithUTF8String: stringTable->entries[i]];
+
+        /* Preserve the indices of any entries that are not valid UTF-8 */
+        if (string == nil)
+            string = @"";
+
+        [strings addObject: string];
+    }
+
+    return strings;
+}
+
+/**
+ * Return a string value that was written either in full as @a string, or if @a hasIndex is true, as a reference to the
+ * report's string table entry at @a index. Returns nil if the value is missing, or @a index is out of range.
+ */
+- (NSString *) stringWithValue: (const char *) string index: (uint32_t) index hasIndex: (protobuf_c_boolean) hasIndex {
+    if (hasIndex) {
+        if (index >= [_decoder->strings count])
+            return nil;
+
+        return [_decoder->strings objectAtIndex: index];
+    }
+
+    if (string == NULL)
+        return nil;
+
+    return [NSString stringWithUTF8String: string];
+}
+
 /**
  * Extract symbol information from the crash log. Returns nil on error, or a PLCrashReportSymbolInfo
  * instance on success.
@@ -574,7 +961,12 @@ error:
         return nil;
     }
     
-    NSString *name = [NSString stringWithUTF8String: symbol->name];
+    NSString *name = [self stringWithValue: symbol->name index: symbol->name_index hasIndex: symbol->has_name_index];
+    if (name == nil) {
+        populate_nserror(outError, PLCrashReporterErrorCrashReportInvalid, @"Missing symbol name in symbol record");
+        return nil;
+    }
+
     return [[[PLCrashReportSymbolInfo alloc] initWithSymbolName: name
                                                    startAddress: symbol->start_address
                                                      endAddress: symbol->has_end_address ? symbol->end_address : 0] autorelease];
@@ -599,8 +991,64 @@ error:
             return NULL;
     }
 
+    BOOL scanned = stackFrame->has_scanned && stackFrame->scanned;
     return [[[PLCrashReportStackFrameInfo alloc] initWithInstructionPointer: stackFrame->pc
-                                                                 symbolInfo: symbolInfo] autorelease];
+                                                                 symbolInfo: symbolInfo
+                                                                    scanned: scanned] autorelease];
+}
+
+/**
+ * Extract register information from a typed register state message. Returns an array of PLCrashReportRegisterInfo
+ * instances, ordered by field number, for all registers included in @a registerState.
+ */
+- (NSMutableArray *) extractRegisterState: (Plcrash__CrashReport__Thread__RegisterState *) registerState {
+    const ProtobufCMessage *message = NULL;
+    if (registerState->x86_32 != NULL) {
+        message = &registerState->x86_32->base;
+    } else if (registerState->x86_64 != NULL) {
+        message = &registerState->x86_64->base;
+    } else if (registerState->arm != NULL) {
+        message = &registerState->arm->base;
+    } else if (registerState->arm64 != NULL) {
+        message = &registerState->arm64->base;
+    }
+
+    if (message == NULL)
+        return [NSMutableArray array];
+
+    /* The register names are provided by the message's field names */
+    const ProtobufCMessageDescriptor *descriptor = message->descriptor;
+    const uint8_t *fields = (const uint8_t *) message;
+    NSMutableArray *registers = [NSMutableArray arrayWithCapacity: descriptor->n_fields];
+    for (unsigned int i = 0; i < descriptor->n_fields; i++) {
+        const ProtobufCFieldDescriptor *field = &descriptor->fields[i];
+        uint64_t value;
+
+        /* Registers that could not be fetched are omitted by the writer */
+        if (field->label == PROTOBUF_C_LABEL_OPTIONAL && !*(const protobuf_c_boolean *) (fields + field->quantifier_offset))
+            continue;
+
+        switch (field->type) {
+            case PROTOBUF_C_TYPE_UINT32:
+                value = *(const uint32_t *) (fields + field->offset);
+                break;
+
+            case PROTOBUF_C_TYPE_UINT64:
+                value = *(const uint64_t *) (fields + field->offset);
+                break;
+
+            default:
+                continue;
+        }
+
+        PLCrashReportRegisterInfo *regInfo = [[[PLCrashReportRegisterInfo alloc] initWithRegisterName: [NSString stringWithUTF8String: field->name]
+                                                                                        registerValue: value
+                                                                                         registerType: nil
+                                                                                        registerValue: nil] autorelease];
+        [registers addObject: regInfo];
+    }
+
+    return registers;
 }
 
 /**
@@ -632,8 +1080,15 @@ error:
             [frames addObject: frameInfo];
         }
 
-        /* Fetch registers for this thread */
-        NSMutableArray *registers = [NSMutableArray arrayWithCapacity: thread->n_registers];
+        /* Fetch registers for this thread. If the typed register state is available, any named register values
+         * provide additional type and content information for the typed registers. */
+        NSMutableArray *registers;
+        if (thread->register_state != NULL) {
+            registers = [self extractRegisterState: thread->register_state];
+        } else {
+            registers = [NSMutableArray arrayWithCapacity: thread->n_registers];
+        }
+
         for (size_t reg_idx = 0; reg_idx < thread->n_registers; reg_idx++) {
             Plcrash__CrashReport__Thread__RegisterValue *reg = thread->registers[reg_idx];
             PLCrashReportRegisterInfo *regInfo;
@@ -658,7 +1113,23 @@ error:
                                                               registerValue: reg->value
                                                                   registerType:regiserType
                                                                  registerValue:registerContent] autorelease];
-            [registers addObject: regInfo];
+
+            /* Replace the matching typed register, if any */
+            NSUInteger typedIndex = NSNotFound;
+            if (thread->register_state != NULL) {
+                for (NSUInteger i = 0; i < [registers count]; i++) {
+                    if ([[[registers objectAtIndex: i] registerName] isEqualToString: [regInfo registerName]]) {
+                        typedIndex = i;
+                        break;
+                    }
+                }
+            }
+
+            if (typedIndex != NSNotFound) {
+                [registers replaceObjectAtIndex: typedIndex withObject: regInfo];
+            } else {
+                [registers addObject: regInfo];
+            }
         }
 
         /* Create the thread info instance */
@@ -692,7 +1163,8 @@ error:
         PLCrashReportBinaryImageInfo *imageInfo;
 
         /* Validate */
-        if (image->name == NULL) {
+        NSString *name = [self stringWithValue: image->name index: image->name_index hasIndex: image->has_name_index];
+        if (name == nil) {
             populate_nserror(outError, PLCrashReporterErrorCrashReportInvalid, @"Missing image name in image record");
             return nil;
         }
@@ -718,7 +1190,7 @@ error:
         imageInfo = [[[PLCrashReportBinaryImageInfo alloc] initWithCodeType: codeType
                                                                 baseAddress: image->base_address
                                                                        size: image->size
-                                                                       name: [NSString stringWithUTF8String: image->name]
+                                                                       name: name
                                                                        uuid: uuid] autorelease];
         [images addObject: imageInfo];
     }
@@ -726,6 +1198,52 @@ error:
     return images;
 }
 
+/**
+ * Build and publish the sorted image address index used by imageForAddress:. This may be called concurrently;
+ * the first index to be published is used by all callers.
+ *
+ * @return Returns the published index, or NULL if the index can not be allocated, in which case callers must fall
+ * back on a linear search.
+ */
+- (plcr_image_index_t *) buildImageIndex {
+    NSUInteger count = [_images count];
+
+    plcr_image_range_t *ranges = malloc(sizeof(plcr_image_range_t) * (count + 1));
+    if (ranges == NULL)
+        return NULL;
+
+    /* Record all non-empty image ranges; empty or wrapping ranges can never match a lookup. */
+    NSUInteger rangeCount = 0;
+    NSUInteger imageIndex = 0;
+    for (PLCrashReportBinaryImageInfo *imageInfo in _images) {
+        uint64_t start = plcr_normalize_image_address(imageInfo.imageBaseAddress);
+        uint64_t end = start + imageInfo.imageSize;
+
+        if (end > start) {
+            ranges[rangeCount].start = start;
+            ranges[rangeCount].end = end;
+            ranges[rangeCount].image_index = imageIndex;
+            rangeCount++;
+        }
+
+        imageIndex++;
+    }
+
+    plcr_image_index_t *index = plcr_image_index_create(ranges, rangeCount);
+    free(ranges);
+    if (index == NULL)
+        return NULL;
+
+    /* Publish the index; if another thread won the race, discard ours in favor of the published index. */
+    plcr_image_index_t *published = NULL;
+    if (!atomic_compare_exchange_strong_explicit(&_decoder->image_index, &published, index, memory_order_acq_rel, memory_order_acquire)) {
+        free(index);
+        index = published;
+    }
+
+    return index;
+}
+
 /**
  * Extract  exception information from the crash log. Returns nil on error.
  */
@@ -0,0 +1,1144 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PLCrashReportReader.h"
+
+#include <string.h>
+
+/**
+ * @defgroup plcrash_report_reader Crash Report Reader
+ * @ingroup plcrash_internal
+ *
+ * Implements a Foundation-free pull decoder for crash report files. The PLCrashReportFileHeader and protobuf
+ * wire format are decoded directly from the caller's buffer (typically a memory-mapped file), and all returned
+ * strings and byte arrays point into that buffer; nothing is allocated, and nothing is decoded until requested.
+ *
+ * The reader depends only on the C standard library, and may be built on hosts other than Mac OS X and iOS for
+ * offline report processing.
+ *
+ * @{
+ */
+
+/** Crash log magic identifier; see PLCrashReportFileHeader. */
+#define REPORT_FILE_MAGIC "plcrash"
+
+/** Supported crash log file format version. */
+#define REPORT_FILE_VERSION 1
+
+/* Protobuf wire types */
+enum {
+    WIRE_TYPE_VARINT = 0,
+    WIRE_TYPE_FIXED64 = 1,
+    WIRE_TYPE_DELIMITED = 2,
+    WIRE_TYPE_FIXED32 = 5
+};
+
+/* Field numbers, from crash_report.proto */
+enum {
+    CRASH_REPORT_SYSTEM_INFO = 1,
+    CRASH_REPORT_APPLICATION_INFO = 2,
+    CRASH_REPORT_THREADS = 3,
+    CRASH_REPORT_BINARY_IMAGES = 4,
+    CRASH_REPORT_EXCEPTION = 5,
+    CRASH_REPORT_SIGNAL = 6,
+    CRASH_REPORT_PROCESS_INFO = 7,
+    CRASH_REPORT_MACHINE_INFO = 8,
+    CRASH_REPORT_REPORT_INFO = 9,
+    CRASH_REPORT_STRING_TABLE = 10,
+
+    PROCESSOR_ENCODING = 1,
+    PROCESSOR_TYPE = 2,
+    PROCESSOR_SUBTYPE = 3,
+
+    SYSTEM_INFO_OPERATING_SYSTEM = 1,
+    SYSTEM_INFO_OS_VERSION = 2,
+    SYSTEM_INFO_ARCHITECTURE = 3,
+    SYSTEM_INFO_TIMESTAMP = 4,
+    SYSTEM_INFO_OS_BUILD = 5,
+
+    APPLICATION_INFO_IDENTIFIER = 1,
+    APPLICATION_INFO_VERSION = 2,
+    APPLICATION_INFO_MARKETING_VERSION = 3,
+
+    SYMBOL_NAME = 1,
+    SYMBOL_START_ADDRESS = 2,
+    SYMBOL_END_ADDRESS = 3,
+    SYMBOL_NAME_INDEX = 4,
+
+    THREAD_THREAD_NUMBER = 1,
+    THREAD_FRAMES = 2,
+    THREAD_CRASHED = 3,
+    THREAD_REGISTERS = 4,
+    THREAD_REGISTER_STATE = 5,
+
+    STACK_FRAME_PC = 3,
+    STACK_FRAME_SYMBOL = 6,
+    STACK_FRAME_SCANNED = 7,
+
+    REGISTER_VALUE_NAME = 1,
+    REGISTER_VALUE_VALUE = 2,
+    REGISTER_VALUE_TYPE = 3,
+    REGISTER_VALUE_CONTENT = 4,
+
+    BINARY_IMAGE_BASE_ADDRESS = 1,
+    BINARY_IMAGE_SIZE = 2,
+    BINARY_IMAGE_NAME = 3,
+    BINARY_IMAGE_UUID = 4,
+    BINARY_IMAGE_CODE_TYPE = 5,
+    BINARY_IMAGE_NAME_INDEX = 6,
+
+    EXCEPTION_NAME = 1,
+    EXCEPTION_REASON = 2,
+    EXCEPTION_FRAMES = 3,
+
+    SIGNAL_NAME = 1,
+    SIGNAL_CODE = 2,
+    SIGNAL_ADDRESS = 3,
+    SIGNAL_MACH_EXCEPTION = 4,
+
+    MACH_EXCEPTION_TYPE = 1,
+    MACH_EXCEPTION_CODES = 2,
+
+    PROCESS_INFO_PROCESS_NAME = 1,
+    PROCESS_INFO_PROCESS_ID = 2,
+    PROCESS_INFO_PROCESS_PATH = 3,
+    PROCESS_INFO_PARENT_PROCESS_NAME = 4,
+    PROCESS_INFO_PARENT_PROCESS_ID = 5,
+    PROCESS_INFO_NATIVE = 6,
+    PROCESS_INFO_START_TIME = 7,
+
+    MACHINE_INFO_MODEL = 1,
+    MACHINE_INFO_PROCESSOR = 2,
+    MACHINE_INFO_PROCESSOR_COUNT = 3,
+    MACHINE_INFO_LOGICAL_PROCESSOR_COUNT = 4,
+
+    REPORT_INFO_USER_REQUESTED = 1,
+    REPORT_INFO_UUID = 2,
+    REPORT_INFO_TYPE = 3,
+    REPORT_INFO_FINGERPRINT = 4,
+
+    STRING_TABLE_ENTRIES = 1
+};
+
+/* Default enumeration values, from crash_report.proto */
+enum {
+    DEFAULT_OPERATING_SYSTEM = 3,   /* OS_UNKNOWN */
+    DEFAULT_ARCHITECTURE = 6        /* ARCHITECTURE_UNKNOWN */
+};
+
+/* Typed register names, indexed by RegisterState field number - 1. Field numbers without a register are NULL. */
+static const char *const x86_32_register_names[] = {
+    "eax", "ebx", "ecx", "edx", "edi", "esi", "ebp", "esp", NULL, "eflags", "eip", "cs", "ds", "es", "fs", "gs", "ss",
+    "trapno"
+};
+
+static const char *const x86_64_register_names[] = {
+    "rax", "rbx", "rcx", "rdx", "rdi", "rsi", "rbp", "rsp", "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15", "rip",
+    "rflags", "cs", "fs", "gs"
+};
+
+static const char *const arm_register_names[] = {
+    "r0", "r1", "r2", "r3", "r4", "r5", "r6", "r7", "r8", "r9", "r10", "r11", "r12", "sp", "lr", "pc", "cpsr"
+};
+
+static const char *const arm64_register_names[] = {
+    "x0", "x1", "x2", "x3", "x4", "x5", "x6", "x7", "x8", "x9", "x10", "x11", "x12", "x13", "x14", "x15", "x16", "x17",
+    "x18", "x19", "x20", "x21", "x22", "x23", "x24", "x25", "x26", "x27", "x28", "fp", "sp", "lr", "pc", "cpsr"
+};
+
+/* Register name tables, indexed by RegisterState field number - 1 */
+static const struct {
+    const char *const *names;
+    uint32_t count;
+} register_state_names[] = {
+    { x86_32_register_names, sizeof(x86_32_register_names) / sizeof(x86_32_register_names[0]) },
+    { x86_64_register_names, sizeof(x86_64_register_names) / sizeof(x86_64_register_names[0]) },
+    { arm_register_names, sizeof(arm_register_names) / sizeof(arm_register_names[0]) },
+    { arm64_register_names, sizeof(arm64_register_names) / sizeof(arm64_register_names[0]) }
+};
+
+/*
+ * Wire format primitives. All primitives mark the reader as failed on malformed input; once failed, no further
+ * fields will be returned.
+ */
+
+static void cursor_init (plcrash_report_cursor_t *cursor, plcrash_report_bytes_t bytes) {
+    cursor->p = bytes.data;
+    cursor->end = bytes.data != NULL ? bytes.data + bytes.length : NULL;
+}
+
+static uint64_t read_varint (plcrash_report_reader_t *reader, plcrash_report_cursor_t *cursor) {
+    uint64_t value = 0;
+    for (unsigned int shift = 0; shift < 64 && cursor->p < cursor->end; shift += 7) {
+        uint8_t byte = *cursor->p++;
+        value |= (uint64_t) (byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+            return value;
+    }
+
+    reader->failed = true;
+    return 0;
+}
+
+static uint64_t read_fixed (plcrash_report_reader_t *reader, plcrash_report_cursor_t *cursor, size_t size) {
+    if ((size_t) (cursor->end - cursor->p) < size) {
+        reader->failed = true;
+        return 0;
+    }
+
+    /* Values are encoded in little-endian byte order, independent of the host */
+    uint64_t value = 0;
+    for (size_t i = 0; i < size; i++)
+        value |= (uint64_t) cursor->p[i] << (8 * i);
+
+    cursor->p += size;
+    return value;
+}
+
+static plcrash_report_bytes_t read_delimited (plcrash_report_reader_t *reader, plcrash_report_cursor_t *cursor) {
+    plcrash_report_bytes_t result = { NULL, 0 };
+
+    uint64_t length = read_varint(reader, cursor);
+    if (reader->failed)
+        return result;
+
+    if (length > (uint64_t) (cursor->end - cursor->p)) {
+        reader->failed = true;
+        return result;
+    }
+
+    result.data = cursor->p;
+    result.length = (size_t) length;
+    cursor->p += length;
+    return result;
+}
+
+static plcrash_report_string_t read_string (plcrash_report_reader_t *reader, plcrash_report_cursor_t *cursor) {
+    plcrash_report_bytes_t bytes = read_delimited(reader, cursor);
+    plcrash_report_string_t result = { (const char *) bytes.data, bytes.length };
+    return result;
+}
+
+static void skip_field (plcrash_report_reader_t *reader, plcrash_report_cursor_t *cursor, uint32_t type) {
+    switch (type) {
+        case WIRE_TYPE_VARINT:
+            read_varint(reader, cursor);
+            break;
+        case WIRE_TYPE_FIXED64:
+            read_fixed(reader, cursor, 8);
+            break;
+        case WIRE_TYPE_DELIMITED:
+            read_delimited(reader, cursor);
+            break;
+        case WIRE_TYPE_FIXED32:
+            read_fixed(reader, cursor, 4);
+            break;
+        default:
+            /* Groups are not used by the crash report format */
+            reader->failed = true;
+            break;
+    }
+}
+
+/**
+ * Read the next field key from @a cursor.
+ *
+ * @return Returns false once the message is exhausted, or if the reader has failed.
+ */
+static bool next_field (plcrash_report_reader_t *reader, plcrash_report_cursor_t *cursor, uint32_t *field, uint32_t *type) {
+    if (reader->failed || cursor->p >= cursor->end)
+        return false;
+
+    uint64_t key = read_varint(reader, cursor);
+    if (reader->failed)
+        return false;
+
+    /* Field numbers are limited to 29 bits, and may not be zero */
+    if ((key >> 3) == 0 || (key >> 3) > 0x1FFFFFFF) {
+        reader->failed = true;
+        return false;
+    }
+
+    *field = (uint32_t) (key >> 3);
+    *type = (uint32_t) (key & 0x7);
+    return true;
+}
+
+/**
+ * Resolve a string value that may have been written to the report's string table. As per PLCrashReport, a
+ * string table index takes precedence over an inline value. An out-of-range index marks the reader as failed.
+ */
+static plcrash_report_string_t resolve_string (plcrash_report_reader_t *reader, plcrash_report_string_t value, bool has_index, uint32_t index) {
+    if (!has_index)
+        return value;
+
+    plcrash_report_string_t result = { NULL, 0 };
+    if (!plcrash_report_reader_string(reader, index, &result))
+        reader->failed = true;
+
+    return result;
+}
+
+static void decode_processor (plcrash_report_reader_t *reader, plcrash_report_bytes_t message, plcrash_report_processor_t *processor) {
+    plcrash_report_cursor_t cursor;
+    uint32_t field, type;
+
+    processor->encoding = 0;
+    processor->type = 0;
+    processor->subtype = 0;
+
+    cursor_init(&cursor, message);
+    while (next_field(reader, &cursor, &field, &type)) {
+        if (field == PROCESSOR_ENCODING && type == WIRE_TYPE_VARINT) {
+            processor->encoding = (uint32_t) read_varint(reader, &cursor);
+        } else if (field == PROCESSOR_TYPE && type == WIRE_TYPE_VARINT) {
+            processor->type = read_varint(reader, &cursor);
+        } else if (field == PROCESSOR_SUBTYPE && type == WIRE_TYPE_VARINT) {
+            processor->subtype = read_varint(reader, &cursor);
+        } else {
+            skip_field(reader, &cursor, type);
+        }
+    }
+}
+
+/*
+ * Reader
+ */
+
+/**
+ * Initialize a reader for the crash report file contents at @a data. The report's top-level fields are located,
+ * and its threads, images and string table entries are counted; no other fields are decoded.
+ *
+ * @param reader The reader to initialize.
+ * @param data The report file contents, including the file header. This buffer must remain valid for the
+ * lifetime of the reader.
+ * @param length The length of @a data, in bytes.
+ *
+ * @return Returns true on success, or false if the file header is invalid, the file version is unsupported, or
+ * the report is malformed.
+ */
+bool plcrash_report_reader_open (plcrash_report_reader_t *reader, const void *data, size_t length) {
+    const uint8_t *bytes = data;
+    const size_t magic_length = sizeof(REPORT_FILE_MAGIC) - 1;
+
+    memset(reader, 0, sizeof(*reader));
+
+    /* Validate the file header */
+    if (bytes == NULL || length < magic_length + 1 || memcmp(bytes, REPORT_FILE_MAGIC, magic_length) != 0) {
+        reader->failed = true;
+        return false;
+    }
+
+    reader->version = bytes[magic_length];
+    if (reader->version != REPORT_FILE_VERSION) {
+        reader->failed = true;
+        return false;
+    }
+
+    reader->body.data = bytes + magic_length + 1;
+    reader->body.length = length - magic_length - 1;
+
+    /* Locate the top-level fields */
+    plcrash_report_cursor_t cursor;
+    uint32_t field, type;
+
+    cursor_init(&cursor, reader->body);
+    while (next_field(reader, &cursor, &field, &type)) {
+        if (type != WIRE_TYPE_DELIMITED) {
+            skip_field(reader, &cursor, type);
+            continue;
+        }
+
+        plcrash_report_bytes_t message = read_delimited(reader, &cursor);
+        switch (field) {
+            case CRASH_REPORT_SYSTEM_INFO:
+                reader->system_info = message;
+                break;
+            case CRASH_REPORT_APPLICATION_INFO:
+                reader->application_info = message;
+                break;
+            case CRASH_REPORT_THREADS:
+                reader->thread_count++;
+                break;
+            case CRASH_REPORT_BINARY_IMAGES:
+                reader->image_count++;
+                break;
+            case CRASH_REPORT_EXCEPTION:
+                reader->exception = message;
+                break;
+            case CRASH_REPORT_SIGNAL:
+                reader->signal = message;
+                break;
+            case CRASH_REPORT_PROCESS_INFO:
+                reader->process_info = message;
+                break;
+            case CRASH_REPORT_MACHINE_INFO:
+                reader->machine_info = message;
+                break;
+            case CRASH_REPORT_REPORT_INFO:
+                reader->report_info = message;
+                break;
+            case CRASH_REPORT_STRING_TABLE:
+                reader->string_table = message;
+                break;
+            default:
+                break;
+        }
+    }
+
+    /* Count the string table entries */
+    cursor_init(&cursor, reader->string_table);
+    while (next_field(reader, &cursor, &field, &type)) {
+        if (field == STRING_TABLE_ENTRIES && type == WIRE_TYPE_DELIMITED) {
+            read_delimited(reader, &cursor);
+            reader->string_count++;
+        } else {
+            skip_field(reader, &cursor, type);
+        }
+    }
+
+    return !reader->failed;
+}
+
+/**
+ * Return true if malformed data has been encountered by @a reader or any of its iterators.
+ */
+bool plcrash_report_reader_failed (const plcrash_report_reader_t *reader) {
+    return reader->failed;
+}
+
+/**
+ * Return the number of entries in the report's string table.
+ */
+size_t plcrash_report_reader_string_count (const plcrash_report_reader_t *reader) {
+    return reader->string_count;
+}
+
+/**
+ * Index the report's string table into the caller-provided @a strings array, allowing string table entries to be
+ * resolved in constant time. Without an index, each string table lookup requires a linear scan of the table.
+ *
+ * The @a strings array must remain valid for the lifetime of the reader, and may be reused across readers.
+ *
+ * @param reader The reader.
+ * @param strings An array of at least plcrash_report_reader_string_count() entries.
+ * @param capacity The number of entries in @a strings.
+ *
+ * @return Returns true on success, or false if @a capacity is insufficient or the string table is malformed.
+ */
+bool plcrash_report_reader_index_strings (plcrash_report_reader_t *reader, plcrash_report_string_t *strings, size_t capacity) {
+    if (reader->string_count > capacity)
+        return false;
+
+    plcrash_report_cursor_t cursor;
+    uint32_t field, type;
+    size_t count = 0;
+
+    cursor_init(&cursor, reader->string_table);
+    while (count < capacity && next_field(reader, &cursor, &field, &type)) {
+        if (field == STRING_TABLE_ENTRIES && type == WIRE_TYPE_DELIMITED) {
+            strings[count++] = read_string(reader, &cursor);
+        } else {
+            skip_field(reader, &cursor, type);
+        }
+    }
+
+    if (reader->failed)
+        return false;
+
+    reader->strings = strings;
+    reader->indexed_string_count = count;
+    return true;
+}
+
+/**
+ * Fetch the string table entry at @a index.
+ *
+ * @param reader The reader.
+ * @param index The string table index.
+ * @param[out] string On success, the string table entry.
+ *
+ * @return Returns true on success, or false if @a index is out of range.
+ */
+bool plcrash_report_reader_string (plcrash_report_reader_t *reader, uint32_t index, plcrash_report_string_t *string) {
+    if (index < reader->indexed_string_count) {
+        *string = reader->strings[index];
+        return true;
+    }
+
+    plcrash_report_cursor_t cursor;
+    uint32_t field, type;
+    uint32_t current = 0;
+
+    cursor_init(&cursor, reader->string_table);
+    while (next_field(reader, &cursor, &field, &type)) {
+        if (field == STRING_TABLE_ENTRIES && type == WIRE_TYPE_DELIMITED) {
+            plcrash_report_string_t entry = read_string(reader, &cursor);
+            if (current++ == index) {
+                *string = entry;
+                return !reader->failed;
+            }
+        } else {
+            skip_field(reader, &cursor, type);
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Decode the report's metadata.
+ *
+ * @return Returns true on success, or false if the report does not include metadata, or it is malformed.
+ */
+bool plcrash_report_reader_report_info (plcrash_report_reader_t *reader, plcrash_report_info_t *info) {
+    plcrash_report_cursor_t cursor;
+    uint32_t field, type;
+
+    memset(info, 0, sizeof(*info));
+    if (reader->report_info.data == NULL)
+        return false;
+
+    cursor_init(&cursor, reader->report_info);
+    while (next_field(reader, &cursor, &field, &type)) {
+        if (field == REPORT_INFO_USER_REQUESTED && type == WIRE_TYPE_VARINT) {
+            info->user_requested = read_varint(reader, &cursor) != 0;
+        } else if (field == REPORT_INFO_UUID && type == WIRE_TYPE_DELIMITED) {
+            info->uuid = read_delimited(reader, &cursor);
+        } else if (field == REPORT_INFO_TYPE && type == WIRE_TYPE_VARINT) {
+            info->has_type = true;
+            info->type = (uint32_t) read_varint(reader, &cursor);
+        } else if (field == REPORT_INFO_FINGERPRINT && type == WIRE_TYPE_FIXED64) {
+            info->has_fingerprint = true;
+            info->fingerprint = read_fixed(reader, &cursor, 8);
+        } else {
+            skip_field(reader, &cursor, type);
+        }
+    }
+
+    return !reader->failed;
+}
+
+/**
+ * Decode the report's system information.
+ *
+ * @return Returns true on success, or false if the report does not include system information, or it is malformed.
+ */
+bool plcrash_report_reader_system_info (plcrash_report_reader_t *reader, plcrash_report_system_info_t *info) {
+    plcrash_report_cursor_t cursor;
+    uint32_t field, type;
+
+    memset(info, 0, sizeof(*info));
+    info->operating_system = DEFAULT_OPERATING_SYSTEM;
+    info->architecture = DEFAULT_ARCHITECTURE;
+    if (reader->system_info.data == NULL)
+        return false;
+
+    cursor_init(&cursor, reader->system_info);
+    while (next_field(reader, &cursor, &field, &type)) {
+        if (field == SYSTEM_INFO_OPERATING_SYSTEM && type == WIRE_TYPE_VARINT) {
+            info->operating_system = (uint32_t) read_varint(reader, &cursor);
+        } else if (field == SYSTEM_INFO_OS_VERSION && type == WIRE_TYPE_DELIMITED) {
+            info->os_version = read_string(reader, &cursor);
+        } else if (field == SYSTEM_INFO_ARCHITECTURE && type == WIRE_TYPE_VARINT) {
+            info->architecture = (uint32_t) read_varint(reader, &cursor);
+        } else if (field == SYSTEM_INFO_TIMESTAMP && type == WIRE_TYPE_VARINT) {
+            info->timestamp = (int64_t) read_varint(reader, &cursor);
+        } else if (field == SYSTEM_INFO_OS_BUILD && type == WIRE_TYPE_DELIMITED) {
+            info->os_build = read_string(reader, &cursor);
+        } else {
+            skip_field(reader, &cursor, type);
+        }
+    }
+
+    return !reader->failed;
+}
+
+/**
+ * Decode the report's application information.
+ *
+ * @return Returns true on success, or false if the report does not include application information, or it is
+ * malformed.
+ */
+bool plcrash_report_reader_application_info (plcrash_report_reader_t *reader, plcrash_report_application_info_t *info) {
+    plcrash_report_cursor_t cursor;
+    uint32_t field, type;
+
+    memset(info, 0, sizeof(*info));
+    if (reader->application_info.data == NULL)
+        return false;
+
+    cursor_init(&cursor, reader->application_info);
+    while (next_field(reader, &cursor, &field, &type)) {
+        if (field == APPLICATION_INFO_IDENTIFIER && type == WIRE_TYPE_DELIMITED) {
+            info->identifier = read_string(reader, &cursor);
+        } else if (field == APPLICATION_INFO_VERSION && type == WIRE_TYPE_DELIMITED) {
+            info->version = read_string(reader, &cursor);
+        } else if (field == APPLICATION_INFO_MARKETING_VERSION && type == WIRE_TYPE_DELIMITED) {
+            info->marketing_version = read_string(reader, &cursor);
+        } else {
+            skip_field(reader, &cursor, type);
+        }
+    }
+
+    return !reader->failed;
+}
+
+/**
+ * Decode the report's process information.
+ *
+ * @return Returns true on success, or false if the report does not include process information, or it is malformed.
+ */
+bool plcrash_report_reader_process_info (plcrash_report_reader_t *reader, plcrash_report_process_info_t *info) {
+    plcrash_report_cursor_t cursor;
+    uint32_t field, type;
+
+    memset(info, 0, sizeof(*info));
+    if (reader->process_info.data == NULL)
+        return false;
+
+    cursor_init(&cursor, reader->process_info);
+    while (next_field(reader, &cursor, &field, &type)) {
+        if (field == PROCESS_INFO_PROCESS_NAME && type == WIRE_TYPE_DELIMITED) {
+            info->process_name = read_string(reader, &cursor);
+        } else if (field == PROCESS_INFO_PROCESS_ID && type == WIRE_TYPE_VARINT) {
+            info->process_id = (uint32_t) read_varint(reader, &cursor);
+        } else if (field == PROCESS_INFO_PROCESS_PATH && type == WIRE_TYPE_DELIMITED) {
+            info->process_path = read_string(reader, &cursor);
+        } else if (field == PROCESS_INFO_PARENT_PROCESS_NAME && type == WIRE_TYPE_DELIMITED) {
+            info->parent_process_name = read_string(reader, &cursor);
+        } else if (field == PROCESS_INFO_PARENT_PROCESS_ID && type == WIRE_TYPE_VARINT) {
+            info->parent_process_id = (uint32_t) read_varint(reader, &cursor);
+        } else if (field == PROCESS_INFO_NATIVE && type == WIRE_TYPE_VARINT) {
+            info->native = read_varint(reader, &cursor) != 0;
+        } else if (field == PROCESS_INFO_START_TIME && type == WIRE_TYPE_VARINT) {
+            info->has_start_time = true;
+            info->start_time = read_varint(reader, &cursor);
+        } else {
+            skip_field(reader, &cursor, type);
+        }
+    }
+
+    return !reader->failed;
+}
+
+/**
+ * Decode the report's machine information.
+ *
+ * @return Returns true on success, or false if the report does not include machine information, or it is malformed.
+ */
+bool plcrash_report_reader_machine_info (plcrash_report_reader_t *reader, plcrash_report_machine_info_t *info) {
+    plcrash_report_cursor_t cursor;
+    uint32_t field, type;
+
+    memset(info, 0, sizeof(*info));
+    if (reader->machine_info.data == NULL)
+        return false;
+
+    cursor_init(&cursor, reader->machine_info);
+    while (next_field(reader, &cursor, &field, &type)) {
+        if (field == MACHINE_INFO_MODEL && type == WIRE_TYPE_DELIMITED) {
+            info->model = read_string(reader, &cursor);
+        } else if (field == MACHINE_INFO_PROCESSOR && type == WIRE_TYPE_DELIMITED) {
+            decode_processor(reader, read_delimited(reader, &cursor), &info->processor);
+        } else if (field == MACHINE_INFO_PROCESSOR_COUNT && type == WIRE_TYPE_VARINT) {
+            info->processor_count = (uint32_t) read_varint(reader, &cursor);
+        } else if (field == MACHINE_INFO_LOGICAL_PROCESSOR_COUNT && type == WIRE_TYPE_VARINT) {
+            info->logical_processor_count = (uint32_t) read_varint(reader, &cursor);
+        } else {
+            skip_field(reader, &cursor, type);
+        }
+    }
+
+    return !reader->failed;
+}
+
+/**
+ * Decode the report's signal information.
+ *
+ * @return Returns true on success, or false if the report does not include signal information, or it is malformed.
+ */
+bool plcrash_report_reader_signal (plcrash_report_reader_t *reader, plcrash_report_signal_t *signal) {
+    plcrash_report_cursor_t cursor;
+    uint32_t field, type;
+
+    memset(signal, 0, sizeof(*signal));
+    if (reader->signal.data == NULL)
+        return false;
+
+    cursor_init(&cursor, reader->signal);
+    while (next_field(reader, &cursor, &field, &type)) {
+        if (field == SIGNAL_NAME && type == WIRE_TYPE_DELIMITED) {
+            signal->name = read_string(reader, &cursor);
+        } else if (field == SIGNAL_CODE && type == WIRE_TYPE_DELIMITED) {
+            signal->code = read_string(reader, &cursor);
+        } else if (field == SIGNAL_ADDRESS && type == WIRE_TYPE_VARINT) {
+            signal->address = read_varint(reader, &cursor);
+        } else if (field == SIGNAL_MACH_EXCEPTION && type == WIRE_TYPE_DELIMITED) {
+            plcrash_report_cursor_t mach;
+            cursor_init(&mach, read_delimited(reader, &cursor));
+
+            signal->has_mach_exception = true;
+            while (next_field(reader, &mach, &field, &type)) {
+                if (field == MACH_EXCEPTION_TYPE && type == WIRE_TYPE_VARINT) {
+                    signal->mach_type = read_varint(reader, &mach);
+                } else if (field == MACH_EXCEPTION_CODES && type == WIRE_TYPE_VARINT) {
+                    uint64_t code = read_varint(reader, &mach);
+                    if (signal->mach_code_count < PLCRASH_REPORT_READER_MAX_MACH_CODES)
+                        signal->mach_codes[signal->mach_code_count] = code;
+                    signal->mach_code_count++;
+                } else if (field == MACH_EXCEPTION_CODES && type == WIRE_TYPE_DELIMITED) {
+                    /* Packed encoding */
+                    plcrash_report_cursor_t packed;
+                    cursor_init(&packed, read_delimited(reader, &mach));
+                    while (!reader->failed && packed.p < packed.end) {
+                        uint64_t code = read_varint(reader, &packed);
+                        if (signal->mach_code_count < PLCRASH_REPORT_READER_MAX_MACH_CODES)
+                            signal->mach_codes[signal->mach_code_count] = code;
+                        signal->mach_code_count++;
+                    }
+                } else {
+                    skip_field(reader, &mach, type);
+                }
+            }
+        } else {
+            skip_field(reader, &cursor, type);
+        }
+    }
+
+    return !reader->failed;
+}
+
+/**
+ * Decode the report's uncaught exception information. The exception's stack frames may be iterated via
+ * plcrash_report_reader_exception_frames().
+ *
+ * @return Returns true on success, or false if the report does not include exception information, or it is
+ * malformed.
+ */
+bool plcrash_report_reader_exception (plcrash_report_reader_t *reader, plcrash_report_exception_t *exception) {
+    plcrash_report_cursor_t cursor;
+    uint32_t field, type;
+
+    memset(exception, 0, sizeof(*exception));
+    if (reader->exception.data == NULL)
+        return false;
+
+    exception->message = reader->exception;
+    cursor_init(&cursor, reader->exception);
+    while (next_field(reader, &cursor, &field, &type)) {
+        if (field == EXCEPTION_NAME && type == WIRE_TYPE_DELIMITED) {
+            exception->name = read_string(reader, &cursor);
+        } else if (field == EXCEPTION_REASON && type == WIRE_TYPE_DELIMITED) {
+            exception->reason = read_string(reader, &cursor);
+        } else {
+            skip_field(reader, &cursor, type);
+        }
+    }
+
+    return !reader->failed;
+}
+
+/*
+ * Threads
+ */
+
+/**
+ * Return the number of threads in the report.
+ */
+size_t plcrash_report_reader_thread_count (const plcrash_report_reader_t *reader) {
+    return reader->thread_count;
+}
+
+/**
+ * Initialize @a iter to iterate over the report's threads, in report order.
+ */
+void plcrash_report_reader_threads (plcrash_report_reader_t *reader, plcrash_report_thread_iter_t *iter) {
+    iter->reader = reader;
+    cursor_init(&iter->cursor, reader->body);
+}
+
+/**
+ * Fetch the next thread.
+ *
+ * @return Returns false once all threads have been returned, or if the report is malformed.
+ */
+bool plcrash_report_thread_iter_next (plcrash_report_thread_iter_t *iter, plcrash_report_thread_t *thread) {
+    plcrash_report_reader_t *reader = iter->reader;
+    uint32_t field, type;
+
+    while (next_field(reader, &iter->cursor, &field, &type)) {
+        if (field != CRASH_REPORT_THREADS || type != WIRE_TYPE_DELIMITED) {
+            skip_field(reader, &iter->cursor, type);
+            continue;
+        }
+
+        plcrash_report_cursor_t cursor;
+        thread->number = 0;
+        thread->crashed = false;
+        thread->message = read_delimited(reader, &iter->cursor);
+
+        cursor_init(&cursor, thread->message);
+        while (next_field(reader, &cursor, &field, &type)) {
+            if (field == THREAD_THREAD_NUMBER && type == WIRE_TYPE_VARINT) {
+                thread->number = (uint32_t) read_varint(reader, &cursor);
+            } else if (field == THREAD_CRASHED && type == WIRE_TYPE_VARINT) {
+                thread->crashed = read_varint(reader, &cursor) != 0;
+            } else {
+                skip_field(reader, &cursor, type);
+            }
+        }
+
+        return !reader->failed;
+    }
+
+    return false;
+}
+
+/*
+ * Stack frames
+ */
+
+/**
+ * Initialize @a iter to iterate over the stack frames of @a thread, starting with the innermost frame.
+ */
+void plcrash_report_reader_thread_frames (plcrash_report_reader_t *reader, const plcrash_report_thread_t *thread, plcrash_report_frame_iter_t *iter) {
+    iter->reader = reader;
+    iter->field = THREAD_FRAMES;
+    cursor_init(&iter->cursor, thread->message);
+}
+
+/**
+ * Initialize @a iter to iterate over the stack frames of @a exception, starting with the innermost frame.
+ */
+void plcrash_report_reader_exception_frames (plcrash_report_reader_t *reader, const plcrash_report_exception_t *exception, plcrash_report_frame_iter_t *iter) {
+    iter->reader = reader;
+    iter->field = EXCEPTION_FRAMES;
+    cursor_init(&iter->cursor, exception->message);
+}
+
+/**
+ * Fetch the next stack frame.
+ *
+ * @return Returns false once all frames have been returned, or if the report is malformed.
+ */
+bool plcrash_report_frame_iter_next (plcrash_report_frame_iter_t *iter, plcrash_report_frame_t *frame) {
+    plcrash_report_reader_t *reader = iter->reader;
+    uint32_t field, type;
+
+    while (next_field(reader, &iter->cursor, &field, &type)) {
+        if (field != iter->field || type != WIRE_TYPE_DELIMITED) {
+            skip_field(reader, &iter->cursor, type);
+            continue;
+        }
+
+        plcrash_report_cursor_t cursor;
+        memset(frame, 0, sizeof(*frame));
+
+        cursor_init(&cursor, read_delimited(reader, &iter->cursor));
+        while (next_field(reader, &cursor, &field, &type)) {
+            if (field == STACK_FRAME_PC && type == WIRE_TYPE_VARINT) {
+                frame->pc = read_varint(reader, &cursor);
+            } else if (field == STACK_FRAME_SCANNED && type == WIRE_TYPE_VARINT) {
+                frame->scanned = read_varint(reader, &cursor) != 0;
+            } else if (field == STACK_FRAME_SYMBOL && type == WIRE_TYPE_DELIMITED) {
+                plcrash_report_cursor_t symbol;
+                bool has_name_index = false;
+                uint32_t name_index = 0;
+
+                frame->has_symbol = true;
+                cursor_init(&symbol, read_delimited(reader, &cursor));
+                while (next_field(reader, &symbol, &field, &type)) {
+                    if (field == SYMBOL_NAME && type == WIRE_TYPE_DELIMITED) {
+                        frame->symbol_name = read_string(reader, &symbol);
+                    } else if (field == SYMBOL_START_ADDRESS && type == WIRE_TYPE_VARINT) {
+                        frame->symbol_start = read_varint(reader, &symbol);
+                    } else if (field == SYMBOL_END_ADDRESS && type == WIRE_TYPE_VARINT) {
+                        frame->has_symbol_end = true;
+                        frame->symbol_end = read_varint(reader, &symbol);
+                    } else if (field == SYMBOL_NAME_INDEX && type == WIRE_TYPE_VARINT) {
+                        has_name_index = true;
+                        name_index = (uint32_t) read_varint(reader, &symbol);
+                    } else {
+                        skip_field(reader, &symbol, type);
+                    }
+                }
+
+                frame->symbol_name = resolve_string(reader, frame->symbol_name, has_name_index, name_index);
+            } else {
+                skip_field(reader, &cursor, type);
+            }
+        }
+
+        return !reader->failed;
+    }
+
+    return false;
+}
+
+/*
+ * Registers
+ */
+
+/**
+ * Find the value of the typed register with field number @a number in the register state @a state.
+ */
+static bool find_typed_register (plcrash_report_reader_t *reader, plcrash_report_bytes_t state, uint32_t number, uint64_t *value) {
+    plcrash_report_cursor_t cursor;
+    uint32_t field, type;
+
+    cursor_init(&cursor, state);
+    while (next_field(reader, &cursor, &field, &type)) {
+        if (field == number && type == WIRE_TYPE_VARINT) {
+            *value = read_varint(reader, &cursor);
+            return !reader->failed;
+        }
+
+        skip_field(reader, &cursor, type);
+    }
+
+    return false;
+}
+
+/**
+ * Return true if @a name names a typed register that is present in @a iter's register state.
+ */
+static bool has_typed_register (plcrash_report_register_iter_t *iter, plcrash_report_string_t name) {
+    for (uint32_t i = 0; i < iter->state_name_count; i++) {
+        const char *typed_name = iter->state_names[i];
+        if (typed_name == NULL || strlen(typed_name) != name.length || memcmp(typed_name, name.data, name.length) != 0)
+            continue;
+
+        uint64_t value;
+        return find_typed_register(iter->reader, iter->state, i + 1, &value);
+    }
+
+    return false;
+}
+
+/**
+ * Decode a RegisterValue message. A register value without a name marks the reader as failed.
+ */
+static void decode_register (plcrash_report_reader_t *reader, plcrash_report_bytes_t message, plcrash_report_register_t *reg) {
+    plcrash_report_cursor_t cursor;
+    uint32_t field, type;
+
+    memset(reg, 0, sizeof(*reg));
+    cursor_init(&cursor, message);
+    while (next_field(reader, &cursor, &field, &type)) {
+        if (field == REGISTER_VALUE_NAME && type == WIRE_TYPE_DELIMITED) {
+            reg->name = read_string(reader, &cursor);
+        } else if (field == REGISTER_VALUE_VALUE && type == WIRE_TYPE_VARINT) {
+            reg->value = read_varint(reader, &cursor);
+        } else if (field == REGISTER_VALUE_TYPE && type == WIRE_TYPE_DELIMITED) {
+            reg->type = read_string(reader, &cursor);
+        } else if (field == REGISTER_VALUE_CONTENT && type == WIRE_TYPE_DELIMITED) {
+            reg->content = read_string(reader, &cursor);
+        } else {
+            skip_field(reader, &cursor, type);
+        }
+    }
+
+    if (reg->name.data == NULL)
+        reader->failed = true;
+}
+
+/**
+ * Initialize @a iter to iterate over the registers of @a thread.
+ */
+void plcrash_report_reader_thread_registers (plcrash_report_reader_t *reader, const plcrash_report_thread_t *thread, plcrash_report_register_iter_t *iter) {
+    plcrash_report_cursor_t cursor;
+    uint32_t field, type;
+    plcrash_report_bytes_t register_state = { NULL, 0 };
+
+    iter->reader = reader;
+    iter->thread = thread->message;
+    iter->state.data = NULL;
+    iter->state.length = 0;
+    iter->state_names = NULL;
+    iter->state_name_count = 0;
+    iter->next_field = 1;
+    cursor_init(&iter->cursor, thread->message);
+
+    /* Locate the register state, if any */
+    cursor_init(&cursor, thread->message);
+    while (next_field(reader, &cursor, &field, &type)) {
+        if (field == THREAD_REGISTER_STATE && type == WIRE_TYPE_DELIMITED) {
+            register_state = read_delimited(reader, &cursor);
+        } else {
+            skip_field(reader, &cursor, type);
+        }
+    }
+
+    /* If multiple architectures are present, prefer the first in field order, as per PLCrashReport */
+    uint32_t selected = 0;
+    cursor_init(&cursor, register_state);
+    while (next_field(reader, &cursor, &field, &type)) {
+        const uint32_t table_count = sizeof(register_state_names) / sizeof(register_state_names[0]);
+        if (type == WIRE_TYPE_DELIMITED && field <= table_count && (selected == 0 || field < selected)) {
+            selected = field;
+            iter->state = read_delimited(reader, &cursor);
+            iter->state_names = register_state_names[field - 1].names;
+            iter->state_name_count = register_state_names[field - 1].count;
+        } else {
+            skip_field(reader, &cursor, type);
+        }
+    }
+}
+
+/**
+ * Fetch the next register.
+ *
+ * @return Returns false once all registers have been returned, or if the report is malformed.
+ */
+bool plcrash_report_register_iter_next (plcrash_report_register_iter_t *iter, plcrash_report_register_t *reg) {
+    plcrash_report_reader_t *reader = iter->reader;
+    uint32_t field, type;
+
+    /* Typed registers, ordered by field number */
+    while (iter->state.data != NULL && iter->next_field <= iter->state_name_count && !reader->failed) {
+        uint32_t number = iter->next_field++;
+        const char *name = iter->state_names[number - 1];
+        uint64_t value;
+
+        /* Registers that could not be fetched are omitted by the writer */
+        if (name == NULL || !find_typed_register(reader, iter->state, number, &value))
+            continue;
+
+        memset(reg, 0, sizeof(*reg));
+        reg->name.data = name;
+        reg->name.length = strlen(name);
+        reg->value = value;
+
+        /* A named register value describing this register replaces the typed value; if there are several, the
+         * last is used, as per PLCrashReport */
+        plcrash_report_cursor_t cursor;
+        cursor_init(&cursor, iter->thread);
+        while (next_field(reader, &cursor, &field, &type)) {
+            if (field != THREAD_REGISTERS || type != WIRE_TYPE_DELIMITED) {
+                skip_field(reader, &cursor, type);
+                continue;
+            }
+
+            plcrash_report_register_t named;
+            decode_register(reader, read_delimited(reader, &cursor), &named);
+            if (named.name.length == reg->name.length && memcmp(named.name.data, name, reg->name.length) == 0)
+                *reg = named;
+        }
+
+        return !reader->failed;
+    }
+
+    /* Named registers that do not describe a typed register */
+    while (next_field(reader, &iter->cursor, &field, &type)) {
+        if (field != THREAD_REGISTERS || type != WIRE_TYPE_DELIMITED) {
+            skip_field(reader, &iter->cursor, type);
+            continue;
+        }
+
+        decode_register(reader, read_delimited(reader, &iter->cursor), reg);
+        if (reader->failed)
+            return false;
+
+        if (iter->state.data != NULL && has_typed_register(iter, reg->name))
+            continue;
+
+        return !reader->failed;
+    }
+
+    return false;
+}
+
+/*
+ * Binary images
+ */
+
+/**
+ * Return the number of binary images in the report.
+ */
+size_t plcrash_report_reader_image_count (const plcrash_report_reader_t *reader) {
+    return reader->image_count;
+}
+
+/**
+ * Initialize @a iter to iterate over the report's binary images, in report order.
+ */
+void plcrash_report_reader_images (plcrash_report_reader_t *reader, plcrash_report_image_iter_t *iter) {
+    iter->reader = reader;
+    cursor_init(&iter->cursor, reader->body);
+}
+
+/**
+ * Fetch the next binary image.
+ *
+ * @return Returns false once all images have been returned, or if the report is malformed.
+ */
+bool plcrash_report_image_iter_next (plcrash_report_image_iter_t *iter, plcrash_report_image_t *image) {
+    plcrash_report_reader_t *reader = iter->reader;
+    uint32_t field, type;
+
+    while (next_field(reader, &iter->cursor, &field, &type)) {
+        if (field != CRASH_REPORT_BINARY_IMAGES || type != WIRE_TYPE_DELIMITED) {
+            skip_field(reader, &iter->cursor, type);
+            continue;
+        }
+
+        plcrash_report_cursor_t cursor;
+        bool has_name_index = false;
+        uint32_t name_index = 0;
+
+        memset(image, 0, sizeof(*image));
+        cursor_init(&cursor, read_delimited(reader, &iter->cursor));
+        while (next_field(reader, &cursor, &field, &type)) {
+            if (field == BINARY_IMAGE_BASE_ADDRESS && type == WIRE_TYPE_VARINT) {
+                image->base_address = read_varint(reader, &cursor);
+            } else if (field == BINARY_IMAGE_SIZE && type == WIRE_TYPE_VARINT) {
+                image->size = read_varint(reader, &cursor);
+            } else if (field == BINARY_IMAGE_NAME && type == WIRE_TYPE_DELIMITED) {
+                image->name = read_string(reader, &cursor);
+            } else if (field == BINARY_IMAGE_UUID && type == WIRE_TYPE_DELIMITED) {
+                image->uuid = read_delimited(reader, &cursor);
+            } else if (field == BINARY_IMAGE_CODE_TYPE && type == WIRE_TYPE_DELIMITED) {
+                image->has_code_type = true;
+                decode_processor(reader, read_delimited(reader, &cursor), &image->code_type);
+            } else if (field == BINARY_IMAGE_NAME_INDEX && type == WIRE_TYPE_VARINT) {
+                has_name_index = true;
+                name_index = (uint32_t) read_varint(reader, &cursor);
+            } else {
+                skip_field(reader, &cursor, type);
+            }
+        }
+
+        image->name = resolve_string(reader, image->name, has_name_index, name_index);
+        return !reader->failed;
+    }
+
+    return false;
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,485 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PLCRASH_REPORT_READER_H
+#define PLCRASH_REPORT_READER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @ingroup plcrash_report_reader
+ * @{
+ */
+
+/**
+ * The maximum number of Mach exception codes returned by plcrash_report_reader_signal(); see
+ * plcrash_report_signal_t::mach_code_count.
+ */
+#define PLCRASH_REPORT_READER_MAX_MACH_CODES 4
+
+/**
+ * A view of a byte array within the report data.
+ */
+typedef struct plcrash_report_bytes {
+    /** A pointer into the report data, or NULL if the value is not available. */
+    const uint8_t *data;
+
+    /** The length of @a data, in bytes. */
+    size_t length;
+} plcrash_report_bytes_t;
+
+/**
+ * A view of a UTF-8 string within the report data. The string is not NUL-terminated.
+ */
+typedef struct plcrash_report_string {
+    /** A pointer into the report data, or NULL if the value is not available. */
+    const char *data;
+
+    /** The length of @a data, in bytes. */
+    size_t length;
+} plcrash_report_string_t;
+
+/**
+ * A crash report reader.
+ *
+ * The reader decodes the protobuf wire format directly from the report data, which must remain valid for the
+ * lifetime of the reader and all values returned by it. No memory is allocated by the reader.
+ *
+ * Malformed input is sticky: once malformed data has been encountered, all iterators will terminate, and
+ * plcrash_report_reader_failed() will return true. A caller may iterate a report to completion, checking for
+ * failure only once.
+ */
+typedef struct plcrash_report_reader {
+    /** The report file format version. */
+    uint8_t version;
+
+    /** The encoded CrashReport message. */
+    plcrash_report_bytes_t body;
+
+    /** If true, malformed data has been encountered. */
+    bool failed;
+
+    /** The encoded SystemInfo message, if any. */
+    plcrash_report_bytes_t system_info;
+
+    /** The encoded ApplicationInfo message, if any. */
+    plcrash_report_bytes_t application_info;
+
+    /** The encoded Exception message, if any. */
+    plcrash_report_bytes_t exception;
+
+    /** The encoded Signal message, if any. */
+    plcrash_report_bytes_t signal;
+
+    /** The encoded ProcessInfo message, if any. */
+    plcrash_report_bytes_t process_info;
+
+    /** The encoded MachineInfo message, if any. */
+    plcrash_report_bytes_t machine_info;
+
+    /** The encoded ReportInfo message, if any. */
+    plcrash_report_bytes_t report_info;
+
+    /** The encoded StringTable message, if any. */
+    plcrash_report_bytes_t string_table;
+
+    /** The number of threads in the report. */
+    size_t thread_count;
+
+    /** The number of binary images in the report. */
+    size_t image_count;
+
+    /** The number of string table entries in the report. */
+    size_t string_count;
+
+    /** Caller-provided string table index, or NULL; see plcrash_report_reader_index_strings(). */
+    const plcrash_report_string_t *strings;
+
+    /** The number of entries in @a strings. */
+    size_t indexed_string_count;
+} plcrash_report_reader_t;
+
+/**
+ * Report metadata.
+ */
+typedef struct plcrash_report_info {
+    /** If true, the report was requested by the user, rather than generated by a crash. */
+    bool user_requested;
+
+    /** The 16-byte report UUID, if any. */
+    plcrash_report_bytes_t uuid;
+
+    /** If true, @a type is available. */
+    bool has_type;
+
+    /** The report type, as defined by CrashReport.ReportInfo.ReportType. */
+    uint32_t type;
+
+    /** If true, @a fingerprint is available. */
+    bool has_fingerprint;
+
+    /** The report's stack fingerprint. */
+    uint64_t fingerprint;
+} plcrash_report_info_t;
+
+/**
+ * Host operating system and architecture.
+ */
+typedef struct plcrash_report_system_info {
+    /** The operating system, as defined by CrashReport.SystemInfo.OperatingSystem. */
+    uint32_t operating_system;
+
+    /** The operating system's version. */
+    plcrash_report_string_t os_version;
+
+    /** The operating system's build, if any. */
+    plcrash_report_string_t os_build;
+
+    /** The (deprecated) host architecture, as defined by the Architecture enumeration. */
+    uint32_t architecture;
+
+    /** The time at which the report was generated, in seconds since the UNIX epoch. */
+    int64_t timestamp;
+} plcrash_report_system_info_t;
+
+/**
+ * Application identification.
+ */
+typedef struct plcrash_report_application_info {
+    /** The application identifier. */
+    plcrash_report_string_t identifier;
+
+    /** The application version. */
+    plcrash_report_string_t version;
+
+    /** The application's marketing version, if any. */
+    plcrash_report_string_t marketing_version;
+} plcrash_report_application_info_t;
+
+/**
+ * Process information.
+ */
+typedef struct plcrash_report_process_info {
+    /** The process name, if any. */
+    plcrash_report_string_t process_name;
+
+    /** The process ID. */
+    uint32_t process_id;
+
+    /** The process path, if any. */
+    plcrash_report_string_t process_path;
+
+    /** The parent process name, if any. */
+    plcrash_report_string_t parent_process_name;
+
+    /** The parent process ID. */
+    uint32_t parent_process_id;
+
+    /** If true, the process was running natively, rather than under emulation. */
+    bool native;
+
+    /** If true, @a start_time is available. */
+    bool has_start_time;
+
+    /** The process start time, in seconds since the UNIX epoch. */
+    uint64_t start_time;
+} plcrash_report_process_info_t;
+
+/**
+ * Processor type.
+ */
+typedef struct plcrash_report_processor {
+    /** The type encoding, as defined by CrashReport.Processor.TypeEncoding. */
+    uint32_t encoding;
+
+    /** The processor type. */
+    uint64_t type;
+
+    /** The processor subtype. */
+    uint64_t subtype;
+} plcrash_report_processor_t;
+
+/**
+ * Host hardware information.
+ */
+typedef struct plcrash_report_machine_info {
+    /** The hardware model, if any. */
+    plcrash_report_string_t model;
+
+    /** The host processor type. */
+    plcrash_report_processor_t processor;
+
+    /** The number of actual physical processor cores. */
+    uint32_t processor_count;
+
+    /** The number of logical processors. */
+    uint32_t logical_processor_count;
+} plcrash_report_machine_info_t;
+
+/**
+ * Signal (and Mach exception) information.
+ */
+typedef struct plcrash_report_signal {
+    /** The signal name. */
+    plcrash_report_string_t name;
+
+    /** The signal code. */
+    plcrash_report_string_t code;
+
+    /** The faulting address. */
+    uint64_t address;
+
+    /** If true, Mach exception information is available. */
+    bool has_mach_exception;
+
+    /** The Mach exception type. */
+    uint64_t mach_type;
+
+    /** The total number of Mach exception codes. Only the first #PLCRASH_REPORT_READER_MAX_MACH_CODES are returned. */
+    size_t mach_code_count;
+
+    /** The Mach exception codes. */
+    uint64_t mach_codes[PLCRASH_REPORT_READER_MAX_MACH_CODES];
+} plcrash_report_signal_t;
+
+/**
+ * Uncaught language exception information.
+ */
+typedef struct plcrash_report_exception {
+    /** The exception name. */
+    plcrash_report_string_t name;
+
+    /** The exception reason. */
+    plcrash_report_string_t reason;
+
+    /** The encoded Exception message. */
+    plcrash_report_bytes_t message;
+} plcrash_report_exception_t;
+
+/**
+ * A thread.
+ */
+typedef struct plcrash_report_thread {
+    /** The thread number. */
+    uint32_t number;
+
+    /** If true, this is the crashed thread. */
+    bool crashed;
+
+    /** The encoded Thread message. */
+    plcrash_report_bytes_t message;
+} plcrash_report_thread_t;
+
+/**
+ * A stack frame.
+ */
+typedef struct plcrash_report_frame {
+    /** The frame's instruction pointer. */
+    uint64_t pc;
+
+    /** If true, the frame was found by stack scanning, rather than by a frame unwinder. */
+    bool scanned;
+
+    /** If true, symbol information is available. */
+    bool has_symbol;
+
+    /** The symbol name, if any. Names written to the string table are resolved automatically. */
+    plcrash_report_string_t symbol_name;
+
+    /** The symbol start address. */
+    uint64_t symbol_start;
+
+    /** If true, @a symbol_end is available. */
+    bool has_symbol_end;
+
+    /** The symbol end address. */
+    uint64_t symbol_end;
+} plcrash_report_frame_t;
+
+/**
+ * A register value.
+ */
+typedef struct plcrash_report_register {
+    /** The register name. */
+    plcrash_report_string_t name;
+
+    /** The register value. */
+    uint64_t value;
+
+    /** The type of the value referenced by the register, if known. */
+    plcrash_report_string_t type;
+
+    /** A description of the value referenced by the register, if known. */
+    plcrash_report_string_t content;
+} plcrash_report_register_t;
+
+/**
+ * A binary image.
+ */
+typedef struct plcrash_report_image {
+    /** The image base address. */
+    uint64_t base_address;
+
+    /** The image size. */
+    uint64_t size;
+
+    /** The image name. Names written to the string table are resolved automatically. */
+    plcrash_report_string_t name;
+
+    /** The image UUID, if any. */
+    plcrash_report_bytes_t uuid;
+
+    /** If true, @a code_type is available. */
+    bool has_code_type;
+
+    /** The image code type. */
+    plcrash_report_processor_t code_type;
+} plcrash_report_image_t;
+
+/**
+ * @internal
+ *
+ * A position within an encoded message.
+ */
+typedef struct plcrash_report_cursor {
+    /** The next byte to be read. */
+    const uint8_t *p;
+
+    /** The end of the message. */
+    const uint8_t *end;
+} plcrash_report_cursor_t;
+
+/**
+ * Thread iterator.
+ */
+typedef struct plcrash_report_thread_iter {
+    /** @internal The backing reader. */
+    plcrash_report_reader_t *reader;
+
+    /** @internal The current position within the CrashReport message. */
+    plcrash_report_cursor_t cursor;
+} plcrash_report_thread_iter_t;
+
+/**
+ * Binary image iterator.
+ */
+typedef struct plcrash_report_image_iter {
+    /** @internal The backing reader. */
+    plcrash_report_reader_t *reader;
+
+    /** @internal The current position within the CrashReport message. */
+    plcrash_report_cursor_t cursor;
+} plcrash_report_image_iter_t;
+
+/**
+ * Stack frame iterator.
+ */
+typedef struct plcrash_report_frame_iter {
+    /** @internal The backing reader. */
+    plcrash_report_reader_t *reader;
+
+    /** @internal The current position within the Thread or Exception message. */
+    plcrash_report_cursor_t cursor;
+
+    /** @internal The field number of the frames within the enclosing message. */
+    uint32_t field;
+} plcrash_report_frame_iter_t;
+
+/**
+ * Register iterator.
+ *
+ * If the thread includes a typed register state, its registers are returned first, ordered by field number, followed
+ * by any named register values that do not describe a typed register. Where a named register value describes a
+ * typed register, the named value (including its type and content) is returned in place of the typed register.
+ */
+typedef struct plcrash_report_register_iter {
+    /** @internal The backing reader. */
+    plcrash_report_reader_t *reader;
+
+    /** @internal The encoded Thread message. */
+    plcrash_report_bytes_t thread;
+
+    /** @internal The encoded architecture-specific register state message, if any. */
+    plcrash_report_bytes_t state;
+
+    /** @internal Register names for @a state, indexed by field number - 1. */
+    const char *const *state_names;
+
+    /** @internal The number of entries in @a state_names. */
+    uint32_t state_name_count;
+
+    /** @internal The next typed register field number to be returned. */
+    uint32_t next_field;
+
+    /** @internal The current position within the Thread message's named register values. */
+    plcrash_report_cursor_t cursor;
+} plcrash_report_register_iter_t;
+
+bool plcrash_report_reader_open (plcrash_report_reader_t *reader, const void *data, size_t length);
+bool plcrash_report_reader_failed (const plcrash_report_reader_t *reader);
+
+size_t plcrash_report_reader_string_count (const plcrash_report_reader_t *reader);
+bool plcrash_report_reader_index_strings (plcrash_report_reader_t *reader, plcrash_report_string_t *strings, size_t capacity);
+bool plcrash_report_reader_string (plcrash_report_reader_t *reader, uint32_t index, plcrash_report_string_t *string);
+
+bool plcrash_report_reader_report_info (plcrash_report_reader_t *reader, plcrash_report_info_t *info);
+bool plcrash_report_reader_system_info (plcrash_report_reader_t *reader, plcrash_report_system_info_t *info);
+bool plcrash_report_reader_application_info (plcrash_report_reader_t *reader, plcrash_report_application_info_t *info);
+bool plcrash_report_reader_process_info (plcrash_report_reader_t *reader, plcrash_report_process_info_t *info);
+bool plcrash_report_reader_machine_info (plcrash_report_reader_t *reader, plcrash_report_machine_info_t *info);
+bool plcrash_report_reader_signal (plcrash_report_reader_t *reader, plcrash_report_signal_t *signal);
+bool plcrash_report_reader_exception (plcrash_report_reader_t *reader, plcrash_report_exception_t *exception);
+
+size_t plcrash_report_reader_thread_count (const plcrash_report_reader_t *reader);
+void plcrash_report_reader_threads (plcrash_report_reader_t *reader, plcrash_report_thread_iter_t *iter);
+bool plcrash_report_thread_iter_next (plcrash_report_thread_iter_t *iter, plcrash_report_thread_t *thread);
+
+void plcrash_report_reader_thread_frames (plcrash_report_reader_t *reader, const plcrash_report_thread_t *thread, plcrash_report_frame_iter_t *iter);
+void plcrash_report_reader_exception_frames (plcrash_report_reader_t *reader, const plcrash_report_exception_t *exception, plcrash_report_frame_iter_t *iter);
+bool plcrash_report_frame_iter_next (plcrash_report_frame_iter_t *iter, plcrash_report_frame_t *frame);
+
+void plcrash_report_reader_thread_registers (plcrash_report_reader_t *reader, const plcrash_report_thread_t *thread, plcrash_report_register_iter_t *iter);
+bool plcrash_report_register_iter_next (plcrash_report_register_iter_t *iter, plcrash_report_register_t *reg);
+
+size_t plcrash_report_reader_image_count (const plcrash_report_reader_t *reader);
+void plcrash_report_reader_images (plcrash_report_reader_t *reader, plcrash_report_image_iter_t *iter);
+bool plcrash_report_image_iter_next (plcrash_report_image_iter_t *iter, plcrash_report_image_t *image);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLCRASH_REPORT_READER_H */
@@ -0,0 +1,381 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "SenTestCompat.h"
+
+#import "PLCrashReportReader.h"
+#import "PLCrashReporter.h"
+#import "PLCrashReport.h"
+#import "PLCrashTestThread.h"
+
+#import "crash_report.pb-c.h"
+
+#import <mach/mach_time.h>
+
+/** The number of times each corpus report is decoded by the throughput benchmark. */
+#define READER_BENCHMARK_ITERATIONS 200
+
+/** The number of test threads spawned while generating the report corpus. */
+#define CORPUS_THREAD_COUNT 4
+
+/** The string table index capacity used by the tests. */
+#define STRING_INDEX_CAPACITY 8192
+
+@interface PLCrashReportReaderTests : SenTestCase {
+@private
+    /** The encoded report corpus (NSData instances). */
+    NSMutableArray *_corpus;
+
+    /** String table index storage. */
+    plcrash_report_string_t *_strings;
+}
+@end
+
+/**
+ * Return @a string as an NSString, or nil if the string is not available.
+ */
+static NSString *plcr_reader_string (plcrash_report_string_t string) {
+    if (string.data == NULL)
+        return nil;
+
+    return [[[NSString alloc] initWithBytes: string.data length: string.length encoding: NSUTF8StringEncoding] autorelease];
+}
+
+/**
+ * Decode every field of the report in @a data with @a reader, returning the number of frames, registers and images
+ * visited, or 0 on failure.
+ */
+static size_t plcr_reader_walk (plcrash_report_reader_t *reader, NSData *data, plcrash_report_string_t *strings, size_t capacity) {
+    size_t visited = 0;
+
+    if (!plcrash_report_reader_open(reader, [data bytes], [data length]))
+        return 0;
+
+    if (strings != NULL && !plcrash_report_reader_index_strings(reader, strings, capacity))
+        return 0;
+
+    plcrash_report_info_t info;
+    plcrash_report_system_info_t systemInfo;
+    plcrash_report_signal_t signal;
+    plcrash_report_reader_report_info(reader, &info);
+    plcrash_report_reader_system_info(reader, &systemInfo);
+    plcrash_report_reader_signal(reader, &signal);
+
+    plcrash_report_thread_iter_t threads;
+    plcrash_report_thread_t thread;
+    plcrash_report_reader_threads(reader, &threads);
+    while (plcrash_report_thread_iter_next(&threads, &thread)) {
+        plcrash_report_frame_iter_t frames;
+        plcrash_report_frame_t frame;
+        plcrash_report_reader_thread_frames(reader, &thread, &frames);
+        while (plcrash_report_frame_iter_next(&frames, &frame))
+            visited++;
+
+        plcrash_report_register_iter_t registers;
+        plcrash_report_register_t reg;
+        plcrash_report_reader_thread_registers(reader, &thread, &registers);
+        while (plcrash_report_register_iter_next(&registers, &reg))
+            visited++;
+    }
+
+    plcrash_report_image_iter_t images;
+    plcrash_report_image_t image;
+    plcrash_report_reader_images(reader, &images);
+    while (plcrash_report_image_iter_next(&images, &image))
+        visited++;
+
+    if (plcrash_report_reader_failed(reader))
+        return 0;
+
+    return visited;
+}
+
+@implementation PLCrashReportReaderTests
+
+- (void) setUp {
+    plcrash_test_thread_t threads[CORPUS_THREAD_COUNT];
+    NSError *error;
+
+    _corpus = [[NSMutableArray alloc] init];
+    _strings = malloc(sizeof(plcrash_report_string_t) * STRING_INDEX_CAPACITY);
+
+    for (size_t i = 0; i < CORPUS_THREAD_COUNT; i++)
+        plcrash_test_thread_spawn(&threads[i]);
+
+    /* Generate live reports for each test thread, and for the current thread, with named registers and inline strings, and
+     * with typed registers and a string table */
+    for (size_t c = 0; c < 2; c++) {
+        PLMutableCrashReporterConfig *config = [[[PLMutableCrashReporterConfig alloc] initWithSignalHandlerType: PLCrashReporterSignalHandlerTypeBSD
+                                                                                         symbolicationStrategy: PLCrashReporterSymbolicationStrategyAll] autorelease];
+        config.registerEncoding = c == 0 ? PLCrashReporterRegisterEncodingNamed : PLCrashReporterRegisterEncodingTyped;
+        config.shouldUseStringTable = c == 0 ? NO : YES;
+        PLCrashReporter *reporter = [[[PLCrashReporter alloc] initWithConfiguration: config] autorelease];
+
+        for (size_t i = 0; i <= CORPUS_THREAD_COUNT; i++) {
+            NSData *data;
+            if (i < CORPUS_THREAD_COUNT) {
+                data = [reporter generateLiveReportWithThread: pthread_mach_thread_np(threads[i].thread) error: &error];
+            } else {
+                data = [reporter generateLiveReportAndReturnError: &error];
+            }
+            STAssertNotNil(data, @"Failed to generate live report: %@", error);
+
+            if (data != nil)
+                [_corpus addObject: data];
+        }
+    }
+
+    for (size_t i = 0; i < CORPUS_THREAD_COUNT; i++)
+        plcrash_test_thread_stop(&threads[i]);
+}
+
+- (void) tearDown {
+    [_corpus release];
+    free(_strings);
+}
+
+/**
+ * Verify that the reader returns the same values as PLCrashReport for every report in the corpus.
+ */
+- (void) testReaderMatchesPLCrashReport {
+    NSError *error;
+
+    STAssertNotEquals((NSUInteger) 0, [_corpus count], @"Empty report corpus");
+    for (NSData *data in _corpus) {
+        PLCrashReport *report = [[[PLCrashReport alloc] initWithData: data error: &error] autorelease];
+        STAssertNotNil(report, @"Could not parse generated live report: %@", error);
+
+        plcrash_report_reader_t reader;
+        STAssertTrue(plcrash_report_reader_open(&reader, [data bytes], [data length]), @"Failed to open report");
+
+        /* Report info */
+        plcrash_report_info_t info;
+        STAssertTrue(plcrash_report_reader_report_info(&reader, &info), @"Missing report info");
+        STAssertEquals((BOOL) info.has_fingerprint, report.hasFingerprint, @"Fingerprint availability mismatch");
+        if (info.has_fingerprint)
+            STAssertEquals(info.fingerprint, report.fingerprint, @"Fingerprint mismatch");
+
+        /* System info */
+        plcrash_report_system_info_t systemInfo;
+        STAssertTrue(plcrash_report_reader_system_info(&reader, &systemInfo), @"Missing system info");
+        STAssertEqualStrings(plcr_reader_string(systemInfo.os_version), report.systemInfo.operatingSystemVersion, @"OS version mismatch");
+        STAssertEquals((NSTimeInterval) systemInfo.timestamp, [report.systemInfo.timestamp timeIntervalSince1970], @"Timestamp mismatch");
+
+        /* Signal info */
+        plcrash_report_signal_t signal;
+        STAssertTrue(plcrash_report_reader_signal(&reader, &signal), @"Missing signal info");
+        STAssertEqualStrings(plcr_reader_string(signal.name), report.signalInfo.name, @"Signal name mismatch");
+        STAssertEqualStrings(plcr_reader_string(signal.code), report.signalInfo.code, @"Signal code mismatch");
+        STAssertEquals(signal.address, report.signalInfo.address, @"Signal address mismatch");
+
+        /* Threads */
+        STAssertEquals((NSUInteger) plcrash_report_reader_thread_count(&reader), [report.threads count], @"Thread count mismatch");
+
+        plcrash_report_thread_iter_t threads;
+        plcrash_report_thread_t thread;
+        NSUInteger threadIndex = 0;
+        plcrash_report_reader_threads(&reader, &threads);
+        while (plcrash_report_thread_iter_next(&threads, &thread)) {
+            PLCrashReportThreadInfo *threadInfo = [report.threads objectAtIndex: threadIndex++];
+            STAssertEquals((NSInteger) thread.number, threadInfo.threadNumber, @"Thread number mismatch");
+            STAssertEquals((BOOL) thread.crashed, threadInfo.crashed, @"Crashed flag mismatch");
+
+            plcrash_report_frame_iter_t frames;
+            plcrash_report_frame_t frame;
+            NSUInteger frameIndex = 0;
+            plcrash_report_reader_thread_frames(&reader, &thread, &frames);
+            while (plcrash_report_frame_iter_next(&frames, &frame)) {
+                PLCrashReportStackFrameInfo *frameInfo = [threadInfo.stackFrames objectAtIndex: frameIndex++];
+                STAssertEquals(frame.pc, frameInfo.instructionPointer, @"Frame PC mismatch");
+                STAssertEquals((BOOL) frame.scanned, frameInfo.scanned, @"Scanned flag mismatch");
+                STAssertEquals((BOOL) frame.has_symbol, (BOOL) (frameInfo.symbolInfo != nil), @"Symbol availability mismatch");
+                if (frame.has_symbol) {
+                    STAssertEqualStrings(plcr_reader_string(frame.symbol_name), frameInfo.symbolInfo.symbolName, @"Symbol name mismatch");
+                    STAssertEquals(frame.symbol_start, frameInfo.symbolInfo.startAddress, @"Symbol start mismatch");
+                }
+            }
+            STAssertEquals(frameIndex, [threadInfo.stackFrames count], @"Frame count mismatch");
+
+            plcrash_report_register_iter_t registers;
+            plcrash_report_register_t reg;
+            NSUInteger registerIndex = 0;
+            plcrash_report_reader_thread_registers(&reader, &thread, &registers);
+            while (plcrash_report_register_iter_next(&registers, &reg)) {
+                PLCrashReportRegisterInfo *registerInfo = [threadInfo.registers objectAtIndex: registerIndex++];
+                STAssertEqualStrings(plcr_reader_string(reg.name), registerInfo.registerName, @"Register name mismatch");
+                STAssertEquals(reg.value, registerInfo.registerValue, @"Register value mismatch");
+                STAssertEqualObjects(plcr_reader_string(reg.type), registerInfo.registerType, @"Register type mismatch");
+                STAssertEqualObjects(plcr_reader_string(reg.content), registerInfo.registerContent, @"Register content mismatch");
+            }
+            STAssertEquals(registerIndex, [threadInfo.registers count], @"Register count mismatch");
+        }
+        STAssertEquals(threadIndex, [report.threads count], @"Thread iteration count mismatch");
+
+        /* Images */
+        STAssertEquals((NSUInteger) plcrash_report_reader_image_count(&reader), [report.images count], @"Image count mismatch");
+
+        plcrash_report_image_iter_t images;
+        plcrash_report_image_t image;
+        NSUInteger imageIndex = 0;
+        plcrash_report_reader_images(&reader, &images);
+        while (plcrash_report_image_iter_next(&images, &image)) {
+            PLCrashReportBinaryImageInfo *imageInfo = [report.images objectAtIndex: imageIndex++];
+            STAssertEquals(image.base_address, imageInfo.imageBaseAddress, @"Image base address mismatch");
+            STAssertEquals(image.size, imageInfo.imageSize, @"Image size mismatch");
+            STAssertEqualStrings(plcr_reader_string(image.name), imageInfo.imageName, @"Image name mismatch");
+            STAssertEquals((BOOL) (image.uuid.length != 0), imageInfo.hasImageUUID, @"Image UUID availability mismatch");
+            STAssertEquals((BOOL) image.has_code_type, (BOOL) (imageInfo.codeType != nil), @"Image code type availability mismatch");
+            if (image.has_code_type) {
+                STAssertEquals(image.code_type.type, imageInfo.codeType.type, @"Image CPU type mismatch");
+                STAssertEquals(image.code_type.subtype, imageInfo.codeType.subtype, @"Image CPU subtype mismatch");
+            }
+        }
+        STAssertEquals(imageIndex, [report.images count], @"Image iteration count mismatch");
+
+        STAssertFalse(plcrash_report_reader_failed(&reader), @"Reader failed");
+    }
+}
+
+/**
+ * Verify that indexed string table lookups return the same values as linear lookups.
+ */
+- (void) testStringTableIndex {
+    BOOL foundStrings = NO;
+
+    for (NSData *data in _corpus) {
+        plcrash_report_reader_t reader;
+        STAssertTrue(plcrash_report_reader_open(&reader, [data bytes], [data length]), @"Failed to open report");
+
+        size_t count = plcrash_report_reader_string_count(&reader);
+        if (count == 0)
+            continue;
+        foundStrings = YES;
+
+        /* An undersized index must be rejected */
+        STAssertFalse(plcrash_report_reader_index_strings(&reader, _strings, count - 1), @"Undersized index accepted");
+
+        /* Collect the linear lookup results before indexing */
+        STAssertTrue(count <= STRING_INDEX_CAPACITY, @"String table too large for the test index");
+        NSMutableArray *expected = [NSMutableArray arrayWithCapacity: count];
+        for (uint32_t i = 0; i < count; i++) {
+            plcrash_report_string_t string;
+            STAssertTrue(plcrash_report_reader_string(&reader, i, &string), @"Failed to fetch string %u", i);
+            [expected addObject: plcr_reader_string(string)];
+        }
+
+        STAssertTrue(plcrash_report_reader_index_strings(&reader, _strings, STRING_INDEX_CAPACITY), @"Failed to index strings");
+        for (uint32_t i = 0; i < count; i++) {
+            plcrash_report_string_t string;
+            STAssertTrue(plcrash_report_reader_string(&reader, i, &string), @"Failed to fetch indexed string %u", i);
+            STAssertEqualStrings(plcr_reader_string(string), [expected objectAtIndex: i], @"Indexed string mismatch");
+        }
+
+        plcrash_report_string_t string;
+        STAssertFalse(plcrash_report_reader_string(&reader, (uint32_t) count, &string), @"Out-of-range index accepted");
+    }
+
+    STAssertTrue(foundStrings, @"No report in the corpus includes a string table");
+}
+
+/**
+ * Verify that invalid headers are rejected, and that truncated reports fail cleanly.
+ */
+- (void) testInvalidReports {
+    plcrash_report_reader_t reader;
+
+    STAssertFalse(plcrash_report_reader_open(&reader, "", 0), @"Empty input accepted");
+    STAssertFalse(plcrash_report_reader_open(&reader, "plcras", 6), @"Short header accepted");
+    STAssertFalse(plcrash_report_reader_open(&reader, "xlcrash\x01", 8), @"Invalid magic accepted");
+    STAssertFalse(plcrash_report_reader_open(&reader, "plcrash\x02", 8), @"Unsupported version accepted");
+    STAssertTrue(plcrash_report_reader_open(&reader, "plcrash\x01", 8), @"Empty report rejected");
+    STAssertFalse(plcrash_report_reader_failed(&reader), @"Empty report marked as failed");
+
+    /* Every truncation of a valid report must either decode or fail, without reading past the truncated length. The
+     * truncated copy is allocated separately, so that guard malloc or ASan can detect overreads. */
+    NSData *data = [_corpus objectAtIndex: 0];
+    size_t step = MAX((size_t) 1, [data length] / 512);
+    for (size_t length = 0; length < [data length]; length += step) {
+        void *copy = malloc(MAX(length, (size_t) 1));
+        memcpy(copy, [data bytes], length);
+        plcr_reader_walk(&reader, [NSData dataWithBytesNoCopy: copy length: length freeWhenDone: NO], NULL, 0);
+        free(copy);
+    }
+}
+
+/**
+ * Compare the throughput of the reader, the protobuf-c unpacker, and PLCrashReport over the report corpus.
+ */
+- (void) testReaderBenchmark {
+    mach_timebase_info_data_t timebase;
+    uint64_t reader_total = 0;
+    uint64_t protobuf_total = 0;
+    uint64_t report_total = 0;
+    size_t bytes = 0;
+
+    mach_timebase_info(&timebase);
+
+    for (uint32_t i = 0; i < READER_BENCHMARK_ITERATIONS; i++) {
+        for (NSData *data in _corpus) {
+            NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+            const struct PLCrashReportFileHeader *header = [data bytes];
+            plcrash_report_reader_t reader;
+
+            uint64_t start = mach_absolute_time();
+            size_t visited = plcr_reader_walk(&reader, data, _strings, STRING_INDEX_CAPACITY);
+            reader_total += mach_absolute_time() - start;
+            STAssertNotEquals((size_t) 0, visited, @"Reader failed");
+
+            start = mach_absolute_time();
+            Plcrash__CrashReport *crashReport = plcrash__crash_report__unpack(NULL, [data length] - sizeof(struct PLCrashReportFileHeader), header->data);
+            if (crashReport != NULL)
+                protobuf_c_message_free_unpacked((ProtobufCMessage *) crashReport, NULL);
+            protobuf_total += mach_absolute_time() - start;
+            STAssertNotNULL(crashReport, @"protobuf-c failed to unpack report");
+
+            start = mach_absolute_time();
+            PLCrashReport *report = [[PLCrashReport alloc] initWithData: data error: NULL];
+            [report release];
+            report_total += mach_absolute_time() - start;
+            STAssertNotNil(report, @"PLCrashReport failed to decode report");
+
+            bytes += [data length];
+            [pool drain];
+        }
+    }
+
+    double reports = (double) READER_BENCHMARK_ITERATIONS * [_corpus count];
+    double reader_ns = (double) reader_total * timebase.numer / timebase.denom;
+    double protobuf_ns = (double) protobuf_total * timebase.numer / timebase.denom;
+    double report_ns = (double) report_total * timebase.numer / timebase.denom;
+
+    fprintf(stderr, "Report decoding benchmark: %lu reports, %lu input bytes\n", (unsigned long) reports, (unsigned long) bytes);
+    fprintf(stderr, "  %-14s %14s %14s\n", "", "ns/report", "MB/s");
+    fprintf(stderr, "  %-14s %14.0f %14.1f\n", "reader", reader_ns / reports, bytes / (reader_ns / 1e9) / (1024 * 1024));
+    fprintf(stderr, "  %-14s %14.0f %14.1f\n", "protobuf-c", protobuf_ns / reports, bytes / (protobuf_ns / 1e9) / (1024 * 1024));
+    fprintf(stderr, "  %-14s %14.0f %14.1f\n", "PLCrashReport", report_ns / reports, bytes / (report_ns / 1e9) / (1024 * 1024));
+}
+
+@end
@@ -36,9 +36,13 @@
 
     /** Symbol information, if available. Otherwise, will be nil. */
     PLCrashReportSymbolInfo *_symbolInfo;
+
+    /** True if the frame was recovered by heuristic stack scanning. */
+    BOOL _scanned;
 }
 
 - (id) initWithInstructionPointer: (uint64_t) instructionPointer symbolInfo: (PLCrashReportSymbolInfo *) symbolInfo;
+- (id) initWithInstructionPointer: (uint64_t) instructionPointer symbolInfo: (PLCrashReportSymbolInfo *) symbolInfo scanned: (BOOL) scanned;
 
 /**
  * Frame's instruction pointer.
@@ -49,4 +53,10 @@
  * This may be unavailable, and this property will be nil. */
 @property(nonatomic, readonly) PLCrashReportSymbolInfo *symbolInfo;
 
+/**
+ * YES if this frame was recovered by heuristic stack scanning, rather than from unwind information or frame
+ * pointers. Scanned frames are a best guess, and may be spurious.
+ */
+@property(nonatomic, readonly) BOOL scanned;
+
 @end
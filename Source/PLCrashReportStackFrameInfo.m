@@ -35,6 +35,7 @@
 
 @synthesize instructionPointer = _instructionPointer;
 @synthesize symbolInfo = _symbolInfo;
+@synthesize scanned = _scanned;
 
 /**
  * Initialize with the provided frame info.
@@ -43,11 +44,23 @@
  * @param symbolInfo Symbol information for this frame, if available. May be nil.
  */
 - (id) initWithInstructionPointer: (uint64_t) instructionPointer symbolInfo: (PLCrashReportSymbolInfo *) symbolInfo {
+    return [self initWithInstructionPointer: instructionPointer symbolInfo: symbolInfo scanned: NO];
+}
+
+/**
+ * Initialize with the provided frame info.
+ *
+ * @param instructionPointer The instruction pointer value for this frame.
+ * @param symbolInfo Symbol information for this frame, if available. May be nil.
+ * @param scanned YES if the frame was recovered by heuristic stack scanning.
+ */
+- (id) initWithInstructionPointer: (uint64_t) instructionPointer symbolInfo: (PLCrashReportSymbolInfo *) symbolInfo scanned: (BOOL) scanned {
     if ((self = [super init]) == nil)
         return nil;
     
     _instructionPointer = instructionPointer;
     _symbolInfo = [symbolInfo retain];
+    _scanned = scanned;
     
     return self;
 }
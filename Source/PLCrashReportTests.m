@@ -26,7 +26,7 @@
  * OTHER DEALINGS IN THE SOFTWARE.
  */
 
-#import "SenTestCompat.h"
+#import "PLCrashTestCase.h"
 #import "PLCrashReport.h"
 #import "PLCrashReporter.h"
 #import "PLCrashFrameWalker.h"
@@ -44,7 +44,7 @@
 #import <mach-o/arch.h>
 #import <mach-o/dyld.h>
 
-@interface PLCrashReportTests : SenTestCase {
+@interface PLCrashReportTests : PLCrashTestCase {
 @private
     /* Path to crash log */
     NSString *_logPath;
@@ -300,4 +300,150 @@ static plcrash_error_t plcr_live_report_callback (plcrash_async_thread_state_t *
 }
 
 
+
+/**
+ * Reference implementation of -[PLCrashReport imageForAddress:]; returns the first image in report
+ * order containing @a address.
+ */
+static PLCrashReportBinaryImageInfo *plcr_linear_image_for_address (PLCrashReport *report, uint64_t address) {
+    for (PLCrashReportBinaryImageInfo *imageInfo in report.images) {
+        uint64_t normalizedBaseAddress = imageInfo.imageBaseAddress;
+#if __DARWIN_OPAQUE_ARM_THREAD_STATE64
+        normalizedBaseAddress &= 0x0000000fffffffff;
+#endif
+        if (normalizedBaseAddress <= address && address < (normalizedBaseAddress + imageInfo.imageSize))
+            return imageInfo;
+    }
+
+    return nil;
+}
+
+/**
+ * Verify that indexed image lookups match a linear search of the report's images, including at
+ * image boundaries and for addresses outside of any image.
+ */
+- (void) testImageForAddress {
+    plcrash_log_writer_t writer;
+    plcrash_async_file_t file;
+    plcrash_async_image_list_t image_list;
+    NSError *error = nil;
+
+    /* Initialize faux crash data */
+    plcrash_log_signal_info_t info;
+    plcrash_log_bsd_signal_info_t bsd_info;
+    {
+        bsd_info.address = method_getImplementation(class_getInstanceMethod([self class], _cmd));
+        bsd_info.code = SEGV_MAPERR;
+        bsd_info.signo = SIGSEGV;
+
+        info.bsd_info = &bsd_info;
+        info.mach_info = NULL;
+    }
+
+    /* Write a live report, including all loaded images */
+    int fd = open([_logPath UTF8String], O_RDWR|O_CREAT|O_EXCL, 0644);
+    plcrash_async_file_init(&file, fd, 0);
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_log_writer_init(&writer, @"test.id", @"1.0", @"1.0", PLCRASH_ASYNC_SYMBOL_STRATEGY_NONE, false), @"Initialization failed");
+
+    plcrash_nasync_image_list_init(&image_list, mach_task_self());
+    uint32_t image_count = _dyld_image_count();
+    for (uint32_t i = 0; i < image_count; i++) {
+        plcrash_nasync_image_list_append(&image_list, (uintptr_t) _dyld_get_image_header(i), _dyld_get_image_name(i));
+    }
+
+    struct plcr_live_report_context ctx = {
+        .writer = &writer,
+        .file = &file,
+        .images = &image_list,
+        .info = &info
+    };
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_async_thread_state_current(plcr_live_report_callback, &ctx), @"Writing crash log failed");
+
+    plcrash_log_writer_close(&writer);
+    plcrash_log_writer_free(&writer);
+    plcrash_nasync_image_list_free(&image_list);
+
+    plcrash_async_file_flush(&file);
+    plcrash_async_file_close(&file);
+
+    NSData *data = [NSData dataWithContentsOfFile: _logPath options: NSDataReadingMappedIfSafe error: nil];
+    PLCrashReport *report = [[[PLCrashReport alloc] initWithData: data error: &error] autorelease];
+    STAssertNotNil(report, @"Could not decode crash log: %@", error);
+
+    /* Probe each image's boundaries */
+    STAssertNotEquals((NSUInteger)0, [report.images count], @"Crash log should contain at least one image");
+    for (PLCrashReportBinaryImageInfo *imageInfo in report.images) {
+        uint64_t base = imageInfo.imageBaseAddress;
+#if __DARWIN_OPAQUE_ARM_THREAD_STATE64
+        base &= 0x0000000fffffffff;
+#endif
+        uint64_t probes[] = {
+            base - 1,
+            base,
+            base + (imageInfo.imageSize / 2),
+            base + imageInfo.imageSize - 1,
+            base + imageInfo.imageSize
+        };
+
+        for (size_t i = 0; i < sizeof(probes) / sizeof(probes[0]); i++) {
+            PLCrashReportBinaryImageInfo *expected = plcr_linear_image_for_address(report, probes[i]);
+            STAssertEquals(expected, [report imageForAddress: probes[i]], @"Incorrect image returned for 0x%" PRIx64, probes[i]);
+        }
+
+        if (imageInfo.imageSize > 0)
+            STAssertNotNil([report imageForAddress: base], @"No image found for image base address 0x%" PRIx64, base);
+    }
+
+    /* Verify lookups of addresses outside of any image */
+    STAssertNil([report imageForAddress: 0x0], @"Unexpected image found for NULL address");
+    STAssertNil([report imageForAddress: UINT64_MAX], @"Unexpected image found for UINT64_MAX");
+}
+
+/**
+ * Verify that indexed image lookups resolve overlapping, nested, and empty images to the first
+ * matching image in report order.
+ */
+- (void) testImageForAddressOverlappingImages {
+    NSError *error = nil;
+
+    /* Stage the fixture at the log path, which is removed on tear down */
+    STAssertTrue([[self dataForTestResource: @"overlapping_images.plcrash"] writeToFile: _logPath atomically: NO], @"Could not write fixture");
+    NSData *data = [NSData dataWithContentsOfFile: _logPath options: NSDataReadingMappedIfSafe error: nil];
+    PLCrashReport *report = [[[PLCrashReport alloc] initWithData: data error: &error] autorelease];
+    STAssertNotNil(report, @"Could not decode crash log: %@", error);
+
+    /*
+     * The fixture contains, in report order:
+     *   0: [0x10000, 0x11000)
+     *   1: [0x10800, 0x11800), overlapping the end of image 0
+     *   2: [0x8000, 0x108000), containing images 0, 1 and 3
+     *   3: [0x20000, 0x20010)
+     *   4: [0x200000, 0x201000)
+     *   5: [0x200000, 0x200000), empty
+     */
+    NSArray *images = report.images;
+    STAssertEquals((NSUInteger) 6, [images count], @"Incorrect image count");
+
+    STAssertEquals([images objectAtIndex: 2], [report imageForAddress: 0x8000], @"Incorrect image for start of image 2");
+    STAssertEquals([images objectAtIndex: 0], [report imageForAddress: 0x10000], @"Incorrect image for start of image 0");
+    STAssertEquals([images objectAtIndex: 0], [report imageForAddress: 0x10800], @"Image 1 did not defer to image 0");
+    STAssertEquals([images objectAtIndex: 1], [report imageForAddress: 0x11000], @"Incorrect image after the end of image 0");
+    STAssertEquals([images objectAtIndex: 2], [report imageForAddress: 0x11800], @"Incorrect image after the end of image 1");
+    STAssertEquals([images objectAtIndex: 2], [report imageForAddress: 0x20008], @"Image 3 did not defer to image 2");
+    STAssertEquals([images objectAtIndex: 2], [report imageForAddress: 0x107fff], @"Incorrect image for end of image 2");
+    STAssertNil([report imageForAddress: 0x108000], @"Unexpected image found after the end of image 2");
+    STAssertEquals([images objectAtIndex: 4], [report imageForAddress: 0x200000], @"Empty image 5 matched a lookup");
+
+    /* Probe every image boundary against the linear search */
+    for (PLCrashReportBinaryImageInfo *imageInfo in images) {
+        uint64_t base = imageInfo.imageBaseAddress;
+        uint64_t probes[] = { base - 1, base, base + imageInfo.imageSize - 1, base + imageInfo.imageSize };
+
+        for (size_t i = 0; i < sizeof(probes) / sizeof(probes[0]); i++) {
+            PLCrashReportBinaryImageInfo *expected = plcr_linear_image_for_address(report, probes[i]);
+            STAssertEquals(expected, [report imageForAddress: probes[i]], @"Incorrect image returned for 0x%" PRIx64, probes[i]);
+        }
+    }
+}
+
 @end
@@ -33,14 +33,49 @@
 
 #import "PLCrashReportTextFormatter.h"
 #import "PLCrashCompatConstants.h"
+#import "PLCrashTextBuffer.h"
 
-@interface PLCrashReportTextFormatter (PrivateAPI)
-static NSInteger binaryImageSort(id binary1, id binary2, void *context);
-+ (NSString *) formatStackFrame: (PLCrashReportStackFrameInfo *) frameInfo
-                     frameIndex: (NSUInteger) frameIndex
-                         report: (PLCrashReport *) report
-                           lp64: (BOOL) lp64;
-@end
+/** The initial size of the text buffer used to format a report. */
+#define TEXT_REPORT_INITIAL_BYTES (32 * 1024)
+
+/**
+ * @internal
+ *
+ * Formatting state for a single binary image, computed once per report.
+ */
+typedef struct plcr_text_image {
+    /** The image info (unretained; owned by the report). */
+    PLCrashReportBinaryImageInfo *info;
+
+    /** The image's index within the report's image list. */
+    NSUInteger index;
+
+    /** The image base address. */
+    uint64_t base_address;
+
+    /** The image size. */
+    uint64_t size;
+
+    /** The image's full path, as a UTF-8 string. */
+    const char *path;
+
+    /** The last path component of the image's path, as a UTF-8 string. */
+    const char *name;
+
+    /** The length of @a name, in bytes. */
+    size_t name_length;
+} plcr_text_image_t;
+
+static void plcr_append_object (plcrash_text_buffer_t *buffer, id object);
+static int plcr_text_image_compare (const void *a, const void *b);
+static void plcr_append_stack_frame (plcrash_text_buffer_t *buffer,
+                                     PLCrashReportStackFrameInfo *frameInfo,
+                                     NSUInteger frameIndex,
+                                     PLCrashReportOperatingSystem os,
+                                     PLCrashReport *report,
+                                     CFDictionaryRef imageMap,
+                                     BOOL lp64);
+static BOOL plcr_format_report (PLCrashReport *report, PLCrashReportTextFormat textFormat, plcrash_text_buffer_t *buffer);
 
 
 /**
@@ -59,7 +94,215 @@ static NSInteger binaryImageSort(id binary1, id binary2, void *context);
  * @return Returns the formatted result on success, or nil if an error occurs.
  */
 + (NSString *) stringValueForCrashReport: (PLCrashReport *) report withTextFormat: (PLCrashReportTextFormat) textFormat {
-	NSMutableString* text = [NSMutableString string];
+    plcrash_text_buffer_t buffer;
+    if (plcrash_text_buffer_init(&buffer, TEXT_REPORT_INITIAL_BYTES) != PLCRASH_ESUCCESS)
+        return nil;
+
+    if (!plcr_format_report(report, textFormat, &buffer)) {
+        plcrash_text_buffer_free(&buffer);
+        return nil;
+    }
+
+    NSString *text = [[[NSString alloc] initWithBytes: plcrash_text_buffer_bytes(&buffer)
+                                               length: plcrash_text_buffer_length(&buffer)
+                                             encoding: NSUTF8StringEncoding] autorelease];
+    plcrash_text_buffer_free(&buffer);
+
+    return text;
+}
+
+/**
+ * Initialize with the request string encoding and output format.
+ *
+ * @param textFormat Format to use for the generated text crash report.
+ * @param stringEncoding Encoding to use when writing to the output stream.
+ */
+- (id) initWithTextFormat: (PLCrashReportTextFormat) textFormat stringEncoding: (NSStringEncoding) stringEncoding {
+    if ((self = [super init]) == nil)
+        return nil;
+    
+    _textFormat = textFormat;
+    _stringEncoding = stringEncoding;
+
+    return self;
+}
+
+// from PLCrashReportFormatter protocol
+- (NSData *) formatReport: (PLCrashReport *) report error: (NSError **) outError {
+    /* The report is formatted as UTF-8; if that is the requested encoding, the formatted bytes may be returned
+     * directly. */
+    if (_stringEncoding == NSUTF8StringEncoding) {
+        plcrash_text_buffer_t buffer;
+        if (plcrash_text_buffer_init(&buffer, TEXT_REPORT_INITIAL_BYTES) != PLCRASH_ESUCCESS)
+            return nil;
+
+        if (!plcr_format_report(report, _textFormat, &buffer)) {
+            plcrash_text_buffer_free(&buffer);
+            return nil;
+        }
+
+        size_t length;
+        void *bytes = plcrash_text_buffer_detach(&buffer, &length);
+        plcrash_text_buffer_free(&buffer);
+
+        return [NSData dataWithBytesNoCopy: bytes length: length freeWhenDone: YES];
+    }
+
+    NSString *text = [PLCrashReportTextFormatter stringValueForCrashReport: report withTextFormat: _textFormat];
+    return [text dataUsingEncoding: _stringEncoding allowLossyConversion: YES];
+}
+		 
+@end
+
+
+
+
+/**
+ * @internal
+ *
+ * Append the description of @a object to @a buffer as UTF-8, matching the output of the %@ format specifier.
+ */
+static void plcr_append_object (plcrash_text_buffer_t *buffer, id object) {
+    if (object == nil) {
+        plcrash_text_buffer_append_string(buffer, NULL);
+        return;
+    }
+
+    NSString *string = [object description];
+    const char *utf8 = [string UTF8String];
+    if (utf8 != NULL) {
+        plcrash_text_buffer_append_string(buffer, utf8);
+    } else {
+        /* The string can not be represented losslessly */
+        NSData *data = [string dataUsingEncoding: NSUTF8StringEncoding allowLossyConversion: YES];
+        plcrash_text_buffer_append(buffer, [data bytes], [data length]);
+    }
+}
+
+/**
+ * @internal
+ *
+ * Sort plcr_text_image_t instances by their starting address, preserving the report order of images that share
+ * a starting address.
+ */
+static int plcr_text_image_compare (const void *a, const void *b) {
+    const plcr_text_image_t *image1 = a;
+    const plcr_text_image_t *image2 = b;
+
+    if (image1->base_address < image2->base_address)
+        return -1;
+    else if (image1->base_address > image2->base_address)
+        return 1;
+    else if (image1->index < image2->index)
+        return -1;
+    else if (image1->index > image2->index)
+        return 1;
+    else
+        return 0;
+}
+
+/**
+ * @internal
+ *
+ * Format a stack frame for display in a thread backtrace.
+ *
+ * @param buffer The output buffer.
+ * @param frameInfo The stack frame to format
+ * @param frameIndex The frame's index
+ * @param os The operating system of the report from which this frame was acquired.
+ * @param report The report from which this frame was acquired.
+ * @param imageMap A map of the report's PLCrashReportBinaryImageInfo instances to their plcr_text_image_t formatting state.
+ * @param lp64 If YES, the report was generated by an LP64 system.
+ */
+static void plcr_append_stack_frame (plcrash_text_buffer_t *buffer,
+                                     PLCrashReportStackFrameInfo *frameInfo,
+                                     NSUInteger frameIndex,
+                                     PLCrashReportOperatingSystem os,
+                                     PLCrashReport *report,
+                                     CFDictionaryRef imageMap,
+                                     BOOL lp64)
+{
+    /* Base image address containing instrumention pointer, offset of the IP from that base
+     * address, and the associated image name */
+    uint64_t baseAddress = 0x0;
+    uint64_t pcOffset = 0x0;
+    const char *imageName = "???";
+    size_t imageNameLength = 3;
+
+    uint64_t normalizedInstructionPointer = frameInfo.instructionPointer;
+#if __DARWIN_OPAQUE_ARM_THREAD_STATE64
+    normalizedInstructionPointer &= 0x0000000fffffffff;
+#endif
+
+    /* Find the image containing the instruction pointer */
+    PLCrashReportBinaryImageInfo *imageInfo = [report imageForAddress: normalizedInstructionPointer];
+    if (imageInfo != nil) {
+        const plcr_text_image_t *image = CFDictionaryGetValue(imageMap, imageInfo);
+        imageName = image->name;
+        imageNameLength = image->name_length;
+        baseAddress = image->base_address;
+        pcOffset = normalizedInstructionPointer - image->base_address;
+    }
+
+    /* Frame index, image name, and instruction pointer. The image name is padded in UTF-16 code units, matching
+     * the behavior of the %S format specifier. */
+    plcrash_text_buffer_append_int64(buffer, (int64_t) frameIndex, 4, true);
+    plcrash_text_buffer_append_padded(buffer, imageName, imageNameLength, 35, true);
+    plcrash_text_buffer_append(buffer, " 0x", 3);
+    plcrash_text_buffer_append_hex(buffer, normalizedInstructionPointer, lp64 ? 16 : 8);
+    plcrash_text_buffer_append(buffer, " ", 1);
+
+    /* If symbol info is available, the format used in Apple's reports is Sym + OffsetFromSym. Otherwise,
+     * the format used is imageBaseAddress + offsetToIP */
+    if (frameInfo.symbolInfo != nil) {
+        const char *symbolName = [frameInfo.symbolInfo.symbolName UTF8String];
+        if (symbolName == NULL)
+            symbolName = "";
+
+        /* Apple strips the _ symbol prefix in their reports. Only OS X makes use of an
+         * underscore symbol prefix by default. */
+        if (symbolName[0] == '_' && symbolName[1] != '\0') {
+            switch (os) {
+                case PLCrashReportOperatingSystemMacOSX:
+                case PLCrashReportOperatingSystemiPhoneOS:
+                case PLCrashReportOperatingSystemAppleTVOS:
+                case PLCrashReportOperatingSystemiPhoneSimulator:
+                    symbolName++;
+                    break;
+
+                default:
+                    NSLog(@"Symbol prefix rules are unknown for this OS!");
+                    break;
+            }
+        }
+
+        uint64_t symOffset = normalizedInstructionPointer - frameInfo.symbolInfo.startAddress;
+        plcrash_text_buffer_append_string(buffer, symbolName);
+        plcrash_text_buffer_append(buffer, " + ", 3);
+        plcrash_text_buffer_append_int64(buffer, (int64_t) symOffset, 0, false);
+    } else {
+        plcrash_text_buffer_append(buffer, "0x", 2);
+        plcrash_text_buffer_append_hex(buffer, baseAddress, 0);
+        plcrash_text_buffer_append(buffer, " + ", 3);
+        plcrash_text_buffer_append_int64(buffer, (int64_t) pcOffset, 0, false);
+    }
+
+    plcrash_text_buffer_append(buffer, "\n", 1);
+}
+
+/**
+ * @internal
+ *
+ * Format the provided @a report as human-readable UTF-8 text in the given @a textFormat, appending the result to
+ * @a buffer.
+ *
+ * @param report The report to format.
+ * @param textFormat The text format to use.
+ * @param buffer The output buffer.
+ *
+ * @return Returns YES on success, or NO if an allocation failure occurs.
+ */
+static BOOL plcr_format_report (PLCrashReport *report, PLCrashReportTextFormat textFormat, plcrash_text_buffer_t *buffer) {
 	boolean_t lp64 = true; // quiesce GCC uninitialized value warning
 
 	/* Header */
@@ -186,9 +429,12 @@ static NSInteger binaryImageSort(id binary1, id binary2, void *context);
             [incidentIdentifier autorelease];
         }
     
-        [text appendFormat: @"Incident Identifier: %@\n", incidentIdentifier];
-        [text appendFormat: @"CrashReporter Key:   TODO\n"];
-        [text appendFormat: @"Hardware Model:      %@\n", hardwareModel];
+        plcrash_text_buffer_append_string(buffer, "Incident Identifier: ");
+        plcr_append_object(buffer, incidentIdentifier);
+        plcrash_text_buffer_append_string(buffer, "\nCrashReporter Key:   TODO\n");
+        plcrash_text_buffer_append_string(buffer, "Hardware Model:      ");
+        plcr_append_object(buffer, hardwareModel);
+        plcrash_text_buffer_append_string(buffer, "\n");
     }
     
     /* Application and process info */
@@ -227,15 +473,26 @@ static NSInteger binaryImageSort(id binary1, id binary2, void *context);
         if (report.applicationInfo.applicationMarketingVersion != nil)
             versionString = [NSString stringWithFormat: @"%@ (%@)", report.applicationInfo.applicationMarketingVersion, report.applicationInfo.applicationVersion];
         
-        [text appendFormat: @"Process:         %@ [%@]\n", processName, processId];
-        [text appendFormat: @"Path:            %@\n", processPath];
-        [text appendFormat: @"Identifier:      %@\n", report.applicationInfo.applicationIdentifier];
-        [text appendFormat: @"Version:         %@\n", versionString];
-        [text appendFormat: @"Code Type:       %@\n", codeType];
-        [text appendFormat: @"Parent Process:  %@ [%@]\n", parentProcessName, parentProcessId];
+        plcrash_text_buffer_append_string(buffer, "Process:         ");
+        plcr_append_object(buffer, processName);
+        plcrash_text_buffer_append_string(buffer, " [");
+        plcr_append_object(buffer, processId);
+        plcrash_text_buffer_append_string(buffer, "]\nPath:            ");
+        plcr_append_object(buffer, processPath);
+        plcrash_text_buffer_append_string(buffer, "\nIdentifier:      ");
+        plcr_append_object(buffer, report.applicationInfo.applicationIdentifier);
+        plcrash_text_buffer_append_string(buffer, "\nVersion:         ");
+        plcr_append_object(buffer, versionString);
+        plcrash_text_buffer_append_string(buffer, "\nCode Type:       ");
+        plcr_append_object(buffer, codeType);
+        plcrash_text_buffer_append_string(buffer, "\nParent Process:  ");
+        plcr_append_object(buffer, parentProcessName);
+        plcrash_text_buffer_append_string(buffer, " [");
+        plcr_append_object(buffer, parentProcessId);
+        plcrash_text_buffer_append_string(buffer, "]\n");
     }
     
-    [text appendString: @"\n"];
+    plcrash_text_buffer_append_string(buffer, "\n");
     
     /* System info */
     {
@@ -243,33 +500,81 @@ static NSInteger binaryImageSort(id binary1, id binary2, void *context);
         if (report.systemInfo.operatingSystemBuild != nil)
             osBuild = report.systemInfo.operatingSystemBuild;
         
-        [text appendFormat: @"Date/Time:       %@\n", report.systemInfo.timestamp];
-        [text appendFormat: @"OS Version:      %@ %@ (%@)\n", osName, report.systemInfo.operatingSystemVersion, osBuild];
-        [text appendFormat: @"Report Version:  104\n"];        
+        plcrash_text_buffer_append_string(buffer, "Date/Time:       ");
+        plcr_append_object(buffer, report.systemInfo.timestamp);
+        plcrash_text_buffer_append_string(buffer, "\nOS Version:      ");
+        plcr_append_object(buffer, osName);
+        plcrash_text_buffer_append_string(buffer, " ");
+        plcr_append_object(buffer, report.systemInfo.operatingSystemVersion);
+        plcrash_text_buffer_append_string(buffer, " (");
+        plcr_append_object(buffer, osBuild);
+        plcrash_text_buffer_append_string(buffer, ")\nReport Version:  104\n");
     }
 
-    [text appendString: @"\n"];
+    plcrash_text_buffer_append_string(buffer, "\n");
 
     /* Exception code */
-    [text appendFormat: @"Exception Type:  %@\n", report.signalInfo.name];
-    [text appendFormat: @"Exception Codes: %@ at 0x%" PRIx64 "\n", report.signalInfo.code, report.signalInfo.address];
-    
+    plcrash_text_buffer_append_string(buffer, "Exception Type:  ");
+    plcr_append_object(buffer, report.signalInfo.name);
+    plcrash_text_buffer_append_string(buffer, "\nException Codes: ");
+    plcr_append_object(buffer, report.signalInfo.code);
+    plcrash_text_buffer_append_string(buffer, " at 0x");
+    plcrash_text_buffer_append_hex(buffer, report.signalInfo.address, 0);
+    plcrash_text_buffer_append_string(buffer, "\n");
+
     for (PLCrashReportThreadInfo *thread in report.threads) {
         if (thread.crashed) {
-            [text appendFormat: @"Crashed Thread:  %ld\n", (long) thread.threadNumber];
+            plcrash_text_buffer_append_string(buffer, "Crashed Thread:  ");
+            plcrash_text_buffer_append_int64(buffer, (int64_t) thread.threadNumber, 0, false);
+            plcrash_text_buffer_append_string(buffer, "\n");
             break;
         }
     }
     
-    [text appendString: @"\n"];
+    plcrash_text_buffer_append_string(buffer, "\n");
     
     /* Uncaught Exception */
     if (report.hasExceptionInfo) {
-        [text appendFormat: @"Application Specific Information:\n"];
-        [text appendFormat: @"*** Terminating app due to uncaught exception '%@', reason: '%@'\n",
-                report.exceptionInfo.exceptionName, report.exceptionInfo.exceptionReason];
+        plcrash_text_buffer_append_string(buffer, "Application Specific Information:\n");
+        plcrash_text_buffer_append_string(buffer, "*** Terminating app due to uncaught exception '");
+        plcr_append_object(buffer, report.exceptionInfo.exceptionName);
+        plcrash_text_buffer_append_string(buffer, "', reason: '");
+        plcr_append_object(buffer, report.exceptionInfo.exceptionReason);
+        plcrash_text_buffer_append_string(buffer, "'\n");
         
-        [text appendString: @"\n"];
+        plcrash_text_buffer_append_string(buffer, "\n");
+    }
+
+    /* Gather the binary images. Image names are converted once, rather than for every frame that references them. */
+    NSArray *imageInfos = report.images;
+    NSUInteger imageCount = [imageInfos count];
+    plcr_text_image_t *images = malloc(sizeof(plcr_text_image_t) * MAX(imageCount, (NSUInteger) 1));
+    plcr_text_image_t *sortedImages = malloc(sizeof(plcr_text_image_t) * MAX(imageCount, (NSUInteger) 1));
+    CFMutableDictionaryRef imageMap = CFDictionaryCreateMutable(NULL, imageCount, NULL, NULL);
+    if (images == NULL || sortedImages == NULL || imageMap == NULL) {
+        free(images);
+        free(sortedImages);
+        if (imageMap != NULL)
+            CFRelease(imageMap);
+        return NO;
+    }
+
+    const char *processPath = [report.processInfo.processPath UTF8String];
+    for (NSUInteger i = 0; i < imageCount; i++) {
+        PLCrashReportBinaryImageInfo *imageInfo = [imageInfos objectAtIndex: i];
+        plcr_text_image_t *image = &images[i];
+
+        image->info = imageInfo;
+        image->index = i;
+        image->base_address = imageInfo.imageBaseAddress;
+        image->size = imageInfo.imageSize;
+        image->path = [imageInfo.imageName UTF8String];
+        image->name = [[imageInfo.imageName lastPathComponent] UTF8String];
+        if (image->name == NULL)
+            image->name = "(null)";
+        image->name_length = strlen(image->name);
+
+        CFDictionarySetValue(imageMap, imageInfo, image);
     }
 
     /* If an exception stack trace is available, output an Apple-compatible backtrace. */
@@ -277,151 +582,158 @@ static NSInteger binaryImageSort(id binary1, id binary2, void *context);
         PLCrashReportExceptionInfo *exception = report.exceptionInfo;
         
         /* Create the header. */
-        [text appendString: @"Last Exception Backtrace:\n"];
+        plcrash_text_buffer_append_string(buffer, "Last Exception Backtrace:\n");
 
         /* Write out the frames. In raw reports, Apple writes this out as a simple list of PCs. In the minimally
          * post-processed report, Apple writes this out as full frame entries. We use the latter format. */
         for (NSUInteger frame_idx = 0; frame_idx < [exception.stackFrames count]; frame_idx++) {
             PLCrashReportStackFrameInfo *frameInfo = [exception.stackFrames objectAtIndex: frame_idx];
-            [text appendString: [self formatStackFrame: frameInfo frameIndex: frame_idx report: report lp64: lp64]];
+            plcr_append_stack_frame(buffer, frameInfo, frame_idx, report.systemInfo.operatingSystem, report, imageMap, lp64);
         }
-        [text appendString: @"\n"];
+        plcrash_text_buffer_append_string(buffer, "\n");
     }
 
     /* Threads */
     PLCrashReportThreadInfo *crashed_thread = nil;
-    NSInteger maxThreadNum = 0;
     for (PLCrashReportThreadInfo *thread in report.threads) {
+        plcrash_text_buffer_append_string(buffer, "Thread ");
+        plcrash_text_buffer_append_int64(buffer, (int64_t) thread.threadNumber, 0, false);
         if (thread.crashed) {
-            [text appendFormat: @"Thread %ld Crashed:\n", (long) thread.threadNumber];
+            plcrash_text_buffer_append_string(buffer, " Crashed:\n");
             crashed_thread = thread;
         } else {
-            [text appendFormat: @"Thread %ld:\n", (long) thread.threadNumber];
+            plcrash_text_buffer_append_string(buffer, ":\n");
         }
         for (NSUInteger frame_idx = 0; frame_idx < [thread.stackFrames count]; frame_idx++) {
             PLCrashReportStackFrameInfo *frameInfo = [thread.stackFrames objectAtIndex: frame_idx];
-            [text appendString: [self formatStackFrame: frameInfo frameIndex: frame_idx report: report lp64: lp64]];
+            plcr_append_stack_frame(buffer, frameInfo, frame_idx, report.systemInfo.operatingSystem, report, imageMap, lp64);
         }
-        [text appendString: @"\n"];
-
-        /* Track the highest thread number */
-        maxThreadNum = MAX(maxThreadNum, thread.threadNumber);
+        plcrash_text_buffer_append_string(buffer, "\n");
     }
 
     /* Registers */
     if (crashed_thread != nil) {
-        [text appendFormat: @"Thread %ld crashed with %@ Thread State:\n", (long) crashed_thread.threadNumber, codeType];
-        
+        plcrash_text_buffer_append_string(buffer, "Thread ");
+        plcrash_text_buffer_append_int64(buffer, (int64_t) crashed_thread.threadNumber, 0, false);
+        plcrash_text_buffer_append_string(buffer, " crashed with ");
+        plcr_append_object(buffer, codeType);
+        plcrash_text_buffer_append_string(buffer, " Thread State:\n");
+
+        /* Apple uses 'ip' rather than 'r12' on ARM */
+        BOOL remapARMRegisters = NO;
+        if (report.machineInfo != nil && report.machineInfo.processorInfo.typeEncoding == PLCrashReportProcessorTypeEncodingMach) {
+            PLCrashReportProcessorInfo *pinfo = report.machineInfo.processorInfo;
+            cpu_type_t arch_type = pinfo.type & ~CPU_ARCH_MASK;
+            if (arch_type == CPU_TYPE_ARM)
+                remapARMRegisters = YES;
+        }
+
         int regColumn = 0;
         for (PLCrashReportRegisterInfo *reg in crashed_thread.registers) {
-            NSString *reg_fmt;
-            
-            /* Use 32-bit or 64-bit fixed width format for the register values */
-            if (lp64)
-                reg_fmt = @"%6s: 0x%016" PRIx64 " ";
-            else
-                reg_fmt = @"%6s: 0x%08" PRIx64 " ";
-            
             /* Remap register names to match Apple's crash reports */
-            NSString *regName = reg.registerName;
-            if (report.machineInfo != nil && report.machineInfo.processorInfo.typeEncoding == PLCrashReportProcessorTypeEncodingMach) {
-                PLCrashReportProcessorInfo *pinfo = report.machineInfo.processorInfo;
-                cpu_type_t arch_type = pinfo.type & ~CPU_ARCH_MASK;
-
-                /* Apple uses 'ip' rather than 'r12' on ARM */
-                if (arch_type == CPU_TYPE_ARM && [regName isEqual: @"r12"]) {
-                    regName = @"ip";
-                }
-            }
-            [text appendFormat: reg_fmt, [regName UTF8String], reg.registerValue];
+            const char *regName = [reg.registerName UTF8String];
+            if (regName == NULL)
+                regName = "(null)";
+            if (remapARMRegisters && strcmp(regName, "r12") == 0)
+                regName = "ip";
+
+            /* Use 32-bit or 64-bit fixed width format for the register values */
+            plcrash_text_buffer_append_padded(buffer, regName, strlen(regName), 6, false);
+            plcrash_text_buffer_append(buffer, ": 0x", 4);
+            plcrash_text_buffer_append_hex(buffer, reg.registerValue, lp64 ? 16 : 8);
+            plcrash_text_buffer_append(buffer, " ", 1);
 
             regColumn++;
             if (regColumn == 4) {
-                [text appendString: @"\n"];
+                plcrash_text_buffer_append_string(buffer, "\n");
                 regColumn = 0;
             }
         }
         
         if (regColumn != 0)
-            [text appendString: @"\n"];
+            plcrash_text_buffer_append_string(buffer, "\n");
         
-        [text appendString: @"\n"];
+        plcrash_text_buffer_append_string(buffer, "\n");
     }
     
     /* Images. The iPhone crash report format sorts these in ascending order, by the base address */
-    [text appendString: @"Binary Images:\n"];
+    if (imageCount > 0)
+        memcpy(sortedImages, images, sizeof(plcr_text_image_t) * imageCount);
+    qsort(sortedImages, imageCount, sizeof(plcr_text_image_t), plcr_text_image_compare);
+
+    plcrash_text_buffer_append_string(buffer, "Binary Images:\n");
     uint64_t lastImageBaseAddress = 0;
-    for (PLCrashReportBinaryImageInfo *imageInfo in [report.images sortedArrayUsingFunction: binaryImageSort context: nil]) {
+    for (NSUInteger i = 0; i < imageCount; i++) {
+        const plcr_text_image_t *image = &sortedImages[i];
+
         /* Remove duplicates */
-        uint64_t imageBaseAddress = [imageInfo imageBaseAddress];
+        uint64_t imageBaseAddress = image->base_address;
         if (lastImageBaseAddress == imageBaseAddress) {
             continue;
         }
         lastImageBaseAddress = imageBaseAddress;
 
-        NSString *uuid;
         /* Fetch the UUID if it exists */
-        if (imageInfo.hasImageUUID)
-            uuid = imageInfo.imageUUID;
-        else
-            uuid = @"???";
-        
+        const char *uuid = "???";
+        if (image->info.hasImageUUID)
+            uuid = [image->info.imageUUID UTF8String];
+
         /* Determine the architecture string */
-        NSString *archName = @"???";
-        if (imageInfo.codeType != nil && imageInfo.codeType.typeEncoding == PLCrashReportProcessorTypeEncodingMach) {
-            switch (imageInfo.codeType.type) {
+        const char *archName = "???";
+        if (image->info.codeType != nil && image->info.codeType.typeEncoding == PLCrashReportProcessorTypeEncodingMach) {
+            switch (image->info.codeType.type) {
                 case CPU_TYPE_ARM:
                     /* Apple includes subtype for ARM binaries. */
-                    switch (imageInfo.codeType.subtype) {
+                    switch (image->info.codeType.subtype) {
                         case CPU_SUBTYPE_ARM_V6:
-                            archName = @"armv6";
+                            archName = "armv6";
                             break;
 
                         case CPU_SUBTYPE_ARM_V7:
-                            archName = @"armv7";
+                            archName = "armv7";
                             break;
                             
                         case CPU_SUBTYPE_ARM_V7S:
-                            archName = @"armv7s";
+                            archName = "armv7s";
                             break;
 
                         default:
-                            archName = @"arm-unknown";
+                            archName = "arm-unknown";
                             break;
                     }
                     break;
                     
                 case CPU_TYPE_ARM64:
                     /* Apple includes subtype for ARM64 binaries. */
-                    switch (imageInfo.codeType.subtype) {
+                    switch (image->info.codeType.subtype) {
                         case CPU_SUBTYPE_ARM64_ALL:
-                            archName = @"arm64";
+                            archName = "arm64";
                             break;
 
                         case CPU_SUBTYPE_ARM64_V8:
-                            archName = @"armv8";
+                            archName = "armv8";
                             break;
 
                         case CPU_SUBTYPE_ARM64E:
-                            archName = @"arm64e";
+                            archName = "arm64e";
                             break;
 
                         default:
-                            archName = @"arm64-unknown";
+                            archName = "arm64-unknown";
                             break;
                     }
                     break;
                     
                 case CPU_TYPE_X86:
-                    archName = @"i386";
+                    archName = "i386";
                     break;
                     
                 case CPU_TYPE_X86_64:
-                    archName = @"x86_64";
+                    archName = "x86_64";
                     break;
 
                 case CPU_TYPE_POWERPC:
-                    archName = @"powerpc";
+                    archName = "powerpc";
                     break;
 
                 default:
@@ -431,145 +743,30 @@ static NSInteger binaryImageSort(id binary1, id binary2, void *context);
         }
 
         /* Determine if this is the main executable */
-        NSString *binaryDesignator = @" ";
-        if ([imageInfo.imageName isEqual: report.processInfo.processPath])
-            binaryDesignator = @"+";
+        const char *binaryDesignator = " ";
+        if (image->path != NULL && processPath != NULL && strcmp(image->path, processPath) == 0)
+            binaryDesignator = "+";
         
         /* base_address - terminating_address [designator]file_name arch <uuid> file_path */
-        NSString *fmt = nil;
-        if (lp64) {
-            fmt = @"%18#" PRIx64 " - %18#" PRIx64 " %@%@ %@  <%@> %@\n";
-        } else {
-            fmt = @"%10#" PRIx64 " - %10#" PRIx64 " %@%@ %@  <%@> %@\n";
-        }
-
-        [text appendFormat: fmt,
-                            imageInfo.imageBaseAddress,
-                            imageInfo.imageBaseAddress + (MAX(1, imageInfo.imageSize) - 1), // The Apple format uses an inclusive range
-                            binaryDesignator,
-                            [imageInfo.imageName lastPathComponent],
-                            archName,
-                            uuid,
-                            imageInfo.imageName];
+        size_t addressWidth = lp64 ? 18 : 10;
+        plcrash_text_buffer_append_hex_alternate(buffer, image->base_address, addressWidth);
+        plcrash_text_buffer_append(buffer, " - ", 3);
+        plcrash_text_buffer_append_hex_alternate(buffer, image->base_address + (MAX(1, image->size) - 1), addressWidth); // The Apple format uses an inclusive range
+        plcrash_text_buffer_append(buffer, " ", 1);
+        plcrash_text_buffer_append_string(buffer, binaryDesignator);
+        plcrash_text_buffer_append(buffer, image->name, image->name_length);
+        plcrash_text_buffer_append(buffer, " ", 1);
+        plcrash_text_buffer_append_string(buffer, archName);
+        plcrash_text_buffer_append(buffer, "  <", 3);
+        plcrash_text_buffer_append_string(buffer, uuid);
+        plcrash_text_buffer_append(buffer, "> ", 2);
+        plcrash_text_buffer_append_string(buffer, image->path);
+        plcrash_text_buffer_append(buffer, "\n", 1);
     }
-    
 
-    return text;
-}
+    free(images);
+    free(sortedImages);
+    CFRelease(imageMap);
 
-/**
- * Initialize with the request string encoding and output format.
- *
- * @param textFormat Format to use for the generated text crash report.
- * @param stringEncoding Encoding to use when writing to the output stream.
- */
-- (id) initWithTextFormat: (PLCrashReportTextFormat) textFormat stringEncoding: (NSStringEncoding) stringEncoding {
-    if ((self = [super init]) == nil)
-        return nil;
-    
-    _textFormat = textFormat;
-    _stringEncoding = stringEncoding;
-
-    return self;
-}
-
-// from PLCrashReportFormatter protocol
-- (NSData *) formatReport: (PLCrashReport *) report error: (NSError **) outError {
-    NSString *text = [PLCrashReportTextFormatter stringValueForCrashReport: report withTextFormat: _textFormat];
-    return [text dataUsingEncoding: _stringEncoding allowLossyConversion: YES];
+    return !plcrash_text_buffer_failed(buffer);
 }
-		 
-@end
-
-
-@implementation PLCrashReportTextFormatter (PrivateMethods)
-
-/**
- * Format a stack frame for display in a thread backtrace.
- *
- * @param frameInfo The stack frame to format
- * @param frameIndex The frame's index
- * @param report The report from which this frame was acquired.
- * @param lp64 If YES, the report was generated by an LP64 system.
- *
- * @return Returns a formatted frame line.
- */
-+ (NSString *) formatStackFrame: (PLCrashReportStackFrameInfo *) frameInfo
-                     frameIndex: (NSUInteger) frameIndex
-                         report: (PLCrashReport *) report
-                           lp64: (BOOL) lp64
-{
-    /* Base image address containing instrumention pointer, offset of the IP from that base
-     * address, and the associated image name */
-    uint64_t baseAddress = 0x0;
-    uint64_t pcOffset = 0x0;
-    NSString *imageName = @"\?\?\?";
-    NSString *symbolString = nil;
-
-    uint64_t normalizedInstructionPointer = frameInfo.instructionPointer;
-#if __DARWIN_OPAQUE_ARM_THREAD_STATE64
-    normalizedInstructionPointer &= 0x0000000fffffffff;
-#endif
-
-    PLCrashReportBinaryImageInfo *imageInfo = [report imageForAddress: normalizedInstructionPointer];
-    if (imageInfo != nil) {
-        imageName = [imageInfo.imageName lastPathComponent];
-        baseAddress = imageInfo.imageBaseAddress;
-        pcOffset = normalizedInstructionPointer - imageInfo.imageBaseAddress;
-    }
-
-    /* If symbol info is available, the format used in Apple's reports is Sym + OffsetFromSym. Otherwise,
-     * the format used is imageBaseAddress + offsetToIP */
-    if (frameInfo.symbolInfo != nil) {
-        NSString *symbolName = frameInfo.symbolInfo.symbolName;
-
-        /* Apple strips the _ symbol prefix in their reports. Only OS X makes use of an
-         * underscore symbol prefix by default. */
-        if ([symbolName rangeOfString: @"_"].location == 0 && [symbolName length] > 1) {
-            switch (report.systemInfo.operatingSystem) {
-                case PLCrashReportOperatingSystemMacOSX:
-                case PLCrashReportOperatingSystemiPhoneOS:
-                case PLCrashReportOperatingSystemAppleTVOS:
-                case PLCrashReportOperatingSystemiPhoneSimulator:
-                    symbolName = [symbolName substringFromIndex: 1];
-                    break;
-
-                default:
-                    NSLog(@"Symbol prefix rules are unknown for this OS!");
-                    break;
-            }
-        }
-        
-        
-        uint64_t symOffset = normalizedInstructionPointer - frameInfo.symbolInfo.startAddress;
-        symbolString = [NSString stringWithFormat: @"%@ + %" PRId64, symbolName, symOffset];
-    } else {
-        symbolString = [NSString stringWithFormat: @"0x%" PRIx64 " + %" PRId64, baseAddress, pcOffset];
-    }
-
-    /* Note that width specifiers are ignored for %@, but work for C strings.
-     * UTF-8 is not correctly handled with %s (it depends on the system encoding), but
-     * UTF-16 is supported via %S, so we use it here */
-    return [NSString stringWithFormat: @"%-4ld%-35S 0x%0*" PRIx64 " %@\n",
-            (long) frameIndex,
-            (const uint16_t *)[imageName cStringUsingEncoding: NSUTF16StringEncoding],
-            lp64 ? 16 : 8, normalizedInstructionPointer,
-            symbolString];
-}
-
-/**
- * Sort PLCrashReportBinaryImageInfo instances by their starting address.
- */
-static NSInteger binaryImageSort(id binary1, id binary2, void *context) {
-    uint64_t addr1 = [binary1 imageBaseAddress];
-    uint64_t addr2 = [binary2 imageBaseAddress];
-    
-    if (addr1 < addr2)
-        return NSOrderedAscending;
-    else if (addr1 > addr2)
-        return NSOrderedDescending;
-    else
-        return NSOrderedSame;
-}
-
-@end
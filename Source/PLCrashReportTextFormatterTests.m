@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#import "PLCrashTestCase.h"
+
+#import "PLCrashReportTextFormatter.h"
+#import "PLCrashReporter.h"
+#import "PLCrashReport.h"
+#import "PLCrashTestThread.h"
+
+#import <mach/mach_time.h>
+
+/** The number of times each corpus report is formatted by the throughput benchmark. */
+#define FORMATTER_BENCHMARK_ITERATIONS 50
+
+/** The number of test threads spawned while generating the report corpus. */
+#define CORPUS_THREAD_COUNT 4
+
+@interface PLCrashReportTextFormatterTests : PLCrashTestCase {
+@private
+    /** The report corpus (PLCrashReport instances). */
+    NSMutableArray *_corpus;
+}
+@end
+
+@implementation PLCrashReportTextFormatterTests
+
+- (void) setUp {
+    PLCrashReporterSymbolicationStrategy strategies[] = { PLCrashReporterSymbolicationStrategyNone, PLCrashReporterSymbolicationStrategyAll };
+    plcrash_test_thread_t threads[CORPUS_THREAD_COUNT];
+    NSError *error;
+
+    _corpus = [[NSMutableArray alloc] init];
+
+    for (size_t i = 0; i < CORPUS_THREAD_COUNT; i++)
+        plcrash_test_thread_spawn(&threads[i]);
+
+    /* Generate a live report for each test thread, and for the current thread, with and without symbolication */
+    for (size_t s = 0; s < sizeof(strategies) / sizeof(strategies[0]); s++) {
+        PLCrashReporterConfig *config = [[[PLCrashReporterConfig alloc] initWithSignalHandlerType: PLCrashReporterSignalHandlerTypeBSD
+                                                                           symbolicationStrategy: strategies[s]] autorelease];
+        PLCrashReporter *reporter = [[[PLCrashReporter alloc] initWithConfiguration: config] autorelease];
+
+        for (size_t i = 0; i <= CORPUS_THREAD_COUNT; i++) {
+            NSData *data;
+            if (i < CORPUS_THREAD_COUNT) {
+                data = [reporter generateLiveReportWithThread: pthread_mach_thread_np(threads[i].thread) error: &error];
+            } else {
+                data = [reporter generateLiveReportAndReturnError: &error];
+            }
+            STAssertNotNil(data, @"Failed to generate live report: %@", error);
+
+            PLCrashReport *report = [[[PLCrashReport alloc] initWithData: data error: &error] autorelease];
+            STAssertNotNil(report, @"Could not parse generated live report: %@", error);
+            if (report != nil)
+                [_corpus addObject: report];
+        }
+    }
+
+    for (size_t i = 0; i < CORPUS_THREAD_COUNT; i++)
+        plcrash_test_thread_stop(&threads[i]);
+}
+
+- (void) tearDown {
+    [_corpus release];
+}
+
+/**
+ * Verify the formatter output for a fixture report against its checked-in text, via both the UTF-8 byte buffer
+ * and the string conversion paths.
+ */
+- (void) testFormatFixtureReport {
+    NSError *error;
+
+    PLCrashReport *report = [[[PLCrashReport alloc] initWithData: [self dataForTestResource: @"report.plcrash"] error: &error] autorelease];
+    STAssertNotNil(report, @"Could not parse fixture report: %@", error);
+
+    NSData *expectedData = [self dataForTestResource: @"report.crash"];
+    NSString *expected = [[[NSString alloc] initWithData: expectedData encoding: NSUTF8StringEncoding] autorelease];
+    STAssertNotNil(expected, @"Could not decode the expected text");
+
+    NSString *actual = [PLCrashReportTextFormatter stringValueForCrashReport: report withTextFormat: PLCrashReportTextFormatiOS];
+    STAssertEqualStrings(expected, actual, @"Formatted report does not match the expected text");
+
+    PLCrashReportTextFormatter *formatter = [[[PLCrashReportTextFormatter alloc] initWithTextFormat: PLCrashReportTextFormatiOS
+                                                                                     stringEncoding: NSUTF8StringEncoding] autorelease];
+    NSData *actualData = [formatter formatReport: report error: &error];
+    STAssertNotNil(actualData, @"Failed to format report: %@", error);
+    STAssertEqualObjects(expectedData, actualData, @"Formatted report bytes do not match the expected text");
+
+    formatter = [[[PLCrashReportTextFormatter alloc] initWithTextFormat: PLCrashReportTextFormatiOS
+                                                         stringEncoding: NSUTF16LittleEndianStringEncoding] autorelease];
+    actualData = [formatter formatReport: report error: &error];
+    STAssertNotNil(actualData, @"Failed to format report: %@", error);
+    STAssertEqualObjects([expected dataUsingEncoding: NSUTF16LittleEndianStringEncoding], actualData, @"UTF-16 report bytes do not match the expected text");
+}
+
+/**
+ * Verify that every live report is formatted, and that the byte buffer and string conversion paths agree.
+ */
+- (void) testFormatLiveReports {
+    PLCrashReportTextFormatter *formatter = [[[PLCrashReportTextFormatter alloc] initWithTextFormat: PLCrashReportTextFormatiOS
+                                                                                     stringEncoding: NSUTF8StringEncoding] autorelease];
+    NSError *error;
+
+    STAssertNotEquals((NSUInteger) 0, [_corpus count], @"Empty report corpus");
+    for (PLCrashReport *report in _corpus) {
+        NSString *text = [PLCrashReportTextFormatter stringValueForCrashReport: report withTextFormat: PLCrashReportTextFormatiOS];
+        STAssertNotNil(text, @"Failed to format report");
+        STAssertTrue([text hasPrefix: @"Incident Identifier: "], @"Unexpected report header");
+
+        NSData *data = [formatter formatReport: report error: &error];
+        STAssertNotNil(data, @"Failed to format report: %@", error);
+        STAssertEqualObjects([text dataUsingEncoding: NSUTF8StringEncoding], data, @"Formatted bytes do not match the string value");
+    }
+}
+
+/**
+ * Measure the throughput of the formatter over the report corpus.
+ */
+- (void) testFormatterBenchmark {
+    PLCrashReportTextFormatter *formatter = [[[PLCrashReportTextFormatter alloc] initWithTextFormat: PLCrashReportTextFormatiOS
+                                                                                     stringEncoding: NSUTF8StringEncoding] autorelease];
+    mach_timebase_info_data_t timebase;
+    uint64_t total = 0;
+    size_t bytes = 0;
+
+    mach_timebase_info(&timebase);
+
+    for (uint32_t i = 0; i < FORMATTER_BENCHMARK_ITERATIONS; i++) {
+        for (PLCrashReport *report in _corpus) {
+            NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+
+            uint64_t start = mach_absolute_time();
+            NSData *formatted = [formatter formatReport: report error: NULL];
+            total += mach_absolute_time() - start;
+
+            STAssertNotNil(formatted, @"Formatter failed");
+            bytes += [formatted length];
+
+            [pool drain];
+        }
+    }
+
+    double reports = (double) FORMATTER_BENCHMARK_ITERATIONS * [_corpus count];
+    double ns = (double) total * timebase.numer / timebase.denom;
+
+    fprintf(stderr, "Text formatter benchmark: %lu reports, %lu output bytes\n", (unsigned long) reports, (unsigned long) bytes);
+    fprintf(stderr, "  %14.0f ns/report, %.1f MB/s\n", ns / reports, bytes / (ns / 1e9) / (1024 * 1024));
+}
+
+@end
@@ -126,9 +126,16 @@ typedef struct PLCrashReporterCallbacks {
 - (NSData *) generateLiveReport;
 - (NSData *) generateLiveReportAndReturnError: (NSError **) outError;
 
+- (NSData *) generateWatchdogReportWithThread: (thread_t) thread error: (NSError **) outError;
+
 - (BOOL) purgePendingCrashReport;
 - (BOOL) purgePendingCrashReportAndReturnError: (NSError **) outError;
 
+- (NSArray *) queuedCrashReportPaths;
+- (NSArray *) loadQueuedCrashReportDataAndReturnError: (NSError **) outError;
+- (BOOL) purgeQueuedCrashReportAtPath: (NSString *) path error: (NSError **) outError;
+- (BOOL) purgeQueuedCrashReportsAndReturnError: (NSError **) outError;
+
 - (BOOL) enableCrashReporter;
 - (BOOL) enableCrashReporterAndReturnError: (NSError **) outError;
 
@@ -66,6 +66,10 @@ static NSString *PLCRASH_LIVE_CRASHREPORT = @"live_report.plcrash";
  * Directory containing crash reports queued for sending. */
 static NSString *PLCRASH_QUEUED_DIR = @"queued_reports";
 
+/** @internal
+ * Queued crash report slot file name format; the single argument is the slot index. */
+static NSString *PLCRASH_QUEUED_REPORT_FORMAT = @"report_%lu.plcrash";
+
 /** @internal
  * Maximum number of bytes that will be written to the crash report.
  * Used as a safety measure in case of implementation malfunction.
@@ -77,6 +81,13 @@ static NSString *PLCRASH_QUEUED_DIR = @"queued_reports";
  */
 #define MAX_REPORT_BYTES (256 * 1024)
 
+/**
+ * @internal
+ * Initial in-memory buffer size used when generating live reports. The buffer is grown as required, up to
+ * MAX_REPORT_BYTES.
+ */
+#define LIVE_REPORT_INITIAL_BYTES (64 * 1024)
+
 /**
  * @internal
  * Fatal signals to be monitored.
@@ -105,6 +116,18 @@ typedef struct signal_handler_ctx {
     /** Path to the output file */
     const char *path;
 
+    /** Preopened output file descriptor, or -1 if the output file must be created at crash time. */
+    int fd;
+
+    /** Preallocated page cache used while writing the crash report. */
+    plcrash_async_page_cache_t page_cache;
+
+    /** Preallocated mapping pool used while writing the crash report. */
+    plcrash_async_mobject_pool_t mobject_pool;
+
+    /** Preallocated string table used while writing the crash report, if enabled. */
+    plcrash_async_string_table_t string_table;
+
 #if PLCRASH_FEATURE_MACH_EXCEPTIONS
     /* Previously registered Mach exception ports, if any. Will be left uninitialized if PLCrashReporterSignalHandlerTypeMach
      * is not enabled. */
@@ -152,12 +175,31 @@ static PLCrashReporterCallbacks crashCallbacks = {
 static plcrash_error_t plcrash_write_report (plcrashreporter_handler_ctx_t *sigctx, thread_t crashed_thread, plcrash_async_thread_state_t *thread_state, plcrash_log_signal_info_t *siginfo) {
     plcrash_async_file_t file;
     plcrash_error_t err;
-
-    /* Open the output file */
-    int fd = open(sigctx->path, O_RDWR|O_CREAT|O_TRUNC, 0644);
-    if (fd < 0) {
-        PLCF_DEBUG("Could not open the crashlog output file: %s", strerror(errno));
-        return PLCRASH_EINTERNAL;
+    bool preopened = false;
+    int fd;
+
+    /* Use the preopened output file if available; otherwise, open the output file. Ownership of a preopened file
+     * is claimed here, so that the descriptor is never reused once it has been closed on any of the paths below. */
+    if (sigctx->fd >= 0) {
+        fd = sigctx->fd;
+        sigctx->fd = -1;
+        preopened = true;
+
+        if (lseek(fd, 0, SEEK_SET) != 0) {
+            PLCF_DEBUG("Could not seek the preopened crashlog output file: %s", strerror(errno));
+
+            /* Don't leave a previous report in place to be mistaken for this one */
+            if (ftruncate(fd, 0) != 0)
+                PLCF_DEBUG("Failed to truncate output file: %s", strerror(errno));
+            close(fd);
+            return PLCRASH_EINTERNAL;
+        }
+    } else {
+        fd = open(sigctx->path, O_RDWR|O_CREAT|O_TRUNC, 0644);
+        if (fd < 0) {
+            PLCF_DEBUG("Could not open the crashlog output file: %s", strerror(errno));
+            return PLCRASH_EINTERNAL;
+        }
     }
     
     /* Initialize the output context */
@@ -169,15 +211,30 @@ static plcrash_error_t plcrash_write_report (plcrashreporter_handler_ctx_t *sigc
     /* Close the writer; this may also fail (but shouldn't) */
     if (plcrash_log_writer_close(&sigctx->writer) != PLCRASH_ESUCCESS) {
         PLCF_DEBUG("Failed to close the log writer");
-        plcrash_async_file_close(&file);
-        return PLCRASH_EINTERNAL;
+        err = PLCRASH_EINTERNAL;
+        goto cleanup;
     }
     
     /* Finished */
     if (!plcrash_async_file_flush(&file)) {
         PLCF_DEBUG("Failed to flush output file");
-        plcrash_async_file_close(&file);
-        return PLCRASH_EINTERNAL;
+        err = PLCRASH_EINTERNAL;
+        goto cleanup;
+    }
+
+cleanup:
+    /* Drop any preallocated space, and any previous report data, beyond the end of the bytes written. This must
+     * be done on every path; otherwise a failed or partial write would leave the new report followed by stale
+     * bytes, which would later be read back as a pending report. */
+    if (preopened) {
+        off_t length = lseek(fd, 0, SEEK_CUR);
+        if (length < 0)
+            length = 0;
+
+        if (ftruncate(fd, length) != 0) {
+            PLCF_DEBUG("Failed to truncate output file: %s", strerror(errno));
+            err = PLCRASH_EINTERNAL;
+        }
     }
     
     if (!plcrash_async_file_close(&file)) {
@@ -188,6 +245,37 @@ static plcrash_error_t plcrash_write_report (plcrashreporter_handler_ctx_t *sigc
     return err;
 }
 
+/**
+ * @internal
+ *
+ * Reserve @a size bytes of storage for @a fd, without modifying the file's length. Storage is reserved
+ * contiguously if possible.
+ *
+ * @param fd The file descriptor for which storage should be reserved.
+ * @param size The number of bytes to reserve beyond the file's current length.
+ *
+ * @return Returns true on success, or false if the storage could not be reserved.
+ */
+static bool plcrash_preallocate_report_file (int fd, off_t size) {
+    if (size <= 0)
+        return true;
+
+    fstore_t store = {
+        .fst_flags = F_ALLOCATECONTIG | F_ALLOCATEALL,
+        .fst_posmode = F_PEOFPOSMODE,
+        .fst_offset = 0,
+        .fst_length = size,
+        .fst_bytesalloc = 0
+    };
+
+    if (fcntl(fd, F_PREALLOCATE, &store) == 0)
+        return true;
+
+    /* Fall back on non-contiguous allocation */
+    store.fst_flags = F_ALLOCATEALL;
+    return fcntl(fd, F_PREALLOCATE, &store) == 0;
+}
+
 /**
  * @internal
  *
@@ -386,11 +474,19 @@ static void uncaught_exception_handler (NSException *exception) {
                                                                         error: (NSError **) outError;
 #endif
 - (plcrash_async_symbol_strategy_t) mapToAsyncSymbolicationStrategy: (PLCrashReporterSymbolicationStrategy) strategy;
+- (plcrash_log_register_encoding_t) mapToAsyncRegisterEncoding: (PLCrashReporterRegisterEncoding) encoding;
+
+- (NSData *) generateReportWithThread: (thread_t) thread reportType: (plcrash_log_report_type_t) reportType error: (NSError **) outError;
 
 - (BOOL) populateCrashReportDirectoryAndReturnError: (NSError **) outError;
 - (NSString *) crashReportDirectory;
 - (NSString *) queuedCrashReportDirectory;
 - (NSString *) crashReportPath;
+- (NSString *) pendingCrashReportPath;
+- (off_t) reportPreallocationSize;
+- (NSString *) queuedCrashReportPathForSlot: (NSUInteger) slot;
+- (NSString *) selectQueuedCrashReportSlot;
+- (BOOL) purgeReportAtPath: (NSString *) path error: (NSError **) outError;
 
 @end
 
@@ -455,10 +551,13 @@ static PLCrashReporter *sharedReporter = nil;
 /**
  * Returns YES if the application has previously crashed and
  * an pending crash report is available.
+ *
+ * If the reporter is configured with more than one report slot (see PLCrashReporterConfig::reportSlotCount), the
+ * oldest queued report is the pending report. Loading and purging the pending report until none remains will
+ * process every queued report, oldest first.
  */
 - (BOOL) hasPendingCrashReport {
-    /* Check for a live crash report file */
-    return [[NSFileManager defaultManager] fileExistsAtPath: [self crashReportPath]];
+    return [self pendingCrashReportPath] != nil;
 }
 
 
@@ -491,8 +590,14 @@ static PLCrashReporter *sharedReporter = nil;
  * @return Returns nil if the crash report data could not be loaded.
  */
 - (NSData *) loadPendingCrashReportDataAndReturnError: (NSError **) outError {
+    NSString *path = [self pendingCrashReportPath];
+    if (path == nil) {
+        plcrash_populate_error(outError, PLCrashReporterErrorCrashReportInvalid, @"No pending crash report is available", nil);
+        return nil;
+    }
+
     /* Load the (memory mapped) data */
-    return [NSData dataWithContentsOfFile: [self crashReportPath] options: NSMappedRead error: outError];
+    return [NSData dataWithContentsOfFile: path options: NSMappedRead error: outError];
 }
 
 
@@ -507,12 +612,105 @@ static PLCrashReporter *sharedReporter = nil;
 
 
 /**
- * Purge a pending crash report.
+ * Purge a pending crash report. If multiple reports are queued, only the oldest report -- as returned by
+ * PLCrashReporter::loadPendingCrashReportDataAndReturnError: -- is purged.
  *
  * @return Returns YES on success, or NO on error.
  */
 - (BOOL) purgePendingCrashReportAndReturnError: (NSError **) outError {
-    return [[NSFileManager defaultManager] removeItemAtPath: [self crashReportPath] error: outError];
+    NSString *path = [self pendingCrashReportPath];
+    if (path == nil)
+        path = [self crashReportPath];
+
+    return [self purgeReportAtPath: path error: outError];
+}
+
+
+/**
+ * Return the paths of all queued crash reports, ordered from oldest to newest. Crash reports are only queued if
+ * the reporter was configured with more than one report slot; see PLCrashReporterConfig::reportSlotCount.
+ *
+ * The report files must not be modified directly; use PLCrashReporter::purgeQueuedCrashReportAtPath:error: to
+ * remove a report once it has been processed.
+ */
+- (NSArray *) queuedCrashReportPaths {
+    NSFileManager *fm = [NSFileManager defaultManager];
+    NSMutableArray *reports = [NSMutableArray array];
+
+    for (NSUInteger slot = 0; slot < _config.reportSlotCount; slot++) {
+        NSString *path = [self queuedCrashReportPathForSlot: slot];
+
+        /* Skip unused, and preallocated but unwritten, slots */
+        NSDictionary *attributes = [fm attributesOfItemAtPath: path error: NULL];
+        if (attributes == nil || [attributes fileSize] == 0)
+            continue;
+
+        [reports addObject: [NSDictionary dictionaryWithObjectsAndKeys: path, @"path", [attributes fileModificationDate], @"date", nil]];
+    }
+
+    [reports sortUsingDescriptors: [NSArray arrayWithObject: [NSSortDescriptor sortDescriptorWithKey: @"date" ascending: YES]]];
+    return [reports valueForKey: @"path"];
+}
+
+
+/**
+ * Load all queued crash reports, ordered from oldest to newest. The report data is memory mapped.
+ *
+ * @param outError A pointer to an NSError object variable. If an error occurs, this pointer
+ * will contain an error object indicating why the queued crash reports could not be
+ * loaded. If no error occurs, this parameter will be left unmodified. You may specify
+ * nil for this parameter, and no error information will be provided.
+ *
+ * @return Returns an array of NSData instances, in the same order as PLCrashReporter::queuedCrashReportPaths, or
+ * nil if a report could not be loaded.
+ */
+- (NSArray *) loadQueuedCrashReportDataAndReturnError: (NSError **) outError {
+    NSArray *paths = [self queuedCrashReportPaths];
+    NSMutableArray *reports = [NSMutableArray arrayWithCapacity: [paths count]];
+
+    for (NSString *path in paths) {
+        NSData *data = [NSData dataWithContentsOfFile: path options: NSMappedRead error: outError];
+        if (data == nil)
+            return nil;
+
+        [reports addObject: data];
+    }
+
+    return reports;
+}
+
+
+/**
+ * Purge a single queued crash report.
+ *
+ * @param path The path of the queued report, as returned by PLCrashReporter::queuedCrashReportPaths.
+ * @param outError A pointer to an NSError object variable. If an error occurs, this pointer
+ * will contain an error object indicating why the report could not be purged. If no error occurs, this parameter
+ * will be left unmodified. You may specify nil for this parameter, and no error information will be provided.
+ *
+ * @return Returns YES on success, or NO on error.
+ */
+- (BOOL) purgeQueuedCrashReportAtPath: (NSString *) path error: (NSError **) outError {
+    return [self purgeReportAtPath: path error: outError];
+}
+
+
+/**
+ * Purge all queued crash reports.
+ *
+ * @param outError A pointer to an NSError object variable. If an error occurs, this pointer
+ * will contain an error object indicating why the reports could not be purged. If no error occurs, this parameter
+ * will be left unmodified. You may specify nil for this parameter, and no error information will be provided.
+ *
+ * @return Returns YES on success, or NO on error.
+ */
+- (BOOL) purgeQueuedCrashReportsAndReturnError: (NSError **) outError {
+    for (NSString *path in [self queuedCrashReportPaths]) {
+        if (![self purgeReportAtPath: path error: outError])
+            return NO;
+    }
+
+    return YES;
 }
 
 
@@ -582,11 +780,45 @@ static PLCrashReporter *sharedReporter = nil;
     if (![self populateCrashReportDirectoryAndReturnError: outError])
         return NO;
 
-    /* Set up the signal handler context */
-    signal_handler_context.path = strdup([[self crashReportPath] UTF8String]); // NOTE: would leak if this were not a singleton struct
+    /* Set up the signal handler context. If multiple report slots are configured, the report slot is selected here,
+     * rather than at crash time, so that the crash handler need not inspect the queued report directory. */
+    NSString *reportPath = [self crashReportPath];
+    if (_config.reportSlotCount > 1)
+        reportPath = [self selectQueuedCrashReportSlot];
+    signal_handler_context.path = strdup([reportPath UTF8String]); // NOTE: would leak if this were not a singleton struct
+
+    /* Preopen the output file and reserve its storage, so that the crash handler need not create or grow the file.
+     * The file is not truncated; any pending report is preserved until a new report is written. If the file can't
+     * be opened, it will be created at crash time. */
+    signal_handler_context.fd = -1;
+    if (_config.reportPreallocationSize > 0) {
+        int fd = open(signal_handler_context.path, O_RDWR|O_CREAT, 0644);
+        if (fd >= 0) {
+            if (!plcrash_preallocate_report_file(fd, [self reportPreallocationSize]))
+                NSDEBUG(@"Could not preallocate the crash report file: %s", strerror(errno));
+            signal_handler_context.fd = fd;
+        } else {
+            NSDEBUG(@"Could not preopen the crash report file: %s", strerror(errno));
+        }
+    }
+
     assert(_applicationIdentifier != nil);
     assert(_applicationVersion != nil);
     plcrash_log_writer_init(&signal_handler_context.writer, _applicationIdentifier, _applicationVersion, _applicationMarketingVersion, [self mapToAsyncSymbolicationStrategy: _config.symbolicationStrategy], false);
+    plcrash_log_writer_set_register_encoding(&signal_handler_context.writer, [self mapToAsyncRegisterEncoding: _config.registerEncoding]);
+    plcrash_log_writer_set_fingerprint_frame_count(&signal_handler_context.writer, (uint32_t) MIN(_config.fingerprintFrameCount, (NSUInteger) UINT32_MAX));
+
+    /* Preallocate the page cache used at crash time; if allocation fails, reports are written without it. */
+    if (plcrash_async_page_cache_init(&signal_handler_context.page_cache, PLCRASH_ASYNC_PAGE_CACHE_DEFAULT_CAPACITY) == PLCRASH_ESUCCESS)
+        plcrash_log_writer_set_page_cache(&signal_handler_context.writer, &signal_handler_context.page_cache);
+
+    /* Likewise for the mapping pool; if allocation fails, each mapping is created and released individually. */
+    if (plcrash_async_mobject_pool_init(&signal_handler_context.mobject_pool, PLCRASH_ASYNC_MOBJECT_POOL_DEFAULT_CAPACITY, PLCRASH_ASYNC_MOBJECT_POOL_DEFAULT_MAX_SIZE) == PLCRASH_ESUCCESS)
+        plcrash_log_writer_set_mobject_pool(&signal_handler_context.writer, &signal_handler_context.mobject_pool);
+
+    /* Preallocate the string table, if enabled; if allocation fails, names are written inline. */
+    if (_config.shouldUseStringTable && plcrash_async_string_table_init(&signal_handler_context.string_table, PLCRASH_ASYNC_STRING_TABLE_DEFAULT_CAPACITY, PLCRASH_ASYNC_STRING_TABLE_DEFAULT_STORAGE_SIZE) == PLCRASH_ESUCCESS)
+        plcrash_log_writer_set_string_table(&signal_handler_context.writer, &signal_handler_context.string_table);
     
     
     /* Enable the signal handler */
@@ -692,29 +924,75 @@ static plcrash_error_t plcr_live_report_callback (plcrash_async_thread_state_t *
  * error information will be provided.
  *
  * @return Returns nil if the crash report data could not be loaded.
- *
- * @todo Implement in-memory, rather than requiring writing of the report to disk.
  */
 - (NSData *) generateLiveReportWithThread: (thread_t) thread error: (NSError **) outError {
+    return [self generateReportWithThread: thread reportType: PLCRASH_LOG_REPORT_TYPE_LIVE error: outError];
+}
+
+
+/**
+ * Generate a watchdog report for a given @a thread, without triggering an actual crash condition. This
+ * may be used to record process state when a watchdog condition -- such as a main thread stall -- is detected.
+ * The report will be marked as a PLCrashReportTypeWatchdog report, and @a thread will be marked as the
+ * responsible (crashed) thread.
+ *
+ * @param thread The thread responsible for the watchdog event.
+ * @param outError A pointer to an NSError object variable. If an error occurs, this pointer
+ * will contain an error object indicating why the report could not be generated. If no
+ * error occurs, this parameter will be left unmodified. You may specify nil for this parameter, and no
+ * error information will be provided.
+ *
+ * @return Returns nil if the report data could not be generated.
+ */
+- (NSData *) generateWatchdogReportWithThread: (thread_t) thread error: (NSError **) outError {
+    return [self generateReportWithThread: thread reportType: PLCRASH_LOG_REPORT_TYPE_WATCHDOG error: outError];
+}
+
+
+/* CFAllocator deallocation callback used to release live report buffers; the allocation size is passed as the
+ * allocator's info pointer. */
+static void plcr_live_report_deallocate (void *ptr, void *info) {
+    vm_deallocate(mach_task_self(), (vm_address_t) ptr, (vm_size_t) (uintptr_t) info);
+}
+
+/**
+ * @internal
+ * Generate a non-fatal report of @a reportType for the given @a thread. The report data will be
+ * returned on success.
+ *
+ * The report is written directly to a growable in-memory buffer, and the returned NSData instance takes ownership
+ * of that buffer without copying it.
+ *
+ * @param thread The thread which will be marked as the failing thread in the generated report.
+ * @param reportType The report type to be recorded in the report.
+ * @param outError A pointer to an NSError object variable. If an error occurs, this pointer
+ * will contain an error object indicating why the crash report could not be generated or loaded.
+ *
+ * @return Returns nil if the crash report data could not be loaded.
+ */
+- (NSData *) generateReportWithThread: (thread_t) thread reportType: (plcrash_log_report_type_t) reportType error: (NSError **) outError {
     plcrash_log_writer_t writer;
     plcrash_async_file_t file;
     plcrash_error_t err;
 
-    /* Open the output file */
-    NSString *templateStr = [NSTemporaryDirectory() stringByAppendingPathComponent: @"live_crash_report.XXXXXX"];
-    char *path = strdup([templateStr fileSystemRepresentation]);
-    
-    int fd = mkstemp(path);
-    if (fd < 0) {
-        plcrash_populate_posix_error(outError, errno, NSLocalizedString(@"Failed to create temporary path", @"Error opening temporary output path"));
-        free(path);
-
+    /* Initialize the output buffer */
+    if ((err = plcrash_async_file_init_growable(&file, LIVE_REPORT_INITIAL_BYTES, MAX_REPORT_BYTES)) != PLCRASH_ESUCCESS) {
+        plcrash_populate_error(outError, PLCrashReporterErrorOperatingSystem, @"Failed to allocate the live crash report buffer", nil);
         return nil;
     }
 
     /* Initialize the output context */
     plcrash_log_writer_init(&writer, _applicationIdentifier, _applicationVersion, _applicationMarketingVersion, [self mapToAsyncSymbolicationStrategy: _config.symbolicationStrategy], true);
-    plcrash_async_file_init(&file, fd, MAX_REPORT_BYTES);
+    plcrash_log_writer_set_report_type(&writer, reportType);
+    plcrash_log_writer_set_register_encoding(&writer, [self mapToAsyncRegisterEncoding: _config.registerEncoding]);
+    plcrash_log_writer_set_fingerprint_frame_count(&writer, (uint32_t) MIN(_config.fingerprintFrameCount, (NSUInteger) UINT32_MAX));
+
+    plcrash_async_string_table_t string_table;
+    bool string_table_enabled = false;
+    if (_config.shouldUseStringTable && plcrash_async_string_table_init(&string_table, PLCRASH_ASYNC_STRING_TABLE_DEFAULT_CAPACITY, PLCRASH_ASYNC_STRING_TABLE_DEFAULT_STORAGE_SIZE) == PLCRASH_ESUCCESS) {
+        plcrash_log_writer_set_string_table(&writer, &string_table);
+        string_table_enabled = true;
+    }
     
     /* Mock up a SIGTRAP-based signal info */
     plcrash_log_bsd_signal_info_t bsd_signal_info;
@@ -738,38 +1016,44 @@ static plcrash_error_t plcr_live_report_callback (plcrash_async_thread_state_t *
         err = plcrash_log_writer_write(&writer, thread, &shared_image_list, &file, &signal_info, NULL);
     }
     plcrash_log_writer_close(&writer);
-
-    /* Flush the data */
-    plcrash_async_file_flush(&file);
-    plcrash_async_file_close(&file);
+    plcrash_log_writer_free(&writer);
+    if (string_table_enabled)
+        plcrash_async_string_table_free(&string_table);
 
     /* Check for write failure */
-    NSData *data;
+    NSData *data = nil;
     if (err != PLCRASH_ESUCCESS) {
         NSLog(@"Write failed with error %s", plcrash_async_strerror(err));
-        plcrash_populate_error(outError, PLCrashReporterErrorUnknown, @"Failed to write the crash report to disk", nil);
-        data = nil;
-        goto cleanup;
+        plcrash_populate_error(outError, PLCrashReporterErrorUnknown, @"Failed to write the crash report", nil);
+        plcrash_async_file_close(&file);
+        return nil;
     }
 
-    data = [NSData dataWithContentsOfFile: [NSString stringWithUTF8String: path]];
-    if (data == nil) {
-        /* This should only happen if our data is deleted out from under us */
-        plcrash_populate_error(outError, PLCrashReporterErrorUnknown, NSLocalizedString(@"Unable to open live crash report for reading", nil), nil);
-        goto cleanup;
-    }
+    /* Hand the buffer off to a CFData instance. The allocator is retained by the data instance, and will
+     * deallocate the buffer once the data is released. */
+    size_t length;
+    size_t allocationSize;
+    void *bytes = plcrash_async_file_buffer_detach(&file, &length, &allocationSize);
+    plcrash_async_file_close(&file);
 
-cleanup:
-    /* Finished -- clean up. */
-    plcrash_log_writer_free(&writer);
+    CFAllocatorContext allocatorContext = {
+        .version = 0,
+        .info = (void *) (uintptr_t) allocationSize,
+        .deallocate = plcr_live_report_deallocate
+    };
+    CFAllocatorRef deallocator = CFAllocatorCreate(kCFAllocatorDefault, &allocatorContext);
+    if (deallocator != NULL)
+        data = (NSData *) CFDataCreateWithBytesNoCopy(kCFAllocatorDefault, bytes, (CFIndex) length, deallocator);
 
-    if (unlink(path) != 0) {
-        /* This shouldn't fail, but if it does, there's no use in returning nil */
-        NSLog(@"Failure occured deleting live crash report: %s", strerror(errno));
+    if (data == nil) {
+        vm_deallocate(mach_task_self(), (vm_address_t) bytes, allocationSize);
+        plcrash_populate_error(outError, PLCrashReporterErrorOperatingSystem, @"Failed to allocate the live crash report data", nil);
     }
 
-    free(path);
-    return data;
+    if (deallocator != NULL)
+        CFRelease(deallocator);
+
+    return [data autorelease];
 }
 
 
@@ -858,7 +1142,7 @@ cleanup:
         return nil;
 
     /* Save the configuration */
-    _config = [configuration retain];
+    _config = [configuration copy];
     _applicationIdentifier = [applicationIdentifier retain];
     _applicationVersion = [applicationVersion retain];
     _applicationMarketingVersion = [applicationMarketingVersion retain];
@@ -1019,6 +1303,23 @@ cleanup:
     return result;
 }
 
+/**
+ * Map the configuration defined @a encoding to the backing plcrash_log_register_encoding_t representation.
+ *
+ * @param encoding The encoding value to map.
+ */
+- (plcrash_log_register_encoding_t) mapToAsyncRegisterEncoding: (PLCrashReporterRegisterEncoding) encoding {
+    switch (encoding) {
+        case PLCrashReporterRegisterEncodingTyped:
+            return PLCRASH_LOG_REGISTER_ENCODING_TYPED;
+
+        case PLCrashReporterRegisterEncodingNamed:
+            return PLCRASH_LOG_REGISTER_ENCODING_NAMED;
+    }
+
+    return PLCRASH_LOG_REGISTER_ENCODING_NAMED;
+}
+
 /**
  * Validate (and create if necessary) the crash reporter directory structure.
  */
@@ -1069,5 +1370,90 @@ cleanup:
 }
 
 
+/**
+ * Return the path to the pending crash report: the live crash report if it has been written, otherwise the oldest
+ * queued crash report. Returns nil if no report is pending.
+ */
+- (NSString *) pendingCrashReportPath {
+    /* Check for a non-empty live crash report file; the file will exist, but will be empty, if it was preallocated
+     * by a previous session that did not crash. */
+    NSDictionary *attributes = [[NSFileManager defaultManager] attributesOfItemAtPath: [self crashReportPath] error: NULL];
+    if (attributes != nil && [attributes fileSize] > 0)
+        return [self crashReportPath];
+
+    if (_config.reportSlotCount > 1) {
+        NSArray *queued = [self queuedCrashReportPaths];
+        if ([queued count] > 0)
+            return [queued objectAtIndex: 0];
+    }
+
+    return nil;
+}
+
+
+/**
+ * Return the path to the queued crash report in @a slot (which may not yet, or ever, exist).
+ */
+- (NSString *) queuedCrashReportPathForSlot: (NSUInteger) slot {
+    NSString *name = [NSString stringWithFormat: PLCRASH_QUEUED_REPORT_FORMAT, (unsigned long) slot];
+    return [[self queuedCrashReportDirectory] stringByAppendingPathComponent: name];
+}
+
+
+/**
+ * Select the report slot to be used for the next crash report, returning its path. The first free slot is
+ * used; if all slots are in use, the slot holding the oldest report is reused.
+ */
+- (NSString *) selectQueuedCrashReportSlot {
+    NSFileManager *fm = [NSFileManager defaultManager];
+    NSString *oldestPath = nil;
+    NSDate *oldestDate = nil;
+
+    for (NSUInteger slot = 0; slot < _config.reportSlotCount; slot++) {
+        NSString *path = [self queuedCrashReportPathForSlot: slot];
+
+        NSDictionary *attributes = [fm attributesOfItemAtPath: path error: NULL];
+        if (attributes == nil || [attributes fileSize] == 0)
+            return path;
+
+        NSDate *date = [attributes fileModificationDate];
+        if (oldestDate == nil || [date compare: oldestDate] == NSOrderedAscending) {
+            oldestDate = date;
+            oldestPath = path;
+        }
+    }
+
+    return oldestPath;
+}
+
+
+/**
+ * Purge the report at @a path. If the report file has been preopened by the crash handler, it must not be unlinked;
+ * it is truncated instead, and its storage re-reserved.
+ */
+- (BOOL) purgeReportAtPath: (NSString *) path error: (NSError **) outError {
+    if (_enabled && signal_handler_context.fd >= 0 && strcmp([path UTF8String], signal_handler_context.path) == 0) {
+        if (ftruncate(signal_handler_context.fd, 0) != 0) {
+            plcrash_populate_posix_error(outError, errno, @"Failed to truncate the crash report file");
+            return NO;
+        }
+
+        plcrash_preallocate_report_file(signal_handler_context.fd, [self reportPreallocationSize]);
+        return YES;
+    }
+
+    return [[NSFileManager defaultManager] removeItemAtPath: path error: outError];
+}
+
+
+/**
+ * Return the number of bytes to be preallocated for the crash report file. This is the configured
+ * preallocation size, bounded by the maximum report size.
+ */
+- (off_t) reportPreallocationSize {
+    return (off_t) MIN(_config.reportPreallocationSize, (NSUInteger) MAX_REPORT_BYTES);
+}
+
+
 
 @end
@@ -29,6 +29,25 @@
 #import <Foundation/Foundation.h>
 #import "PLCrashFeatureConfig.h"
 
+/**
+ * @ingroup constants
+ * The default number of bytes preallocated for the crash report file when the crash reporter is enabled. Preallocation
+ * is disabled by default, and the report file is created by the crash handler.
+ */
+#define PLCRASH_REPORTER_DEFAULT_REPORT_PREALLOCATION_SIZE 0
+
+/**
+ * @ingroup constants
+ * The default number of crash report slots. A single slot preserves the legacy single pending report behavior.
+ */
+#define PLCRASH_REPORTER_DEFAULT_REPORT_SLOT_COUNT 1
+
+/**
+ * @ingroup constants
+ * The default number of crashed thread frames included in the report fingerprint.
+ */
+#define PLCRASH_REPORTER_DEFAULT_FINGERPRINT_FRAME_COUNT 8
+
 /**
  * @ingroup enums
  * Supported mechanisms for trapping and handling crashes.
@@ -139,7 +158,27 @@ typedef NS_OPTIONS(NSUInteger, PLCrashReporterSymbolicationStrategy) {
     PLCrashReporterSymbolicationStrategyAll = (PLCrashReporterSymbolicationStrategySymbolTable|PLCrashReporterSymbolicationStrategyObjC)
 };
 
-@interface PLCrashReporterConfig : NSObject {
+/**
+ * Supported register encodings.
+ *
+ * @ingroup enums
+ */
+typedef NS_ENUM(NSUInteger, PLCrashReporterRegisterEncoding) {
+    /**
+     * Write each register value along with its name. This encoding is supported by all readers of the
+     * PLCrashReporter report format.
+     */
+    PLCrashReporterRegisterEncodingNamed = 0,
+
+    /**
+     * Write register values as the fixed fields of an architecture-specific register state message. This produces
+     * smaller reports that are faster to write and decode, but registers will not be visible to readers that predate
+     * PLCrashReporter 1.5.
+     */
+    PLCrashReporterRegisterEncodingTyped = 1
+};
+
+@interface PLCrashReporterConfig : NSObject <NSCopying, NSMutableCopying> {
 @private
     /** The configured signal handler type. */
     PLCrashReporterSignalHandlerType _signalHandlerType;
@@ -152,6 +191,21 @@ typedef NS_OPTIONS(NSUInteger, PLCrashReporterSymbolicationStrategy) {
     * Xamarin environment.
     */
   BOOL _shouldRegisterUncaughtExceptionHandler;
+
+    /** The number of bytes to preallocate for the crash report file, or 0 to disable preallocation. */
+    NSUInteger _reportPreallocationSize;
+
+    /** The number of crash report slots. */
+    NSUInteger _reportSlotCount;
+
+    /** The register encoding. */
+    PLCrashReporterRegisterEncoding _registerEncoding;
+
+    /** Flag indicating if symbol and image names should be written to a report string table. */
+    BOOL _shouldUseStringTable;
+
+    /** The number of crashed thread frames included in the report fingerprint. */
+    NSUInteger _fingerprintFrameCount;
 }
 
 + (instancetype) defaultConfiguration;
@@ -164,7 +218,6 @@ typedef NS_OPTIONS(NSUInteger, PLCrashReporterSymbolicationStrategy) {
                      symbolicationStrategy: (PLCrashReporterSymbolicationStrategy) symbolicationStrategy
                shouldRegisterUncaughtExceptionHandler: (BOOL) shouldRegisterUncaughtExceptionHandler;
 
-
 /** The configured signal handler type. */
 @property(nonatomic, readonly) PLCrashReporterSignalHandlerType signalHandlerType;
 
@@ -174,5 +227,59 @@ typedef NS_OPTIONS(NSUInteger, PLCrashReporterSymbolicationStrategy) {
 /** Should PLCrashReporter regiser an uncaught exception handler? This is entended to be used in Xamarin apps */
 @property(nonatomic, readonly) BOOL shouldRegisterUncaughtExceptionHandler;
 
+/**
+ * The number of bytes preallocated for the crash report file when the crash reporter is enabled. If non-zero, the
+ * report file is opened and its storage reserved ahead of time, and the crash handler only writes to the already
+ * open file. If 0, the report file is created by the crash handler. Defaults to 0.
+ */
+@property(nonatomic, readonly) NSUInteger reportPreallocationSize;
+
+/**
+ * The number of crash report slots. If greater than 1, crash reports are written to a ring of report slots, rather
+ * than to the single pending crash report; up to this many reports are retained until purged, with the oldest report
+ * replaced once all slots are in use. Queued reports may be accessed via PLCrashReporter::queuedCrashReportPaths,
+ * or one at a time, oldest first, via PLCrashReporter::hasPendingCrashReport and the pending crash report methods.
+ */
+@property(nonatomic, readonly) NSUInteger reportSlotCount;
+
+/** The encoding used to write the crashed thread's register values. */
+@property(nonatomic, readonly) PLCrashReporterRegisterEncoding registerEncoding;
+
+/**
+ * If YES, symbol and binary image names are written once to a report-level string table, and referenced by index
+ * from each frame and image. This produces smaller reports, but names will not be visible to readers that predate
+ * PLCrashReporter 1.5.
+ */
+@property(nonatomic, readonly) BOOL shouldUseStringTable;
+
+/**
+ * The number of crashed thread frames included in the report fingerprint, or 0 if no fingerprint should be written.
+ * The fingerprint is written at a fixed offset in the report file, and may be used to group duplicate reports
+ * without decoding them; see PLCrashReport::fingerprint.
+ */
+@property(nonatomic, readonly) NSUInteger fingerprintFrameCount;
+
 @end
 
+/**
+ * A mutable crash reporter configuration.
+ *
+ * Settings that are not supported by the PLCrashReporterConfig initializers may be configured by mutating a
+ * PLMutableCrashReporterConfig instance; all settings not explicitly assigned retain their default values. The
+ * configuration is copied by PLCrashReporter, and changes made after the reporter is initialized have no effect.
+ */
+@interface PLMutableCrashReporterConfig : PLCrashReporterConfig
+
+@property(nonatomic, readwrite) PLCrashReporterSignalHandlerType signalHandlerType;
+@property(nonatomic, readwrite) PLCrashReporterSymbolicationStrategy symbolicationStrategy;
+@property(nonatomic, readwrite) BOOL shouldRegisterUncaughtExceptionHandler;
+@property(nonatomic, readwrite) NSUInteger reportPreallocationSize;
+
+/** The number of crash report slots. A value of 0 is treated as 1. */
+@property(nonatomic, readwrite) NSUInteger reportSlotCount;
+
+@property(nonatomic, readwrite) PLCrashReporterRegisterEncoding registerEncoding;
+@property(nonatomic, readwrite) BOOL shouldUseStringTable;
+@property(nonatomic, readwrite) NSUInteger fingerprintFrameCount;
+
+@end
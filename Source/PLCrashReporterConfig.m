@@ -28,6 +28,19 @@
 
 #import "PLCrashReporterConfig.h"
 
+@interface PLCrashReporterConfig ()
+@property(nonatomic, readwrite) PLCrashReporterSignalHandlerType signalHandlerType;
+@property(nonatomic, readwrite) PLCrashReporterSymbolicationStrategy symbolicationStrategy;
+@property(nonatomic, readwrite) BOOL shouldRegisterUncaughtExceptionHandler;
+@property(nonatomic, readwrite) NSUInteger reportPreallocationSize;
+@property(nonatomic, readwrite) NSUInteger reportSlotCount;
+@property(nonatomic, readwrite) PLCrashReporterRegisterEncoding registerEncoding;
+@property(nonatomic, readwrite) BOOL shouldUseStringTable;
+@property(nonatomic, readwrite) NSUInteger fingerprintFrameCount;
+
+- (instancetype) initWithConfiguration: (PLCrashReporterConfig *) config;
+@end
+
 /**
  * Crash Reporter Configuration.
  *
@@ -38,6 +51,11 @@
 @synthesize signalHandlerType = _signalHandlerType;
 @synthesize symbolicationStrategy = _symbolicationStrategy;
 @synthesize shouldRegisterUncaughtExceptionHandler = _shouldRegisterUncaughtExceptionHandler;
+@synthesize reportPreallocationSize = _reportPreallocationSize;
+@synthesize reportSlotCount = _reportSlotCount;
+@synthesize registerEncoding = _registerEncoding;
+@synthesize shouldUseStringTable = _shouldUseStringTable;
+@synthesize fingerprintFrameCount = _fingerprintFrameCount;
 
 /**
  * Return the default local configuration.
@@ -67,7 +85,8 @@
 }
 
 /**
- * Initialize a new PLCrashReporterConfig instance.
+ * Initialize a new PLCrashReporterConfig instance. All other settings are assigned their default values; use
+ * PLMutableCrashReporterConfig to configure them.
  *
  * @param signalHandlerType The requested signal handler type.
  * @param symbolicationStrategy A local symbolication strategy.
@@ -83,8 +102,67 @@
   _signalHandlerType = signalHandlerType;
   _symbolicationStrategy = symbolicationStrategy;
   _shouldRegisterUncaughtExceptionHandler = shouldRegisterUncaughtExceptionHandler;
+  _reportPreallocationSize = PLCRASH_REPORTER_DEFAULT_REPORT_PREALLOCATION_SIZE;
+  _reportSlotCount = PLCRASH_REPORTER_DEFAULT_REPORT_SLOT_COUNT;
+  _registerEncoding = PLCrashReporterRegisterEncodingNamed;
+  _shouldUseStringTable = NO;
+  _fingerprintFrameCount = PLCRASH_REPORTER_DEFAULT_FINGERPRINT_FRAME_COUNT;
   
   return self;
 }
 
+/**
+ * @internal
+ *
+ * Initialize a new instance with all settings copied from @a config.
+ */
+- (instancetype) initWithConfiguration: (PLCrashReporterConfig *) config {
+  if ((self = [super init]) == nil)
+    return nil;
+
+  _signalHandlerType = config->_signalHandlerType;
+  _symbolicationStrategy = config->_symbolicationStrategy;
+  _shouldRegisterUncaughtExceptionHandler = config->_shouldRegisterUncaughtExceptionHandler;
+  _reportPreallocationSize = config->_reportPreallocationSize;
+  _reportSlotCount = config->_reportSlotCount;
+  _registerEncoding = config->_registerEncoding;
+  _shouldUseStringTable = config->_shouldUseStringTable;
+  _fingerprintFrameCount = config->_fingerprintFrameCount;
+
+  return self;
+}
+
+- (void) setReportSlotCount: (NSUInteger) reportSlotCount {
+  _reportSlotCount = MAX(reportSlotCount, (NSUInteger) 1);
+}
+
+- (id) copyWithZone: (NSZone *) zone {
+  /* Immutable; there's no need to copy */
+  return [self retain];
+}
+
+- (id) mutableCopyWithZone: (NSZone *) zone {
+  return [[PLMutableCrashReporterConfig allocWithZone: zone] initWithConfiguration: self];
+}
+
+@end
+
+/**
+ * Mutable Crash Reporter Configuration.
+ */
+@implementation PLMutableCrashReporterConfig
+
+@dynamic signalHandlerType;
+@dynamic symbolicationStrategy;
+@dynamic shouldRegisterUncaughtExceptionHandler;
+@dynamic reportPreallocationSize;
+@dynamic reportSlotCount;
+@dynamic registerEncoding;
+@dynamic shouldUseStringTable;
+@dynamic fingerprintFrameCount;
+
+- (id) copyWithZone: (NSZone *) zone {
+  return [[PLCrashReporterConfig allocWithZone: zone] initWithConfiguration: self];
+}
+
 @end
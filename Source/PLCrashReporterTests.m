@@ -33,6 +33,13 @@
 #import "PLCrashFrameWalker.h"
 #import "PLCrashTestThread.h"
 
+@interface PLCrashReporter (PrivateMethods)
+- (BOOL) populateCrashReportDirectoryAndReturnError: (NSError **) outError;
+- (NSString *) crashReportPath;
+- (NSString *) queuedCrashReportPathForSlot: (NSUInteger) slot;
+- (NSString *) selectQueuedCrashReportSlot;
+@end
+
 @interface PLCrashReporterTests : SenTestCase
 @end
 
@@ -46,6 +53,26 @@
 #pragma clang diagnostic pop
 }
 
+/**
+ * Test that mutable configurations are defaulted, and copied to an immutable configuration.
+ */
+- (void) testMutableConfiguration {
+    PLMutableCrashReporterConfig *config = [[[PLMutableCrashReporterConfig alloc] init] autorelease];
+    STAssertEquals((NSUInteger) PLCRASH_REPORTER_DEFAULT_REPORT_PREALLOCATION_SIZE, config.reportPreallocationSize, @"Incorrect default preallocation size");
+    STAssertEquals((NSUInteger) PLCRASH_REPORTER_DEFAULT_REPORT_SLOT_COUNT, config.reportSlotCount, @"Incorrect default slot count");
+    STAssertEquals((NSUInteger) PLCRASH_REPORTER_DEFAULT_FINGERPRINT_FRAME_COUNT, config.fingerprintFrameCount, @"Incorrect default fingerprint frame count");
+
+    config.reportSlotCount = 0;
+    STAssertEquals((NSUInteger) 1, config.reportSlotCount, @"A slot count of 0 was not treated as 1");
+
+    config.reportPreallocationSize = 4096;
+    PLCrashReporterConfig *copy = [[config copy] autorelease];
+    config.reportPreallocationSize = 0;
+
+    STAssertFalse([copy isKindOfClass: [PLMutableCrashReporterConfig class]], @"Copy is mutable");
+    STAssertEquals((NSUInteger) 4096, copy.reportPreallocationSize, @"Copy was modified by its source");
+}
+
 /**
  * Test generation of a 'live' crash report for a specific thread.
  */
@@ -87,6 +114,141 @@
 
     STAssertEqualStrings([[report signalInfo] name], @"SIGTRAP", @"Incorrect signal name");
     STAssertEqualStrings([[report signalInfo] code], @"TRAP_TRACE", @"Incorrect signal code");
+    STAssertEquals(PLCrashReportTypeLive, report.reportType, @"Report not marked as a live report");
+}
+
+/**
+ * Test generation of a watchdog report for a specific thread.
+ */
+- (void) testGenerateWatchdogReportWithThread {
+    NSError *error;
+    NSData *reportData;
+    plcrash_test_thread_t thr;
+
+    /* Spawn a thread and generate a report for it */
+    plcrash_test_thread_spawn(&thr);
+    PLCrashReporter *reporter = [[[PLCrashReporter alloc] initWithConfiguration: [PLCrashReporterConfig defaultConfiguration]] autorelease];
+    reportData = [reporter generateWatchdogReportWithThread: pthread_mach_thread_np(thr.thread) error: &error];
+    plcrash_test_thread_stop(&thr);
+    STAssertNotNil(reportData, @"Failed to generate watchdog report: %@", error);
+
+    PLCrashReport *report = [[[PLCrashReport alloc] initWithData: reportData error: &error] autorelease];
+    STAssertNotNil(report, @"Could not parse generated watchdog report: %@", error);
+    if (report == nil)
+        return;
+
+    STAssertEquals(PLCrashReportTypeWatchdog, report.reportType, @"Report not marked as a watchdog report");
+
+    /* The watchdog thread must be marked as crashed */
+    BOOL foundCrashed = NO;
+    for (PLCrashReportThreadInfo *thread in report.threads) {
+        if (thread.crashed)
+            foundCrashed = YES;
+    }
+    STAssertTrue(foundCrashed, @"No thread was marked as the responsible thread");
+}
+
+/**
+ * Verify that an empty (preallocated, but never written) report file is not treated as a pending report.
+ */
+- (void) testEmptyReportFileIsNotPending {
+    NSError *error;
+    PLCrashReporter *reporter = [[[PLCrashReporter alloc] initWithConfiguration: [PLCrashReporterConfig defaultConfiguration]] autorelease];
+    NSString *path = [reporter crashReportPath];
+
+    STAssertTrue([[NSFileManager defaultManager] createDirectoryAtPath: [path stringByDeletingLastPathComponent] withIntermediateDirectories: YES attributes: nil error: &error], @"Failed to create report directory: %@", error);
+    STAssertTrue([[NSData data] writeToFile: path atomically: NO], @"Failed to write empty report file");
+
+    STAssertFalse([reporter hasPendingCrashReport], @"Empty report file treated as a pending report");
+    STAssertNil([reporter loadPendingCrashReportDataAndReturnError: NULL], @"Loaded an empty report file");
+    STAssertTrue([reporter purgePendingCrashReportAndReturnError: &error], @"Failed to purge empty report file: %@", error);
+}
+
+/**
+ * Test that the pending report API drains queued reports, oldest first, when two crashes have been recorded.
+ */
+- (void) testPendingQueuedReports {
+    NSError *error;
+    PLMutableCrashReporterConfig *config = [[[PLMutableCrashReporterConfig alloc] init] autorelease];
+    config.reportPreallocationSize = 0;
+    config.reportSlotCount = 3;
+    PLCrashReporter *reporter = [[[PLCrashReporter alloc] initWithConfiguration: config] autorelease];
+    STAssertTrue([reporter populateCrashReportDirectoryAndReturnError: &error], @"Failed to create report directory: %@", error);
+    STAssertTrue([reporter purgeQueuedCrashReportsAndReturnError: &error], @"Failed to purge queued reports: %@", error);
+    [[NSFileManager defaultManager] removeItemAtPath: [reporter crashReportPath] error: NULL];
+    STAssertFalse([reporter hasPendingCrashReport], @"Pending report reported with no queued reports");
+
+    /* Record two crashes, in slots selected as at enable time */
+    NSData *first = [@"first crash" dataUsingEncoding: NSUTF8StringEncoding];
+    NSData *second = [@"second crash" dataUsingEncoding: NSUTF8StringEncoding];
+    NSString *firstPath = [reporter selectQueuedCrashReportSlot];
+    STAssertTrue([first writeToFile: firstPath atomically: NO], @"Failed to write report");
+    [[NSFileManager defaultManager] setAttributes: [NSDictionary dictionaryWithObject: [NSDate dateWithTimeIntervalSinceNow: -60] forKey: NSFileModificationDate] ofItemAtPath: firstPath error: NULL];
+    STAssertTrue([second writeToFile: [reporter selectQueuedCrashReportSlot] atomically: NO], @"Failed to write report");
+
+    /* Both reports are delivered via the pending report API, oldest first */
+    STAssertTrue([reporter hasPendingCrashReport], @"Queued report not reported as pending");
+    STAssertTrue([first isEqualToData: [reporter loadPendingCrashReportDataAndReturnError: &error]], @"Incorrect first pending report: %@", error);
+    STAssertTrue([reporter purgePendingCrashReportAndReturnError: &error], @"Failed to purge report: %@", error);
+
+    STAssertTrue([reporter hasPendingCrashReport], @"Second queued report not reported as pending");
+    STAssertTrue([second isEqualToData: [reporter loadPendingCrashReportDataAndReturnError: &error]], @"Incorrect second pending report: %@", error);
+    STAssertTrue([reporter purgePendingCrashReportAndReturnError: &error], @"Failed to purge report: %@", error);
+
+    STAssertFalse([reporter hasPendingCrashReport], @"Pending report remained after all reports were purged");
+    STAssertNil([reporter loadPendingCrashReportDataAndReturnError: NULL], @"Loaded a pending report after all reports were purged");
+}
+
+/**
+ * Test enumeration, loading, slot selection, and purging of queued crash reports.
+ */
+- (void) testQueuedReports {
+    NSError *error;
+    PLMutableCrashReporterConfig *config = [[[PLMutableCrashReporterConfig alloc] init] autorelease];
+    config.reportPreallocationSize = 0;
+    config.reportSlotCount = 3;
+    PLCrashReporter *reporter = [[[PLCrashReporter alloc] initWithConfiguration: config] autorelease];
+    STAssertTrue([reporter populateCrashReportDirectoryAndReturnError: &error], @"Failed to create report directory: %@", error);
+    STAssertTrue([reporter purgeQueuedCrashReportsAndReturnError: &error], @"Failed to purge queued reports: %@", error);
+    STAssertEquals((NSUInteger) 0, [[reporter queuedCrashReportPaths] count], @"Queued reports not purged");
+
+    /* Populate slots 1 and 0, with slot 1 holding the older report */
+    NSString *slot0 = [reporter queuedCrashReportPathForSlot: 0];
+    NSString *slot1 = [reporter queuedCrashReportPathForSlot: 1];
+    NSString *slot2 = [reporter queuedCrashReportPathForSlot: 2];
+    NSData *data0 = [@"report 0" dataUsingEncoding: NSUTF8StringEncoding];
+    NSData *data1 = [@"report 1" dataUsingEncoding: NSUTF8StringEncoding];
+
+    STAssertTrue([data1 writeToFile: slot1 atomically: NO], @"Failed to write report");
+    STAssertTrue([data0 writeToFile: slot0 atomically: NO], @"Failed to write report");
+    [[NSFileManager defaultManager] setAttributes: [NSDictionary dictionaryWithObject: [NSDate dateWithTimeIntervalSinceNow: -60] forKey: NSFileModificationDate] ofItemAtPath: slot1 error: NULL];
+
+    /* Queued reports are ordered oldest first */
+    NSArray *paths = [reporter queuedCrashReportPaths];
+    STAssertEquals((NSUInteger) 2, [paths count], @"Incorrect queued report count");
+    if ([paths count] == 2) {
+        STAssertEqualStrings(slot1, [paths objectAtIndex: 0], @"Incorrect report order");
+        STAssertEqualStrings(slot0, [paths objectAtIndex: 1], @"Incorrect report order");
+    }
+
+    NSArray *reports = [reporter loadQueuedCrashReportDataAndReturnError: &error];
+    STAssertNotNil(reports, @"Failed to load queued reports: %@", error);
+    STAssertEquals((NSUInteger) 2, [reports count], @"Incorrect loaded report count");
+    if ([reports count] == 2) {
+        STAssertTrue([data1 isEqualToData: [reports objectAtIndex: 0]], @"Incorrect report data");
+        STAssertTrue([data0 isEqualToData: [reports objectAtIndex: 1]], @"Incorrect report data");
+    }
+
+    /* The free slot is selected first; once all slots are full, the oldest is reused */
+    STAssertEqualStrings(slot2, [reporter selectQueuedCrashReportSlot], @"Free slot not selected");
+    STAssertTrue([data0 writeToFile: slot2 atomically: NO], @"Failed to write report");
+    STAssertEqualStrings(slot1, [reporter selectQueuedCrashReportSlot], @"Oldest slot not selected");
+
+    /* Purge */
+    STAssertTrue([reporter purgeQueuedCrashReportAtPath: slot1 error: &error], @"Failed to purge report: %@", error);
+    STAssertEquals((NSUInteger) 2, [[reporter queuedCrashReportPaths] count], @"Report not purged");
+    STAssertTrue([reporter purgeQueuedCrashReportsAndReturnError: &error], @"Failed to purge queued reports: %@", error);
+    STAssertEquals((NSUInteger) 0, [[reporter queuedCrashReportPaths] count], @"Queued reports not purged");
 }
 
 @end
@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "SenTestCompat.h"
+
+#import "PLCrashReporter.h"
+#import "PLCrashReport.h"
+
+#import "plcrashutil/PLCrashSymbolicator.hpp"
+
+#import <inttypes.h>
+
+using namespace plcrash::symbolication;
+
+@interface PLCrashSymbolicatorTests : SenTestCase @end
+
+/**
+ * Tests for the offline symbolicator's report decoding.
+ */
+@implementation PLCrashSymbolicatorTests
+
+/**
+ * Generate a live report for the current thread, with symbol and image names written to the string table.
+ */
+- (NSData *) stringTableReport {
+    PLMutableCrashReporterConfig *config = [[[PLMutableCrashReporterConfig alloc] initWithSignalHandlerType: PLCrashReporterSignalHandlerTypeBSD
+                                                                                     symbolicationStrategy: PLCrashReporterSymbolicationStrategyAll] autorelease];
+    config.shouldUseStringTable = YES;
+    PLCrashReporter *reporter = [[[PLCrashReporter alloc] initWithConfiguration: config] autorelease];
+
+    NSError *error;
+    NSData *data = [reporter generateLiveReportAndReturnError: &error];
+    STAssertNotNil(data, @"Failed to generate live report: %@", error);
+    return data;
+}
+
+/**
+ * Verify that symbol and image names referenced via the string table are resolved, and match those decoded by
+ * PLCrashReport.
+ */
+- (void) testDecodeStringTableReport {
+    NSData *data = [self stringTableReport];
+    NSError *error;
+
+    PLCrashReport *crashReport = [[[PLCrashReport alloc] initWithData: data error: &error] autorelease];
+    STAssertNotNil(crashReport, @"Failed to decode report: %@", error);
+
+    report decoded;
+    STAssertEquals(PLCRASH_ESUCCESS, decode_report((const uint8_t *) [data bytes], [data length], &decoded), @"Failed to decode report");
+
+    STAssertEquals([crashReport.images count], (NSUInteger) decoded.images.size(), @"Incorrect image count");
+    for (PLCrashReportBinaryImageInfo *imageInfo in crashReport.images) {
+        const report_image *image = decoded.image_for_address(imageInfo.imageBaseAddress);
+        STAssertNotNULL(image, @"Missing image %@", imageInfo.imageName);
+        if (image == NULL)
+            continue;
+
+        STAssertTrue(image->name.size() > 0, @"Image name was not resolved");
+        STAssertEqualStrings([NSString stringWithUTF8String: image->name.c_str()], imageInfo.imageName, @"Incorrect image name");
+    }
+
+    /* The live report's crashed thread is the current thread, and must carry resolved symbol names */
+    PLCrashReportThreadInfo *crashedThread = nil;
+    for (PLCrashReportThreadInfo *thread in crashReport.threads) {
+        if (thread.crashed)
+            crashedThread = thread;
+    }
+    STAssertNotNil(crashedThread, @"No crashed thread");
+
+    const report_backtrace *backtrace = NULL;
+    for (const report_backtrace &bt : decoded.backtraces) {
+        if (bt.crashed && !bt.exception)
+            backtrace = &bt;
+    }
+    STAssertNotNULL(backtrace, @"No crashed thread decoded");
+    if (crashedThread == nil || backtrace == NULL)
+        return;
+
+    STAssertEquals([crashedThread.stackFrames count], (NSUInteger) backtrace->frames.size(), @"Incorrect frame count");
+
+    size_t symbols = 0;
+    for (size_t i = 0; i < backtrace->frames.size() && i < [crashedThread.stackFrames count]; i++) {
+        PLCrashReportStackFrameInfo *frameInfo = [crashedThread.stackFrames objectAtIndex: i];
+        const report_frame &frame = backtrace->frames[i];
+
+        STAssertEquals(frameInfo.instructionPointer, frame.pc, @"Incorrect PC");
+        STAssertEquals(frameInfo.symbolInfo != nil, frame.has_symbol, @"Incorrect symbol presence");
+        if (frameInfo.symbolInfo == nil)
+            continue;
+
+        STAssertTrue(frame.symbol.size() > 0, @"Symbol name was not resolved");
+        STAssertEqualStrings([NSString stringWithUTF8String: frame.symbol.c_str()], frameInfo.symbolInfo.symbolName, @"Incorrect symbol name");
+        STAssertEquals(frameInfo.symbolInfo.startAddress, frame.symbol_start, @"Incorrect symbol start");
+        symbols++;
+    }
+    STAssertTrue(symbols > 0, @"No frames were symbolicated in the live report");
+
+    /* Symbolication must emit the resolved names of frames that already carry symbol information */
+    SymbolStore store;
+    ImageCache cache(store);
+    symbolicate_stats stats = { 0, 0, 0 };
+    std::string output;
+    symbolicate_report(decoded, cache, "live", &output, &stats);
+
+    NSString *text = [NSString stringWithUTF8String: output.c_str()];
+    for (PLCrashReportStackFrameInfo *frameInfo in crashedThread.stackFrames) {
+        if (frameInfo.symbolInfo == nil)
+            continue;
+
+        NSString *expected = [NSString stringWithFormat: @"\t%@ + %" PRIu64 "\n", frameInfo.symbolInfo.symbolName,
+                              frameInfo.instructionPointer - frameInfo.symbolInfo.startAddress];
+        STAssertTrue([text rangeOfString: expected].location != NSNotFound, @"Missing symbolicated frame %@", expected);
+    }
+}
+
+/**
+ * Verify that a report referencing a string table entry that does not exist is rejected.
+ */
+- (void) testDecodeInvalidStringTableIndex {
+    /* CrashReport { binary_images { base_address: 4096 size: 4096 name_index: 1 } string_table { entries: "/a" } } */
+    static const uint8_t data[] = {
+        'p', 'l', 'c', 'r', 'a', 's', 'h', 1,
+        0x22, 0x08, 0x08, 0x80, 0x20, 0x10, 0x80, 0x20, 0x30, 0x01,
+        0x52, 0x04, 0x0a, 0x02, '/', 'a'
+    };
+
+    report decoded;
+    STAssertEquals(PLCRASH_EINVALID_DATA, decode_report(data, sizeof(data), &decoded), @"Out-of-range index accepted");
+
+    /* The same report, referencing the valid entry */
+    uint8_t valid[sizeof(data)];
+    memcpy(valid, data, sizeof(data));
+    valid[17] = 0x00;
+    STAssertEquals(PLCRASH_ESUCCESS, decode_report(valid, sizeof(valid), &decoded), @"Failed to decode report");
+    STAssertEquals((size_t) 1, decoded.images.size(), @"Incorrect image count");
+    if (decoded.images.size() == 1)
+        STAssertTrue(decoded.images[0].name == "/a", @"Incorrect image name");
+}
+
+@end
@@ -0,0 +1,350 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PLCrashTextBuffer.h"
+
+#include <string.h>
+
+/**
+ * @internal
+ * @defgroup plcrash_text_buffer Text Buffer
+ * @ingroup plcrash_internal
+ *
+ * Implements a growable byte buffer, with fixed-width integer and string formatting, for use by the text
+ * report formatters. Formatting is performed directly into the buffer, without the use of printf-style
+ * format strings; hexadecimal output is generated from a precomputed table of byte values.
+ *
+ * @warning This API is not async-safe.
+ *
+ * @{
+ */
+
+/** Lowercase hexadecimal representations of all byte values, two characters per value. */
+static const char plcrash_text_buffer_hex_pairs[] =
+    "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f"
+    "202122232425262728292a2b2c2d2e2f303132333435363738393a3b3c3d3e3f"
+    "404142434445464748494a4b4c4d4e4f505152535455565758595a5b5c5d5e5f"
+    "606162636465666768696a6b6c6d6e6f707172737475767778797a7b7c7d7e7f"
+    "808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f"
+    "a0a1a2a3a4a5a6a7a8a9aaabacadaeafb0b1b2b3b4b5b6b7b8b9babbbcbdbebf"
+    "c0c1c2c3c4c5c6c7c8c9cacbcccdcecfd0d1d2d3d4d5d6d7d8d9dadbdcdddedf"
+    "e0e1e2e3e4e5e6e7e8e9eaebecedeeeff0f1f2f3f4f5f6f7f8f9fafbfcfdfeff";
+
+/** The default initial buffer capacity. */
+#define DEFAULT_CAPACITY 4096
+
+/**
+ * Initialize a new text buffer.
+ *
+ * @param buffer The buffer to initialize.
+ * @param initial_capacity The number of bytes to allocate initially. If 0, a default capacity will be used.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, or PLCRASH_ENOMEM if the initial allocation fails.
+ */
+plcrash_error_t plcrash_text_buffer_init (plcrash_text_buffer_t *buffer, size_t initial_capacity) {
+    if (initial_capacity == 0)
+        initial_capacity = DEFAULT_CAPACITY;
+
+    buffer->length = 0;
+    buffer->failed = false;
+    buffer->capacity = initial_capacity;
+    buffer->data = malloc(initial_capacity);
+    if (buffer->data == NULL) {
+        buffer->capacity = 0;
+        buffer->failed = true;
+        return PLCRASH_ENOMEM;
+    }
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Free all resources associated with @a buffer.
+ */
+void plcrash_text_buffer_free (plcrash_text_buffer_t *buffer) {
+    if (buffer->data != NULL)
+        free(buffer->data);
+
+    buffer->data = NULL;
+    buffer->length = 0;
+    buffer->capacity = 0;
+}
+
+/**
+ * Transfer ownership of the buffer's contents to the caller. The buffer is left empty, and must still be freed
+ * via plcrash_text_buffer_free().
+ *
+ * @param buffer The buffer to detach.
+ * @param length On return, the number of valid bytes in the returned allocation.
+ *
+ * @return Returns the malloc-allocated contents of the buffer, which the caller is responsible for free()'ing,
+ * or NULL if an allocation failure occured while the buffer was written.
+ */
+void *plcrash_text_buffer_detach (plcrash_text_buffer_t *buffer, size_t *length) {
+    void *data = buffer->data;
+
+    *length = buffer->length;
+    if (buffer->failed) {
+        free(data);
+        data = NULL;
+        *length = 0;
+    }
+
+    buffer->data = NULL;
+    buffer->length = 0;
+    buffer->capacity = 0;
+
+    return data;
+}
+
+/**
+ * Return true if an allocation failure has occured, in which case the buffer's contents are incomplete.
+ */
+bool plcrash_text_buffer_failed (plcrash_text_buffer_t *buffer) {
+    return buffer->failed;
+}
+
+/**
+ * Return the number of bytes written to @a buffer.
+ */
+size_t plcrash_text_buffer_length (plcrash_text_buffer_t *buffer) {
+    return buffer->length;
+}
+
+/**
+ * Return a borrowed reference to the bytes written to @a buffer. The returned pointer is invalidated by any
+ * subsequent append. The contents are not NUL terminated.
+ */
+const char *plcrash_text_buffer_bytes (plcrash_text_buffer_t *buffer) {
+    return buffer->data;
+}
+
+/**
+ * @internal
+ *
+ * Ensure that @a buffer has space for an additional @a length bytes, growing the allocation if required.
+ *
+ * @return Returns true on success, or false if the buffer could not be grown.
+ */
+static bool plcrash_text_buffer_reserve (plcrash_text_buffer_t *buffer, size_t length) {
+    if (buffer->failed)
+        return false;
+
+    if (buffer->capacity - buffer->length >= length)
+        return true;
+
+    /* Check for overflow */
+    if (SIZE_MAX - buffer->length < length) {
+        buffer->failed = true;
+        return false;
+    }
+
+    size_t required = buffer->length + length;
+    size_t capacity = buffer->capacity > 0 ? buffer->capacity : DEFAULT_CAPACITY;
+    while (capacity < required) {
+        if (capacity > SIZE_MAX / 2) {
+            capacity = required;
+            break;
+        }
+        capacity *= 2;
+    }
+
+    char *data = realloc(buffer->data, capacity);
+    if (data == NULL) {
+        buffer->failed = true;
+        return false;
+    }
+
+    buffer->data = data;
+    buffer->capacity = capacity;
+    return true;
+}
+
+/**
+ * Append @a length bytes of @a data to @a buffer.
+ */
+void plcrash_text_buffer_append (plcrash_text_buffer_t *buffer, const void *data, size_t length) {
+    if (!plcrash_text_buffer_reserve(buffer, length))
+        return;
+
+    memcpy(buffer->data + buffer->length, data, length);
+    buffer->length += length;
+}
+
+/**
+ * Append the NUL-terminated @a string to @a buffer. If @a string is NULL, the string "(null)" is appended, matching the
+ * output of the Foundation string formatting functions.
+ */
+void plcrash_text_buffer_append_string (plcrash_text_buffer_t *buffer, const char *string) {
+    if (string == NULL)
+        string = "(null)";
+
+    plcrash_text_buffer_append(buffer, string, strlen(string));
+}
+
+/**
+ * Append @a count copies of the character @a c to @a buffer.
+ */
+void plcrash_text_buffer_append_padding (plcrash_text_buffer_t *buffer, char c, size_t count) {
+    if (!plcrash_text_buffer_reserve(buffer, count))
+        return;
+
+    memset(buffer->data + buffer->length, c, count);
+    buffer->length += count;
+}
+
+/**
+ * Return the number of UTF-16 code units required to represent the first @a length bytes of the UTF-8 encoded
+ * @a string. This matches the width calculation applied by the Foundation string formatting functions.
+ */
+size_t plcrash_text_buffer_utf16_length (const char *string, size_t length) {
+    const uint8_t *bytes = (const uint8_t *) string;
+    size_t units = 0;
+
+    for (size_t i = 0; i < length; i++) {
+        /* Skip continuation bytes */
+        if ((bytes[i] & 0xC0) == 0x80)
+            continue;
+
+        /* Characters outside of the BMP are represented as a surrogate pair */
+        if (bytes[i] >= 0xF0) {
+            units += 2;
+        } else {
+            units++;
+        }
+    }
+
+    return units;
+}
+
+/**
+ * Append @a length bytes of the UTF-8 encoded @a string to @a buffer, space-padded to a minimum of @a width
+ * characters.
+ *
+ * @param buffer The target buffer.
+ * @param string The UTF-8 string to append.
+ * @param length The length of @a string, in bytes.
+ * @param width The minimum field width, in UTF-16 code units.
+ * @param left_align If true, the padding is appended after @a string; otherwise, it is inserted before.
+ */
+void plcrash_text_buffer_append_padded (plcrash_text_buffer_t *buffer, const char *string, size_t length, size_t width, bool left_align) {
+    size_t units = plcrash_text_buffer_utf16_length(string, length);
+    size_t padding = units < width ? width - units : 0;
+
+    if (!left_align)
+        plcrash_text_buffer_append_padding(buffer, ' ', padding);
+
+    plcrash_text_buffer_append(buffer, string, length);
+
+    if (left_align)
+        plcrash_text_buffer_append_padding(buffer, ' ', padding);
+}
+
+/**
+ * Append the decimal representation of @a value to @a buffer, space-padded to a minimum of @a width characters.
+ *
+ * @param buffer The target buffer.
+ * @param value The value to append.
+ * @param width The minimum field width.
+ * @param left_align If true, the padding is appended after the value; otherwise, it is inserted before.
+ */
+void plcrash_text_buffer_append_int64 (plcrash_text_buffer_t *buffer, int64_t value, size_t width, bool left_align) {
+    char digits[21];
+    char *p = digits + sizeof(digits);
+
+    /* Negate via the unsigned type, which is well defined for INT64_MIN */
+    uint64_t magnitude = value < 0 ? (uint64_t) 0 - (uint64_t) value : (uint64_t) value;
+    do {
+        *--p = (char) ('0' + (magnitude % 10));
+        magnitude /= 10;
+    } while (magnitude != 0);
+
+    if (value < 0)
+        *--p = '-';
+
+    plcrash_text_buffer_append_padded(buffer, p, (size_t) (digits + sizeof(digits) - p), width, left_align);
+}
+
+/**
+ * @internal
+ *
+ * Write the minimal lowercase hexadecimal representation of @a value to the end of @a end, returning a pointer to
+ * the first written character.
+ */
+static char *plcrash_text_buffer_format_hex (uint64_t value, char *end) {
+    char *p = end;
+
+    do {
+        const char *pair = &plcrash_text_buffer_hex_pairs[(value & 0xFF) * 2];
+        *--p = pair[1];
+        *--p = pair[0];
+        value >>= 8;
+    } while (value != 0);
+
+    /* Drop a leading zero nibble */
+    if (*p == '0' && p < end - 1)
+        p++;
+
+    return p;
+}
+
+/**
+ * Append the lowercase hexadecimal representation of @a value to @a buffer, zero-padded to a minimum of
+ * @a digits characters. This matches the output of the "%0*llx" printf conversion.
+ */
+void plcrash_text_buffer_append_hex (plcrash_text_buffer_t *buffer, uint64_t value, size_t digits) {
+    char hex[16];
+    char *end = hex + sizeof(hex);
+    char *p = plcrash_text_buffer_format_hex(value, end);
+    size_t length = (size_t) (end - p);
+
+    if (length < digits)
+        plcrash_text_buffer_append_padding(buffer, '0', digits - length);
+
+    plcrash_text_buffer_append(buffer, p, length);
+}
+
+/**
+ * Append the lowercase hexadecimal representation of @a value to @a buffer in the printf alternate form, prefixed
+ * with "0x" and right-aligned within a minimum of @a width characters. As with the "%#*llx" printf conversion,
+ * no prefix is written for a value of zero.
+ */
+void plcrash_text_buffer_append_hex_alternate (plcrash_text_buffer_t *buffer, uint64_t value, size_t width) {
+    char hex[18];
+    char *end = hex + sizeof(hex);
+    char *p = plcrash_text_buffer_format_hex(value, end);
+
+    if (value != 0) {
+        *--p = 'x';
+        *--p = '0';
+    }
+
+    plcrash_text_buffer_append_padded(buffer, p, (size_t) (end - p), width, false);
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PLCRASH_TEXT_BUFFER_H
+#define PLCRASH_TEXT_BUFFER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "PLCrashAsyncError.h"
+
+/**
+ * @internal
+ * @ingroup plcrash_text_buffer
+ * @{
+ */
+
+/**
+ * @internal
+ *
+ * A growable byte buffer used to format text output.
+ *
+ * Allocation failures are sticky: once an append fails to grow the buffer, all subsequent appends are
+ * ignored, and plcrash_text_buffer_failed() will return true. This allows a formatter to append its
+ * complete output, checking for failure only once.
+ */
+typedef struct plcrash_text_buffer {
+    /** The buffer's malloc-allocated contents, or NULL if no storage has been allocated. */
+    char *data;
+
+    /** The number of bytes written to @a data. */
+    size_t length;
+
+    /** The allocated size of @a data, in bytes. */
+    size_t capacity;
+
+    /** If true, an allocation failure has occured, and the buffer's contents are incomplete. */
+    bool failed;
+} plcrash_text_buffer_t;
+
+plcrash_error_t plcrash_text_buffer_init (plcrash_text_buffer_t *buffer, size_t initial_capacity);
+void plcrash_text_buffer_free (plcrash_text_buffer_t *buffer);
+void *plcrash_text_buffer_detach (plcrash_text_buffer_t *buffer, size_t *length);
+
+bool plcrash_text_buffer_failed (plcrash_text_buffer_t *buffer);
+size_t plcrash_text_buffer_length (plcrash_text_buffer_t *buffer);
+const char *plcrash_text_buffer_bytes (plcrash_text_buffer_t *buffer);
+
+void plcrash_text_buffer_append (plcrash_text_buffer_t *buffer, const void *data, size_t length);
+void plcrash_text_buffer_append_string (plcrash_text_buffer_t *buffer, const char *string);
+void plcrash_text_buffer_append_padding (plcrash_text_buffer_t *buffer, char c, size_t count);
+void plcrash_text_buffer_append_padded (plcrash_text_buffer_t *buffer, const char *string, size_t length, size_t width, bool left_align);
+
+void plcrash_text_buffer_append_int64 (plcrash_text_buffer_t *buffer, int64_t value, size_t width, bool left_align);
+void plcrash_text_buffer_append_hex (plcrash_text_buffer_t *buffer, uint64_t value, size_t digits);
+void plcrash_text_buffer_append_hex_alternate (plcrash_text_buffer_t *buffer, uint64_t value, size_t width);
+
+size_t plcrash_text_buffer_utf16_length (const char *string, size_t length);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLCRASH_TEXT_BUFFER_H */
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "SenTestCompat.h"
+
+#import "PLCrashTextBuffer.h"
+
+#import <inttypes.h>
+
+@interface PLCrashTextBufferTests : SenTestCase {
+@private
+    /** The buffer under test. */
+    plcrash_text_buffer_t _buffer;
+}
+@end
+
+@implementation PLCrashTextBufferTests
+
+- (void) setUp {
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_text_buffer_init(&_buffer, 16), @"Failed to initialize buffer");
+}
+
+- (void) tearDown {
+    plcrash_text_buffer_free(&_buffer);
+}
+
+/**
+ * Return true if the buffer's contents exactly match @a expected, resetting the buffer for the next comparison.
+ */
+- (BOOL) consumeBufferMatching: (const char *) expected {
+    BOOL matches = plcrash_text_buffer_length(&_buffer) == strlen(expected) &&
+        memcmp(plcrash_text_buffer_bytes(&_buffer), expected, strlen(expected)) == 0;
+    _buffer.length = 0;
+    return matches;
+}
+
+/**
+ * Verify that appends grow the buffer, and that the contents may be detached.
+ */
+- (void) testAppend {
+    plcrash_text_buffer_append_string(&_buffer, "Binary Images:\n");
+    for (int i = 0; i < 1000; i++)
+        plcrash_text_buffer_append(&_buffer, "0123456789", 10);
+    plcrash_text_buffer_append_string(&_buffer, NULL);
+
+    STAssertFalse(plcrash_text_buffer_failed(&_buffer), @"Append failed");
+    STAssertEquals((size_t) (15 + 10000 + 6), plcrash_text_buffer_length(&_buffer), @"Incorrect length");
+    STAssertTrue(memcmp(plcrash_text_buffer_bytes(&_buffer), "Binary Images:\n0123", 19) == 0, @"Incorrect contents");
+
+    size_t length;
+    char *data = plcrash_text_buffer_detach(&_buffer, &length);
+    STAssertNotNULL(data, @"Failed to detach buffer");
+    STAssertEquals((size_t) (15 + 10000 + 6), length, @"Incorrect detached length");
+    STAssertTrue(memcmp(data + length - 6, "(null)", 6) == 0, @"NULL string not formatted as (null)");
+    free(data);
+
+    STAssertEquals((size_t) 0, plcrash_text_buffer_length(&_buffer), @"Buffer not emptied by detach");
+}
+
+/**
+ * Verify that integer formatting matches the equivalent printf conversions.
+ */
+- (void) testIntegerFormatting {
+    const int64_t values[] = { 0, 1, 9, 10, 12345, -1, -42, INT64_MAX, INT64_MIN };
+    const uint64_t hexValues[] = { 0, 1, 0xf, 0x10, 0xabc, 0x1000, 0x7fff5fbff000ULL, 0xffffffffULL, UINT64_MAX };
+    char expected[64];
+
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        snprintf(expected, sizeof(expected), "%-4" PRId64, values[i]);
+        plcrash_text_buffer_append_int64(&_buffer, values[i], 4, true);
+        STAssertTrue([self consumeBufferMatching: expected], @"Incorrect formatting of %" PRId64, values[i]);
+
+        snprintf(expected, sizeof(expected), "%" PRId64, values[i]);
+        plcrash_text_buffer_append_int64(&_buffer, values[i], 0, false);
+        STAssertTrue([self consumeBufferMatching: expected], @"Incorrect formatting of %" PRId64, values[i]);
+    }
+
+    for (size_t i = 0; i < sizeof(hexValues) / sizeof(hexValues[0]); i++) {
+        snprintf(expected, sizeof(expected), "%016" PRIx64, hexValues[i]);
+        plcrash_text_buffer_append_hex(&_buffer, hexValues[i], 16);
+        STAssertTrue([self consumeBufferMatching: expected], @"Incorrect formatting of 0x%" PRIx64, hexValues[i]);
+
+        snprintf(expected, sizeof(expected), "%08" PRIx64, hexValues[i]);
+        plcrash_text_buffer_append_hex(&_buffer, hexValues[i], 8);
+        STAssertTrue([self consumeBufferMatching: expected], @"Incorrect formatting of 0x%" PRIx64, hexValues[i]);
+
+        snprintf(expected, sizeof(expected), "%" PRIx64, hexValues[i]);
+        plcrash_text_buffer_append_hex(&_buffer, hexValues[i], 0);
+        STAssertTrue([self consumeBufferMatching: expected], @"Incorrect formatting of 0x%" PRIx64, hexValues[i]);
+
+        snprintf(expected, sizeof(expected), "%#18" PRIx64, hexValues[i]);
+        plcrash_text_buffer_append_hex_alternate(&_buffer, hexValues[i], 18);
+        STAssertTrue([self consumeBufferMatching: expected], @"Incorrect formatting of 0x%" PRIx64, hexValues[i]);
+
+        snprintf(expected, sizeof(expected), "%#10" PRIx64, hexValues[i]);
+        plcrash_text_buffer_append_hex_alternate(&_buffer, hexValues[i], 10);
+        STAssertTrue([self consumeBufferMatching: expected], @"Incorrect formatting of 0x%" PRIx64, hexValues[i]);
+    }
+}
+
+/**
+ * Verify that string padding is applied in UTF-16 code units, rather than bytes.
+ */
+- (void) testPadding {
+    plcrash_text_buffer_append_padded(&_buffer, "r12", 3, 6, false);
+    STAssertTrue([self consumeBufferMatching: "   r12"], @"Incorrect right alignment");
+
+    plcrash_text_buffer_append_padded(&_buffer, "libobjc.A.dylib", 15, 20, true);
+    STAssertTrue([self consumeBufferMatching: "libobjc.A.dylib     "], @"Incorrect left alignment");
+
+    plcrash_text_buffer_append_padded(&_buffer, "CoreFoundation", 14, 4, true);
+    STAssertTrue([self consumeBufferMatching: "CoreFoundation"], @"Strings wider than the field must not be truncated");
+
+    /* U+00E9 is two UTF-8 bytes and one UTF-16 unit; U+1F600 is four UTF-8 bytes and two UTF-16 units */
+    const char *name = "caf\xC3\xA9\xF0\x9F\x98\x80";
+    STAssertEquals((size_t) 6, plcrash_text_buffer_utf16_length(name, strlen(name)), @"Incorrect UTF-16 length");
+
+    plcrash_text_buffer_append_padded(&_buffer, name, strlen(name), 8, true);
+    STAssertTrue([self consumeBufferMatching: "caf\xC3\xA9\xF0\x9F\x98\x80  "], @"Incorrect padding of non-ASCII string");
+}
+
+@end
@@ -167,19 +167,21 @@ inline bool dwarf_opstream::read_uintmax64 (uint8_t data_size, uint64_t *result)
  */
 inline bool dwarf_opstream::read_uleb128 (uint64_t *result) {
     plcrash_error_t err;
-    pl_vm_off_t offset = ((uint8_t *)_p - (uint8_t *)_instr);
-    pl_vm_size_t lebsize;
+    size_t lebsize;
 
-    if ((err = plcrash_async_dwarf_read_uleb128(_mobj, _start, offset, result, &lebsize)) != PLCRASH_ESUCCESS) {
-        PLCF_DEBUG("Read of ULEB128 value failed with %u", err);
+    if (_p < _instr || _p >= _instr_max) {
+        PLCF_DEBUG("ULEB128 value extends past end of opstream");
         return false;
     }
 
-    /* Advance the position */
-    if (!skip(lebsize)) {
-        PLCF_DEBUG("ULEB128 value extends past end of opstream");
+    /* Decode directly from the local mapping; the opstream bounds are checked once for the entire value */
+    if ((err = plcrash_async_dwarf_decode_uleb128((const uint8_t *) _p, (uint8_t *)_instr_max - (uint8_t *)_p, result, &lebsize)) != PLCRASH_ESUCCESS) {
+        PLCF_DEBUG("Read of ULEB128 value failed with %u", err);
         return false;
     }
+
+    /* Advance the position */
+    _p = ((uint8_t *)_p) + lebsize;
     return true;
 }
 
@@ -193,19 +195,21 @@ inline bool dwarf_opstream::read_uleb128 (uint64_t *result) {
  */
 inline bool dwarf_opstream::read_sleb128 (int64_t *result) {
     plcrash_error_t err;
-    pl_vm_off_t offset = ((uint8_t *)_p - (uint8_t *)_instr);
-    pl_vm_size_t lebsize;
-    
-    if ((err = plcrash_async_dwarf_read_sleb128(_mobj, _start, offset, result, &lebsize)) != PLCRASH_ESUCCESS) {
-        PLCF_DEBUG("Read of ULEB128 value failed with %u", err);
+    size_t lebsize;
+
+    if (_p < _instr || _p >= _instr_max) {
+        PLCF_DEBUG("SLEB128 value extends past end of opstream");
         return false;
     }
-    
-    /* Advance the position */
-    if (!skip(lebsize)) {
-        PLCF_DEBUG("SLEB128 value extends past end of opstream");
+
+    /* Decode directly from the local mapping; the opstream bounds are checked once for the entire value */
+    if ((err = plcrash_async_dwarf_decode_sleb128((const uint8_t *) _p, (uint8_t *)_instr_max - (uint8_t *)_p, result, &lebsize)) != PLCRASH_ESUCCESS) {
+        PLCF_DEBUG("Read of SLEB128 value failed with %u", err);
         return false;
     }
+
+    /* Advance the position */
+    _p = ((uint8_t *)_p) + lebsize;
     return true;
 }
 
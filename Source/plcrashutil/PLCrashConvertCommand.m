@@ -0,0 +1,446 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+#import <CrashReporter/CrashReporter.h>
+
+#import <stdlib.h>
+#import <stdio.h>
+#import <errno.h>
+#import <getopt.h>
+#import <pthread.h>
+
+#import <stdatomic.h>
+
+/*
+ * Print command line usage.
+ */
+static void print_convert_usage () {
+    fprintf(stderr, "Usage: plcrashutil convert [--format=<format>] <file>\n"
+                    "       plcrashutil convert [--format=<format>] [--jobs=<count>] [--manifest=<file>] --output-dir=<dir> <file or directory> ...\n"
+                    "Options:\n"
+                    "  -f, --format=<format>  Output format; one of 'ios', or its synonym 'iphone' (default: iphone).\n"
+                    "  -j, --jobs=<count>     Number of worker threads (default: number of processors).\n"
+                    "  -o, --output-dir=<dir> Write a .crash file for each report to the given directory.\n"
+                    "  -m, --manifest=<file>  Read input paths from the given file, one per line; '-' reads from stdin.\n");
+}
+
+/*
+ * Batch conversion state, shared by all worker threads.
+ */
+struct convert_batch {
+    /** Input report paths. */
+    NSArray *inputs;
+
+    /** Output paths, indexed as per inputs. */
+    NSArray *outputs;
+
+    /** The output format. */
+    PLCrashReportTextFormat textFormat;
+
+    /** The next input index to be claimed by a worker. */
+    _Atomic int32_t next;
+
+    /** Number of reports successfully converted. */
+    _Atomic int32_t converted;
+
+    /** Number of inputs that could not be read. */
+    _Atomic int32_t read_failures;
+
+    /** Number of inputs that could not be decoded or formatted. */
+    _Atomic int32_t decode_failures;
+
+    /** Number of outputs that could not be written. */
+    _Atomic int32_t write_failures;
+
+    /** Total bytes read. */
+    _Atomic int64_t bytes_in;
+
+    /** Total bytes written. */
+    _Atomic int64_t bytes_out;
+};
+
+/*
+ * Return the first output path derived from @a path that has not already been claimed in @a claimed.
+ */
+static NSString *claim_output_path (NSMutableSet *claimed, NSString *path) {
+    NSString *base = [path stringByDeletingPathExtension];
+    NSString *candidate = [base stringByAppendingPathExtension: @"crash"];
+
+    for (NSUInteger i = 2; [claimed containsObject: candidate]; i++)
+        candidate = [[base stringByAppendingFormat: @"-%lu", (unsigned long) i] stringByAppendingPathExtension: @"crash"];
+
+    [claimed addObject: candidate];
+    return candidate;
+}
+
+/*
+ * Append the input report(s) at @a path to @a inputs, and their output paths within @a outputDir to @a outputs.
+ * Directories are searched recursively; hidden files are skipped.
+ *
+ * @return Returns NO if @a path does not exist.
+ */
+static BOOL add_convert_input (NSString *path, NSString *outputDir, NSMutableSet *claimed, NSMutableArray *inputs, NSMutableArray *outputs) {
+    NSFileManager *fm = [NSFileManager defaultManager];
+    BOOL isDirectory;
+
+    if (![fm fileExistsAtPath: path isDirectory: &isDirectory])
+        return NO;
+
+    if (!isDirectory) {
+        [inputs addObject: path];
+        [outputs addObject: claim_output_path(claimed, [outputDir stringByAppendingPathComponent: [path lastPathComponent]])];
+        return YES;
+    }
+
+    /* Walk in a stable order, so that output names do not depend on the directory enumeration order */
+    NSMutableArray *children = [NSMutableArray array];
+    NSDirectoryEnumerator *enumerator = [fm enumeratorAtPath: path];
+    for (NSString *child in enumerator) {
+        if ([[child lastPathComponent] hasPrefix: @"."]) {
+            if ([[[enumerator fileAttributes] fileType] isEqualToString: NSFileTypeDirectory])
+                [enumerator skipDescendants];
+            continue;
+        }
+
+        if ([[[enumerator fileAttributes] fileType] isEqualToString: NSFileTypeRegular])
+            [children addObject: child];
+    }
+    [children sortUsingSelector: @selector(compare:)];
+
+    for (NSString *child in children) {
+        [inputs addObject: [path stringByAppendingPathComponent: child]];
+        [outputs addObject: claim_output_path(claimed, [outputDir stringByAppendingPathComponent: child])];
+    }
+
+    return YES;
+}
+
+/*
+ * Read the newline-delimited input paths from the manifest at @a manifestPath ('-' for stdin). Blank lines and
+ * lines starting with '#' are ignored.
+ */
+static NSArray *read_convert_manifest (const char *manifestPath) {
+    FILE *manifest = stdin;
+    if (strcmp(manifestPath, "-") != 0 && (manifest = fopen(manifestPath, "r")) == NULL) {
+        fprintf(stderr, "Could not open manifest %s\n", manifestPath);
+        return nil;
+    }
+
+    NSMutableArray *paths = [NSMutableArray array];
+    char *line = NULL;
+    size_t capacity = 0;
+    ssize_t length;
+    while ((length = getline(&line, &capacity, manifest)) != -1) {
+        while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r'))
+            line[--length] = '\0';
+
+        if (length == 0 || line[0] == '#')
+            continue;
+
+        NSString *path = [NSString stringWithUTF8String: line];
+        if (path != nil)
+            [paths addObject: path];
+    }
+
+    free(line);
+    if (manifest != stdin)
+        fclose(manifest);
+
+    return paths;
+}
+
+/*
+ * Batch conversion worker thread. Claims and converts inputs until none remain.
+ */
+static void *convert_worker (void *ctx) {
+    struct convert_batch *batch = ctx;
+    NSAutoreleasePool *threadPool = [[NSAutoreleasePool alloc] init];
+    PLCrashReportTextFormatter *formatter = [[PLCrashReportTextFormatter alloc] initWithTextFormat: batch->textFormat stringEncoding: NSUTF8StringEncoding];
+    int32_t count = (int32_t) [batch->inputs count];
+    int32_t item;
+
+    while ((item = atomic_fetch_add(&batch->next, 1)) < count) {
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+        NSString *input = [batch->inputs objectAtIndex: item];
+        NSString *output = [batch->outputs objectAtIndex: item];
+        NSError *error;
+
+        /* Map the input; the report is decoded directly from the mapped pages. */
+        NSData *data = [NSData dataWithContentsOfFile: input options: NSDataReadingMappedAlways error: &error];
+        if (data == nil) {
+            fprintf(stderr, "Could not read %s: %s\n", [input UTF8String], [[error localizedDescription] UTF8String]);
+            atomic_fetch_add(&batch->read_failures, 1);
+            [pool release];
+            continue;
+        }
+        atomic_fetch_add(&batch->bytes_in, (int64_t) [data length]);
+
+        PLCrashReport *report = [[[PLCrashReport alloc] initWithData: data error: &error] autorelease];
+        NSData *text = nil;
+        if (report != nil)
+            text = [formatter formatReport: report error: &error];
+
+        if (text == nil) {
+            fprintf(stderr, "Could not decode %s: %s\n", [input UTF8String], [[error localizedDescription] UTF8String]);
+            atomic_fetch_add(&batch->decode_failures, 1);
+            [pool release];
+            continue;
+        }
+
+        if (![text writeToFile: output options: NSDataWritingAtomic error: &error]) {
+            fprintf(stderr, "Could not write %s: %s\n", [output UTF8String], [[error localizedDescription] UTF8String]);
+            atomic_fetch_add(&batch->write_failures, 1);
+            [pool release];
+            continue;
+        }
+
+        atomic_fetch_add(&batch->bytes_out, (int64_t) [text length]);
+        atomic_fetch_add(&batch->converted, 1);
+        [pool release];
+    }
+
+    [formatter release];
+    [threadPool release];
+    return NULL;
+}
+
+/*
+ * Run a batch conversion of the reports at @a paths to @a outputDir on @a jobs worker threads, reporting throughput and error
+ * statistics to stderr.
+ */
+static int convert_batch_command (NSArray *paths, NSString *outputDir, unsigned jobs, PLCrashReportTextFormat textFormat) {
+    NSMutableArray *inputs = [NSMutableArray array];
+    NSMutableArray *outputs = [NSMutableArray array];
+    NSMutableSet *claimed = [NSMutableSet set];
+    unsigned missing = 0;
+    NSError *error;
+
+    /* Gather the input reports */
+    for (NSString *path in paths) {
+        if (!add_convert_input(path, outputDir, claimed, inputs, outputs)) {
+            fprintf(stderr, "Could not find input %s\n", [path UTF8String]);
+            missing++;
+        }
+    }
+
+    if ([inputs count] == 0) {
+        fprintf(stderr, "No input reports supplied\n");
+        return 1;
+    }
+
+    if ([inputs count] > INT32_MAX) {
+        fprintf(stderr, "Too many input reports supplied\n");
+        return 1;
+    }
+
+    /* Create the output directory tree up front, rather than concurrently from the workers */
+    NSMutableSet *directories = [NSMutableSet setWithObject: outputDir];
+    for (NSString *output in outputs)
+        [directories addObject: [output stringByDeletingLastPathComponent]];
+
+    for (NSString *directory in directories) {
+        if (![[NSFileManager defaultManager] createDirectoryAtPath: directory withIntermediateDirectories: YES attributes: nil error: &error]) {
+            fprintf(stderr, "Could not create output directory %s: %s\n", [directory UTF8String], [[error localizedDescription] UTF8String]);
+            return 1;
+        }
+    }
+
+    if (jobs == 0)
+        jobs = (unsigned) MAX((NSUInteger) 1, [[NSProcessInfo processInfo] activeProcessorCount]);
+    jobs = (unsigned) MIN((NSUInteger) jobs, [inputs count]);
+
+    struct convert_batch batch = {
+        .inputs = inputs,
+        .outputs = outputs,
+        .textFormat = textFormat,
+        .next = 0,
+        .converted = 0,
+        .read_failures = 0,
+        .decode_failures = 0,
+        .write_failures = 0,
+        .bytes_in = 0,
+        .bytes_out = 0
+    };
+
+    /* Ensure that Foundation is in multithreaded mode before spawning our own threads */
+    if (![NSThread isMultiThreaded])
+        [NSThread detachNewThreadSelector: @selector(class) toTarget: [NSObject class] withObject: nil];
+
+    NSDate *started = [NSDate date];
+
+    pthread_t *threads = calloc(jobs, sizeof(pthread_t));
+    unsigned started_jobs = 0;
+    for (unsigned i = 0; threads != NULL && i < jobs; i++) {
+        if (pthread_create(&threads[i], NULL, convert_worker, &batch) != 0) {
+            fprintf(stderr, "Could not start worker thread: %s\n", strerror(errno));
+            break;
+        }
+        started_jobs++;
+    }
+
+    for (unsigned i = 0; i < started_jobs; i++)
+        pthread_join(threads[i], NULL);
+    free(threads);
+
+    /* If no worker could be started, fall back on converting from this thread */
+    if (started_jobs == 0) {
+        convert_worker(&batch);
+        started_jobs = 1;
+    }
+
+    NSTimeInterval elapsed = -[started timeIntervalSinceNow];
+
+    /* All workers have been joined; the totals are final */
+    int32_t converted = atomic_load(&batch.converted);
+    int32_t read_failures = atomic_load(&batch.read_failures);
+    int32_t decode_failures = atomic_load(&batch.decode_failures);
+    int32_t write_failures = atomic_load(&batch.write_failures);
+    int64_t bytes_in = atomic_load(&batch.bytes_in);
+    int64_t bytes_out = atomic_load(&batch.bytes_out);
+    unsigned failures = (unsigned) (read_failures + decode_failures + write_failures) + missing;
+
+    fprintf(stderr, "%d of %lu reports converted in %.3f s (%.1f reports/sec, %.1f MB/sec read) on %u workers\n",
+            converted, (unsigned long) [inputs count], elapsed,
+            elapsed > 0 ? converted / elapsed : 0.0,
+            elapsed > 0 ? (bytes_in / (1024.0 * 1024.0)) / elapsed : 0.0,
+            started_jobs);
+    fprintf(stderr, "%lld bytes read, %lld bytes written\n", bytes_in, bytes_out);
+    fprintf(stderr, "%u errors: %u missing, %d unreadable, %d undecodable, %d unwritable\n",
+            failures, missing, read_failures, decode_failures, write_failures);
+
+    return failures == 0 ? 0 : 1;
+}
+
+/**
+ * Run the convert command. @a argv[0] is the command name.
+ */
+int plcrash_convert_command (int argc, char *argv[]) {
+    const char *format = "iphone";
+    const char *input_file;
+    const char *output_dir = NULL;
+    const char *manifest = NULL;
+    unsigned jobs = 0;
+    FILE *output = stdout;
+
+    /* options descriptor */
+    static struct option longopts[] = {
+        { "format",     required_argument,      NULL,          'f' },
+        { "jobs",       required_argument,      NULL,          'j' },
+        { "output-dir", required_argument,      NULL,          'o' },
+        { "manifest",   required_argument,      NULL,          'm' },
+        { NULL,         0,                      NULL,           0 }
+    };    
+
+    /* Read the options, resetting any getopt state left by a previous run */
+    optreset = 1;
+    optind = 1;
+
+    int ch;
+    while ((ch = getopt_long(argc, argv, "f:j:o:m:", longopts, NULL)) != -1) {
+        switch (ch) {
+            case 'f':
+                format = optarg;
+                break;
+            case 'j':
+                jobs = (unsigned) strtoul(optarg, NULL, 10);
+                break;
+            case 'o':
+                output_dir = optarg;
+                break;
+            case 'm':
+                manifest = optarg;
+                break;
+            default:
+                print_convert_usage();
+                return 1;
+        }
+    }
+    argc -= optind;
+    argv += optind;
+
+    /* Ensure there's an input file specified */
+    if (argc < 1 && manifest == NULL) {
+        fprintf(stderr, "No input file supplied\n");
+        print_convert_usage();
+        return 1;
+    } else {
+        input_file = argv[0];
+    }
+    
+    /* Verify that the format is supported. Only one is actually supported currently */
+    PLCrashReportTextFormat textFormat;
+    if (strcasecmp(format, "iphone") == 0 || strcasecmp(format, "ios") == 0) {
+        textFormat = PLCrashReportTextFormatiOS;
+    } else {
+        fprintf(stderr, "Unsupported format requested\n");
+        print_convert_usage();
+        return 1;
+    }
+
+    /* Batch conversion */
+    if (output_dir != NULL || manifest != NULL || argc > 1) {
+        if (output_dir == NULL) {
+            fprintf(stderr, "An output directory is required when converting multiple reports\n");
+            print_convert_usage();
+            return 1;
+        }
+
+        NSMutableArray *paths = [NSMutableArray array];
+        if (manifest != NULL) {
+            NSArray *manifestPaths = read_convert_manifest(manifest);
+            if (manifestPaths == nil)
+                return 1;
+            [paths addObjectsFromArray: manifestPaths];
+        }
+
+        for (int i = 0; i < argc; i++)
+            [paths addObject: [NSString stringWithUTF8String: argv[i]]];
+
+        return convert_batch_command(paths, [NSString stringWithUTF8String: output_dir], jobs, textFormat);
+    }
+
+    /* Try reading the file in */
+    NSError *error;
+    NSData *data = [NSData dataWithContentsOfFile: [NSString stringWithUTF8String: input_file] 
+                                          options: NSMappedRead error: &error];
+    if (data == nil) {
+        fprintf(stderr, "Could not read input file: %s\n", [[error localizedDescription] UTF8String]);
+        return 1;
+    }
+    
+    /* Decode it */
+    PLCrashReport *crashLog = [[PLCrashReport alloc] initWithData: data error: &error];
+    if (crashLog == nil) {
+        fprintf(stderr, "Could not decode crash log: %s\n", [[error localizedDescription] UTF8String]);
+        return 1;
+    }
+
+    /* Format the report */
+    NSString* report = [PLCrashReportTextFormatter stringValueForCrashReport: crashLog withTextFormat: textFormat];
+    fprintf(output, "%s", [report UTF8String]);     
+    return 0;
+}
@@ -0,0 +1,872 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PLCrashSymbolicator.hpp"
+
+#include "PLCrashAsyncMachOImage.h"
+#include "PLCrashAsyncMemorySource.h"
+#include "PLCrashReportReader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <thread>
+
+#include <dirent.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <mach-o/fat.h>
+#include <mach-o/loader.h>
+#include <mach-o/nlist.h>
+
+#include <libkern/OSByteOrder.h>
+
+using namespace plcrash::symbolication;
+
+/** Supported crash log file format version. */
+#define REPORT_FILE_VERSION 1
+
+/**
+ * @internal
+ * @ingroup plcrash_symbolication
+ * @{
+ */
+
+/*
+ * Paths
+ */
+
+/**
+ * Invoke @a fn for every regular file at or below @a path. Symbolic links to directories are not followed.
+ */
+static void walk_path (const std::string &path, const std::function<void(const std::string &)> &fn) {
+    struct stat sb;
+    if (lstat(path.c_str(), &sb) != 0)
+        return;
+
+    /* Resolve links to files (but not directories) */
+    if (S_ISLNK(sb.st_mode)) {
+        if (stat(path.c_str(), &sb) != 0 || !S_ISREG(sb.st_mode))
+            return;
+    }
+
+    if (S_ISREG(sb.st_mode)) {
+        fn(path);
+        return;
+    }
+
+    if (!S_ISDIR(sb.st_mode))
+        return;
+
+    DIR *dir = opendir(path.c_str());
+    if (dir == NULL)
+        return;
+
+    std::vector<std::string> children;
+    struct dirent *ent;
+    while ((ent = readdir(dir)) != NULL) {
+        if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0)
+            continue;
+        children.push_back(path + "/" + ent->d_name);
+    }
+    closedir(dir);
+
+    /* Walk in a stable order, so that the first image found for a UUID does not depend on the directory layout */
+    std::sort(children.begin(), children.end());
+    for (const std::string &child : children)
+        walk_path(child, fn);
+}
+
+/*
+ * Symbol store
+ */
+
+/**
+ * Parse a single (thin) Mach-O image of @a length bytes at @a data, returning its UUID, __TEXT address and file type.
+ *
+ * @return Returns true if the image is a valid Mach-O image with both a UUID and a __TEXT segment.
+ */
+static bool scan_macho (const uint8_t *data, uint64_t length, image_uuid *uuid, uint64_t *text_vmaddr, bool *dsym) {
+    struct mach_header header;
+    size_t header_size;
+    bool swap;
+    bool m64;
+
+    if (length < sizeof(header))
+        return false;
+    memcpy(&header, data, sizeof(header));
+
+    switch (header.magic) {
+        case MH_MAGIC:      swap = false; m64 = false; break;
+        case MH_CIGAM:      swap = true;  m64 = false; break;
+        case MH_MAGIC_64:   swap = false; m64 = true;  break;
+        case MH_CIGAM_64:   swap = true;  m64 = true;  break;
+        default:
+            return false;
+    }
+    header_size = m64 ? sizeof(struct mach_header_64) : sizeof(struct mach_header);
+
+    auto swap32 = [swap](uint32_t v) { return swap ? OSSwapInt32(v) : v; };
+    auto swap64 = [swap](uint64_t v) { return swap ? OSSwapInt64(v) : v; };
+
+    uint64_t cmds_size = swap32(header.sizeofcmds);
+    uint32_t ncmds = swap32(header.ncmds);
+    if (length < header_size || length - header_size < cmds_size)
+        return false;
+
+    bool have_uuid = false;
+    bool have_text = false;
+    const uint8_t *cmds = data + header_size;
+    uint64_t offset = 0;
+    for (uint32_t i = 0; i < ncmds; i++) {
+        struct load_command cmd;
+        if (cmds_size - offset < sizeof(cmd))
+            return false;
+        memcpy(&cmd, cmds + offset, sizeof(cmd));
+
+        uint32_t cmdsize = swap32(cmd.cmdsize);
+        if (cmdsize < sizeof(cmd) || cmds_size - offset < cmdsize)
+            return false;
+
+        const uint8_t *cmd_data = cmds + offset;
+        offset += cmdsize;
+
+        switch (swap32(cmd.cmd)) {
+            case LC_UUID: {
+                struct uuid_command uc;
+                if (cmdsize < sizeof(uc))
+                    return false;
+                memcpy(&uc, cmd_data, sizeof(uc));
+                memcpy(uuid->data(), uc.uuid, uuid->size());
+                have_uuid = true;
+                break;
+            }
+
+            case LC_SEGMENT: {
+                struct segment_command seg;
+                if (m64 || cmdsize < sizeof(seg))
+                    break;
+                memcpy(&seg, cmd_data, sizeof(seg));
+                if (strncmp(seg.segname, SEG_TEXT, sizeof(seg.segname)) == 0) {
+                    *text_vmaddr = swap32(seg.vmaddr);
+                    have_text = true;
+                }
+                break;
+            }
+
+            case LC_SEGMENT_64: {
+                struct segment_command_64 seg;
+                if (!m64 || cmdsize < sizeof(seg))
+                    break;
+                memcpy(&seg, cmd_data, sizeof(seg));
+                if (strncmp(seg.segname, SEG_TEXT, sizeof(seg.segname)) == 0) {
+                    *text_vmaddr = swap64(seg.vmaddr);
+                    have_text = true;
+                }
+                break;
+            }
+
+            default:
+                break;
+        }
+    }
+
+    *dsym = (swap32(header.filetype) == MH_DSYM);
+    return have_uuid && have_text;
+}
+
+/**
+ * Index all Mach-O images found at or below @a path. Universal binaries are indexed per-slice. If both a binary and
+ * its dSYM are found, the dSYM is preferred.
+ *
+ * @param path A file or directory path.
+ *
+ * @return Returns the number of images added.
+ */
+size_t SymbolStore::add_path (const std::string &path) {
+    size_t added = 0;
+    walk_path(path, [this, &added](const std::string &file) {
+        added += add_file(file);
+    });
+    return added;
+}
+
+/**
+ * Index the Mach-O image(s) contained in the file at @a path.
+ *
+ * @return Returns the number of images added.
+ */
+size_t SymbolStore::add_file (const std::string &path) {
+    plcrash_async_memory_file_t file;
+    if (plcrash_nasync_memory_file_open(&file, path.c_str()) != PLCRASH_ESUCCESS)
+        return 0;
+
+    /* Determine the slices to be scanned */
+    std::vector<std::pair<uint64_t, uint64_t>> slices;
+    uint32_t magic = 0;
+    if (file.length >= sizeof(magic))
+        memcpy(&magic, file.data, sizeof(magic));
+
+    if (OSSwapBigToHostInt32(magic) == FAT_MAGIC && file.length >= sizeof(struct fat_header)) {
+        struct fat_header fh;
+        memcpy(&fh, file.data, sizeof(fh));
+
+        uint32_t nfat_arch = OSSwapBigToHostInt32(fh.nfat_arch);
+        if ((file.length - sizeof(fh)) / sizeof(struct fat_arch) >= nfat_arch) {
+            for (uint32_t i = 0; i < nfat_arch; i++) {
+                struct fat_arch fa;
+                memcpy(&fa, file.data + sizeof(fh) + i * sizeof(fa), sizeof(fa));
+
+                uint64_t offset = OSSwapBigToHostInt32(fa.offset);
+                uint64_t size = OSSwapBigToHostInt32(fa.size);
+                if (offset <= file.length && file.length - offset >= size)
+                    slices.push_back(std::make_pair(offset, size));
+            }
+        }
+    } else {
+        slices.push_back(std::make_pair(0, (uint64_t) file.length));
+    }
+
+    size_t added = 0;
+    for (const auto &slice : slices) {
+        image_uuid uuid;
+        image_location location = { path, slice.first, slice.second, 0, false };
+        if (!scan_macho(file.data + slice.first, slice.second, &uuid, &location.text_vmaddr, &location.dsym))
+            continue;
+
+        auto existing = _images.find(uuid);
+        if (existing != _images.end()) {
+            if (existing->second.dsym || !location.dsym)
+                continue;
+            existing->second = location;
+        } else {
+            _images.insert(std::make_pair(uuid, location));
+        }
+
+        added++;
+    }
+
+    plcrash_nasync_memory_file_close(&file);
+    return added;
+}
+
+/**
+ * Look up the on-disk image with @a uuid.
+ *
+ * @param uuid The image UUID.
+ * @param[out] location On success, the image's location.
+ *
+ * @return Returns true if the image was found.
+ */
+bool SymbolStore::find (const image_uuid &uuid, image_location *location) const {
+    auto it = _images.find(uuid);
+    if (it == _images.end())
+        return false;
+
+    *location = it->second;
+    return true;
+}
+
+/*
+ * Image index
+ */
+
+/** Lock guarding source_slots. */
+static std::mutex source_slots_lock;
+
+/** Signaled when a memory source slot is released. */
+static std::condition_variable source_slots_cv;
+
+/** Number of memory source slots in use by image loaders. The registry holds at most PLCRASH_ASYNC_MEMORY_SOURCE_MAX sources. */
+static size_t source_slots = 0;
+
+/**
+ * Load the symbol table of the image at @a location.
+ *
+ * The image's file-backed segments are served through a registered memory source for the duration of the load, and
+ * are read via the plcrash_async_macho_* symbol table readers; the resulting index retains no reference to the file.
+ *
+ * @param location The image to load.
+ * @param[out] index On success, the loaded index.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, or an error if the image could not be read.
+ */
+plcrash_error_t ImageIndex::load (const image_location &location, std::shared_ptr<const ImageIndex> *index) {
+    plcrash_async_memory_file_t file;
+    plcrash_error_t err;
+
+    if ((err = plcrash_nasync_memory_file_open(&file, location.path.c_str())) != PLCRASH_ESUCCESS)
+        return err;
+
+    if (location.offset > file.length || file.length - location.offset < location.length) {
+        plcrash_nasync_memory_file_close(&file);
+        return PLCRASH_EINVALID_DATA;
+    }
+
+    /* Map the image's segments at their unslid addresses */
+    plcrash_async_memory_file_t slice = { file.data + location.offset, (pl_vm_size_t) location.length };
+    std::vector<plcrash_async_memory_region_t> regions(16);
+    size_t count;
+    while ((err = plcrash_nasync_memory_file_macho_regions(&slice, 0, regions.data(), regions.size(), &count)) == PLCRASH_ENOMEM)
+        regions.resize(regions.size() * 2);
+
+    plcrash_async_memory_source_t source;
+    if (err == PLCRASH_ESUCCESS)
+        err = plcrash_async_memory_source_regions_init(&source, regions.data(), count);
+
+    if (err != PLCRASH_ESUCCESS) {
+        plcrash_nasync_memory_file_close(&file);
+        return err;
+    }
+
+    /* Wait for a free registry slot */
+    {
+        std::unique_lock<std::mutex> guard(source_slots_lock);
+        source_slots_cv.wait(guard, [] { return source_slots < PLCRASH_ASYNC_MEMORY_SOURCE_MAX; });
+        source_slots++;
+    }
+
+    if ((err = plcrash_async_memory_source_register(&source)) == PLCRASH_ESUCCESS) {
+        plcrash_async_macho_t macho;
+        if ((err = plcrash_nasync_macho_init(&macho, plcrash_async_memory_source_task(&source), location.path.c_str(), location.text_vmaddr)) == PLCRASH_ESUCCESS) {
+            plcrash_async_macho_symtab_reader_t reader;
+            if ((err = plcrash_async_macho_symtab_reader_init(&reader, &macho)) == PLCRASH_ESUCCESS) {
+                std::shared_ptr<ImageIndex> result(new ImageIndex(location.text_vmaddr));
+
+                for (uint32_t i = 0; i < reader.nsyms; i++) {
+                    plcrash_async_macho_symtab_entry_t entry = plcrash_async_macho_symtab_reader_read(&reader, reader.symtab, i);
+
+                    /* Symbol must be within a section, and must not be a debugging entry. */
+                    if ((entry.n_type & N_TYPE) != N_SECT || (entry.n_type & N_STAB) != 0)
+                        continue;
+
+                    const char *name = plcrash_async_macho_symtab_reader_symbol_name(&reader, entry.n_strx);
+                    if (name == NULL)
+                        continue;
+
+                    result->_symbols.push_back({ entry.n_value, entry.normalized_value, result->_names.size() });
+                    result->_names.append(name);
+                    result->_names.push_back('\0');
+                }
+
+                std::stable_sort(result->_symbols.begin(), result->_symbols.end(), [](const symbol &a, const symbol &b) {
+                    return a.address < b.address;
+                });
+
+                *index = result;
+                plcrash_async_macho_symtab_reader_free(&reader);
+            }
+            plcrash_nasync_macho_free(&macho);
+        }
+        plcrash_async_memory_source_unregister(&source);
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(source_slots_lock);
+        source_slots--;
+    }
+    source_slots_cv.notify_one();
+
+    plcrash_nasync_memory_file_close(&file);
+    return err;
+}
+
+/**
+ * Find the closest symbol at or below the unslid address @a pc.
+ *
+ * @param pc The unslid address to look up.
+ * @param[out] name On success, the symbol name. The string is owned by the index.
+ * @param[out] start On success, the unslid symbol start address.
+ *
+ * @return Returns true if a symbol was found.
+ */
+bool ImageIndex::lookup (uint64_t pc, const char **name, uint64_t *start) const {
+    auto it = std::upper_bound(_symbols.begin(), _symbols.end(), pc, [](uint64_t value, const symbol &sym) {
+        return value < sym.address;
+    });
+
+    if (it == _symbols.begin())
+        return false;
+    --it;
+
+    *name = _names.c_str() + it->name;
+    *start = it->start;
+    return true;
+}
+
+/*
+ * Image cache
+ */
+
+/**
+ * Return the index for the image with @a uuid, loading it if necessary.
+ *
+ * @return Returns the image index, or NULL if the image is not available.
+ */
+std::shared_ptr<const ImageIndex> ImageCache::get (const image_uuid &uuid) {
+    std::promise<std::shared_ptr<const ImageIndex>> promise;
+    std::unique_lock<std::mutex> guard(_lock);
+
+    auto it = _images.find(uuid);
+    if (it != _images.end()) {
+        _hits++;
+        std::shared_future<std::shared_ptr<const ImageIndex>> future = it->second;
+        guard.unlock();
+        return future.get();
+    }
+
+    _images.insert(std::make_pair(uuid, promise.get_future().share()));
+    guard.unlock();
+
+    /* Load the image outside of the lock; concurrent requests wait on the shared future */
+    std::shared_ptr<const ImageIndex> index;
+    image_location location;
+    if (_store.find(uuid, &location)) {
+        plcrash_error_t err = ImageIndex::load(location, &index);
+        if (err != PLCRASH_ESUCCESS)
+            fprintf(stderr, "Could not load %s: %s\n", location.path.c_str(), plcrash_async_strerror(err));
+    }
+
+    if (index != NULL) {
+        guard.lock();
+        _loads++;
+        guard.unlock();
+    }
+
+    promise.set_value(index);
+    return index;
+}
+
+/*
+ * Work-stealing pool
+ */
+
+WorkStealingPool::WorkStealingPool (unsigned workers) : _steals(0) {
+    if (workers == 0)
+        workers = std::max(1U, std::thread::hardware_concurrency());
+
+    for (unsigned i = 0; i < workers; i++)
+        _queues.emplace_back(new queue());
+}
+
+/**
+ * Fetch the next work item for @a worker, stealing from a peer if the worker's own queue is empty.
+ *
+ * @return Returns false if no work remains.
+ */
+bool WorkStealingPool::next (size_t worker, size_t *item) {
+    {
+        queue &own = *_queues[worker];
+        std::lock_guard<std::mutex> guard(own.lock);
+        if (!own.items.empty()) {
+            *item = own.items.front();
+            own.items.pop_front();
+            return true;
+        }
+    }
+
+    for (size_t i = 1; i < _queues.size(); i++) {
+        queue &victim = *_queues[(worker + i) % _queues.size()];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.items.empty()) {
+            *item = victim.items.back();
+            victim.items.pop_back();
+            _steals++;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Execute @a fn for every index in [0, @a count), returning once all work items have completed. Each worker is
+ * initially assigned a contiguous block of items.
+ *
+ * @param count The number of work items.
+ * @param fn The function to execute for each work item. It will be called concurrently from all worker threads.
+ */
+void WorkStealingPool::run (size_t count, const std::function<void(size_t)> &fn) {
+    size_t workers = _queues.size();
+    for (size_t w = 0; w < workers; w++) {
+        for (size_t i = count * w / workers; i < count * (w + 1) / workers; i++)
+            _queues[w]->items.push_back(i);
+    }
+
+    std::vector<std::thread> threads;
+    for (size_t w = 0; w < workers; w++) {
+        threads.emplace_back([this, w, &fn] {
+            size_t item;
+            while (next(w, &item))
+                fn(item);
+        });
+    }
+
+    for (std::thread &thread : threads)
+        thread.join();
+}
+
+/*
+ * Report decoding
+ */
+
+namespace {
+
+/** Return @a string as a std::string; unavailable strings are returned as the empty string. */
+std::string reader_string (plcrash_report_string_t string) {
+    if (string.data == NULL)
+        return std::string();
+
+    return std::string(string.data, string.length);
+}
+
+/** Append all frames returned by @a iter to @a frames. */
+void decode_frames (plcrash_report_frame_iter_t *iter, std::vector<report_frame> *frames) {
+    plcrash_report_frame_t frame;
+
+    while (plcrash_report_frame_iter_next(iter, &frame))
+        frames->push_back({ frame.pc, frame.has_symbol, reader_string(frame.symbol_name), frame.symbol_start });
+}
+
+} /* anonymous namespace */
+
+/**
+ * Decode the symbolication-relevant subset of a crash report. Symbol and image names written to the report's string
+ * table are resolved.
+ *
+ * @param data The report file contents, including the file header.
+ * @param length The length of @a data.
+ * @param[out] result On success, the decoded report.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, PLCRASH_ENOTSUP if the file version is unsupported, or
+ * PLCRASH_EINVALID_DATA if the report could not be decoded.
+ */
+plcrash_error_t plcrash::symbolication::decode_report (const uint8_t *data, size_t length, report *result) {
+    plcrash_report_reader_t reader;
+
+    result->backtraces.clear();
+    result->images.clear();
+
+    if (!plcrash_report_reader_open(&reader, data, length)) {
+        /* The version is only set once the file magic has been validated */
+        if (reader.version != 0 && reader.version != REPORT_FILE_VERSION)
+            return PLCRASH_ENOTSUP;
+        return PLCRASH_EINVALID_DATA;
+    }
+
+    /* Index the string table, so that each name is resolved in constant time */
+    std::vector<plcrash_report_string_t> strings(plcrash_report_reader_string_count(&reader));
+    if (!strings.empty() && !plcrash_report_reader_index_strings(&reader, strings.data(), strings.size()))
+        return PLCRASH_EINVALID_DATA;
+
+    plcrash_report_thread_iter_t threads;
+    plcrash_report_thread_t thread;
+    plcrash_report_reader_threads(&reader, &threads);
+    while (plcrash_report_thread_iter_next(&threads, &thread)) {
+        plcrash_report_frame_iter_t frames;
+        report_backtrace backtrace = { thread.number, thread.crashed, false, {} };
+
+        plcrash_report_reader_thread_frames(&reader, &thread, &frames);
+        decode_frames(&frames, &backtrace.frames);
+        result->backtraces.push_back(std::move(backtrace));
+    }
+
+    plcrash_report_exception_t exception;
+    if (plcrash_report_reader_exception(&reader, &exception)) {
+        plcrash_report_frame_iter_t frames;
+        report_backtrace backtrace = { 0, false, true, {} };
+
+        plcrash_report_reader_exception_frames(&reader, &exception, &frames);
+        decode_frames(&frames, &backtrace.frames);
+        result->backtraces.push_back(std::move(backtrace));
+    }
+
+    plcrash_report_image_iter_t images;
+    plcrash_report_image_t image;
+    plcrash_report_reader_images(&reader, &images);
+    while (plcrash_report_image_iter_next(&images, &image)) {
+        report_image entry = { image.base_address, image.size, reader_string(image.name), false, {} };
+        if (image.uuid.data != NULL && image.uuid.length == entry.uuid.size()) {
+            memcpy(entry.uuid.data(), image.uuid.data, entry.uuid.size());
+            entry.has_uuid = true;
+        }
+        result->images.push_back(std::move(entry));
+    }
+
+    if (plcrash_report_reader_failed(&reader))
+        return PLCRASH_EINVALID_DATA;
+
+    std::sort(result->images.begin(), result->images.end(), [](const report_image &a, const report_image &b) {
+        return a.base_address < b.base_address;
+    });
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Return the image containing @a address, or NULL if none.
+ */
+const report_image *report::image_for_address (uint64_t address) const {
+    auto it = std::upper_bound(images.begin(), images.end(), address, [](uint64_t value, const report_image &image) {
+        return value < image.base_address;
+    });
+
+    if (it == images.begin())
+        return NULL;
+    --it;
+
+    if (address - it->base_address >= it->size)
+        return NULL;
+
+    return &*it;
+}
+
+/*
+ * Symbolication
+ */
+
+/**
+ * Symbolicate all frames of @a report that lack symbol information, appending one line per frame to @a output:
+ *
+ * <label> TAB <thread number|exception> TAB <frame index> TAB <pc> TAB <image> TAB <symbol> + <offset>
+ *
+ * Frames that already carry symbol information are emitted as-is.
+ *
+ * @param report The report to symbolicate.
+ * @param cache The shared image cache.
+ * @param label The label emitted for each frame; typically, the report path.
+ * @param output The string to which output will be appended.
+ * @param stats Statistics to be updated.
+ */
+void plcrash::symbolication::symbolicate_report (const report &report, ImageCache &cache, const std::string &label, std::string *output, symbolicate_stats *stats) {
+    /* Images resolved for this report, by binary image index */
+    std::map<const report_image *, std::shared_ptr<const ImageIndex>> indexes;
+    char line[1024];
+
+    for (const report_backtrace &bt : report.backtraces) {
+        char thread[32];
+        if (bt.exception)
+            snprintf(thread, sizeof(thread), "exception");
+        else
+            snprintf(thread, sizeof(thread), "%" PRIu32 "%s", bt.thread_number, bt.crashed ? " crashed" : "");
+
+        for (size_t i = 0; i < bt.frames.size(); i++) {
+            const report_frame &frame = bt.frames[i];
+            const report_image *image = report.image_for_address(frame.pc);
+            const char *symbol = NULL;
+            uint64_t start = 0;
+
+            stats->frames++;
+
+            if (frame.has_symbol) {
+                symbol = frame.symbol.c_str();
+                start = frame.symbol_start;
+            } else if (image != NULL && image->has_uuid) {
+                auto it = indexes.find(image);
+                if (it == indexes.end())
+                    it = indexes.insert(std::make_pair(image, cache.get(image->uuid))).first;
+
+                const ImageIndex *index = it->second.get();
+                uint64_t unslid_start;
+                if (index != NULL && index->lookup(frame.pc - image->base_address + index->text_vmaddr(), &symbol, &unslid_start)) {
+                    start = unslid_start - index->text_vmaddr() + image->base_address;
+                    stats->symbolicated++;
+                } else {
+                    stats->unresolved++;
+                }
+            } else {
+                stats->unresolved++;
+            }
+
+            const char *image_name = "???";
+            if (image != NULL) {
+                size_t sep = image->name.rfind('/');
+                image_name = image->name.c_str() + (sep == std::string::npos ? 0 : sep + 1);
+            }
+
+            if (symbol != NULL) {
+                snprintf(line, sizeof(line), "%s\t%s\t%zu\t0x%016" PRIx64 "\t%s\t%s + %" PRIu64 "\n",
+                         label.c_str(), thread, i, frame.pc, image_name, symbol, frame.pc - start);
+            } else {
+                snprintf(line, sizeof(line), "%s\t%s\t%zu\t0x%016" PRIx64 "\t%s\t???\n",
+                         label.c_str(), thread, i, frame.pc, image_name);
+            }
+            output->append(line);
+        }
+    }
+}
+
+/*
+ * Command
+ */
+
+static void print_symbolicate_usage () {
+    fprintf(stderr, "Usage: plcrashutil symbolicate [options] <report or directory> ...\n"
+                    "Options:\n"
+                    "  -s, --symbols=<path>   Mach-O binary, dSYM, or directory of either. May be repeated.\n"
+                    "  -j, --jobs=<count>     Number of worker threads (default: number of processors).\n"
+                    "  -o, --output=<file>    Write output to the given file (default: stdout).\n"
+                    "  -b, --benchmark        Discard output, and report throughput in reports/sec.\n"
+                    "  -r, --repeat=<count>   Process the input reports the given number of times.\n");
+}
+
+/**
+ * Run the symbolicate command. @a argv[0] is the command name.
+ *
+ * Reports are decoded without Foundation, and processed on a work-stealing pool; image indexes are shared across
+ * all reports.
+ */
+extern "C" int plcrash_symbolicate_command (int argc, char *argv[]) {
+    SymbolStore store;
+    unsigned jobs = 0;
+    unsigned long repeat = 1;
+    bool benchmark = false;
+    FILE *output = stdout;
+
+    static struct option longopts[] = {
+        { "symbols",    required_argument,      NULL,          's' },
+        { "jobs",       required_argument,      NULL,          'j' },
+        { "output",     required_argument,      NULL,          'o' },
+        { "benchmark",  no_argument,            NULL,          'b' },
+        { "repeat",     required_argument,      NULL,          'r' },
+        { NULL,         0,                      NULL,           0 }
+    };
+
+    int ch;
+    while ((ch = getopt_long(argc, argv, "s:j:o:br:", longopts, NULL)) != -1) {
+        switch (ch) {
+            case 's':
+                if (store.add_path(optarg) == 0)
+                    fprintf(stderr, "No Mach-O images found at %s\n", optarg);
+                break;
+            case 'j':
+                jobs = (unsigned) strtoul(optarg, NULL, 10);
+                break;
+            case 'o':
+                if ((output = fopen(optarg, "w")) == NULL) {
+                    fprintf(stderr, "Could not open %s for writing\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'b':
+                benchmark = true;
+                break;
+            case 'r':
+                repeat = std::max(1UL, strtoul(optarg, NULL, 10));
+                break;
+            default:
+                print_symbolicate_usage();
+                return 1;
+        }
+    }
+    argc -= optind;
+    argv += optind;
+
+    /* Gather the input reports */
+    std::vector<std::string> paths;
+    for (int i = 0; i < argc; i++) {
+        walk_path(argv[i], [&paths](const std::string &path) {
+            paths.push_back(path);
+        });
+    }
+
+    if (paths.empty()) {
+        fprintf(stderr, "No input reports supplied\n");
+        print_symbolicate_usage();
+        return 1;
+    }
+
+    ImageCache cache(store);
+    WorkStealingPool pool(jobs);
+    std::mutex output_lock;
+    std::atomic<size_t> failures(0);
+    symbolicate_stats totals = { 0, 0, 0 };
+
+    auto started = std::chrono::steady_clock::now();
+
+    pool.run(paths.size() * repeat, [&](size_t item) {
+        const std::string &path = paths[item % paths.size()];
+        plcrash_async_memory_file_t file;
+        report report;
+        plcrash_error_t err;
+
+        if ((err = plcrash_nasync_memory_file_open(&file, path.c_str())) == PLCRASH_ESUCCESS) {
+            err = decode_report(file.data, file.length, &report);
+            plcrash_nasync_memory_file_close(&file);
+        }
+
+        if (err != PLCRASH_ESUCCESS) {
+            fprintf(stderr, "Could not decode %s: %s\n", path.c_str(), plcrash_async_strerror(err));
+            failures++;
+            return;
+        }
+
+        std::string text;
+        symbolicate_stats stats = { 0, 0, 0 };
+        symbolicate_report(report, cache, path, &text, &stats);
+
+        std::lock_guard<std::mutex> guard(output_lock);
+        if (!benchmark)
+            fwrite(text.data(), 1, text.size(), output);
+
+        totals.frames += stats.frames;
+        totals.symbolicated += stats.symbolicated;
+        totals.unresolved += stats.unresolved;
+    });
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    size_t reports = paths.size() * repeat;
+
+    if (output != stdout)
+        fclose(output);
+
+    if (benchmark) {
+        fprintf(stderr, "%zu reports in %.3f s (%.1f reports/sec) on %u workers\n", reports, elapsed, elapsed > 0 ? reports / elapsed : 0.0, pool.workers());
+        fprintf(stderr, "%zu frames, %zu symbolicated, %zu unresolved\n", totals.frames, totals.symbolicated, totals.unresolved);
+        fprintf(stderr, "%zu images indexed, %zu loaded, %zu cache hits, %zu steals\n", store.count(), cache.loads(), cache.hits(), pool.steals());
+    }
+
+    return failures == 0 ? 0 : 1;
+}
+
+#if PLCRASH_SYMBOLICATOR_STANDALONE
+/*
+ * Standalone entry point, for hosts on which the Foundation-based plcrashutil driver is unavailable. See
+ * Source/Linux/Makefile.
+ */
+int main (int argc, char *argv[]) {
+    return plcrash_symbolicate_command(argc, argv);
+}
+#endif
+
+/**
+ * @}
+ */
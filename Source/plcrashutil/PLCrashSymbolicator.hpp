@@ -0,0 +1,308 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PLCRASH_SYMBOLICATOR_H
+#define PLCRASH_SYMBOLICATOR_H 1
+
+#include "PLCrashAsync.h"
+#include "PLCrashMacros.h"
+
+#include <stdint.h>
+
+#include <array>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+PLCR_CPP_BEGIN_NS
+namespace symbolication {
+
+/**
+ * @defgroup plcrash_symbolication Offline Symbolication
+ *
+ * Host-side re-symbolication of crash reports against on-disk Mach-O images and dSYMs.
+ *
+ * None of these APIs are async-safe, and none depend on Foundation; on-disk images are read through the
+ * plcrash_async_macho_* readers via file-backed memory sources.
+ * @{
+ */
+
+/** A Mach-O image UUID. */
+typedef std::array<uint8_t, 16> image_uuid;
+
+/**
+ * The on-disk location of a Mach-O image.
+ */
+struct image_location {
+    /** The path of the file containing the image. */
+    std::string path;
+
+    /** The offset of the image within the file; non-zero for universal binary slices. */
+    uint64_t offset;
+
+    /** The size of the image, in bytes. */
+    uint64_t length;
+
+    /** The unslid address of the image's __TEXT segment. */
+    uint64_t text_vmaddr;
+
+    /** True if the image is a dSYM companion file. */
+    bool dsym;
+};
+
+/**
+ * An index of the on-disk images available for symbolication, keyed by UUID.
+ */
+class SymbolStore {
+public:
+    size_t add_path (const std::string &path);
+    bool find (const image_uuid &uuid, image_location *location) const;
+
+    /** Return the number of indexed images. */
+    size_t count () const { return _images.size(); }
+
+private:
+    size_t add_file (const std::string &path);
+
+    /** Indexed images. */
+    std::map<image_uuid, image_location> _images;
+};
+
+/**
+ * A sorted symbol table for a single image, built once and shared by all reports referencing the image's UUID.
+ * Addresses are unslid; instances are immutable and may be used concurrently.
+ */
+class ImageIndex {
+public:
+    static plcrash_error_t load (const image_location &location, std::shared_ptr<const ImageIndex> *index);
+
+    bool lookup (uint64_t pc, const char **name, uint64_t *start) const;
+
+    /** Return the unslid address of the image's __TEXT segment. */
+    uint64_t text_vmaddr () const { return _text_vmaddr; }
+
+    /** Return the number of indexed symbols. */
+    size_t count () const { return _symbols.size(); }
+
+private:
+    ImageIndex (uint64_t text_vmaddr) : _text_vmaddr(text_vmaddr) {}
+
+    /** A symbol table entry. */
+    struct symbol {
+        /** The unslid symbol address, used for matching. */
+        uint64_t address;
+
+        /** The normalized symbol address (including the thumb bit, if any), used for reporting. */
+        uint64_t start;
+
+        /** The offset of the symbol's name within _names. */
+        size_t name;
+    };
+
+    /** The unslid address of the image's __TEXT segment. */
+    uint64_t _text_vmaddr;
+
+    /** Symbols, sorted by address. */
+    std::vector<symbol> _symbols;
+
+    /** NUL-separated symbol names. */
+    std::string _names;
+};
+
+/**
+ * A cache of image indexes, shared by concurrently symbolicated reports. Each UUID is loaded at most once; concurrent
+ * requests for an image that is still loading wait on the first loader.
+ */
+class ImageCache {
+public:
+    /**
+     * Construct a new cache.
+     *
+     * @param store The store from which images will be loaded. The store must not be modified while in use by the cache.
+     */
+    ImageCache (const SymbolStore &store) : _store(store), _loads(0), _hits(0) {}
+
+    std::shared_ptr<const ImageIndex> get (const image_uuid &uuid);
+
+    /** Return the number of images loaded. */
+    size_t loads () const { return _loads; }
+
+    /** Return the number of lookups served by a previously loaded (or loading) image. */
+    size_t hits () const { return _hits; }
+
+private:
+    /** The backing store. */
+    const SymbolStore &_store;
+
+    /** Lock guarding all mutable state. */
+    std::mutex _lock;
+
+    /** Loaded and loading images. A NULL index is cached for images that are unavailable or fail to load. */
+    std::map<image_uuid, std::shared_future<std::shared_ptr<const ImageIndex>>> _images;
+
+    /** Number of images loaded. */
+    size_t _loads;
+
+    /** Number of lookups served by a previously loaded image. */
+    size_t _hits;
+};
+
+/**
+ * A fixed-size pool of worker threads. Each worker owns a deque of pending work items, executing them in order from
+ * its front; idle workers steal from the back of their peers' deques.
+ */
+class WorkStealingPool {
+public:
+    /**
+     * Construct a new pool.
+     *
+     * @param workers The number of worker threads; if 0, the number of available processors is used.
+     */
+    WorkStealingPool (unsigned workers);
+
+    void run (size_t count, const std::function<void(size_t)> &fn);
+
+    /** Return the number of worker threads. */
+    unsigned workers () const { return (unsigned) _queues.size(); }
+
+    /** Return the number of work items executed by a worker other than the one to which they were assigned. */
+    size_t steals () const { return _steals; }
+
+private:
+    /** A per-worker work queue. */
+    struct queue {
+        std::mutex lock;
+        std::deque<size_t> items;
+    };
+
+    bool next (size_t worker, size_t *item);
+
+    /** Per-worker queues. */
+    std::vector<std::unique_ptr<queue>> _queues;
+
+    /** Total steals performed. */
+    std::atomic<size_t> _steals;
+};
+
+/**
+ * A decoded stack frame.
+ */
+struct report_frame {
+    /** The frame's PC. */
+    uint64_t pc;
+
+    /** True if the report supplied symbol information for this frame. */
+    bool has_symbol;
+
+    /** The symbol name, if any. */
+    std::string symbol;
+
+    /** The symbol start address, if any. */
+    uint64_t symbol_start;
+};
+
+/**
+ * A decoded backtrace; either a thread, or the uncaught exception's backtrace.
+ */
+struct report_backtrace {
+    /** The thread number, if not an exception backtrace. */
+    uint32_t thread_number;
+
+    /** True if this is the crashed thread. */
+    bool crashed;
+
+    /** True if this is the uncaught exception's backtrace. */
+    bool exception;
+
+    /** Frames, ordered from the innermost frame. */
+    std::vector<report_frame> frames;
+};
+
+/**
+ * A decoded binary image.
+ */
+struct report_image {
+    /** The image base address. */
+    uint64_t base_address;
+
+    /** The image size. */
+    uint64_t size;
+
+    /** The image path. */
+    std::string name;
+
+    /** True if the image's UUID was supplied. */
+    bool has_uuid;
+
+    /** The image's UUID. */
+    image_uuid uuid;
+};
+
+/**
+ * The subset of a crash report required for symbolication.
+ */
+struct report {
+    /** Thread and exception backtraces. */
+    std::vector<report_backtrace> backtraces;
+
+    /** Loaded binary images, sorted by base address. */
+    std::vector<report_image> images;
+
+    const report_image *image_for_address (uint64_t address) const;
+};
+
+plcrash_error_t decode_report (const uint8_t *data, size_t length, report *result);
+
+/**
+ * Symbolication statistics.
+ */
+struct symbolicate_stats {
+    /** Number of frames processed. */
+    size_t frames;
+
+    /** Number of frames symbolicated from the symbol store. */
+    size_t symbolicated;
+
+    /** Number of frames that required symbolication, but for which no symbol could be found. */
+    size_t unresolved;
+};
+
+void symbolicate_report (const report &report, ImageCache &cache, const std::string &label, std::string *output, symbolicate_stats *stats);
+
+/**
+ * @}
+ */
+
+}
+PLCR_CPP_END_NS
+
+#endif /* PLCRASH_SYMBOLICATOR_H */
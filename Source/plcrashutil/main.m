@@ -31,7 +31,12 @@
 
 #import <stdlib.h>
 #import <stdio.h>
-#import <getopt.h>
+
+/* Defined in PLCrashConvertCommand.m */
+extern int plcrash_convert_command (int argc, char *argv[]);
+
+/* Defined in PLCrashSymbolicator.cpp */
+extern int plcrash_symbolicate_command (int argc, char *argv[]);
 
 /*
  * Print command line usage.
@@ -39,81 +44,17 @@
 static void print_usage () {
     fprintf(stderr, "Usage: plcrashutil <command> <options>\n"
                     "Commands:\n"
-                    "  convert --format=<format> <file>\n"
-                    "      Covert a plcrash file to the given format.\n\n"
+                    "  convert [--format=<format>] <file>\n"
+                    "      Covert a plcrash file to the given format, writing the result to stdout.\n\n"
+                    "  convert [--format=<format>] [--jobs=<count>] [--manifest=<file>] --output-dir=<dir> <file or directory> ...\n"
+                    "      Convert plcrash files in parallel, writing a .crash file for each report to the output directory.\n"
+                    "      Directories are searched recursively, and their layout is preserved in the output directory. A\n"
+                    "      manifest lists one input path per line; pass '-' to read the manifest from stdin.\n\n"
                     "      Supported formats:\n"
                     "        ios - Standard Apple iOS-compatible text crash log\n"
-                    "        iphone - Synonym for 'iOS'.\n");
-}
-
-/*
- * Run a conversion.
- */
-static int convert_command (int argc, char *argv[]) {
-    const char *format = "iphone";
-    const char *input_file;
-    FILE *output = stdout;
-
-    /* options descriptor */
-    static struct option longopts[] = {
-        { "format",     required_argument,      NULL,          'f' },
-        { NULL,         0,                      NULL,           0 }
-    };    
-
-    /* Read the options */
-    char ch;
-    while ((ch = getopt_long(argc, argv, "f:", longopts, NULL)) != -1) {
-        switch (ch) {
-            case 'f':
-                format = optarg;
-                break;
-            default:
-                print_usage();
-                return 1;
-        }
-    }
-    argc -= optind;
-    argv += optind;
-
-    /* Ensure there's an input file specified */
-    if (argc < 1) {
-        fprintf(stderr, "No input file supplied\n");
-        print_usage();
-        return 1;
-    } else {
-        input_file = argv[0];
-    }
-    
-    /* Verify that the format is supported. Only one is actually supported currently */
-    PLCrashReportTextFormat textFormat;
-    if (strcasecmp(format, "iphone") == 0 || strcasecmp(format, "ios")) {
-        textFormat = PLCrashReportTextFormatiOS;
-    } else {
-        fprintf(stderr, "Unsupported format requested\n");
-        print_usage();
-        return 1;
-    }
-
-    /* Try reading the file in */
-    NSError *error;
-    NSData *data = [NSData dataWithContentsOfFile: [NSString stringWithUTF8String: input_file] 
-                                          options: NSMappedRead error: &error];
-    if (data == nil) {
-        fprintf(stderr, "Could not read input file: %s\n", [[error localizedDescription] UTF8String]);
-        return 1;
-    }
-    
-    /* Decode it */
-    PLCrashReport *crashLog = [[PLCrashReport alloc] initWithData: data error: &error];
-    if (crashLog == nil) {
-        fprintf(stderr, "Could not decode crash log: %s\n", [[error localizedDescription] UTF8String]);
-        return 1;
-    }
-
-    /* Format the report */
-    NSString* report = [PLCrashReportTextFormatter stringValueForCrashReport: crashLog withTextFormat: textFormat];
-    fprintf(output, "%s", [report UTF8String]);     
-    return 0;
+                    "        iphone - Synonym for 'iOS'.\n\n"
+                    "  symbolicate [--symbols=<path>] [--jobs=<count>] [--benchmark] <file or directory> ...\n"
+                    "      Symbolicate plcrash files against on-disk Mach-O binaries and dSYMs.\n");
 }
 
 int main (int argc, char *argv[]) {
@@ -127,7 +68,9 @@ int main (int argc, char *argv[]) {
 
     /* Convert command */
     if (strcmp(argv[1], "convert") == 0) {
-        ret = convert_command(argc - 2, argv + 2);
+        ret = plcrash_convert_command(argc - 1, argv + 1);
+    } else if (strcmp(argv[1], "symbolicate") == 0) {
+        ret = plcrash_symbolicate_command(argc - 1, argv + 1);
     } else {
         print_usage();
         ret = 1;